@@ -8,8 +8,18 @@
  *  a. Either externally on the CMACC ports.
  *  b. Internally by using cmam_configuration to set gt_loopback, which enables Near End PMA loopback in the transceivers.
  *
- *  The loopback is a functional test, which tests all packets sizes from the minimum to maximum configured in the CMAC,
- *  incrementing one byte at a time. This checks the AXI stream tlast end-of-packet handling is as expected.
+ *  By default the loopback is a functional test, which tests all packets sizes from the minimum to maximum configured in the
+ *  CMAC, incrementing one byte at a time. This checks the AXI stream tlast end-of-packet handling is as expected.
+ *
+ *  Optionally a throughput test may be performed instead, which keeps up to NUM_BUFFERS frames in flight for a set of fixed
+ *  frame sizes, and reports the achieved rate against the theoretical maximum for 100G Ethernet.
+ *
+ *  Alternatively a latency test may be performed, which for a set of fixed frame sizes reports the distribution of the
+ *  per-frame latency from submission to the H2C DMA until:
+ *  a. The H2C DMA has completed the transmission.
+ *  b. The looped back frame has been received by the C2H DMA.
+ *  The latency is measured both when idle, with only one frame in flight, and when loaded with up to NUM_BUFFERS frames
+ *  in flight on the same ports.
  */
 
 #include "identify_pcie_fpga_design.h"
@@ -17,6 +27,7 @@
 #include "xilinx_axi_stream_switch_configure.h"
 #include "cmac_register_access.h"
 #include "cmac_axi4_lite_registers.h"
+#include "transfer_timing.h"
 
 #include <stdlib.h>
 #include <stddef.h>
@@ -37,11 +48,27 @@
 
 
 /* The number of transmit and receive buffers, each to allow the maximum size of test_ethernet_frame_t.
- * While this test has only one frame outstanding at once, have a larger number of buffers to flush any pending receive frames
- * in the FIFOs at the start of the test. */
+ * While the functional test has only one frame outstanding at once, have a larger number of buffers to flush any pending
+ * receive frames in the FIFOs at the start of the test.
+ * The throughput and latency tests have up to NUM_BUFFERS frames outstanding at once. */
 #define NUM_BUFFERS 64
 
 
+/* The Ethernet line rate in bits per second, used to calculate the theoretical maximum throughput */
+#define ETHERNET_LINE_RATE_BPS 100E9
+
+
+/* The number of bytes on the line per frame in addition to the frame including the FCS:
+ * - 7 bytes preamble
+ * - 1 byte Start Frame Delimiter
+ * - 12 bytes minimum Inter Frame Gap */
+#define ETHERNET_PER_FRAME_OVERHEAD_BYTES 20
+
+
+/* The maximum number of frame sizes which may be specified for the throughput or latency test */
+#define MAX_TEST_FRAME_SIZES 32
+
+
 /* Based upon CMAC_DRP_CTL_RX_MAX_PACKET_LEN_MASK having 15 bits.
  * Albeit the description of the register says the maximum value is 16383 (i.e. 14 bits) and:
  *   "ctl_rx_max_packet_len[14] is reserved and must be set to 0" */
@@ -102,12 +129,43 @@ typedef struct
 } loopback_test_context_t;
 
 
+/* Randomly generated MAC addresses created by https://www.browserling.com/tools/random-mac.
+ * For this test with the Ethernet packets looped back, the actual addresses don't matter. */
+static const uint8_t destination_mac_addr[ETHER_MAC_ADDRESS_LEN] = {0x7a, 0xca, 0x56, 0x3c, 0x55, 0x17};
+static const uint8_t source_mac_addr     [ETHER_MAC_ADDRESS_LEN] = {0x9a, 0xf3, 0x0c, 0xd5, 0x79, 0x51};
+
+
 /* Command line arguments which specify the CMAC device and port used to send/receive test frames */
 static char arg_cmac_device_location[PATH_MAX];
 static uint32_t arg_cmac_tx_port_num;
 static uint32_t arg_cmac_rx_port_num;
 
 
+/* The different tests which may be selected by the command line arguments */
+typedef enum
+{
+    TEST_MODE_FUNCTIONAL,
+    TEST_MODE_THROUGHPUT,
+    TEST_MODE_LATENCY
+} test_mode_t;
+
+
+/* Command line arguments for the throughput and latency tests.
+ * When no frame sizes are specified, a default set of frame sizes is used. */
+static test_mode_t arg_test_mode = TEST_MODE_FUNCTIONAL;
+static uint32_t arg_num_test_frame_sizes;
+static uint32_t arg_test_frame_sizes[MAX_TEST_FRAME_SIZES];
+static uint32_t arg_num_test_frames = 1000000;
+
+
+/* The default frame sizes, including the FCS, used for the throughput and latency tests. Sizes larger than the configured maximum
+ * receive packet length of the CMAC are skipped. */
+static const uint32_t default_test_frame_sizes[] =
+{
+    64, 128, 256, 512, 1024, 1518, 4096, 9000
+};
+
+
 /**
  * @brief Display the program usage and then exit
  * @param[in] program_name Name of the program from argv[0]
@@ -115,6 +173,7 @@ static uint32_t arg_cmac_rx_port_num;
 static void display_usage (const char *const program_name)
 {
     printf ("Usage %s: [-i <domain>:<bus>:<dev>.<func>] -n [<cmac_port_num>|<cmac_tx_port_num>:<cmac_rx_port_num>]\n", program_name);
+    printf ("   [-t|-l] [-s <frame_size>] [-f <num_frames>]\n");
     printf ("\n");
     printf ("  -i only open using VFIO specific PCI device in the event that there is more than\n");
     printf ("     one PCI device which matches the identity filters.\n");
@@ -122,6 +181,11 @@ static void display_usage (const char *const program_name)
     printf ("     - A single number of the port to use for transmit and receive\n");
     printf ("     - A pair of colon delimited <cmac_tx_port_num>:<cmac_rx_port_num>\n");
     printf ("       to allow independent CMAC ports to be used for transmit and receive.\n");
+    printf ("  -t performs a throughput test with up to %u frames in flight, rather than the functional test.\n", NUM_BUFFERS);
+    printf ("  -l performs a latency test, idle and loaded, rather than the functional test.\n");
+    printf ("  -s specifies a frame size in bytes, including the FCS, for the throughput or latency test.\n");
+    printf ("     May be used multiple times. If not specified uses a default set of frame sizes.\n");
+    printf ("  -f specifies the number of frames for each frame size in the throughput or latency test.\n");
 
     exit (EXIT_FAILURE);
 }
@@ -135,7 +199,7 @@ static void read_command_line_arguments (const int argc, char *argv[])
 {
     bool cmac_port_num_specified = false;
     const char *const program_name = argv[0];
-    const char *const optstring = "i:n:";
+    const char *const optstring = "i:n:tls:f:";
     int option;
     char junk;
     uint32_t port_num;
@@ -172,6 +236,37 @@ static void read_command_line_arguments (const int argc, char *argv[])
             cmac_port_num_specified = true;
             break;
 
+        case 't':
+            arg_test_mode = TEST_MODE_THROUGHPUT;
+            break;
+
+        case 'l':
+            arg_test_mode = TEST_MODE_LATENCY;
+            break;
+
+        case 's':
+            if (arg_num_test_frame_sizes == MAX_TEST_FRAME_SIZES)
+            {
+                printf ("Error: Too many frame sizes\n");
+                exit (EXIT_FAILURE);
+            }
+            if ((sscanf (optarg, "%" SCNu32 "%c", &arg_test_frame_sizes[arg_num_test_frame_sizes], &junk) != 1) ||
+                (arg_test_frame_sizes[arg_num_test_frame_sizes] > MAX_PACKET_BYTES))
+            {
+                printf ("Error: Invalid frame size %s\n", optarg);
+                exit (EXIT_FAILURE);
+            }
+            arg_num_test_frame_sizes++;
+            break;
+
+        case 'f':
+            if ((sscanf (optarg, "%" SCNu32 "%c", &arg_num_test_frames, &junk) != 1) || (arg_num_test_frames == 0))
+            {
+                printf ("Error: Invalid number of frames %s\n", optarg);
+                exit (EXIT_FAILURE);
+            }
+            break;
+
         case '?':
         default:
             display_usage (program_name);
@@ -468,26 +563,15 @@ static void collect_port_statistics (loopback_test_context_t *const context)
 
 
 /**
- * @brief Sequence the CMAC loopback test
- * @param[in/out] context Defines the CMAC ports to perform the loopback test on
+ * @brief Flush any receive frames pending in the FIFOs prior to the start of a test
+ * @param[in/out] context The context to flush the receive frames for
  */
-static void sequence_cmac_loopback_test (loopback_test_context_t *const context)
+static void flush_receive_frames (loopback_test_context_t *const context)
 {
     size_t transfer_len;
     bool end_of_packet;
-
-    /* Randomly generated MAC addresses created by https://www.browserling.com/tools/random-mac.
-     * For this test with the Ethernet packets looped back, the actual addresses don't matter. */
-    const uint8_t destination_mac_addr[ETHER_MAC_ADDRESS_LEN] = {0x7a, 0xca, 0x56, 0x3c, 0x55, 0x17};
-    const uint8_t source_mac_addr     [ETHER_MAC_ADDRESS_LEN] = {0x9a, 0xf3, 0x0c, 0xd5, 0x79, 0x51};
-
-    /* Read the CMAC configuration for min/max valid receive lengths, to control the range of frame sizes tested. */
-    uint32_t rx_min_packet_len;
-    uint32_t rx_max_packet_len;
-    cmac_get_rx_min_max_packet_lens (context->cmac_rx_port, &rx_min_packet_len, &rx_max_packet_len);
-
-    /* Flush any receive frames prior to the start of the test */
     uint32_t num_frames_flushed = 0;
+
     while (context->xdma_overall_success && x2x_poll_completed_transfer (&context->c2h_transfer, &transfer_len, &end_of_packet))
     {
         num_frames_flushed++;
@@ -497,6 +581,24 @@ static void sequence_cmac_loopback_test (loopback_test_context_t *const context)
     {
         printf ("Flush %u receive frames at start of test\n", num_frames_flushed);
     }
+}
+
+
+/**
+ * @brief Sequence the CMAC loopback test
+ * @param[in/out] context Defines the CMAC ports to perform the loopback test on
+ */
+static void sequence_cmac_loopback_test (loopback_test_context_t *const context)
+{
+    size_t transfer_len;
+    bool end_of_packet;
+
+    /* Read the CMAC configuration for min/max valid receive lengths, to control the range of frame sizes tested. */
+    uint32_t rx_min_packet_len;
+    uint32_t rx_max_packet_len;
+    cmac_get_rx_min_max_packet_lens (context->cmac_rx_port, &rx_min_packet_len, &rx_max_packet_len);
+
+    flush_receive_frames (context);
 
     printf ("Testing %s Tx port %u Rx Port %u with %u packet lengths (including FCS) from %u to %u bytes\n",
             fpga_design_names[context->cmac_design->design_id],
@@ -588,6 +690,323 @@ static void sequence_cmac_loopback_test (loopback_test_context_t *const context)
 }
 
 
+/* Optional latency measurements made while streaming the test frames of one frame size */
+typedef struct
+{
+    /* The time at which each frame in flight was submitted for transmission, indexed by the sequence number modulo
+     * NUM_BUFFERS. An entry isn't re-used until the H2C descriptor for the frame has been freed, and the frame received. */
+    int64_t submit_times[NUM_BUFFERS];
+    /* The latency from submission until the H2C DMA completed the transmission of each frame */
+    size_t num_h2c_latencies;
+    int64_t *h2c_latencies_ns;
+    /* The latency from submission until the looped back frame was received by the C2H DMA */
+    size_t num_loopback_latencies;
+    int64_t *loopback_latencies_ns;
+} frame_latencies_t;
+
+
+/* The template for the test frames streamed for one frame size, with the sequence number at the start of the payload
+ * overwritten for each frame */
+static test_ethernet_frame_t template_frame;
+
+
+/**
+ * @brief Check the counters in the CMAC port statistics against the frames sent and received when streaming test frames
+ * @param[in/out] context The context the frames were streamed on. The C2H transfer records a failure on a mismatch.
+ * @param[in] frame_len_including_fcs The size of the frames streamed
+ * @param[in] num_tx_frames The number of frames transmitted
+ * @param[in] num_rx_frames The number of frames received
+ */
+static void check_streamed_port_statistics (loopback_test_context_t *const context, const uint32_t frame_len_including_fcs,
+                                            const uint64_t num_tx_frames, const uint64_t num_rx_frames)
+{
+    const cmac_port_statistics_t *const tx_stats = &context->port_statistics[0];
+    const cmac_port_statistics_t *const rx_stats = &context->port_statistics[context->num_ports_used_for_statistics - 1];
+    const uint64_t tx_good_packets = tx_stats->counter_values[CMAC_STAT_TX_TOTAL_GOOD_PACKETS];
+    const uint64_t tx_good_bytes = tx_stats->counter_values[CMAC_STAT_TX_TOTAL_GOOD_BYTES];
+    const uint64_t rx_good_packets = rx_stats->counter_values[CMAC_STAT_RX_TOTAL_GOOD_PACKETS];
+    const uint64_t rx_good_bytes = rx_stats->counter_values[CMAC_STAT_RX_TOTAL_GOOD_BYTES];
+    const bool counters_match = (tx_good_packets == num_tx_frames) && (tx_good_bytes == (num_tx_frames * frame_len_including_fcs)) &&
+            (rx_good_packets == num_rx_frames) && (rx_good_bytes == (num_rx_frames * frame_len_including_fcs));
+
+    printf ("  CMAC statistics: TX good packets %" PRIu64 " bytes %" PRIu64 "  RX good packets %" PRIu64 " bytes %" PRIu64 " : %s\n",
+            tx_good_packets, tx_good_bytes, rx_good_packets, rx_good_bytes, counters_match ? "match" : "MISMATCH");
+    if (!counters_match && context->xdma_overall_success)
+    {
+        x2x_record_failure (&context->c2h_transfer, "CMAC statistics don't match the %" PRIu64 " frames of %u bytes tested",
+                num_tx_frames, frame_len_including_fcs);
+    }
+}
+
+
+/**
+ * @brief Populate the template frame and all transmit buffers for streaming test frames of one frame size
+ * @param[in/out] context The context containing the transmit buffers
+ * @param[in] frame_len_including_fcs The size of the frames to be streamed
+ */
+static void prepare_streamed_frames (loopback_test_context_t *const context, const uint32_t frame_len_including_fcs)
+{
+    const size_t frame_len_excluding_fcs = frame_len_including_fcs - sizeof (uint32_t);
+    const size_t num_payload_bytes = frame_len_excluding_fcs - offsetof (test_ethernet_frame_t, test_payload);
+    const size_t tx_buffer_size = vfio_align_cache_line_size (sizeof (test_ethernet_frame_t));
+    uint8_t *const tx_buffers = context->h2c_data_mapping.buffer.vaddr;
+
+    memcpy (template_frame.destination_mac_addr, destination_mac_addr, sizeof (template_frame.destination_mac_addr));
+    memcpy (template_frame.source_mac_addr, source_mac_addr, sizeof (template_frame.source_mac_addr));
+    template_frame.ether_type = htons (ETH_P_802_EX1);
+    for (uint32_t payload_index = 0; payload_index < num_payload_bytes; payload_index++)
+    {
+        template_frame.test_payload[payload_index] = (uint8_t) payload_index;
+    }
+    for (uint32_t buffer_index = 0; buffer_index < NUM_BUFFERS; buffer_index++)
+    {
+        memcpy (&tx_buffers[buffer_index * tx_buffer_size], &template_frame, frame_len_excluding_fcs);
+    }
+}
+
+
+/**
+ * @brief Stream test frames of one frame size through the loopback, checking the received frames
+ * @details prepare_streamed_frames() must have been called for the frame size. Only the sequence number at the start of the
+ *          payload is written for each frame transmitted, to minimise the CPU overhead per frame.
+ *          The number of frames in flight is limited to at most the number of receive buffers, since the CMAC has no receive
+ *          flow control and would otherwise drop frames if the C2H DMA had no free buffer.
+ *          The CMAC statistics are checked against the number of frames streamed.
+ * @param[in/out] context Defines the CMAC ports to stream the frames on
+ * @param[in] frame_len_including_fcs The size of the frames to stream
+ * @param[in] max_frames_in_flight The maximum number of frames transmitted but not yet received, from 1 to NUM_BUFFERS
+ * @param[in/out] latencies When non-NULL the latencies of each frame are recorded, which adds the overhead of reading the
+ *                          time for each frame.
+ * @param[out] num_rx_frames The number of frames received
+ * @return Returns the elapsed time in nanoseconds from the first frame being transmitted to the last frame being received
+ */
+static int64_t stream_test_frames (loopback_test_context_t *const context, const uint32_t frame_len_including_fcs,
+                                   const uint32_t max_frames_in_flight, frame_latencies_t *const latencies,
+                                   uint32_t *const num_rx_frames)
+{
+    const size_t frame_len_excluding_fcs = frame_len_including_fcs - sizeof (uint32_t);
+    const size_t num_payload_bytes = frame_len_excluding_fcs - offsetof (test_ethernet_frame_t, test_payload);
+    const size_t tx_buffer_size = vfio_align_cache_line_size (sizeof (test_ethernet_frame_t));
+    uint32_t num_tx_frames = 0;
+    uint32_t num_tx_completed = 0;
+    const test_ethernet_frame_t *rx_frame;
+    size_t transfer_len;
+    bool end_of_packet;
+    uint32_t rx_sequence_number;
+
+    *num_rx_frames = 0;
+    if (latencies != NULL)
+    {
+        latencies->num_h2c_latencies = 0;
+        latencies->num_loopback_latencies = 0;
+    }
+
+    flush_receive_frames (context);
+    collect_port_statistics (context);
+
+    const int64_t start_time = get_monotonic_time ();
+    while (context->xdma_overall_success && ((*num_rx_frames < arg_num_test_frames) || (num_tx_completed < num_tx_frames)))
+    {
+        /* Queue transmit frames while there is a receive buffer available for each frame in flight, and the transmit
+         * buffer and submit time for the frame are no longer in use by a transmission which hasn't been completed */
+        bool tx_queued = true;
+        while (context->xdma_overall_success && tx_queued && (num_tx_frames < arg_num_test_frames) &&
+               ((num_tx_frames - *num_rx_frames) < max_frames_in_flight) &&
+               ((num_tx_frames - num_tx_completed) < NUM_BUFFERS))
+        {
+            const uint64_t host_buffer_offset = (num_tx_frames % NUM_BUFFERS) * tx_buffer_size;
+            test_ethernet_frame_t *const tx_frame =
+                    x2x_populate_stream_transfer (&context->h2c_transfer, frame_len_excluding_fcs, host_buffer_offset);
+
+            tx_queued = tx_frame != NULL;
+            if (tx_queued)
+            {
+                memcpy (tx_frame->test_payload, &num_tx_frames, sizeof (num_tx_frames));
+                if (latencies != NULL)
+                {
+                    latencies->submit_times[num_tx_frames % NUM_BUFFERS] = get_monotonic_time ();
+                }
+                x2x_start_populated_descriptors (&context->h2c_transfer);
+                num_tx_frames++;
+            }
+        }
+
+        /* Free the descriptors of completed transmit frames */
+        while (context->xdma_overall_success && (x2x_poll_completed_transfer (&context->h2c_transfer, NULL, NULL) != NULL))
+        {
+            if (latencies != NULL)
+            {
+                latencies->h2c_latencies_ns[latencies->num_h2c_latencies++] =
+                        get_monotonic_time () - latencies->submit_times[num_tx_completed % NUM_BUFFERS];
+            }
+            num_tx_completed++;
+        }
+
+        /* Check received frames, which are expected in sequence number order */
+        while (context->xdma_overall_success &&
+               ((rx_frame = x2x_poll_completed_transfer (&context->c2h_transfer, &transfer_len, &end_of_packet)) != NULL))
+        {
+            if (latencies != NULL)
+            {
+                latencies->loopback_latencies_ns[latencies->num_loopback_latencies++] =
+                        get_monotonic_time () - latencies->submit_times[*num_rx_frames % NUM_BUFFERS];
+            }
+
+            memcpy (&rx_sequence_number, rx_frame->test_payload, sizeof (rx_sequence_number));
+            if (!end_of_packet)
+            {
+                x2x_record_failure (&context->c2h_transfer,
+                        "end_of_packet not indicated, frame_len_excluding_fcs=%zu rx transfer_len=%zu",
+                        frame_len_excluding_fcs, transfer_len);
+            }
+            else if (transfer_len != frame_len_excluding_fcs)
+            {
+                x2x_record_failure (&context->c2h_transfer, "Rx transfer_len=%zu, expected %zu", transfer_len, frame_len_excluding_fcs);
+            }
+            else if (rx_sequence_number != *num_rx_frames)
+            {
+                x2x_record_failure (&context->c2h_transfer, "Rx sequence number %u, expected %u (frames lost or re-ordered)",
+                        rx_sequence_number, *num_rx_frames);
+            }
+            else if ((memcmp (rx_frame, &template_frame, offsetof (test_ethernet_frame_t, test_payload)) != 0) ||
+                     (memcmp (&rx_frame->test_payload[sizeof (rx_sequence_number)],
+                              &template_frame.test_payload[sizeof (rx_sequence_number)],
+                              num_payload_bytes - sizeof (rx_sequence_number)) != 0))
+            {
+                x2x_record_failure (&context->c2h_transfer, "Receive frame sequence number %u has incorrect content",
+                        rx_sequence_number);
+            }
+
+            x2x_start_next_c2h_buffer (&context->c2h_transfer);
+            (*num_rx_frames)++;
+        }
+    }
+    const int64_t stop_time = get_monotonic_time ();
+
+    collect_port_statistics (context);
+    check_streamed_port_statistics (context, frame_len_including_fcs, num_tx_frames, *num_rx_frames);
+
+    return stop_time - start_time;
+}
+
+
+/**
+ * @brief Perform the throughput test for one frame size
+ * @param[in/out] context Defines the CMAC ports to perform the throughput test on
+ * @param[in] frame_len_including_fcs The size of the frames to test
+ */
+static void perform_frame_size_throughput_test (loopback_test_context_t *const context, const uint32_t frame_len_including_fcs)
+{
+    uint32_t num_rx_frames;
+
+    prepare_streamed_frames (context, frame_len_including_fcs);
+    const int64_t elapsed_ns = stream_test_frames (context, frame_len_including_fcs, NUM_BUFFERS, NULL, &num_rx_frames);
+
+    /* Report the achieved rate against the theoretical maximum, where the achieved Gb/s is for the frames including the FCS */
+    const double elapsed_secs = (double) elapsed_ns / 1E9;
+    const double max_frames_per_sec =
+            ETHERNET_LINE_RATE_BPS / ((frame_len_including_fcs + ETHERNET_PER_FRAME_OVERHEAD_BYTES) * 8.0);
+    const double max_gbps = (max_frames_per_sec * frame_len_including_fcs * 8.0) / 1E9;
+    const double frames_per_sec = (elapsed_secs > 0.0) ? (num_rx_frames / elapsed_secs) : 0.0;
+    const double gbps = (frames_per_sec * frame_len_including_fcs * 8.0) / 1E9;
+
+    printf ("Frame size %5u : %10u frames in %.6f secs  %8.3f Mpps (max %8.3f)  %7.2f Gb/s (max %7.2f)  %5.1f%% of max\n",
+            frame_len_including_fcs, num_rx_frames, elapsed_secs, frames_per_sec / 1E6, max_frames_per_sec / 1E6,
+            gbps, max_gbps, (frames_per_sec * 100.0) / max_frames_per_sec);
+}
+
+
+/**
+ * @brief Perform the latency test for one frame size, when idle and loaded
+ * @param[in/out] context Defines the CMAC ports to perform the latency test on
+ * @param[in] frame_len_including_fcs The size of the frames to test
+ * @param[in/out] latencies Used to record the latencies of each frame
+ */
+static void perform_frame_size_latency_test (loopback_test_context_t *const context, const uint32_t frame_len_including_fcs,
+                                             frame_latencies_t *const latencies)
+{
+    /* Idle has only one frame in flight. Loaded has as many frames in flight as there are receive buffers. */
+    const uint32_t max_frames_in_flight[] = {1, NUM_BUFFERS};
+    const char *const load_names[] = {"idle", "loaded"};
+    const uint32_t num_loads = sizeof (max_frames_in_flight) / sizeof (max_frames_in_flight[0]);
+    uint32_t num_rx_frames;
+    char latency_name[80];
+
+    prepare_streamed_frames (context, frame_len_including_fcs);
+    for (uint32_t load_index = 0; context->xdma_overall_success && (load_index < num_loads); load_index++)
+    {
+        printf ("Frame size %5u %s with up to %u frames in flight:\n",
+                frame_len_including_fcs, load_names[load_index], max_frames_in_flight[load_index]);
+        (void) stream_test_frames (context, frame_len_including_fcs, max_frames_in_flight[load_index], latencies, &num_rx_frames);
+
+        snprintf (latency_name, sizeof (latency_name), "  Tx port %u H2C completion", arg_cmac_tx_port_num);
+        display_latency_distribution (latency_name, latencies->num_h2c_latencies, latencies->h2c_latencies_ns);
+        snprintf (latency_name, sizeof (latency_name), "  Tx port %u to Rx port %u loopback",
+                arg_cmac_tx_port_num, arg_cmac_rx_port_num);
+        display_latency_distribution (latency_name, latencies->num_loopback_latencies, latencies->loopback_latencies_ns);
+    }
+}
+
+
+/**
+ * @brief Sequence the CMAC throughput or latency test, over the frame sizes specified by the command line arguments
+ * @param[in/out] context Defines the CMAC ports to perform the test on
+ */
+static void sequence_cmac_streamed_test (loopback_test_context_t *const context)
+{
+    const uint32_t num_frame_sizes = (arg_num_test_frame_sizes > 0) ? arg_num_test_frame_sizes :
+            (sizeof (default_test_frame_sizes) / sizeof (default_test_frame_sizes[0]));
+    const uint32_t *const frame_sizes = (arg_num_test_frame_sizes > 0) ? arg_test_frame_sizes : default_test_frame_sizes;
+    const char *const test_name = (arg_test_mode == TEST_MODE_LATENCY) ? "Latency" : "Throughput";
+    frame_latencies_t latencies = {0};
+
+    /* Read the CMAC configuration for min/max valid receive lengths, to determine which frame sizes can be tested */
+    uint32_t rx_min_packet_len;
+    uint32_t rx_max_packet_len;
+    cmac_get_rx_min_max_packet_lens (context->cmac_rx_port, &rx_min_packet_len, &rx_max_packet_len);
+
+    if (arg_test_mode == TEST_MODE_LATENCY)
+    {
+        latencies.h2c_latencies_ns = calloc (arg_num_test_frames, sizeof (latencies.h2c_latencies_ns[0]));
+        latencies.loopback_latencies_ns = calloc (arg_num_test_frames, sizeof (latencies.loopback_latencies_ns[0]));
+        if ((latencies.h2c_latencies_ns == NULL) || (latencies.loopback_latencies_ns == NULL))
+        {
+            printf ("Error: Failed to allocate latency measurements for %u frames\n", arg_num_test_frames);
+            exit (EXIT_FAILURE);
+        }
+    }
+
+    printf ("%s testing %s Tx port %u Rx Port %u with %u frames per frame size and up to %u frames in flight\n",
+            test_name, fpga_design_names[context->cmac_design->design_id], arg_cmac_tx_port_num, arg_cmac_rx_port_num,
+            arg_num_test_frames, NUM_BUFFERS);
+
+    for (uint32_t size_index = 0; context->xdma_overall_success && (size_index < num_frame_sizes); size_index++)
+    {
+        const uint32_t frame_len_including_fcs = frame_sizes[size_index];
+
+        if ((frame_len_including_fcs < rx_min_packet_len) || (frame_len_including_fcs > rx_max_packet_len))
+        {
+            printf ("Frame size %5u : skipped as outside of CMAC rx packet lengths %u to %u bytes\n",
+                    frame_len_including_fcs, rx_min_packet_len, rx_max_packet_len);
+        }
+        else if (arg_test_mode == TEST_MODE_LATENCY)
+        {
+            perform_frame_size_latency_test (context, frame_len_including_fcs, &latencies);
+        }
+        else
+        {
+            perform_frame_size_throughput_test (context, frame_len_including_fcs);
+        }
+    }
+
+    free (latencies.h2c_latencies_ns);
+    free (latencies.loopback_latencies_ns);
+
+    /* Display a summary. Any error messages will be reported by report_if_transfer_failed() */
+    printf ("%s test: %s\n", test_name, context->xdma_overall_success ? "PASS" : "FAIL");
+}
+
+
 int main (int argc, char *argv[])
 {
     loopback_test_context_t context;
@@ -598,7 +1017,14 @@ int main (int argc, char *argv[])
     memset (&context, 0, sizeof (context));
     open_cmac_device (&context);
     wait_receive_link_ready (&context);
-    sequence_cmac_loopback_test (&context);
+    if (arg_test_mode == TEST_MODE_FUNCTIONAL)
+    {
+        sequence_cmac_loopback_test (&context);
+    }
+    else
+    {
+        sequence_cmac_streamed_test (&context);
+    }
 
     close_cmac_device (&context);
 
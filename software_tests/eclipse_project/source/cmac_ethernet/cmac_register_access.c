@@ -147,8 +147,10 @@ const cmac_statistics_counter_definition_t cmac_statistics_counter_definitions[C
 };
 
 
-/* The monotonic time of the last sample tick for the statistics counters in each CMAC port */
-static int64_t port_last_sample_tick_times_ns[MAX_VFIO_DEVICES][MAX_CMAC_PORTS_PER_DESIGN];
+/* The monotonic time of the last sample tick for the statistics counters in each CMAC port.
+ * Indexed by the design index, and grown as statistics are sampled for designs. */
+static int64_t (*port_last_sample_tick_times_ns)[MAX_CMAC_PORTS_PER_DESIGN];
+static uint32_t port_last_sample_tick_times_allocated_length;
 
 
 /**
@@ -317,6 +319,9 @@ void cmac_read_port_statistics (cmac_port_statistics_t *const stats)
     }
 
     /* Record the duration between samples on the same port */
+    port_last_sample_tick_times_ns = vfio_grow_array (port_last_sample_tick_times_ns,
+            &port_last_sample_tick_times_allocated_length, stats->design->design_index + 1,
+            sizeof (port_last_sample_tick_times_ns[0]), "port_last_sample_tick_times_ns");
     if (port_last_sample_tick_times_ns[stats->design->design_index][stats->port_num] != 0)
     {
         stats->sample_duration_ns =
@@ -39,7 +39,13 @@ static void read_and_display_cmac_statistics (fpga_designs_t *const designs, con
 {
     uint32_t design_index;
     uint32_t port_num;
-    cmac_port_statistics_t stats[MAX_VFIO_DEVICES][MAX_CMAC_PORTS_PER_DESIGN];
+    cmac_port_statistics_t (*const stats)[MAX_CMAC_PORTS_PER_DESIGN] = calloc (designs->num_identified_designs, sizeof (stats[0]));
+
+    if ((stats == NULL) && (designs->num_identified_designs > 0))
+    {
+        printf ("Failed to allocate memory for statistics\n");
+        exit (EXIT_FAILURE);
+    }
 
     /* Snapshot the counters for all CMAC ports */
     for (design_index = 0; design_index < designs->num_identified_designs; design_index++)
@@ -67,6 +73,8 @@ static void read_and_display_cmac_statistics (fpga_designs_t *const designs, con
             }
         }
     }
+
+    free (stats);
 }
 
 
@@ -0,0 +1,1132 @@
+/*
+ * @file cmac_traffic_generator.c
+ * @date 18 Oct 2026
+ * @author Chester Gillon
+ * @brief Generate and check traffic concurrently on all CMAC ports of all identified designs
+ * @details
+ *  Each CMAC port configured for both transmit and receive is assumed to be looped back, either externally or internally by
+ *  using cmac_configuration to set gt_loopback. Each port uses the DMA/Bridge H2C and C2H channels with the same number as
+ *  the port, and is served by its own worker thread pinned to a CPU.
+ *
+ *  The traffic profile selects the sequence of frame sizes transmitted:
+ *  - fixed : All frames are the same size.
+ *  - sweep : Frame sizes increment one byte at a time over the configured CMAC receive packet lengths.
+ *  - imix  : The simple IMIX of 7 x 64 byte, 4 x 576 byte and 1 x 1518 byte frames.
+ *  - burst : Bursts of fixed size frames, separated by an idle gap.
+ *
+ *  Each frame contains a per-port sequence number and port identity, and the receive frames are checked for:
+ *  - Sequence gaps, where frames have been lost. A corrupt frame is also counted as lost, since its sequence number can't
+ *    be trusted.
+ *  - Reordering, where a frame is received with a sequence number earlier than expected.
+ *  - Corruption, where the length or contents of a frame don't match that transmitted.
+ *
+ *  The per-port and aggregate throughput is reported live at one second intervals, until either the test duration expires
+ *  or Ctrl-C is used to stop the test.
+ */
+
+#define _GNU_SOURCE /* For pthread_attr_setaffinity_np() */
+
+#include "identify_pcie_fpga_design.h"
+#include "xilinx_dma_bridge_transfers.h"
+#include "xilinx_axi_stream_switch_configure.h"
+#include "cmac_register_access.h"
+#include "cmac_axi4_lite_registers.h"
+#include "transfer_timing.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <inttypes.h>
+
+#include <unistd.h>
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sched.h>
+#include <linux/if_ether.h>
+#include <arpa/inet.h>
+
+
+#define ETHER_MAC_ADDRESS_LEN 6
+
+
+/* Timeout used to detect if the transmit or receive DMA has hung. */
+#define XMDA_TRANSFER_TIMEOUT_SECS 5
+
+
+/* The number of transmit and receive buffers for each port, each to allow the maximum size of test_ethernet_frame_t.
+ * Up to NUM_BUFFERS frames are in flight at once on each port, so that each frame has a receive buffer available. */
+#define NUM_BUFFERS 64
+
+
+/* Based upon CMAC_DRP_CTL_RX_MAX_PACKET_LEN_MASK having 15 bits. */
+#define MAX_PACKET_BYTES 32767
+
+
+/* The maximum number of CPUs which can be specified to pin the worker threads to */
+#define MAX_WORKER_CPUS 64
+
+
+/* How long to wait for the receive link of a port to be ready, before omitting the port from the test */
+#define LINK_READY_TIMEOUT_SECS 5
+
+
+/* If no frames are received for this time while frames are in flight, the frames in flight are counted as lost.
+ * This prevents the test stalling when the last frames in flight are lost. */
+#define RX_STALL_TIMEOUT_NS 100000000LL
+
+
+/* Defines a variable length test Ethernet frame to be transmitted / received.
+ * The start of the payload contains the identity used to check each frame received. */
+typedef struct __attribute__((packed))
+{
+    /* Ethernet Header */
+    uint8_t destination_mac_addr[ETHER_MAC_ADDRESS_LEN];
+    uint8_t source_mac_addr[ETHER_MAC_ADDRESS_LEN];
+    uint16_t ether_type;
+
+    /* The index of the tested port which transmitted the frame */
+    uint32_t port_index;
+    /* Incremented for each frame transmitted on the port */
+    uint32_t sequence_number;
+
+    /* Variable length */
+    uint8_t test_payload[MAX_PACKET_BYTES -
+                         (ETHER_MAC_ADDRESS_LEN /* destination_mac_addr */ +
+                          ETHER_MAC_ADDRESS_LEN /* source_mac_addr */ +
+                          sizeof (uint16_t) /* ether_type */ +
+                          sizeof (uint32_t) /* port_index */ +
+                          sizeof (uint32_t) /* sequence_number */)];
+} test_ethernet_frame_t;
+
+
+/* The traffic profiles which may be generated */
+typedef enum
+{
+    TRAFFIC_PROFILE_FIXED,
+    TRAFFIC_PROFILE_SWEEP,
+    TRAFFIC_PROFILE_IMIX,
+    TRAFFIC_PROFILE_BURST,
+
+    TRAFFIC_PROFILE_ARRAY_SIZE
+} traffic_profile_t;
+
+static const char *const traffic_profile_names[TRAFFIC_PROFILE_ARRAY_SIZE] =
+{
+    [TRAFFIC_PROFILE_FIXED] = "fixed",
+    [TRAFFIC_PROFILE_SWEEP] = "sweep",
+    [TRAFFIC_PROFILE_IMIX ] = "imix",
+    [TRAFFIC_PROFILE_BURST] = "burst"
+};
+
+
+/* The sequence of frame sizes, including the FCS, for the simple IMIX profile.
+ * The 7:4:1 ratio of sizes is interleaved to avoid runs of the same size. */
+static const uint32_t imix_frame_sizes[] =
+{
+    64, 576, 64, 64, 576, 64, 1518, 64, 576, 64, 64, 576
+};
+#define NUM_IMIX_FRAME_SIZES (sizeof (imix_frame_sizes) / sizeof (imix_frame_sizes[0]))
+
+
+/* The traffic counters for one port.
+ * Written by the worker thread for the port and read by the main thread to report the throughput, so accessed using
+ * atomic operations. There is only one writer for each counter. */
+typedef struct
+{
+    uint64_t tx_frames;
+    uint64_t tx_bytes;
+    uint64_t rx_frames;
+    uint64_t rx_bytes;
+    uint64_t lost_frames;
+    uint64_t reordered_frames;
+    uint64_t corrupt_frames;
+} port_traffic_counters_t;
+
+
+/* The context used to generate and check traffic on one CMAC port */
+typedef struct
+{
+    /* The index of this port in the tested ports, used to identify the frames transmitted */
+    uint32_t port_index;
+    /* The design containing the CMAC port */
+    fpga_design_t *design;
+    /* The CMAC port number in the design, which is also the DMA channel number */
+    uint32_t port_num;
+    /* Used to access the CMAC port registers */
+    cmac_port_definition_t *cmac_port;
+    /* The CPU the worker thread is pinned to */
+    int cpu;
+    /* The CMAC configuration for min/max valid receive lengths, including the FCS */
+    uint32_t rx_min_packet_len;
+    uint32_t rx_max_packet_len;
+    /* Overall success of initialising and performing XMDA transfers on this port */
+    bool xdma_overall_success;
+    /* Read/write mapping for the XDMA descriptors */
+    vfio_dma_mapping_t descriptors_mapping;
+    /* XDMA read mapping used by device for Ethernet transmission */
+    vfio_dma_mapping_t h2c_data_mapping;
+    /* XDMA write mapping used by device for Ethernet reception */
+    vfio_dma_mapping_t c2h_data_mapping;
+    /* Used to perform XMDA transfers for Ethernet transmission / reception */
+    x2x_transfer_context_t h2c_transfer;
+    x2x_transfer_context_t c2h_transfer;
+    /* The template for the frames transmitted, of the maximum size, with the sequence number written for each frame */
+    test_ethernet_frame_t template_frame;
+    /* The sequence number of the next frame to be transmitted */
+    uint32_t tx_sequence_number;
+    /* The sequence number of the next frame expected to be received */
+    uint32_t rx_expected_sequence_number;
+    /* The counters updated as the traffic is generated and checked */
+    port_traffic_counters_t counters;
+    /* The worker thread which generates and checks the traffic */
+    pthread_t thread;
+} port_traffic_context_t;
+
+
+/* Contains the context for all ports tested concurrently */
+typedef struct
+{
+    /* All the FPGA designs which have been opened */
+    fpga_designs_t designs;
+    /* The configured AXI stream switch routing for each design which has an AXI stream switch.
+     * Allocated with one entry per identified design. */
+    device_routing_t *routing;
+    /* The ports being tested. Allocated since each contains a template frame of the maximum size.
+     * The array of pointers is allocated for the maximum number of ports in the identified designs. */
+    uint32_t num_ports;
+    port_traffic_context_t **ports;
+} traffic_generator_context_t;
+
+
+/* Randomly generated MAC addresses created by https://www.browserling.com/tools/random-mac.
+ * For this test with the Ethernet packets looped back, the actual addresses don't matter. */
+static const uint8_t destination_mac_addr[ETHER_MAC_ADDRESS_LEN] = {0x7a, 0xca, 0x56, 0x3c, 0x55, 0x17};
+static const uint8_t source_mac_addr     [ETHER_MAC_ADDRESS_LEN] = {0x9a, 0xf3, 0x0c, 0xd5, 0x79, 0x51};
+
+
+/* Command line arguments which control the traffic generated */
+static traffic_profile_t arg_traffic_profile = TRAFFIC_PROFILE_FIXED;
+static uint32_t arg_frame_size = 1518;
+static uint32_t arg_burst_num_frames = 32;
+static int64_t arg_burst_gap_ns = 100000;
+static int64_t arg_test_duration_secs = 0;
+
+
+/* Command line arguments which specify the CPUs to pin the worker threads to, allocated in turn to the ports.
+ * When not specified uses the CPUs in the affinity of the process. */
+static uint32_t arg_num_worker_cpus;
+static int arg_worker_cpus[MAX_WORKER_CPUS];
+
+
+/* Set true in a signal handler when Ctrl-C is used to request a running test stops, or by the main thread when the test
+ * duration expires. Polled by the worker threads. */
+static volatile bool test_stop_requested;
+
+
+/**
+ * @brief Signal handler to request a running test stops
+ * @param[in] sig Not used
+ */
+static void stop_test_handler (const int sig)
+{
+    test_stop_requested = true;
+}
+
+
+/**
+ * @brief Display the program usage and then exit
+ * @param[in] program_name Name of the program from argv[0]
+ */
+static void display_usage (const char *const program_name)
+{
+    printf ("Usage %s: [-i <domain>:<bus>:<dev>.<func>] [-p fixed|sweep|imix|burst] [-s <frame_size>]\n", program_name);
+    printf ("   [-b <burst_num_frames>] [-g <burst_gap_us>] [-d <duration_secs>] [-c <cpu>]\n");
+    printf ("\n");
+    printf ("  -i only open using VFIO specific PCI device(s). May be used multiple times.\n");
+    printf ("  -p specifies the traffic profile. Default is fixed.\n");
+    printf ("  -s specifies the frame size in bytes, including the FCS, for the fixed and burst profiles.\n");
+    printf ("  -b specifies the number of frames in each burst for the burst profile.\n");
+    printf ("  -g specifies the idle gap in microseconds between bursts for the burst profile.\n");
+    printf ("  -d specifies the test duration in seconds. If not specified runs until Ctrl-C.\n");
+    printf ("  -c specifies a CPU to pin a worker thread to, allocated in turn to the ports tested.\n");
+    printf ("     May be used multiple times. If not specified uses the CPUs the process is allowed to run on.\n");
+
+    exit (EXIT_FAILURE);
+}
+
+
+/**
+ * @brief Read the command line arguments, exiting if an error in the arguments
+ * @param[in] argc, argv Command line arguments passed to main
+ */
+static void read_command_line_arguments (const int argc, char *argv[])
+{
+    const char *const program_name = argv[0];
+    const char *const optstring = "i:p:s:b:g:d:c:";
+    int option;
+    char junk;
+    bool profile_found;
+    int64_t burst_gap_us;
+
+    /* Process the command line arguments */
+    option = getopt (argc, argv, optstring);
+    while (option != -1)
+    {
+        switch (option)
+        {
+        case 'i':
+            vfio_add_pci_device_location_filter (optarg);
+            break;
+
+        case 'p':
+            profile_found = false;
+            for (traffic_profile_t profile = 0; !profile_found && (profile < TRAFFIC_PROFILE_ARRAY_SIZE); profile++)
+            {
+                if (strcmp (optarg, traffic_profile_names[profile]) == 0)
+                {
+                    arg_traffic_profile = profile;
+                    profile_found = true;
+                }
+            }
+            if (!profile_found)
+            {
+                printf ("Error: Invalid traffic profile %s\n", optarg);
+                exit (EXIT_FAILURE);
+            }
+            break;
+
+        case 's':
+            if ((sscanf (optarg, "%" SCNu32 "%c", &arg_frame_size, &junk) != 1) || (arg_frame_size > MAX_PACKET_BYTES) ||
+                (arg_frame_size < (offsetof (test_ethernet_frame_t, test_payload) + sizeof (uint32_t))))
+            {
+                printf ("Error: Invalid frame size %s\n", optarg);
+                exit (EXIT_FAILURE);
+            }
+            break;
+
+        case 'b':
+            if ((sscanf (optarg, "%" SCNu32 "%c", &arg_burst_num_frames, &junk) != 1) || (arg_burst_num_frames == 0))
+            {
+                printf ("Error: Invalid burst number of frames %s\n", optarg);
+                exit (EXIT_FAILURE);
+            }
+            break;
+
+        case 'g':
+            if ((sscanf (optarg, "%" SCNi64 "%c", &burst_gap_us, &junk) != 1) || (burst_gap_us < 0))
+            {
+                printf ("Error: Invalid burst gap %s\n", optarg);
+                exit (EXIT_FAILURE);
+            }
+            arg_burst_gap_ns = burst_gap_us * 1000;
+            break;
+
+        case 'd':
+            if ((sscanf (optarg, "%" SCNi64 "%c", &arg_test_duration_secs, &junk) != 1) || (arg_test_duration_secs <= 0))
+            {
+                printf ("Error: Invalid test duration %s\n", optarg);
+                exit (EXIT_FAILURE);
+            }
+            break;
+
+        case 'c':
+            if (arg_num_worker_cpus == MAX_WORKER_CPUS)
+            {
+                printf ("Error: Too many CPUs\n");
+                exit (EXIT_FAILURE);
+            }
+            if ((sscanf (optarg, "%d%c", &arg_worker_cpus[arg_num_worker_cpus], &junk) != 1) ||
+                (arg_worker_cpus[arg_num_worker_cpus] < 0) || (arg_worker_cpus[arg_num_worker_cpus] >= CPU_SETSIZE))
+            {
+                printf ("Error: Invalid CPU %s\n", optarg);
+                exit (EXIT_FAILURE);
+            }
+            arg_num_worker_cpus++;
+            break;
+
+        case '?':
+        default:
+            display_usage (program_name);
+            break;
+        }
+
+        option = getopt (argc, argv, optstring);
+    }
+
+    if (optind < argc)
+    {
+        printf ("Error: Unexpected nonoption (first %s)\n\n", argv[optind]);
+        display_usage (program_name);
+    }
+
+    /* When no CPUs are specified use those the process is allowed to run on */
+    if (arg_num_worker_cpus == 0)
+    {
+        cpu_set_t cpus;
+
+        if (sched_getaffinity (0, sizeof (cpus), &cpus) == 0)
+        {
+            for (int cpu = 0; (cpu < CPU_SETSIZE) && (arg_num_worker_cpus < MAX_WORKER_CPUS); cpu++)
+            {
+                if (CPU_ISSET ((size_t) cpu, &cpus))
+                {
+                    arg_worker_cpus[arg_num_worker_cpus] = cpu;
+                    arg_num_worker_cpus++;
+                }
+            }
+        }
+        if (arg_num_worker_cpus == 0)
+        {
+            printf ("Error: Unable to get the CPU affinity of the process\n");
+            exit (EXIT_FAILURE);
+        }
+    }
+}
+
+
+/**
+ * @brief Get the size of a frame to transmit, according to the traffic profile
+ * @details The receive checking calls this to obtain the expected length of each received frame from its sequence number.
+ * @param[in] port The port the frame is transmitted on
+ * @param[in] sequence_number The sequence number of the frame
+ * @return Returns the frame length including the FCS
+ */
+static uint32_t get_frame_len_including_fcs (const port_traffic_context_t *const port, const uint32_t sequence_number)
+{
+    switch (arg_traffic_profile)
+    {
+    case TRAFFIC_PROFILE_SWEEP:
+        return port->rx_min_packet_len + (sequence_number % ((port->rx_max_packet_len - port->rx_min_packet_len) + 1));
+
+    case TRAFFIC_PROFILE_IMIX:
+        return imix_frame_sizes[sequence_number % NUM_IMIX_FRAME_SIZES];
+
+    case TRAFFIC_PROFILE_FIXED:
+    case TRAFFIC_PROFILE_BURST:
+    default:
+        return arg_frame_size;
+    }
+}
+
+
+/**
+ * @brief Determine if the frame sizes of the traffic profile are valid for the CMAC configuration of a port
+ * @param[in] port The port to check
+ * @return Returns true if all frame sizes generated are within the CMAC receive packet lengths
+ */
+static bool profile_valid_for_port (const port_traffic_context_t *const port)
+{
+    uint32_t min_frame_len = arg_frame_size;
+    uint32_t max_frame_len = arg_frame_size;
+
+    if (arg_traffic_profile == TRAFFIC_PROFILE_SWEEP)
+    {
+        min_frame_len = port->rx_min_packet_len;
+        max_frame_len = port->rx_max_packet_len;
+    }
+    else if (arg_traffic_profile == TRAFFIC_PROFILE_IMIX)
+    {
+        min_frame_len = UINT32_MAX;
+        max_frame_len = 0;
+        for (uint32_t size_index = 0; size_index < NUM_IMIX_FRAME_SIZES; size_index++)
+        {
+            if (imix_frame_sizes[size_index] < min_frame_len)
+            {
+                min_frame_len = imix_frame_sizes[size_index];
+            }
+            if (imix_frame_sizes[size_index] > max_frame_len)
+            {
+                max_frame_len = imix_frame_sizes[size_index];
+            }
+        }
+    }
+
+    return (min_frame_len >= port->rx_min_packet_len) && (max_frame_len <= port->rx_max_packet_len) &&
+            (min_frame_len >= (offsetof (test_ethernet_frame_t, test_payload) + sizeof (uint32_t))) &&
+            (max_frame_len <= MAX_PACKET_BYTES);
+}
+
+
+/*
+ * @brief Wait for the receive link of a port to be ready ("up") before starting the test
+ * @details Also ensures the CMAC port is enabled, since is disabled at reset.
+ * @param[in/out] port The port to wait for the link to be ready
+ * @return Returns true if the link is ready, or false if timed out
+ */
+static bool wait_receive_link_ready (port_traffic_context_t *const port)
+{
+    const uint32_t rx_link_ready_status_value = STAT_RX_STATUS_REG_STAT_RX_STATUS_MASK | STAT_RX_STATUS_REG_STAT_RX_ALIGNED_MASK;
+    const int64_t timeout_time = get_monotonic_time () + (LINK_READY_TIMEOUT_SECS * 1000000000LL);
+    const struct timespec hold_off =
+    {
+        .tv_sec = 0,
+        .tv_nsec = 100000000 /* 100 milliseconds */
+    };
+    bool rx_link_ready;
+    bool timed_out = false;
+
+    cmac_enable_port (port->cmac_port);
+    do
+    {
+        const uint32_t rx_status = read_reg32 (port->cmac_port->cmac_control_status_statistics_regs, STAT_RX_STATUS_REG_OFFSET);
+
+        rx_link_ready = rx_status == rx_link_ready_status_value;
+        if (!rx_link_ready)
+        {
+            timed_out = get_monotonic_time () > timeout_time;
+            if (!timed_out)
+            {
+                clock_nanosleep (CLOCK_MONOTONIC, 0, &hold_off, NULL);
+            }
+        }
+    } while (!rx_link_ready && !timed_out);
+
+    return rx_link_ready;
+}
+
+
+/**
+ * @brief Initialise the DMA transfers and transmit buffers for one port
+ * @param[in/out] port The port to initialise
+ */
+static void initialise_port_transfers (port_traffic_context_t *const port)
+{
+    const size_t buffer_size = vfio_align_cache_line_size (sizeof (test_ethernet_frame_t));
+    fpga_design_t *const design = port->design;
+
+    port->xdma_overall_success = true;
+
+    /* Configure XDMA transmit to use a queue of variable size buffers. */
+    const x2x_transfer_configuration_t h2c_transfer_configuration =
+    {
+        .dma_bridge_memory_size_bytes = design->dma_bridge_memory_size_bytes,
+        .dma_bridge_memory_base_address = design->dma_bridge_memory_base_address,
+        .min_size_alignment = 1, /* The host memory is byte addressable */
+        .num_descriptors = NUM_BUFFERS,
+        .channels_submodule = DMA_SUBMODULE_H2C_CHANNELS,
+        .channel_id = port->port_num,
+        .bytes_per_buffer = 0, /* Using variable length transfers */
+        .host_buffer_start_offset = 0, /* Not used for variable length transfers */
+        .card_buffer_start_offset = 0, /* Not used for AXI stream */
+        .c2h_stream_continuous = false,
+        .timeout_seconds = XMDA_TRANSFER_TIMEOUT_SECS,
+        .vfio_device = design->vfio_device,
+        .bar_index = design->dma_bridge_bar,
+        .descriptors_mapping = &port->descriptors_mapping,
+        .data_mapping = &port->h2c_data_mapping,
+        .overall_success = &port->xdma_overall_success
+    };
+
+    /* Configure XMDA receive to use a queue of fixed size buffers, based upon the cache line aligned size of the maximum
+     * length payload. */
+    const x2x_transfer_configuration_t c2h_transfer_configuration =
+    {
+        .dma_bridge_memory_size_bytes = design->dma_bridge_memory_size_bytes,
+        .dma_bridge_memory_base_address = design->dma_bridge_memory_base_address,
+        .min_size_alignment = 1, /* The host memory is byte addressable */
+        .num_descriptors = NUM_BUFFERS,
+        .channels_submodule = DMA_SUBMODULE_C2H_CHANNELS,
+        .channel_id = port->port_num,
+        .bytes_per_buffer = buffer_size,
+        .host_buffer_start_offset = 0, /* Separate host buffer used for transmit and receive transfers */
+        .card_buffer_start_offset = 0, /* Not used for AXI stream */
+        .c2h_stream_continuous = false,
+        .timeout_seconds = XMDA_TRANSFER_TIMEOUT_SECS,
+        .vfio_device = design->vfio_device,
+        .bar_index = design->dma_bridge_bar,
+        .descriptors_mapping = &port->descriptors_mapping,
+        .data_mapping = &port->c2h_data_mapping,
+        .overall_success = &port->xdma_overall_success
+    };
+
+    const size_t descriptors_allocation_size = x2x_get_descriptor_allocation_size (&h2c_transfer_configuration) +
+            x2x_get_descriptor_allocation_size (&c2h_transfer_configuration);
+    allocate_vfio_dma_mapping (design->vfio_device, &port->descriptors_mapping, descriptors_allocation_size,
+            VFIO_DMA_MAP_FLAG_READ | VFIO_DMA_MAP_FLAG_WRITE, VFIO_BUFFER_ALLOCATION_HEAP);
+    allocate_vfio_dma_mapping (design->vfio_device, &port->h2c_data_mapping, NUM_BUFFERS * buffer_size,
+            VFIO_DMA_MAP_FLAG_READ, VFIO_BUFFER_ALLOCATION_HEAP);
+    allocate_vfio_dma_mapping (design->vfio_device, &port->c2h_data_mapping, NUM_BUFFERS * buffer_size,
+            VFIO_DMA_MAP_FLAG_WRITE, VFIO_BUFFER_ALLOCATION_HEAP);
+
+    port->xdma_overall_success = (port->descriptors_mapping.buffer.vaddr != NULL) &&
+                                 (port->h2c_data_mapping.buffer.vaddr    != NULL) &&
+                                 (port->c2h_data_mapping.buffer.vaddr    != NULL);
+    if (port->xdma_overall_success)
+    {
+        x2x_initialise_transfer_context (&port->h2c_transfer, &h2c_transfer_configuration);
+        x2x_initialise_transfer_context (&port->c2h_transfer, &c2h_transfer_configuration);
+    }
+
+    if (port->xdma_overall_success)
+    {
+        /* Create the template frame of the maximum size, and copy to all transmit buffers */
+        const size_t num_payload_bytes = sizeof (port->template_frame.test_payload);
+        uint8_t *const tx_buffers = port->h2c_data_mapping.buffer.vaddr;
+
+        memcpy (port->template_frame.destination_mac_addr, destination_mac_addr, sizeof (port->template_frame.destination_mac_addr));
+        memcpy (port->template_frame.source_mac_addr, source_mac_addr, sizeof (port->template_frame.source_mac_addr));
+        port->template_frame.ether_type = htons (ETH_P_802_EX1);
+        port->template_frame.port_index = port->port_index;
+        port->template_frame.sequence_number = 0;
+        for (uint32_t payload_index = 0; payload_index < num_payload_bytes; payload_index++)
+        {
+            port->template_frame.test_payload[payload_index] = (uint8_t) (payload_index + port->port_index);
+        }
+        for (uint32_t buffer_index = 0; buffer_index < NUM_BUFFERS; buffer_index++)
+        {
+            memcpy (&tx_buffers[buffer_index * buffer_size], &port->template_frame, sizeof (port->template_frame));
+        }
+
+        /* Start transfers for all receive buffers */
+        for (uint32_t rx_buffer_index = 0; rx_buffer_index < NUM_BUFFERS; rx_buffer_index++)
+        {
+            x2x_start_next_c2h_buffer (&port->c2h_transfer);
+        }
+    }
+}
+
+
+/**
+ * @brief If a transfer failed, report an error to the console
+ * @param[in] context The transfer context to check for errors.
+ */
+static void report_if_transfer_failed (const x2x_transfer_context_t *const context)
+{
+    if (context->failed)
+    {
+        printf ("  %s %s channel %u failure : %s%s\n",
+                context->configuration.vfio_device->device_name,
+                (context->configuration.channels_submodule == DMA_SUBMODULE_H2C_CHANNELS) ? "H2C" : "C2H",
+                context->configuration.channel_id,
+                context->error_message,
+                context->timeout_awaiting_idle_at_finalisation ? " (+timeout waiting for idle at finalisation)" : "");
+    }
+}
+
+
+/**
+ * @brief Finalise the DMA transfers for one port, freeing the resources
+ * @param[in/out] port The port to finalise
+ */
+static void finalise_port_transfers (port_traffic_context_t *const port)
+{
+    x2x_finalise_transfer_context (&port->h2c_transfer);
+    x2x_finalise_transfer_context (&port->c2h_transfer);
+
+    report_if_transfer_failed (&port->h2c_transfer);
+    report_if_transfer_failed (&port->c2h_transfer);
+
+    free_vfio_dma_mapping (&port->c2h_data_mapping);
+    free_vfio_dma_mapping (&port->h2c_data_mapping);
+    free_vfio_dma_mapping (&port->descriptors_mapping);
+}
+
+
+/**
+ * @brief Add to a traffic counter, which is read by the main thread
+ * @param[in/out] counter The counter to update, only written by the calling worker thread
+ * @param[in] increment The value to add to the counter
+ */
+static inline void add_to_counter (uint64_t *const counter, const uint64_t increment)
+{
+    __atomic_store_n (counter, *counter + increment, __ATOMIC_RELAXED);
+}
+
+
+/**
+ * @brief Check one frame received on a port, updating the counters
+ * @param[in/out] port The port the frame was received on
+ * @param[in] rx_frame The received frame
+ * @param[in] transfer_len The length of the received frame, excluding the FCS
+ * @param[in] end_of_packet Indicates if the received frame was terminated by the end of packet
+ */
+static void check_received_frame (port_traffic_context_t *const port, const test_ethernet_frame_t *const rx_frame,
+                                  const size_t transfer_len, const bool end_of_packet)
+{
+    const uint32_t sequence_number = rx_frame->sequence_number;
+    bool frame_valid = end_of_packet && (transfer_len >= offsetof (test_ethernet_frame_t, test_payload)) &&
+            (rx_frame->port_index == port->port_index);
+
+    if (frame_valid)
+    {
+        /* Check the length and contents against the template, for the frame size the sequence number was transmitted with */
+        const size_t expected_len = get_frame_len_including_fcs (port, sequence_number) - sizeof (uint32_t);
+
+        frame_valid = (transfer_len == expected_len) &&
+                (memcmp (rx_frame, &port->template_frame, offsetof (test_ethernet_frame_t, port_index)) == 0) &&
+                (memcmp (rx_frame->test_payload, port->template_frame.test_payload,
+                        transfer_len - offsetof (test_ethernet_frame_t, test_payload)) == 0);
+    }
+
+    add_to_counter (&port->counters.rx_frames, 1);
+    add_to_counter (&port->counters.rx_bytes, transfer_len + sizeof (uint32_t));
+    if (!frame_valid)
+    {
+        add_to_counter (&port->counters.corrupt_frames, 1);
+    }
+    else
+    {
+        /* Check the sequence number, using a signed difference to allow for wrap-around */
+        const int32_t sequence_difference = (int32_t) (sequence_number - port->rx_expected_sequence_number);
+
+        if (sequence_difference == 0)
+        {
+            port->rx_expected_sequence_number++;
+        }
+        else if (sequence_difference > 0)
+        {
+            add_to_counter (&port->counters.lost_frames, (uint64_t) sequence_difference);
+            port->rx_expected_sequence_number = sequence_number + 1;
+        }
+        else
+        {
+            add_to_counter (&port->counters.reordered_frames, 1);
+        }
+    }
+}
+
+
+/**
+ * @brief The worker thread which generates and checks the traffic for one port
+ * @details Runs until the test is requested to stop, and then waits for the frames in flight to be received.
+ * @param[in/out] arg The port to generate and check traffic on
+ * @return Not used
+ */
+static void *port_traffic_thread (void *arg)
+{
+    port_traffic_context_t *const port = arg;
+    const size_t buffer_size = vfio_align_cache_line_size (sizeof (test_ethernet_frame_t));
+    const test_ethernet_frame_t *rx_frame;
+    size_t transfer_len;
+    bool end_of_packet;
+    uint32_t num_frames_in_burst = 0;
+    int64_t next_burst_time = 0;
+    int64_t last_rx_progress_time = get_monotonic_time ();
+    uint32_t frames_in_flight = 0;
+
+    while (port->xdma_overall_success && (!test_stop_requested || (frames_in_flight > 0)))
+    {
+        int64_t now = get_monotonic_time ();
+
+        /* Queue transmit frames while there is a receive buffer available for each frame in flight */
+        bool tx_allowed = !test_stop_requested;
+        while (port->xdma_overall_success && tx_allowed && (frames_in_flight < NUM_BUFFERS))
+        {
+            if (arg_traffic_profile == TRAFFIC_PROFILE_BURST)
+            {
+                if (num_frames_in_burst == arg_burst_num_frames)
+                {
+                    next_burst_time = now + arg_burst_gap_ns;
+                    num_frames_in_burst = 0;
+                }
+                tx_allowed = now >= next_burst_time;
+            }
+
+            if (tx_allowed)
+            {
+                const uint32_t frame_len_including_fcs = get_frame_len_including_fcs (port, port->tx_sequence_number);
+                const uint64_t host_buffer_offset = (port->tx_sequence_number % NUM_BUFFERS) * buffer_size;
+                test_ethernet_frame_t *const tx_frame = x2x_populate_stream_transfer (&port->h2c_transfer,
+                        frame_len_including_fcs - sizeof (uint32_t), host_buffer_offset);
+
+                tx_allowed = tx_frame != NULL;
+                if (tx_allowed)
+                {
+                    tx_frame->sequence_number = port->tx_sequence_number;
+                    x2x_start_populated_descriptors (&port->h2c_transfer);
+                    add_to_counter (&port->counters.tx_frames, 1);
+                    add_to_counter (&port->counters.tx_bytes, frame_len_including_fcs);
+                    port->tx_sequence_number++;
+                    num_frames_in_burst++;
+                }
+            }
+            frames_in_flight = port->tx_sequence_number - port->rx_expected_sequence_number;
+        }
+
+        /* Free the descriptors of completed transmit frames */
+        while (port->xdma_overall_success && (x2x_poll_completed_transfer (&port->h2c_transfer, NULL, NULL) != NULL))
+        {
+        }
+
+        /* Check received frames */
+        while (port->xdma_overall_success &&
+               ((rx_frame = x2x_poll_completed_transfer (&port->c2h_transfer, &transfer_len, &end_of_packet)) != NULL))
+        {
+            check_received_frame (port, rx_frame, transfer_len, end_of_packet);
+            x2x_start_next_c2h_buffer (&port->c2h_transfer);
+            last_rx_progress_time = get_monotonic_time ();
+        }
+
+        /* If no frames have been received for the stall timeout, count the frames in flight as lost so that transmission
+         * can continue. Should any of these frames be received later they will be counted as reordered. */
+        frames_in_flight = port->tx_sequence_number - port->rx_expected_sequence_number;
+        now = get_monotonic_time ();
+        if ((frames_in_flight > 0) && ((now - last_rx_progress_time) > RX_STALL_TIMEOUT_NS))
+        {
+            add_to_counter (&port->counters.lost_frames, frames_in_flight);
+            port->rx_expected_sequence_number = port->tx_sequence_number;
+            frames_in_flight = 0;
+            last_rx_progress_time = now;
+        }
+        else if (frames_in_flight == 0)
+        {
+            last_rx_progress_time = now;
+        }
+    }
+
+    return NULL;
+}
+
+
+/**
+ * @brief Read a snapshot of the traffic counters for a port, which are being updated by the worker thread
+ * @param[in] port The port to read the counters for
+ * @param[out] counters The snapshot of the counters
+ */
+static void read_port_counters (const port_traffic_context_t *const port, port_traffic_counters_t *const counters)
+{
+    counters->tx_frames = __atomic_load_n (&port->counters.tx_frames, __ATOMIC_RELAXED);
+    counters->tx_bytes = __atomic_load_n (&port->counters.tx_bytes, __ATOMIC_RELAXED);
+    counters->rx_frames = __atomic_load_n (&port->counters.rx_frames, __ATOMIC_RELAXED);
+    counters->rx_bytes = __atomic_load_n (&port->counters.rx_bytes, __ATOMIC_RELAXED);
+    counters->lost_frames = __atomic_load_n (&port->counters.lost_frames, __ATOMIC_RELAXED);
+    counters->reordered_frames = __atomic_load_n (&port->counters.reordered_frames, __ATOMIC_RELAXED);
+    counters->corrupt_frames = __atomic_load_n (&port->counters.corrupt_frames, __ATOMIC_RELAXED);
+}
+
+
+/**
+ * @brief Display the throughput and errors for one port, or the aggregate over all ports, over an interval
+ * @param[in] name Identifies the port(s) the counters are for
+ * @param[in] interval_counters The change in the counters over the interval
+ * @param[in] total_counters The counters since the start of the test, used to report the errors
+ * @param[in] interval_ns The duration of the interval
+ */
+static void display_interval_throughput (const char *const name, const port_traffic_counters_t *const interval_counters,
+                                         const port_traffic_counters_t *const total_counters, const int64_t interval_ns)
+{
+    const double interval_secs = (double) interval_ns / 1E9;
+
+    printf ("  %-22s TX %8.3f Mpps %7.2f Gb/s  RX %8.3f Mpps %7.2f Gb/s  lost %" PRIu64 " reordered %" PRIu64 " corrupt %" PRIu64 "\n",
+            name,
+            ((double) interval_counters->tx_frames / interval_secs) / 1E6,
+            ((double) interval_counters->tx_bytes * 8.0 / interval_secs) / 1E9,
+            ((double) interval_counters->rx_frames / interval_secs) / 1E6,
+            ((double) interval_counters->rx_bytes * 8.0 / interval_secs) / 1E9,
+            total_counters->lost_frames, total_counters->reordered_frames, total_counters->corrupt_frames);
+}
+
+
+/**
+ * @brief Accumulate one set of traffic counters into another
+ * @param[in/out] total The counters to accumulate into
+ * @param[in] counters The counters to add
+ */
+static void accumulate_counters (port_traffic_counters_t *const total, const port_traffic_counters_t *const counters)
+{
+    total->tx_frames += counters->tx_frames;
+    total->tx_bytes += counters->tx_bytes;
+    total->rx_frames += counters->rx_frames;
+    total->rx_bytes += counters->rx_bytes;
+    total->lost_frames += counters->lost_frames;
+    total->reordered_frames += counters->reordered_frames;
+    total->corrupt_frames += counters->corrupt_frames;
+}
+
+
+/**
+ * @brief Report the throughput of all ports at regular intervals, until the test is requested to stop
+ * @param[in] context The ports being tested
+ * @param[out] start_time The monotonic time the reporting started
+ */
+static void report_live_throughput (const traffic_generator_context_t *const context, int64_t *const start_time)
+{
+    port_traffic_counters_t *const previous_counters = calloc (context->num_ports, sizeof (previous_counters[0]));
+    port_traffic_counters_t current_counters;
+    port_traffic_counters_t interval_counters;
+    port_traffic_counters_t aggregate_interval;
+    port_traffic_counters_t aggregate_total;
+    char port_name[sizeof (((vfio_device_t *) NULL)->device_name) + 16];
+    struct timespec report_time;
+
+    if (previous_counters == NULL)
+    {
+        printf ("Error: Failed to allocate previous counters\n");
+        exit (EXIT_FAILURE);
+    }
+
+    *start_time = get_monotonic_time ();
+    int64_t previous_time = *start_time;
+    const int64_t stop_time = *start_time + (arg_test_duration_secs * 1000000000LL);
+
+    clock_gettime (CLOCK_MONOTONIC, &report_time);
+    while (!test_stop_requested)
+    {
+        /* Wait until the next report, using an absolute time to avoid drift */
+        report_time.tv_sec++;
+        clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &report_time, NULL);
+
+        const int64_t now = get_monotonic_time ();
+        const int64_t interval_ns = now - previous_time;
+
+        memset (&aggregate_interval, 0, sizeof (aggregate_interval));
+        memset (&aggregate_total, 0, sizeof (aggregate_total));
+        printf ("After %.1f secs:\n", (double) (now - *start_time) / 1E9);
+        for (uint32_t port_index = 0; port_index < context->num_ports; port_index++)
+        {
+            const port_traffic_context_t *const port = context->ports[port_index];
+
+            read_port_counters (port, &current_counters);
+            interval_counters.tx_frames = current_counters.tx_frames - previous_counters[port_index].tx_frames;
+            interval_counters.tx_bytes = current_counters.tx_bytes - previous_counters[port_index].tx_bytes;
+            interval_counters.rx_frames = current_counters.rx_frames - previous_counters[port_index].rx_frames;
+            interval_counters.rx_bytes = current_counters.rx_bytes - previous_counters[port_index].rx_bytes;
+            interval_counters.lost_frames = current_counters.lost_frames - previous_counters[port_index].lost_frames;
+            interval_counters.reordered_frames = current_counters.reordered_frames - previous_counters[port_index].reordered_frames;
+            interval_counters.corrupt_frames = current_counters.corrupt_frames - previous_counters[port_index].corrupt_frames;
+            previous_counters[port_index] = current_counters;
+
+            snprintf (port_name, sizeof (port_name), "%s port %u", port->design->vfio_device->device_name, port->port_num);
+            display_interval_throughput (port_name, &interval_counters, &current_counters, interval_ns);
+            accumulate_counters (&aggregate_interval, &interval_counters);
+            accumulate_counters (&aggregate_total, &current_counters);
+        }
+        if (context->num_ports > 1)
+        {
+            display_interval_throughput ("Aggregate", &aggregate_interval, &aggregate_total, interval_ns);
+        }
+        previous_time = now;
+
+        if ((arg_test_duration_secs > 0) && (now >= stop_time))
+        {
+            test_stop_requested = true;
+        }
+    }
+
+    free (previous_counters);
+}
+
+
+/**
+ * @brief Select the ports to be tested, which are all CMAC ports configured for both transmit and receive
+ * @param[in/out] context The context to select the ports for
+ */
+static void select_tested_ports (traffic_generator_context_t *const context)
+{
+    uint32_t cpu_index = 0;
+    const uint32_t num_designs = context->designs.num_identified_designs;
+
+    context->routing = calloc ((num_designs > 0) ? num_designs : 1, sizeof (context->routing[0]));
+    context->ports = calloc ((num_designs > 0) ? (num_designs * MAX_CMAC_PORTS_PER_DESIGN) : 1, sizeof (context->ports[0]));
+    if ((context->routing == NULL) || (context->ports == NULL))
+    {
+        printf ("Error: Failed to allocate tested ports\n");
+        exit (EXIT_FAILURE);
+    }
+    context->num_ports = 0;
+    for (uint32_t design_index = 0; design_index < context->designs.num_identified_designs; design_index++)
+    {
+        fpga_design_t *const design = &context->designs.designs[design_index];
+
+        if (design->num_cmac_ports > 0)
+        {
+            /* Allow the DMA to be connected to the CMAC data ports */
+            if (design->axi_switch_regs != NULL)
+            {
+                configure_routing_for_device (design, &context->routing[design_index]);
+            }
+
+            for (uint32_t port_num = 0; port_num < design->num_cmac_ports; port_num++)
+            {
+                cmac_port_definition_t *const cmac_port = &design->cmac_ports[port_num];
+
+                if (cmac_port->configured_features[CMAC_FEATURE_PACKET_TX] &&
+                    cmac_port->configured_features[CMAC_FEATURE_PACKET_RX])
+                {
+                    port_traffic_context_t *const port = calloc (1, sizeof (*port));
+
+                    if (port == NULL)
+                    {
+                        printf ("Error: Failed to allocate port context\n");
+                        exit (EXIT_FAILURE);
+                    }
+                    port->port_index = context->num_ports;
+                    port->design = design;
+                    port->port_num = port_num;
+                    port->cmac_port = cmac_port;
+                    cmac_get_rx_min_max_packet_lens (cmac_port, &port->rx_min_packet_len, &port->rx_max_packet_len);
+
+                    if (!profile_valid_for_port (port))
+                    {
+                        printf ("Omitting %s port %u as %s profile frame sizes outside of CMAC rx packet lengths %u to %u bytes\n",
+                                design->vfio_device->device_name, port_num, traffic_profile_names[arg_traffic_profile],
+                                port->rx_min_packet_len, port->rx_max_packet_len);
+                        free (port);
+                    }
+                    else if (!wait_receive_link_ready (port))
+                    {
+                        printf ("Omitting %s port %u as receive link not ready\n", design->vfio_device->device_name, port_num);
+                        free (port);
+                    }
+                    else
+                    {
+                        port->cpu = arg_worker_cpus[cpu_index];
+                        cpu_index = (cpu_index + 1) % arg_num_worker_cpus;
+                        printf ("Testing %s design %s port %u on CPU %d\n",
+                                fpga_design_names[design->design_id], design->vfio_device->device_name, port_num, port->cpu);
+                        context->ports[context->num_ports] = port;
+                        context->num_ports++;
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+int main (int argc, char *argv[])
+{
+    traffic_generator_context_t *const context = calloc (1, sizeof (*context));
+    struct sigaction action;
+    pthread_attr_t attr;
+    cpu_set_t cpus;
+    int64_t start_time;
+    uint32_t port_index;
+    int rc;
+
+    if (context == NULL)
+    {
+        printf ("Error: Failed to allocate context\n");
+        exit (EXIT_FAILURE);
+    }
+
+    /* Read the command line arguments */
+    read_command_line_arguments (argc, argv);
+
+    /* Open the FPGA designs which have an IOMMU group assigned */
+    identify_pcie_fpga_designs (&context->designs);
+
+    select_tested_ports (context);
+    if (context->num_ports == 0)
+    {
+        printf ("Error: Found no CMAC ports to test\n");
+        close_pcie_fpga_designs (&context->designs);
+        exit (EXIT_FAILURE);
+    }
+
+    bool overall_success = true;
+    for (port_index = 0; port_index < context->num_ports; port_index++)
+    {
+        initialise_port_transfers (context->ports[port_index]);
+        overall_success = overall_success && context->ports[port_index]->xdma_overall_success;
+    }
+
+    /* Install signal handler, used to request test is stopped */
+    memset (&action, 0, sizeof (action));
+    action.sa_handler = stop_test_handler;
+    action.sa_flags = SA_RESTART;
+    rc = sigaction (SIGINT, &action, NULL);
+    if (rc != 0)
+    {
+        printf ("Error: sigaction failed\n");
+        exit (EXIT_FAILURE);
+    }
+
+    if (overall_success)
+    {
+        printf ("Generating %s profile", traffic_profile_names[arg_traffic_profile]);
+        if ((arg_traffic_profile == TRAFFIC_PROFILE_FIXED) || (arg_traffic_profile == TRAFFIC_PROFILE_BURST))
+        {
+            printf (" with frame size %u", arg_frame_size);
+        }
+        if (arg_traffic_profile == TRAFFIC_PROFILE_BURST)
+        {
+            printf (", %u frames per burst and %.1f us gap", arg_burst_num_frames, (double) arg_burst_gap_ns / 1E3);
+        }
+        printf (" on %u ports\n", context->num_ports);
+        if (arg_test_duration_secs > 0)
+        {
+            printf ("Running for %" PRIi64 " seconds. Press Ctrl-C to stop test early\n", arg_test_duration_secs);
+        }
+        else
+        {
+            printf ("Press Ctrl-C to stop test\n");
+        }
+
+        /* Create the worker threads, each pinned to a CPU */
+        for (port_index = 0; port_index < context->num_ports; port_index++)
+        {
+            port_traffic_context_t *const port = context->ports[port_index];
+
+            rc = pthread_attr_init (&attr);
+            if (rc == 0)
+            {
+                CPU_ZERO (&cpus);
+                CPU_SET ((size_t) port->cpu, &cpus);
+                rc = pthread_attr_setaffinity_np (&attr, sizeof (cpus), &cpus);
+            }
+            if (rc == 0)
+            {
+                rc = pthread_create (&port->thread, &attr, port_traffic_thread, port);
+                pthread_attr_destroy (&attr);
+            }
+            if (rc != 0)
+            {
+                printf ("Error: Failed to create worker thread on CPU %d\n", port->cpu);
+                exit (EXIT_FAILURE);
+            }
+        }
+
+        report_live_throughput (context, &start_time);
+
+        for (port_index = 0; port_index < context->num_ports; port_index++)
+        {
+            rc = pthread_join (context->ports[port_index]->thread, NULL);
+            if (rc != 0)
+            {
+                printf ("Error: pthread_join failed\n");
+                exit (EXIT_FAILURE);
+            }
+        }
+
+        /* Display the overall results */
+        const int64_t test_duration_ns = get_monotonic_time () - start_time;
+        port_traffic_counters_t port_counters;
+        port_traffic_counters_t aggregate_counters = {0};
+        char port_name[sizeof (((vfio_device_t *) NULL)->device_name) + 16];
+
+        printf ("\nOverall test statistics over %.1f secs:\n", (double) test_duration_ns / 1E9);
+        for (port_index = 0; port_index < context->num_ports; port_index++)
+        {
+            const port_traffic_context_t *const port = context->ports[port_index];
+
+            read_port_counters (port, &port_counters);
+            snprintf (port_name, sizeof (port_name), "%s port %u", port->design->vfio_device->device_name, port->port_num);
+            display_interval_throughput (port_name, &port_counters, &port_counters, test_duration_ns);
+            accumulate_counters (&aggregate_counters, &port_counters);
+            overall_success = overall_success && port->xdma_overall_success;
+        }
+        if (context->num_ports > 1)
+        {
+            display_interval_throughput ("Aggregate", &aggregate_counters, &aggregate_counters, test_duration_ns);
+        }
+        overall_success = overall_success && (aggregate_counters.rx_frames > 0) && (aggregate_counters.lost_frames == 0) &&
+                (aggregate_counters.reordered_frames == 0) && (aggregate_counters.corrupt_frames == 0);
+    }
+
+    for (port_index = 0; port_index < context->num_ports; port_index++)
+    {
+        finalise_port_transfers (context->ports[port_index]);
+        free (context->ports[port_index]);
+    }
+    free (context->ports);
+    free (context->routing);
+    close_pcie_fpga_designs (&context->designs);
+
+    printf ("\nOverall %s\n", overall_success ? "PASS" : "FAIL");
+    free (context);
+
+    return overall_success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
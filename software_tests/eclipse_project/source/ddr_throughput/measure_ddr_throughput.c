@@ -280,7 +280,7 @@ int main (int argc, char *argv[])
 
     for (uint32_t device_index = 0; device_index < vfio_devices.num_devices; device_index++)
     {
-        vfio_device_t *const vfio_device = &vfio_devices.devices[device_index];
+        vfio_device_t *const vfio_device = vfio_devices.devices[device_index];
         const uint32_t bar_index = 0;
         const size_t axi_dma_offset = 0x2000;
         const size_t axi_dma_frame_size = 0x2000;
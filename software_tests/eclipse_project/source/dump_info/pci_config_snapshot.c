@@ -0,0 +1,1179 @@
+/*
+ * @file pci_config_snapshot.c
+ * @date 18 Oct 2026
+ * @author Chester Gillon
+ * @brief Snapshot, compare and restore the PCI configuration space of a device using the generic PCI access mechanism
+ * @details
+ *   Intended to check the effect of an operation such as a device reset or a bitstream reload on the configuration of a
+ *   device, by:
+ *   a. Saving a snapshot of the configuration space of the device to a file before the operation.
+ *   b. Comparing the snapshot against the device after the operation, or against another snapshot file.
+ *   c. Optionally restoring the writable fields which differ from the snapshot.
+ *
+ *   The comparison decodes field level differences for the standard header, and for the capabilities which
+ *   dump_pci_info.c decodes along with Advanced Error Reporting. Differences in other parts of the configuration space
+ *   are reported as raw dwords.
+ *
+ *   The snapshot file is the binary pci_config_snapshot_t structure, in the native byte order of the host. Each dword
+ *   of the configuration space has a flag to indicate if it could be read, since:
+ *   a. The extended configuration space is only read if the device has one.
+ *   b. libpciacess and pciutils can only read the first 64 bytes without the CAP_SYS_ADMIN capability.
+ *
+ *   Restore only writes the registers which are marked as restorable in the decode tables, and for those only the bits
+ *   which are read/write. Status bits which are write-one-to-clear and bits which trigger actions are never written.
+ *   The power management control/status register is restored first, since a transition from D3hot to D0 may reset
+ *   the other registers. The command register is restored last, so that memory decoding and bus mastering aren't
+ *   enabled before the BARs have been restored.
+ */
+
+#include "generic_pci_access.h"
+#include "vfio_bitops.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <getopt.h>
+#include <pci/pci.h>
+#include <linux/pci_regs.h>
+
+
+#define NELEMENTS(array) (sizeof(array) / sizeof(array[0]))
+
+
+/* Identifies the snapshot file format */
+#define SNAPSHOT_MAGIC "PCICFGSS"
+#define SNAPSHOT_FORMAT_VERSION 1
+
+
+/* The number of dwords in the configuration space saved in a snapshot */
+#define SNAPSHOT_NUM_DWORDS (PCI_CFG_SPACE_EXP_SIZE / sizeof (uint32_t))
+
+
+/* The maximum number of decoded registers which can be compared between two snapshots */
+#define MAX_REGISTER_INSTANCES 256
+
+
+/* The binary format of a snapshot of the configuration space of one device, which is saved to a file */
+typedef struct
+{
+    /* Set to SNAPSHOT_MAGIC, without a terminating null */
+    char magic[8];
+    /* Set to SNAPSHOT_FORMAT_VERSION */
+    uint32_t format_version;
+    /* The PCI location of the device the snapshot was captured from */
+    uint32_t domain;
+    uint32_t bus;
+    uint32_t dev;
+    uint32_t func;
+    /* The CLOCK_REALTIME seconds at which the snapshot was captured */
+    int64_t capture_time;
+    /* Non-zero for each dword of the configuration space which was read */
+    uint8_t dword_valid[SNAPSHOT_NUM_DWORDS];
+    /* The configuration space contents */
+    uint32_t dwords[SNAPSHOT_NUM_DWORDS];
+} pci_config_snapshot_t;
+
+
+/* Defines one field in a configuration register, for decoding differences */
+typedef struct
+{
+    /* The name of the field, following the lspci naming */
+    const char *name;
+    /* The mask for the field in the register */
+    uint32_t mask;
+} config_field_t;
+
+
+/* Defines one configuration register */
+typedef struct
+{
+    /* The name of the register */
+    const char *name;
+    /* The offset of the register from the start of the header or capability */
+    uint32_t offset;
+    /* The size of the register in bytes, of 1, 2 or 4 */
+    uint32_t size;
+    /* The bits in the register which may be restored. Zero if the register isn't restored. */
+    uint32_t restore_mask;
+    /* The fields decoded in the register, terminated by an entry with a NULL name. May be NULL. */
+    const config_field_t *fields;
+} config_register_t;
+
+
+/* Defines the registers decoded for a capability */
+typedef struct
+{
+    /* The name of the capability */
+    const char *name;
+    /* True for an extended capability, false for a capability in the standard capability list */
+    bool extended;
+    /* The capability identity */
+    uint16_t id;
+    /* The registers decoded for the capability */
+    size_t num_registers;
+    const config_register_t *registers;
+} capability_decode_t;
+
+
+/* One decoded register to compare between a reference and current snapshot.
+ * The absolute offset can be different in each snapshot if the position of a capability has changed. */
+typedef struct
+{
+    /* The name of the header or capability containing the register */
+    const char *region_name;
+    /* The definition of the register */
+    const config_register_t *reg;
+    /* The absolute offset of the register in the reference and current snapshots */
+    uint32_t reference_offset;
+    uint32_t current_offset;
+} register_instance_t;
+
+
+static const config_field_t command_fields[] =
+{
+    {"I/O", PCI_COMMAND_IO},
+    {"Mem", PCI_COMMAND_MEMORY},
+    {"BusMaster", PCI_COMMAND_MASTER},
+    {"ParErr", PCI_COMMAND_PARITY},
+    {"SERR", PCI_COMMAND_SERR},
+    {"DisINTx", PCI_COMMAND_INTX_DISABLE},
+    {NULL, 0}
+};
+
+
+static const config_field_t status_fields[] =
+{
+    {"INTx", PCI_STATUS_INTERRUPT},
+    {"CapList", PCI_STATUS_CAP_LIST},
+    {"<ParErr", PCI_STATUS_PARITY},
+    {">TAbort", PCI_STATUS_SIG_TARGET_ABORT},
+    {"<TAbort", PCI_STATUS_REC_TARGET_ABORT},
+    {"<MAbort", PCI_STATUS_REC_MASTER_ABORT},
+    {">SERR", PCI_STATUS_SIG_SYSTEM_ERROR},
+    {"DetParErr", PCI_STATUS_DETECTED_PARITY},
+    {NULL, 0}
+};
+
+
+/* The registers common to all header types */
+static const config_register_t common_header_registers[] =
+{
+    {"VendorID", PCI_VENDOR_ID, 2, 0, NULL},
+    {"DeviceID", PCI_DEVICE_ID, 2, 0, NULL},
+    {"Command", PCI_COMMAND, 2, 0xffff, command_fields},
+    {"Status", PCI_STATUS, 2, 0, status_fields},
+    {"Revision", PCI_REVISION_ID, 1, 0, NULL},
+    {"ProgIf", PCI_CLASS_PROG, 1, 0, NULL},
+    {"Class", PCI_CLASS_DEVICE, 2, 0, NULL},
+    {"CacheLineSize", PCI_CACHE_LINE_SIZE, 1, 0xff, NULL},
+    {"LatencyTimer", PCI_LATENCY_TIMER, 1, 0xff, NULL},
+    {"HeaderType", PCI_HEADER_TYPE, 1, 0, NULL},
+    {"BIST", PCI_BIST, 1, 0, NULL},
+    {"CapPtr", PCI_CAPABILITY_LIST, 1, 0, NULL},
+    {"InterruptLine", PCI_INTERRUPT_LINE, 1, 0xff, NULL},
+    {"InterruptPin", PCI_INTERRUPT_PIN, 1, 0, NULL}
+};
+
+
+/* The registers specific to a normal header, for endpoints */
+static const config_register_t normal_header_registers[] =
+{
+    {"BAR0", PCI_BASE_ADDRESS_0, 4, 0xffffffff, NULL},
+    {"BAR1", PCI_BASE_ADDRESS_1, 4, 0xffffffff, NULL},
+    {"BAR2", PCI_BASE_ADDRESS_2, 4, 0xffffffff, NULL},
+    {"BAR3", PCI_BASE_ADDRESS_3, 4, 0xffffffff, NULL},
+    {"BAR4", PCI_BASE_ADDRESS_4, 4, 0xffffffff, NULL},
+    {"BAR5", PCI_BASE_ADDRESS_5, 4, 0xffffffff, NULL},
+    {"CardbusCIS", PCI_CARDBUS_CIS, 4, 0, NULL},
+    {"SubsystemVendorID", PCI_SUBSYSTEM_VENDOR_ID, 2, 0, NULL},
+    {"SubsystemID", PCI_SUBSYSTEM_ID, 2, 0, NULL},
+    {"ROM", PCI_ROM_ADDRESS, 4, 0xffffffff, NULL}
+};
+
+
+/* The Discard Timer Status bit in the bridge control register, which is write-one-to-clear.
+ * Not defined in linux/pci_regs.h */
+#define BRIDGE_CTL_DISCARD_TIMER_STATUS 0x0400
+
+
+/* The registers specific to a bridge header.
+ * The Secondary Bus Reset bit in the bridge control register isn't restored, as it triggers an action. */
+static const config_register_t bridge_header_registers[] =
+{
+    {"BAR0", PCI_BASE_ADDRESS_0, 4, 0xffffffff, NULL},
+    {"BAR1", PCI_BASE_ADDRESS_1, 4, 0xffffffff, NULL},
+    {"PrimaryBus", PCI_PRIMARY_BUS, 1, 0xff, NULL},
+    {"SecondaryBus", PCI_SECONDARY_BUS, 1, 0xff, NULL},
+    {"SubordinateBus", PCI_SUBORDINATE_BUS, 1, 0xff, NULL},
+    {"SecLatency", PCI_SEC_LATENCY_TIMER, 1, 0xff, NULL},
+    {"IOBase", PCI_IO_BASE, 1, 0xff, NULL},
+    {"IOLimit", PCI_IO_LIMIT, 1, 0xff, NULL},
+    {"SecStatus", PCI_SEC_STATUS, 2, 0, NULL},
+    {"MemBase", PCI_MEMORY_BASE, 2, 0xffff, NULL},
+    {"MemLimit", PCI_MEMORY_LIMIT, 2, 0xffff, NULL},
+    {"PrefMemBase", PCI_PREF_MEMORY_BASE, 2, 0xffff, NULL},
+    {"PrefMemLimit", PCI_PREF_MEMORY_LIMIT, 2, 0xffff, NULL},
+    {"PrefBaseUpper", PCI_PREF_BASE_UPPER32, 4, 0xffffffff, NULL},
+    {"PrefLimitUpper", PCI_PREF_LIMIT_UPPER32, 4, 0xffffffff, NULL},
+    {"IOBaseUpper", PCI_IO_BASE_UPPER16, 2, 0xffff, NULL},
+    {"IOLimitUpper", PCI_IO_LIMIT_UPPER16, 2, 0xffff, NULL},
+    {"ROM", PCI_ROM_ADDRESS1, 4, 0xffffffff, NULL},
+    {"BridgeControl", PCI_BRIDGE_CONTROL, 2, 0xffff & ~(PCI_BRIDGE_CTL_BUS_RESET | BRIDGE_CTL_DISCARD_TIMER_STATUS), NULL}
+};
+
+
+static const config_field_t pm_control_status_fields[] =
+{
+    {"PowerState", PCI_PM_CTRL_STATE_MASK},
+    {"NoSoftRst", PCI_PM_CTRL_NO_SOFT_RESET},
+    {"PME-Enable", PCI_PM_CTRL_PME_ENABLE},
+    {"DSel", PCI_PM_CTRL_DATA_SEL_MASK},
+    {"PME", PCI_PM_CTRL_PME_STATUS},
+    {NULL, 0}
+};
+
+
+static const config_register_t pm_registers[] =
+{
+    {"PMC", PCI_PM_PMC, 2, 0, NULL},
+    {"PMCSR", PCI_PM_CTRL, 2, PCI_PM_CTRL_STATE_MASK | PCI_PM_CTRL_PME_ENABLE | PCI_PM_CTRL_DATA_SEL_MASK,
+            pm_control_status_fields}
+};
+
+
+static const config_field_t pcie_device_control_fields[] =
+{
+    {"CorrErr", PCI_EXP_DEVCTL_CERE},
+    {"NonFatalErr", PCI_EXP_DEVCTL_NFERE},
+    {"FatalErr", PCI_EXP_DEVCTL_FERE},
+    {"UnsupReq", PCI_EXP_DEVCTL_URRE},
+    {"RlxdOrd", PCI_EXP_DEVCTL_RELAX_EN},
+    {"MaxPayload", PCI_EXP_DEVCTL_PAYLOAD},
+    {"ExtTag", PCI_EXP_DEVCTL_EXT_TAG},
+    {"PhantFunc", PCI_EXP_DEVCTL_PHANTOM},
+    {"AuxPwr", PCI_EXP_DEVCTL_AUX_PME},
+    {"NoSnoop", PCI_EXP_DEVCTL_NOSNOOP_EN},
+    {"MaxReadReq", PCI_EXP_DEVCTL_READRQ},
+    {NULL, 0}
+};
+
+
+static const config_field_t pcie_device_status_fields[] =
+{
+    {"CorrErr", PCI_EXP_DEVSTA_CED},
+    {"NonFatalErr", PCI_EXP_DEVSTA_NFED},
+    {"FatalErr", PCI_EXP_DEVSTA_FED},
+    {"UnsupReq", PCI_EXP_DEVSTA_URD},
+    {"AuxPwr", PCI_EXP_DEVSTA_AUXPD},
+    {"TransPend", PCI_EXP_DEVSTA_TRPND},
+    {NULL, 0}
+};
+
+
+static const config_field_t pcie_link_capabilities_fields[] =
+{
+    {"Speed", PCI_EXP_LNKCAP_SPEED},
+    {"Width", PCI_EXP_LNKCAP_WIDTH},
+    {"ASPM", PCI_EXP_LNKCAP_ASPMS},
+    {"Port #", PCI_EXP_LNKCAP_PN},
+    {NULL, 0}
+};
+
+
+static const config_field_t pcie_link_control_fields[] =
+{
+    {"ASPM", PCI_EXP_LNKCTL_ASPMC},
+    {"RCB", PCI_EXP_LNKCTL_RCB},
+    {"Disabled", PCI_EXP_LNKCTL_LD},
+    {"CommClk", PCI_EXP_LNKCTL_CCC},
+    {"ExtSynch", PCI_EXP_LNKCTL_ES},
+    {"ClockPM", PCI_EXP_LNKCTL_CLKREQ_EN},
+    {"AutWidDis", PCI_EXP_LNKCTL_HAWD},
+    {"BWInt", PCI_EXP_LNKCTL_LBMIE},
+    {"ABWMgmt", PCI_EXP_LNKCTL_LABIE},
+    {NULL, 0}
+};
+
+
+static const config_field_t pcie_link_status_fields[] =
+{
+    {"Speed", PCI_EXP_LNKSTA_SPEED},
+    {"Width", PCI_EXP_LNKSTA_WIDTH},
+    {"Train", PCI_EXP_LNKSTA_LT},
+    {"SlotClk", PCI_EXP_LNKSTA_SLC},
+    {"DLActive", PCI_EXP_LNKSTA_DLLLA},
+    {"BWMgmt", PCI_EXP_LNKSTA_LBMS},
+    {"ABWMgmt", PCI_EXP_LNKSTA_LABS},
+    {NULL, 0}
+};
+
+
+static const config_field_t pcie_device_control2_fields[] =
+{
+    {"CompletionTimeout", PCI_EXP_DEVCTL2_COMP_TIMEOUT},
+    {"TimeoutDis", PCI_EXP_DEVCTL2_COMP_TMOUT_DIS},
+    {"ARIFwd", PCI_EXP_DEVCTL2_ARI},
+    {"AtomicOpsReq", PCI_EXP_DEVCTL2_ATOMIC_REQ},
+    {"LTR", PCI_EXP_DEVCTL2_LTR_EN},
+    {NULL, 0}
+};
+
+
+static const config_field_t pcie_link_control2_fields[] =
+{
+    {"TargetSpeed", PCI_EXP_LNKCTL2_TLS},
+    {"EnterCompliance", PCI_EXP_LNKCTL2_ENTER_COMP},
+    {"SpeedDis", PCI_EXP_LNKCTL2_HASD},
+    {NULL, 0}
+};
+
+
+/* The Retrain Link bit isn't restored, as it triggers an action.
+ * The registers from DevCap2 onwards are only present in version 2 or later of the capability. */
+static const config_register_t pcie_registers[] =
+{
+    {"Flags", PCI_EXP_FLAGS, 2, 0, NULL},
+    {"DevCap", PCI_EXP_DEVCAP, 4, 0, NULL},
+    {"DevCtl", PCI_EXP_DEVCTL, 2, 0xffff & ~PCI_EXP_DEVCTL_BCR_FLR, pcie_device_control_fields},
+    {"DevSta", PCI_EXP_DEVSTA, 2, 0, pcie_device_status_fields},
+    {"LnkCap", PCI_EXP_LNKCAP, 4, 0, pcie_link_capabilities_fields},
+    {"LnkCtl", PCI_EXP_LNKCTL, 2, 0xffff & ~PCI_EXP_LNKCTL_RL, pcie_link_control_fields},
+    {"LnkSta", PCI_EXP_LNKSTA, 2, 0, pcie_link_status_fields},
+    {"SltCap", PCI_EXP_SLTCAP, 4, 0, NULL},
+    {"SltCtl", PCI_EXP_SLTCTL, 2, 0xffff, NULL},
+    {"SltSta", PCI_EXP_SLTSTA, 2, 0, NULL},
+    {"RootCtl", PCI_EXP_RTCTL, 2, 0xffff, NULL},
+    {"RootCap", PCI_EXP_RTCAP, 2, 0, NULL},
+    {"RootSta", PCI_EXP_RTSTA, 4, 0, NULL},
+    {"DevCap2", PCI_EXP_DEVCAP2, 4, 0, NULL},
+    {"DevCtl2", PCI_EXP_DEVCTL2, 2, 0xffff, pcie_device_control2_fields},
+    {"DevSta2", PCI_EXP_DEVSTA2, 2, 0, NULL},
+    {"LnkCap2", PCI_EXP_LNKCAP2, 4, 0, NULL},
+    {"LnkCtl2", PCI_EXP_LNKCTL2, 2, 0xffff, pcie_link_control2_fields},
+    {"LnkSta2", PCI_EXP_LNKSTA2, 2, 0, NULL}
+};
+
+
+/* Only the ECRC generation and check enables in the capabilities and control register are restored */
+static const config_register_t aer_registers[] =
+{
+    {"Header", 0, 4, 0, NULL},
+    {"UESta", PCI_ERR_UNCOR_STATUS, 4, 0, NULL},
+    {"UEMsk", PCI_ERR_UNCOR_MASK, 4, 0xffffffff, NULL},
+    {"UESvrt", PCI_ERR_UNCOR_SEVER, 4, 0xffffffff, NULL},
+    {"CESta", PCI_ERR_COR_STATUS, 4, 0, NULL},
+    {"CEMsk", PCI_ERR_COR_MASK, 4, 0xffffffff, NULL},
+    {"AERCap", PCI_ERR_CAP, 4, PCI_ERR_CAP_ECRC_GENE | PCI_ERR_CAP_ECRC_CHKE, NULL},
+    {"HeaderLog0", PCI_ERR_HEADER_LOG + 0x0, 4, 0, NULL},
+    {"HeaderLog1", PCI_ERR_HEADER_LOG + 0x4, 4, 0, NULL},
+    {"HeaderLog2", PCI_ERR_HEADER_LOG + 0x8, 4, 0, NULL},
+    {"HeaderLog3", PCI_ERR_HEADER_LOG + 0xc, 4, 0, NULL}
+};
+
+
+static const config_register_t dsn_registers[] =
+{
+    {"Header", 0, 4, 0, NULL},
+    {"SerialLow", 4, 4, 0, NULL},
+    {"SerialHigh", 8, 4, 0, NULL}
+};
+
+
+/* The capabilities which are decoded */
+static const capability_decode_t capability_decodes[] =
+{
+    {"Power Management", false, PCI_CAP_ID_PM, NELEMENTS (pm_registers), pm_registers},
+    {"PCI Express", false, PCI_CAP_ID_EXP, NELEMENTS (pcie_registers), pcie_registers},
+    {"Advanced Error Reporting", true, PCI_EXT_CAP_ID_ERR, NELEMENTS (aer_registers), aer_registers},
+    {"Device Serial Number", true, PCI_EXT_CAP_ID_DSN, NELEMENTS (dsn_registers), dsn_registers}
+};
+
+
+/* Command line argument which specifies the PCI location of the device to operate on */
+static bool arg_device_specified;
+static generic_pci_access_filter_t arg_device_filter;
+
+
+/* Command line argument which specifies a file to save a snapshot of the device to */
+static const char *arg_save_pathname;
+
+
+/* Command line argument which specifies a snapshot file to use as the reference for a comparison */
+static const char *arg_reference_pathname;
+
+
+/* Command line argument which specifies a snapshot file to compare against the reference, rather than the device */
+static const char *arg_current_pathname;
+
+
+/* Command line argument which causes the writable fields of the device which differ from the reference to be restored */
+static bool arg_restore;
+
+
+/** The command line options for this program, in the format passed to getopt_long().
+ *  Only long arguments are supported */
+static const struct option command_line_options[] =
+{
+    {"device", required_argument, NULL, 0},
+    {"save", required_argument, NULL, 0},
+    {"reference", required_argument, NULL, 0},
+    {"current", required_argument, NULL, 0},
+    {"restore", no_argument, NULL, 0},
+    {NULL, 0, NULL, 0}
+};
+
+
+/**
+ * @brief Display the usage for this program, and the exit
+ */
+static void display_usage (void)
+{
+    printf ("Usage:\n");
+    printf ("  pci_config_snapshot_<access> <options>\n");
+    printf ("   Snapshot, compare and restore the PCI configuration space of a device\n");
+    printf ("--device <domain>:<bus>:<dev>.<func>\n");
+    printf ("  The PCI location of the device to operate on\n");
+    printf ("--save <pathname>\n");
+    printf ("  Save a snapshot of the configuration space of the device to a file\n");
+    printf ("--reference <pathname>\n");
+    printf ("  Compare the configuration space of the device against a previously saved\n");
+    printf ("  snapshot file. The exit status is failure if any differences are found.\n");
+    printf ("--current <pathname>\n");
+    printf ("  With --reference compare against the snapshot in this file, rather than the\n");
+    printf ("  device\n");
+    printf ("--restore\n");
+    printf ("  With --reference restore the writable fields of the device which differ\n");
+    printf ("  from the reference, and then compare again\n");
+
+    exit (EXIT_FAILURE);
+}
+
+
+/**
+ * @brief Parse the command line arguments, storing the results in global variables
+ * @param[in] argc, argv Arguments passed to main
+ */
+static void parse_command_line_arguments (int argc, char *argv[])
+{
+    int opt_status;
+    char junk;
+
+    do
+    {
+        int option_index = 0;
+
+        opt_status = getopt_long (argc, argv, "", command_line_options, &option_index);
+        if (opt_status == '?')
+        {
+            display_usage ();
+        }
+        else if (opt_status >= 0)
+        {
+            const struct option *const optdef = &command_line_options[option_index];
+
+            if (optdef->flag != NULL)
+            {
+                /* Argument just sets a flag */
+            }
+            else if (strcmp (optdef->name, "device") == 0)
+            {
+                memset (&arg_device_filter, 0, sizeof (arg_device_filter));
+                if (sscanf (optarg, "%x:%" SCNx8 ":%" SCNx8 ".%" SCNx8 "%c",
+                        &arg_device_filter.domain, &arg_device_filter.bus, &arg_device_filter.dev,
+                        &arg_device_filter.func, &junk) != 4)
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+                arg_device_filter.filter_type = GENERIC_PCI_ACCESS_FILTER_LOCATION;
+                arg_device_specified = true;
+            }
+            else if (strcmp (optdef->name, "save") == 0)
+            {
+                arg_save_pathname = optarg;
+            }
+            else if (strcmp (optdef->name, "reference") == 0)
+            {
+                arg_reference_pathname = optarg;
+            }
+            else if (strcmp (optdef->name, "current") == 0)
+            {
+                arg_current_pathname = optarg;
+            }
+            else if (strcmp (optdef->name, "restore") == 0)
+            {
+                arg_restore = true;
+            }
+            else
+            {
+                /* This is a program error, and shouldn't be triggered by the command line options */
+                fprintf (stderr, "Unexpected argument definition %s\n", optdef->name);
+                exit (EXIT_FAILURE);
+            }
+        }
+    } while (opt_status != -1);
+
+    /* Check for a valid combination of arguments */
+    if ((arg_save_pathname == NULL) && (arg_reference_pathname == NULL))
+    {
+        printf ("Either --save or --reference must be specified\n");
+        exit (EXIT_FAILURE);
+    }
+    if (((arg_save_pathname != NULL) || (arg_current_pathname == NULL)) && !arg_device_specified)
+    {
+        printf ("--device must be specified to operate on a device\n");
+        exit (EXIT_FAILURE);
+    }
+    if ((arg_current_pathname != NULL) && (arg_reference_pathname == NULL))
+    {
+        printf ("--current requires --reference\n");
+        exit (EXIT_FAILURE);
+    }
+    if (arg_restore && ((arg_reference_pathname == NULL) || (arg_current_pathname != NULL)))
+    {
+        printf ("--restore requires --reference to compare against the device\n");
+        exit (EXIT_FAILURE);
+    }
+}
+
+
+/**
+ * @brief Capture a snapshot of the configuration space of a device
+ * @details The extended configuration space is only read if the first extended capability header can be read and isn't
+ *          all ones, to avoid reads of the extended configuration space of a device which doesn't have one.
+ * @param[in/out] device The device to capture the snapshot for
+ * @param[out] snapshot The captured snapshot
+ * @return Returns true if the start of the configuration space could be read
+ */
+static bool capture_snapshot (generic_pci_access_device_p const device, pci_config_snapshot_t *const snapshot)
+{
+    uint32_t offset;
+
+    memset (snapshot, 0, sizeof (*snapshot));
+    memcpy (snapshot->magic, SNAPSHOT_MAGIC, sizeof (snapshot->magic));
+    snapshot->format_version = SNAPSHOT_FORMAT_VERSION;
+    snapshot->capture_time = (int64_t) time (NULL);
+    if (!generic_pci_access_uint_property (device, GENERIC_PCI_ACCESS_DOMAIN, &snapshot->domain) ||
+        !generic_pci_access_uint_property (device, GENERIC_PCI_ACCESS_BUS, &snapshot->bus) ||
+        !generic_pci_access_uint_property (device, GENERIC_PCI_ACCESS_DEV, &snapshot->dev) ||
+        !generic_pci_access_uint_property (device, GENERIC_PCI_ACCESS_FUNC, &snapshot->func))
+    {
+        return false;
+    }
+
+    for (offset = 0; offset < PCI_CFG_SPACE_SIZE; offset += sizeof (uint32_t))
+    {
+        snapshot->dword_valid[offset / sizeof (uint32_t)] =
+                generic_pci_access_cfg_read_u32 (device, offset, &snapshot->dwords[offset / sizeof (uint32_t)]);
+    }
+
+    uint32_t header;
+    if (generic_pci_access_cfg_read_u32 (device, PCI_CFG_SPACE_SIZE, &header) && (header != 0xffffffff))
+    {
+        for (offset = PCI_CFG_SPACE_SIZE; offset < PCI_CFG_SPACE_EXP_SIZE; offset += sizeof (uint32_t))
+        {
+            snapshot->dword_valid[offset / sizeof (uint32_t)] =
+                    generic_pci_access_cfg_read_u32 (device, offset, &snapshot->dwords[offset / sizeof (uint32_t)]);
+        }
+    }
+
+    return snapshot->dword_valid[0];
+}
+
+
+/**
+ * @brief Save a snapshot to a file
+ * @param[in] pathname The file to save the snapshot to
+ * @param[in] snapshot The snapshot to save
+ */
+static void save_snapshot (const char *const pathname, const pci_config_snapshot_t *const snapshot)
+{
+    FILE *const snapshot_file = fopen (pathname, "wb");
+
+    if (snapshot_file == NULL)
+    {
+        printf ("Failed to create %s\n", pathname);
+        exit (EXIT_FAILURE);
+    }
+
+    if ((fwrite (snapshot, sizeof (*snapshot), 1, snapshot_file) != 1) || (fclose (snapshot_file) != 0))
+    {
+        printf ("Failed to write %s\n", pathname);
+        exit (EXIT_FAILURE);
+    }
+}
+
+
+/**
+ * @brief Load a snapshot from a file, checking that the file is in the expected format
+ * @param[in] pathname The file to load the snapshot from
+ * @param[out] snapshot The loaded snapshot
+ */
+static void load_snapshot (const char *const pathname, pci_config_snapshot_t *const snapshot)
+{
+    FILE *const snapshot_file = fopen (pathname, "rb");
+    char junk;
+
+    if (snapshot_file == NULL)
+    {
+        printf ("Failed to open %s\n", pathname);
+        exit (EXIT_FAILURE);
+    }
+
+    if ((fread (snapshot, sizeof (*snapshot), 1, snapshot_file) != 1) ||
+        (fread (&junk, sizeof (junk), 1, snapshot_file) != 0))
+    {
+        printf ("%s is not the size of a snapshot file\n", pathname);
+        exit (EXIT_FAILURE);
+    }
+    (void) fclose (snapshot_file);
+
+    if ((memcmp (snapshot->magic, SNAPSHOT_MAGIC, sizeof (snapshot->magic)) != 0) ||
+        (snapshot->format_version != SNAPSHOT_FORMAT_VERSION))
+    {
+        printf ("%s is not a snapshot file of a supported version\n", pathname);
+        exit (EXIT_FAILURE);
+    }
+}
+
+
+/**
+ * @brief Get the value of a register from a snapshot
+ * @param[in] snapshot The snapshot to get the register value from
+ * @param[in] offset The offset of the register, which must be naturally aligned for the size
+ * @param[in] size The size of the register in bytes
+ * @param[out] value The register value
+ * @return Returns true if the register value was captured in the snapshot
+ */
+static bool get_snapshot_register (const pci_config_snapshot_t *const snapshot, const uint32_t offset, const uint32_t size,
+                                   uint32_t *const value)
+{
+    const uint32_t dword_index = offset / sizeof (uint32_t);
+    const uint32_t shift = (offset % sizeof (uint32_t)) * 8;
+    const uint32_t mask = (size == sizeof (uint32_t)) ? 0xffffffff : ((1u << (size * 8)) - 1);
+
+    if ((dword_index >= SNAPSHOT_NUM_DWORDS) || !snapshot->dword_valid[dword_index])
+    {
+        return false;
+    }
+
+    *value = (snapshot->dwords[dword_index] >> shift) & mask;
+    return true;
+}
+
+
+/**
+ * @brief Find the offset of a capability in a snapshot
+ * @details been_hear[] used as protection against infinite loops due to malformed capability lists
+ * @param[in] snapshot The snapshot to search
+ * @param[in] decode Which capability to search for
+ * @param[out] capability_offset The offset of the capability in the snapshot
+ * @return Returns true if the capability was found
+ */
+static bool find_snapshot_capability (const pci_config_snapshot_t *const snapshot, const capability_decode_t *const decode,
+                                      uint32_t *const capability_offset)
+{
+    bool been_hear[PCI_CFG_SPACE_EXP_SIZE] = {false};
+    uint32_t status;
+    uint32_t offset;
+    uint32_t value;
+
+    if (decode->extended)
+    {
+        offset = PCI_CFG_SPACE_SIZE;
+        while ((offset >= PCI_CFG_SPACE_SIZE) && (offset < PCI_CFG_SPACE_EXP_SIZE) && !been_hear[offset] &&
+               get_snapshot_register (snapshot, offset, sizeof (uint32_t), &value) &&
+               (value != 0) && (value != 0xffffffff))
+        {
+            if (PCI_EXT_CAP_ID (value) == decode->id)
+            {
+                *capability_offset = offset;
+                return true;
+            }
+            been_hear[offset] = true;
+            offset = PCI_EXT_CAP_NEXT (value);
+        }
+    }
+    else if (get_snapshot_register (snapshot, PCI_STATUS, 2, &status) && ((status & PCI_STATUS_CAP_LIST) != 0) &&
+             get_snapshot_register (snapshot, PCI_CAPABILITY_LIST, 1, &offset))
+    {
+        while ((offset != 0) && (offset < PCI_CFG_SPACE_SIZE) && !been_hear[offset] &&
+               get_snapshot_register (snapshot, offset + PCI_CAP_LIST_ID, 1, &value))
+        {
+            if (value == decode->id)
+            {
+                *capability_offset = offset;
+                return true;
+            }
+            been_hear[offset] = true;
+            if (!get_snapshot_register (snapshot, offset + PCI_CAP_LIST_NEXT, 1, &offset))
+            {
+                offset = 0;
+            }
+        }
+    }
+
+    return false;
+}
+
+
+/**
+ * @brief Add the registers from a register definition table to the list of registers to compare
+ * @param[in] region_name The name of the header or capability containing the registers
+ * @param[in] num_registers The number of registers in the definition table
+ * @param[in] registers The definition table
+ * @param[in] reference_base The offset of the header or capability in the reference snapshot
+ * @param[in] current_base The offset of the header or capability in the current snapshot
+ * @param[in/out] instances The list of registers to compare
+ * @param[in/out] num_instances The number of registers in the list
+ */
+static void add_register_instances (const char *const region_name,
+                                    const size_t num_registers, const config_register_t registers[const num_registers],
+                                    const uint32_t reference_base, const uint32_t current_base,
+                                    register_instance_t instances[const MAX_REGISTER_INSTANCES],
+                                    uint32_t *const num_instances)
+{
+    for (size_t register_index = 0; (register_index < num_registers) && (*num_instances < MAX_REGISTER_INSTANCES);
+            register_index++)
+    {
+        register_instance_t *const instance = &instances[*num_instances];
+
+        instance->region_name = region_name;
+        instance->reg = &registers[register_index];
+        instance->reference_offset = reference_base + registers[register_index].offset;
+        instance->current_offset = current_base + registers[register_index].offset;
+        (*num_instances)++;
+    }
+}
+
+
+/**
+ * @brief Get the number of registers to decode for a capability present in both a reference and current snapshot
+ * @details For the PCI Express capability the registers from DevCap2 onwards are only decoded when the capability
+ *          version is at least 2 in both snapshots, since version 1 of the capability doesn't implement them.
+ * @param[in] decode Which capability to get the number of registers for
+ * @param[in] reference The reference snapshot
+ * @param[in] reference_offset The offset of the capability in the reference snapshot
+ * @param[in] current The current snapshot
+ * @param[in] current_offset The offset of the capability in the current snapshot
+ * @return The number of registers from the start of the decode table which are decoded
+ */
+static size_t get_capability_num_registers (const capability_decode_t *const decode,
+                                            const pci_config_snapshot_t *const reference, const uint32_t reference_offset,
+                                            const pci_config_snapshot_t *const current, const uint32_t current_offset)
+{
+    size_t num_registers = decode->num_registers;
+    uint32_t reference_flags;
+    uint32_t current_flags;
+
+    if (!decode->extended && (decode->id == PCI_CAP_ID_EXP))
+    {
+        const bool version_2 =
+                get_snapshot_register (reference, reference_offset + PCI_EXP_FLAGS, 2, &reference_flags) &&
+                get_snapshot_register (current, current_offset + PCI_EXP_FLAGS, 2, &current_flags) &&
+                ((reference_flags & PCI_EXP_FLAGS_VERS) >= 2) && ((current_flags & PCI_EXP_FLAGS_VERS) >= 2);
+
+        if (!version_2)
+        {
+            num_registers = 0;
+            while ((num_registers < decode->num_registers) && (decode->registers[num_registers].offset < PCI_EXP_DEVCAP2))
+            {
+                num_registers++;
+            }
+        }
+    }
+
+    return num_registers;
+}
+
+
+/**
+ * @brief Get the list of decoded registers to compare between a reference and current snapshot
+ * @details The header registers are selected by the header type of the reference snapshot.
+ *          The capability registers are only compared for capabilities present in both snapshots.
+ * @param[in] reference The reference snapshot
+ * @param[in] current The current snapshot
+ * @param[in] report_capability_differences When true report capabilities which have moved or are only present in one
+ *                                          snapshot
+ * @param[out] instances The list of registers to compare
+ * @param[out] num_differences Incremented for each capability difference reported
+ * @return The number of registers in the list
+ */
+static uint32_t get_register_instances (const pci_config_snapshot_t *const reference,
+                                        const pci_config_snapshot_t *const current,
+                                        const bool report_capability_differences,
+                                        register_instance_t instances[const MAX_REGISTER_INSTANCES],
+                                        uint32_t *const num_differences)
+{
+    uint32_t num_instances = 0;
+    uint32_t header_type = PCI_HEADER_TYPE_NORMAL;
+
+    add_register_instances ("Header", NELEMENTS (common_header_registers), common_header_registers, 0, 0,
+            instances, &num_instances);
+    (void) get_snapshot_register (reference, PCI_HEADER_TYPE, 1, &header_type);
+    switch (header_type & 0x7f)
+    {
+    case PCI_HEADER_TYPE_NORMAL:
+        add_register_instances ("Header", NELEMENTS (normal_header_registers), normal_header_registers, 0, 0,
+                instances, &num_instances);
+        break;
+
+    case PCI_HEADER_TYPE_BRIDGE:
+        add_register_instances ("Header", NELEMENTS (bridge_header_registers), bridge_header_registers, 0, 0,
+                instances, &num_instances);
+        break;
+
+    default:
+        /* Other header types only have the common registers decoded */
+        break;
+    }
+
+    for (size_t decode_index = 0; decode_index < NELEMENTS (capability_decodes); decode_index++)
+    {
+        const capability_decode_t *const decode = &capability_decodes[decode_index];
+        uint32_t reference_offset;
+        uint32_t current_offset;
+        const bool in_reference = find_snapshot_capability (reference, decode, &reference_offset);
+        const bool in_current = find_snapshot_capability (current, decode, &current_offset);
+
+        if (in_reference && in_current)
+        {
+            if (report_capability_differences && (reference_offset != current_offset))
+            {
+                printf ("  %s capability moved from 0x%03x -> 0x%03x\n", decode->name, reference_offset, current_offset);
+                (*num_differences)++;
+            }
+            add_register_instances (decode->name,
+                    get_capability_num_registers (decode, reference, reference_offset, current, current_offset),
+                    decode->registers, reference_offset, current_offset, instances, &num_instances);
+        }
+        else if (report_capability_differences && (in_reference != in_current))
+        {
+            printf ("  %s capability only present in the %s\n", decode->name, in_reference ? "reference" : "current");
+            (*num_differences)++;
+        }
+    }
+
+    return num_instances;
+}
+
+
+/**
+ * @brief Display the fields which differ in a register
+ * @details Single bit fields are displayed with a +/- suffix as used by lspci, and multiple bit fields as values.
+ * @param[in] fields The fields of the register
+ * @param[in] reference_value The register value in the reference snapshot
+ * @param[in] current_value The register value in the current snapshot
+ */
+static void display_field_differences (const config_field_t *const fields,
+                                       const uint32_t reference_value, const uint32_t current_value)
+{
+    for (const config_field_t *field = fields; field->name != NULL; field++)
+    {
+        const uint32_t reference_field = vfio_extract_field_u32 (reference_value, field->mask);
+        const uint32_t current_field = vfio_extract_field_u32 (current_value, field->mask);
+
+        if (reference_field != current_field)
+        {
+            if ((field->mask & (field->mask - 1)) == 0)
+            {
+                printf (" %s%s->%s", field->name, reference_field ? "+" : "-", current_field ? "+" : "-");
+            }
+            else
+            {
+                printf (" %s %u->%u", field->name, reference_field, current_field);
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief Compare two snapshots, displaying the differences
+ * @param[in] reference The reference snapshot
+ * @param[in] current The current snapshot
+ * @return The number of differences found
+ */
+static uint32_t compare_snapshots (const pci_config_snapshot_t *const reference, const pci_config_snapshot_t *const current)
+{
+    static register_instance_t instances[MAX_REGISTER_INSTANCES];
+    bool reference_decoded[PCI_CFG_SPACE_EXP_SIZE] = {false};
+    bool current_decoded[PCI_CFG_SPACE_EXP_SIZE] = {false};
+    uint32_t num_differences = 0;
+    uint32_t num_uncaptured_dwords = 0;
+    uint32_t reference_value;
+    uint32_t current_value;
+
+    const uint32_t num_instances = get_register_instances (reference, current, true, instances, &num_differences);
+
+    /* Compare the decoded registers */
+    for (uint32_t instance_index = 0; instance_index < num_instances; instance_index++)
+    {
+        const register_instance_t *const instance = &instances[instance_index];
+        const config_register_t *const reg = instance->reg;
+
+        if (get_snapshot_register (reference, instance->reference_offset, reg->size, &reference_value) &&
+            get_snapshot_register (current, instance->current_offset, reg->size, &current_value))
+        {
+            for (uint32_t byte_index = 0; byte_index < reg->size; byte_index++)
+            {
+                reference_decoded[instance->reference_offset + byte_index] = true;
+                current_decoded[instance->current_offset + byte_index] = true;
+            }
+
+            if (reference_value != current_value)
+            {
+                printf ("  %s %s [0x%03x]: 0x%0*x -> 0x%0*x", instance->region_name, reg->name,
+                        instance->current_offset, reg->size * 2, reference_value, reg->size * 2, current_value);
+                if (reg->fields != NULL)
+                {
+                    display_field_differences (reg->fields, reference_value, current_value);
+                }
+                printf ("\n");
+                num_differences++;
+            }
+        }
+    }
+
+    /* Compare the remaining bytes, which aren't part of a decoded register, as raw dwords.
+     * Only the bytes which aren't decoded in either snapshot are compared, to avoid reporting the same difference twice
+     * when the position of a capability has changed. */
+    for (uint32_t dword_index = 0; dword_index < SNAPSHOT_NUM_DWORDS; dword_index++)
+    {
+        if (reference->dword_valid[dword_index] && current->dword_valid[dword_index])
+        {
+            uint32_t undecoded_mask = 0;
+
+            for (uint32_t byte_index = 0; byte_index < sizeof (uint32_t); byte_index++)
+            {
+                const uint32_t offset = (uint32_t) (dword_index * sizeof (uint32_t)) + byte_index;
+
+                if (!reference_decoded[offset] && !current_decoded[offset])
+                {
+                    undecoded_mask |= 0xffu << (byte_index * 8);
+                }
+            }
+
+            if (((reference->dwords[dword_index] ^ current->dwords[dword_index]) & undecoded_mask) != 0)
+            {
+                printf ("  [0x%03zx]: 0x%08x -> 0x%08x\n", dword_index * sizeof (uint32_t),
+                        reference->dwords[dword_index], current->dwords[dword_index]);
+                num_differences++;
+            }
+        }
+        else if (reference->dword_valid[dword_index] != current->dword_valid[dword_index])
+        {
+            num_uncaptured_dwords++;
+        }
+    }
+
+    if (num_uncaptured_dwords > 0)
+    {
+        printf ("  %u dwords only captured in one snapshot, which were not compared\n", num_uncaptured_dwords);
+    }
+    printf ("%u differences\n", num_differences);
+
+    return num_differences;
+}
+
+
+/**
+ * @brief Write one register of a device, to restore the restorable bits from the reference snapshot
+ * @param[in/out] device The device to restore
+ * @param[in] instance The register to restore
+ * @param[in] reference The reference snapshot, containing the values to restore
+ * @param[in] current The current snapshot of the device
+ * @return Returns true if the register was written
+ */
+static bool restore_register (generic_pci_access_device_p const device, const register_instance_t *const instance,
+                              const pci_config_snapshot_t *const reference, const pci_config_snapshot_t *const current)
+{
+    const config_register_t *const reg = instance->reg;
+    uint32_t reference_value;
+    uint32_t current_value;
+    bool written = false;
+    bool success = true;
+
+    if ((reg->restore_mask != 0) &&
+        get_snapshot_register (reference, instance->reference_offset, reg->size, &reference_value) &&
+        get_snapshot_register (current, instance->current_offset, reg->size, &current_value) &&
+        (((reference_value ^ current_value) & reg->restore_mask) != 0))
+    {
+        const uint32_t new_value = (current_value & ~reg->restore_mask) | (reference_value & reg->restore_mask);
+
+        switch (reg->size)
+        {
+        case 1:
+            success = generic_pci_access_cfg_write_u8 (device, instance->current_offset, (uint8_t) new_value);
+            break;
+
+        case 2:
+            success = generic_pci_access_cfg_write_u16 (device, instance->current_offset, (uint16_t) new_value);
+            break;
+
+        default:
+            success = generic_pci_access_cfg_write_u32 (device, instance->current_offset, new_value);
+            break;
+        }
+
+        printf ("  Restore %s %s [0x%03x]: 0x%0*x -> 0x%0*x%s\n", instance->region_name, reg->name,
+                instance->current_offset, reg->size * 2, current_value, reg->size * 2, new_value,
+                success ? "" : " FAILED");
+        written = success;
+    }
+
+    return written;
+}
+
+
+/**
+ * @brief Restore the restorable registers of a device which differ from the reference snapshot
+ * @details The registers are restored in the same order as the Linux kernel pci_restore_state():
+ *          a. The power management control/status register first. A transition from D3hot to D0 on a device which
+ *             doesn't advertise No_Soft_Reset resets the configuration registers, which would undo any registers
+ *             already restored. After the power state has been changed the current snapshot is re-captured, so the
+ *             remaining registers are compared against the state of the device following the transition.
+ *          b. All other registers, apart from the command register.
+ *          c. The command register last.
+ * @param[in/out] device The device to restore
+ * @param[in] reference The reference snapshot, containing the values to restore
+ * @param[in/out] current The current snapshot of the device. Re-captured if the power state was restored.
+ * @return The number of registers written
+ */
+static uint32_t restore_device (generic_pci_access_device_p const device,
+                                const pci_config_snapshot_t *const reference, pci_config_snapshot_t *const current)
+{
+    static register_instance_t instances[MAX_REGISTER_INSTANCES];
+    uint32_t num_differences = 0;
+    uint32_t num_written = 0;
+    bool power_state_written = false;
+
+    /* The PCIe spec requires a 10 ms recovery time after a transition from D3hot to D0 before accessing the device */
+    const struct timespec power_state_recovery_time =
+    {
+        .tv_sec = 0,
+        .tv_nsec = 10000000
+    };
+
+    const uint32_t num_instances = get_register_instances (reference, current, false, instances, &num_differences);
+    for (uint32_t pass = 0; pass < 3; pass++)
+    {
+        if (power_state_written)
+        {
+            nanosleep (&power_state_recovery_time, NULL);
+            if (!capture_snapshot (device, current))
+            {
+                printf ("Failed to read the configuration space of the device\n");
+                exit (EXIT_FAILURE);
+            }
+            power_state_written = false;
+        }
+
+        for (uint32_t instance_index = 0; instance_index < num_instances; instance_index++)
+        {
+            const register_instance_t *const instance = &instances[instance_index];
+            const bool is_pmcsr = instance->reg->fields == pm_control_status_fields;
+            const bool is_command = instance->reg->fields == command_fields;
+            const uint32_t register_pass = is_pmcsr ? 0 : (is_command ? 2 : 1);
+
+            if (register_pass == pass)
+            {
+                if (restore_register (device, instance, reference, current))
+                {
+                    num_written++;
+                    power_state_written = is_pmcsr;
+                }
+            }
+        }
+    }
+    printf ("%u registers restored\n", num_written);
+
+    return num_written;
+}
+
+
+int main (int argc, char *argv[])
+{
+    static pci_config_snapshot_t reference;
+    static pci_config_snapshot_t current;
+    generic_pci_access_context_p access_context = NULL;
+    generic_pci_access_iterator_p device_iterator = NULL;
+    generic_pci_access_device_p device = NULL;
+    int exit_status = EXIT_SUCCESS;
+
+    parse_command_line_arguments (argc, argv);
+
+    if (arg_device_specified)
+    {
+        access_context = generic_pci_access_initialise ();
+        device_iterator = generic_pci_access_iterator_create (access_context, &arg_device_filter);
+        device = generic_pci_access_iterator_next (device_iterator);
+        if (device == NULL)
+        {
+            printf ("Failed to open device at location %04x:%02x:%02x.%x\n", arg_device_filter.domain,
+                    arg_device_filter.bus, arg_device_filter.dev, arg_device_filter.func);
+            exit (EXIT_FAILURE);
+        }
+    }
+
+    /* Capture the current configuration space of the device, or load the current snapshot file */
+    if (arg_current_pathname != NULL)
+    {
+        load_snapshot (arg_current_pathname, &current);
+    }
+    else if (!capture_snapshot (device, &current))
+    {
+        printf ("Failed to read the configuration space of the device\n");
+        exit (EXIT_FAILURE);
+    }
+
+    if (arg_save_pathname != NULL)
+    {
+        save_snapshot (arg_save_pathname, &current);
+        printf ("Saved snapshot of %04x:%02x:%02x.%x to %s\n",
+                current.domain, current.bus, current.dev, current.func, arg_save_pathname);
+    }
+
+    if (arg_reference_pathname != NULL)
+    {
+        load_snapshot (arg_reference_pathname, &reference);
+        if ((reference.domain != current.domain) || (reference.bus != current.bus) ||
+            (reference.dev != current.dev) || (reference.func != current.func))
+        {
+            printf ("Warning: comparing snapshots of different devices %04x:%02x:%02x.%x and %04x:%02x:%02x.%x\n",
+                    reference.domain, reference.bus, reference.dev, reference.func,
+                    current.domain, current.bus, current.dev, current.func);
+        }
+
+        printf ("Comparing reference snapshot %s against %s\n", arg_reference_pathname,
+                (arg_current_pathname != NULL) ? arg_current_pathname : "device");
+        uint32_t num_differences = compare_snapshots (&reference, &current);
+
+        if (arg_restore && (num_differences > 0) && (restore_device (device, &reference, &current) > 0))
+        {
+            printf ("Comparing reference snapshot %s against device after restore\n", arg_reference_pathname);
+            if (!capture_snapshot (device, &current))
+            {
+                printf ("Failed to read the configuration space of the device\n");
+                exit (EXIT_FAILURE);
+            }
+            num_differences = compare_snapshots (&reference, &current);
+        }
+
+        if (num_differences > 0)
+        {
+            exit_status = EXIT_FAILURE;
+        }
+    }
+
+    if (access_context != NULL)
+    {
+        generic_pci_access_iterator_destroy (device_iterator);
+        generic_pci_access_finalise (access_context);
+    }
+
+    return exit_status;
+}
@@ -0,0 +1,226 @@
+/*
+ * @file pcie_exp_cap_access.c
+ * @date 18 Oct 2026
+ * @author Chester Gillon
+ * @brief Implements access to the PCIe express capability configuration registers of a device,
+ *        including changing the target link speed and retraining the link.
+ * @details Originally part of pcie_set_speed.c, moved to be shared with other programs which change the link speed.
+ */
+
+#include "pcie_exp_cap_access.h"
+#include "pcie_extended_capability.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+
+#include <pci/pci.h>
+#include <linux/pci_regs.h> /* For PCI_EXP_LNKCTL2_TLS */
+
+
+/**
+ * @brief Read a PCIe capability configuration register for a device
+ * @details Only attempts the read if the overall status is currently successful.
+ *          Reports a diagnostic error on the first failure, including the errno from the underlying configuration read.
+ * @param[in/out] access The access mechanism, updated if the read fails.
+ * @param[in] offset The offset into the PCIe express capability configuration registers to read
+ * @param[out] value The configuration register value read.
+ */
+void exp_cap_read_u16 (exp_cap_access_t *const access, const uint32_t offset, uint16_t *const value)
+{
+    if (access->success)
+    {
+        errno = 0;
+        if (!generic_pci_access_cfg_read_u16 (access->device, access->capability_pointer + offset, value))
+        {
+            printf ("PCIe capability U16 read for register 0x%x failed : %s\n", offset, strerror (errno));
+            access->success = false;
+        }
+    }
+}
+
+void exp_cap_read_u32 (exp_cap_access_t *const access, const uint32_t offset, uint32_t *const value)
+{
+    if (access->success)
+    {
+        errno = 0;
+        if (!generic_pci_access_cfg_read_u32 (access->device, access->capability_pointer + offset, value))
+        {
+            printf ("PCIe capability U32 read for register 0x%x failed : %s\n", offset, strerror (errno));
+            access->success = false;
+        }
+    }
+}
+
+
+/**
+ * @brief Write a PCIe capability configuration register for a device
+ * @details Only attempts the write if the overall status is currently successful.
+ *          Reports a diagnostic error on the first failure, including the errno from the underlying configuration write.
+ * @param[in/out] access The access mechanism, updated if the write fails.
+ * @param[in] offset The offset into the PCIe express capability configuration registers to write
+ * @param[in] value The configuration register value to write
+ */
+void exp_cap_write_u16 (exp_cap_access_t *const access, const uint32_t offset, const uint16_t value)
+{
+    if (access->success)
+    {
+        errno = 0;
+        if (!generic_pci_access_cfg_write_u16 (access->device, access->capability_pointer + offset, value))
+        {
+            printf ("PCIe capability U16 write for register 0x%x failed : %s\n", offset, strerror (errno));
+            access->success = false;
+        }
+    }
+}
+
+
+/**
+ * @brief Obtain the PCIe capability pointer for a device, to be able to access the PCIe express capability configuration registers.
+ * @details A device without the PCIe capability, e.g. a conventional PCI device, isn't reported as an error since
+ *          the caller decides if that is an error.
+ * @param[out] access The initialised access mechanism. success is false if the device doesn't have the PCIe capability.
+ * @param[in/out] device The device to obtain the capability pointer for
+ * @return Returns true if the PCIe capability pointer was obtained.
+ */
+bool obtain_pcie_capability_pointer (exp_cap_access_t *const access, generic_pci_access_device_p const device)
+{
+    bool found_capability_pointer = false;
+    uint16_t status_register;
+    bool been_hear[256] = {false};
+    uint8_t capability_id;
+
+    errno = 0;
+    access->device = device;
+    access->success = generic_pci_access_cfg_read_u16 (access->device, PCI_STATUS, &status_register);
+
+    /* Check for presence of PCI capabilities */
+    if (access->success && (status_register & PCI_STATUS_CAP_LIST) != 0)
+    {
+        /* Iterate over all capabilities, looking for the PCIe capability.
+         * been_hear[] used as protection against infinite loops due to malformed capability lists */
+        access->success = generic_pci_access_cfg_read_u8 (access->device, PCI_CAPABILITY_LIST, &access->capability_pointer);
+        while (access->success && (!found_capability_pointer) &&
+               (access->capability_pointer != 0) && (!been_hear[access->capability_pointer]))
+        {
+            access->success = generic_pci_access_cfg_read_u8 (device, (access->capability_pointer) + PCI_CAP_LIST_ID, &capability_id);
+
+            if (access->success)
+            {
+                if (capability_id == PCI_CAP_ID_EXP)
+                {
+                    found_capability_pointer = true;
+                }
+                else
+                {
+                    /* Advance to next capability */
+                    been_hear[access->capability_pointer] = true;
+                    access->success = generic_pci_access_cfg_read_u8 (device, (access->capability_pointer) + PCI_CAP_LIST_NEXT,
+                            &access->capability_pointer);
+                }
+            }
+        }
+    }
+
+    if (!access->success)
+    {
+        printf ("Failed to read capability pointer : %s\n", strerror (errno));
+    }
+    else if (!found_capability_pointer)
+    {
+        access->success = false;
+    }
+
+    return access->success;
+}
+
+
+/**
+ * @brief The pcie_config_read_u32_t function used to search the extended capabilities of a device
+ * @param[in/out] device The generic PCI device to read the configuration space of
+ * @param[in] offset The offset of the dword to read
+ * @param[out] value The dword read
+ * @return Returns true if the read was successful
+ */
+static bool exp_cap_extended_capability_read_u32 (void *const device, const uint32_t offset, uint32_t *const value)
+{
+    return generic_pci_access_cfg_read_u32 (device, offset, value);
+}
+
+
+/**
+ * @brief Find a PCIe extended capability for a device
+ * @details The extended capabilities start at offset PCI_CFG_SPACE_SIZE in the PCI configuration space, and are only
+ *          present for PCIe devices. A failure to read the configuration space is treated as the capability not being
+ *          present, rather than setting access->success to false, since not all devices have extended capabilities.
+ * @param[in] access The access mechanism for the device, on which obtain_pcie_capability_pointer() has been called
+ * @param[in] capability_id The PCI_EXT_CAP_ID_* to search for
+ * @param[out] capability_offset The offset in the PCI configuration space of the header of the extended capability
+ * @return Returns true when the extended capability has been found.
+ */
+bool exp_cap_find_extended_capability (exp_cap_access_t *const access, const uint16_t capability_id,
+                                       uint32_t *const capability_offset)
+{
+    return access->success &&
+            pcie_find_extended_capability (exp_cap_extended_capability_read_u32, access->device, capability_id,
+                    capability_offset);
+}
+
+
+/**
+ * @brief Change the target link speed of a downstream port, and retrain the link
+ * @details Writes the target link speed to link control 2, triggers link retraining and then waits for the Link Training
+ *          bit in the link status to clear, or a timeout. Retraining is only supported by downstream ports, so the
+ *          caller is responsible for selecting the parent bridge of an endpoint.
+ *
+ *          A short delay is used before polling for link training to complete, since the Link Training bit may not be
+ *          set immediately after the Retrain Link bit has been written.
+ * @param[in/out] access The access mechanism for the downstream port, updated if a configuration access fails
+ * @param[in] target_link_speed The PCI_EXP_LNKCTL2_TLS value to train the link at
+ * @param[in] timeout_ns How long to wait for link training to complete
+ * @param[out] link_status The link status read once link training has completed
+ * @return Returns true if the link completed training within the timeout, or false if a configuration access failed or
+ *         the link was still training at the timeout.
+ */
+bool exp_cap_retrain_link (exp_cap_access_t *const access, const uint32_t target_link_speed, const int64_t timeout_ns,
+                           uint16_t *const link_status)
+{
+    const struct timespec poll_interval =
+    {
+        .tv_sec = 0,
+        .tv_nsec = 10000000 /* 10 milliseconds */
+    };
+    uint16_t link_control;
+    uint16_t link_control2;
+    bool training_complete = false;
+    int64_t waited_ns = 0;
+
+    *link_status = 0;
+
+    /* Write link control 2 with the new target link speed */
+    exp_cap_read_u16 (access, PCI_EXP_LNKCTL2, &link_control2);
+    link_control2 = (uint16_t) (link_control2 & ~PCI_EXP_LNKCTL2_TLS);
+    link_control2 = (uint16_t) (link_control2 | target_link_speed);
+    exp_cap_write_u16 (access, PCI_EXP_LNKCTL2, link_control2);
+
+    /* Trigger link retraining */
+    exp_cap_read_u16 (access, PCI_EXP_LNKCTL, &link_control);
+    exp_cap_write_u16 (access, PCI_EXP_LNKCTL, link_control | PCI_EXP_LNKCTL_RETRAIN);
+
+    /* Wait for link training to complete */
+    while (access->success && !training_complete && (waited_ns < timeout_ns))
+    {
+        nanosleep (&poll_interval, NULL);
+        waited_ns += poll_interval.tv_nsec;
+        exp_cap_read_u16 (access, PCI_EXP_LNKSTA, link_status);
+        training_complete = access->success && ((*link_status & PCI_EXP_LNKSTA_LT) == 0);
+    }
+
+    if (access->success && !training_complete)
+    {
+        printf ("Link training did not complete within %.3f seconds\n", (double) timeout_ns / 1E9);
+    }
+
+    return training_complete;
+}
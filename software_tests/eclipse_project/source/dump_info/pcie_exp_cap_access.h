@@ -0,0 +1,39 @@
+/*
+ * @file pcie_exp_cap_access.h
+ * @date 18 Oct 2026
+ * @author Chester Gillon
+ * @brief Provides an interface to access the PCIe express capability configuration registers of a device,
+ *        including changing the target link speed and retraining the link.
+ */
+
+#ifndef PCIE_EXP_CAP_ACCESS_H_
+#define PCIE_EXP_CAP_ACCESS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "generic_pci_access.h"
+
+
+/* Structure used to read or write the PCIe express capability configuration registers for a device */
+typedef struct
+{
+    /* Overall success. Set false on the first error attempting to access the configuration registers */
+    bool success;
+    /* The PCIe device for which are accessing the PCIe express capability for */
+    generic_pci_access_device_p device;
+    /* The PCIe capability pointer, used as the offset for the start of the configuration registers */
+    uint8_t capability_pointer;
+} exp_cap_access_t;
+
+
+void exp_cap_read_u16 (exp_cap_access_t *const access, const uint32_t offset, uint16_t *const value);
+void exp_cap_read_u32 (exp_cap_access_t *const access, const uint32_t offset, uint32_t *const value);
+void exp_cap_write_u16 (exp_cap_access_t *const access, const uint32_t offset, const uint16_t value);
+bool obtain_pcie_capability_pointer (exp_cap_access_t *const access, generic_pci_access_device_p const device);
+bool exp_cap_find_extended_capability (exp_cap_access_t *const access, const uint16_t capability_id,
+                                       uint32_t *const capability_offset);
+bool exp_cap_retrain_link (exp_cap_access_t *const access, const uint32_t target_link_speed, const int64_t timeout_ns,
+                           uint16_t *const link_status);
+
+#endif /* PCIE_EXP_CAP_ACCESS_H_ */
@@ -0,0 +1,665 @@
+/*
+ * @file pcie_link_bottleneck_report.c
+ * @date 18 Oct 2026
+ * @author Chester Gillon
+ * @brief Report the PCIe link bottleneck between each identified FPGA design and the root port
+ * @details
+ *  For each identified FPGA design walks from the endpoint up through the parent bridges to the root port, reporting
+ *  the negotiated and capable speed and width of each link. The link with the lowest negotiated bandwidth is the
+ *  bottleneck, from which the theoretical TLP payload throughput is calculated for each direction taking into account:
+ *  a. The link encoding.
+ *  b. The smallest Max_Payload_Size configured for the devices in the path.
+ *  c. The Max_Read_Request_Size configured for the endpoint.
+ *  d. The TLP header, sequence number, LCRC and framing overhead of each TLP.
+ *
+ *  The theoretical throughput is an upper bound as it ignores DLLP traffic for ACKs and flow control updates, and that the
+ *  root complex may return read completions split at the Read Completion Boundary rather than at Max_Payload_Size.
+ *
+ *  For designs with a DMA bridge with DMA accessible memory a short H2C and C2H run is performed to measure the
+ *  throughput, which is compared against the theoretical throughput. Designs with AXI streams aren't measured, since the
+ *  stream connections depend upon the design.
+ *
+ *  The generic PCI access mechanism is used to walk the bridges, which only the pciutils implementation supports.
+ *  Reading the PCIe capabilities with pciutils requires CAP_SYS_ADMIN.
+ */
+
+#include "generic_pci_access.h"
+#include "pcie_exp_cap_access.h"
+#include "vfio_bitops.h"
+#include "identify_pcie_fpga_design.h"
+#include "dma_memory_test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <getopt.h>
+#include <pci/pci.h>
+#include <linux/pci_regs.h>
+
+
+/* The maximum number of links between an endpoint and the root port which are reported */
+#define MAX_PATH_LINKS 16
+
+
+/* The overhead in bytes of each TLP, in addition to the header:
+ * - 2 byte sequence number
+ * - 4 byte LCRC
+ * - 2 bytes for the STP and END framing symbols for 8b/10b encoding, or 2 further bytes of the 4 byte STP token for
+ *   128b/130b encoding (which includes the sequence number). */
+#define TLP_FRAMING_OVERHEAD_BYTES 8
+
+
+/* The TLP header size for:
+ * - The posted memory writes used for C2H transfers, assuming 64-bit addresses.
+ * - The completions with data used to return the data for the memory reads used for H2C transfers. */
+#define MEMORY_WRITE_64_HEADER_BYTES 16
+#define COMPLETION_HEADER_BYTES 12
+
+
+/* Command line argument which specifies the duration of the DMA throughput measurement in each direction */
+static double arg_duration_secs = 1.0;
+
+
+/* Command line argument which specifies the size of each DMA transfer when measuring DMA throughput */
+static size_t arg_chunk_size_bytes = 0x400000;
+
+
+/* Command line argument which specifies the percentage of the theoretical throughput below which the measured throughput
+ * is reported as below expectations */
+static double arg_expected_percent = 80.0;
+
+
+/* Command line argument which skips measuring the DMA throughput, so only the topology is reported */
+static bool arg_skip_dma_measurement;
+
+
+/** The command line options for this program, in the format passed to getopt_long().
+ *  Only long arguments are supported */
+static const struct option command_line_options[] =
+{
+    {"duration_secs", required_argument, NULL, 0},
+    {"chunk_size", required_argument, NULL, 0},
+    {"expected_percent", required_argument, NULL, 0},
+    {"skip_dma_measurement", no_argument, NULL, 0},
+    {NULL, 0, NULL, 0}
+};
+
+
+/* Describes one link in the path between an endpoint and the root port */
+typedef struct
+{
+    /* The device at the downstream end of the link, and the port at the upstream end */
+    char downstream_name[32];
+    char upstream_name[32];
+    /* The negotiated link speed (as a PCI_EXP_LNKSTA_SPEED encoding) and width */
+    uint32_t negotiated_speed;
+    uint32_t negotiated_width;
+    /* The maximum link speed and width supported by both ends of the link.
+     * If the upstream port capabilities can't be read, only the downstream device is considered. */
+    uint32_t capable_speed;
+    uint32_t capable_width;
+    /* The raw bandwidth of the negotiated link, after the encoding overhead */
+    double negotiated_bytes_per_sec;
+} pcie_link_t;
+
+
+/* Describes the path between an endpoint and the root port */
+typedef struct
+{
+    /* The links in the path, starting with the link to the endpoint */
+    uint32_t num_links;
+    pcie_link_t links[MAX_PATH_LINKS];
+    /* Set true when the walk reached the root port. False indicates the configuration of a bridge couldn't be read. */
+    bool reached_root_port;
+    /* The smallest Max_Payload_Size configured for the devices in the path */
+    uint32_t min_max_payload_size;
+    /* The Max_Read_Request_Size configured for the endpoint */
+    uint32_t max_read_request_size;
+    /* Index into links[] for the link with the lowest negotiated bandwidth */
+    uint32_t bottleneck_link_index;
+    /* The theoretical TLP payload throughput through the bottleneck link for each direction */
+    double h2c_theoretical_bytes_per_sec;
+    double c2h_theoretical_bytes_per_sec;
+} pcie_path_t;
+
+
+/* The link speeds in GT/s, indexed by the PCI_EXP_LNKSTA_SPEED and PCI_EXP_LNKCAP_SPEED encodings */
+static const double link_speed_gts[] =
+{
+    [1] = 2.5,
+    [2] = 5.0,
+    [3] = 8.0,
+    [4] = 16.0,
+    [5] = 32.0,
+    [6] = 64.0
+};
+
+
+/**
+ * @brief Display the usage for this program, and the exit
+ */
+static void display_usage (void)
+{
+    printf ("Usage:\n");
+    printf ("  pcie_link_bottleneck_report <options>\n");
+    printf ("   Report the PCIe link bottleneck between each FPGA design and the root port\n");
+    printf ("--duration_secs <seconds>\n");
+    printf ("  The duration of the DMA throughput measurement in each direction. Default %.1f\n", arg_duration_secs);
+    printf ("--chunk_size <size_bytes>\n");
+    printf ("  The size of each DMA transfer when measuring DMA throughput. Minimum 0x%x. Default 0x%zx\n",
+            DMA_MEMORY_TEST_MIN_CHUNK_SIZE_BYTES, arg_chunk_size_bytes);
+    printf ("--expected_percent <percent>\n");
+    printf ("  The percentage of the theoretical throughput below which the measured\n");
+    printf ("  throughput is reported as below expectations. Default %.0f\n", arg_expected_percent);
+    printf ("--skip_dma_measurement\n");
+    printf ("  Only report the topology, without measuring the DMA throughput\n");
+
+    exit (EXIT_FAILURE);
+}
+
+
+/**
+ * @brief Parse the command line arguments, storing the results in global variables
+ * @param[in] argc, argv Arguments passed to main
+ */
+static void parse_command_line_arguments (int argc, char *argv[])
+{
+    int opt_status;
+    char junk;
+
+    do
+    {
+        int option_index = 0;
+
+        opt_status = getopt_long (argc, argv, "", command_line_options, &option_index);
+        if (opt_status == '?')
+        {
+            display_usage ();
+        }
+        else if (opt_status >= 0)
+        {
+            const struct option *const optdef = &command_line_options[option_index];
+
+            if (optdef->flag != NULL)
+            {
+                /* Argument just sets a flag */
+            }
+            else if (strcmp (optdef->name, "duration_secs") == 0)
+            {
+                if ((sscanf (optarg, "%lf%c", &arg_duration_secs, &junk) != 1) || (arg_duration_secs <= 0.0))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else if (strcmp (optdef->name, "chunk_size") == 0)
+            {
+                if ((sscanf (optarg, "%zi%c", &arg_chunk_size_bytes, &junk) != 1) ||
+                    (arg_chunk_size_bytes < DMA_MEMORY_TEST_MIN_CHUNK_SIZE_BYTES) ||
+                    ((arg_chunk_size_bytes % sizeof (uint64_t)) != 0))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else if (strcmp (optdef->name, "expected_percent") == 0)
+            {
+                if ((sscanf (optarg, "%lf%c", &arg_expected_percent, &junk) != 1) ||
+                    (arg_expected_percent <= 0.0) || (arg_expected_percent > 100.0))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else if (strcmp (optdef->name, "skip_dma_measurement") == 0)
+            {
+                arg_skip_dma_measurement = true;
+            }
+            else
+            {
+                /* This is a program error, and shouldn't be triggered by the command line options */
+                fprintf (stderr, "Unexpected argument definition %s\n", optdef->name);
+                exit (EXIT_FAILURE);
+            }
+        }
+    } while (opt_status != -1);
+}
+
+
+/**
+ * @brief Get the location of a device as a text name
+ * @param[in] device The device to get the name for
+ * @param[out] name The name as <domain>:<bus>:<dev>.<func>
+ * @param[in] name_size The size of name
+ */
+static void get_device_name (generic_pci_access_device_p const device, char *const name, const size_t name_size)
+{
+    uint32_t domain;
+    uint32_t bus;
+    uint32_t dev;
+    uint32_t func;
+
+    if (generic_pci_access_uint_property (device, GENERIC_PCI_ACCESS_DOMAIN, &domain) &&
+        generic_pci_access_uint_property (device, GENERIC_PCI_ACCESS_BUS, &bus) &&
+        generic_pci_access_uint_property (device, GENERIC_PCI_ACCESS_DEV, &dev) &&
+        generic_pci_access_uint_property (device, GENERIC_PCI_ACCESS_FUNC, &func))
+    {
+        snprintf (name, name_size, "%04x:%02x:%02x.%x", domain, bus, dev, func);
+    }
+    else
+    {
+        snprintf (name, name_size, "unknown");
+    }
+}
+
+
+/**
+ * @brief Get the speed of a link in GT/s
+ * @param[in] speed The encoded link speed
+ * @return The speed in GT/s, or zero if the encoding isn't known
+ */
+static double get_link_speed_gts (const uint32_t speed)
+{
+    return (speed < VFIO_NELEMENTS (link_speed_gts)) ? link_speed_gts[speed] : 0.0;
+}
+
+
+/**
+ * @brief Get the raw bandwidth of one direction of a link, after the encoding overhead
+ * @details 64 GT/s uses FLIT mode, for which the efficiency of 242/256 accounts for the FLIT CRC and FEC bytes but not
+ *          the different TLP framing.
+ * @param[in] speed The encoded link speed
+ * @param[in] width The number of lanes
+ * @return The bandwidth in bytes per second
+ */
+static double get_link_bytes_per_sec (const uint32_t speed, const uint32_t width)
+{
+    double encoding_efficiency;
+
+    if (speed <= 2)
+    {
+        encoding_efficiency = 8.0 / 10.0;
+    }
+    else if (speed <= 5)
+    {
+        encoding_efficiency = 128.0 / 130.0;
+    }
+    else
+    {
+        encoding_efficiency = 242.0 / 256.0;
+    }
+
+    return (get_link_speed_gts (speed) * 1E9 * width * encoding_efficiency) / 8.0;
+}
+
+
+/**
+ * @brief Get the fraction of the link bandwidth which carries payload data for TLPs of one size
+ * @param[in] payload_bytes The data payload of each TLP
+ * @param[in] header_bytes The header size of each TLP
+ * @return The payload efficiency
+ */
+static double get_tlp_payload_efficiency (const uint32_t payload_bytes, const uint32_t header_bytes)
+{
+    return (double) payload_bytes / (double) (payload_bytes + header_bytes + TLP_FRAMING_OVERHEAD_BYTES);
+}
+
+
+/**
+ * @brief Display a link speed and width
+ * @param[in] speed The encoded link speed
+ * @param[in] width The number of lanes
+ */
+static void display_link_speed_width (const uint32_t speed, const uint32_t width)
+{
+    const double speed_gts = get_link_speed_gts (speed);
+
+    if (speed_gts > 0.0)
+    {
+        printf ("%g GT/s x%u", speed_gts, width);
+    }
+    else
+    {
+        printf ("Unknown speed encoding %u x%u", speed, width);
+    }
+}
+
+
+/**
+ * @brief Walk from an endpoint through the parent bridges to the root port, recording the links in the path
+ * @details
+ *   The link status register of a device describes the link on its upstream side. Therefore links are recorded for
+ *   endpoints, switch upstream ports and PCIe to PCI bridges. Switch downstream ports are skipped, as their link status
+ *   describes the link already recorded for the device below them.
+ * @param[in/out] endpoint The endpoint to walk from
+ * @param[out] path The path which has been walked
+ */
+static void walk_path_to_root_port (generic_pci_access_device_p const endpoint, pcie_path_t *const path)
+{
+    generic_pci_access_device_p device = endpoint;
+    generic_pci_access_device_p parent;
+    exp_cap_access_t access;
+    exp_cap_access_t parent_access;
+    uint16_t flags;
+    uint16_t device_control;
+    uint16_t link_status;
+    uint32_t link_capabilities;
+    uint32_t parent_link_capabilities;
+
+    memset (path, 0, sizeof (*path));
+    path->min_max_payload_size = UINT32_MAX;
+    while ((device != NULL) && (!path->reached_root_port))
+    {
+        parent = generic_pci_access_get_parent_bridge (device);
+        obtain_pcie_capability_pointer (&access, device);
+        exp_cap_read_u16 (&access, PCI_EXP_FLAGS, &flags);
+        exp_cap_read_u16 (&access, PCI_EXP_DEVCTL, &device_control);
+        if (!access.success)
+        {
+            /* Either a conventional PCI bridge, or the configuration can't be read */
+            device = parent;
+            continue;
+        }
+
+        const uint32_t device_port_type = vfio_extract_field_u32 (flags, PCI_EXP_FLAGS_TYPE);
+        const uint32_t max_payload_size = 128u << vfio_extract_field_u32 (device_control, PCI_EXP_DEVCTL_PAYLOAD);
+
+        if (max_payload_size < path->min_max_payload_size)
+        {
+            path->min_max_payload_size = max_payload_size;
+        }
+        if (device == endpoint)
+        {
+            path->max_read_request_size = 128u << vfio_extract_field_u32 (device_control, PCI_EXP_DEVCTL_READRQ);
+        }
+
+        switch (device_port_type)
+        {
+        case PCI_EXP_TYPE_ROOT_PORT:
+            path->reached_root_port = true;
+            break;
+
+        case PCI_EXP_TYPE_ENDPOINT:
+        case PCI_EXP_TYPE_LEG_END:
+        case PCI_EXP_TYPE_UPSTREAM:
+        case PCI_EXP_TYPE_PCI_BRIDGE:
+            exp_cap_read_u32 (&access, PCI_EXP_LNKCAP, &link_capabilities);
+            exp_cap_read_u16 (&access, PCI_EXP_LNKSTA, &link_status);
+            if ((path->num_links < MAX_PATH_LINKS) && access.success)
+            {
+                pcie_link_t *const link = &path->links[path->num_links];
+
+                get_device_name (device, link->downstream_name, sizeof (link->downstream_name));
+                link->negotiated_speed = vfio_extract_field_u32 (link_status, PCI_EXP_LNKSTA_SPEED);
+                link->negotiated_width = vfio_extract_field_u32 (link_status, PCI_EXP_LNKSTA_WIDTH);
+                link->capable_speed = vfio_extract_field_u32 (link_capabilities, PCI_EXP_LNKCAP_SPEED);
+                link->capable_width = vfio_extract_field_u32 (link_capabilities, PCI_EXP_LNKCAP_WIDTH);
+                link->negotiated_bytes_per_sec = get_link_bytes_per_sec (link->negotiated_speed, link->negotiated_width);
+                if (parent != NULL)
+                {
+                    get_device_name (parent, link->upstream_name, sizeof (link->upstream_name));
+                    obtain_pcie_capability_pointer (&parent_access, parent);
+                    exp_cap_read_u32 (&parent_access, PCI_EXP_LNKCAP, &parent_link_capabilities);
+                    if (parent_access.success)
+                    {
+                        const uint32_t parent_speed = vfio_extract_field_u32 (parent_link_capabilities, PCI_EXP_LNKCAP_SPEED);
+                        const uint32_t parent_width = vfio_extract_field_u32 (parent_link_capabilities, PCI_EXP_LNKCAP_WIDTH);
+
+                        if (parent_speed < link->capable_speed)
+                        {
+                            link->capable_speed = parent_speed;
+                        }
+                        if (parent_width < link->capable_width)
+                        {
+                            link->capable_width = parent_width;
+                        }
+                    }
+                }
+                else
+                {
+                    snprintf (link->upstream_name, sizeof (link->upstream_name), "unknown");
+                }
+
+                if ((path->num_links == 0) ||
+                    (link->negotiated_bytes_per_sec < path->links[path->bottleneck_link_index].negotiated_bytes_per_sec))
+                {
+                    path->bottleneck_link_index = path->num_links;
+                }
+                path->num_links++;
+            }
+            break;
+
+        default:
+            /* Switch downstream ports, and other types which don't have an upstream link to record */
+            break;
+        }
+
+        device = parent;
+    }
+
+    /* Calculate the theoretical throughput through the bottleneck link:
+     * - C2H uses posted memory writes with up to Max_Payload_Size of data.
+     * - H2C uses memory reads of up to Max_Read_Request_Size, with the data returned in completions which are limited by
+     *   Max_Payload_Size. */
+    if ((path->num_links > 0) && (path->min_max_payload_size != UINT32_MAX))
+    {
+        const double bottleneck_bytes_per_sec = path->links[path->bottleneck_link_index].negotiated_bytes_per_sec;
+        const uint32_t completion_payload_size = (path->max_read_request_size < path->min_max_payload_size) ?
+                path->max_read_request_size : path->min_max_payload_size;
+
+        path->c2h_theoretical_bytes_per_sec = bottleneck_bytes_per_sec *
+                get_tlp_payload_efficiency (path->min_max_payload_size, MEMORY_WRITE_64_HEADER_BYTES);
+        path->h2c_theoretical_bytes_per_sec = bottleneck_bytes_per_sec *
+                get_tlp_payload_efficiency (completion_payload_size, COMPLETION_HEADER_BYTES);
+    }
+}
+
+
+/**
+ * @brief Display the path between an endpoint and the root port, identifying the bottleneck
+ * @param[in] path The path to display
+ */
+static void display_path (const pcie_path_t *const path)
+{
+    for (uint32_t link_index = 0; link_index < path->num_links; link_index++)
+    {
+        const pcie_link_t *const link = &path->links[link_index];
+
+        printf ("  Link %s -> %s : ", link->downstream_name, link->upstream_name);
+        display_link_speed_width (link->negotiated_speed, link->negotiated_width);
+        printf (" (capable ");
+        display_link_speed_width (link->capable_speed, link->capable_width);
+        printf (") %.1f Mbytes/sec", link->negotiated_bytes_per_sec / 1E6);
+        if ((link->negotiated_speed < link->capable_speed) || (link->negotiated_width < link->capable_width))
+        {
+            printf (" DEGRADED");
+        }
+        if (link_index == path->bottleneck_link_index)
+        {
+            printf (" <- bottleneck");
+        }
+        printf ("\n");
+    }
+    if (!path->reached_root_port)
+    {
+        printf ("  Unable to walk the path to the root port, so the report may be incomplete\n");
+    }
+
+    if (path->h2c_theoretical_bytes_per_sec > 0.0)
+    {
+        printf ("  Smallest Max_Payload_Size %u bytes, endpoint Max_Read_Request_Size %u bytes\n",
+                path->min_max_payload_size, path->max_read_request_size);
+        printf ("  Theoretical H2C %.1f Mbytes/sec  C2H %.1f Mbytes/sec\n",
+                path->h2c_theoretical_bytes_per_sec / 1E6, path->c2h_theoretical_bytes_per_sec / 1E6);
+    }
+    else
+    {
+        printf ("  Unable to determine the theoretical throughput\n");
+    }
+}
+
+
+/**
+ * @brief Measure the throughput for one direction of DMA transfers between host memory and card memory
+ * @param[in/out] context The memory test context which has been initialised with the host buffers and channels
+ * @param[in] measure_h2c When true measures H2C transfers, otherwise C2H transfers
+ * @param[out] bytes_per_sec The measured throughput
+ * @return Returns true if the transfers were successful, or false otherwise
+ */
+static bool measure_dma_direction_throughput (dma_memory_test_context_t *const context, const bool measure_h2c,
+                                              double *const bytes_per_sec)
+{
+    const int64_t duration_ns = (int64_t) (arg_duration_secs * 1E9);
+    bool success;
+
+    success = dma_memory_test_measure_throughput (context, duration_ns, measure_h2c, !measure_h2c);
+    if (success)
+    {
+        const uint64_t num_bytes_transferred = measure_h2c ? context->results.h2c_bytes : context->results.c2h_bytes;
+        const int64_t elapsed_ns = context->results.elapsed_ns;
+
+        *bytes_per_sec = (elapsed_ns > 0) ? (((double) num_bytes_transferred * 1E9) / (double) elapsed_ns) : 0.0;
+    }
+
+    return success;
+}
+
+
+/**
+ * @brief Display the measured throughput for one direction, compared against the theoretical throughput
+ * @param[in] direction The name of the direction
+ * @param[in] measured_bytes_per_sec The measured throughput
+ * @param[in] theoretical_bytes_per_sec The theoretical throughput, or zero if unknown
+ */
+static void display_measured_throughput (const char *const direction, const double measured_bytes_per_sec,
+                                         const double theoretical_bytes_per_sec)
+{
+    printf ("  Measured %s %.1f Mbytes/sec", direction, measured_bytes_per_sec / 1E6);
+    if (theoretical_bytes_per_sec > 0.0)
+    {
+        const double percent = (measured_bytes_per_sec * 100.0) / theoretical_bytes_per_sec;
+
+        printf (" (%.1f%% of theoretical)", percent);
+        if (percent < arg_expected_percent)
+        {
+            printf (" BELOW EXPECTATION");
+        }
+    }
+    printf ("\n");
+}
+
+
+/**
+ * @brief Measure the DMA throughput for a design with DMA accessible memory, and compare against the theoretical throughput
+ * @param[in] design The design to measure the DMA throughput for
+ * @param[in] path The path to the root port for the design, which gives the theoretical throughput
+ */
+static void measure_design_dma_throughput (const fpga_design_t *const design, const pcie_path_t *const path)
+{
+    const dma_memory_test_configuration_t configuration =
+    {
+        .vfio_device = design->vfio_device,
+        .bar_index = design->dma_bridge_bar,
+        .memory_base_address = design->dma_bridge_memory_base_address,
+        .memory_size_bytes = design->dma_bridge_memory_size_bytes,
+        .h2c_channel_id = 0,
+        .c2h_channel_id = 0,
+        .chunk_size_bytes = (arg_chunk_size_bytes < design->dma_bridge_memory_size_bytes) ?
+                arg_chunk_size_bytes : (design->dma_bridge_memory_size_bytes & ~(sizeof (uint64_t) - 1)),
+        .buffer_allocation = VFIO_BUFFER_ALLOCATION_HEAP
+    };
+    dma_memory_test_context_t *const context = calloc (1, sizeof (*context));
+    double h2c_bytes_per_sec;
+    double c2h_bytes_per_sec;
+
+    if (context == NULL)
+    {
+        printf ("Failed to allocate dma_memory_test_context_t\n");
+        exit (EXIT_FAILURE);
+    }
+
+    if (dma_memory_test_initialise (context, &configuration))
+    {
+        /* dma_memory_test_finalise() reports the reason for a DMA failure */
+        if (measure_dma_direction_throughput (context, true, &h2c_bytes_per_sec))
+        {
+            display_measured_throughput ("H2C", h2c_bytes_per_sec, path->h2c_theoretical_bytes_per_sec);
+        }
+        else
+        {
+            printf ("  H2C DMA failed\n");
+        }
+        if (context->transfer_success && measure_dma_direction_throughput (context, false, &c2h_bytes_per_sec))
+        {
+            display_measured_throughput ("C2H", c2h_bytes_per_sec, path->c2h_theoretical_bytes_per_sec);
+        }
+        else
+        {
+            printf ("  C2H DMA failed\n");
+        }
+        dma_memory_test_finalise (context);
+    }
+
+    free (context);
+}
+
+
+int main (int argc, char *argv[])
+{
+    fpga_designs_t designs;
+    pcie_path_t path;
+    generic_pci_access_device_p endpoint;
+
+    parse_command_line_arguments (argc, argv);
+
+    /* Open the FPGA designs which have an IOMMU group assigned */
+    identify_pcie_fpga_designs (&designs);
+
+    generic_pci_access_context_p const access_context = generic_pci_access_initialise ();
+
+    for (uint32_t design_index = 0; design_index < designs.num_identified_designs; design_index++)
+    {
+        fpga_design_t *const design = &designs.designs[design_index];
+        const struct pci_dev *const pci_dev = design->vfio_device->pci_dev;
+        const generic_pci_access_filter_t filter =
+        {
+            .filter_type = GENERIC_PCI_ACCESS_FILTER_LOCATION,
+            .domain = (uint32_t) pci_dev->domain,
+            .bus = pci_dev->bus,
+            .dev = pci_dev->dev,
+            .func = pci_dev->func
+        };
+
+        printf ("\n%s design PCI device %s\n", fpga_design_names[design->design_id], design->vfio_device->device_name);
+        generic_pci_access_iterator_p const device_iterator = generic_pci_access_iterator_create (access_context, &filter);
+        endpoint = generic_pci_access_iterator_next (device_iterator);
+        generic_pci_access_iterator_destroy (device_iterator);
+        if (endpoint == NULL)
+        {
+            printf ("  Unable to find the PCI device to walk the path to the root port\n");
+            continue;
+        }
+
+        walk_path_to_root_port (endpoint, &path);
+        display_path (&path);
+
+        if (!arg_skip_dma_measurement)
+        {
+            if (design->dma_bridge_present && (design->dma_bridge_memory_size_bytes > 0))
+            {
+                measure_design_dma_throughput (design, &path);
+            }
+            else
+            {
+                printf ("  DMA throughput not measured, as the design doesn't have a DMA bridge with DMA accessible memory\n");
+            }
+        }
+    }
+
+    generic_pci_access_finalise (access_context);
+    close_pcie_fpga_designs (&designs);
+
+    return EXIT_SUCCESS;
+}
@@ -9,139 +9,19 @@
  */
 
 #include "generic_pci_access.h"
+#include "pcie_exp_cap_access.h"
 #include "vfio_bitops.h"
 
 #include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
 #include <stdio.h>
-#include <errno.h>
 
 #include <unistd.h>
 #include <pci/pci.h>
 #include <linux/pci_regs.h> /* For PCI_EXP_LNKCTL2_TLS */
 
 
-/* Structure used to read or write the PCIe express capability configuration registers for a device */
-typedef struct
-{
-    /* Overall success. Set false on the first error attempting to access the configuration registers */
-    bool success;
-    /* The PCIe device for which are accessing the PCIe express capability for */
-    generic_pci_access_device_p device;
-    /* The PCIe capability pointer, used as the offset for the start of the configuration registers */
-    uint8_t capability_pointer;
-} exp_cap_access_t;
-
-
-/**
- * @brief Read a PCIe capability configuration register for a device
- * @details Only attempts the read if the overall status is currently successful.
- *          Reports a diagnostic error on the first failure, including the errno from the underlying configuration read.
- * @param[in/out] access The access mechanism, updated if the read fails.
- * @param[in] offset The offset into the PCIe express capability configuration registers to read
- * @param[out] value The configuration register value read.
- */
-static void exp_cap_read_u16 (exp_cap_access_t *const access, const uint32_t offset, uint16_t *const value)
-{
-    if (access->success)
-    {
-        errno = 0;
-        if (!generic_pci_access_cfg_read_u16 (access->device, access->capability_pointer + offset, value))
-        {
-            printf ("PCIe capability U16 read for register 0x%x failed : %s\n", offset, strerror (errno));
-            access->success = false;
-        }
-    }
-}
-
-static void exp_cap_read_u32 (exp_cap_access_t *const access, const uint32_t offset, uint32_t *const value)
-{
-    if (access->success)
-    {
-        errno = 0;
-        if (!generic_pci_access_cfg_read_u32 (access->device, access->capability_pointer + offset, value))
-        {
-            printf ("PCIe capability U32 read for register 0x%x failed : %s\n", offset, strerror (errno));
-            access->success = false;
-        }
-    }
-}
-
-
-/**
- * @brief Write a PCIe capability configuration register for a device
- * @details Only attempts the write if the overall status is currently successful.
- *          Reports a diagnostic error on the first failure, including the errno from the underlying configuration write.
- * @param[in/out] access The access mechanism, updated if the write fails.
- * @param[in] offset The offset into the PCIe express capability configuration registers to write
- * @param[in] value The configuration register value to write
- */
-static void exp_cap_write_u16 (exp_cap_access_t *const access, const uint32_t offset, const uint16_t value)
-{
-    if (access->success)
-    {
-        errno = 0;
-        if (!generic_pci_access_cfg_write_u16 (access->device, access->capability_pointer + offset, value))
-        {
-            printf ("PCIe capability U16 write for register 0x%x failed : %s\n", offset, strerror (errno));
-            access->success = false;
-        }
-    }
-}
-
-
-/**
- * @brief Obtain the PCIe capability pointer for a device, to be able to access the PCIe express capability configuration registers.
- * @param[out] access The initialised access mechanism.
- * @param[in/out] device The device to obtain the capability pointer for
- */
-static void obtain_pcie_capability_pointer (exp_cap_access_t *const access, generic_pci_access_device_p const device)
-{
-    bool found_capability_pointer = false;
-    uint16_t status_register;
-    bool been_hear[256] = {false};
-    uint8_t capability_id;
-
-    errno = 0;
-    access->device = device;
-    access->success = generic_pci_access_cfg_read_u16 (access->device, PCI_STATUS, &status_register);
-
-    /* Check for presence of PCI capabilities */
-    if (access->success && (status_register & PCI_STATUS_CAP_LIST) != 0)
-    {
-        /* Iterate over all capabilities, looking for the PCIe capability.
-         * been_hear[] used as protection against infinite loops due to malformed capability lists */
-        access->success = generic_pci_access_cfg_read_u8 (access->device, PCI_CAPABILITY_LIST, &access->capability_pointer);
-        while (access->success && (!found_capability_pointer) &&
-               (access->capability_pointer != 0) && (!been_hear[access->capability_pointer]))
-        {
-            access->success = generic_pci_access_cfg_read_u8 (device, (access->capability_pointer) + PCI_CAP_LIST_ID, &capability_id);
-
-            if (access->success)
-            {
-                if (capability_id == PCI_CAP_ID_EXP)
-                {
-                    found_capability_pointer = true;
-                }
-                else
-                {
-                    /* Advance to next capability */
-                    been_hear[access->capability_pointer] = true;
-                    access->success = generic_pci_access_cfg_read_u8 (device, (access->capability_pointer) + PCI_CAP_LIST_NEXT,
-                            &access->capability_pointer);
-                }
-            }
-        }
-    }
-
-    if (!access->success)
-    {
-        printf ("Failed to read capability pointer : %s\n", strerror (errno));
-    }
-}
-
-
 int main (int argc, char *argv[])
 {
     char junk;
@@ -169,7 +49,7 @@ int main (int argc, char *argv[])
     const char *const location_text = argv[1];
     memset (&filter, 0, sizeof (filter));
     if (sscanf (location_text, "%x:%" SCNx8 ":%" SCNx8 ".%" SCNx8 "%c",
-            &filter.domain, &filter.bus, &filter.func, &filter.dev, &junk) == 4)
+            &filter.domain, &filter.bus, &filter.dev, &filter.func, &junk) == 4)
     {
         filter.filter_type = GENERIC_PCI_ACCESS_FILTER_LOCATION;
     }
@@ -207,7 +87,10 @@ int main (int argc, char *argv[])
     {
         uint16_t flags;
 
-        obtain_pcie_capability_pointer (&access, device);
+        if (!obtain_pcie_capability_pointer (&access, device))
+        {
+            printf ("Unable to access the PCIe capability of the target device\n");
+        }
 
         /* PCIe endpoints and upstream ports don't support the Retrain Link bit which is required to set the PCIe speed.
          * Therefore, if such a PCIe device has been specified need to operate on the parent bridge for the PCIe device */
@@ -224,7 +107,10 @@ int main (int argc, char *argv[])
                 access.success = access.success && (device != NULL);
                 if (access.success)
                 {
-                    obtain_pcie_capability_pointer (&access, device);
+                    if (!obtain_pcie_capability_pointer (&access, device))
+                    {
+                        printf ("Unable to access the PCIe capability of the parent bridge\n");
+                    }
                 }
                 else
                 {
@@ -0,0 +1,580 @@
+/*
+ * @file pcie_speed_sweep.c
+ * @date 18 Oct 2026
+ * @author Chester Gillon
+ * @brief Characterise the DMA throughput of each identified FPGA design at each supported PCIe link speed
+ * @details
+ *  For each identified FPGA design the link between the endpoint and its parent bridge is cycled through every link
+ *  speed supported by both ends of the link, lowest first. At each speed:
+ *  a. The link is retrained a number of times, using the same mechanism as pcie_set_speed. A retrain is counted as a
+ *     failure if link training doesn't complete, or the negotiated speed or width isn't the expected value.
+ *  b. For designs with a DMA bridge with DMA accessible memory, a timed measurement is performed with H2C and C2H
+ *     transfers running concurrently.
+ *  c. The number of PCIe errors reported for the endpoint by a VFIO error monitor is counted.
+ *  d. The number of error status bits set in the parent bridge is counted. The bridge is the side of the link which is
+ *     retrained, and so is where most link errors are logged, e.g. receiver errors, bad TLPs or DLLPs and surprise down.
+ *     The bridge error status bits are cleared before testing each speed.
+ *
+ *  Once all speeds have been tested the original target link speed is restored, and a table of the results displayed.
+ *
+ *  Since link retraining requires the parent bridge, which can only be found using the pciutils generic PCI access
+ *  mechanism, this program is only built for pciutils. Changing the link speed requires CAP_SYS_ADMIN.
+ */
+
+#include "generic_pci_access.h"
+#include "pcie_exp_cap_access.h"
+#include "vfio_bitops.h"
+#include "vfio_error_monitor.h"
+#include "identify_pcie_fpga_design.h"
+#include "dma_memory_test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <getopt.h>
+#include <pci/pci.h>
+#include <linux/pci_regs.h>
+
+
+/* The maximum link speed encoding which can be tested, which is 64 GT/s */
+#define MAX_LINK_SPEED PCI_EXP_LNKCTL2_TLS_64_0GT
+
+
+/* The Supported Link Speeds Vector in Link Capabilities 2, where bit N is set if link speed encoding N is supported */
+#define LNKCAP2_SUPPORTED_SPEEDS_MASK 0xfe
+
+
+/* How long to wait for link training to complete after a retrain */
+#define LINK_TRAINING_TIMEOUT_NS 1000000000LL
+
+
+/* The interval at which the VFIO error monitor polls the error status of the endpoint. After each measurement waits for
+ * two poll intervals, so that any errors which occurred during the measurement are counted against the link speed. */
+#define ERROR_POLL_INTERVAL_NS 100000000LL
+
+
+/* Command line argument which specifies the number of times the link is retrained at each speed */
+static uint32_t arg_num_retrains = 3;
+
+
+/* Command line argument which specifies the duration of the DMA throughput measurement at each speed */
+static double arg_duration_secs = 2.0;
+
+
+/* Command line argument which specifies the size of each DMA transfer when measuring DMA throughput */
+static size_t arg_chunk_size_bytes = 0x400000;
+
+
+/** The command line options for this program, in the format passed to getopt_long().
+ *  Only long arguments are supported */
+static const struct option command_line_options[] =
+{
+    {"retrains", required_argument, NULL, 0},
+    {"duration_secs", required_argument, NULL, 0},
+    {"chunk_size", required_argument, NULL, 0},
+    {NULL, 0, NULL, 0}
+};
+
+
+/* The results for one link speed */
+typedef struct
+{
+    /* Set true when this link speed was tested */
+    bool tested;
+    /* The number of times the link was retrained, and how many of those failed */
+    uint32_t num_retrains;
+    uint32_t num_retrain_failures;
+    /* The negotiated speed and width following the final retrain */
+    uint32_t negotiated_speed;
+    uint32_t negotiated_width;
+    /* Set true when DMA throughput was measured */
+    bool throughput_measured;
+    double h2c_bytes_per_sec;
+    double c2h_bytes_per_sec;
+    /* The number of PCIe error events reported for the endpoint while testing the link speed */
+    uint64_t num_error_events;
+    /* The number of error status bits set in the parent bridge while testing the link speed */
+    uint32_t num_bridge_errors;
+} link_speed_result_t;
+
+
+/* Used to read the error status of the parent bridge of the endpoint, which isn't a VFIO device so can't be monitored
+ * using a VFIO error monitor */
+typedef struct
+{
+    /* The access for the PCIe capability, containing the Device Status register */
+    exp_cap_access_t *access;
+    /* When true aer_capability_offset gives the offset of the Advanced Error Reporting extended capability */
+    bool aer_capability_present;
+    uint32_t aer_capability_offset;
+} bridge_error_status_t;
+
+
+/* The link speed names, indexed by the PCI_EXP_LNKSTA_SPEED and PCI_EXP_LNKCTL2_TLS encodings */
+static const char *const link_speed_names[MAX_LINK_SPEED + 1] =
+{
+    [0] = "unknown",
+    [1] = "2.5 GT/s",
+    [2] = "5 GT/s",
+    [3] = "8 GT/s",
+    [4] = "16 GT/s",
+    [5] = "32 GT/s",
+    [6] = "64 GT/s"
+};
+
+
+/**
+ * @brief Display the usage for this program, and the exit
+ */
+static void display_usage (void)
+{
+    printf ("Usage:\n");
+    printf ("  pcie_speed_sweep <options>\n");
+    printf ("   Measure the DMA throughput of each FPGA design at each supported PCIe link speed\n");
+    printf ("--retrains <count>\n");
+    printf ("  The number of times the link is retrained at each speed. Default %" PRIu32 "\n", arg_num_retrains);
+    printf ("--duration_secs <seconds>\n");
+    printf ("  The duration of the DMA throughput measurement at each speed. Default %.1f\n", arg_duration_secs);
+    printf ("--chunk_size <size_bytes>\n");
+    printf ("  The size of each DMA transfer when measuring DMA throughput. Minimum 0x%x. Default 0x%zx\n",
+            DMA_MEMORY_TEST_MIN_CHUNK_SIZE_BYTES, arg_chunk_size_bytes);
+
+    exit (EXIT_FAILURE);
+}
+
+
+/**
+ * @brief Parse the command line arguments, storing the results in global variables
+ * @param[in] argc, argv Arguments passed to main
+ */
+static void parse_command_line_arguments (int argc, char *argv[])
+{
+    int opt_status;
+    char junk;
+
+    do
+    {
+        int option_index = 0;
+
+        opt_status = getopt_long (argc, argv, "", command_line_options, &option_index);
+        if (opt_status == '?')
+        {
+            display_usage ();
+        }
+        else if (opt_status >= 0)
+        {
+            const struct option *const optdef = &command_line_options[option_index];
+
+            if (optdef->flag != NULL)
+            {
+                /* Argument just sets a flag */
+            }
+            else if (strcmp (optdef->name, "retrains") == 0)
+            {
+                if ((sscanf (optarg, "%" SCNu32 "%c", &arg_num_retrains, &junk) != 1) || (arg_num_retrains == 0))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else if (strcmp (optdef->name, "duration_secs") == 0)
+            {
+                if ((sscanf (optarg, "%lf%c", &arg_duration_secs, &junk) != 1) || (arg_duration_secs <= 0.0))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else if (strcmp (optdef->name, "chunk_size") == 0)
+            {
+                if ((sscanf (optarg, "%zi%c", &arg_chunk_size_bytes, &junk) != 1) ||
+                    (arg_chunk_size_bytes < DMA_MEMORY_TEST_MIN_CHUNK_SIZE_BYTES) ||
+                    ((arg_chunk_size_bytes % sizeof (uint64_t)) != 0))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else
+            {
+                /* This is a program error, and shouldn't be triggered by the command line options */
+                fprintf (stderr, "Unexpected argument definition %s\n", optdef->name);
+                exit (EXIT_FAILURE);
+            }
+        }
+    } while (opt_status != -1);
+}
+
+
+/**
+ * @brief Get the link speeds supported by a device, as a Supported Link Speeds Vector
+ * @details Devices prior to PCIe 3.0 may not implement Link Capabilities 2, in which case all speeds up to the
+ *          Max Link Speed in Link Capabilities are assumed to be supported.
+ * @param[in/out] access The access mechanism for the device
+ * @return The bit mask of supported link speeds, where bit N is set if link speed encoding N is supported
+ */
+static uint32_t get_supported_link_speeds (exp_cap_access_t *const access)
+{
+    uint32_t link_capabilities = 0;
+    uint32_t link_capabilities2 = 0;
+
+    exp_cap_read_u32 (access, PCI_EXP_LNKCAP, &link_capabilities);
+    exp_cap_read_u32 (access, PCI_EXP_LNKCAP2, &link_capabilities2);
+
+    uint32_t supported_speeds = link_capabilities2 & LNKCAP2_SUPPORTED_SPEEDS_MASK;
+    if (supported_speeds == 0)
+    {
+        const uint32_t max_link_speed = vfio_extract_field_u32 (link_capabilities, PCI_EXP_LNKCAP_SPEED);
+
+        supported_speeds = ((2u << max_link_speed) - 2u) & LNKCAP2_SUPPORTED_SPEEDS_MASK;
+    }
+
+    return supported_speeds;
+}
+
+
+/**
+ * @brief Measure the DMA throughput for a design at the current link speed
+ * @param[in/out] context The memory test context for the design
+ * @param[out] result Updated with the measured throughput
+ */
+static void measure_link_speed_throughput (dma_memory_test_context_t *const context, link_speed_result_t *const result)
+{
+    const int64_t duration_ns = (int64_t) (arg_duration_secs * 1E9);
+
+    if (dma_memory_test_measure_throughput (context, duration_ns, true, true))
+    {
+        const double elapsed_secs = (double) context->results.elapsed_ns / 1E9;
+
+        result->throughput_measured = true;
+        result->h2c_bytes_per_sec = (double) context->results.h2c_bytes / elapsed_secs;
+        result->c2h_bytes_per_sec = (double) context->results.c2h_bytes / elapsed_secs;
+    }
+}
+
+
+/**
+ * @brief Read and clear the error status of the parent bridge
+ * @details The error status bits are RW1C, so are cleared by writing back the bits which are set.
+ *          A failure to access the AER capability is reported, but doesn't stop the sweep.
+ * @param[in/out] bridge_errors The bridge to read the error status for
+ * @param[in] description When non-NULL and error status bits are set, displayed with the error status
+ * @return The number of error status bits which were set
+ */
+static uint32_t read_and_clear_bridge_errors (bridge_error_status_t *const bridge_errors, const char *const description)
+{
+    exp_cap_access_t *const access = bridge_errors->access;
+    const uint32_t aer = bridge_errors->aer_capability_offset;
+    uint16_t device_status = 0;
+    uint32_t uncorrectable_status = 0;
+    uint32_t correctable_status = 0;
+
+    exp_cap_read_u16 (access, PCI_EXP_DEVSTA, &device_status);
+    device_status &= VFIO_ERROR_MONITOR_DEVSTA_ERRORS;
+    if (device_status != 0)
+    {
+        exp_cap_write_u16 (access, PCI_EXP_DEVSTA, device_status);
+    }
+
+    if (access->success && bridge_errors->aer_capability_present)
+    {
+        if (!generic_pci_access_cfg_read_u32 (access->device, aer + PCI_ERR_UNCOR_STATUS, &uncorrectable_status) ||
+            !generic_pci_access_cfg_read_u32 (access->device, aer + PCI_ERR_COR_STATUS, &correctable_status))
+        {
+            printf ("  Failed to read the bridge AER status\n");
+            bridge_errors->aer_capability_present = false;
+            uncorrectable_status = 0;
+            correctable_status = 0;
+        }
+        if ((uncorrectable_status != 0) &&
+            !generic_pci_access_cfg_write_u32 (access->device, aer + PCI_ERR_UNCOR_STATUS, uncorrectable_status))
+        {
+            printf ("  Failed to clear the bridge AER uncorrectable status\n");
+        }
+        if ((correctable_status != 0) &&
+            !generic_pci_access_cfg_write_u32 (access->device, aer + PCI_ERR_COR_STATUS, correctable_status))
+        {
+            printf ("  Failed to clear the bridge AER correctable status\n");
+        }
+    }
+
+    const uint32_t num_errors = (uint32_t) (__builtin_popcount (device_status) +
+            __builtin_popcount (uncorrectable_status) + __builtin_popcount (correctable_status));
+    if ((num_errors > 0) && (description != NULL))
+    {
+        printf ("  Bridge %s: DevSta=0x%04" PRIx16 " UESta=0x%08" PRIx32 " CESta=0x%08" PRIx32 "\n",
+                description, device_status, uncorrectable_status, correctable_status);
+    }
+
+    return num_errors;
+}
+
+
+/**
+ * @brief Display the table of results of the link speed sweep for one design
+ * @param[in] results The results, indexed by link speed
+ */
+static void display_results_table (const link_speed_result_t results[const MAX_LINK_SPEED + 1])
+{
+    printf ("\n  %-9s  %8s  %8s  %-13s  %12s  %12s  %10s  %13s\n",
+            "Speed", "Retrains", "Failures", "Negotiated", "H2C Mbytes/s", "C2H Mbytes/s", "AER events", "Bridge errors");
+    for (uint32_t speed = 1; speed <= MAX_LINK_SPEED; speed++)
+    {
+        const link_speed_result_t *const result = &results[speed];
+        char negotiated[32];
+
+        if (result->tested)
+        {
+            snprintf (negotiated, sizeof (negotiated), "%s x%" PRIu32,
+                    link_speed_names[(result->negotiated_speed <= MAX_LINK_SPEED) ? result->negotiated_speed : 0],
+                    result->negotiated_width);
+            printf ("  %-9s  %8" PRIu32 "  %8" PRIu32 "  %-13s", link_speed_names[speed],
+                    result->num_retrains, result->num_retrain_failures, negotiated);
+            if (result->throughput_measured)
+            {
+                printf ("  %12.1f  %12.1f", result->h2c_bytes_per_sec / 1E6, result->c2h_bytes_per_sec / 1E6);
+            }
+            else
+            {
+                printf ("  %12s  %12s", "n/a", "n/a");
+            }
+            printf ("  %10" PRIu64 "  %13" PRIu32 "\n", result->num_error_events, result->num_bridge_errors);
+        }
+    }
+}
+
+
+/**
+ * @brief Perform the link speed sweep for one design
+ * @param[in/out] design The design to test
+ * @param[in/out] endpoint The PCI device for the design
+ * @return Returns true if the sweep completed without any failures
+ */
+static bool sweep_design_link_speeds (fpga_design_t *const design, generic_pci_access_device_p const endpoint)
+{
+    exp_cap_access_t endpoint_access;
+    exp_cap_access_t bridge_access;
+    link_speed_result_t results[MAX_LINK_SPEED + 1];
+    dma_memory_test_context_t *context = NULL;
+    vfio_error_monitor_t monitor;
+    bridge_error_status_t bridge_errors;
+    uint32_t endpoint_link_capabilities = 0;
+    uint32_t bridge_link_capabilities = 0;
+    uint16_t original_link_control2 = 0;
+    uint16_t link_status;
+    bool success = true;
+
+    memset (results, 0, sizeof (results));
+
+    /* Retraining is performed by the downstream port which is the parent bridge of the endpoint */
+    if (!obtain_pcie_capability_pointer (&endpoint_access, endpoint))
+    {
+        printf ("  Unable to access the PCIe capability of the endpoint\n");
+        return false;
+    }
+    generic_pci_access_device_p const bridge = generic_pci_access_get_parent_bridge (endpoint);
+    if (bridge == NULL)
+    {
+        printf ("  Unable to find the parent bridge of the endpoint\n");
+        return false;
+    }
+    if (!obtain_pcie_capability_pointer (&bridge_access, bridge))
+    {
+        printf ("  Unable to access the PCIe capability of the parent bridge\n");
+        return false;
+    }
+
+    /* The speeds tested are those supported by both ends of the link, and the expected width is that which both ends
+     * are capable of */
+    const uint32_t supported_speeds = get_supported_link_speeds (&endpoint_access) & get_supported_link_speeds (&bridge_access);
+    exp_cap_read_u32 (&endpoint_access, PCI_EXP_LNKCAP, &endpoint_link_capabilities);
+    exp_cap_read_u32 (&bridge_access, PCI_EXP_LNKCAP, &bridge_link_capabilities);
+    exp_cap_read_u16 (&bridge_access, PCI_EXP_LNKCTL2, &original_link_control2);
+    if (!endpoint_access.success || !bridge_access.success)
+    {
+        printf ("  Unable to read the link capabilities\n");
+        return false;
+    }
+    const uint32_t endpoint_width = vfio_extract_field_u32 (endpoint_link_capabilities, PCI_EXP_LNKCAP_WIDTH);
+    const uint32_t bridge_width = vfio_extract_field_u32 (bridge_link_capabilities, PCI_EXP_LNKCAP_WIDTH);
+    const uint32_t expected_width = (endpoint_width < bridge_width) ? endpoint_width : bridge_width;
+    const uint32_t original_target_link_speed = vfio_extract_field_u32 (original_link_control2, PCI_EXP_LNKCTL2_TLS);
+
+    /* Only designs with DMA accessible memory have the throughput measured, since the stream connections depend upon
+     * the design */
+    if (design->dma_bridge_present && (design->dma_bridge_memory_size_bytes > 0))
+    {
+        const dma_memory_test_configuration_t configuration =
+        {
+            .vfio_device = design->vfio_device,
+            .bar_index = design->dma_bridge_bar,
+            .memory_base_address = design->dma_bridge_memory_base_address,
+            .memory_size_bytes = design->dma_bridge_memory_size_bytes,
+            .h2c_channel_id = 0,
+            .c2h_channel_id = 0,
+            .chunk_size_bytes = (arg_chunk_size_bytes < design->dma_bridge_memory_size_bytes) ?
+                    arg_chunk_size_bytes : (design->dma_bridge_memory_size_bytes & ~(sizeof (uint64_t) - 1)),
+            .buffer_allocation = VFIO_BUFFER_ALLOCATION_HEAP
+        };
+
+        context = calloc (1, sizeof (*context));
+        if (context == NULL)
+        {
+            printf ("Failed to allocate dma_memory_test_context_t\n");
+            exit (EXIT_FAILURE);
+        }
+        if (!dma_memory_test_initialise (context, &configuration))
+        {
+            free (context);
+            context = NULL;
+        }
+    }
+
+    /* vfio_error_monitor_start() samples the endpoint error status before returning, so errors latched before the sweep
+     * started are not counted against the first link speed */
+    vfio_error_monitor_initialise (&monitor, ERROR_POLL_INTERVAL_NS, true);
+    vfio_error_monitor_add_device (&monitor, design->vfio_device);
+    vfio_error_monitor_register_callback (&monitor, vfio_error_monitor_display_event, NULL);
+    vfio_error_monitor_start (&monitor);
+
+    /* Clear any errors latched in the bridge before the sweep started */
+    bridge_errors.access = &bridge_access;
+    bridge_errors.aer_capability_present =
+            exp_cap_find_extended_capability (&bridge_access, PCI_EXT_CAP_ID_ERR, &bridge_errors.aer_capability_offset);
+    (void) read_and_clear_bridge_errors (&bridge_errors, "error status latched before the sweep, which is cleared");
+
+    for (uint32_t speed = 1; bridge_access.success && (speed <= MAX_LINK_SPEED); speed++)
+    {
+        link_speed_result_t *const result = &results[speed];
+
+        if ((supported_speeds & (1u << speed)) == 0)
+        {
+            continue;
+        }
+
+        printf ("  Testing link speed %s\n", link_speed_names[speed]);
+        const uint64_t initial_error_events = vfio_error_monitor_total_events (&monitor);
+        result->tested = true;
+        for (uint32_t retrain_index = 0; bridge_access.success && (retrain_index < arg_num_retrains); retrain_index++)
+        {
+            const bool training_complete =
+                    exp_cap_retrain_link (&bridge_access, speed, LINK_TRAINING_TIMEOUT_NS, &link_status);
+
+            result->num_retrains++;
+            result->negotiated_speed = vfio_extract_field_u32 (link_status, PCI_EXP_LNKSTA_SPEED);
+            result->negotiated_width = vfio_extract_field_u32 (link_status, PCI_EXP_LNKSTA_WIDTH);
+            if (!training_complete || (result->negotiated_speed != speed) || (result->negotiated_width != expected_width))
+            {
+                result->num_retrain_failures++;
+                success = false;
+            }
+        }
+
+        if (bridge_access.success && (context != NULL))
+        {
+            measure_link_speed_throughput (context, result);
+            if (!result->throughput_measured)
+            {
+                /* The DMA context isn't usable once a transfer has failed */
+                success = false;
+                dma_memory_test_finalise (context);
+                free (context);
+                context = NULL;
+            }
+        }
+
+        const struct timespec error_settle_time =
+        {
+            .tv_sec = 0,
+            .tv_nsec = 2 * ERROR_POLL_INTERVAL_NS
+        };
+        nanosleep (&error_settle_time, NULL);
+        result->num_error_events = vfio_error_monitor_total_events (&monitor) - initial_error_events;
+        result->num_bridge_errors = read_and_clear_bridge_errors (&bridge_errors, "error status");
+        if ((result->num_error_events > 0) || (result->num_bridge_errors > 0))
+        {
+            success = false;
+        }
+    }
+
+    /* Restore the original target link speed */
+    if (bridge_access.success)
+    {
+        if (!exp_cap_retrain_link (&bridge_access, original_target_link_speed, LINK_TRAINING_TIMEOUT_NS, &link_status))
+        {
+            printf ("  Failed to restore the original target link speed %s\n",
+                    link_speed_names[(original_target_link_speed <= MAX_LINK_SPEED) ? original_target_link_speed : 0]);
+            success = false;
+        }
+    }
+    else
+    {
+        success = false;
+    }
+
+    vfio_error_monitor_stop (&monitor);
+    if (context != NULL)
+    {
+        dma_memory_test_finalise (context);
+        free (context);
+    }
+
+    display_results_table (results);
+
+    return success;
+}
+
+
+int main (int argc, char *argv[])
+{
+    fpga_designs_t designs;
+    generic_pci_access_device_p endpoint;
+    bool overall_success = true;
+
+    parse_command_line_arguments (argc, argv);
+
+    /* Open the FPGA designs which have an IOMMU group assigned */
+    identify_pcie_fpga_designs (&designs);
+
+    generic_pci_access_context_p const access_context = generic_pci_access_initialise ();
+
+    for (uint32_t design_index = 0; design_index < designs.num_identified_designs; design_index++)
+    {
+        fpga_design_t *const design = &designs.designs[design_index];
+        const struct pci_dev *const pci_dev = design->vfio_device->pci_dev;
+        const generic_pci_access_filter_t filter =
+        {
+            .filter_type = GENERIC_PCI_ACCESS_FILTER_LOCATION,
+            .domain = (uint32_t) pci_dev->domain,
+            .bus = pci_dev->bus,
+            .dev = pci_dev->dev,
+            .func = pci_dev->func
+        };
+
+        printf ("\n%s design PCI device %s\n", fpga_design_names[design->design_id], design->vfio_device->device_name);
+        generic_pci_access_iterator_p const device_iterator = generic_pci_access_iterator_create (access_context, &filter);
+        endpoint = generic_pci_access_iterator_next (device_iterator);
+        generic_pci_access_iterator_destroy (device_iterator);
+        if (endpoint == NULL)
+        {
+            printf ("  Unable to find the PCI device to change the link speed of\n");
+            overall_success = false;
+            continue;
+        }
+
+        if (!sweep_design_link_speeds (design, endpoint))
+        {
+            overall_success = false;
+        }
+    }
+
+    generic_pci_access_finalise (access_context);
+    close_pcie_fpga_designs (&designs);
+
+    printf ("\nOverall %s\n", overall_success ? "PASS" : "FAIL");
+
+    return overall_success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -127,7 +127,7 @@ generic_pci_access_device_p generic_pci_access_iterator_next (generic_pci_access
      * Returns the pointer to to the underlying vfio_device_t type, as avoids the need to perform our own memory management. */
     if (iterator->num_devices_returned < iterator->vfio_devices.num_devices)
     {
-        matching_device = (generic_pci_access_device_p) &iterator->vfio_devices.devices[iterator->num_devices_returned];
+        matching_device = (generic_pci_access_device_p) iterator->vfio_devices.devices[iterator->num_devices_returned];
         iterator->num_devices_returned++;
     }
 
@@ -10,7 +10,12 @@
  *   b. The only master on the I2C bus.
  *   c. Unable to handle I2C slaves which stretch SCL.
  *
- *   Attempts to use a nominal I2C "Standard" SCL frequency of 100 KHz.
+ *   Attempts to use a nominal I2C "Standard" SCL frequency of 100 KHz by default, or optionally "Fast-mode" of 400 KHz.
+ *
+ *   The delays for the bus timing busy-poll the invariant Time Stamp Counter (TSC) when available, calibrated against
+ *   CLOCK_MONOTONIC_RAW, since reading the TSC has lower overhead than clock_gettime(). Otherwise falls back to polling
+ *   CLOCK_MONOTONIC_RAW. The delay for each SCL / SDA edge is timed from before the write to the GPIO data register, so the
+ *   MMIO write latency counts towards the delay rather than adding to it.
  *
  *   Includes support for System Management Bus (SMBus) since:
  *   a. Allows the encapsulation of the Packet Error Code (PEC) calculation, which is computed over the entire message
@@ -25,6 +30,13 @@
 
 #include <time.h>
 #include <string.h>
+#include <stdio.h>
+#include <inttypes.h>
+
+#if defined (__x86_64__) || defined (__i386__)
+#include <x86intrin.h>
+#include <cpuid.h>
+#endif
 
 #include "i2c_bit_banged.h"
 #include "vfio_access.h"
@@ -57,15 +69,41 @@
 #define WRITE_OPERATION 0 /* Write operation on the I2C bus */
 
 
-/* Delay values taken from the I2C bus specification UM10204, for Standard Mode using a 100 KHz SCL clock frequency */
-#define T_RISE   1000 /* t r rise time of both SDA and SCL signals */
-#define T_FALL    300 /* t f fall time of both SDA and SCL signals */
-#define T_BUF    4700 /* t BUF bus free time between a STOP and START condition */
-#define T_SU_STA 4700 /* t SU;STA set-up time for a repeated START condition in Standard Mode */
-#define T_HD_STA 4000 /* t HD;STA hold time (repeated) START condition in Standard Mode */
-#define T_SU_STO 4000 /* t SU;STO set-up time for STOP condition */
-#define T_LOW    4700 /* t LOW LOW period of the SCL clock */
-#define T_HIGH   4000 /* t HIGH HIGH period of the SCL clock */
+/* Delay values in nanoseconds taken from the I2C bus specification UM10204, for Standard Mode using a 100 KHz SCL clock
+ * frequency */
+static const bit_bang_timing_t standard_mode_timing_ns =
+{
+    .t_rise   = 1000, /* t r rise time of both SDA and SCL signals */
+    .t_fall   =  300, /* t f fall time of both SDA and SCL signals */
+    .t_buf    = 4700, /* t BUF bus free time between a STOP and START condition */
+    .t_su_sta = 4700, /* t SU;STA set-up time for a repeated START condition in Standard Mode */
+    .t_hd_sta = 4000, /* t HD;STA hold time (repeated) START condition in Standard Mode */
+    .t_su_sto = 4000, /* t SU;STO set-up time for STOP condition */
+    .t_low    = 4700, /* t LOW LOW period of the SCL clock */
+    .t_high   = 4000  /* t HIGH HIGH period of the SCL clock */
+};
+
+
+/* Delay values in nanoseconds taken from the I2C bus specification UM10204, for Fast-mode using a 400 KHz SCL clock frequency */
+static const bit_bang_timing_t fast_mode_timing_ns =
+{
+    .t_rise   =  300,
+    .t_fall   =  300,
+    .t_buf    = 1300,
+    .t_su_sta =  600,
+    .t_hd_sta =  600,
+    .t_su_sto =  600,
+    .t_low    = 1300,
+    .t_high   =  600
+};
+
+
+/* The time over which the TSC frequency is calibrated */
+#define TSC_CALIBRATION_NS 10000000
+
+
+/* The number of GPIO data register writes used to measure the average write time */
+#define NUM_GPIO_WRITE_MEASUREMENTS 100
 
 
 /* Describes the different SMBus transfer status values */
@@ -81,64 +119,104 @@ const char *const smbus_transfer_status_descriptions[SMBUS_TRANSFER_ARRAY_SIZE]
 
 
 /**
- * @brief Use busy-polling to delay for a minimum amount of time to satisfy I2C bus timing.
+ * @brief Read CLOCK_MONOTONIC_RAW as nanoseconds
  * @details Uses CLOCK_MONOTONIC_RAW on the assumption that are running on a modern Kernel which can read that
  *          entirely from user space.
- * @param[in] delay_ns The number of nanoseconds to delay for.
+ * @return The current time in nanoseconds
  */
-static void bit_bang_delay (const int delay_ns)
+static uint64_t read_raw_clock_ns (void)
 {
-    const int nsecs_per_sec = 1000000000;
-    struct timespec end_time;
     struct timespec now;
-    bool delay_complete;
 
-    clock_gettime (CLOCK_MONOTONIC_RAW, &end_time);
-    end_time.tv_nsec += delay_ns;
-    if (end_time.tv_nsec >= nsecs_per_sec)
+    clock_gettime (CLOCK_MONOTONIC_RAW, &now);
+
+    return ((uint64_t) now.tv_sec * 1000000000UL) + (uint64_t) now.tv_nsec;
+}
+
+
+/**
+ * @brief Read the source used to time the delays
+ * @param[in] controller The controller for the GPIO bit-banged interface, which selects the delay source
+ * @return The current time in ticks of the delay source
+ */
+static inline uint64_t read_delay_ticks (const bit_banged_i2c_controller_context_t *const controller)
+{
+#if defined (__x86_64__) || defined (__i386__)
+    if (controller->delay_source == BIT_BANG_DELAY_SOURCE_TSC)
     {
-        end_time.tv_sec++;
-        end_time.tv_nsec -= nsecs_per_sec;
+        return __rdtsc ();
     }
+#endif
+
+    return read_raw_clock_ns ();
+}
 
-    do
+
+/**
+ * @brief Use busy-polling to delay until a time has been reached, to satisfy I2C bus timing.
+ * @param[in] controller The controller for the GPIO bit-banged interface, which selects the delay source
+ * @param[in] end_ticks The delay source ticks to delay until
+ */
+static void bit_bang_delay_until (const bit_banged_i2c_controller_context_t *const controller, const uint64_t end_ticks)
+{
+    while (read_delay_ticks (controller) < end_ticks)
     {
-        clock_gettime (CLOCK_MONOTONIC_RAW, &now);
-        delay_complete = (now.tv_sec > end_time.tv_sec) ||
-                ((now.tv_sec == end_time.tv_sec) && (now.tv_nsec >= end_time.tv_nsec));
-    } while (!delay_complete);
+    }
+}
+
+
+/**
+ * @brief Use busy-polling to delay for a minimum amount of time to satisfy I2C bus timing.
+ * @param[in] controller The controller for the GPIO bit-banged interface, which selects the delay source
+ * @param[in] delay_ticks The number of delay source ticks to delay for.
+ */
+static void bit_bang_delay (const bit_banged_i2c_controller_context_t *const controller, const uint64_t delay_ticks)
+{
+    bit_bang_delay_until (controller, read_delay_ticks (controller) + delay_ticks);
+}
+
+
+/**
+ * @brief Write the GPIO data output bits, and then delay to allow for the edge on the I2C bus
+ * @details The delay is timed from before the write, so that the MMIO write latency counts towards the delay.
+ * @param[in/out] controller The controller for the GPIO bit-banged interface
+ * @param[in] edge_delay_ticks The delay for the edge, in delay source ticks
+ */
+static inline void write_gpio_data_out (bit_banged_i2c_controller_context_t *const controller, const uint64_t edge_delay_ticks)
+{
+    const uint64_t edge_start_ticks = read_delay_ticks (controller);
+
+    write_reg32 (controller->gpio_regs, GPIO_DATA_OFFSET, controller->gpio_data_out);
+    bit_bang_delay_until (controller, edge_start_ticks + edge_delay_ticks);
 }
 
 
 static inline void scl_low (bit_banged_i2c_controller_context_t *const controller)
 {
     controller->gpio_data_out &= ~GPIO_DATA_SCL_OUT_MASK;
-    write_reg32 (controller->gpio_regs, GPIO_DATA_OFFSET, controller->gpio_data_out);
-    bit_bang_delay (T_FALL);
+    write_gpio_data_out (controller, controller->timing.t_fall);
 }
 
 
 static inline void scl_high (bit_banged_i2c_controller_context_t *const controller)
 {
     controller->gpio_data_out |= GPIO_DATA_SCL_OUT_MASK;
-    write_reg32 (controller->gpio_regs, GPIO_DATA_OFFSET, controller->gpio_data_out);
-    bit_bang_delay (T_RISE);
+    write_gpio_data_out (controller, controller->timing.t_rise);
+    controller->statistics.num_scl_cycles++;
 }
 
 
 static inline void sda_low (bit_banged_i2c_controller_context_t *const controller)
 {
     controller->gpio_data_out &= ~GPIO_DATA_SDA_OUT_MASK;
-    write_reg32 (controller->gpio_regs, GPIO_DATA_OFFSET, controller->gpio_data_out);
-    bit_bang_delay (T_FALL);
+    write_gpio_data_out (controller, controller->timing.t_fall);
 }
 
 
 static inline void sda_high (bit_banged_i2c_controller_context_t *const controller)
 {
     controller->gpio_data_out |= GPIO_DATA_SDA_OUT_MASK;
-    write_reg32 (controller->gpio_regs, GPIO_DATA_OFFSET, controller->gpio_data_out);
-    bit_bang_delay (T_RISE);
+    write_gpio_data_out (controller, controller->timing.t_rise);
 }
 
 
@@ -163,10 +241,13 @@ static uint8_t read_sda (bit_banged_i2c_controller_context_t *const controller)
 static void generate_i2c_stop (bit_banged_i2c_controller_context_t *const controller)
 {
     sda_low (controller); /* Need to ensure SDA is low, to generate a rising edge to signify a STOP condition */
-    bit_bang_delay (T_LOW);
+    bit_bang_delay (controller, controller->timing.t_low);
     scl_high (controller);
-    bit_bang_delay (T_SU_STO);
+    bit_bang_delay (controller, controller->timing.t_su_sto);
     sda_high (controller);
+
+    controller->statistics.num_transactions++;
+    controller->statistics.bus_busy_ticks += read_delay_ticks (controller) - controller->statistics.transaction_start_ticks;
 }
 
 
@@ -209,9 +290,9 @@ static bool i2c_transmit_byte (bit_banged_i2c_controller_context_t *const contro
             sda_low (controller);
         }
 
-        bit_bang_delay (T_LOW);
+        bit_bang_delay (controller, controller->timing.t_low);
         scl_high (controller);
-        bit_bang_delay (T_HIGH);
+        bit_bang_delay (controller, controller->timing.t_high);
         scl_low (controller);
 
         output_shift_register = (uint8_t) (output_shift_register << 1U);
@@ -222,10 +303,10 @@ static bool i2c_transmit_byte (bit_banged_i2c_controller_context_t *const contro
 
     /* Generate 9th clock and sample SDA to determine if an ACK from the slave */
     scl_high (controller);
-    bit_bang_delay (T_HIGH);
+    bit_bang_delay (controller, controller->timing.t_high);
     sampled_sda = read_sda (controller);
     scl_low (controller);
-    bit_bang_delay (T_LOW);
+    bit_bang_delay (controller, controller->timing.t_low);
     slave_acked = sampled_sda == 0;
 
     update_smbus_crc_with_byte (controller, tx_byte);
@@ -255,10 +336,10 @@ static uint8_t i2c_receive_byte (bit_banged_i2c_controller_context_t *const cont
     {
         rx_byte = (uint8_t) (rx_byte << 1U);
 
-        bit_bang_delay (T_LOW);
+        bit_bang_delay (controller, controller->timing.t_low);
         rx_byte |= read_sda (controller);
         scl_high (controller);
-        bit_bang_delay (T_HIGH);
+        bit_bang_delay (controller, controller->timing.t_high);
         scl_low (controller);
     }
 
@@ -271,9 +352,9 @@ static uint8_t i2c_receive_byte (bit_banged_i2c_controller_context_t *const cont
     {
         sda_low (controller); /* ACK */
     }
-    bit_bang_delay (T_LOW);
+    bit_bang_delay (controller, controller->timing.t_low);
     scl_high (controller);
-    bit_bang_delay (T_HIGH);
+    bit_bang_delay (controller, controller->timing.t_high);
     scl_low (controller);
 
     update_smbus_crc_with_byte (controller, rx_byte);
@@ -298,18 +379,19 @@ static bool i2c_begin (bit_banged_i2c_controller_context_t *const controller,
     if ((controller->gpio_data_out & GPIO_DATA_SCL_OUT_MASK) != 0)
     {
         /* When called with SCL high the bus is free so generate a START condition. Assumes SDA is high */
-        bit_bang_delay (T_BUF);
+        bit_bang_delay (controller, controller->timing.t_buf);
+        controller->statistics.transaction_start_ticks = read_delay_ticks (controller);
         sda_low (controller); /* Take SDA low to generate the start condition */
-        bit_bang_delay (T_HD_STA);
+        bit_bang_delay (controller, controller->timing.t_hd_sta);
     }
     else
     {
         /* When called with SCL low the bus is in use so generate a RESTART condition */
         sda_high (controller); /* Need to ensure SDA is high, to generate a falling edge to signify a RESTART condition */
         scl_high (controller); /* Take SCL high in preparation for the RESTART condition */
-        bit_bang_delay (T_SU_STA);
+        bit_bang_delay (controller, controller->timing.t_su_sta);
         sda_low (controller); /* Take SDA low to generate the RESTART condition */
-        bit_bang_delay (T_HD_STA);
+        bit_bang_delay (controller, controller->timing.t_hd_sta);
     }
 
     scl_low (controller); /* Take SCL low for the beginning of the 1st clock pulse */
@@ -319,6 +401,70 @@ static bool i2c_begin (bit_banged_i2c_controller_context_t *const controller,
 }
 
 
+/**
+ * @brief Determine the source to use for the bit-banged delays
+ * @details The TSC is only used when the CPU reports the TSC is invariant, i.e. runs at a constant rate independent of the
+ *          CPU frequency and power states. The TSC frequency is calibrated once per process against CLOCK_MONOTONIC_RAW.
+ * @param[out] controller The controller to set the delay source for
+ */
+static void select_delay_source (bit_banged_i2c_controller_context_t *const controller)
+{
+    static bool calibrated;
+    static bit_bang_delay_source_t calibrated_delay_source;
+    static double calibrated_delay_ticks_per_ns;
+
+    if (!calibrated)
+    {
+        calibrated_delay_source = BIT_BANG_DELAY_SOURCE_CLOCK;
+        calibrated_delay_ticks_per_ns = 1.0;
+
+#if defined (__x86_64__) || defined (__i386__)
+        const unsigned int invariant_tsc_edx_mask = 1U << 8;
+        unsigned int eax, ebx, ecx, edx;
+
+        if ((__get_cpuid (0x80000007, &eax, &ebx, &ecx, &edx) != 0) && ((edx & invariant_tsc_edx_mask) != 0))
+        {
+            const uint64_t start_ns = read_raw_clock_ns ();
+            const uint64_t start_tsc = __rdtsc ();
+            uint64_t end_ns;
+            uint64_t end_tsc;
+
+            do
+            {
+                end_ns = read_raw_clock_ns ();
+                end_tsc = __rdtsc ();
+            } while ((end_ns - start_ns) < TSC_CALIBRATION_NS);
+
+            if (end_tsc > start_tsc)
+            {
+                calibrated_delay_source = BIT_BANG_DELAY_SOURCE_TSC;
+                calibrated_delay_ticks_per_ns = (double) (end_tsc - start_tsc) / (double) (end_ns - start_ns);
+            }
+        }
+#endif
+
+        calibrated = true;
+    }
+
+    controller->delay_source = calibrated_delay_source;
+    controller->delay_ticks_per_ns = calibrated_delay_ticks_per_ns;
+}
+
+
+/**
+ * @brief Convert a delay in nanoseconds to delay source ticks, rounding up so the delay is never shorter than requested
+ * @param[in] controller The controller for the GPIO bit-banged interface, which selects the delay source
+ * @param[in] delay_ns The delay in nanoseconds
+ * @return The delay in delay source ticks
+ */
+static uint64_t delay_ns_to_ticks (const bit_banged_i2c_controller_context_t *const controller, const uint64_t delay_ns)
+{
+    const uint64_t delay_ticks = (uint64_t) ((double) delay_ns * controller->delay_ticks_per_ns);
+
+    return delay_ticks + 1;
+}
+
+
 /**
  * @brief Select either the Xilinx AXI IIC or GPIO bit-banged interface
  * @param[in] select_bit_banged When true selects the bit-banged interface, when false select the AXI IIC interface
@@ -330,6 +476,12 @@ void select_i2c_controller (const bool select_bit_banged, uint8_t *const gpio_re
 {
     controller->gpio_regs = gpio_regs;
 
+    /* Default to the I2C Standard Mode bus timing */
+    select_delay_source (controller);
+    bit_banged_i2c_set_scl_frequency (controller, I2C_STANDARD_MODE_SCL_FREQUENCY_HZ);
+    (void) memset (&controller->statistics, 0, sizeof (controller->statistics));
+    controller->gpio_write_ns = 0.0;
+
     /* Default to SMBus PEC disabled */
     (void) memset (controller->smbus_pec_enables, false, sizeof (controller->smbus_pec_enables));
 
@@ -349,6 +501,15 @@ void select_i2c_controller (const bool select_bit_banged, uint8_t *const gpio_re
             controller->gpio_data_out |= GPIO_DATA_SELECT_BIT_BANG_MASK;
         }
         write_reg32 (controller->gpio_regs, GPIO_DATA_OFFSET, controller->gpio_data_out);
+
+        /* Measure the average time for a GPIO data register write, by re-writing the unchanged output value */
+        const uint64_t start_ns = read_raw_clock_ns ();
+        for (uint32_t write_index = 0; write_index < NUM_GPIO_WRITE_MEASUREMENTS; write_index++)
+        {
+            write_reg32 (controller->gpio_regs, GPIO_DATA_OFFSET, controller->gpio_data_out);
+        }
+        (void) read_reg32 (controller->gpio_regs, GPIO_DATA_OFFSET);
+        controller->gpio_write_ns = (double) (read_raw_clock_ns () - start_ns) / (double) NUM_GPIO_WRITE_MEASUREMENTS;
     }
 
     /* Create the SMBus CRC look-up table, which uses the "CRC-8-CCITT" algorithm */
@@ -373,6 +534,63 @@ void select_i2c_controller (const bool select_bit_banged, uint8_t *const gpio_re
 }
 
 
+/**
+ * @brief Set the nominal SCL frequency used by the GPIO bit-banged interface
+ * @details Frequencies above the Standard Mode frequency use the Fast-mode bus timing. The achieved SCL frequency will be
+ *          lower than nominal, since the bus timing values are minimums and the GPIO register accesses add overhead.
+ * @param[in/out] controller The controller for the GPIO bit-banged interface
+ * @param[in] scl_frequency_hz The nominal SCL frequency, either I2C_STANDARD_MODE_SCL_FREQUENCY_HZ or
+ *                             I2C_FAST_MODE_SCL_FREQUENCY_HZ
+ */
+void bit_banged_i2c_set_scl_frequency (bit_banged_i2c_controller_context_t *const controller, const uint32_t scl_frequency_hz)
+{
+    const bit_bang_timing_t *const timing_ns =
+            (scl_frequency_hz > I2C_STANDARD_MODE_SCL_FREQUENCY_HZ) ? &fast_mode_timing_ns : &standard_mode_timing_ns;
+
+    controller->scl_frequency_hz =
+            (scl_frequency_hz > I2C_STANDARD_MODE_SCL_FREQUENCY_HZ) ? I2C_FAST_MODE_SCL_FREQUENCY_HZ : I2C_STANDARD_MODE_SCL_FREQUENCY_HZ;
+    controller->timing.t_rise   = delay_ns_to_ticks (controller, timing_ns->t_rise);
+    controller->timing.t_fall   = delay_ns_to_ticks (controller, timing_ns->t_fall);
+    controller->timing.t_buf    = delay_ns_to_ticks (controller, timing_ns->t_buf);
+    controller->timing.t_su_sta = delay_ns_to_ticks (controller, timing_ns->t_su_sta);
+    controller->timing.t_hd_sta = delay_ns_to_ticks (controller, timing_ns->t_hd_sta);
+    controller->timing.t_su_sto = delay_ns_to_ticks (controller, timing_ns->t_su_sto);
+    controller->timing.t_low    = delay_ns_to_ticks (controller, timing_ns->t_low);
+    controller->timing.t_high   = delay_ns_to_ticks (controller, timing_ns->t_high);
+}
+
+
+/**
+ * @brief Display the statistics for the I2C bus transactions performed using the GPIO bit-banged interface
+ * @details The achieved SCL frequency is the average over the time the bus was busy performing transactions.
+ * @param[in] controller The controller for the GPIO bit-banged interface
+ */
+void bit_banged_i2c_display_bus_statistics (const bit_banged_i2c_controller_context_t *const controller)
+{
+    const bit_bang_bus_statistics_t *const statistics = &controller->statistics;
+    const double bus_busy_secs = ((double) statistics->bus_busy_ticks / controller->delay_ticks_per_ns) / 1E9;
+
+    printf ("\nBit-banged I2C bus statistics for nominal SCL frequency %u KHz:\n", controller->scl_frequency_hz / 1000);
+    if (controller->delay_source == BIT_BANG_DELAY_SOURCE_TSC)
+    {
+        printf ("  Delay source         : invariant TSC at %.3f MHz\n", controller->delay_ticks_per_ns * 1E3);
+    }
+    else
+    {
+        printf ("  Delay source         : CLOCK_MONOTONIC_RAW\n");
+    }
+    printf ("  GPIO write time      : %.1f ns\n", controller->gpio_write_ns);
+    printf ("  SCL cycles           : %" PRIu64 "\n", statistics->num_scl_cycles);
+    printf ("  Transactions         : %" PRIu64 "\n", statistics->num_transactions);
+    printf ("  Bus busy time        : %.6f secs\n", bus_busy_secs);
+    if (bus_busy_secs > 0.0)
+    {
+        printf ("  Achieved SCL         : %.1f KHz\n", ((double) statistics->num_scl_cycles / bus_busy_secs) / 1E3);
+        printf ("  Transactions per sec : %.1f\n", (double) statistics->num_transactions / bus_busy_secs);
+    }
+}
+
+
 /**
  * @brief Perform a read from the I2C bus using the GPIO bit-banged interface
  * @param[in/out] controller The controller for the GPIO bit-banged interface
@@ -617,6 +835,69 @@ smbus_transfer_status_t bit_banged_smbus_read (bit_banged_i2c_controller_context
 }
 
 
+/**
+ * @brief Perform a SMBus WRITE of a fixed number of bytes, such as a Write Byte or Write Word
+ * @param[in/out] controller The controller for the GPIO bit-banged interface
+ * @param[in] i2c_slave_address 7-bit slave address to write to
+ * @param[in] command_code The SMBus command code to perform the write to.
+ * @param[in] num_data_bytes The number of bytes to write, which excludes any PEC byte
+ * @param[in] data The bytes to write to the SMBus slave.
+ * @return Indicates if the WRITE was successful or not.
+ */
+smbus_transfer_status_t bit_banged_smbus_write (bit_banged_i2c_controller_context_t *const controller,
+                                                const uint8_t i2c_slave_address,
+                                                const uint8_t command_code,
+                                                const size_t num_data_bytes, const uint8_t data[const num_data_bytes])
+{
+    smbus_transfer_status_t status = SMBUS_TRANSFER_SUCCESS;
+    size_t num_bytes_written;
+
+    /* Begin the message with a write operation for the command */
+    initialise_smbus_message_crc (controller, i2c_slave_address, command_code);
+    if (!i2c_begin (controller, i2c_slave_address, WRITE_OPERATION))
+    {
+        status = SMBUS_TRANSFER_WRITE_ADDRESS_NACK;
+    }
+
+    /* Transmit the command code */
+    if (status == SMBUS_TRANSFER_SUCCESS)
+    {
+        if (!i2c_transmit_byte (controller, command_code))
+        {
+            status = SMBUS_TRANSFER_WRITE_DATA_NACK;
+        }
+    }
+
+    /* Transmit the data bytes */
+    num_bytes_written = 0;
+    while ((status == SMBUS_TRANSFER_SUCCESS) && (num_bytes_written < num_data_bytes))
+    {
+        if (i2c_transmit_byte (controller, data[num_bytes_written]))
+        {
+            num_bytes_written++;
+        }
+        else
+        {
+            status = SMBUS_TRANSFER_WRITE_DATA_NACK;
+        }
+    }
+
+    /* Transmit the PEC byte, if enabled for the message */
+    if ((status == SMBUS_TRANSFER_SUCCESS) && controller->smbus_message_uses_crc)
+    {
+        if (!i2c_transmit_byte (controller, controller->smbus_crc))
+        {
+            status = SMBUS_TRANSFER_WRITE_DATA_NACK;
+        }
+    }
+
+    /* Always generate a STOP condition to free the I2C bus, regardless of if the SMBus message transfer was successful */
+    generate_i2c_stop (controller);
+
+    return status;
+}
+
+
 /**
  * @brief Perform a SMBus BLOCK READ, for a variable number of bytes
  * @param[in/out] controller The controller for the GPIO bit-banged interface
@@ -43,6 +43,49 @@ typedef enum
 extern const char *const smbus_transfer_status_descriptions[SMBUS_TRANSFER_ARRAY_SIZE];
 
 
+/* The nominal I2C SCL frequencies which may be selected */
+#define I2C_STANDARD_MODE_SCL_FREQUENCY_HZ 100000
+#define I2C_FAST_MODE_SCL_FREQUENCY_HZ     400000
+
+
+/* Defines the source used to time the delays for the I2C bus timing */
+typedef enum
+{
+    /* Reads CLOCK_MONOTONIC_RAW, used when an invariant TSC is not available */
+    BIT_BANG_DELAY_SOURCE_CLOCK,
+    /* Reads the invariant Time Stamp Counter, calibrated against CLOCK_MONOTONIC_RAW */
+    BIT_BANG_DELAY_SOURCE_TSC
+} bit_bang_delay_source_t;
+
+
+/* The I2C bus timing used for the delays, in ticks of the delay source */
+typedef struct
+{
+    uint64_t t_rise;
+    uint64_t t_fall;
+    uint64_t t_buf;
+    uint64_t t_su_sta;
+    uint64_t t_hd_sta;
+    uint64_t t_su_sto;
+    uint64_t t_low;
+    uint64_t t_high;
+} bit_bang_timing_t;
+
+
+/* Statistics on the I2C bus transfers, to allow the achieved SCL frequency and transaction rate to be reported */
+typedef struct
+{
+    /* The number of SCL clock cycles generated */
+    uint64_t num_scl_cycles;
+    /* The number of transactions, counted as the number of STOP conditions generated */
+    uint64_t num_transactions;
+    /* The total delay source ticks for which the bus was busy, from a START to a STOP condition */
+    uint64_t bus_busy_ticks;
+    /* The delay source ticks at the START condition of the current transaction */
+    uint64_t transaction_start_ticks;
+} bit_bang_bus_statistics_t;
+
+
 /* The context for a GPIO bit-banged I2C controller */
 typedef struct
 {
@@ -68,11 +111,25 @@ typedef struct
     uint8_t last_smbus_command_code;
     /* The last SMBus block Byte Count received, for recording diagnostic information for SMBUS_TRANSFER_INVALID_BLOCK_BYTE_COUNT */
     uint8_t last_smbus_block_byte_count;
+    /* The source used to time the delays, and its frequency */
+    bit_bang_delay_source_t delay_source;
+    double delay_ticks_per_ns;
+    /* The nominal SCL frequency the timing is for */
+    uint32_t scl_frequency_hz;
+    /* The I2C bus timing used for the delays */
+    bit_bang_timing_t timing;
+    /* The average time for a write to the GPIO data register, measured at initialisation. For diagnostics, since the delays
+     * for each SCL / SDA edge are timed from before the write to account for the MMIO write latency. */
+    double gpio_write_ns;
+    /* Statistics on the I2C bus transfers */
+    bit_bang_bus_statistics_t statistics;
 } bit_banged_i2c_controller_context_t;
 
 
 void select_i2c_controller (const bool select_bit_banged, uint8_t *const gpio_regs,
                             bit_banged_i2c_controller_context_t *const controller);
+void bit_banged_i2c_set_scl_frequency (bit_banged_i2c_controller_context_t *const controller, const uint32_t scl_frequency_hz);
+void bit_banged_i2c_display_bus_statistics (const bit_banged_i2c_controller_context_t *const controller);
 bool bit_banged_i2c_read (bit_banged_i2c_controller_context_t *const controller,
                           const uint8_t i2c_slave_address,
                           const size_t num_bytes, uint8_t data[const num_bytes],
@@ -91,6 +148,10 @@ smbus_transfer_status_t bit_banged_smbus_read (bit_banged_i2c_controller_context
                                                const uint8_t i2c_slave_address,
                                                const uint8_t command_code,
                                                const size_t num_data_bytes, uint8_t data[const num_data_bytes]);
+smbus_transfer_status_t bit_banged_smbus_write (bit_banged_i2c_controller_context_t *const controller,
+                                                const uint8_t i2c_slave_address,
+                                                const uint8_t command_code,
+                                                const size_t num_data_bytes, const uint8_t data[const num_data_bytes]);
 smbus_transfer_status_t bit_banged_smbus_block_read (bit_banged_i2c_controller_context_t *const controller,
                                                      const uint8_t i2c_slave_address,
                                                      const uint8_t command_code,
@@ -9,6 +9,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+#include <unistd.h>
+
 #include "i2c_bit_banged.h"
 #include "pmbus_access.h"
 #include "ltm4676a_access.h"
@@ -17,6 +19,49 @@
 #include "identify_pcie_fpga_design.h"
 
 
+/* Command line argument which sets the nominal SCL frequency used by the bit-banged I2C controller */
+static uint32_t arg_scl_frequency_hz = I2C_STANDARD_MODE_SCL_FREQUENCY_HZ;
+
+
+/**
+ * @brief Parse the command line arguments, storing the results in global variables
+ * @param[in] argc, argv Arguments passed to main
+ */
+static void parse_command_line_arguments (int argc, char *argv[])
+{
+    const char *const optstring = "f:?";
+    int option;
+    uint32_t scl_frequency_khz;
+    char junk;
+
+    option = getopt (argc, argv, optstring);
+    while (option != -1)
+    {
+        switch (option)
+        {
+        case 'f':
+            if ((sscanf (optarg, "%u%c", &scl_frequency_khz, &junk) != 1) ||
+                (((scl_frequency_khz * 1000) != I2C_STANDARD_MODE_SCL_FREQUENCY_HZ) &&
+                 ((scl_frequency_khz * 1000) != I2C_FAST_MODE_SCL_FREQUENCY_HZ)))
+            {
+                printf ("Error: Invalid scl_frequency_khz \"%s\"\n", optarg);
+                exit (EXIT_FAILURE);
+            }
+            arg_scl_frequency_hz = scl_frequency_khz * 1000;
+            break;
+
+        case '?':
+        default:
+            printf ("Usage %s [-f 100|400]\n", argv[0]);
+            printf ("  -f sets the nominal SCL frequency in KHz used for the bit-banged I2C controller\n");
+            exit (EXIT_FAILURE);
+            break;
+        }
+        option = getopt (argc, argv, optstring);
+    }
+}
+
+
 /**
  * @brief Display information by reading the fan control register in the CPLD
  * @details https://wiki.trenz-electronic.de/display/PD/TEF1001+CPLD#TEF1001CPLD-FAN1 documents the register information.
@@ -883,6 +928,7 @@ static void dump_tef1001_information (fpga_design_t *const design, struct pci_ac
 
     printf ("Using design %s in device %s\n", fpga_design_names[design->design_id], design->vfio_device->device_name);
     select_i2c_controller (true, design->bit_banged_i2c_gpio_regs, &controller);
+    bit_banged_i2c_set_scl_frequency (&controller, arg_scl_frequency_hz);
 
     dump_tef1001_fan_info (&controller);
     dump_ddr_temperature_information (&controller, pacc);
@@ -900,6 +946,8 @@ static void dump_tef1001_information (fpga_design_t *const design, struct pci_ac
         printf ("\n");
         display_xadc_samples (&xadc_collection);
     }
+
+    bit_banged_i2c_display_bus_statistics (&controller);
 }
 
 
@@ -907,6 +955,8 @@ int main (int argc, char *argv[])
 {
     fpga_designs_t designs;
 
+    parse_command_line_arguments (argc, argv);
+
     /* Open the FPGA designs which have an IOMMU group assigned */
     identify_pcie_fpga_designs (&designs);
 
@@ -12,12 +12,11 @@
 
 #include <stdio.h>
 
-/* The LTM4676A is a dual-channel DCDC converter, with channel specific sensors per-page */
-#define LTM4676A_NUM_PAGES 2
-
 /* Defines the LTM4676A sensors which are read and displayed.
  * The sensors with a PMBUS_COMMAND_* prefix are defined by the PMBus specification.
- * The sensors with a LTM4674A_COMMAND_MFR_* prefix are manufacturer specific. */
+ * The sensors with a LTM4674A_COMMAND_MFR_* prefix are manufacturer specific.
+ * The first LTM4676A_NUM_TELEMETRY_SENSORS entries are the telemetry, with the remaining entries being limits and set points
+ * which are not expected to change while scanning. */
 #define LTM4676A_NUM_SENSORS (sizeof (ltm4676a_sensor_definitions) / sizeof (ltm4676a_sensor_definitions[0]))
 static const pmbus_sensor_definition_t ltm4676a_sensor_definitions[] =
 {
@@ -318,3 +317,31 @@ void dump_ltm4676a_information (bit_banged_i2c_controller_context_t *const contr
         report_pmbus_transfer_failure (controller, status);
     }
 }
+
+
+/**
+ * @brief Initialise a schedule for repeatedly scanning the sensors of one DCDC LTM4676A
+ * @details Reads the PMBus capability first, so that PEC is enabled if supported.
+ * @param[in/out] controller The controller for the GPIO bit-banged interface
+ * @param[in] i2c_slave_address The I2C address of the LTM4676A to scan
+ * @param[in] telemetry_only When true only the telemetry sensors are scanned, to maximise the scan rate.
+ *                           When false all the sensors displayed by dump_ltm4676a_information() are scanned.
+ * @param[out] schedule The initialised schedule
+ * @return Indicates if the schedule was initialised successfully
+ */
+smbus_transfer_status_t ltm4676a_initialise_scan_schedule (bit_banged_i2c_controller_context_t *const controller,
+                                                           const uint8_t i2c_slave_address, const bool telemetry_only,
+                                                           pmbus_scan_schedule_t *const schedule)
+{
+    smbus_transfer_status_t status;
+    uint8_t capability;
+
+    status = read_pmbus_capability (controller, i2c_slave_address, &capability);
+    if (status == SMBUS_TRANSFER_SUCCESS)
+    {
+        status = pmbus_initialise_scan_schedule (controller, i2c_slave_address, LTM4676A_NUM_PAGES,
+                telemetry_only ? LTM4676A_NUM_TELEMETRY_SENSORS : LTM4676A_NUM_SENSORS, ltm4676a_sensor_definitions, schedule);
+    }
+
+    return status;
+}
@@ -11,6 +11,13 @@
 #include "pmbus_access.h"
 
 
+/* The LTM4676A is a dual-channel DCDC converter, with channel specific sensors per-page */
+#define LTM4676A_NUM_PAGES 2
+
+/* The number of telemetry sensors, which are at the start of the sensor definitions */
+#define LTM4676A_NUM_TELEMETRY_SENSORS 14
+
+
 /* PMBus command codes which are specific to a LTM4676A, which are "Manufacturer Specific" in the PMBus specification */
 #define LTM4676A_COMMAND_MFR_VOUT_PEAK          0xDD
 #define LTM4676A_COMMAND_MFR_VIN_PEAK           0xDE
@@ -31,6 +38,9 @@
 
 
 void dump_ltm4676a_information (bit_banged_i2c_controller_context_t *const controller, const uint8_t i2c_slave_address);
+smbus_transfer_status_t ltm4676a_initialise_scan_schedule (bit_banged_i2c_controller_context_t *const controller,
+                                                           const uint8_t i2c_slave_address, const bool telemetry_only,
+                                                           pmbus_scan_schedule_t *const schedule);
 
 
 #endif /* LTM4676A_ACCESS_H_ */
@@ -0,0 +1,462 @@
+/*
+ * @file ltm4676a_sensor_monitor.c
+ * @date 18 Oct 2026
+ * @author Chester Gillon
+ * @brief Continuously scan the sensors of the LTM4676A DCDC regulators on the TEF1001, for capturing transients
+ * @details
+ *   Uses the /fpga_tests/i2c_probe FPGA image. The default mode runs a background thread which scans the sensors of both
+ *   LTM4676A regulators back-to-back, or at the interval set by the -i option, and writes each timestamped sample to
+ *   standard out in CSV format. This allows the rails to be monitored while a different program applies a load,
+ *   e.g. DMA transfers.
+ *
+ *   The -b option instead benchmarks the loop rate of read_pmbus_sensors(), which uses one PAGE_PLUS_READ per paged
+ *   sensor, against pmbus_scan_sensors() which groups the sensor reads per page.
+ *
+ *   A lease on the IIC bus is held for the entire run, so that other processes using the VFIO multi process manager
+ *   which lease the IIC bus don't interleave their transfers with the sensor scans.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include <unistd.h>
+
+#include "i2c_bit_banged.h"
+#include "pmbus_access.h"
+#include "pmbus_sensor_monitor.h"
+#include "ltm4676a_access.h"
+#include "vfio_access.h"
+#include "transfer_timing.h"
+#include "identify_pcie_fpga_design.h"
+
+
+/* The LTM4676A regulators on the TEF1001 which are scanned */
+#define NUM_LTM4676A_DEVICES 2
+static const uint8_t ltm4676a_i2c_slave_addresses[NUM_LTM4676A_DEVICES] =
+{
+    0x40, /* U3 provides 4V and 1.5V */
+    0x4f  /* U4 provides 1V */
+};
+
+
+/* How long to wait for the lease on the IIC bus, when in use by another process */
+#define IIC_LEASE_WAIT_TIMEOUT_NS 60000000000UL
+
+
+/* The interval at which the main thread retrieves samples from the background thread */
+#define SAMPLE_POLL_INTERVAL_NS 100000000L
+
+
+/* Command line argument which sets the nominal SCL frequency used by the bit-banged I2C controller */
+static uint32_t arg_scl_frequency_hz = I2C_STANDARD_MODE_SCL_FREQUENCY_HZ;
+
+
+/* Command line argument which when true scans all sensors, rather than just the telemetry */
+static bool arg_all_sensors = false;
+
+
+/* Command line argument which when true performs the loop rate benchmark, rather than monitoring */
+static bool arg_benchmark = false;
+
+
+/* Command line argument which sets the number of loops for each method in the benchmark */
+static uint32_t arg_num_benchmark_loops = 20;
+
+
+/* Command line argument which sets the duration to monitor for. Zero means until Ctrl-C */
+static uint32_t arg_duration_secs = 10;
+
+
+/* Command line argument which sets the interval between scans in microseconds. Zero means scan back-to-back */
+static uint32_t arg_scan_interval_us = 0;
+
+
+/* Set true in a signal handler when Ctrl-C is used to request monitoring stops */
+static volatile bool monitor_stop_requested;
+
+
+/* The background monitor. Static due to the size of the sample ring */
+static pmbus_sensor_monitor_t monitor;
+
+
+/* Used to retrieve samples from the background monitor */
+static pmbus_sensor_sample_t retrieved_samples[PMBUS_MONITOR_SAMPLE_RING_SIZE];
+
+
+/**
+ * @brief Signal handler to request monitoring stops
+ * @param[in] sig Not used
+ */
+static void stop_monitor_handler (const int sig)
+{
+    monitor_stop_requested = true;
+}
+
+
+/**
+ * @brief Parse the command line arguments, storing the results in global variables
+ * @param[in] argc, argv Arguments passed to main
+ */
+static void parse_command_line_arguments (int argc, char *argv[])
+{
+    const char *const optstring = "f:abn:d:i:?";
+    int option;
+    uint32_t scl_frequency_khz;
+    char junk;
+
+    option = getopt (argc, argv, optstring);
+    while (option != -1)
+    {
+        switch (option)
+        {
+        case 'f':
+            if ((sscanf (optarg, "%u%c", &scl_frequency_khz, &junk) != 1) ||
+                (((scl_frequency_khz * 1000) != I2C_STANDARD_MODE_SCL_FREQUENCY_HZ) &&
+                 ((scl_frequency_khz * 1000) != I2C_FAST_MODE_SCL_FREQUENCY_HZ)))
+            {
+                printf ("Error: Invalid scl_frequency_khz \"%s\"\n", optarg);
+                exit (EXIT_FAILURE);
+            }
+            arg_scl_frequency_hz = scl_frequency_khz * 1000;
+            break;
+
+        case 'a':
+            arg_all_sensors = true;
+            break;
+
+        case 'b':
+            arg_benchmark = true;
+            break;
+
+        case 'n':
+            if ((sscanf (optarg, "%u%c", &arg_num_benchmark_loops, &junk) != 1) || (arg_num_benchmark_loops == 0))
+            {
+                printf ("Error: Invalid num_benchmark_loops \"%s\"\n", optarg);
+                exit (EXIT_FAILURE);
+            }
+            break;
+
+        case 'd':
+            if (sscanf (optarg, "%u%c", &arg_duration_secs, &junk) != 1)
+            {
+                printf ("Error: Invalid duration_secs \"%s\"\n", optarg);
+                exit (EXIT_FAILURE);
+            }
+            break;
+
+        case 'i':
+            if (sscanf (optarg, "%u%c", &arg_scan_interval_us, &junk) != 1)
+            {
+                printf ("Error: Invalid scan_interval_us \"%s\"\n", optarg);
+                exit (EXIT_FAILURE);
+            }
+            break;
+
+        case '?':
+        default:
+            printf ("Usage %s [-f 100|400] [-a] [-b] [-n <num_benchmark_loops>] [-d <duration_secs>] [-i <scan_interval_us>]\n",
+                    argv[0]);
+            printf ("  -f sets the nominal SCL frequency in KHz used for the bit-banged I2C controller\n");
+            printf ("  -a scans all sensors, rather than just the telemetry\n");
+            printf ("  -b benchmarks the loop rate of the unscheduled and scheduled sensor reads, rather than monitoring\n");
+            printf ("  -n sets the number of loops for each method in the benchmark\n");
+            printf ("  -d sets the duration to monitor for. Zero means until Ctrl-C\n");
+            printf ("  -i sets the interval between scans. Zero means scan back-to-back\n");
+            exit (EXIT_FAILURE);
+            break;
+        }
+        option = getopt (argc, argv, optstring);
+    }
+}
+
+
+/**
+ * @brief Benchmark the loop rate of reading the sensors of one LTM4676A
+ * @details Compares read_pmbus_sensors(), which re-reads VOUT_MODE and uses PAGE_PLUS_READ for each paged sensor,
+ *          against pmbus_scan_sensors().
+ * @param[in/out] controller The controller for the GPIO bit-banged interface
+ * @param[in/out] schedule The scan schedule for the LTM4676A
+ * @return Returns true if the benchmark completed without a SMBus failure
+ */
+static bool benchmark_ltm4676a_loop_rate (bit_banged_i2c_controller_context_t *const controller,
+                                          pmbus_scan_schedule_t *const schedule)
+{
+    const char *const method_names[] = {"read_pmbus_sensors", "pmbus_scan_sensors"};
+    const size_t num_methods = sizeof (method_names) / sizeof (method_names[0]);
+    pmbus_sensor_reading_t readings[PMBUS_MAX_SCAN_SENSORS];
+    smbus_transfer_status_t status = SMBUS_TRANSFER_SUCCESS;
+
+    printf ("\nLTM4676A at I2C address 0x%02x scanning %zu sensors over %zu pages:\n",
+            schedule->i2c_slave_address, schedule->num_sensors, schedule->num_pages);
+    for (size_t method_index = 0; (status == SMBUS_TRANSFER_SUCCESS) && (method_index < num_methods); method_index++)
+    {
+        const uint64_t start_transactions = controller->statistics.num_transactions;
+        const int64_t start_time = get_monotonic_time ();
+        uint32_t loop_index;
+
+        for (loop_index = 0; (status == SMBUS_TRANSFER_SUCCESS) && (loop_index < arg_num_benchmark_loops); loop_index++)
+        {
+            if (method_index == 0)
+            {
+                status = read_pmbus_sensors (controller, schedule->i2c_slave_address, schedule->num_pages,
+                        schedule->num_sensors, schedule->sensor_definitions, readings);
+            }
+            else
+            {
+                status = pmbus_scan_sensors (controller, schedule, readings);
+            }
+        }
+
+        if (status == SMBUS_TRANSFER_SUCCESS)
+        {
+            const double loop_secs = ((double) (get_monotonic_time () - start_time) / 1E9) / (double) arg_num_benchmark_loops;
+            const double transactions_per_loop =
+                    (double) (controller->statistics.num_transactions - start_transactions) / (double) arg_num_benchmark_loops;
+
+            printf ("  %-18s : %8.3f ms per loop  %7.2f loops/sec  %5.1f SMBus transactions per loop\n",
+                    method_names[method_index], loop_secs * 1E3, 1.0 / loop_secs, transactions_per_loop);
+        }
+        else
+        {
+            report_pmbus_transfer_failure (controller, status);
+        }
+    }
+
+    return status == SMBUS_TRANSFER_SUCCESS;
+}
+
+
+/**
+ * @brief Write the CSV header for the samples
+ * @param[in] schedule The scan schedule, which defines the sensors. The same for all LTM4676A devices.
+ */
+static void write_csv_header (const pmbus_scan_schedule_t *const schedule)
+{
+    printf ("time_secs,i2c_address,scan_us,status");
+    for (size_t sensor_index = 0; sensor_index < schedule->num_sensors; sensor_index++)
+    {
+        const pmbus_sensor_definition_t *const definition = &schedule->sensor_definitions[sensor_index];
+
+        if (definition->paged)
+        {
+            for (size_t page_number = 0; page_number < schedule->num_pages; page_number++)
+            {
+                printf (",\"%s page %zu (%s)\"", definition->name, page_number, definition->units);
+            }
+        }
+        else
+        {
+            printf (",\"%s (%s)\"", definition->name, definition->units);
+        }
+    }
+    printf ("\n");
+}
+
+
+/**
+ * @brief Write one sample in CSV format
+ * @param[in] schedules The scan schedules for the devices
+ * @param[in] start_time The monotonic time monitoring started, which sample times are relative to
+ * @param[in] sample The sample to write
+ */
+static void write_csv_sample (pmbus_scan_schedule_t *const schedules[const NUM_LTM4676A_DEVICES],
+                              const int64_t start_time, const pmbus_sensor_sample_t *const sample)
+{
+    const pmbus_scan_schedule_t *const schedule = schedules[sample->device_index];
+
+    printf ("%.6f,0x%02x,%.1f,", (double) (sample->timestamp_ns - start_time) / 1E9, schedule->i2c_slave_address,
+            (double) sample->scan_duration_ns / 1E3);
+    if (sample->status == SMBUS_TRANSFER_SUCCESS)
+    {
+        printf ("OK");
+        for (size_t sensor_index = 0; sensor_index < schedule->num_sensors; sensor_index++)
+        {
+            const size_t num_readings = schedule->sensor_definitions[sensor_index].paged ? schedule->num_pages : 1;
+
+            for (size_t page_number = 0; page_number < num_readings; page_number++)
+            {
+                printf (",%.4f", sample->readings[sensor_index].scaled_sensor_values[page_number]);
+            }
+        }
+    }
+    else
+    {
+        printf ("\"command 0x%02x %s\"", sample->failed_command_code, smbus_transfer_status_descriptions[sample->status]);
+    }
+    printf ("\n");
+}
+
+
+/**
+ * @brief Monitor the LTM4676A sensors using a background thread, writing the samples to standard out
+ * @param[in/out] controller The controller for the GPIO bit-banged interface
+ * @param[in/out] schedules The scan schedules for the devices
+ */
+static void monitor_ltm4676a_sensors (bit_banged_i2c_controller_context_t *const controller,
+                                      pmbus_scan_schedule_t *const schedules[const NUM_LTM4676A_DEVICES])
+{
+    const struct timespec poll_interval =
+    {
+        .tv_sec = SAMPLE_POLL_INTERVAL_NS / 1000000000L,
+        .tv_nsec = SAMPLE_POLL_INTERVAL_NS % 1000000000L
+    };
+    uint64_t num_samples[NUM_LTM4676A_DEVICES] = {0};
+    int64_t total_scan_ns[NUM_LTM4676A_DEVICES] = {0};
+    int64_t max_scan_ns[NUM_LTM4676A_DEVICES] = {0};
+    struct sigaction action;
+    size_t num_retrieved;
+    bool monitor_running;
+    int rc;
+
+    memset (&action, 0, sizeof (action));
+    action.sa_handler = stop_monitor_handler;
+    action.sa_flags = SA_RESTART;
+    rc = sigaction (SIGINT, &action, NULL);
+    if (rc != 0)
+    {
+        printf ("Error: sigaction failed\n");
+        exit (EXIT_FAILURE);
+    }
+
+    write_csv_header (schedules[0]);
+    const int64_t start_time = get_monotonic_time ();
+    const int64_t stop_time = start_time + ((int64_t) arg_duration_secs * 1000000000L);
+    pmbus_sensor_monitor_start (&monitor, controller, NUM_LTM4676A_DEVICES, schedules, (int64_t) arg_scan_interval_us * 1000);
+
+    monitor_running = true;
+    do
+    {
+        if (monitor_running)
+        {
+            clock_nanosleep (CLOCK_MONOTONIC, 0, &poll_interval, NULL);
+            if (monitor_stop_requested || ((arg_duration_secs > 0) && (get_monotonic_time () >= stop_time)))
+            {
+                /* Once stopped the remaining samples are retrieved */
+                pmbus_sensor_monitor_stop (&monitor);
+                monitor_running = false;
+            }
+        }
+
+        num_retrieved = pmbus_sensor_monitor_get_samples (&monitor, PMBUS_MONITOR_SAMPLE_RING_SIZE, retrieved_samples);
+        for (size_t sample_index = 0; sample_index < num_retrieved; sample_index++)
+        {
+            const pmbus_sensor_sample_t *const sample = &retrieved_samples[sample_index];
+
+            write_csv_sample (schedules, start_time, sample);
+            if (sample->status == SMBUS_TRANSFER_SUCCESS)
+            {
+                num_samples[sample->device_index]++;
+                total_scan_ns[sample->device_index] += sample->scan_duration_ns;
+                if (sample->scan_duration_ns > max_scan_ns[sample->device_index])
+                {
+                    max_scan_ns[sample->device_index] = sample->scan_duration_ns;
+                }
+            }
+        }
+    } while (monitor_running || (num_retrieved > 0));
+
+    /* Report the summary to standard error, so doesn't get mixed with the CSV samples */
+    const double monitor_secs = (double) (get_monotonic_time () - start_time) / 1E9;
+    for (uint32_t device_index = 0; device_index < NUM_LTM4676A_DEVICES; device_index++)
+    {
+        const pmbus_scan_schedule_t *const schedule = schedules[device_index];
+
+        if (num_samples[device_index] > 0)
+        {
+            fprintf (stderr, "LTM4676A 0x%02x : %" PRIu64 " samples at %.2f Hz  mean scan %.3f ms  max scan %.3f ms  %" PRIu64
+                    " PAGE writes\n",
+                    schedule->i2c_slave_address, num_samples[device_index], (double) num_samples[device_index] / monitor_secs,
+                    ((double) total_scan_ns[device_index] / (double) num_samples[device_index]) / 1E6,
+                    (double) max_scan_ns[device_index] / 1E6, schedule->num_page_selections);
+        }
+    }
+    fprintf (stderr, "%" PRIu64 " failed scans  %" PRIu64 " samples dropped\n",
+            monitor.num_failed_scans, monitor.num_samples_dropped);
+}
+
+
+int main (int argc, char *argv[])
+{
+    fpga_designs_t designs;
+    bit_banged_i2c_controller_context_t controller = {0};
+    pmbus_scan_schedule_t schedule_storage[NUM_LTM4676A_DEVICES];
+    pmbus_scan_schedule_t *schedules[NUM_LTM4676A_DEVICES];
+    smbus_transfer_status_t status;
+    fpga_design_t *selected_design = NULL;
+    uint32_t iic_lease_id;
+    bool success = true;
+
+    parse_command_line_arguments (argc, argv);
+
+    /* Open the FPGA designs which have an IOMMU group assigned */
+    identify_pcie_fpga_designs (&designs);
+
+    /* Use the first FPGA design which has the required I2C peripherals */
+    for (uint32_t design_index = 0; (selected_design == NULL) && (design_index < designs.num_identified_designs); design_index++)
+    {
+        fpga_design_t *const design = &designs.designs[design_index];
+
+        if ((design->iic_regs != NULL) && (design->bit_banged_i2c_gpio_regs != NULL))
+        {
+            selected_design = design;
+        }
+    }
+
+    if (selected_design == NULL)
+    {
+        printf ("No FPGA design with a bit-banged I2C controller found\n");
+        close_pcie_fpga_designs (&designs);
+        exit (EXIT_FAILURE);
+    }
+
+    fprintf (stderr, "Using design %s in device %s\n",
+            fpga_design_names[selected_design->design_id], selected_design->vfio_device->device_name);
+    if (!vfio_acquire_resource_lease (selected_design->vfio_device, VFIO_RESOURCE_IIC, 0,
+            VFIO_RESOURCE_LEASE_INFINITE_NS, IIC_LEASE_WAIT_TIMEOUT_NS, &iic_lease_id))
+    {
+        printf ("Timed out waiting for lease on IIC bus in PCI device %s\n", selected_design->vfio_device->device_name);
+        close_pcie_fpga_designs (&designs);
+        exit (EXIT_FAILURE);
+    }
+    select_i2c_controller (true, selected_design->bit_banged_i2c_gpio_regs, &controller);
+    bit_banged_i2c_set_scl_frequency (&controller, arg_scl_frequency_hz);
+
+    for (uint32_t device_index = 0; success && (device_index < NUM_LTM4676A_DEVICES); device_index++)
+    {
+        schedules[device_index] = &schedule_storage[device_index];
+        status = ltm4676a_initialise_scan_schedule (&controller, ltm4676a_i2c_slave_addresses[device_index], !arg_all_sensors,
+                schedules[device_index]);
+        if (status != SMBUS_TRANSFER_SUCCESS)
+        {
+            printf ("LTM4676A at I2C address 0x%02x:\n", ltm4676a_i2c_slave_addresses[device_index]);
+            report_pmbus_transfer_failure (&controller, status);
+            success = false;
+        }
+    }
+
+    if (success)
+    {
+        if (arg_benchmark)
+        {
+            for (uint32_t device_index = 0; success && (device_index < NUM_LTM4676A_DEVICES); device_index++)
+            {
+                success = benchmark_ltm4676a_loop_rate (&controller, schedules[device_index]);
+            }
+            bit_banged_i2c_display_bus_statistics (&controller);
+        }
+        else
+        {
+            monitor_ltm4676a_sensors (&controller, schedules);
+        }
+    }
+
+    /* The lease has no time limit, so can't have expired */
+    (void) vfio_release_resource_lease (selected_design->vfio_device, iic_lease_id);
+    close_pcie_fpga_designs (&designs);
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
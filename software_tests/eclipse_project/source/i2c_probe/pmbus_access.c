@@ -18,6 +18,7 @@
 
 #include <math.h>
 #include <string.h>
+#include <stdlib.h>
 #include <stdio.h>
 
 
@@ -247,32 +248,22 @@ static inline int32_t pmbus_extract_twos_complement (const uint32_t word,
 
 
 /**
- * @brief Read the sensor readings from a PMBus device
+ * @brief Read the VOUT_MODE setting for each page of a PMBus device, to be able to scale PMBUS_SENSOR_FORMAT_LINEAR_16U sensors
  * @param[in/out] controller The controller for the GPIO bit-banged interface
  * @param[in] i2c_slave_address 7-bit slave address of the PMBus device
- * @param[in] num_pages The number of pages in the PMBus device, for sensors which are per-page
- * @param[in] num_sensors The number of sensors to read in the PMBus device
- * @param[in] sensor_definitions The definitions of the sensors to read.
- * @param[out] sensor_readings The sensor readings obtained from the PMBus device
- * @return Returns the overall status of reading the sensors:
- *         - SMBUS_TRANSFER_SUCCESS means all sensor values were read.
- *         - Any other value indicates the reading of the sensors values was aborted due to a SMBus error.
- *           The number of successfully read sensors before the error is not reported.
+ * @param[in] num_pages The number of pages in the PMBus device
+ * @param[out] vout_mode_scalings The scaling for each page
+ * @return Indicates if the VOUT_MODE was read successfully for all pages.
  */
-smbus_transfer_status_t read_pmbus_sensors (bit_banged_i2c_controller_context_t *const controller,
-                                            const uint8_t i2c_slave_address,
-                                            const size_t num_pages,
-                                            const size_t num_sensors,
-                                            const pmbus_sensor_definition_t sensor_definitions[const num_sensors],
-                                            pmbus_sensor_reading_t sensor_readings[const num_sensors])
+static smbus_transfer_status_t read_pmbus_vout_mode_scalings (bit_banged_i2c_controller_context_t *const controller,
+                                                              const uint8_t i2c_slave_address,
+                                                              const size_t num_pages,
+                                                              double vout_mode_scalings[const PMBUS_MAX_PAGES])
 {
     smbus_transfer_status_t status = SMBUS_TRANSFER_SUCCESS;
     uint8_t vout_mode_byte;
-    double vout_mode_scalings[PMBUS_MAX_PAGES];
     uint8_t page_number;
-    size_t sensor_index;
 
-    /* First read the VOUT_MODE setting for each page, to be able to scale PMBUS_SENSOR_FORMAT_LINEAR_16U sensors */
     for (page_number = 0; (status == SMBUS_TRANSFER_SUCCESS) && (page_number < num_pages); page_number++)
     {
         status = pmbus_paged_read (controller, i2c_slave_address, page_number, PMBUS_COMMAND_VOUT_MODE,
@@ -296,6 +287,78 @@ smbus_transfer_status_t read_pmbus_sensors (bit_banged_i2c_controller_context_t
         }
     }
 
+    return status;
+}
+
+
+/**
+ * @brief Scale the raw values read from one PMBus sensor
+ * @param[in] num_pages The number of pages in the PMBus device, for sensors which are per-page
+ * @param[in] definition The definition of the sensor
+ * @param[in] vout_mode_scalings The scaling for each page, used for PMBUS_SENSOR_FORMAT_LINEAR_16U sensors
+ * @param[in/out] reading The sensor reading to convert the raw values to scaled values for
+ */
+static void scale_pmbus_sensor_reading (const size_t num_pages,
+                                        const pmbus_sensor_definition_t *const definition,
+                                        const double vout_mode_scalings[const PMBUS_MAX_PAGES],
+                                        pmbus_sensor_reading_t *const reading)
+{
+    const size_t num_populated_readings = definition->paged ? num_pages : 1;
+    uint8_t page_number;
+
+    for (page_number = 0; page_number < num_populated_readings; page_number++)
+    {
+        const uint16_t raw_sensor_value = reading->raw_sensor_values[page_number];
+
+        switch (definition->sensor_format)
+        {
+        case PMBUS_SENSOR_FORMAT_LINEAR_5S_11S:
+            {
+                const int32_t exponent = pmbus_extract_twos_complement (raw_sensor_value, 5, 11);
+                const int32_t mantissa = pmbus_extract_twos_complement (raw_sensor_value, 11, 0);
+
+                reading->scaled_sensor_values[page_number] = (double) mantissa * pow (2.0, (double) exponent);
+            }
+            break;
+
+        case PMBUS_SENSOR_FORMAT_LINEAR_16U:
+            reading->scaled_sensor_values[page_number] = (double) raw_sensor_value * vout_mode_scalings[page_number];
+            break;
+        }
+    }
+}
+
+
+/**
+ * @brief Read the sensor readings from a PMBus device
+ * @details Each paged sensor is read using PAGE_PLUS_READ, which doesn't change the PAGE selected in the PMBus device.
+ *          pmbus_scan_sensors() can be used instead when the sensors are to be polled repeatedly.
+ * @param[in/out] controller The controller for the GPIO bit-banged interface
+ * @param[in] i2c_slave_address 7-bit slave address of the PMBus device
+ * @param[in] num_pages The number of pages in the PMBus device, for sensors which are per-page
+ * @param[in] num_sensors The number of sensors to read in the PMBus device
+ * @param[in] sensor_definitions The definitions of the sensors to read.
+ * @param[out] sensor_readings The sensor readings obtained from the PMBus device
+ * @return Returns the overall status of reading the sensors:
+ *         - SMBUS_TRANSFER_SUCCESS means all sensor values were read.
+ *         - Any other value indicates the reading of the sensors values was aborted due to a SMBus error.
+ *           The number of successfully read sensors before the error is not reported.
+ */
+smbus_transfer_status_t read_pmbus_sensors (bit_banged_i2c_controller_context_t *const controller,
+                                            const uint8_t i2c_slave_address,
+                                            const size_t num_pages,
+                                            const size_t num_sensors,
+                                            const pmbus_sensor_definition_t sensor_definitions[const num_sensors],
+                                            pmbus_sensor_reading_t sensor_readings[const num_sensors])
+{
+    smbus_transfer_status_t status;
+    double vout_mode_scalings[PMBUS_MAX_PAGES];
+    uint8_t page_number;
+    size_t sensor_index;
+
+    /* First read the VOUT_MODE setting for each page, to be able to scale PMBUS_SENSOR_FORMAT_LINEAR_16U sensors */
+    status = read_pmbus_vout_mode_scalings (controller, i2c_slave_address, num_pages, vout_mode_scalings);
+
     /* Read the raw values from all the sensors */
     for (sensor_index = 0; (status == SMBUS_TRANSFER_SUCCESS) && (sensor_index < num_sensors); sensor_index++)
     {
@@ -322,31 +385,151 @@ smbus_transfer_status_t read_pmbus_sensors (bit_banged_i2c_controller_context_t
         /* Scale the raw sensor values */
         for (sensor_index = 0; sensor_index < num_sensors; sensor_index++)
         {
-            const pmbus_sensor_definition_t *const definition = &sensor_definitions[sensor_index];
-            pmbus_sensor_reading_t *const reading = &sensor_readings[sensor_index];
-            const size_t num_populated_readings = definition->paged ? num_pages : 1;
+            scale_pmbus_sensor_reading (num_pages, &sensor_definitions[sensor_index], vout_mode_scalings,
+                    &sensor_readings[sensor_index]);
+        }
+    }
+
+    return status;
+}
+
+
+/**
+ * @brief Initialise a schedule for repeatedly scanning the sensors of a PMBus device
+ * @details The sensors are grouped into those which are not paged, and those which are read for each page.
+ *          The VOUT_MODE scaling is read once when the schedule is initialised, rather than on each scan, on the assumption
+ *          that the VOUT_MODE isn't changed while the sensors are being scanned.
+ *
+ *          Any PEC enable for the PMBus device must have been set before calling this function.
+ * @param[in/out] controller The controller for the GPIO bit-banged interface
+ * @param[in] i2c_slave_address 7-bit slave address of the PMBus device
+ * @param[in] num_pages The number of pages in the PMBus device, for sensors which are per-page
+ * @param[in] num_sensors The number of sensors to scan in the PMBus device
+ * @param[in] sensor_definitions The definitions of the sensors to scan. Must remain valid while the schedule is used.
+ * @param[out] schedule The initialised schedule
+ * @return Indicates if the VOUT_MODE was read successfully, in which case the schedule may be used.
+ */
+smbus_transfer_status_t pmbus_initialise_scan_schedule (bit_banged_i2c_controller_context_t *const controller,
+                                                        const uint8_t i2c_slave_address,
+                                                        const size_t num_pages,
+                                                        const size_t num_sensors,
+                                                        const pmbus_sensor_definition_t sensor_definitions[const num_sensors],
+                                                        pmbus_scan_schedule_t *const schedule)
+{
+    if ((num_pages > PMBUS_MAX_PAGES) || (num_sensors > PMBUS_MAX_SCAN_SENSORS))
+    {
+        printf ("num_pages=%zu or num_sensors=%zu exceeds the maximum supported for a scan schedule\n", num_pages, num_sensors);
+        exit (EXIT_FAILURE);
+    }
+
+    memset (schedule, 0, sizeof (*schedule));
+    schedule->i2c_slave_address = i2c_slave_address;
+    schedule->num_pages = num_pages;
+    schedule->num_sensors = num_sensors;
+    schedule->sensor_definitions = sensor_definitions;
+    for (size_t sensor_index = 0; sensor_index < num_sensors; sensor_index++)
+    {
+        if (sensor_definitions[sensor_index].paged)
+        {
+            schedule->paged_sensor_indices[schedule->num_paged_sensors] = sensor_index;
+            schedule->num_paged_sensors++;
+        }
+        else
+        {
+            schedule->unpaged_sensor_indices[schedule->num_unpaged_sensors] = sensor_index;
+            schedule->num_unpaged_sensors++;
+        }
+    }
+
+    /* The PAGE currently selected in the PMBus device isn't known until the first scan selects one */
+    schedule->page_selected = false;
+
+    return read_pmbus_vout_mode_scalings (controller, i2c_slave_address, num_pages, schedule->vout_mode_scalings);
+}
+
+
+/**
+ * @brief Perform one scan of the sensors of a PMBus device, using a schedule to minimise the SMBus transactions
+ * @details Compared to read_pmbus_sensors() which uses one PAGE_PLUS_READ per paged sensor reading:
+ *          a. The PAGE is written once, and then all the paged sensors for that page are read using a plain SMBus read.
+ *             A SMBus read of a word is 6 bytes on the bus including the PEC, compared to 9 bytes for a PAGE_PLUS_READ.
+ *          b. The pages are visited starting with the PAGE left selected by the previous scan, so the PAGE only needs to be
+ *             written (num_pages - 1) times per scan once the schedule is running.
+ *          c. The VOUT_MODE scaling is not re-read on each scan.
+ *
+ *          This does leave the PAGE in the PMBus device changed. If a SMBus transfer fails the PAGE selected in the PMBus
+ *          device is treated as unknown, so it is written again on the next scan.
+ * @param[in/out] controller The controller for the GPIO bit-banged interface
+ * @param[in/out] schedule The schedule for the PMBus device, which tracks the PAGE selected
+ * @param[out] sensor_readings The sensor readings obtained from the PMBus device, indexed the same as the sensor definitions
+ *                             used to initialise the schedule
+ * @return Returns the overall status of the scan:
+ *         - SMBUS_TRANSFER_SUCCESS means all sensor values were read.
+ *         - Any other value indicates the scan was aborted due to a SMBus error.
+ */
+smbus_transfer_status_t pmbus_scan_sensors (bit_banged_i2c_controller_context_t *const controller,
+                                            pmbus_scan_schedule_t *const schedule,
+                                            pmbus_sensor_reading_t sensor_readings[const PMBUS_MAX_SCAN_SENSORS])
+{
+    smbus_transfer_status_t status = SMBUS_TRANSFER_SUCCESS;
+    const pmbus_sensor_definition_t *definition;
+    pmbus_sensor_reading_t *reading;
+    size_t schedule_index;
+    size_t page_offset;
+    uint8_t page_number;
 
-            for (page_number = 0; page_number < num_populated_readings; page_number++)
+    /* Read the sensors which are not paged, which don't depend upon the PAGE selected */
+    for (schedule_index = 0; (status == SMBUS_TRANSFER_SUCCESS) && (schedule_index < schedule->num_unpaged_sensors);
+            schedule_index++)
+    {
+        definition = &schedule->sensor_definitions[schedule->unpaged_sensor_indices[schedule_index]];
+        reading = &sensor_readings[schedule->unpaged_sensor_indices[schedule_index]];
+        status = bit_banged_smbus_read (controller, schedule->i2c_slave_address, definition->command_code,
+                sizeof (reading->raw_sensor_values[0]), (uint8_t *) &reading->raw_sensor_values[0]);
+    }
+
+    /* Read the paged sensors, grouped per page. Starts with the PAGE selected by the previous scan */
+    const uint8_t first_page = schedule->page_selected ? schedule->selected_page : 0;
+    for (page_offset = 0;
+         (status == SMBUS_TRANSFER_SUCCESS) && (schedule->num_paged_sensors > 0) && (page_offset < schedule->num_pages);
+         page_offset++)
+    {
+        page_number = (uint8_t) ((first_page + page_offset) % schedule->num_pages);
+
+        if ((!schedule->page_selected) || (schedule->selected_page != page_number))
+        {
+            status = bit_banged_smbus_write (controller, schedule->i2c_slave_address, PMBUS_COMMAND_PAGE,
+                    sizeof (page_number), &page_number);
+            if (status == SMBUS_TRANSFER_SUCCESS)
             {
-                const uint16_t raw_sensor_value = reading->raw_sensor_values[page_number];
-
-                switch (definition->sensor_format)
-                {
-                case PMBUS_SENSOR_FORMAT_LINEAR_5S_11S:
-                    {
-                        const int32_t exponent = pmbus_extract_twos_complement (raw_sensor_value, 5, 11);
-                        const int32_t mantissa = pmbus_extract_twos_complement (raw_sensor_value, 11, 0);
-
-                        reading->scaled_sensor_values[page_number] = (double) mantissa * pow (2.0, (double) exponent);
-                    }
-                    break;
-
-                case PMBUS_SENSOR_FORMAT_LINEAR_16U:
-                    reading->scaled_sensor_values[page_number] = (double) raw_sensor_value * vout_mode_scalings[page_number];
-                    break;
-                }
+                schedule->page_selected = true;
+                schedule->selected_page = page_number;
+                schedule->num_page_selections++;
             }
         }
+
+        for (schedule_index = 0; (status == SMBUS_TRANSFER_SUCCESS) && (schedule_index < schedule->num_paged_sensors);
+                schedule_index++)
+        {
+            definition = &schedule->sensor_definitions[schedule->paged_sensor_indices[schedule_index]];
+            reading = &sensor_readings[schedule->paged_sensor_indices[schedule_index]];
+            status = bit_banged_smbus_read (controller, schedule->i2c_slave_address, definition->command_code,
+                    sizeof (reading->raw_sensor_values[page_number]), (uint8_t *) &reading->raw_sensor_values[page_number]);
+        }
+    }
+
+    if (status == SMBUS_TRANSFER_SUCCESS)
+    {
+        for (size_t sensor_index = 0; sensor_index < schedule->num_sensors; sensor_index++)
+        {
+            scale_pmbus_sensor_reading (schedule->num_pages, &schedule->sensor_definitions[sensor_index],
+                    schedule->vout_mode_scalings, &sensor_readings[sensor_index]);
+        }
+        schedule->num_scans++;
+    }
+    else
+    {
+        schedule->page_selected = false;
     }
 
     return status;
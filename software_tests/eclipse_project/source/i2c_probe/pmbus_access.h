@@ -12,6 +12,7 @@
 
 
 /* The command codes defined in the PMBus specification */
+#define PMBUS_COMMAND_PAGE                0x00
 #define PMBUS_COMMAND_PAGE_PLUS_READ      0x06
 #define PMBUS_COMMAND_WRITE_PROTECT       0x10
 #define PMBUS_COMMAND_CAPABILITY          0x19
@@ -91,6 +92,37 @@ typedef struct
 } pmbus_sensor_reading_t;
 
 
+/* Used to set a compile time maximum number of sensors which can be in a scan schedule */
+#define PMBUS_MAX_SCAN_SENSORS 32
+
+/* A schedule for repeatedly scanning the sensors of one PMBus device, which groups the sensor reads per page */
+typedef struct
+{
+    /* 7-bit slave address of the PMBus device */
+    uint8_t i2c_slave_address;
+    /* The number of pages in the PMBus device, for sensors which are per-page */
+    size_t num_pages;
+    /* The number of sensors to scan */
+    size_t num_sensors;
+    /* The definitions of the sensors to scan */
+    const pmbus_sensor_definition_t *sensor_definitions;
+    /* The VOUT_MODE scaling for each page, read when the schedule is initialised */
+    double vout_mode_scalings[PMBUS_MAX_PAGES];
+    /* The indices into sensor_definitions[] of the sensors which are not paged, and are read once per scan */
+    size_t num_unpaged_sensors;
+    size_t unpaged_sensor_indices[PMBUS_MAX_SCAN_SENSORS];
+    /* The indices into sensor_definitions[] of the sensors which are paged, and are read for each page per scan */
+    size_t num_paged_sensors;
+    size_t paged_sensor_indices[PMBUS_MAX_SCAN_SENSORS];
+    /* When true selected_page is the PAGE which has been selected in the PMBus device */
+    bool page_selected;
+    uint8_t selected_page;
+    /* The number of PAGE writes performed, and the number of successful scans, for reporting */
+    uint64_t num_page_selections;
+    uint64_t num_scans;
+} pmbus_scan_schedule_t;
+
+
 smbus_transfer_status_t pmbus_paged_read (bit_banged_i2c_controller_context_t *const controller,
                                           const uint8_t i2c_slave_address,
                                           const uint8_t page_number,
@@ -111,6 +143,15 @@ smbus_transfer_status_t read_pmbus_sensors (bit_banged_i2c_controller_context_t
                                             const size_t num_sensors,
                                             const pmbus_sensor_definition_t sensor_definitions[const num_sensors],
                                             pmbus_sensor_reading_t sensor_readings[const num_sensors]);
+smbus_transfer_status_t pmbus_initialise_scan_schedule (bit_banged_i2c_controller_context_t *const controller,
+                                                        const uint8_t i2c_slave_address,
+                                                        const size_t num_pages,
+                                                        const size_t num_sensors,
+                                                        const pmbus_sensor_definition_t sensor_definitions[const num_sensors],
+                                                        pmbus_scan_schedule_t *const schedule);
+smbus_transfer_status_t pmbus_scan_sensors (bit_banged_i2c_controller_context_t *const controller,
+                                            pmbus_scan_schedule_t *const schedule,
+                                            pmbus_sensor_reading_t sensor_readings[const PMBUS_MAX_SCAN_SENSORS]);
 void display_pmbus_sensors (const size_t num_pages,
                             const size_t num_sensors,
                             const pmbus_sensor_definition_t sensor_definitions[const num_sensors],
@@ -0,0 +1,182 @@
+/*
+ * @file pmbus_sensor_monitor.c
+ * @date 18 Oct 2026
+ * @author Chester Gillon
+ * @brief Provides an interface to continuously scan the sensors of PMBus devices in a background thread
+ * @details
+ *   The background thread owns the bit-banged I2C controller while the monitor is running, and uses pmbus_scan_sensors()
+ *   to scan each device in turn. Each scan is published as a timestamped sample into a ring, which the consumer drains
+ *   with pmbus_sensor_monitor_get_samples(). If the consumer doesn't keep up the newest samples are dropped, and counted,
+ *   rather than blocking the scanning.
+ */
+
+#include "pmbus_sensor_monitor.h"
+#include "transfer_timing.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+
+/**
+ * @brief Publish one sample from the background thread
+ * @param[in/out] monitor The monitor to publish the sample to
+ * @param[in] sample The sample to publish
+ */
+static void publish_sample (pmbus_sensor_monitor_t *const monitor, const pmbus_sensor_sample_t *const sample)
+{
+    pthread_mutex_lock (&monitor->lock);
+    if ((monitor->num_samples_published - monitor->num_samples_consumed) < PMBUS_MONITOR_SAMPLE_RING_SIZE)
+    {
+        monitor->samples[monitor->num_samples_published % PMBUS_MONITOR_SAMPLE_RING_SIZE] = *sample;
+        monitor->num_samples_published++;
+    }
+    else
+    {
+        monitor->num_samples_dropped++;
+    }
+    if (sample->status != SMBUS_TRANSFER_SUCCESS)
+    {
+        monitor->num_failed_scans++;
+    }
+    pthread_mutex_unlock (&monitor->lock);
+}
+
+
+/**
+ * @brief The entry point for the background thread which scans the PMBus devices until requested to stop
+ * @param[in/out] arg The monitor context
+ * @return Not used
+ */
+static void *pmbus_sensor_monitor_thread (void *const arg)
+{
+    pmbus_sensor_monitor_t *const monitor = arg;
+    pmbus_sensor_sample_t sample;
+    struct timespec next_scan_time;
+
+    clock_gettime (CLOCK_MONOTONIC, &next_scan_time);
+    while (!__atomic_load_n (&monitor->stop_requested, __ATOMIC_ACQUIRE))
+    {
+        for (uint32_t device_index = 0; device_index < monitor->num_devices; device_index++)
+        {
+            memset (&sample, 0, sizeof (sample));
+            sample.device_index = device_index;
+            sample.timestamp_ns = get_monotonic_time ();
+            sample.status = pmbus_scan_sensors (monitor->controller, monitor->schedules[device_index], sample.readings);
+            sample.scan_duration_ns = get_monotonic_time () - sample.timestamp_ns;
+            if (sample.status != SMBUS_TRANSFER_SUCCESS)
+            {
+                sample.failed_command_code = monitor->controller->last_smbus_command_code;
+            }
+            publish_sample (monitor, &sample);
+        }
+
+        if (monitor->scan_interval_ns > 0)
+        {
+            /* Wait until the next scan, using an absolute time to avoid drift */
+            next_scan_time.tv_nsec += monitor->scan_interval_ns;
+            while (next_scan_time.tv_nsec >= 1000000000L)
+            {
+                next_scan_time.tv_sec++;
+                next_scan_time.tv_nsec -= 1000000000L;
+            }
+            clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &next_scan_time, NULL);
+        }
+    }
+
+    return NULL;
+}
+
+
+/**
+ * @brief Start a background thread which continuously scans the sensors of PMBus devices
+ * @details The caller must not use the controller until pmbus_sensor_monitor_stop() has been called.
+ * @param[out] monitor The monitor context to initialise
+ * @param[in/out] controller The controller for the GPIO bit-banged interface, used by the background thread
+ * @param[in] num_devices The number of PMBus devices to scan
+ * @param[in/out] schedules The initialised scan schedule for each PMBus device
+ * @param[in] scan_interval_ns The minimum interval between the start of successive scans of all devices.
+ *                             Zero means scan back-to-back to obtain the maximum sample rate.
+ */
+void pmbus_sensor_monitor_start (pmbus_sensor_monitor_t *const monitor,
+                                 bit_banged_i2c_controller_context_t *const controller,
+                                 const uint32_t num_devices, pmbus_scan_schedule_t *const schedules[const num_devices],
+                                 const int64_t scan_interval_ns)
+{
+    int rc;
+
+    if (num_devices > PMBUS_MONITOR_MAX_DEVICES)
+    {
+        printf ("num_devices=%u exceeds PMBUS_MONITOR_MAX_DEVICES\n", num_devices);
+        exit (EXIT_FAILURE);
+    }
+
+    memset (monitor, 0, sizeof (*monitor));
+    monitor->controller = controller;
+    monitor->num_devices = num_devices;
+    for (uint32_t device_index = 0; device_index < num_devices; device_index++)
+    {
+        monitor->schedules[device_index] = schedules[device_index];
+    }
+    monitor->scan_interval_ns = scan_interval_ns;
+    monitor->stop_requested = false;
+
+    rc = pthread_mutex_init (&monitor->lock, NULL);
+    if (rc != 0)
+    {
+        printf ("pthread_mutex_init() failed\n");
+        exit (EXIT_FAILURE);
+    }
+
+    rc = pthread_create (&monitor->thread, NULL, pmbus_sensor_monitor_thread, monitor);
+    if (rc != 0)
+    {
+        printf ("pthread_create() failed\n");
+        exit (EXIT_FAILURE);
+    }
+}
+
+
+/**
+ * @brief Retrieve the samples which have been published by the background thread, in the order they were published
+ * @param[in/out] monitor The monitor to retrieve the samples from
+ * @param[in] max_samples The maximum number of samples to retrieve
+ * @param[out] samples The retrieved samples
+ * @return The number of samples retrieved, which is zero if no new samples are available
+ */
+size_t pmbus_sensor_monitor_get_samples (pmbus_sensor_monitor_t *const monitor,
+                                         const size_t max_samples, pmbus_sensor_sample_t samples[const max_samples])
+{
+    size_t num_samples = 0;
+
+    pthread_mutex_lock (&monitor->lock);
+    while ((num_samples < max_samples) && (monitor->num_samples_consumed < monitor->num_samples_published))
+    {
+        samples[num_samples] = monitor->samples[monitor->num_samples_consumed % PMBUS_MONITOR_SAMPLE_RING_SIZE];
+        monitor->num_samples_consumed++;
+        num_samples++;
+    }
+    pthread_mutex_unlock (&monitor->lock);
+
+    return num_samples;
+}
+
+
+/**
+ * @brief Stop the background thread, after which the controller may be used by the caller again.
+ * @details Any samples which have not been retrieved may still be retrieved after the thread has stopped.
+ * @param[in/out] monitor The monitor to stop
+ */
+void pmbus_sensor_monitor_stop (pmbus_sensor_monitor_t *const monitor)
+{
+    int rc;
+
+    __atomic_store_n (&monitor->stop_requested, true, __ATOMIC_RELEASE);
+    rc = pthread_join (monitor->thread, NULL);
+    if (rc != 0)
+    {
+        printf ("pthread_join() failed\n");
+        exit (EXIT_FAILURE);
+    }
+}
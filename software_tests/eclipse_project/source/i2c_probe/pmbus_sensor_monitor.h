@@ -0,0 +1,78 @@
+/*
+ * @file pmbus_sensor_monitor.h
+ * @date 18 Oct 2026
+ * @author Chester Gillon
+ * @brief Provides an interface to continuously scan the sensors of PMBus devices in a background thread
+ */
+
+#ifndef PMBUS_SENSOR_MONITOR_H_
+#define PMBUS_SENSOR_MONITOR_H_
+
+#include <pthread.h>
+
+#include "pmbus_access.h"
+
+
+/* The maximum number of PMBus devices which can be scanned by one monitor */
+#define PMBUS_MONITOR_MAX_DEVICES 4
+
+/* The number of samples which can be queued between the background thread and the consumer.
+ * Must be a power of two. */
+#define PMBUS_MONITOR_SAMPLE_RING_SIZE 1024
+
+
+/* One timestamped sample published by the background thread, from one scan of one PMBus device */
+typedef struct
+{
+    /* CLOCK_MONOTONIC time in nanoseconds at the start of the scan */
+    int64_t timestamp_ns;
+    /* The time taken for the scan in nanoseconds */
+    int64_t scan_duration_ns;
+    /* Identifies which of the monitored devices the sample is for */
+    uint32_t device_index;
+    /* The status of the scan. The readings are only valid when SMBUS_TRANSFER_SUCCESS */
+    smbus_transfer_status_t status;
+    /* The command code which failed, when status isn't SMBUS_TRANSFER_SUCCESS */
+    uint8_t failed_command_code;
+    /* The sensor readings, indexed the same as the sensor definitions in the schedule for the device */
+    pmbus_sensor_reading_t readings[PMBUS_MAX_SCAN_SENSORS];
+} pmbus_sensor_sample_t;
+
+
+/* Context for a background thread which continuously scans PMBus devices */
+typedef struct
+{
+    /* The controller used to access the PMBus devices. Owned by the background thread while the monitor is running. */
+    bit_banged_i2c_controller_context_t *controller;
+    /* The schedules for the PMBus devices to scan, which are scanned in turn */
+    uint32_t num_devices;
+    pmbus_scan_schedule_t *schedules[PMBUS_MONITOR_MAX_DEVICES];
+    /* The minimum interval between the start of successive scans of all devices. Zero means scan back-to-back. */
+    int64_t scan_interval_ns;
+    /* The background thread */
+    pthread_t thread;
+    /* Set to request the background thread to stop */
+    bool stop_requested;
+    /* Protects the sample ring and counts below */
+    pthread_mutex_t lock;
+    /* Ring of samples published by the background thread, for retrieval by pmbus_sensor_monitor_get_samples().
+     * The indices are free-running counts. */
+    pmbus_sensor_sample_t samples[PMBUS_MONITOR_SAMPLE_RING_SIZE];
+    uint64_t num_samples_published;
+    uint64_t num_samples_consumed;
+    /* The number of samples discarded as the ring was full */
+    uint64_t num_samples_dropped;
+    /* The number of scans which failed */
+    uint64_t num_failed_scans;
+} pmbus_sensor_monitor_t;
+
+
+void pmbus_sensor_monitor_start (pmbus_sensor_monitor_t *const monitor,
+                                 bit_banged_i2c_controller_context_t *const controller,
+                                 const uint32_t num_devices, pmbus_scan_schedule_t *const schedules[const num_devices],
+                                 const int64_t scan_interval_ns);
+size_t pmbus_sensor_monitor_get_samples (pmbus_sensor_monitor_t *const monitor,
+                                         const size_t max_samples, pmbus_sensor_sample_t samples[const max_samples]);
+void pmbus_sensor_monitor_stop (pmbus_sensor_monitor_t *const monitor);
+
+#endif /* PMBUS_SENSOR_MONITOR_H_ */
@@ -163,7 +163,7 @@ int main (int argc, char *argv[])
     /* Display information using the FPGA devices */
     for (uint32_t device_index = 0; device_index < vfio_devices.num_devices; device_index++)
     {
-        vfio_device_t *const vfio_device = &vfio_devices.devices[device_index];
+        vfio_device_t *const vfio_device = vfio_devices.devices[device_index];
 
         test_fan_control (vfio_device, (uint8_t) fan_control_value);
     }
@@ -14,6 +14,7 @@
 #include "qdma_transfers.h"
 #include "mrmac_register_access.h"
 #include "cmac_register_access.h"
+#include "transfer_timing.h"
 
 #include <stdlib.h>
 #include <stddef.h>
@@ -28,7 +29,7 @@
  */
 static void parse_command_line_arguments (int argc, char *argv[])
 {
-    const char *const optstring = "d:";
+    const char *const optstring = "d:c:";
     int option;
 
     option = getopt (argc, argv, optstring);
@@ -40,9 +41,13 @@ static void parse_command_line_arguments (int argc, char *argv[])
             vfio_add_pci_device_location_filter (optarg);
             break;
 
+        case 'c':
+            identify_pcie_fpga_designs_enable_cache (optarg);
+            break;
+
         case '?':
         default:
-            printf ("Usage %s -d <pci_device_location>\n", argv[0]);
+            printf ("Usage %s -d <pci_device_location> -c <identification_cache_pathname>\n", argv[0]);
             exit (EXIT_FAILURE);
             break;
         }
@@ -254,8 +259,15 @@ int main (int argc, char *argv[])
 
     parse_command_line_arguments (argc, argv);
 
-    /* Open the FPGA designs which have an IOMMU group assigned */
+    /* Open the FPGA designs which have an IOMMU group assigned, timing the identification so can compare the startup time
+     * with and without the identification cache. */
+    const int64_t identify_start_time = get_monotonic_time ();
     identify_pcie_fpga_designs (&designs);
+    const int64_t identify_stop_time = get_monotonic_time ();
+
+    printf ("Identified %u designs (%u from cache) in %.3f ms\n",
+            designs.num_identified_designs, designs.num_designs_from_cache,
+            (double) (identify_stop_time - identify_start_time) / 1E6);
 
     /* Display the identified designs */
     for (uint32_t design_index = 0; design_index < designs.num_identified_designs; design_index++)
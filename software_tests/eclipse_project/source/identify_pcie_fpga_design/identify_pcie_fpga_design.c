@@ -20,6 +20,10 @@
 #include <string.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include <unistd.h>
 
 
 /* Lookup table to give the name for each FPGA design, with the name of the board in brackets if not part of the design name. */
@@ -497,15 +501,105 @@ const uint32_t crc64_stream_tdata_width_bytes[FPGA_DESIGN_ARRAY_SIZE] =
 };
 
 
+/* The types of register block which may be present in a design, each of which sets fields in fpga_design_t */
+typedef enum
+{
+    /* Marks the end of the list of register blocks for a design */
+    FPGA_DESIGN_BLOCK_NONE,
+    FPGA_DESIGN_BLOCK_QUAD_SPI,
+    FPGA_DESIGN_BLOCK_XADC,
+    FPGA_DESIGN_BLOCK_SYSMON,
+    FPGA_DESIGN_BLOCK_IIC,
+    FPGA_DESIGN_BLOCK_BIT_BANGED_I2C_GPIO,
+    FPGA_DESIGN_BLOCK_USER_ACCESS,
+    FPGA_DESIGN_BLOCK_AXI_SWITCH,
+    /* The instance selects the SLR */
+    FPGA_DESIGN_BLOCK_ULTRASCALE_DNA,
+    FPGA_DESIGN_BLOCK_MRMAC,
+    /* The instance selects the CMAC port. Sets the number of CMAC ports to include the instance */
+    FPGA_DESIGN_BLOCK_CMAC,
+    /* The instance selects the CMAC port. Must follow the FPGA_DESIGN_BLOCK_CMAC entry for the same port */
+    FPGA_DESIGN_BLOCK_CMAC_DRP,
+    /* Only records the location of the CMS Subsystem, without mapping it. The frame_size isn't used. */
+    FPGA_DESIGN_BLOCK_CMS
+} fpga_design_block_type_t;
+
+
+/* Defines one register block in a design, in terms of where it is located in the BARs */
+typedef struct
+{
+    /* The type of register block */
+    fpga_design_block_type_t type;
+    /* The BAR and offset within the BAR of the register block */
+    uint32_t bar_index;
+    size_t base_offset;
+    /* The size of the register block */
+    size_t frame_size;
+    /* For register blocks which may have multiple instances in a design, the instance this entry is for */
+    uint32_t instance;
+    /* The register block is only present when the PCI revision ID is at least this value.
+     * Allows for revisions of a design which have added register blocks. */
+    uint8_t min_revision_id;
+} fpga_design_block_t;
+
+
+/* The maximum number of register blocks which may be defined for one design */
+#define MAX_FPGA_DESIGN_BLOCKS 12
+
+
+/* The maximum number of PCI device IDs which may be used to select between designs which share the same PCI filter */
+#define MAX_FPGA_DESIGN_DEVICE_IDS 2
+
+
+/* Function which may be called to complete the identification of a design after the register blocks have been mapped,
+ * to handle information which can't be expressed in fpga_design_descriptor_t. Returns false if the design isn't identified. */
+typedef bool (*fpga_design_probe_t) (vfio_device_t *const vfio_device, const fpga_design_id_t candidate_design_id,
+                                     fpga_design_t *const candidate_design);
+
+
+/* Describes how to identify one design, and the contents of the design once identified */
+typedef struct
+{
+    /* When non-zero the PCI device IDs which are accepted for this design.
+     * Used for designs which use default Xilinx identities, and so share the same PCI filter. */
+    uint32_t num_device_ids;
+    uint32_t device_ids[MAX_FPGA_DESIGN_DEVICE_IDS];
+    /* Optional function to complete the identification */
+    fpga_design_probe_t probe;
+    /* The DMA/Bridge Subsystem, if present. A zero memory size indicates "AXI Stream" */
+    bool dma_bridge_present;
+    uint32_t dma_bridge_bar;
+    size_t dma_bridge_memory_base_address;
+    size_t dma_bridge_memory_size_bytes;
+    /* The QDMA Subsystem, if present */
+    bool qdma_present;
+    uint32_t qdma_bridge_bar;
+    size_t qdma_memory_base_address;
+    size_t qdma_memory_size_bytes;
+    /* Applied when a FPGA_DESIGN_BLOCK_SYSMON is present */
+    uint32_t num_sysmon_slaves;
+    /* Applied when a FPGA_DESIGN_BLOCK_AXI_SWITCH is present */
+    uint32_t axi_switch_num_master_ports;
+    uint32_t axi_switch_num_slave_ports;
+    /* Applied when a FPGA_DESIGN_BLOCK_MRMAC is present */
+    bool mrmac_used_ports[NUM_MRMAC_PORTS];
+    /* Applied to each FPGA_DESIGN_BLOCK_CMAC present. CMAC_FEATURE_DRP is set by the presence of FPGA_DESIGN_BLOCK_CMAC_DRP */
+    bool cmac_configured_features[CMAC_FEATURE_ARRAY_SIZE];
+    /* The register blocks in the design, terminated by FPGA_DESIGN_BLOCK_NONE.
+     * The blocks are mapped in the order listed. */
+    fpga_design_block_t blocks[MAX_FPGA_DESIGN_BLOCKS];
+} fpga_design_descriptor_t;
+
+
 /**
  * @brief Identify if a design is a FPGA_DESIGN_LITEFURY_PROJECT0 or FPGA_DESIGN_NITEFURY_PROJECT0
  * @details Both designs use the same PCI identities, and are differentiated by reading a GPIO register in the design
  * @param[in/out] vfio_device The VFIO device for the candidate design to be probed
- * @param[out] candidate_design_id Set to the identified design
- * @param[on/out] candidate_design Used to store the information about the identified design
+ * @param[in] candidate_design_id Which of the two designs to check for
+ * @param[on/out] candidate_design Used to store the board version of the identified design
  * @return Returns true if have identified the design based upon the GPIO register
  */
-static bool identify_fury_project0 (vfio_device_t *const vfio_device, fpga_design_id_t *const candidate_design_id,
+static bool identify_fury_project0 (vfio_device_t *const vfio_device, const fpga_design_id_t candidate_design_id,
                                     fpga_design_t *const candidate_design)
 {
     bool design_identified = false;
@@ -527,38 +621,16 @@ static bool identify_fury_project0 (vfio_device_t *const vfio_device, fpga_desig
 
         /* Look for the encoded pid string to identify the LiteFury or NiteFury board.
          * The two boards have:
-         * a. Different DDR3 sizes.
+         * a. Different DDR3 sizes, which are set in fpga_design_descriptors[].
          * b. Different FPGA devices. However, the type of device is not available to this library. */
-        if (strncmp (pid_string, "LITE", 4) == 0)
-        {
-            *candidate_design_id = FPGA_DESIGN_LITEFURY_PROJECT0;
-            candidate_design->dma_bridge_memory_base_address = 0;
-            candidate_design->dma_bridge_memory_size_bytes = 512UL * 1024 * 1024;
-            design_identified = true;
-        }
-        else if (strncmp (pid_string, "NITE", 4) == 0)
-        {
-            *candidate_design_id = FPGA_DESIGN_NITEFURY_PROJECT0;
-            candidate_design->dma_bridge_memory_base_address = 0;
-            candidate_design->dma_bridge_memory_size_bytes = 1024UL * 1024 * 1024;
-            design_identified = true;
-        }
+        design_identified =
+                ((candidate_design_id == FPGA_DESIGN_LITEFURY_PROJECT0) && (strncmp (pid_string, "LITE", 4) == 0)) ||
+                ((candidate_design_id == FPGA_DESIGN_NITEFURY_PROJECT0) && (strncmp (pid_string, "NITE", 4) == 0));
 
         if (design_identified)
         {
             /* board_version is a constant value fed to the GPIO2 input value */
             candidate_design->board_version = read_reg32 (gpio_0_regs, 0x8);
-
-            /* Size of the DMA bridge memory has been set above, as depends upon the design */
-            candidate_design->dma_bridge_present = true;
-            candidate_design->dma_bridge_bar = FURY_PROJECT0_DMA_BRIDGE_BAR;
-
-            candidate_design->quad_spi_regs =
-                    map_vfio_registers_block (vfio_device, FURY_PROJECT0_AXI_PERIPHERALS_BAR,
-                            FURY_PROJECT0_QUAD_SPI_BASE_OFFSET, FURY_PROJECT0_PERIPHERAL_FRAME_SIZE);
-            candidate_design->xadc_regs =
-                    map_vfio_registers_block (vfio_device, FURY_PROJECT0_AXI_PERIPHERALS_BAR,
-                            FURY_PROJECT0_XADC_WIZ_BASE_OFFSET, FURY_PROJECT0_PERIPHERAL_FRAME_SIZE);
         }
     }
 
@@ -567,1528 +639,1505 @@ static bool identify_fury_project0 (vfio_device_t *const vfio_device, fpga_desig
 
 
 /**
- * @brief Identify the PCIe FPGA designs known to the library, opening them using VFIO
- * @param[out] designs Contains the identified designs
+ * @brief Set the memory addressed by the DMA bridge for FPGA_DESIGN_U200_DMA_DDR4, which depends upon the revision
+ * @details Revisions which aren't known leave the memory size as zero.
+ * @param[in/out] vfio_device The VFIO device for the identified design
+ * @param[in] candidate_design_id Not used
+ * @param[on/out] candidate_design Used to store the DMA bridge memory
+ * @return Always returns true, since the PCI identities are sufficient to identify the design
  */
-void identify_pcie_fpga_designs (fpga_designs_t *const designs)
+static bool set_u200_dma_ddr4_memory (vfio_device_t *const vfio_device, const fpga_design_id_t candidate_design_id,
+                                      fpga_design_t *const candidate_design)
 {
-    fpga_design_id_t candidate_design_id;
-    bool design_identified;
-
-    /* Open all VFIO devices potentially matching the designs */
-    memset (designs, 0, sizeof (*designs));
-    open_vfio_devices_matching_filter (&designs->vfio_devices, FPGA_DESIGN_ARRAY_SIZE, fpga_design_pci_filters);
+    (void) candidate_design_id;
 
-    designs->num_identified_designs = 0;
-    for (uint32_t device_index = 0; device_index < designs->vfio_devices.num_devices; device_index++)
+    switch (vfio_device->pci_revision_id)
     {
-        vfio_device_t *const vfio_device = &designs->vfio_devices.devices[device_index];
-        fpga_design_t *const candidate_design = &designs->designs[designs->num_identified_designs];
-
-        design_identified = false;
-        candidate_design_id = 0;
-        while (!design_identified && (candidate_design_id < FPGA_DESIGN_ARRAY_SIZE))
-        {
-            if (vfio_device_pci_filter_match (vfio_device, &fpga_design_pci_filters[candidate_design_id]))
-            {
-                /* Handle designs using default Xilinx identities, to determine the actual design */
-                switch (candidate_design_id)
-                {
-                case FPGA_DESIGN_OPEN_NIC:
-                case FPGA_DESIGN_XCKU5P_PCIE_DDR4_ETH:
-                    switch (vfio_device->pci_dev->device_id)
-                    {
-                    case 0x903f:
-                    case 0x913f:
-                        /* The design has two physical functions with different device IDs */
-                        candidate_design_id = FPGA_DESIGN_OPEN_NIC;
-                        break;
-
-                    case 0x9038:
-                        candidate_design_id = FPGA_DESIGN_XCKU5P_PCIE_DDR4_ETH;
-                        break;
-
-                    default:
-                        /* Identification of aliased fpga_design_pci_filters[] failed, so cause to be unknown */
-                        candidate_design_id = FPGA_DESIGN_ARRAY_SIZE;
-                        break;
-                    }
-                    break;
-
-                default:
-                    /* Not a design with aliased identities */
-                    break;
-                }
-
-                switch (candidate_design_id)
-                {
-                case FPGA_DESIGN_DMA_BLKRAM:
-                    {
-                        /* The total amount of BLKRAM addressable by DMA. Sizes set to maximise BLKRAM usage in FPGA */
-                        const size_t blkram_0_size_bytes = 1024 * 1024;
-                        const size_t blkram_1_size_bytes =  128 * 1024;
-
-                        candidate_design->dma_bridge_present = true;
-                        candidate_design->dma_bridge_bar = 0; /* Since the PCIe to AXI Lite Master Interface isn't used */
-                        candidate_design->dma_bridge_memory_base_address = 0;
-                        candidate_design->dma_bridge_memory_size_bytes = blkram_0_size_bytes + blkram_1_size_bytes;
-                        design_identified = true;
-                    }
-                    break;
-
-                case FPGA_DESIGN_I2C_PROBE:
-                    {
-                        const uint32_t bar_index = 0;
-                        const size_t iic_base_offset      = 0x0000;
-                        const size_t iic_frame_size       = 0x1000;
-                        const size_t gpio_base_offset     = 0x1000;
-                        const size_t gpio_frame_size      = 0x1000;
-                        const size_t quad_spi_base_offset = 0x2000;
-                        const size_t quad_spi_frame_size  = 0x1000;
-                        const size_t xadc_base_offset     = 0x3000;
-                        const size_t xadc_frame_size      = 0x1000;
-
-                        candidate_design->iic_regs =
-                                map_vfio_registers_block (vfio_device, bar_index, iic_base_offset, iic_frame_size);
-                        candidate_design->bit_banged_i2c_gpio_regs =
-                                map_vfio_registers_block (vfio_device, bar_index, gpio_base_offset, gpio_frame_size);
-                        candidate_design->quad_spi_regs =
-                                map_vfio_registers_block (vfio_device, bar_index, quad_spi_base_offset, quad_spi_frame_size);
-                        candidate_design->xadc_regs =
-                                map_vfio_registers_block (vfio_device, bar_index, xadc_base_offset, xadc_frame_size);
-                        design_identified = true;
-                    }
-                    break;
-
-                case FPGA_DESIGN_TOSING_160T_DMA_DDR3:
-                    {
-                        const uint32_t peripherals_bar_index = 0;
-                        const uint32_t dma_bridge_bar_index = 2;
-                        const size_t quad_spi_base_offset    = 0x0000;
-                        const size_t quad_spi_frame_size     = 0x1000;
-                        const size_t xadc_base_offset        = 0x1000;
-                        const size_t xadc_frame_size         = 0x1000;
-                        const size_t user_access_base_offset = 0x2000;
-                        const size_t user_access_frame_size  = 0x1000;
-
-                        candidate_design->dma_bridge_present = true;
-                        candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                        candidate_design->dma_bridge_memory_base_address = 0;
-                        candidate_design->dma_bridge_memory_size_bytes = 1024UL * 1024 * 1024;
-                        candidate_design->quad_spi_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        quad_spi_base_offset, quad_spi_frame_size);
-                        candidate_design->xadc_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index, xadc_base_offset, xadc_frame_size);
-                        candidate_design->user_access =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        user_access_base_offset, user_access_frame_size);
-                        design_identified = true;
-                    }
-                    break;
-
-                case FPGA_DESIGN_LITEFURY_PROJECT0:
-                case FPGA_DESIGN_NITEFURY_PROJECT0:
-                    design_identified = identify_fury_project0 (vfio_device, &candidate_design_id, candidate_design);
-                    break;
-
-                case FPGA_DESIGN_TEF1001_DMA_DDR3:
-                    {
-                        const uint32_t peripherals_bar_index = 0;
-                        const uint32_t dma_bridge_bar_index = 2;
-                        const size_t iic_base_offset         = 0x0000;
-                        const size_t iic_frame_size          = 0x1000;
-                        const size_t gpio_base_offset        = 0x1000;
-                        const size_t gpio_frame_size         = 0x1000;
-                        const size_t quad_spi_base_offset    = 0x2000;
-                        const size_t quad_spi_frame_size     = 0x1000;
-                        const size_t xadc_base_offset        = 0x3000;
-                        const size_t xadc_frame_size         = 0x1000;
-                        const size_t user_access_base_offset = 0x4000;
-                        const size_t user_access_frame_size  = 0x1000;
-
-                        candidate_design->dma_bridge_present = true;
-                        candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                        candidate_design->dma_bridge_memory_base_address = 0;
-                        candidate_design->dma_bridge_memory_size_bytes = 8192UL * 1024 * 1024;
-
-                        candidate_design->iic_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index, iic_base_offset, iic_frame_size);
-                        candidate_design->bit_banged_i2c_gpio_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index, gpio_base_offset, gpio_frame_size);
-                        candidate_design->quad_spi_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index, quad_spi_base_offset, quad_spi_frame_size);
-                        candidate_design->xadc_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index, xadc_base_offset, xadc_frame_size);
-                        candidate_design->user_access =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        user_access_base_offset, user_access_frame_size);
-                        design_identified = true;
-                    }
-                    break;
-
-                case FPGA_DESIGN_NITEFURY_DMA_DDR3:
-                    {
-                        const uint32_t peripherals_bar_index = 0;
-                        const uint32_t dma_bridge_bar_index = 2;
-                        const size_t quad_spi_base_offset    = 0x0000;
-                        const size_t quad_spi_frame_size     = 0x1000;
-                        const size_t xadc_base_offset        = 0x1000;
-                        const size_t xadc_frame_size         = 0x1000;
-                        const size_t user_access_base_offset = 0x2000;
-                        const size_t user_access_frame_size  = 0x1000;
-
-                        candidate_design->dma_bridge_present = true;
-                        candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                        candidate_design->dma_bridge_memory_base_address = 0;
-                        candidate_design->dma_bridge_memory_size_bytes = 1024UL * 1024 * 1024;
-
-                        candidate_design->quad_spi_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index, quad_spi_base_offset, quad_spi_frame_size);
-                        candidate_design->xadc_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index, xadc_base_offset, xadc_frame_size);
-                        candidate_design->user_access =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        user_access_base_offset, user_access_frame_size);
-                        design_identified = true;
-                    }
-                    break;
-
-                case FPGA_DESIGN_TEF1001_DMA_STREAM_LOOPBACK:
-                {
-                    const uint32_t peripherals_bar_index = 0;
-                    const uint32_t dma_bridge_bar_index = 2;
-                    const size_t iic_base_offset         = 0x0000;
-                    const size_t iic_frame_size          = 0x1000;
-                    const size_t gpio_base_offset        = 0x1000;
-                    const size_t gpio_frame_size         = 0x1000;
-                    const size_t quad_spi_base_offset    = 0x2000;
-                    const size_t quad_spi_frame_size     = 0x1000;
-                    const size_t xadc_base_offset        = 0x3000;
-                    const size_t xadc_frame_size         = 0x1000;
-                    const size_t user_access_base_offset = 0x4000;
-                    const size_t user_access_frame_size  = 0x1000;
-                    const size_t axi_switch_base_offset  = 0x6000;
-                    const size_t axi_switch_frame_size   = 0x1000;
-
-                    candidate_design->dma_bridge_present = true;
-                    candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                    candidate_design->dma_bridge_memory_size_bytes = 0; /* DMA bridge configured for "AXI Stream" */
-
-                    candidate_design->iic_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, iic_base_offset, iic_frame_size);
-                    candidate_design->bit_banged_i2c_gpio_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, gpio_base_offset, gpio_frame_size);
-                    candidate_design->quad_spi_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, quad_spi_base_offset, quad_spi_frame_size);
-                    candidate_design->xadc_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, xadc_base_offset, xadc_frame_size);
-                    candidate_design->user_access =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    user_access_base_offset, user_access_frame_size);
-                    if (vfio_device->pci_revision_id >= 1)
-                    {
-                        candidate_design->axi_switch_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        axi_switch_base_offset, axi_switch_frame_size);
-                        candidate_design->axi_switch_num_master_ports = 2;
-                        candidate_design->axi_switch_num_slave_ports = 2;
-                    }
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_TEF1001_DMA_STREAM_FIXED_DATA:
-                {
-                    const uint32_t peripherals_bar_index = 0;
-                    const uint32_t dma_bridge_bar_index = 2;
-                    const size_t iic_base_offset         = 0x0000;
-                    const size_t iic_frame_size          = 0x1000;
-                    const size_t gpio_base_offset        = 0x1000;
-                    const size_t gpio_frame_size         = 0x1000;
-                    const size_t quad_spi_base_offset    = 0x2000;
-                    const size_t quad_spi_frame_size     = 0x1000;
-                    const size_t xadc_base_offset        = 0x3000;
-                    const size_t xadc_frame_size         = 0x1000;
-                    const size_t user_access_base_offset = 0x4000;
-                    const size_t user_access_frame_size  = 0x1000;
-
-                    candidate_design->dma_bridge_present = true;
-                    candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                    candidate_design->dma_bridge_memory_size_bytes = 0; /* DMA bridge configured for "AXI Stream" */
-
-                    candidate_design->iic_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, iic_base_offset, iic_frame_size);
-                    candidate_design->bit_banged_i2c_gpio_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, gpio_base_offset, gpio_frame_size);
-                    candidate_design->quad_spi_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, quad_spi_base_offset, quad_spi_frame_size);
-                    candidate_design->xadc_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, xadc_base_offset, xadc_frame_size);
-                    candidate_design->user_access =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    user_access_base_offset, user_access_frame_size);
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_NITEFURY_DMA_STREAM_LOOPBACK:
-                {
-                    const uint32_t peripherals_bar_index = 0;
-                    const uint32_t dma_bridge_bar_index = 2;
-                    const size_t quad_spi_base_offset    = 0x0000;
-                    const size_t quad_spi_frame_size     = 0x1000;
-                    const size_t xadc_base_offset        = 0x1000;
-                    const size_t xadc_frame_size         = 0x1000;
-                    const size_t user_access_base_offset = 0x2000;
-                    const size_t user_access_frame_size  = 0x1000;
-                    const size_t axi_switch_base_offset  = 0x3000;
-                    const size_t axi_switch_frame_size   = 0x1000;
-
-                    candidate_design->dma_bridge_present = true;
-                    candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                    candidate_design->dma_bridge_memory_size_bytes = 0; /* DMA bridge configured for "AXI Stream" */
-
-                    candidate_design->quad_spi_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, quad_spi_base_offset, quad_spi_frame_size);
-                    candidate_design->xadc_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, xadc_base_offset, xadc_frame_size);
-                    candidate_design->user_access =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    user_access_base_offset, user_access_frame_size);
-                    if (vfio_device->pci_revision_id >= 1)
-                    {
-                        candidate_design->axi_switch_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        axi_switch_base_offset, axi_switch_frame_size);
-                        candidate_design->axi_switch_num_master_ports = 2;
-                        candidate_design->axi_switch_num_slave_ports = 2;
-                    }
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_NITEFURY_DMA_STREAM_FIXED_DATA:
-                {
-                    const uint32_t peripherals_bar_index = 0;
-                    const uint32_t dma_bridge_bar_index = 2;
-                    const size_t quad_spi_base_offset    = 0x0000;
-                    const size_t quad_spi_frame_size     = 0x1000;
-                    const size_t xadc_base_offset        = 0x1000;
-                    const size_t xadc_frame_size         = 0x1000;
-                    const size_t user_access_base_offset = 0x2000;
-                    const size_t user_access_frame_size  = 0x1000;
-
-                    candidate_design->dma_bridge_present = true;
-                    candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                    candidate_design->dma_bridge_memory_size_bytes = 0; /* DMA bridge configured for "AXI Stream" */
-
-                    candidate_design->quad_spi_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, quad_spi_base_offset, quad_spi_frame_size);
-                    candidate_design->xadc_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, xadc_base_offset, xadc_frame_size);
-                    candidate_design->user_access =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    user_access_base_offset, user_access_frame_size);
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_TOSING_160T_DMA_STREAM_LOOPBACK:
-                {
-                    const uint32_t peripherals_bar_index = 0;
-                    const uint32_t dma_bridge_bar_index = 2;
-                    const size_t quad_spi_base_offset    = 0x0000;
-                    const size_t quad_spi_frame_size     = 0x1000;
-                    const size_t xadc_base_offset        = 0x1000;
-                    const size_t xadc_frame_size         = 0x1000;
-                    const size_t user_access_base_offset = 0x2000;
-                    const size_t user_access_frame_size  = 0x1000;
-                    const size_t axi_switch_base_offset  = 0x3000;
-                    const size_t axi_switch_frame_size   = 0x1000;
-
-                    candidate_design->dma_bridge_present = true;
-                    candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                    candidate_design->dma_bridge_memory_size_bytes = 0; /* DMA bridge configured for "AXI Stream" */
-                    candidate_design->quad_spi_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    quad_spi_base_offset, quad_spi_frame_size);
-                    candidate_design->xadc_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, xadc_base_offset, xadc_frame_size);
-                    candidate_design->user_access =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    user_access_base_offset, user_access_frame_size);
-                    if (vfio_device->pci_revision_id >= 1)
-                    {
-                        candidate_design->axi_switch_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        axi_switch_base_offset, axi_switch_frame_size);
-                        candidate_design->axi_switch_num_master_ports = 2;
-                        candidate_design->axi_switch_num_slave_ports = 2;
-                    }
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_TOSING_160T_DMA_STREAM_FIXED_DATA:
-                {
-                    const uint32_t peripherals_bar_index = 0;
-                    const uint32_t dma_bridge_bar_index = 2;
-                    const size_t quad_spi_base_offset    = 0x0000;
-                    const size_t quad_spi_frame_size     = 0x1000;
-                    const size_t xadc_base_offset        = 0x1000;
-                    const size_t xadc_frame_size         = 0x1000;
-                    const size_t user_access_base_offset = 0x2000;
-                    const size_t user_access_frame_size  = 0x1000;
-
-                    candidate_design->dma_bridge_present = true;
-                    candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                    candidate_design->dma_bridge_memory_size_bytes = 0; /* DMA bridge configured for "AXI Stream" */
-                    candidate_design->quad_spi_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    quad_spi_base_offset, quad_spi_frame_size);
-                    candidate_design->xadc_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, xadc_base_offset, xadc_frame_size);
-                    candidate_design->user_access =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    user_access_base_offset, user_access_frame_size);
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_XCKU5P_DUAL_QSFP_DMA_STREAM_LOOPBACK:
-                {
-                    const uint32_t peripherals_bar_index = 0;
-                    const uint32_t dma_bridge_bar_index = 2;
-                    const size_t quad_spi_base_offset    = 0x0000;
-                    const size_t quad_spi_frame_size     = 0x1000;
-                    const size_t sysmon_base_offset      = 0x1000;
-                    const size_t sysmon_frame_size       = 0x1000;
-                    const size_t user_access_base_offset = 0x2000;
-                    const size_t user_access_frame_size  = 0x1000;
-                    const size_t axi_switch_base_offset  = 0x3000;
-                    const size_t axi_switch_frame_size   = 0x1000;
-
-                    candidate_design->dma_bridge_present = true;
-                    candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                    candidate_design->dma_bridge_memory_size_bytes = 0; /* DMA bridge configured for "AXI Stream" */
-                    candidate_design->quad_spi_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    quad_spi_base_offset, quad_spi_frame_size);
-                    candidate_design->sysmon_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, sysmon_base_offset, sysmon_frame_size);
-                    candidate_design->num_sysmon_slaves = 0;
-                    candidate_design->user_access =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    user_access_base_offset, user_access_frame_size);
-                    if (vfio_device->pci_revision_id >= 1)
-                    {
-                        candidate_design->axi_switch_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        axi_switch_base_offset, axi_switch_frame_size);
-                        candidate_design->axi_switch_num_master_ports = 4;
-                        candidate_design->axi_switch_num_slave_ports = 4;
-                    }
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_XCKU5P_DUAL_QSFP_DMA_STREAM_FIXED_DATA:
-                {
-                    const uint32_t peripherals_bar_index = 0;
-                    const uint32_t dma_bridge_bar_index = 2;
-                    const size_t quad_spi_base_offset    = 0x0000;
-                    const size_t quad_spi_frame_size     = 0x1000;
-                    const size_t sysmon_base_offset      = 0x1000;
-                    const size_t sysmon_frame_size       = 0x1000;
-                    const size_t user_access_base_offset = 0x2000;
-                    const size_t user_access_frame_size  = 0x1000;
-
-                    candidate_design->dma_bridge_present = true;
-                    candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                    candidate_design->dma_bridge_memory_size_bytes = 0; /* DMA bridge configured for "AXI Stream" */
-                    candidate_design->quad_spi_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    quad_spi_base_offset, quad_spi_frame_size);
-                    candidate_design->sysmon_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, sysmon_base_offset, sysmon_frame_size);
-                    candidate_design->num_sysmon_slaves = 0;
-                    candidate_design->user_access =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    user_access_base_offset, user_access_frame_size);
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_XCKU5P_DUAL_QSFP_DMA_RAM:
-                {
-                    const uint32_t peripherals_bar_index = 0;
-                    const uint32_t dma_bridge_bar_index = 2;
-                    const size_t quad_spi_base_offset    = 0x0000;
-                    const size_t quad_spi_frame_size     = 0x1000;
-                    const size_t sysmon_base_offset      = 0x1000;
-                    const size_t sysmon_frame_size       = 0x1000;
-                    const size_t user_access_base_offset = 0x2000;
-                    const size_t user_access_frame_size  = 0x1000;
-
-                    candidate_design->dma_bridge_present = true;
-                    candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                    candidate_design->dma_bridge_memory_base_address = 0;
-                    candidate_design->dma_bridge_memory_size_bytes = 2UL * 1024 * 1024;
-                    candidate_design->quad_spi_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    quad_spi_base_offset, quad_spi_frame_size);
-                    candidate_design->sysmon_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, sysmon_base_offset, sysmon_frame_size);
-                    candidate_design->num_sysmon_slaves = 0;
-                    candidate_design->user_access =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    user_access_base_offset, user_access_frame_size);
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_XCKU5P_DUAL_QSFP_QDMA_RAM_QUAD_SPI:
-                {
-                    const uint32_t qdma_bridge_bar_index = 0;
-                    const uint32_t peripherals_bar_index = 2;
-                    const size_t quad_spi_base_offset    = 0x0000;
-                    const size_t quad_spi_frame_size     = 0x1000;
-
-                    candidate_design->qdma_present = true;
-                    candidate_design->qdma_bridge_bar = qdma_bridge_bar_index;
-                    candidate_design->qdma_memory_base_address = 0;
-                    candidate_design->qdma_memory_size_bytes = 2 * 1024 * 1024;
-                    candidate_design->quad_spi_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    quad_spi_base_offset, quad_spi_frame_size);
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_XCKU5P_DUAL_QSFP_QDMA_RAM_SYSMON:
-                {
-                    const uint32_t peripherals_bar_index = 2;
-                    const size_t sysmon_base_offset      = 0x0000;
-                    const size_t sysmon_frame_size       = 0x1000;
-
-                    candidate_design->sysmon_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, sysmon_base_offset, sysmon_frame_size);
-                    candidate_design->num_sysmon_slaves = 0;
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_XCKU5P_DUAL_QSFP_QDMA_RAM_USER_ACCESS:
-                {
-                    const uint32_t peripherals_bar_index = 2;
-                    const size_t user_access_base_offset = 0x0000;
-                    const size_t user_access_frame_size  = 0x1000;
-
-                    candidate_design->user_access =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    user_access_base_offset, user_access_frame_size);
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_XCKU5P_DUAL_QSFP_QDMA_RAM_UART:
-                {
-                    /* The only peripheral on this design is a UART, which isn't supported as part of the identification.
-                     * This design identification is a placeholder until QDMA support is added */
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_XCKU5P_DUAL_QSFP_IBERT:
-                {
-                    const uint32_t peripherals_bar_index = 0;
-                    const size_t quad_spi_base_offset    = 0x4000;
-                    const size_t quad_spi_frame_size     = 0x1000;
-                    const size_t sysmon_base_offset      = 0x5000;
-                    const size_t sysmon_frame_size       = 0x1000;
-                    const size_t user_access_base_offset = 0x6000;
-                    const size_t user_access_frame_size  = 0x1000;
-
-                    candidate_design->quad_spi_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    quad_spi_base_offset, quad_spi_frame_size);
-                    candidate_design->sysmon_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, sysmon_base_offset, sysmon_frame_size);
-                    candidate_design->num_sysmon_slaves = 0;
-                    candidate_design->user_access =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    user_access_base_offset, user_access_frame_size);
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_TEF1001_DDR3_THROUGHPUT:
-                {
-                    const uint32_t peripherals_bar_index = 0;
-                    const size_t xadc_base_offset        = 0x0000;
-                    const size_t xadc_frame_size         = 0x1000;
-                    const size_t user_access_base_offset = 0x1000;
-                    const size_t user_access_frame_size  = 0x1000;
-
-                    candidate_design->xadc_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, xadc_base_offset, xadc_frame_size);
-                    candidate_design->user_access =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    user_access_base_offset, user_access_frame_size);
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_XCKU5P_DUAL_QSFP_DMA_STREAM_CRC64:
-                {
-                    const uint32_t peripherals_bar_index = 0;
-                    const uint32_t dma_bridge_bar_index = 2;
-                    const size_t quad_spi_base_offset    = 0x0000;
-                    const size_t quad_spi_frame_size     = 0x1000;
-                    const size_t sysmon_base_offset      = 0x1000;
-                    const size_t sysmon_frame_size       = 0x1000;
-                    const size_t user_access_base_offset = 0x2000;
-                    const size_t user_access_frame_size  = 0x1000;
-
-                    candidate_design->dma_bridge_present = true;
-                    candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                    candidate_design->dma_bridge_memory_size_bytes = 0; /* DMA bridge configured for "AXI Stream" */
-                    candidate_design->quad_spi_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    quad_spi_base_offset, quad_spi_frame_size);
-                    candidate_design->sysmon_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, sysmon_base_offset, sysmon_frame_size);
-                    candidate_design->num_sysmon_slaves = 0;
-                    candidate_design->user_access =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    user_access_base_offset, user_access_frame_size);
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_TEF1001_DMA_STREAM_CRC64:
-                {
-                    const uint32_t peripherals_bar_index = 0;
-                    const uint32_t dma_bridge_bar_index = 2;
-                    const size_t iic_base_offset         = 0x0000;
-                    const size_t iic_frame_size          = 0x1000;
-                    const size_t gpio_base_offset        = 0x1000;
-                    const size_t gpio_frame_size         = 0x1000;
-                    const size_t quad_spi_base_offset    = 0x2000;
-                    const size_t quad_spi_frame_size     = 0x1000;
-                    const size_t xadc_base_offset        = 0x3000;
-                    const size_t xadc_frame_size         = 0x1000;
-                    const size_t user_access_base_offset = 0x4000;
-                    const size_t user_access_frame_size  = 0x1000;
-
-                    candidate_design->dma_bridge_present = true;
-                    candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                    candidate_design->dma_bridge_memory_size_bytes = 0; /* DMA bridge configured for "AXI Stream" */
-
-                    candidate_design->iic_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, iic_base_offset, iic_frame_size);
-                    candidate_design->bit_banged_i2c_gpio_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, gpio_base_offset, gpio_frame_size);
-                    candidate_design->quad_spi_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, quad_spi_base_offset, quad_spi_frame_size);
-                    candidate_design->xadc_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, xadc_base_offset, xadc_frame_size);
-                    candidate_design->user_access =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    user_access_base_offset, user_access_frame_size);
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_TOSING_160T_DMA_STREAM_CRC64:
-                {
-                    const uint32_t peripherals_bar_index = 0;
-                    const uint32_t dma_bridge_bar_index = 2;
-                    const size_t quad_spi_base_offset    = 0x0000;
-                    const size_t quad_spi_frame_size     = 0x1000;
-                    const size_t xadc_base_offset        = 0x1000;
-                    const size_t xadc_frame_size         = 0x1000;
-                    const size_t user_access_base_offset = 0x2000;
-                    const size_t user_access_frame_size  = 0x1000;
-
-                    candidate_design->dma_bridge_present = true;
-                    candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                    candidate_design->dma_bridge_memory_size_bytes = 0; /* DMA bridge configured for "AXI Stream" */
-                    candidate_design->quad_spi_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    quad_spi_base_offset, quad_spi_frame_size);
-                    candidate_design->xadc_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, xadc_base_offset, xadc_frame_size);
-                    candidate_design->user_access =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    user_access_base_offset, user_access_frame_size);
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_NITEFURY_DMA_STREAM_CRC64:
-                {
-                    const uint32_t peripherals_bar_index = 0;
-                    const uint32_t dma_bridge_bar_index = 2;
-                    const size_t quad_spi_base_offset    = 0x0000;
-                    const size_t quad_spi_frame_size     = 0x1000;
-                    const size_t xadc_base_offset        = 0x1000;
-                    const size_t xadc_frame_size         = 0x1000;
-                    const size_t user_access_base_offset = 0x2000;
-                    const size_t user_access_frame_size  = 0x1000;
-
-                    candidate_design->dma_bridge_present = true;
-                    candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                    candidate_design->dma_bridge_memory_size_bytes = 0; /* DMA bridge configured for "AXI Stream" */
-
-                    candidate_design->quad_spi_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, quad_spi_base_offset, quad_spi_frame_size);
-                    candidate_design->xadc_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, xadc_base_offset, xadc_frame_size);
-                    candidate_design->user_access =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    user_access_base_offset, user_access_frame_size);
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_AS02MC04_DMA_STREAM_CRC64:
-                {
-                    const uint32_t peripherals_bar_index    = 0;
-                    const uint32_t dma_bridge_bar_index     = 2;
-                    const size_t quad_spi_base_offset       = 0x0000;
-                    const size_t quad_spi_frame_size        = 0x1000;
-                    const size_t sysmon_base_offset         = 0x1000;
-                    const size_t sysmon_frame_size          = 0x1000;
-                    const size_t user_access_base_offset    = 0x2000;
-                    const size_t user_access_frame_size     = 0x1000;
-                    const size_t ultrascale_dna_base_offset = 0x3000;
-                    const size_t ultrascale_dna_frame_size  = 0x1000;
-
-                    candidate_design->dma_bridge_present = true;
-                    candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                    candidate_design->dma_bridge_memory_size_bytes = 0; /* DMA bridge configured for "AXI Stream" */
-                    candidate_design->quad_spi_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    quad_spi_base_offset, quad_spi_frame_size);
-                    candidate_design->sysmon_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, sysmon_base_offset, sysmon_frame_size);
-                    candidate_design->num_sysmon_slaves = 0;
-                    candidate_design->user_access =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    user_access_base_offset, user_access_frame_size);
-                    if (vfio_device->pci_revision_id >= 1)
-                    {
-                        candidate_design->ultrascale_dna_regs[0] =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        ultrascale_dna_base_offset, ultrascale_dna_frame_size);
-                        candidate_design->num_ultrascale_dna_regs = 1;
-                    }
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_AS02MC04_ENUM:
-                {
-                    const uint32_t peripherals_bar_index = 0;
-                    const uint32_t dma_bridge_bar_index = 1; /* Due to the peripherals BAR being 32-bit */
-                    const size_t user_access_base_offset = 0x0000;
-                    const size_t user_access_frame_size  = 0x1000;
-
-                    /* DMA bridge configured for "Memory Mapped" but no actual memory connected.
-                     * The following allows x2x_get_num_channels() to return valid results, but if attempts to actually
-                     * perform DMA will timeout. */
-                    candidate_design->dma_bridge_present = true;
-                    candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                    candidate_design->dma_bridge_memory_base_address = 0;
-                    candidate_design->dma_bridge_memory_size_bytes = 4096;
-
-                    candidate_design->user_access =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    user_access_base_offset, user_access_frame_size);
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_U200_ENUM:
-                {
-                    const uint32_t peripherals_bar_index = 0;
-                    const uint32_t dma_bridge_bar_index = 1; /* Due to the peripherals BAR being 32-bit */
-                    const size_t user_access_base_offset = 0x0000;
-                    const size_t user_access_frame_size  = 0x1000;
-
-                    /* DMA bridge configured for "Memory Mapped" but no actual memory connected.
-                     * The following allows x2x_get_num_channels() to return valid results, but if attempts to actually
-                     * perform DMA will timeout. */
-                    candidate_design->dma_bridge_present = true;
-                    candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                    candidate_design->dma_bridge_memory_base_address = 0;
-                    candidate_design->dma_bridge_memory_size_bytes = 4096;
-
-                    candidate_design->user_access =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    user_access_base_offset, user_access_frame_size);
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_U200_100G_ETHER_SIMPLEX_TX:
-                {
-                    const uint32_t peripherals_bar_index    = 0;
-                    const uint32_t dma_bridge_bar_index     = 2;
-                    const size_t user_access_base_offset    = 0x02000;
-                    const size_t user_access_frame_size     = 0x02000;
-                    const size_t sysmon_base_offset         = 0x04000;
-                    const size_t sysmon_frame_size          = 0x02000;
-                    const size_t quad_spi_base_offset       = 0x06000;
-                    const size_t quad_spi_frame_size        = 0x02000;
-                    const size_t ultrascale_dna_base_offset = 0x08000;
-                    const size_t ultrascale_dna_frame_size  = 0x01000;
-                    const size_t cms_base_offset            = 0x40000;
-                    const size_t cmac_registers_base_offsets[] =
-                    {
-                        0x00000,
-                        0x10000
-                    };
-                    const size_t cmac_registers_frame_size  = 0x02000;
-
-                    candidate_design->dma_bridge_present = true;
-                    candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                    candidate_design->dma_bridge_memory_size_bytes = 0; /* DMA bridge configured for "AXI Stream" */
-                    candidate_design->user_access =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    user_access_base_offset, user_access_frame_size);
-                    if (vfio_device->pci_revision_id >= 1)
-                    {
-                        candidate_design->quad_spi_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        quad_spi_base_offset, quad_spi_frame_size);
-                        candidate_design->sysmon_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index, sysmon_base_offset, sysmon_frame_size);
-                        candidate_design->num_sysmon_slaves = 2;
-                        candidate_design->cms_subsystem_present = true;
-                        candidate_design->cms_subsystem_bar_index = peripherals_bar_index;
-                        candidate_design->cms_subsystem_base_offset = cms_base_offset;
-                    }
-
-                    candidate_design->num_cmac_ports = (vfio_device->pci_revision_id >= 2) ? 2 : 1;
-                    for (uint32_t port_index = 0; port_index < candidate_design->num_cmac_ports; port_index++)
-                    {
-                        cmac_port_definition_t *const port_def = &candidate_design->cmac_ports[port_index];
-
-                        port_def->cmac_control_status_statistics_regs = map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                cmac_registers_base_offsets[port_index], cmac_registers_frame_size);
-                        port_def->cmac_drp_regs = NULL; /* Not implemented in this design */
-                        port_def->configured_features[CMAC_FEATURE_PACKET_RX] = false;
-                        port_def->configured_features[CMAC_FEATURE_PACKET_TX] = true;
-                        port_def->configured_features[CMAC_FEATURE_RS_FEC   ] = true;
-                        port_def->configured_features[CMAC_FEATURE_TX_OTN   ] = false;
-                        port_def->configured_features[CMAC_FEATURE_DRP      ] = false;
-                    }
-
-                    if (vfio_device->pci_revision_id >= 3)
-                    {
-                        candidate_design->ultrascale_dna_regs[0] =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        ultrascale_dna_base_offset, ultrascale_dna_frame_size);
-                        candidate_design->num_ultrascale_dna_regs = 1;
-                    }
-
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_U200_DMA_STREAM_CRC64:
-                {
-                    const uint32_t peripherals_bar_index = 0;
-                    const uint32_t dma_bridge_bar_index = 2;
-                    const size_t quad_spi_base_offset    = 0x0000;
-                    const size_t quad_spi_frame_size     = 0x1000;
-                    const size_t user_access_base_offset = 0x1000;
-                    const size_t user_access_frame_size  = 0x1000;
-                    const size_t sysmon_base_offset      = 0x2000;
-                    const size_t sysmon_frame_size       = 0x2000;
-
-                    candidate_design->dma_bridge_present = true;
-                    candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                    candidate_design->dma_bridge_memory_size_bytes = 0; /* DMA bridge configured for "AXI Stream" */
-                    candidate_design->quad_spi_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    quad_spi_base_offset, quad_spi_frame_size);
-                    candidate_design->sysmon_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, sysmon_base_offset, sysmon_frame_size);
-                    candidate_design->num_sysmon_slaves = 2;
-                    candidate_design->user_access =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    user_access_base_offset, user_access_frame_size);
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_U200_IBERT_100G_ETHER:
-                {
-                    const uint32_t peripherals_bar_index = 0;
-                    const size_t quad_spi_base_offset    = 0x44000;
-                    const size_t quad_spi_frame_size     = 0x01000;
-                    const size_t user_access_base_offset = 0x42000;
-                    const size_t user_access_frame_size  = 0x01000;
-                    const size_t sysmon_base_offset      = 0x40000;
-                    const size_t sysmon_frame_size       = 0x02000;
-
-                    /* While the design uses the DMA/Bridge Subsystem, is configured for AXI Bridge mode so the DMA bridge
-                     * isn't present. */
-                    candidate_design->dma_bridge_present = false;
-
-                    candidate_design->quad_spi_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    quad_spi_base_offset, quad_spi_frame_size);
-                    candidate_design->sysmon_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, sysmon_base_offset, sysmon_frame_size);
-                    candidate_design->num_sysmon_slaves = 2;
-                    candidate_design->user_access =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    user_access_base_offset, user_access_frame_size);
-                    candidate_design->cms_subsystem_present = true;
-                    candidate_design->cms_subsystem_bar_index = peripherals_bar_index;
-                    candidate_design->cms_subsystem_base_offset = 0x0;
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_OPEN_NIC:
-                {
-                    /* The addresses are taken from comments in
-                     * https://github.com/Xilinx/open-nic-shell/blob/main/src/system_config/system_config_address_map.sv */
-                    const uint32_t qdma_bridge_bar_index = 0;
-                    const uint32_t peripherals_bar_index = 2;
-                    const size_t sysmon_base_offset               = 0x010000;
-                    const size_t sysmon_frame_size                = 0x002000;
-                    const size_t cms_base_offset                  = 0x300000;
-                    const size_t quad_spi_base_offset             = 0x340000;
-                    const size_t quad_spi_frame_size              = 0x001000;
-                    const size_t cmac_registers_base_offsets[] =
-                    {
-                        0x008000,
-                        0x00C000
-                    };
-                    const size_t cmac_registers_frame_size        = 0x002000;
-
-                    candidate_design->qdma_present = true;
-                    candidate_design->qdma_bridge_bar = qdma_bridge_bar_index;
-                    candidate_design->qdma_memory_base_address = 0x0;
-                    candidate_design->qdma_memory_size_bytes   = 0x0;
-
-                    candidate_design->quad_spi_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    quad_spi_base_offset, quad_spi_frame_size);
-                    candidate_design->sysmon_regs =
-                            map_vfio_registers_block (vfio_device, peripherals_bar_index, sysmon_base_offset, sysmon_frame_size);
-                    candidate_design->num_sysmon_slaves = 2;
-                    candidate_design->cms_subsystem_present = true;
-                    candidate_design->cms_subsystem_bar_index = peripherals_bar_index;
-                    candidate_design->cms_subsystem_base_offset = cms_base_offset;
-
-                    candidate_design->num_cmac_ports = 2;
-                    for (uint32_t port_index = 0; port_index < candidate_design->num_cmac_ports; port_index++)
-                    {
-                        cmac_port_definition_t *const port_def = &candidate_design->cmac_ports[port_index];
-
-                        port_def->cmac_control_status_statistics_regs = map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                cmac_registers_base_offsets[port_index], cmac_registers_frame_size);
-                        port_def->cmac_drp_regs = NULL; /* Not implemented in this design */
-                        port_def->configured_features[CMAC_FEATURE_PACKET_RX] = true;
-                        port_def->configured_features[CMAC_FEATURE_PACKET_TX] = true;
-                        port_def->configured_features[CMAC_FEATURE_RS_FEC   ] = true;
-                        port_def->configured_features[CMAC_FEATURE_TX_OTN   ] = false;
-                        port_def->configured_features[CMAC_FEATURE_DRP      ] = false;
-                    }
-
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_XCKU5P_PCIE_DDR4_ETH:
-                {
-                    const uint32_t dma_bridge_bar_index = 0;
-
-                    candidate_design->dma_bridge_present = true;
-                    candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                    candidate_design->dma_bridge_memory_base_address = 0;
-                    candidate_design->dma_bridge_memory_size_bytes = 2048UL * 1024 * 1024;
-                    design_identified = true;
-                }
-                break;
-
-                case FPGA_DESIGN_VD100_ENUM:
-                    {
-                        const uint32_t dma_bridge_bar_index = 1; /* Due to the peripherals BAR being 32-bit */
-
-                        /* DMA bridge configured for "Memory Mapped" but no actual memory connected.
-                         * The following allows x2x_get_num_channels() to return valid results, but if attempts to actually
-                         * perform DMA will timeout. */
-                        candidate_design->dma_bridge_present = true;
-                        candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                        candidate_design->dma_bridge_memory_base_address = 0;
-                        candidate_design->dma_bridge_memory_size_bytes = 4096;
-                        design_identified = true;
-                    }
-                    break;
-
-                case FPGA_DESIGN_VD100_DMA_STREAM_CRC64:
-                    {
-                        const uint32_t dma_bridge_bar_index = 0; /* Due to the peripherals BAR not being used */
-
-                        candidate_design->dma_bridge_present = true;
-                        candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                        candidate_design->dma_bridge_memory_size_bytes = 0; /* DMA bridge configured for "AXI Stream" */
-                        design_identified = true;
-                    }
-                    break;
-
-                case FPGA_DESIGN_VD100_DMA_STREAM_LOOPBACK:
-                    {
-                        const uint32_t peripherals_bar_index = 0;
-                        const uint32_t dma_bridge_bar_index = 2;
-                        const size_t axi_switch_base_offset  = 0x0000;
-                        const size_t axi_switch_frame_size   = 0x1000;
-
-                        candidate_design->dma_bridge_present = true;
-                        candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                        candidate_design->dma_bridge_memory_size_bytes = 0; /* DMA bridge configured for "AXI Stream" */
-                        candidate_design->axi_switch_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        axi_switch_base_offset, axi_switch_frame_size);
-                        candidate_design->axi_switch_num_master_ports = 4;
-                        candidate_design->axi_switch_num_slave_ports = 4;
-                        design_identified = true;
-                    }
-                    break;
-
-                case FPGA_DESIGN_VD100_DMA_DDR4:
-                    {
-                        const uint32_t dma_bridge_bar_index = 0; /* Due to the peripherals BAR not being used */
-
-                        candidate_design->dma_bridge_present = true;
-                        candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                        candidate_design->dma_bridge_memory_base_address = 0x800000000;
-                        candidate_design->dma_bridge_memory_size_bytes   = 0x100000000;
-                        design_identified = true;
-                    }
-                    break;
-
-                case FPGA_DESIGN_VD100_QDMA_DDR4:
-                    {
-                        const uint32_t qdma_bridge_bar_index = 0;
-
-                        candidate_design->qdma_present = true;
-                        candidate_design->qdma_bridge_bar = qdma_bridge_bar_index;
-                        candidate_design->qdma_memory_base_address = 0x800000000;
-                        candidate_design->qdma_memory_size_bytes   = 0x100000000;
-                        design_identified = true;
-                    }
-                    break;
-
-                case FPGA_DESIGN_U200_QDMA_RAM:
-                    {
-                        const uint32_t qdma_bridge_bar_index = 0;
-                        const uint32_t peripherals_bar_index = 2;
-                        const size_t user_access_base_offset = 0x0000;
-                        const size_t user_access_frame_size  = 0x1000;
-
-                        candidate_design->qdma_present = true;
-                        candidate_design->qdma_bridge_bar = qdma_bridge_bar_index;
-                        candidate_design->qdma_memory_base_address = 0x000000;
-                        candidate_design->qdma_memory_size_bytes   = 0x800000;
-                        candidate_design->user_access =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        user_access_base_offset, user_access_frame_size);
-                        design_identified = true;
-                    }
-                    break;
-
-                case FPGA_DESIGN_VD100_10G_ETHER_DUAL:
-                    {
-                        const uint32_t peripherals_bar_index = 0;
-                        const uint32_t dma_bridge_bar_index = 2;
-                        const size_t mrmac_base_offset    = 0x00000;
-                        const size_t mrmac_frame_size     = 0x10000;
-                        const size_t iic_base_offset      = 0x11000;
-                        const size_t iic_frame_size       = 0x01000;
-
-                        candidate_design->mrmac.regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index, mrmac_base_offset, mrmac_frame_size);
-                        candidate_design->mrmac.used_ports[0] = true;
-                        candidate_design->mrmac.used_ports[1] = true;
-                        candidate_design->mrmac.used_ports[2] = false;
-                        candidate_design->mrmac.used_ports[3] = false;
-                        candidate_design->iic_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index, iic_base_offset, iic_frame_size);
-                        candidate_design->dma_bridge_present = true;
-                        candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                        candidate_design->dma_bridge_memory_size_bytes = 0; /* DMA bridge configured for "AXI Stream" */
-                        design_identified = true;
-                    }
-                    break;
-
-                case FPGA_DESIGN_VMK180_100G_ETHER:
-                    {
-                        const uint32_t peripherals_bar_index = 0;
-                        const uint32_t dma_bridge_bar_index = 2;
-                        const size_t mrmac_base_offset    = 0x00000;
-                        const size_t mrmac_frame_size     = 0x10000;
-
-
-                        candidate_design->mrmac.regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index, mrmac_base_offset, mrmac_frame_size);
-                        candidate_design->mrmac.used_ports[0] = true;
-                        candidate_design->mrmac.used_ports[1] = false;
-                        candidate_design->mrmac.used_ports[2] = false;
-                        candidate_design->mrmac.used_ports[3] = false;
-                        candidate_design->dma_bridge_present = true;
-                        candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                        candidate_design->dma_bridge_memory_size_bytes = 0; /* DMA bridge configured for "AXI Stream" */
-                        design_identified = true;
-                    }
-                    break;
-
-                case FPGA_DESIGN_VD100_25G_ETHER_DUAL:
-                    {
-                        const uint32_t peripherals_bar_index = 0;
-                        const uint32_t dma_bridge_bar_index = 2;
-                        const size_t mrmac_base_offset    = 0x00000;
-                        const size_t mrmac_frame_size     = 0x10000;
-                        const size_t iic_base_offset      = 0x11000;
-                        const size_t iic_frame_size       = 0x01000;
-
-                        candidate_design->mrmac.regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index, mrmac_base_offset, mrmac_frame_size);
-                        candidate_design->mrmac.used_ports[0] = true;
-                        candidate_design->mrmac.used_ports[1] = true;
-                        candidate_design->mrmac.used_ports[2] = false;
-                        candidate_design->mrmac.used_ports[3] = false;
-                        candidate_design->iic_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index, iic_base_offset, iic_frame_size);
-                        candidate_design->dma_bridge_present = true;
-                        candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                        candidate_design->dma_bridge_memory_size_bytes = 0; /* DMA bridge configured for "AXI Stream" */
-                        design_identified = true;
-                    }
-                    break;
-
-                case FPGA_DESIGN_U200_100G_ETHER_DUPLEX:
-                    {
-                        const uint32_t peripherals_bar_index    = 0;
-                        const uint32_t dma_bridge_bar_index     = 2;
-                        const size_t user_access_base_offset    = 0x02000;
-                        const size_t user_access_frame_size     = 0x02000;
-                        const size_t sysmon_base_offset         = 0x04000;
-                        const size_t sysmon_frame_size          = 0x02000;
-                        const size_t quad_spi_base_offset       = 0x06000;
-                        const size_t quad_spi_frame_size        = 0x02000;
-                        const size_t ultrascale_dna_base_offset = 0x08000;
-                        const size_t ultrascale_dna_frame_size  = 0x01000;
-                        const size_t axi_switch_base_offset     = 0x09000;
-                        const size_t axi_switch_frame_size      = 0x01000;
-                        const size_t cms_base_offset            = 0x40000;
-                        const size_t cmac_control_status_statistics_registers_base_offsets[] =
-                        {
-                            0x00000,
-                            0x10000
-                        };
-                        const size_t cmac_control_status_statistics_registers_frame_size  = 0x02000;
-                        const size_t cmac_drp_registers_base_offsets[] =
-                        {
-                            0x0A000,
-                            0x0B000
-                        };
-                        const size_t cmac_drp_registers_frame_size = 0x1000;
-
-                        candidate_design->dma_bridge_present = true;
-                        candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                        candidate_design->dma_bridge_memory_size_bytes = 0; /* DMA bridge configured for "AXI Stream" */
-                        candidate_design->user_access =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        user_access_base_offset, user_access_frame_size);
-                        candidate_design->quad_spi_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        quad_spi_base_offset, quad_spi_frame_size);
-                        candidate_design->sysmon_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index, sysmon_base_offset, sysmon_frame_size);
-                        candidate_design->num_sysmon_slaves = 2;
-                        candidate_design->cms_subsystem_present = true;
-                        candidate_design->cms_subsystem_bar_index = peripherals_bar_index;
-                        candidate_design->cms_subsystem_base_offset = cms_base_offset;
-
-                        candidate_design->num_cmac_ports = 2;
-                        for (uint32_t port_index = 0; port_index < candidate_design->num_cmac_ports; port_index++)
-                        {
-                            cmac_port_definition_t *const port_def = &candidate_design->cmac_ports[port_index];
-
-                            port_def->cmac_control_status_statistics_regs = map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    cmac_control_status_statistics_registers_base_offsets[port_index],
-                                    cmac_control_status_statistics_registers_frame_size);
-                            port_def->configured_features[CMAC_FEATURE_PACKET_RX] = true;
-                            port_def->configured_features[CMAC_FEATURE_PACKET_TX] = true;
-                            port_def->configured_features[CMAC_FEATURE_RS_FEC   ] = true;
-                            port_def->configured_features[CMAC_FEATURE_TX_OTN   ] = false;
-                            port_def->configured_features[CMAC_FEATURE_DRP      ] = vfio_device->pci_revision_id >= 2;
-                            if (port_def->configured_features[CMAC_FEATURE_DRP])
-                            {
-                                port_def->cmac_drp_regs = map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        cmac_drp_registers_base_offsets[port_index], cmac_drp_registers_frame_size);
-                            }
-                            else
-                            {
-                                port_def->cmac_drp_regs = NULL;
-                            }
-                        }
-
-                        candidate_design->ultrascale_dna_regs[0] =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        ultrascale_dna_base_offset, ultrascale_dna_frame_size);
-                        candidate_design->num_ultrascale_dna_regs = 1;
-
-                        if (vfio_device->pci_revision_id >= 1)
-                        {
-                            candidate_design->axi_switch_regs = map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                    axi_switch_base_offset, axi_switch_frame_size);
-                            candidate_design->axi_switch_num_master_ports = 4;
-                            candidate_design->axi_switch_num_slave_ports = 4;
-                        }
-
-                        design_identified = true;
-                    }
-                    break;
-
-                case FPGA_DESIGN_AS02MC04_QDMA_ENUM:
-                    {
-                        const uint32_t qdma_bridge_bar_index = 0;
-                        const uint32_t peripherals_bar_index = 2;
-                        const size_t user_access_base_offset = 0x0000;
-                        const size_t user_access_frame_size  = 0x1000;
-
-                        candidate_design->qdma_present = true;
-                        candidate_design->qdma_bridge_bar = qdma_bridge_bar_index;
-                        candidate_design->qdma_memory_base_address = 0x0;
-                        candidate_design->qdma_memory_size_bytes   = 0x0;
-                        candidate_design->user_access =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        user_access_base_offset, user_access_frame_size);
-                        design_identified = true;
-                    }
-                    break;
-
-                case FPGA_DESIGN_VD100_40G_ETHER:
-                    {
-                        const uint32_t peripherals_bar_index = 0;
-                        const uint32_t dma_bridge_bar_index = 2;
-                        const size_t mrmac_base_offset    = 0x00000;
-                        const size_t mrmac_frame_size     = 0x10000;
-                        const size_t iic_base_offset      = 0x11000;
-                        const size_t iic_frame_size       = 0x01000;
-
-                        candidate_design->mrmac.regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index, mrmac_base_offset, mrmac_frame_size);
-                        candidate_design->mrmac.used_ports[0] = true;
-                        candidate_design->mrmac.used_ports[1] = false;
-                        candidate_design->mrmac.used_ports[2] = false;
-                        candidate_design->mrmac.used_ports[3] = false;
-                        candidate_design->iic_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index, iic_base_offset, iic_frame_size);
-                        candidate_design->dma_bridge_present = true;
-                        candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                        candidate_design->dma_bridge_memory_size_bytes = 0; /* DMA bridge configured for "AXI Stream" */
-                        design_identified = true;
-                    }
-                    break;
-
-                case FPGA_DESIGN_XCKU5P_SINGLE_QSFP_DMA_STREAM_LOOPBACK:
-                    {
-                        const uint32_t peripherals_bar_index    = 0;
-                        const uint32_t dma_bridge_bar_index     = 2;
-                        const size_t quad_spi_base_offset       = 0x0000;
-                        const size_t quad_spi_frame_size        = 0x1000;
-                        const size_t sysmon_base_offset         = 0x1000;
-                        const size_t sysmon_frame_size          = 0x1000;
-                        const size_t user_access_base_offset    = 0x2000;
-                        const size_t user_access_frame_size     = 0x1000;
-                        const size_t axi_switch_base_offset     = 0x3000;
-                        const size_t axi_switch_frame_size      = 0x1000;
-                        const size_t ultrascale_dna_base_offset = 0x4000;
-                        const size_t ultrascale_dna_frame_size  = 0x1000;
-
-                        candidate_design->dma_bridge_present = true;
-                        candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                        candidate_design->dma_bridge_memory_size_bytes = 0; /* DMA bridge configured for "AXI Stream" */
-                        candidate_design->quad_spi_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        quad_spi_base_offset, quad_spi_frame_size);
-                        candidate_design->sysmon_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index, sysmon_base_offset, sysmon_frame_size);
-                        candidate_design->num_sysmon_slaves = 0;
-                        candidate_design->user_access =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        user_access_base_offset, user_access_frame_size);
-                        candidate_design->axi_switch_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        axi_switch_base_offset, axi_switch_frame_size);
-                        candidate_design->axi_switch_num_master_ports = 4;
-                        candidate_design->axi_switch_num_slave_ports = 4;
-                        candidate_design->ultrascale_dna_regs[0] =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        ultrascale_dna_base_offset, ultrascale_dna_frame_size);
-                        candidate_design->num_ultrascale_dna_regs = 1;
-                        design_identified = true;
-                    }
-                    break;
-
-                case FPGA_DESIGN_XCKU5P_SINGLE_QSFP_DMA_DDR4:
-                    {
-                        const uint32_t peripherals_bar_index    = 0;
-                        const uint32_t dma_bridge_bar_index     = 2;
-                        const size_t quad_spi_base_offset       = 0x0000;
-                        const size_t quad_spi_frame_size        = 0x1000;
-                        const size_t sysmon_base_offset         = 0x1000;
-                        const size_t sysmon_frame_size          = 0x1000;
-                        const size_t user_access_base_offset    = 0x2000;
-                        const size_t user_access_frame_size     = 0x1000;
-                        const size_t ultrascale_dna_base_offset = 0x3000;
-                        const size_t ultrascale_dna_frame_size  = 0x1000;
-                        /* The GPIO at offset 0x4000 to control DDR4 not included here as not part of fpga_design_t */
-
-                        candidate_design->dma_bridge_present = true;
-                        candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                        candidate_design->dma_bridge_memory_base_address = 0;
-                        candidate_design->dma_bridge_memory_size_bytes = 2048UL * 1024 * 1024;
-                        candidate_design->quad_spi_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        quad_spi_base_offset, quad_spi_frame_size);
-                        candidate_design->sysmon_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index, sysmon_base_offset, sysmon_frame_size);
-                        candidate_design->num_sysmon_slaves = 0;
-                        candidate_design->user_access =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        user_access_base_offset, user_access_frame_size);
-                        candidate_design->ultrascale_dna_regs[0] =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        ultrascale_dna_base_offset, ultrascale_dna_frame_size);
-                        candidate_design->num_ultrascale_dna_regs = 1;
-                        design_identified = true;
-                    }
-                    break;
-
-                case FPGA_DESIGN_U200_DMA_DDR4:
-                    {
-                        const uint32_t peripherals_bar_index    = 0;
-                        const uint32_t dma_bridge_bar_index     = 2;
-                        const size_t sysmon_base_offset         = 0x04000;
-                        const size_t sysmon_frame_size          = 0x02000;
-                        const size_t quad_spi_base_offset       = 0x06000;
-                        const size_t quad_spi_frame_size        = 0x01000;
-                        const size_t user_access_base_offset    = 0x07000;
-                        const size_t user_access_frame_size     = 0x01000;
-                        const size_t ultrascale_dna_base_offset = 0x08000;
-                        const size_t ultrascale_dna_frame_size  = 0x01000;
-                        const size_t cms_base_offset            = 0x40000;
-
-                        candidate_design->dma_bridge_present = true;
-                        candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                        switch (vfio_device->pci_revision_id)
-                        {
-                        case 0:
-                            /* The original revision which uses all 4 DDR4 channels for 64GB */
-                            candidate_design->dma_bridge_memory_base_address = 0;
-                            candidate_design->dma_bridge_memory_size_bytes = 64UL * 1024UL * 1024UL * 1024UL;
-                            break;
-
-                        case 1:
-                            /* Only uses DDR4 channels 0 and 1 */
-                            candidate_design->dma_bridge_memory_base_address = 0;
-                            candidate_design->dma_bridge_memory_size_bytes = 32UL * 1024UL * 1024UL * 1024UL;
-                            break;
-
-                        case 2:
-                            /* Only uses DDR4 channels 2 and 3 */
-                            candidate_design->dma_bridge_memory_base_address = 32UL * 1024UL * 1024UL * 1024UL;
-                            candidate_design->dma_bridge_memory_size_bytes = 32UL * 1024UL * 1024UL * 1024UL;
-                            break;
-
-                        case 3:
-                            /* Only uses DDR4 channel 0 */
-                            candidate_design->dma_bridge_memory_base_address = 0;
-                            candidate_design->dma_bridge_memory_size_bytes = 16UL * 1024UL * 1024UL * 1024UL;
-                            break;
-
-                        case 4:
-                            /* Use all DDR4 channels, configured as 8GB per channel to match the RDIMMs in a AU200A32G */
-                            candidate_design->dma_bridge_memory_base_address = 0;
-                            candidate_design->dma_bridge_memory_size_bytes = 32UL * 1024UL * 1024UL * 1024UL;
-                            break;
-                        }
-                        candidate_design->user_access =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        user_access_base_offset, user_access_frame_size);
-                        candidate_design->quad_spi_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        quad_spi_base_offset, quad_spi_frame_size);
-                        candidate_design->sysmon_regs =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index, sysmon_base_offset, sysmon_frame_size);
-                        candidate_design->num_sysmon_slaves = 2;
-                        candidate_design->ultrascale_dna_regs[0] =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        ultrascale_dna_base_offset, ultrascale_dna_frame_size);
-                        candidate_design->num_ultrascale_dna_regs = 1;
-                        candidate_design->cms_subsystem_present = true;
-                        candidate_design->cms_subsystem_bar_index = peripherals_bar_index;
-                        candidate_design->cms_subsystem_base_offset = cms_base_offset;
-                        design_identified = true;
-                    }
-                    break;
-
-                case FPGA_DESIGN_U200_SLR_IDS:
-                    {
-                        const uint32_t peripherals_bar_index    = 0;
-                        const uint32_t dma_bridge_bar_index     = 1; /* Due to the peripherals BAR being 32-bit */
-                        const size_t user_access_base_offset    = 0x03000;
-                        const size_t user_access_frame_size     = 0x01000;
-                        const size_t ultrascale_dna_base_offset = 0x00000;
-                        const size_t ultrascale_dna_frame_size  = 0x01000;
-
-                        /* DMA bridge configured for "Memory Mapped" but no actual memory connected.
-                         * The following allows x2x_get_num_channels() to return valid results, but if attempts to actually
-                         * perform DMA will timeout. */
-                        candidate_design->dma_bridge_present = true;
-                        candidate_design->dma_bridge_bar = dma_bridge_bar_index;
-                        candidate_design->dma_bridge_memory_base_address = 0;
-                        candidate_design->dma_bridge_memory_size_bytes = 4096;
-
-                        candidate_design->user_access =
-                                map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                        user_access_base_offset, user_access_frame_size);
-
-                        candidate_design->num_ultrascale_dna_regs = 3;
-                        for (uint32_t slr_index = 0; slr_index < candidate_design->num_ultrascale_dna_regs; slr_index++)
-                        {
-                            candidate_design->ultrascale_dna_regs[slr_index] =
-                                    map_vfio_registers_block (vfio_device, peripherals_bar_index,
-                                            ultrascale_dna_base_offset + (slr_index * ultrascale_dna_frame_size),
-                                            ultrascale_dna_frame_size);
-                        }
-
-                        design_identified = true;
-                    }
-                    break;
-
-                case FPGA_DESIGN_ARRAY_SIZE:
-                    /* Shouldn't get here */
-                    design_identified = false;
-                    break;
-                }
-            }
-
-            if (design_identified)
-            {
-                candidate_design->design_id = candidate_design_id;
-                candidate_design->vfio_device = vfio_device;
-                candidate_design->design_index = designs->num_identified_designs;
-                designs->num_identified_designs++;
-            }
-            else
-            {
-                candidate_design_id++;
-            }
-        }
+    case 0:
+        /* The original revision which uses all 4 DDR4 channels for 64GB */
+        candidate_design->dma_bridge_memory_base_address = 0;
+        candidate_design->dma_bridge_memory_size_bytes = 64UL * 1024UL * 1024UL * 1024UL;
+        break;
+
+    case 1:
+        /* Only uses DDR4 channels 0 and 1 */
+        candidate_design->dma_bridge_memory_base_address = 0;
+        candidate_design->dma_bridge_memory_size_bytes = 32UL * 1024UL * 1024UL * 1024UL;
+        break;
+
+    case 2:
+        /* Only uses DDR4 channels 2 and 3 */
+        candidate_design->dma_bridge_memory_base_address = 32UL * 1024UL * 1024UL * 1024UL;
+        candidate_design->dma_bridge_memory_size_bytes = 32UL * 1024UL * 1024UL * 1024UL;
+        break;
+
+    case 3:
+        /* Only uses DDR4 channel 0 */
+        candidate_design->dma_bridge_memory_base_address = 0;
+        candidate_design->dma_bridge_memory_size_bytes = 16UL * 1024UL * 1024UL * 1024UL;
+        break;
+
+    case 4:
+        /* Use all DDR4 channels, configured as 8GB per channel to match the RDIMMs in a AU200A32G */
+        candidate_design->dma_bridge_memory_base_address = 0;
+        candidate_design->dma_bridge_memory_size_bytes = 32UL * 1024UL * 1024UL * 1024UL;
+        break;
     }
-}
-
-
-/**
- * @brief Close the VFIO devices which were opened by identify_pcie_fpga_designs()
- * @param[in/out] designs Contains the VFIO devices to close
- */
-void close_pcie_fpga_designs (fpga_designs_t *const designs)
-{
-    close_vfio_devices (&designs->vfio_devices);
-}
-
-
-/**
- * @brief Display the possible FPGA designs in the PC which can be opened by identify_pcie_fpga_designs()
- * @details This only needs to scan the PCI bus, and doesn't attempt to open supported PCI devices using VFIO
- */
-void display_possible_fpga_designs (void)
-{
-    display_possible_vfio_devices (FPGA_DESIGN_ARRAY_SIZE, fpga_design_pci_filters, fpga_design_names);
-}
-
-
-/**
- * @brief Format a string containing the timestamp embedded in the the user access (AXSS register) in the bitstream
- * @param[in] user_access The value of the user access to format
- * @param[out] formatted_timestamp The formatted timestamp string
- */
-void format_user_access_timestamp (const uint32_t user_access,
-                                   char formatted_timestamp[const USER_ACCESS_TIMESTAMP_LEN])
-{
-    /* Extract the individual bit fields of the timestamp */
-    const uint32_t day    = (user_access & 0xf8000000) >> 27;
-    const uint32_t month  = (user_access & 0x07800000) >> 23;
-    const uint32_t year   = (user_access & 0x007e0000) >> 17;
-    const uint32_t hour   = (user_access & 0x0001f000) >> 12;
-    const uint32_t minute = (user_access & 0x00000fc0) >>  6;
-    const uint32_t second = (user_access & 0x0000003f);
-
-    const uint32_t epoch_year = 2000;
 
-    snprintf (formatted_timestamp, USER_ACCESS_TIMESTAMP_LEN, "%02u/%02u/%04u %02u:%02u:%02u",
-            day, month, year + epoch_year, hour, minute, second);
+    return true;
 }
 
 
-/**
- * @brief Display information about a peripheral which is present in an identified design
- * @param[in] design The identified design to check for the peripheral
- * @param[in] peripheral_name The name of the peripheral
- * @param[in] peripheral_mapped_base If non-NULL the mapped base of the peripheral which is present in the design.
- */
-void display_design_present_peripheral (const fpga_design_t *const design,
-                                        const char *const peripheral_name, const uint8_t *const peripheral_mapped_base)
+/* Defines the contents of each design. Where a design has been revised to add register blocks, the revision is given by
+ * the min_revision_id of the block. */
+static const fpga_design_descriptor_t fpga_design_descriptors[FPGA_DESIGN_ARRAY_SIZE] =
 {
-    if (peripheral_mapped_base != NULL)
+    [FPGA_DESIGN_DMA_BLKRAM] =
     {
-        /* The peripheral is present since its registers are mapped.
-         * Search to find the offset into which BAR the registers are mapped to. */
-        bool found_bar;
-        uint32_t bar_number;
-        ptrdiff_t bar_offset;
-
-        found_bar = false;
-        bar_number = 0;
-        bar_offset = 0;
-        while (!found_bar && (bar_number < PCI_STD_NUM_BARS))
+        /* The total amount of BLKRAM addressable by DMA. Sizes set to maximise BLKRAM usage in FPGA.
+         * Uses BAR 0 for the DMA bridge since the PCIe to AXI Lite Master Interface isn't used. */
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 0,
+        .dma_bridge_memory_base_address = 0,
+        .dma_bridge_memory_size_bytes = (1024 * 1024) + (128 * 1024)
+    },
+    [FPGA_DESIGN_I2C_PROBE] =
+    {
+        .blocks =
         {
-            if (design->vfio_device->mapped_bars[bar_number] != NULL)
-            {
-                const uint8_t *const mapped_bar_start = design->vfio_device->mapped_bars[bar_number];
-                const uint8_t *const mapped_bar_end = &mapped_bar_start[design->vfio_device->regions_info[bar_number].size];
-
-                if ((peripheral_mapped_base >= mapped_bar_start) && (peripheral_mapped_base < mapped_bar_end))
-                {
-                    bar_offset = peripheral_mapped_base - mapped_bar_start;
-                    found_bar = true;
-                }
-            }
-
-            if (!found_bar)
-            {
-                bar_number++;
-            }
+            {.type = FPGA_DESIGN_BLOCK_IIC,                 .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_BIT_BANGED_I2C_GPIO, .bar_index = 0, .base_offset = 0x1000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,            .bar_index = 0, .base_offset = 0x2000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_XADC,                .bar_index = 0, .base_offset = 0x3000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_TOSING_160T_DMA_DDR3] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .dma_bridge_memory_base_address = 0,
+        .dma_bridge_memory_size_bytes = 1024UL * 1024 * 1024,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,    .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_XADC,        .bar_index = 0, .base_offset = 0x1000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS, .bar_index = 0, .base_offset = 0x2000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_LITEFURY_PROJECT0] =
+    {
+        .probe = identify_fury_project0,
+        .dma_bridge_present = true,
+        .dma_bridge_bar = FURY_PROJECT0_DMA_BRIDGE_BAR,
+        .dma_bridge_memory_base_address = 0,
+        .dma_bridge_memory_size_bytes = 512UL * 1024 * 1024,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI, .bar_index = FURY_PROJECT0_AXI_PERIPHERALS_BAR,
+             .base_offset = FURY_PROJECT0_QUAD_SPI_BASE_OFFSET, .frame_size = FURY_PROJECT0_PERIPHERAL_FRAME_SIZE},
+            {.type = FPGA_DESIGN_BLOCK_XADC, .bar_index = FURY_PROJECT0_AXI_PERIPHERALS_BAR,
+             .base_offset = FURY_PROJECT0_XADC_WIZ_BASE_OFFSET, .frame_size = FURY_PROJECT0_PERIPHERAL_FRAME_SIZE}
+        }
+    },
+    [FPGA_DESIGN_NITEFURY_PROJECT0] =
+    {
+        .probe = identify_fury_project0,
+        .dma_bridge_present = true,
+        .dma_bridge_bar = FURY_PROJECT0_DMA_BRIDGE_BAR,
+        .dma_bridge_memory_base_address = 0,
+        .dma_bridge_memory_size_bytes = 1024UL * 1024 * 1024,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI, .bar_index = FURY_PROJECT0_AXI_PERIPHERALS_BAR,
+             .base_offset = FURY_PROJECT0_QUAD_SPI_BASE_OFFSET, .frame_size = FURY_PROJECT0_PERIPHERAL_FRAME_SIZE},
+            {.type = FPGA_DESIGN_BLOCK_XADC, .bar_index = FURY_PROJECT0_AXI_PERIPHERALS_BAR,
+             .base_offset = FURY_PROJECT0_XADC_WIZ_BASE_OFFSET, .frame_size = FURY_PROJECT0_PERIPHERAL_FRAME_SIZE}
+        }
+    },
+    [FPGA_DESIGN_TEF1001_DMA_DDR3] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .dma_bridge_memory_base_address = 0,
+        .dma_bridge_memory_size_bytes = 8192UL * 1024 * 1024,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_IIC,                 .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_BIT_BANGED_I2C_GPIO, .bar_index = 0, .base_offset = 0x1000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,            .bar_index = 0, .base_offset = 0x2000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_XADC,                .bar_index = 0, .base_offset = 0x3000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS,         .bar_index = 0, .base_offset = 0x4000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_NITEFURY_DMA_DDR3] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .dma_bridge_memory_base_address = 0,
+        .dma_bridge_memory_size_bytes = 1024UL * 1024 * 1024,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,    .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_XADC,        .bar_index = 0, .base_offset = 0x1000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS, .bar_index = 0, .base_offset = 0x2000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_TEF1001_DMA_STREAM_LOOPBACK] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .axi_switch_num_master_ports = 2,
+        .axi_switch_num_slave_ports = 2,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_IIC,                 .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_BIT_BANGED_I2C_GPIO, .bar_index = 0, .base_offset = 0x1000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,            .bar_index = 0, .base_offset = 0x2000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_XADC,                .bar_index = 0, .base_offset = 0x3000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS,         .bar_index = 0, .base_offset = 0x4000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_AXI_SWITCH,          .bar_index = 0, .base_offset = 0x6000, .frame_size = 0x1000,
+             .min_revision_id = 1}
+        }
+    },
+    [FPGA_DESIGN_NITEFURY_DMA_STREAM_LOOPBACK] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .axi_switch_num_master_ports = 2,
+        .axi_switch_num_slave_ports = 2,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,    .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_XADC,        .bar_index = 0, .base_offset = 0x1000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS, .bar_index = 0, .base_offset = 0x2000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_AXI_SWITCH,  .bar_index = 0, .base_offset = 0x3000, .frame_size = 0x1000,
+             .min_revision_id = 1}
+        }
+    },
+    [FPGA_DESIGN_TOSING_160T_DMA_STREAM_LOOPBACK] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .axi_switch_num_master_ports = 2,
+        .axi_switch_num_slave_ports = 2,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,    .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_XADC,        .bar_index = 0, .base_offset = 0x1000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS, .bar_index = 0, .base_offset = 0x2000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_AXI_SWITCH,  .bar_index = 0, .base_offset = 0x3000, .frame_size = 0x1000,
+             .min_revision_id = 1}
+        }
+    },
+    [FPGA_DESIGN_XCKU5P_DUAL_QSFP_DMA_STREAM_LOOPBACK] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .num_sysmon_slaves = 0,
+        .axi_switch_num_master_ports = 4,
+        .axi_switch_num_slave_ports = 4,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,    .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_SYSMON,      .bar_index = 0, .base_offset = 0x1000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS, .bar_index = 0, .base_offset = 0x2000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_AXI_SWITCH,  .bar_index = 0, .base_offset = 0x3000, .frame_size = 0x1000,
+             .min_revision_id = 1}
+        }
+    },
+    [FPGA_DESIGN_XCKU5P_DUAL_QSFP_DMA_RAM] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .dma_bridge_memory_base_address = 0,
+        .dma_bridge_memory_size_bytes = 2UL * 1024 * 1024,
+        .num_sysmon_slaves = 0,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,    .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_SYSMON,      .bar_index = 0, .base_offset = 0x1000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS, .bar_index = 0, .base_offset = 0x2000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_XCKU5P_DUAL_QSFP_QDMA_RAM_QUAD_SPI] =
+    {
+        .qdma_present = true,
+        .qdma_bridge_bar = 0,
+        .qdma_memory_base_address = 0,
+        .qdma_memory_size_bytes = 2 * 1024 * 1024,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI, .bar_index = 2, .base_offset = 0x0000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_XCKU5P_DUAL_QSFP_QDMA_RAM_SYSMON] =
+    {
+        .num_sysmon_slaves = 0,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_SYSMON, .bar_index = 2, .base_offset = 0x0000, .frame_size = 0x1000}
         }
+    },
+    [FPGA_DESIGN_XCKU5P_DUAL_QSFP_QDMA_RAM_USER_ACCESS] =
+    {
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS, .bar_index = 2, .base_offset = 0x0000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_XCKU5P_DUAL_QSFP_QDMA_RAM_UART] =
+    {
+        /* The only peripheral on this design is a UART, which isn't supported as part of the identification.
+         * This design identification is a placeholder until QDMA support is added */
+    },
+    [FPGA_DESIGN_XCKU5P_DUAL_QSFP_DMA_STREAM_FIXED_DATA] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .num_sysmon_slaves = 0,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,    .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_SYSMON,      .bar_index = 0, .base_offset = 0x1000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS, .bar_index = 0, .base_offset = 0x2000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_TEF1001_DMA_STREAM_FIXED_DATA] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_IIC,                 .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_BIT_BANGED_I2C_GPIO, .bar_index = 0, .base_offset = 0x1000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,            .bar_index = 0, .base_offset = 0x2000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_XADC,                .bar_index = 0, .base_offset = 0x3000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS,         .bar_index = 0, .base_offset = 0x4000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_NITEFURY_DMA_STREAM_FIXED_DATA] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,    .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_XADC,        .bar_index = 0, .base_offset = 0x1000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS, .bar_index = 0, .base_offset = 0x2000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_TOSING_160T_DMA_STREAM_FIXED_DATA] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,    .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_XADC,        .bar_index = 0, .base_offset = 0x1000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS, .bar_index = 0, .base_offset = 0x2000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_XCKU5P_DUAL_QSFP_IBERT] =
+    {
+        .num_sysmon_slaves = 0,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,    .bar_index = 0, .base_offset = 0x4000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_SYSMON,      .bar_index = 0, .base_offset = 0x5000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS, .bar_index = 0, .base_offset = 0x6000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_TEF1001_DDR3_THROUGHPUT] =
+    {
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_XADC,        .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS, .bar_index = 0, .base_offset = 0x1000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_XCKU5P_DUAL_QSFP_DMA_STREAM_CRC64] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .num_sysmon_slaves = 0,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,    .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_SYSMON,      .bar_index = 0, .base_offset = 0x1000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS, .bar_index = 0, .base_offset = 0x2000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_TEF1001_DMA_STREAM_CRC64] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_IIC,                 .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_BIT_BANGED_I2C_GPIO, .bar_index = 0, .base_offset = 0x1000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,            .bar_index = 0, .base_offset = 0x2000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_XADC,                .bar_index = 0, .base_offset = 0x3000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS,         .bar_index = 0, .base_offset = 0x4000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_TOSING_160T_DMA_STREAM_CRC64] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,    .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_XADC,        .bar_index = 0, .base_offset = 0x1000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS, .bar_index = 0, .base_offset = 0x2000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_NITEFURY_DMA_STREAM_CRC64] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,    .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_XADC,        .bar_index = 0, .base_offset = 0x1000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS, .bar_index = 0, .base_offset = 0x2000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_AS02MC04_DMA_STREAM_CRC64] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .num_sysmon_slaves = 0,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,       .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_SYSMON,         .bar_index = 0, .base_offset = 0x1000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS,    .bar_index = 0, .base_offset = 0x2000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_ULTRASCALE_DNA, .bar_index = 0, .base_offset = 0x3000, .frame_size = 0x1000,
+             .min_revision_id = 1}
+        }
+    },
+    [FPGA_DESIGN_AS02MC04_ENUM] =
+    {
+        /* DMA bridge configured for "Memory Mapped" but no actual memory connected.
+         * The following allows x2x_get_num_channels() to return valid results, but if attempts to actually
+         * perform DMA will timeout.
+         * The DMA bridge is in BAR 1 due to the peripherals BAR being 32-bit. */
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 1,
+        .dma_bridge_memory_base_address = 0,
+        .dma_bridge_memory_size_bytes = 4096,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS, .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_U200_ENUM] =
+    {
+        /* DMA bridge configured for "Memory Mapped" but no actual memory connected.
+         * The following allows x2x_get_num_channels() to return valid results, but if attempts to actually
+         * perform DMA will timeout.
+         * The DMA bridge is in BAR 1 due to the peripherals BAR being 32-bit. */
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 1,
+        .dma_bridge_memory_base_address = 0,
+        .dma_bridge_memory_size_bytes = 4096,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS, .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_U200_100G_ETHER_SIMPLEX_TX] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .num_sysmon_slaves = 2,
+        .cmac_configured_features =
+        {
+            [CMAC_FEATURE_PACKET_RX] = false,
+            [CMAC_FEATURE_PACKET_TX] = true,
+            [CMAC_FEATURE_RS_FEC   ] = true,
+            [CMAC_FEATURE_TX_OTN   ] = false
+        },
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS,    .bar_index = 0, .base_offset = 0x02000, .frame_size = 0x02000},
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,       .bar_index = 0, .base_offset = 0x06000, .frame_size = 0x02000,
+             .min_revision_id = 1},
+            {.type = FPGA_DESIGN_BLOCK_SYSMON,         .bar_index = 0, .base_offset = 0x04000, .frame_size = 0x02000,
+             .min_revision_id = 1},
+            {.type = FPGA_DESIGN_BLOCK_CMS,            .bar_index = 0, .base_offset = 0x40000, .min_revision_id = 1},
+            {.type = FPGA_DESIGN_BLOCK_CMAC,           .bar_index = 0, .base_offset = 0x00000, .frame_size = 0x02000,
+             .instance = 0},
+            {.type = FPGA_DESIGN_BLOCK_CMAC,           .bar_index = 0, .base_offset = 0x10000, .frame_size = 0x02000,
+             .instance = 1, .min_revision_id = 2},
+            {.type = FPGA_DESIGN_BLOCK_ULTRASCALE_DNA, .bar_index = 0, .base_offset = 0x08000, .frame_size = 0x01000,
+             .min_revision_id = 3}
+        }
+    },
+    [FPGA_DESIGN_U200_DMA_STREAM_CRC64] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .num_sysmon_slaves = 2,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,    .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_SYSMON,      .bar_index = 0, .base_offset = 0x2000, .frame_size = 0x2000},
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS, .bar_index = 0, .base_offset = 0x1000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_U200_IBERT_100G_ETHER] =
+    {
+        /* While the design uses the DMA/Bridge Subsystem, is configured for AXI Bridge mode so the DMA bridge
+         * isn't present. */
+        .dma_bridge_present = false,
+        .num_sysmon_slaves = 2,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,    .bar_index = 0, .base_offset = 0x44000, .frame_size = 0x01000},
+            {.type = FPGA_DESIGN_BLOCK_SYSMON,      .bar_index = 0, .base_offset = 0x40000, .frame_size = 0x02000},
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS, .bar_index = 0, .base_offset = 0x42000, .frame_size = 0x01000},
+            {.type = FPGA_DESIGN_BLOCK_CMS,         .bar_index = 0, .base_offset = 0x00000}
+        }
+    },
+    [FPGA_DESIGN_OPEN_NIC] =
+    {
+        /* The design has two physical functions with different device IDs.
+         * The addresses are taken from comments in
+         * https://github.com/Xilinx/open-nic-shell/blob/main/src/system_config/system_config_address_map.sv */
+        .num_device_ids = 2,
+        .device_ids = {0x903f, 0x913f},
+        .qdma_present = true,
+        .qdma_bridge_bar = 0,
+        .qdma_memory_base_address = 0x0,
+        .qdma_memory_size_bytes = 0x0,
+        .num_sysmon_slaves = 2,
+        .cmac_configured_features =
+        {
+            [CMAC_FEATURE_PACKET_RX] = true,
+            [CMAC_FEATURE_PACKET_TX] = true,
+            [CMAC_FEATURE_RS_FEC   ] = true,
+            [CMAC_FEATURE_TX_OTN   ] = false
+        },
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI, .bar_index = 2, .base_offset = 0x340000, .frame_size = 0x001000},
+            {.type = FPGA_DESIGN_BLOCK_SYSMON,   .bar_index = 2, .base_offset = 0x010000, .frame_size = 0x002000},
+            {.type = FPGA_DESIGN_BLOCK_CMS,      .bar_index = 2, .base_offset = 0x300000},
+            {.type = FPGA_DESIGN_BLOCK_CMAC,     .bar_index = 2, .base_offset = 0x008000, .frame_size = 0x002000,
+             .instance = 0},
+            {.type = FPGA_DESIGN_BLOCK_CMAC,     .bar_index = 2, .base_offset = 0x00C000, .frame_size = 0x002000,
+             .instance = 1}
+        }
+    },
+    [FPGA_DESIGN_XCKU5P_PCIE_DDR4_ETH] =
+    {
+        .num_device_ids = 1,
+        .device_ids = {0x9038},
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 0,
+        .dma_bridge_memory_base_address = 0,
+        .dma_bridge_memory_size_bytes = 2048UL * 1024 * 1024
+    },
+    [FPGA_DESIGN_VD100_ENUM] =
+    {
+        /* DMA bridge configured for "Memory Mapped" but no actual memory connected.
+         * The following allows x2x_get_num_channels() to return valid results, but if attempts to actually
+         * perform DMA will timeout.
+         * The DMA bridge is in BAR 1 due to the peripherals BAR being 32-bit. */
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 1,
+        .dma_bridge_memory_base_address = 0,
+        .dma_bridge_memory_size_bytes = 4096
+    },
+    [FPGA_DESIGN_VD100_DMA_STREAM_CRC64] =
+    {
+        /* The DMA bridge is in BAR 0 due to the peripherals BAR not being used */
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 0
+    },
+    [FPGA_DESIGN_VD100_DMA_STREAM_LOOPBACK] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .axi_switch_num_master_ports = 4,
+        .axi_switch_num_slave_ports = 4,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_AXI_SWITCH, .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_VD100_DMA_DDR4] =
+    {
+        /* The DMA bridge is in BAR 0 due to the peripherals BAR not being used */
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 0,
+        .dma_bridge_memory_base_address = 0x800000000,
+        .dma_bridge_memory_size_bytes   = 0x100000000
+    },
+    [FPGA_DESIGN_VD100_QDMA_DDR4] =
+    {
+        .qdma_present = true,
+        .qdma_bridge_bar = 0,
+        .qdma_memory_base_address = 0x800000000,
+        .qdma_memory_size_bytes   = 0x100000000
+    },
+    [FPGA_DESIGN_U200_QDMA_RAM] =
+    {
+        .qdma_present = true,
+        .qdma_bridge_bar = 0,
+        .qdma_memory_base_address = 0x000000,
+        .qdma_memory_size_bytes   = 0x800000,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS, .bar_index = 2, .base_offset = 0x0000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_VD100_10G_ETHER_DUAL] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .mrmac_used_ports = {true, true, false, false},
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_MRMAC, .bar_index = 0, .base_offset = 0x00000, .frame_size = 0x10000},
+            {.type = FPGA_DESIGN_BLOCK_IIC,   .bar_index = 0, .base_offset = 0x11000, .frame_size = 0x01000}
+        }
+    },
+    [FPGA_DESIGN_VMK180_100G_ETHER] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .mrmac_used_ports = {true, false, false, false},
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_MRMAC, .bar_index = 0, .base_offset = 0x00000, .frame_size = 0x10000}
+        }
+    },
+    [FPGA_DESIGN_VD100_25G_ETHER_DUAL] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .mrmac_used_ports = {true, true, false, false},
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_MRMAC, .bar_index = 0, .base_offset = 0x00000, .frame_size = 0x10000},
+            {.type = FPGA_DESIGN_BLOCK_IIC,   .bar_index = 0, .base_offset = 0x11000, .frame_size = 0x01000}
+        }
+    },
+    [FPGA_DESIGN_U200_100G_ETHER_DUPLEX] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .num_sysmon_slaves = 2,
+        .axi_switch_num_master_ports = 4,
+        .axi_switch_num_slave_ports = 4,
+        .cmac_configured_features =
+        {
+            [CMAC_FEATURE_PACKET_RX] = true,
+            [CMAC_FEATURE_PACKET_TX] = true,
+            [CMAC_FEATURE_RS_FEC   ] = true,
+            [CMAC_FEATURE_TX_OTN   ] = false
+        },
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS,    .bar_index = 0, .base_offset = 0x02000, .frame_size = 0x02000},
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,       .bar_index = 0, .base_offset = 0x06000, .frame_size = 0x02000},
+            {.type = FPGA_DESIGN_BLOCK_SYSMON,         .bar_index = 0, .base_offset = 0x04000, .frame_size = 0x02000},
+            {.type = FPGA_DESIGN_BLOCK_CMS,            .bar_index = 0, .base_offset = 0x40000},
+            {.type = FPGA_DESIGN_BLOCK_CMAC,           .bar_index = 0, .base_offset = 0x00000, .frame_size = 0x02000,
+             .instance = 0},
+            {.type = FPGA_DESIGN_BLOCK_CMAC_DRP,       .bar_index = 0, .base_offset = 0x0A000, .frame_size = 0x01000,
+             .instance = 0, .min_revision_id = 2},
+            {.type = FPGA_DESIGN_BLOCK_CMAC,           .bar_index = 0, .base_offset = 0x10000, .frame_size = 0x02000,
+             .instance = 1},
+            {.type = FPGA_DESIGN_BLOCK_CMAC_DRP,       .bar_index = 0, .base_offset = 0x0B000, .frame_size = 0x01000,
+             .instance = 1, .min_revision_id = 2},
+            {.type = FPGA_DESIGN_BLOCK_ULTRASCALE_DNA, .bar_index = 0, .base_offset = 0x08000, .frame_size = 0x01000},
+            {.type = FPGA_DESIGN_BLOCK_AXI_SWITCH,     .bar_index = 0, .base_offset = 0x09000, .frame_size = 0x01000,
+             .min_revision_id = 1}
+        }
+    },
+    [FPGA_DESIGN_AS02MC04_QDMA_ENUM] =
+    {
+        .qdma_present = true,
+        .qdma_bridge_bar = 0,
+        .qdma_memory_base_address = 0x0,
+        .qdma_memory_size_bytes   = 0x0,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS, .bar_index = 2, .base_offset = 0x0000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_VD100_40G_ETHER] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .mrmac_used_ports = {true, false, false, false},
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_MRMAC, .bar_index = 0, .base_offset = 0x00000, .frame_size = 0x10000},
+            {.type = FPGA_DESIGN_BLOCK_IIC,   .bar_index = 0, .base_offset = 0x11000, .frame_size = 0x01000}
+        }
+    },
+    [FPGA_DESIGN_XCKU5P_SINGLE_QSFP_DMA_STREAM_LOOPBACK] =
+    {
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .num_sysmon_slaves = 0,
+        .axi_switch_num_master_ports = 4,
+        .axi_switch_num_slave_ports = 4,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,       .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_SYSMON,         .bar_index = 0, .base_offset = 0x1000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS,    .bar_index = 0, .base_offset = 0x2000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_AXI_SWITCH,     .bar_index = 0, .base_offset = 0x3000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_ULTRASCALE_DNA, .bar_index = 0, .base_offset = 0x4000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_XCKU5P_SINGLE_QSFP_DMA_DDR4] =
+    {
+        /* The GPIO at offset 0x4000 to control DDR4 not included here as not part of fpga_design_t */
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .dma_bridge_memory_base_address = 0,
+        .dma_bridge_memory_size_bytes = 2048UL * 1024 * 1024,
+        .num_sysmon_slaves = 0,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,       .bar_index = 0, .base_offset = 0x0000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_SYSMON,         .bar_index = 0, .base_offset = 0x1000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS,    .bar_index = 0, .base_offset = 0x2000, .frame_size = 0x1000},
+            {.type = FPGA_DESIGN_BLOCK_ULTRASCALE_DNA, .bar_index = 0, .base_offset = 0x3000, .frame_size = 0x1000}
+        }
+    },
+    [FPGA_DESIGN_U200_DMA_DDR4] =
+    {
+        /* The DMA bridge memory depends upon the revision, so is set by the probe function */
+        .probe = set_u200_dma_ddr4_memory,
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 2,
+        .num_sysmon_slaves = 2,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS,    .bar_index = 0, .base_offset = 0x07000, .frame_size = 0x01000},
+            {.type = FPGA_DESIGN_BLOCK_QUAD_SPI,       .bar_index = 0, .base_offset = 0x06000, .frame_size = 0x01000},
+            {.type = FPGA_DESIGN_BLOCK_SYSMON,         .bar_index = 0, .base_offset = 0x04000, .frame_size = 0x02000},
+            {.type = FPGA_DESIGN_BLOCK_ULTRASCALE_DNA, .bar_index = 0, .base_offset = 0x08000, .frame_size = 0x01000},
+            {.type = FPGA_DESIGN_BLOCK_CMS,            .bar_index = 0, .base_offset = 0x40000}
+        }
+    },
+    [FPGA_DESIGN_U200_SLR_IDS] =
+    {
+        /* DMA bridge configured for "Memory Mapped" but no actual memory connected.
+         * The following allows x2x_get_num_channels() to return valid results, but if attempts to actually
+         * perform DMA will timeout.
+         * The DMA bridge is in BAR 1 due to the peripherals BAR being 32-bit. */
+        .dma_bridge_present = true,
+        .dma_bridge_bar = 1,
+        .dma_bridge_memory_base_address = 0,
+        .dma_bridge_memory_size_bytes = 4096,
+        .blocks =
+        {
+            {.type = FPGA_DESIGN_BLOCK_USER_ACCESS,    .bar_index = 0, .base_offset = 0x03000, .frame_size = 0x01000},
+            {.type = FPGA_DESIGN_BLOCK_ULTRASCALE_DNA, .bar_index = 0, .base_offset = 0x00000, .frame_size = 0x01000,
+             .instance = 0},
+            {.type = FPGA_DESIGN_BLOCK_ULTRASCALE_DNA, .bar_index = 0, .base_offset = 0x01000, .frame_size = 0x01000,
+             .instance = 1},
+            {.type = FPGA_DESIGN_BLOCK_ULTRASCALE_DNA, .bar_index = 0, .base_offset = 0x02000, .frame_size = 0x01000,
+             .instance = 2}
+        }
+    }
+};
+
+
+/* Index of the designs sorted by the PCI subsystem identities in fpga_design_pci_filters[], to allow the candidate designs
+ * for a VFIO device to be found without testing every PCI filter. Designs with the same subsystem identities are in
+ * order of fpga_design_id_t, to retain the order in which candidate designs are probed. */
+static fpga_design_id_t fpga_design_subsystem_index[FPGA_DESIGN_ARRAY_SIZE];
+static bool fpga_design_subsystem_index_initialised;
+
+
+/**
+ * @brief Compare the PCI subsystem identities of a design against a key, as used to sort and search the index
+ * @param[in] design_id The design to compare
+ * @param[in] subsystem_vendor_id The PCI subsystem vendor ID key
+ * @param[in] subsystem_device_id The PCI subsystem device ID key
+ * @return Returns <0, 0 or >0 depending if the design is ordered before, equal or after the key
+ */
+static int compare_design_subsystem_ids (const fpga_design_id_t design_id,
+                                         const int subsystem_vendor_id, const int subsystem_device_id)
+{
+    const vfio_pci_device_identity_filter_t *const filter = &fpga_design_pci_filters[design_id];
+
+    if (filter->subsystem_vendor_id != subsystem_vendor_id)
+    {
+        return (filter->subsystem_vendor_id < subsystem_vendor_id) ? -1 : 1;
+    }
+    if (filter->subsystem_device_id != subsystem_device_id)
+    {
+        return (filter->subsystem_device_id < subsystem_device_id) ? -1 : 1;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief Sort function for the fpga_design_subsystem_index[]
+ * @param[in] compare_a First design to compare
+ * @param[in] compare_b Second design to compare
+ * @return Returns the ordering by subsystem identities, and then by design ID
+ */
+static int design_subsystem_index_sort (const void *const compare_a, const void *const compare_b)
+{
+    const fpga_design_id_t design_a = *(const fpga_design_id_t *) compare_a;
+    const fpga_design_id_t design_b = *(const fpga_design_id_t *) compare_b;
+    const vfio_pci_device_identity_filter_t *const filter_b = &fpga_design_pci_filters[design_b];
+    const int subsystem_order =
+            compare_design_subsystem_ids (design_a, filter_b->subsystem_vendor_id, filter_b->subsystem_device_id);
+
+    if (subsystem_order != 0)
+    {
+        return subsystem_order;
+    }
+
+    return (design_a < design_b) ? -1 : ((design_a > design_b) ? 1 : 0);
+}
+
+
+/**
+ * @brief Find the range of candidate designs in fpga_design_subsystem_index[] which match a VFIO device
+ * @details The fpga_design_pci_filters[] all specify the subsystem identities, so can use a binary search.
+ *          The caller still needs to check the complete PCI filter for each candidate, since the device ID may differ.
+ * @param[in] vfio_device The VFIO device to find candidate designs for
+ * @param[out] first_index The first index in fpga_design_subsystem_index[] of a candidate design
+ * @return The number of candidate designs, starting from first_index
+ */
+static uint32_t find_candidate_designs (const vfio_device_t *const vfio_device, uint32_t *const first_index)
+{
+    uint32_t low = 0;
+    uint32_t high = FPGA_DESIGN_ARRAY_SIZE;
+    uint32_t num_candidates = 0;
+
+    if (!fpga_design_subsystem_index_initialised)
+    {
+        for (fpga_design_id_t design_id = 0; design_id < FPGA_DESIGN_ARRAY_SIZE; design_id++)
+        {
+            fpga_design_subsystem_index[design_id] = design_id;
+        }
+        qsort (fpga_design_subsystem_index, FPGA_DESIGN_ARRAY_SIZE, sizeof (fpga_design_subsystem_index[0]),
+                design_subsystem_index_sort);
+        fpga_design_subsystem_index_initialised = true;
+    }
+
+    /* Find the first entry which isn't ordered before the device subsystem identities */
+    while (low < high)
+    {
+        const uint32_t mid = low + ((high - low) / 2);
+
+        if (compare_design_subsystem_ids (fpga_design_subsystem_index[mid],
+                vfio_device->pci_subsystem_vendor_id, vfio_device->pci_subsystem_device_id) < 0)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    *first_index = low;
+    while (((low + num_candidates) < FPGA_DESIGN_ARRAY_SIZE) &&
+           (compare_design_subsystem_ids (fpga_design_subsystem_index[low + num_candidates],
+                   vfio_device->pci_subsystem_vendor_id, vfio_device->pci_subsystem_device_id) == 0))
+    {
+        num_candidates++;
+    }
+
+    return num_candidates;
+}
+
+
+/**
+ * @brief Map one register block of a candidate design, storing the result in the design
+ * @param[in/out] vfio_device The VFIO device for the candidate design
+ * @param[in] descriptor The descriptor for the candidate design
+ * @param[in] block The register block to map
+ * @param[in/out] candidate_design The candidate design to update
+ */
+static void map_fpga_design_block (vfio_device_t *const vfio_device, const fpga_design_descriptor_t *const descriptor,
+                                   const fpga_design_block_t *const block, fpga_design_t *const candidate_design)
+{
+    cmac_port_definition_t *port_def;
+
+    switch (block->type)
+    {
+    case FPGA_DESIGN_BLOCK_QUAD_SPI:
+        candidate_design->quad_spi_regs =
+                map_vfio_registers_block (vfio_device, block->bar_index, block->base_offset, block->frame_size);
+        break;
+
+    case FPGA_DESIGN_BLOCK_XADC:
+        candidate_design->xadc_regs =
+                map_vfio_registers_block (vfio_device, block->bar_index, block->base_offset, block->frame_size);
+        break;
+
+    case FPGA_DESIGN_BLOCK_SYSMON:
+        candidate_design->sysmon_regs =
+                map_vfio_registers_block (vfio_device, block->bar_index, block->base_offset, block->frame_size);
+        candidate_design->num_sysmon_slaves = descriptor->num_sysmon_slaves;
+        break;
+
+    case FPGA_DESIGN_BLOCK_IIC:
+        candidate_design->iic_regs =
+                map_vfio_registers_block (vfio_device, block->bar_index, block->base_offset, block->frame_size);
+        break;
+
+    case FPGA_DESIGN_BLOCK_BIT_BANGED_I2C_GPIO:
+        candidate_design->bit_banged_i2c_gpio_regs =
+                map_vfio_registers_block (vfio_device, block->bar_index, block->base_offset, block->frame_size);
+        break;
+
+    case FPGA_DESIGN_BLOCK_USER_ACCESS:
+        candidate_design->user_access =
+                map_vfio_registers_block (vfio_device, block->bar_index, block->base_offset, block->frame_size);
+        break;
+
+    case FPGA_DESIGN_BLOCK_AXI_SWITCH:
+        candidate_design->axi_switch_regs =
+                map_vfio_registers_block (vfio_device, block->bar_index, block->base_offset, block->frame_size);
+        candidate_design->axi_switch_num_master_ports = descriptor->axi_switch_num_master_ports;
+        candidate_design->axi_switch_num_slave_ports = descriptor->axi_switch_num_slave_ports;
+        break;
+
+    case FPGA_DESIGN_BLOCK_ULTRASCALE_DNA:
+        candidate_design->ultrascale_dna_regs[block->instance] =
+                map_vfio_registers_block (vfio_device, block->bar_index, block->base_offset, block->frame_size);
+        if (candidate_design->num_ultrascale_dna_regs < (block->instance + 1))
+        {
+            candidate_design->num_ultrascale_dna_regs = block->instance + 1;
+        }
+        break;
+
+    case FPGA_DESIGN_BLOCK_MRMAC:
+        candidate_design->mrmac.regs =
+                map_vfio_registers_block (vfio_device, block->bar_index, block->base_offset, block->frame_size);
+        memcpy (candidate_design->mrmac.used_ports, descriptor->mrmac_used_ports, sizeof (candidate_design->mrmac.used_ports));
+        break;
+
+    case FPGA_DESIGN_BLOCK_CMAC:
+        port_def = &candidate_design->cmac_ports[block->instance];
+        port_def->cmac_control_status_statistics_regs =
+                map_vfio_registers_block (vfio_device, block->bar_index, block->base_offset, block->frame_size);
+        port_def->cmac_drp_regs = NULL;
+        memcpy (port_def->configured_features, descriptor->cmac_configured_features, sizeof (port_def->configured_features));
+        port_def->configured_features[CMAC_FEATURE_DRP] = false;
+        if (candidate_design->num_cmac_ports < (block->instance + 1))
+        {
+            candidate_design->num_cmac_ports = block->instance + 1;
+        }
+        break;
+
+    case FPGA_DESIGN_BLOCK_CMAC_DRP:
+        port_def = &candidate_design->cmac_ports[block->instance];
+        port_def->cmac_drp_regs =
+                map_vfio_registers_block (vfio_device, block->bar_index, block->base_offset, block->frame_size);
+        port_def->configured_features[CMAC_FEATURE_DRP] = true;
+        break;
+
+    case FPGA_DESIGN_BLOCK_CMS:
+        candidate_design->cms_subsystem_present = true;
+        candidate_design->cms_subsystem_bar_index = block->bar_index;
+        candidate_design->cms_subsystem_base_offset = block->base_offset;
+        break;
+
+    case FPGA_DESIGN_BLOCK_NONE:
+        /* Shouldn't get here */
+        break;
+    }
+}
+
+
+/**
+ * @brief Attempt to identify a VFIO device as one candidate design, using fpga_design_descriptors[]
+ * @param[in/out] vfio_device The VFIO device to identify
+ * @param[in] candidate_design_id The candidate design, for which the PCI filter has matched the VFIO device
+ * @param[out] candidate_design When the design is identified contains the information about the design
+ * @return Returns true if the design has been identified
+ */
+static bool identify_candidate_design (vfio_device_t *const vfio_device, const fpga_design_id_t candidate_design_id,
+                                       fpga_design_t *const candidate_design)
+{
+    const fpga_design_descriptor_t *const descriptor = &fpga_design_descriptors[candidate_design_id];
+    fpga_design_t identified_design;
+    bool design_identified;
+
+    /* For designs using default Xilinx identities, check the device ID to determine the actual design */
+    design_identified = descriptor->num_device_ids == 0;
+    for (uint32_t id_index = 0; !design_identified && (id_index < descriptor->num_device_ids); id_index++)
+    {
+        design_identified = vfio_device->pci_dev->device_id == descriptor->device_ids[id_index];
+    }
+
+    if (design_identified)
+    {
+        /* Populate a local copy, so that candidate_design is unchanged if a probe function doesn't identify the design */
+        memset (&identified_design, 0, sizeof (identified_design));
+        identified_design.dma_bridge_present = descriptor->dma_bridge_present;
+        identified_design.dma_bridge_bar = descriptor->dma_bridge_bar;
+        identified_design.dma_bridge_memory_base_address = descriptor->dma_bridge_memory_base_address;
+        identified_design.dma_bridge_memory_size_bytes = descriptor->dma_bridge_memory_size_bytes;
+        identified_design.qdma_present = descriptor->qdma_present;
+        identified_design.qdma_bridge_bar = descriptor->qdma_bridge_bar;
+        identified_design.qdma_memory_base_address = descriptor->qdma_memory_base_address;
+        identified_design.qdma_memory_size_bytes = descriptor->qdma_memory_size_bytes;
+
+        for (uint32_t block_index = 0;
+             (block_index < MAX_FPGA_DESIGN_BLOCKS) && (descriptor->blocks[block_index].type != FPGA_DESIGN_BLOCK_NONE);
+             block_index++)
+        {
+            const fpga_design_block_t *const block = &descriptor->blocks[block_index];
+
+            if (vfio_device->pci_revision_id >= block->min_revision_id)
+            {
+                map_fpga_design_block (vfio_device, descriptor, block, &identified_design);
+            }
+        }
+
+        if (descriptor->probe != NULL)
+        {
+            design_identified = descriptor->probe (vfio_device, candidate_design_id, &identified_design);
+        }
+    }
+
+    if (design_identified)
+    {
+        *candidate_design = identified_design;
+    }
+
+    return design_identified;
+}
+
+
+/* Optional pathname of the file used to cache the identified designs, set by identify_pcie_fpga_designs_enable_cache().
+ * When empty the cache isn't used. */
+static char fpga_design_cache_pathname[PATH_MAX];
+
+
+/* Value at the start of the cache file, to reject files which aren't a cache */
+#define FPGA_DESIGN_CACHE_MAGIC 0x46444943 /* "FDIC" */
+
+
+/* The version of the cache file format. Must be incremented whenever the meaning of the contents of
+ * fpga_design_cache_record_t changes, including changes to fpga_design_t or the order of fpga_design_id_t,
+ * since such changes may not alter the size of the record. */
+#define FPGA_DESIGN_CACHE_FORMAT_VERSION 1
+
+
+/* The offsets in fpga_design_t of the pointers to mapped registers, which have to be stored in the cache as a BAR and
+ * offset since the mapped address is only valid in the process which mapped the BAR. */
+static const size_t fpga_design_register_pointer_offsets[] =
+{
+    offsetof (fpga_design_t, quad_spi_regs),
+    offsetof (fpga_design_t, xadc_regs),
+    offsetof (fpga_design_t, sysmon_regs),
+    offsetof (fpga_design_t, iic_regs),
+    offsetof (fpga_design_t, user_access),
+    offsetof (fpga_design_t, bit_banged_i2c_gpio_regs),
+    offsetof (fpga_design_t, axi_switch_regs),
+    offsetof (fpga_design_t, cmac_ports[0].cmac_control_status_statistics_regs),
+    offsetof (fpga_design_t, cmac_ports[0].cmac_drp_regs),
+    offsetof (fpga_design_t, cmac_ports[1].cmac_control_status_statistics_regs),
+    offsetof (fpga_design_t, cmac_ports[1].cmac_drp_regs),
+    offsetof (fpga_design_t, ultrascale_dna_regs[0]),
+    offsetof (fpga_design_t, ultrascale_dna_regs[1]),
+    offsetof (fpga_design_t, ultrascale_dna_regs[2]),
+    offsetof (fpga_design_t, ultrascale_dna_regs[3]),
+    offsetof (fpga_design_t, mrmac.regs)
+};
+#define FPGA_DESIGN_NUM_REGISTER_POINTERS (sizeof (fpga_design_register_pointer_offsets) / sizeof (fpga_design_register_pointer_offsets[0]))
+
+
+/* The location of one pointer to mapped registers stored in the cache */
+typedef struct
+{
+    /* When false the pointer was NULL */
+    bool present;
+    uint32_t bar_index;
+    size_t base_offset;
+} fpga_design_cached_register_t;
+
+
+/* One record in the cache file, which contains the key used to determine if the cached design is still valid followed by
+ * the identified design. */
+typedef struct
+{
+    /* The PCI location of the device */
+    char device_name[sizeof (((vfio_device_t *) NULL)->device_name)];
+    /* The PCI identities of the device */
+    uint16_t vendor_id;
+    uint16_t device_id;
+    uint16_t subsystem_vendor_id;
+    uint16_t subsystem_device_id;
+    uint8_t revision_id;
+    /* When the design contains a user access register, the value when the design was cached.
+     * Used to detect a different bitstream with the same PCI identities having been loaded. */
+    uint32_t user_access;
+    /* The identified design, with the pointers to mapped registers and the VFIO device set to NULL */
+    fpga_design_t design;
+    /* The locations of the pointers to mapped registers, in the order of fpga_design_register_pointer_offsets[] */
+    fpga_design_cached_register_t registers[FPGA_DESIGN_NUM_REGISTER_POINTERS];
+} fpga_design_cache_record_t;
+
+
+/* The header of the cache file, which is followed by num_records of fpga_design_cache_record_t */
+typedef struct
+{
+    uint32_t magic;
+    /* Used to reject a cache file written by a program with a different format of the records */
+    uint32_t format_version;
+    /* Used to reject a cache file written by a program with a different layout of fpga_design_t */
+    uint32_t record_size;
+    uint32_t num_records;
+} fpga_design_cache_header_t;
+
+
+/* The records read from, and to be written to, the cache file. Grown as records are added.
+ * The cache retains the designs for devices not opened by a process which used PCI device location filters. */
+static fpga_design_cache_record_t *fpga_design_cache_records;
+static uint32_t fpga_design_cache_records_allocated_length;
+static uint32_t fpga_design_cache_num_records;
+
+
+/**
+ * @brief Enable a persistent cache of the identified designs, used by subsequent calls to identify_pcie_fpga_designs()
+ * @details When enabled a VFIO device with a record in the cache is identified without probing for a candidate design.
+ *          The cache is keyed on the PCI location, PCI identities and the value of the user access register, so that
+ *          is invalidated by changing the card in a slot or loading a different bitstream.
+ *          Designs without a user access register can't detect a different bitstream being loaded with the same
+ *          PCI identities.
+ * @param[in] cache_pathname The pathname of the cache file, which is created if doesn't exist.
+ */
+void identify_pcie_fpga_designs_enable_cache (const char *const cache_pathname)
+{
+    snprintf (fpga_design_cache_pathname, sizeof (fpga_design_cache_pathname), "%s", cache_pathname);
+}
+
+
+/**
+ * @brief Find the BAR and offset of a pointer to mapped registers in a VFIO device
+ * @param[in] vfio_device The VFIO device which contains the mapped registers
+ * @param[in] mapped_registers The pointer to mapped registers to find
+ * @param[out] bar_index The BAR which contains the mapped registers
+ * @param[out] bar_offset The offset into the BAR of the mapped registers
+ * @return Returns true if the BAR has been found
+ */
+static bool find_mapped_registers_bar (const vfio_device_t *const vfio_device, const uint8_t *const mapped_registers,
+                                       uint32_t *const bar_index, size_t *const bar_offset)
+{
+    bool found_bar = false;
+
+    *bar_index = 0;
+    *bar_offset = 0;
+    while (!found_bar && (*bar_index < PCI_STD_NUM_BARS))
+    {
+        if (vfio_device->mapped_bars[*bar_index] != NULL)
+        {
+            const uint8_t *const mapped_bar_start = vfio_device->mapped_bars[*bar_index];
+            const uint8_t *const mapped_bar_end = &mapped_bar_start[vfio_device->regions_info[*bar_index].size];
+
+            if ((mapped_registers >= mapped_bar_start) && (mapped_registers < mapped_bar_end))
+            {
+                *bar_offset = (size_t) (mapped_registers - mapped_bar_start);
+                found_bar = true;
+            }
+        }
+
+        if (!found_bar)
+        {
+            (*bar_index)++;
+        }
+    }
+
+    return found_bar;
+}
+
+
+/**
+ * @brief Determine if a record read from the cache file contains valid values
+ * @details Protects against a corrupt cache file causing out of range array indices when the design is used.
+ * @param[in] record The cache record to check
+ * @return Returns true if the record is valid
+ */
+static bool fpga_design_cache_record_valid (const fpga_design_cache_record_t *const record)
+{
+    bool valid = (memchr (record->device_name, '\0', sizeof (record->device_name)) != NULL) &&
+            (record->design.design_id < FPGA_DESIGN_ARRAY_SIZE);
+
+    for (uint32_t pointer_index = 0; valid && (pointer_index < FPGA_DESIGN_NUM_REGISTER_POINTERS); pointer_index++)
+    {
+        const fpga_design_cached_register_t *const cached_register = &record->registers[pointer_index];
+
+        valid = !cached_register->present || (cached_register->bar_index < PCI_STD_NUM_BARS);
+    }
+
+    return valid;
+}
+
+
+/**
+ * @brief Read the cache file into fpga_design_cache_records[]
+ * @details If the cache file doesn't exist, or has an unexpected format, then the cache is treated as empty.
+ *          Records which contain invalid values are discarded.
+ */
+static void read_fpga_design_cache (void)
+{
+    fpga_design_cache_header_t header;
+    fpga_design_cache_record_t record;
+    FILE *cache_file;
+
+    fpga_design_cache_num_records = 0;
+    cache_file = fopen (fpga_design_cache_pathname, "rb");
+    if (cache_file != NULL)
+    {
+        if ((fread (&header, sizeof (header), 1, cache_file) == 1) &&
+            (header.magic == FPGA_DESIGN_CACHE_MAGIC) &&
+            (header.format_version == FPGA_DESIGN_CACHE_FORMAT_VERSION) &&
+            (header.record_size == sizeof (fpga_design_cache_record_t)))
+        {
+            for (uint32_t record_index = 0;
+                 (record_index < header.num_records) && (fread (&record, sizeof (record), 1, cache_file) == 1);
+                 record_index++)
+            {
+                if (fpga_design_cache_record_valid (&record))
+                {
+                    fpga_design_cache_records = vfio_grow_array (fpga_design_cache_records,
+                            &fpga_design_cache_records_allocated_length, fpga_design_cache_num_records + 1,
+                            sizeof (fpga_design_cache_records[0]), "fpga_design_cache_records");
+                    fpga_design_cache_records[fpga_design_cache_num_records] = record;
+                    fpga_design_cache_num_records++;
+                }
+            }
+        }
+        (void) fclose (cache_file);
+    }
+}
+
+
+/**
+ * @brief Write fpga_design_cache_records[] to the cache file
+ * @details Written to a temporary file which is then renamed, so that another process doesn't read a partial file.
+ *          Failure to write the cache is reported but not fatal, since the cache is only an optimisation.
+ */
+static void write_fpga_design_cache (void)
+{
+    char temporary_pathname[PATH_MAX + 16];
+    fpga_design_cache_header_t header;
+    FILE *cache_file;
+    bool success;
+    int rc;
+
+    snprintf (temporary_pathname, sizeof (temporary_pathname), "%s.%d", fpga_design_cache_pathname, getpid ());
+    cache_file = fopen (temporary_pathname, "wb");
+    success = cache_file != NULL;
+    if (success)
+    {
+        header.magic = FPGA_DESIGN_CACHE_MAGIC;
+        header.format_version = FPGA_DESIGN_CACHE_FORMAT_VERSION;
+        header.record_size = sizeof (fpga_design_cache_record_t);
+        header.num_records = fpga_design_cache_num_records;
+        success = (fwrite (&header, sizeof (header), 1, cache_file) == 1) &&
+                (fwrite (fpga_design_cache_records, sizeof (fpga_design_cache_records[0]), fpga_design_cache_num_records,
+                        cache_file) == fpga_design_cache_num_records);
+        rc = fclose (cache_file);
+        success = success && (rc == 0);
+        if (success)
+        {
+            rc = rename (temporary_pathname, fpga_design_cache_pathname);
+            success = rc == 0;
+        }
+        if (!success)
+        {
+            (void) remove (temporary_pathname);
+        }
+    }
+
+    if (!success)
+    {
+        printf ("Warning: Failed to write FPGA design cache %s\n", fpga_design_cache_pathname);
+    }
+}
+
+
+/**
+ * @brief Determine if a cache record matches the PCI location and identities of a VFIO device
+ * @param[in] record The cache record to check
+ * @param[in] vfio_device The VFIO device to compare against
+ * @return Returns true if the cache record is for the VFIO device
+ */
+static bool fpga_design_cache_record_pci_match (const fpga_design_cache_record_t *const record,
+                                                const vfio_device_t *const vfio_device)
+{
+    return (strcmp (record->device_name, vfio_device->device_name) == 0) &&
+            (record->vendor_id == vfio_device->pci_dev->vendor_id) &&
+            (record->device_id == vfio_device->pci_dev->device_id) &&
+            (record->subsystem_vendor_id == vfio_device->pci_subsystem_vendor_id) &&
+            (record->subsystem_device_id == vfio_device->pci_subsystem_device_id) &&
+            (record->revision_id == vfio_device->pci_revision_id);
+}
+
+
+/**
+ * @brief Attempt to identify a VFIO device using the cache
+ * @details The only register access is to read the user access register, if present in the cached design.
+ * @param[in/out] vfio_device The VFIO device to identify
+ * @param[out] identified_design When returns true, the design restored from the cache
+ * @return Returns true if the design has been identified from the cache
+ */
+static bool identify_design_from_cache (vfio_device_t *const vfio_device, fpga_design_t *const identified_design)
+{
+    const size_t user_access_pointer_offset = offsetof (fpga_design_t, user_access);
+    bool design_identified = false;
+
+    for (uint32_t record_index = 0; !design_identified && (record_index < fpga_design_cache_num_records); record_index++)
+    {
+        const fpga_design_cache_record_t *const record = &fpga_design_cache_records[record_index];
+
+        if (fpga_design_cache_record_pci_match (record, vfio_device))
+        {
+            design_identified = true;
+            for (uint32_t pointer_index = 0;
+                 design_identified && (pointer_index < FPGA_DESIGN_NUM_REGISTER_POINTERS);
+                 pointer_index++)
+            {
+                const fpga_design_cached_register_t *const cached_register = &record->registers[pointer_index];
+
+                if ((fpga_design_register_pointer_offsets[pointer_index] == user_access_pointer_offset) &&
+                    cached_register->present)
+                {
+                    const uint8_t *const user_access = map_vfio_registers_block (vfio_device,
+                            cached_register->bar_index, cached_register->base_offset, sizeof (uint32_t));
+
+                    design_identified = (user_access != NULL) && (read_reg32 (user_access, 0) == record->user_access);
+                }
+            }
+
+            if (design_identified)
+            {
+                *identified_design = record->design;
+                for (uint32_t pointer_index = 0; pointer_index < FPGA_DESIGN_NUM_REGISTER_POINTERS; pointer_index++)
+                {
+                    const fpga_design_cached_register_t *const cached_register = &record->registers[pointer_index];
+                    uint8_t **const mapped_registers =
+                            (uint8_t **) &((uint8_t *) identified_design)[fpga_design_register_pointer_offsets[pointer_index]];
+
+                    /* The frame size was validated when the design was identified, so only need to check the offset */
+                    *mapped_registers = cached_register->present ?
+                            map_vfio_registers_block (vfio_device, cached_register->bar_index, cached_register->base_offset, 1) :
+                            NULL;
+                }
+            }
+        }
+    }
+
+    return design_identified;
+}
+
+
+/**
+ * @brief Store an identified design in the cache, replacing any existing record for the same PCI location
+ * @param[in] design The design identified by probing
+ */
+static void store_design_in_cache (const fpga_design_t *const design)
+{
+    const vfio_device_t *const vfio_device = design->vfio_device;
+    fpga_design_cache_record_t *record = NULL;
+
+    for (uint32_t record_index = 0; (record == NULL) && (record_index < fpga_design_cache_num_records); record_index++)
+    {
+        if (strcmp (fpga_design_cache_records[record_index].device_name, vfio_device->device_name) == 0)
+        {
+            record = &fpga_design_cache_records[record_index];
+        }
+    }
+    if (record == NULL)
+    {
+        fpga_design_cache_records = vfio_grow_array (fpga_design_cache_records,
+                &fpga_design_cache_records_allocated_length, fpga_design_cache_num_records + 1,
+                sizeof (fpga_design_cache_records[0]), "fpga_design_cache_records");
+        record = &fpga_design_cache_records[fpga_design_cache_num_records];
+        fpga_design_cache_num_records++;
+    }
+
+    memset (record, 0, sizeof (*record));
+    snprintf (record->device_name, sizeof (record->device_name), "%s", vfio_device->device_name);
+    record->vendor_id = vfio_device->pci_dev->vendor_id;
+    record->device_id = vfio_device->pci_dev->device_id;
+    record->subsystem_vendor_id = vfio_device->pci_subsystem_vendor_id;
+    record->subsystem_device_id = vfio_device->pci_subsystem_device_id;
+    record->revision_id = vfio_device->pci_revision_id;
+    record->user_access = (design->user_access != NULL) ? read_reg32 (design->user_access, 0) : 0;
+
+    record->design = *design;
+    record->design.vfio_device = NULL;
+    for (uint32_t pointer_index = 0; pointer_index < FPGA_DESIGN_NUM_REGISTER_POINTERS; pointer_index++)
+    {
+        fpga_design_cached_register_t *const cached_register = &record->registers[pointer_index];
+        uint8_t **const mapped_registers =
+                (uint8_t **) &((uint8_t *) &record->design)[fpga_design_register_pointer_offsets[pointer_index]];
+
+        cached_register->present = (*mapped_registers != NULL) &&
+                find_mapped_registers_bar (vfio_device, *mapped_registers,
+                        &cached_register->bar_index, &cached_register->base_offset);
+        *mapped_registers = NULL;
+    }
+}
+
+
+/**
+ * @brief Identify the PCIe FPGA designs known to the library, opening them using VFIO
+ * @param[out] designs Contains the identified designs
+ */
+void identify_pcie_fpga_designs (fpga_designs_t *const designs)
+{
+    const bool cache_enabled = strlen (fpga_design_cache_pathname) > 0;
+    bool cache_updated = false;
+    uint32_t first_candidate_index;
+    uint32_t num_candidates;
+    bool design_identified;
+
+    /* Open all VFIO devices potentially matching the designs */
+    memset (designs, 0, sizeof (*designs));
+    open_vfio_devices_matching_filter (&designs->vfio_devices, FPGA_DESIGN_ARRAY_SIZE, fpga_design_pci_filters);
+
+    if (cache_enabled)
+    {
+        read_fpga_design_cache ();
+    }
+
+    designs->num_identified_designs = 0;
+    designs->num_designs_from_cache = 0;
+    designs->designs = calloc (designs->vfio_devices.num_devices > 0 ? designs->vfio_devices.num_devices : 1,
+            sizeof (designs->designs[0]));
+    if (designs->designs == NULL)
+    {
+        printf ("Failed to allocate memory for designs\n");
+        exit (EXIT_FAILURE);
+    }
+    for (uint32_t device_index = 0; device_index < designs->vfio_devices.num_devices; device_index++)
+    {
+        vfio_device_t *const vfio_device = designs->vfio_devices.devices[device_index];
+        fpga_design_t *const candidate_design = &designs->designs[designs->num_identified_designs];
+        fpga_design_id_t candidate_design_id = FPGA_DESIGN_ARRAY_SIZE;
+        const bool identified_from_cache = cache_enabled && identify_design_from_cache (vfio_device, candidate_design);
+
+        design_identified = identified_from_cache;
+        if (identified_from_cache)
+        {
+            candidate_design_id = candidate_design->design_id;
+            designs->num_designs_from_cache++;
+        }
+
+        num_candidates = design_identified ? 0 : find_candidate_designs (vfio_device, &first_candidate_index);
+        for (uint32_t candidate_index = 0; !design_identified && (candidate_index < num_candidates); candidate_index++)
+        {
+            candidate_design_id = fpga_design_subsystem_index[first_candidate_index + candidate_index];
+            if (vfio_device_pci_filter_match (vfio_device, &fpga_design_pci_filters[candidate_design_id]))
+            {
+                design_identified = identify_candidate_design (vfio_device, candidate_design_id, candidate_design);
+            }
+        }
+
+        if (design_identified)
+        {
+            candidate_design->design_id = candidate_design_id;
+            candidate_design->vfio_device = vfio_device;
+            candidate_design->design_index = designs->num_identified_designs;
+            designs->num_identified_designs++;
+
+            if (cache_enabled && !identified_from_cache)
+            {
+                store_design_in_cache (candidate_design);
+                cache_updated = true;
+            }
+        }
+    }
+
+    if (cache_updated)
+    {
+        write_fpga_design_cache ();
+    }
+}
+
+
+/**
+ * @brief Close the VFIO devices which were opened by identify_pcie_fpga_designs()
+ * @param[in/out] designs Contains the VFIO devices to close
+ */
+void close_pcie_fpga_designs (fpga_designs_t *const designs)
+{
+    close_vfio_devices (&designs->vfio_devices);
+    free (designs->designs);
+    designs->designs = NULL;
+    designs->num_identified_designs = 0;
+}
+
+
+/**
+ * @brief Display the possible FPGA designs in the PC which can be opened by identify_pcie_fpga_designs()
+ * @details This only needs to scan the PCI bus, and doesn't attempt to open supported PCI devices using VFIO
+ */
+void display_possible_fpga_designs (void)
+{
+    display_possible_vfio_devices (FPGA_DESIGN_ARRAY_SIZE, fpga_design_pci_filters, fpga_design_names);
+}
+
+
+/**
+ * @brief Format a string containing the timestamp embedded in the the user access (AXSS register) in the bitstream
+ * @param[in] user_access The value of the user access to format
+ * @param[out] formatted_timestamp The formatted timestamp string
+ */
+void format_user_access_timestamp (const uint32_t user_access,
+                                   char formatted_timestamp[const USER_ACCESS_TIMESTAMP_LEN])
+{
+    /* Extract the individual bit fields of the timestamp */
+    const uint32_t day    = (user_access & 0xf8000000) >> 27;
+    const uint32_t month  = (user_access & 0x07800000) >> 23;
+    const uint32_t year   = (user_access & 0x007e0000) >> 17;
+    const uint32_t hour   = (user_access & 0x0001f000) >> 12;
+    const uint32_t minute = (user_access & 0x00000fc0) >>  6;
+    const uint32_t second = (user_access & 0x0000003f);
+
+    const uint32_t epoch_year = 2000;
+
+    snprintf (formatted_timestamp, USER_ACCESS_TIMESTAMP_LEN, "%02u/%02u/%04u %02u:%02u:%02u",
+            day, month, year + epoch_year, hour, minute, second);
+}
+
+
+/**
+ * @brief Display information about a peripheral which is present in an identified design
+ * @param[in] design The identified design to check for the peripheral
+ * @param[in] peripheral_name The name of the peripheral
+ * @param[in] peripheral_mapped_base If non-NULL the mapped base of the peripheral which is present in the design.
+ */
+void display_design_present_peripheral (const fpga_design_t *const design,
+                                        const char *const peripheral_name, const uint8_t *const peripheral_mapped_base)
+{
+    if (peripheral_mapped_base != NULL)
+    {
+        /* The peripheral is present since its registers are mapped.
+         * Search to find the offset into which BAR the registers are mapped to. */
+        uint32_t bar_number;
+        size_t bar_offset;
+        const bool found_bar = find_mapped_registers_bar (design->vfio_device, peripheral_mapped_base, &bar_number, &bar_offset);
 
         if (found_bar)
         {
-            printf ("  %s registers at bar %u offset 0x%lx\n", peripheral_name, bar_number, bar_offset);
+            printf ("  %s registers at bar %u offset 0x%zx\n", peripheral_name, bar_number, bar_offset);
         }
         else
         {
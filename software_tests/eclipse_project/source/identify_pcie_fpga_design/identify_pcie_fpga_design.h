@@ -491,11 +491,15 @@ typedef struct
     vfio_devices_t vfio_devices;
     /* The number of FPGA designed identified in vfio_devices */
     uint32_t num_identified_designs;
-    /* The array of identified FPGA designs */
-    fpga_design_t designs[MAX_VFIO_DEVICES];
+    /* The number of the identified designs which were obtained from the cache enabled by
+     * identify_pcie_fpga_designs_enable_cache(), rather than by probing the designs */
+    uint32_t num_designs_from_cache;
+    /* The array of identified FPGA designs, allocated with one entry for each opened VFIO device */
+    fpga_design_t *designs;
 } fpga_designs_t;
 
 
+void identify_pcie_fpga_designs_enable_cache (const char *const cache_pathname);
 void identify_pcie_fpga_designs (fpga_designs_t *const designs);
 void close_pcie_fpga_designs (fpga_designs_t *const designs);
 void display_possible_fpga_designs (void);
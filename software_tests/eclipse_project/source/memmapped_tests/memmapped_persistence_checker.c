@@ -0,0 +1,1036 @@
+/*
+ * @file memmapped_persistence_checker.c
+ * @date 18 Oct 2026
+ * @author Chester Gillon
+ * @brief Check if FPGA memory keeps its contents between runs of this program, identifying which blocks changed
+ * @details
+ *   This is an extension of memmapped_persistence_vfio.c which:
+ *   a. Fills the memory with a pseudo-random pattern generated from a seed.
+ *   b. Saves the seed, and a checksum for each block of the memory, in a local state file.
+ *   c. On the next run reads the memory and compares the checksums of each block against the state file to identify
+ *      exactly which blocks changed. The words in the changed blocks are compared against the pattern regenerated from
+ *      the seed, to count how many words changed.
+ *   d. Reports the time since the previous run, and if the PC was rebooted since the previous run.
+ *
+ *   The memory checked is:
+ *   - For designs with a DMA/Bridge Subsystem with DMA accessible memory, the memory accessed through DMA.
+ *   - For the memory mapped block RAM design, all BARs accessed through PIO. The PIO copies a block at a time using
+ *     memcpy() to let the CPU perform wider reads than the word-by-word accesses in memmapped_persistence_vfio.c.
+ *
+ *   When the memory has changed, or hasn't been previously checked, a new pattern is written. Otherwise the existing
+ *   pattern is left to check persistence over multiple runs.
+ *
+ *   Reboots are detected by a change in the Linux boot_id between runs. Multiple reboots between two runs of this program
+ *   can't be distinguished, so the reboot count is the number of runs at which a reboot was detected.
+ */
+
+#include "identify_pcie_fpga_design.h"
+#include "dma_memory_test.h"
+#include "transfer_timing.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <limits.h>
+#include <time.h>
+
+#include <getopt.h>
+#include <unistd.h>
+
+#include "fpga_sio_pci_ids.h"
+
+
+/* Identifies the state file format */
+#define STATE_FILE_MAGIC 0x50455253 /* "PERS" */
+#define STATE_FILE_FORMAT_VERSION 1
+
+
+/* The length of the Linux boot_id, which is a UUID, plus a null terminator */
+#define BOOT_ID_LEN 40
+
+
+/* The maximum number of ranges of changed blocks reported for each region, to limit the output when a large amount
+ * of memory has changed */
+#define MAX_REPORTED_CHANGED_RANGES 32
+
+
+/* The number of 32-bit checksum inputs after which the Fletcher sums are reduced, chosen so that sum2 can't overflow */
+#define CHECKSUM_REDUCTION_INTERVAL 4096
+
+
+/* How a region of memory is accessed */
+typedef enum
+{
+    REGION_ACCESS_PIO,
+    REGION_ACCESS_DMA
+} region_access_t;
+
+
+static const char *const region_access_names[] =
+{
+    [REGION_ACCESS_PIO] = "PIO",
+    [REGION_ACCESS_DMA] = "DMA"
+};
+
+
+/* The header at the start of the state file */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t format_version;
+    /* The size of state_file_region_t, as a check on the file format */
+    uint32_t region_size;
+    /* The number of regions which follow the header */
+    uint32_t num_regions;
+    /* The number of runs of this program which have updated the state file */
+    uint32_t num_runs;
+    /* The number of runs at which a reboot since the previous run was detected */
+    uint32_t num_reboots;
+    /* The CLOCK_REALTIME seconds of the previous run */
+    int64_t previous_run_time;
+    /* The Linux boot_id of the previous run */
+    char previous_boot_id[BOOT_ID_LEN];
+} state_file_header_t;
+
+
+/* The state for one region of memory, stored in the state file followed by num_blocks checksums */
+typedef struct
+{
+    /* Identifies the region */
+    char device_name[64];
+    uint32_t access;
+    uint32_t bar_index;
+    uint64_t base_address;
+    uint64_t size_bytes;
+    /* How the region is divided into blocks for checksums */
+    uint64_t block_size_bytes;
+    uint64_t num_blocks;
+    /* The seed used to generate the pattern written to the region */
+    uint64_t pattern_seed;
+    /* When the pattern was written, and the run and reboot counts at that time */
+    int64_t written_time;
+    uint32_t written_num_runs;
+    uint32_t written_num_reboots;
+} state_file_region_t;
+
+
+/* The in-memory state for one region */
+typedef struct
+{
+    state_file_region_t region;
+    /* The expected checksum for each block */
+    uint64_t *checksums;
+    /* Set true when the region has been checked during this run */
+    bool checked;
+} region_state_t;
+
+
+/* The in-memory contents of the state file */
+typedef struct
+{
+    state_file_header_t header;
+    uint32_t regions_allocated_length;
+    region_state_t *regions;
+} persistence_state_t;
+
+
+/* Describes how to access one region of memory during this run */
+typedef struct
+{
+    /* Identifies the region */
+    vfio_device_t *vfio_device;
+    region_access_t access;
+    uint32_t bar_index;
+    uint64_t base_address;
+    uint64_t size_bytes;
+    /* For REGION_ACCESS_PIO the mapped BAR */
+    uint8_t *mapped_bar;
+    /* For REGION_ACCESS_DMA the context used to perform DMA transfers */
+    dma_memory_test_context_t *dma_context;
+    /* For REGION_ACCESS_PIO a host buffer for one block */
+    uint64_t *block_buffer;
+} persistence_region_t;
+
+
+/* Command line argument which specifies the pathname of the state file */
+static const char *arg_state_pathname = "memmapped_persistence_state.bin";
+
+
+/* Command line argument which specifies the size of the blocks for which checksums are calculated */
+static size_t arg_block_size_bytes = 0x10000;
+
+
+/* Command line argument which causes a new pattern to be written to all regions, even if unchanged */
+static bool arg_rewrite;
+
+
+/* Command line argument which causes the devices to be reset before use */
+static bool arg_reset_devices;
+
+
+/** The command line options for this program, in the format passed to getopt_long().
+ *  Only long arguments are supported */
+static const struct option command_line_options[] =
+{
+    {"state_file", required_argument, NULL, 0},
+    {"block_size", required_argument, NULL, 0},
+    {"rewrite", no_argument, NULL, 0},
+    {"reset_devices", no_argument, NULL, 0},
+    {NULL, 0, NULL, 0}
+};
+
+
+/**
+ * @brief Display the usage for this program, and the exit
+ */
+static void display_usage (void)
+{
+    printf ("Usage:\n");
+    printf ("  memmapped_persistence_checker <options>\n");
+    printf ("   Check if FPGA memory keeps its contents between runs\n");
+    printf ("--state_file <pathname>\n");
+    printf ("  The file used to store the pattern seed and block checksums between runs.\n");
+    printf ("  Default %s\n", arg_state_pathname);
+    printf ("--block_size <size_bytes>\n");
+    printf ("  The size of the blocks for which checksums are stored. Default 0x%zx\n", arg_block_size_bytes);
+    printf ("--rewrite\n");
+    printf ("  Write a new pattern to all memory, even if unchanged\n");
+    printf ("--reset_devices\n");
+    printf ("  Reset the devices before use\n");
+
+    exit (EXIT_FAILURE);
+}
+
+
+/**
+ * @brief Parse the command line arguments, storing the results in global variables
+ * @param[in] argc, argv Arguments passed to main
+ */
+static void parse_command_line_arguments (int argc, char *argv[])
+{
+    int opt_status;
+    char junk;
+
+    do
+    {
+        int option_index = 0;
+
+        opt_status = getopt_long (argc, argv, "", command_line_options, &option_index);
+        if (opt_status == '?')
+        {
+            display_usage ();
+        }
+        else if (opt_status >= 0)
+        {
+            const struct option *const optdef = &command_line_options[option_index];
+
+            if (optdef->flag != NULL)
+            {
+                /* Argument just sets a flag */
+            }
+            else if (strcmp (optdef->name, "state_file") == 0)
+            {
+                arg_state_pathname = optarg;
+            }
+            else if (strcmp (optdef->name, "block_size") == 0)
+            {
+                if ((sscanf (optarg, "%zi%c", &arg_block_size_bytes, &junk) != 1) ||
+                    (arg_block_size_bytes < DMA_MEMORY_TEST_MIN_CHUNK_SIZE_BYTES) ||
+                    ((arg_block_size_bytes % sizeof (uint64_t)) != 0))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else if (strcmp (optdef->name, "rewrite") == 0)
+            {
+                arg_rewrite = true;
+            }
+            else if (strcmp (optdef->name, "reset_devices") == 0)
+            {
+                arg_reset_devices = true;
+            }
+            else
+            {
+                /* This is a program error, and shouldn't be triggered by the command line options */
+                fprintf (stderr, "Unexpected argument definition %s\n", optdef->name);
+                exit (EXIT_FAILURE);
+            }
+        }
+    } while (opt_status != -1);
+}
+
+
+/**
+ * @brief Read the state file, if it exists
+ * @details If the state file doesn't exist, is an unsupported format or contains an inconsistent region, starts with an
+ *          empty state
+ * @param[out] state The state read from the file
+ */
+static void read_state_file (persistence_state_t *const state)
+{
+    FILE *state_file;
+    bool success;
+
+    memset (state, 0, sizeof (*state));
+    state_file = fopen (arg_state_pathname, "rb");
+    if (state_file == NULL)
+    {
+        printf ("No existing state file %s\n", arg_state_pathname);
+        return;
+    }
+
+    success = (fread (&state->header, sizeof (state->header), 1, state_file) == 1) &&
+            (state->header.magic == STATE_FILE_MAGIC) &&
+            (state->header.format_version == STATE_FILE_FORMAT_VERSION) &&
+            (state->header.region_size == sizeof (state_file_region_t));
+    if (success)
+    {
+        state->regions_allocated_length = state->header.num_regions;
+        state->regions = calloc (state->regions_allocated_length, sizeof (state->regions[0]));
+        success = (state->regions != NULL) || (state->regions_allocated_length == 0);
+    }
+    for (uint32_t region_index = 0; success && (region_index < state->header.num_regions); region_index++)
+    {
+        region_state_t *const region_state = &state->regions[region_index];
+
+        success = fread (&region_state->region, sizeof (region_state->region), 1, state_file) == 1;
+        if (success && (region_state->region.num_blocks > 0))
+        {
+            /* Reject an inconsistent number of blocks, since verifying the region iterates over num_blocks and
+             * assumes they are all within size_bytes */
+            const state_file_region_t *const region = &region_state->region;
+
+            success = (region->block_size_bytes > 0) &&
+                    (region->num_blocks == ((region->size_bytes + region->block_size_bytes - 1) / region->block_size_bytes));
+        }
+        if (success)
+        {
+            region_state->checksums = calloc (region_state->region.num_blocks, sizeof (region_state->checksums[0]));
+            success = (region_state->checksums != NULL) &&
+                    (fread (region_state->checksums, sizeof (region_state->checksums[0]), region_state->region.num_blocks,
+                            state_file) == region_state->region.num_blocks);
+        }
+    }
+    (void) fclose (state_file);
+
+    if (!success)
+    {
+        printf ("Ignoring invalid state file %s\n", arg_state_pathname);
+        for (uint32_t region_index = 0; region_index < state->regions_allocated_length; region_index++)
+        {
+            free (state->regions[region_index].checksums);
+        }
+        free (state->regions);
+        memset (state, 0, sizeof (*state));
+    }
+}
+
+
+/**
+ * @brief Write the state file
+ * @details Written to a temporary file which is then renamed, so that the previous state file isn't lost if this
+ *          program is interrupted while writing the file.
+ * @param[in] state The state to write
+ */
+static void write_state_file (const persistence_state_t *const state)
+{
+    char temporary_pathname[PATH_MAX + 16];
+    FILE *state_file;
+    bool success;
+    int rc;
+
+    snprintf (temporary_pathname, sizeof (temporary_pathname), "%s.%d", arg_state_pathname, getpid ());
+    state_file = fopen (temporary_pathname, "wb");
+    success = state_file != NULL;
+    if (success)
+    {
+        success = fwrite (&state->header, sizeof (state->header), 1, state_file) == 1;
+        for (uint32_t region_index = 0; success && (region_index < state->header.num_regions); region_index++)
+        {
+            const region_state_t *const region_state = &state->regions[region_index];
+
+            success = (fwrite (&region_state->region, sizeof (region_state->region), 1, state_file) == 1) &&
+                    (fwrite (region_state->checksums, sizeof (region_state->checksums[0]), region_state->region.num_blocks,
+                            state_file) == region_state->region.num_blocks);
+        }
+        rc = fclose (state_file);
+        success = success && (rc == 0);
+        if (success)
+        {
+            rc = rename (temporary_pathname, arg_state_pathname);
+            success = rc == 0;
+        }
+        if (!success)
+        {
+            (void) remove (temporary_pathname);
+        }
+    }
+
+    if (!success)
+    {
+        printf ("Failed to write state file %s\n", arg_state_pathname);
+        exit (EXIT_FAILURE);
+    }
+}
+
+
+/**
+ * @brief Read the Linux boot_id, which changes on every boot
+ * @param[out] boot_id The boot_id read, or an empty string if couldn't be read
+ */
+static void read_boot_id (char boot_id[const BOOT_ID_LEN])
+{
+    FILE *const boot_id_file = fopen ("/proc/sys/kernel/random/boot_id", "r");
+
+    memset (boot_id, 0, BOOT_ID_LEN);
+    if (boot_id_file != NULL)
+    {
+        if (fgets (boot_id, BOOT_ID_LEN, boot_id_file) != NULL)
+        {
+            boot_id[strcspn (boot_id, "\n")] = '\0';
+        }
+        (void) fclose (boot_id_file);
+    }
+}
+
+
+/**
+ * @brief Display a CLOCK_REALTIME time in seconds as a date/time, without a trailing newline
+ * @param[in] time_secs The time to display
+ */
+static void display_date_time (const int64_t time_secs)
+{
+    const time_t display_time = (time_t) time_secs;
+    char date_time_text[64];
+
+    (void) ctime_r (&display_time, date_time_text);
+    date_time_text[strcspn (date_time_text, "\n")] = '\0';
+    printf ("%s", date_time_text);
+}
+
+
+/**
+ * @brief Update the run and reboot counts in the state, reporting the time since the previous run and any reboot
+ * @param[in/out] state The state to update
+ * @param[in] now The CLOCK_REALTIME seconds of this run
+ */
+static void record_run (persistence_state_t *const state, const int64_t now)
+{
+    char boot_id[BOOT_ID_LEN];
+
+    read_boot_id (boot_id);
+    printf ("Now: ");
+    display_date_time (now);
+    printf (" boot_id %s\n", boot_id);
+
+    if (state->header.num_runs > 0)
+    {
+        const bool rebooted = strcmp (boot_id, state->header.previous_boot_id) != 0;
+
+        printf ("Previous run: ");
+        display_date_time (state->header.previous_run_time);
+        printf (" (%.1f hours ago) boot_id %s\n",
+                (double) (now - state->header.previous_run_time) / 3600.0, state->header.previous_boot_id);
+        if (rebooted)
+        {
+            state->header.num_reboots++;
+        }
+        printf ("%s since the previous run. %" PRIu32 " previous runs, with reboots detected at %" PRIu32 " runs\n",
+                rebooted ? "Rebooted" : "Not rebooted", state->header.num_runs, state->header.num_reboots);
+    }
+    else
+    {
+        memset (&state->header, 0, sizeof (state->header));
+        state->header.magic = STATE_FILE_MAGIC;
+        state->header.format_version = STATE_FILE_FORMAT_VERSION;
+        state->header.region_size = sizeof (state_file_region_t);
+    }
+
+    state->header.num_runs++;
+    state->header.previous_run_time = now;
+    snprintf (state->header.previous_boot_id, sizeof (state->header.previous_boot_id), "%s", boot_id);
+}
+
+
+/**
+ * @brief Generate one word of the test pattern
+ * @details Each word is generated independently from the seed and the offset of the word, so that the expected contents
+ *          of any block can be regenerated without generating the preceding blocks.
+ * @param[in] seed The seed for the pattern
+ * @param[in] offset The byte offset of the word in the region
+ * @return The pattern word
+ */
+static inline uint64_t pattern_word (const uint64_t seed, const uint64_t offset)
+{
+    uint64_t word = seed ^ (offset * 0x9E3779B97F4A7C15ULL);
+
+    linear_congruential_generator64 (&word);
+    return word;
+}
+
+
+/**
+ * @brief Calculate a checksum for a block of words
+ * @details Uses a Fletcher-64 checksum, of 32-bit halves of each word, as this is sensitive to the position of changes.
+ *          The modulo reduction is only performed every CHECKSUM_REDUCTION_INTERVAL inputs to reduce the cost.
+ * @param[in] num_words The number of words in the block
+ * @param[in] words The block to calculate the checksum for
+ * @return The checksum
+ */
+static uint64_t block_checksum (const size_t num_words, const uint64_t words[const num_words])
+{
+    const uint64_t modulus = 0xffffffffULL;
+    uint64_t sum1 = 0;
+    uint64_t sum2 = 0;
+    uint32_t num_unreduced = 0;
+
+    for (size_t word_index = 0; word_index < num_words; word_index++)
+    {
+        sum1 += words[word_index] & 0xffffffffULL;
+        sum2 += sum1;
+        sum1 += words[word_index] >> 32;
+        sum2 += sum1;
+        num_unreduced += 2;
+        if (num_unreduced >= CHECKSUM_REDUCTION_INTERVAL)
+        {
+            sum1 %= modulus;
+            sum2 %= modulus;
+            num_unreduced = 0;
+        }
+    }
+
+    return ((sum2 % modulus) << 32) | (sum1 % modulus);
+}
+
+
+/**
+ * @brief Get the number of words in one block of a region, where the final block may be shorter
+ * @param[in] region The region
+ * @param[in] block_index Which block to get the size of
+ * @return The number of words in the block
+ */
+static size_t get_block_num_words (const persistence_region_t *const region, const uint64_t block_index)
+{
+    const uint64_t block_offset = block_index * arg_block_size_bytes;
+    const uint64_t remaining_bytes = region->size_bytes - block_offset;
+
+    return ((remaining_bytes < arg_block_size_bytes) ? remaining_bytes : arg_block_size_bytes) / sizeof (uint64_t);
+}
+
+
+/**
+ * @brief Wait for the DMA transfer which has been started on a channel to complete
+ * @param[in/out] region The region being accessed
+ * @param[in/out] transfer The channel the transfer was started on
+ * @return Returns the host buffer for the transfer, or NULL if the transfer failed
+ */
+static void *await_dma_transfer (persistence_region_t *const region, x2x_transfer_context_t *const transfer)
+{
+    void *host_buffer = NULL;
+
+    while (region->dma_context->transfer_success && (host_buffer == NULL))
+    {
+        host_buffer = x2x_poll_completed_transfer (transfer, NULL, NULL);
+    }
+
+    return host_buffer;
+}
+
+
+/**
+ * @brief Read one block of a region
+ * @param[in/out] region The region to read
+ * @param[in] block_index Which block to read
+ * @return Returns a pointer to the block contents in host memory, or NULL if the read failed
+ */
+static const uint64_t *read_block (persistence_region_t *const region, const uint64_t block_index)
+{
+    const uint64_t block_offset = block_index * arg_block_size_bytes;
+    const size_t block_size_bytes = get_block_num_words (region, block_index) * sizeof (uint64_t);
+
+    if (region->access == REGION_ACCESS_DMA)
+    {
+        x2x_transfer_context_t *const transfer = &region->dma_context->c2h_transfer;
+
+        if (x2x_populate_memory_transfer (transfer, block_size_bytes, 0, block_offset) == NULL)
+        {
+            return NULL;
+        }
+        x2x_start_populated_descriptors (transfer);
+        return await_dma_transfer (region, transfer);
+    }
+    else
+    {
+        memcpy (region->block_buffer, &region->mapped_bar[block_offset], block_size_bytes);
+        return region->block_buffer;
+    }
+}
+
+
+/**
+ * @brief Write one block of a region with the test pattern, returning the checksum of the block
+ * @param[in/out] region The region to write
+ * @param[in] block_index Which block to write
+ * @param[in] seed The seed for the pattern
+ * @param[out] checksum The checksum of the block
+ * @return Returns true if the write was successful
+ */
+static bool write_pattern_block (persistence_region_t *const region, const uint64_t block_index, const uint64_t seed,
+                                 uint64_t *const checksum)
+{
+    const uint64_t block_offset = block_index * arg_block_size_bytes;
+    const size_t block_num_words = get_block_num_words (region, block_index);
+    const size_t block_size_bytes = block_num_words * sizeof (uint64_t);
+    x2x_transfer_context_t *const transfer =
+            (region->access == REGION_ACCESS_DMA) ? &region->dma_context->h2c_transfer : NULL;
+    uint64_t *const words = (transfer != NULL) ?
+            x2x_populate_memory_transfer (transfer, block_size_bytes, 0, block_offset) : region->block_buffer;
+
+    if (words == NULL)
+    {
+        return false;
+    }
+
+    for (size_t word_index = 0; word_index < block_num_words; word_index++)
+    {
+        words[word_index] = pattern_word (seed, block_offset + (word_index * sizeof (uint64_t)));
+    }
+    *checksum = block_checksum (block_num_words, words);
+
+    if (transfer != NULL)
+    {
+        x2x_start_populated_descriptors (transfer);
+        return await_dma_transfer (region, transfer) != NULL;
+    }
+    else
+    {
+        memcpy (&region->mapped_bar[block_offset], words, block_size_bytes);
+        return true;
+    }
+}
+
+
+/**
+ * @brief Find the existing state for a region
+ * @param[in/out] state The state to search
+ * @param[in] region The region to find
+ * @return The existing region state, or NULL if the region hasn't been previously checked
+ */
+static region_state_t *find_region_state (persistence_state_t *const state, const persistence_region_t *const region)
+{
+    for (uint32_t region_index = 0; region_index < state->header.num_regions; region_index++)
+    {
+        region_state_t *const region_state = &state->regions[region_index];
+
+        if ((strcmp (region_state->region.device_name, region->vfio_device->device_name) == 0) &&
+            (region_state->region.access == region->access) &&
+            (region_state->region.bar_index == region->bar_index) &&
+            (region_state->region.base_address == region->base_address))
+        {
+            return region_state;
+        }
+    }
+
+    return NULL;
+}
+
+
+/**
+ * @brief Report one range of contiguous changed blocks
+ * @param[in] first_block The first changed block in the range
+ * @param[in] last_block The last changed block in the range
+ * @param[in] num_changed_words The number of words in the range which differ from the pattern
+ * @param[in/out] num_reported_ranges The number of ranges reported, to limit the output
+ */
+static void report_changed_range (const uint64_t first_block, const uint64_t last_block, const uint64_t num_changed_words,
+                                  uint32_t *const num_reported_ranges)
+{
+    if (*num_reported_ranges < MAX_REPORTED_CHANGED_RANGES)
+    {
+        printf ("  Changed blocks %" PRIu64 "-%" PRIu64 " (offsets 0x%" PRIx64 "-0x%" PRIx64 ") : %" PRIu64
+                " words differ from the pattern\n", first_block, last_block,
+                first_block * arg_block_size_bytes, ((last_block + 1) * arg_block_size_bytes) - 1, num_changed_words);
+    }
+    else if (*num_reported_ranges == MAX_REPORTED_CHANGED_RANGES)
+    {
+        printf ("  Further ranges of changed blocks not reported\n");
+    }
+    (*num_reported_ranges)++;
+}
+
+
+/**
+ * @brief Verify the contents of a region against the stored checksums, reporting the changed blocks
+ * @param[in/out] region The region to verify
+ * @param[in] region_state The stored state for the region
+ * @param[out] num_changed_blocks The number of blocks which changed
+ * @return Returns true if all blocks could be read
+ */
+static bool verify_region (persistence_region_t *const region, const region_state_t *const region_state,
+                           uint64_t *const num_changed_blocks)
+{
+    const uint64_t num_blocks = region_state->region.num_blocks;
+    const uint64_t seed = region_state->region.pattern_seed;
+    bool in_changed_range = false;
+    uint64_t range_first_block = 0;
+    uint64_t range_changed_words = 0;
+    uint32_t num_reported_ranges = 0;
+    bool success = true;
+
+    *num_changed_blocks = 0;
+    const int64_t start_time = get_monotonic_time ();
+    for (uint64_t block_index = 0; success && (block_index < num_blocks); block_index++)
+    {
+        const size_t block_num_words = get_block_num_words (region, block_index);
+        const uint64_t *const words = read_block (region, block_index);
+
+        success = words != NULL;
+        if (success)
+        {
+            const bool changed = block_checksum (block_num_words, words) != region_state->checksums[block_index];
+
+            if (changed)
+            {
+                const uint64_t block_offset = block_index * arg_block_size_bytes;
+
+                if (!in_changed_range)
+                {
+                    in_changed_range = true;
+                    range_first_block = block_index;
+                    range_changed_words = 0;
+                }
+                for (size_t word_index = 0; word_index < block_num_words; word_index++)
+                {
+                    if (words[word_index] != pattern_word (seed, block_offset + (word_index * sizeof (uint64_t))))
+                    {
+                        range_changed_words++;
+                    }
+                }
+                (*num_changed_blocks)++;
+            }
+            else if (in_changed_range)
+            {
+                report_changed_range (range_first_block, block_index - 1, range_changed_words, &num_reported_ranges);
+                in_changed_range = false;
+            }
+        }
+    }
+    if (success && in_changed_range)
+    {
+        report_changed_range (range_first_block, num_blocks - 1, range_changed_words, &num_reported_ranges);
+    }
+    const int64_t elapsed_ns = get_monotonic_time () - start_time;
+
+    if (success)
+    {
+        printf ("  Read %" PRIu64 " bytes using %s in %.3f secs (%.1f Mbytes/sec)\n", region->size_bytes,
+                region_access_names[region->access], (double) elapsed_ns / 1E9,
+                ((double) region->size_bytes * 1E3) / (double) elapsed_ns);
+    }
+    else
+    {
+        printf ("  Failed to read the region\n");
+    }
+
+    return success;
+}
+
+
+/**
+ * @brief Write a new pattern to a region, storing the seed and checksums in the region state
+ * @param[in/out] region The region to write
+ * @param[in/out] region_state Updated with the new pattern
+ * @param[in] header The state file header, which gives the current run and reboot counts
+ * @param[in] now The CLOCK_REALTIME seconds of this run
+ * @return Returns true if all blocks were written
+ */
+static bool write_region_pattern (persistence_region_t *const region, region_state_t *const region_state,
+                                  const state_file_header_t *const header, const int64_t now)
+{
+    uint64_t seed = (uint64_t) get_monotonic_time () ^ ((uint64_t) now << 32) ^ (uint64_t) getpid ();
+    bool success = true;
+
+    linear_congruential_generator64 (&seed);
+    const int64_t start_time = get_monotonic_time ();
+    for (uint64_t block_index = 0; success && (block_index < region_state->region.num_blocks); block_index++)
+    {
+        success = write_pattern_block (region, block_index, seed, &region_state->checksums[block_index]);
+    }
+    const int64_t elapsed_ns = get_monotonic_time () - start_time;
+
+    if (success)
+    {
+        region_state->region.pattern_seed = seed;
+        region_state->region.written_time = now;
+        region_state->region.written_num_runs = header->num_runs;
+        region_state->region.written_num_reboots = header->num_reboots;
+        printf ("  Wrote pattern with seed 0x%016" PRIx64 " using %s in %.3f secs\n",
+                seed, region_access_names[region->access], (double) elapsed_ns / 1E9);
+    }
+    else
+    {
+        /* Don't leave checksums which don't match the memory contents */
+        region_state->region.num_blocks = 0;
+        printf ("  Failed to write the pattern\n");
+    }
+
+    return success;
+}
+
+
+/**
+ * @brief Check the persistence of one region, and update the state for the region
+ * @param[in/out] state The persistence state
+ * @param[in/out] region The region to check
+ * @param[in] now The CLOCK_REALTIME seconds of this run
+ * @return Returns true if the region kept its contents since the previous run
+ */
+static bool check_region (persistence_state_t *const state, persistence_region_t *const region, const int64_t now)
+{
+    const uint64_t num_blocks = (region->size_bytes + arg_block_size_bytes - 1) / arg_block_size_bytes;
+    region_state_t *region_state = find_region_state (state, region);
+    uint64_t num_changed_blocks = 0;
+    bool unchanged = false;
+    bool success = true;
+
+    printf ("\nDevice %s %s", region->vfio_device->device_name, region_access_names[region->access]);
+    if (region->access == REGION_ACCESS_DMA)
+    {
+        printf (" memory base 0x%" PRIx64, region->base_address);
+    }
+    else
+    {
+        printf (" BAR %" PRIu32, region->bar_index);
+    }
+    printf (" size 0x%" PRIx64 " in %" PRIu64 " blocks of 0x%zx bytes\n", region->size_bytes, num_blocks, arg_block_size_bytes);
+
+    if ((region_state != NULL) &&
+        ((region_state->region.size_bytes != region->size_bytes) ||
+         (region_state->region.block_size_bytes != arg_block_size_bytes)))
+    {
+        printf ("  Size or block size differs from the previous run, so not checked\n");
+        free (region_state->checksums);
+        region_state->checksums = NULL;
+        region_state->region.num_blocks = 0;
+    }
+    else if ((region_state != NULL) && (region_state->region.num_blocks > 0))
+    {
+        printf ("  Pattern seed 0x%016" PRIx64 " written at ", region_state->region.pattern_seed);
+        display_date_time (region_state->region.written_time);
+        printf (" (%" PRIu32 " runs and %" PRIu32 " reboots ago)\n",
+                state->header.num_runs - region_state->region.written_num_runs,
+                state->header.num_reboots - region_state->region.written_num_reboots);
+        success = verify_region (region, region_state, &num_changed_blocks);
+        if (success)
+        {
+            unchanged = num_changed_blocks == 0;
+            if (unchanged)
+            {
+                printf ("  All %" PRIu64 " blocks unchanged\n", num_blocks);
+            }
+            else
+            {
+                printf ("  %" PRIu64 " of %" PRIu64 " blocks changed\n", num_changed_blocks, num_blocks);
+            }
+        }
+    }
+    else
+    {
+        printf ("  Not previously checked\n");
+    }
+
+    if (region_state == NULL)
+    {
+        state->regions = vfio_grow_array (state->regions, &state->regions_allocated_length, state->header.num_regions + 1,
+                sizeof (state->regions[0]), "persistence regions");
+        region_state = &state->regions[state->header.num_regions];
+        state->header.num_regions++;
+        memset (region_state, 0, sizeof (*region_state));
+        snprintf (region_state->region.device_name, sizeof (region_state->region.device_name), "%s",
+                region->vfio_device->device_name);
+        region_state->region.access = region->access;
+        region_state->region.bar_index = region->bar_index;
+        region_state->region.base_address = region->base_address;
+    }
+    region_state->checked = true;
+
+    /* Write a new pattern when the memory has changed, so that the next run checks persistence from a known state */
+    if (success && (!unchanged || arg_rewrite))
+    {
+        free (region_state->checksums);
+        region_state->checksums = calloc (num_blocks, sizeof (region_state->checksums[0]));
+        if (region_state->checksums == NULL)
+        {
+            printf ("Failed to allocate checksums\n");
+            exit (EXIT_FAILURE);
+        }
+        region_state->region.size_bytes = region->size_bytes;
+        region_state->region.block_size_bytes = arg_block_size_bytes;
+        region_state->region.num_blocks = num_blocks;
+        (void) write_region_pattern (region, region_state, &state->header, now);
+    }
+
+    return unchanged;
+}
+
+
+/**
+ * @brief Check the persistence of the BARs of the memory mapped block RAM design, using PIO
+ * @param[in/out] state The persistence state
+ * @param[in] now The CLOCK_REALTIME seconds of this run
+ */
+static void check_pio_regions (persistence_state_t *const state, const int64_t now)
+{
+    vfio_devices_t vfio_devices;
+    const vfio_pci_device_identity_filter_t filter =
+    {
+        .vendor_id = FPGA_SIO_VENDOR_ID,
+        .device_id = VFIO_PCI_DEVICE_FILTER_ANY,
+        .subsystem_vendor_id = FPGA_SIO_SUBVENDOR_ID,
+        .subsystem_device_id = FPGA_SIO_SUBDEVICE_ID_MEMMAPPED_BLKRAM,
+        .dma_capability = VFIO_DEVICE_DMA_CAPABILITY_NONE
+    };
+    uint64_t *const block_buffer = malloc (arg_block_size_bytes);
+
+    if (block_buffer == NULL)
+    {
+        printf ("Failed to allocate block buffer\n");
+        exit (EXIT_FAILURE);
+    }
+
+    open_vfio_devices_matching_filter (&vfio_devices, 1, &filter);
+    for (uint32_t device_index = 0; device_index < vfio_devices.num_devices; device_index++)
+    {
+        vfio_device_t *const vfio_device = vfio_devices.devices[device_index];
+
+        if (arg_reset_devices)
+        {
+            reset_vfio_device (vfio_device);
+        }
+        for (uint32_t bar_index = 0; bar_index < PCI_STD_NUM_BARS; bar_index++)
+        {
+            map_vfio_device_bar_before_use (vfio_device, bar_index);
+            if (vfio_device->mapped_bars[bar_index] != NULL)
+            {
+                persistence_region_t region =
+                {
+                    .vfio_device = vfio_device,
+                    .access = REGION_ACCESS_PIO,
+                    .bar_index = bar_index,
+                    .base_address = 0,
+                    .size_bytes = vfio_device->regions_info[bar_index].size & ~(sizeof (uint64_t) - 1),
+                    .mapped_bar = vfio_device->mapped_bars[bar_index],
+                    .dma_context = NULL,
+                    .block_buffer = block_buffer
+                };
+
+                (void) check_region (state, &region, now);
+            }
+        }
+    }
+    close_vfio_devices (&vfio_devices);
+
+    free (block_buffer);
+}
+
+
+/**
+ * @brief Check the persistence of the memory of designs with a DMA/Bridge Subsystem with DMA accessible memory
+ * @param[in/out] state The persistence state
+ * @param[in] now The CLOCK_REALTIME seconds of this run
+ */
+static void check_dma_regions (persistence_state_t *const state, const int64_t now)
+{
+    fpga_designs_t designs;
+
+    identify_pcie_fpga_designs (&designs);
+    for (uint32_t design_index = 0; design_index < designs.num_identified_designs; design_index++)
+    {
+        fpga_design_t *const design = &designs.designs[design_index];
+
+        if (design->dma_bridge_present && (design->dma_bridge_memory_size_bytes > 0))
+        {
+            const dma_memory_test_configuration_t configuration =
+            {
+                .vfio_device = design->vfio_device,
+                .bar_index = design->dma_bridge_bar,
+                .memory_base_address = design->dma_bridge_memory_base_address,
+                .memory_size_bytes = design->dma_bridge_memory_size_bytes,
+                .h2c_channel_id = 0,
+                .c2h_channel_id = 0,
+                .chunk_size_bytes = arg_block_size_bytes,
+                .buffer_allocation = VFIO_BUFFER_ALLOCATION_HEAP
+            };
+            dma_memory_test_context_t *const context = calloc (1, sizeof (*context));
+
+            if (context == NULL)
+            {
+                printf ("Failed to allocate dma_memory_test_context_t\n");
+                exit (EXIT_FAILURE);
+            }
+
+            if (arg_reset_devices)
+            {
+                reset_vfio_device (design->vfio_device);
+            }
+            if (dma_memory_test_initialise (context, &configuration))
+            {
+                persistence_region_t region =
+                {
+                    .vfio_device = design->vfio_device,
+                    .access = REGION_ACCESS_DMA,
+                    .bar_index = design->dma_bridge_bar,
+                    .base_address = design->dma_bridge_memory_base_address,
+                    .size_bytes = design->dma_bridge_memory_size_bytes & ~(sizeof (uint64_t) - 1),
+                    .mapped_bar = NULL,
+                    .dma_context = context,
+                    .block_buffer = NULL
+                };
+
+                /* dma_memory_test_finalise() reports the reason for a DMA failure */
+                (void) check_region (state, &region, now);
+                dma_memory_test_finalise (context);
+            }
+            free (context);
+        }
+    }
+    close_pcie_fpga_designs (&designs);
+}
+
+
+int main (int argc, char *argv[])
+{
+    persistence_state_t state;
+
+    parse_command_line_arguments (argc, argv);
+
+    const int64_t now = (int64_t) time (NULL);
+    read_state_file (&state);
+    record_run (&state, now);
+
+    check_pio_regions (&state, now);
+    check_dma_regions (&state, now);
+
+    /* Regions not present in this run are retained in the state file, for when the device is next present */
+    for (uint32_t region_index = 0; region_index < state.header.num_regions; region_index++)
+    {
+        if (!state.regions[region_index].checked)
+        {
+            printf ("\nDevice %s %s region not present in this run\n", state.regions[region_index].region.device_name,
+                    region_access_names[state.regions[region_index].region.access]);
+        }
+    }
+
+    write_state_file (&state);
+
+    for (uint32_t region_index = 0; region_index < state.header.num_regions; region_index++)
+    {
+        free (state.regions[region_index].checksums);
+    }
+    free (state.regions);
+
+    return EXIT_SUCCESS;
+}
@@ -188,7 +188,7 @@ int main (int argc, char *argv[])
     /* Perform tests on the FPGA devices */
     for (uint32_t device_index = 0; device_index < vfio_devices.num_devices; device_index++)
     {
-        vfio_device_t *const vfio_device = &vfio_devices.devices[device_index];
+        vfio_device_t *const vfio_device = vfio_devices.devices[device_index];
 
         if (reset_device_before_use)
         {
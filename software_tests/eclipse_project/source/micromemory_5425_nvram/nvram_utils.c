@@ -115,6 +115,98 @@ void initialise_nvram_device (uint8_t *const csr)
 }
 
 
+/**
+ * @brief Initialise the context for a chain of DMA transfers for the NVRAM device
+ * @details The chain is initially empty, and queue_nvram_dma_transfer() is used to add transfers to the chain.
+ * @param[out] context The initialised transfer context.
+ * @param[in/out] descriptors_mapping Used to allocate the descriptors in host memory for the chain of DMA transfers.
+ * @param[in] max_descriptors The maximum number of DMA transfers which can be queued in the chain.
+ * @return Returns true if the context has been initialised, or false if an error occurred.
+ *         An error occurs if can't allocate the descriptors.
+ */
+bool initialise_nvram_chained_transfer_context (nvram_transfer_context_t *const context,
+                                                vfio_dma_mapping_t *const descriptors_mapping,
+                                                const uint32_t max_descriptors)
+{
+    memset (context, 0, sizeof (*context));
+
+    /* Allocate the descriptors for the chain */
+    const size_t descriptors_size = max_descriptors * sizeof (struct mm_dma_desc);
+    context->descriptors =
+            vfio_dma_mapping_allocate_space (descriptors_mapping, descriptors_size, &context->descriptors_iova);
+    if (context->descriptors == NULL)
+    {
+        return false;
+    }
+    vfio_dma_mapping_align_space (descriptors_mapping);
+    memset (context->descriptors, 0, descriptors_size);
+    context->max_descriptors = max_descriptors;
+
+    return true;
+}
+
+
+/**
+ * @brief Clear the chain of DMA transfers for the NVRAM device, so that a different set of transfers can be queued.
+ * @details Must only be called when the chain is not in use by the NVRAM device DMA engine.
+ * @param[in/out] context The transfer context to clear the chain for.
+ */
+void clear_nvram_dma_chain (nvram_transfer_context_t *const context)
+{
+    context->num_queued_descriptors = 0;
+    context->num_completed_descriptors = 0;
+    context->error_sem_control_bits = 0;
+}
+
+
+/**
+ * @brief Queue one DMA transfer at the end of a chain for the NVRAM device
+ * @details The direction of each transfer in a chain can be different, which allows host-to-card and card-to-host
+ *          transfers to be overlapped within one chain without waiting for software to start each transfer.
+ * @param[in/out] context The transfer context to add the transfer to.
+ * @param[in] transfer_direction The transfer direction from the point of view of the NVRAM DMA:
+ *                               - DMA_READ_FROM_HOST or DMA_WRITE_TO_HOST
+ * @param[in] local_addr The NVRAM address for the transfer.
+ * @param[in] data_iova The host IOVA for the transfer.
+ * @param[in] transfer_size The size of the transfer in bytes.
+ * @return Returns true if the transfer has been queued, or false if the chain is full.
+ */
+bool queue_nvram_dma_transfer (nvram_transfer_context_t *const context, const int transfer_direction,
+                               const uint64_t local_addr, const uint64_t data_iova, const uint32_t transfer_size)
+{
+    if (context->num_queued_descriptors == context->max_descriptors)
+    {
+        return false;
+    }
+
+    const uint32_t descriptor_index = context->num_queued_descriptors;
+    struct mm_dma_desc *const descriptor = &context->descriptors[descriptor_index];
+    const uint64_t descriptor_iova = context->descriptors_iova + (descriptor_index * sizeof (struct mm_dma_desc));
+
+    memset (descriptor, 0, sizeof (*descriptor));
+    descriptor->local_addr = local_addr;
+    descriptor->pci_addr = data_iova;
+    descriptor->transfer_size = transfer_size;
+
+    /* Set the semaphore address used to indicate completion to the sem_control_bits within the descriptor */
+    descriptor->sem_addr = descriptor_iova + offsetof (struct mm_dma_desc, sem_control_bits);
+
+    /* Set the control bits to be used for the transfer, including the direction.
+     * Since poll sem_control_bits for completion, don't set the DMASCR_DMA_COMP_EN or DMASCR_CHAIN_COMP_EN bits, since they
+     * cause the NVRAM device to generate interrupts for which no handler has been installed via VFIO.
+     * The next_desc_addr and DMASCR_CHAIN_EN bit are set when the chain is started, once the end of the chain is known. */
+    descriptor->control_bits = DMASCR_GO | DMASCR_SEM_EN | NVRAM_PCI_CMDS;
+    if (transfer_direction == DMA_READ_FROM_HOST)
+    {
+        descriptor->control_bits |= DMASCR_TRANSFER_READ;
+    }
+
+    context->num_queued_descriptors++;
+
+    return true;
+}
+
+
 /**
  * @brief Initialise the context for one DMA transfer for the NVRAM device
  * @param[out] context The initialised transfer context, which may be used to perform DMA.
@@ -131,16 +223,13 @@ bool initialise_nvram_transfer_context (nvram_transfer_context_t *const context,
                                         vfio_dma_mapping_t *const data_mapping,
                                         const int transfer_direction)
 {
-    /* Allocate a descriptor for the transfer */
-    context->descriptor =
-            vfio_dma_mapping_allocate_space (descriptors_mapping, sizeof (struct mm_dma_desc), &context->descriptor_iova);
-    if (context->descriptor == NULL)
+    /* Allocate a single descriptor for the transfer */
+    if (!initialise_nvram_chained_transfer_context (context, descriptors_mapping, 1))
     {
         return false;
     }
-    vfio_dma_mapping_align_space (descriptors_mapping);
 
-    /* Set the descriptor to transfer the entire NVRAM contents */
+    /* Set the descriptor to transfer the entire NVRAM contents, starting from the first NVRAM address */
     uint64_t data_iova;
     void *data_buffer = vfio_dma_mapping_allocate_space (data_mapping, data_mapping->buffer.size, &data_iova);
 
@@ -148,49 +237,51 @@ bool initialise_nvram_transfer_context (nvram_transfer_context_t *const context,
     {
         return false;
     }
-    memset (context->descriptor, 0, sizeof (*context->descriptor));
-    context->descriptor->local_addr = 0; /* Start from first NVRAM address */
-    context->descriptor->pci_addr = data_iova;
-    context->descriptor->transfer_size = (uint32_t) data_mapping->buffer.size;
-
-    /* Set the semaphore address used to indicate completion to the sem_control_bits within the descriptor */
-    context->descriptor->sem_addr = context->descriptor_iova + offsetof (struct mm_dma_desc, sem_control_bits);
-
-    /* Single descriptor in the chain */
-    context->descriptor->next_desc_addr = 0;
-
-    /* Set the control bits to be used for the transfer, including the direction.
-     * Since poll sem_control_bits for completion, don't set the DMASCR_DMA_COMP_EN or DMASCR_CHAIN_COMP_EN bits, since they
-     * cause the NVRAM device to generate interrupts for which no handler has been installed via VFIO. */
-    context->descriptor->control_bits = DMASCR_GO | DMASCR_SEM_EN | NVRAM_PCI_CMDS;
-    if (transfer_direction == DMA_READ_FROM_HOST)
-    {
-        context->descriptor->control_bits |= DMASCR_TRANSFER_READ;
-    }
 
-    return true;
+    return queue_nvram_dma_transfer (context, transfer_direction, 0, data_iova, (uint32_t) data_mapping->buffer.size);
 }
 
 
 /**
- * @brief Start a DMA transfer in the NVRAM device
+ * @brief Start the chain of DMA transfers in the NVRAM device
+ * @details The queued transfers remain in the chain after they complete, so the same chain may be started again.
  * @param[in] csr Mapped to the NVRAM CSR
- * @param[in/out] context The transfer to start
+ * @param[in/out] context The chain of transfers to start
  */
 void start_nvram_dma_transfer (uint8_t *const csr, nvram_transfer_context_t *const context)
 {
+    /* Link the queued descriptors into a chain, where the last descriptor has no next descriptor.
+     * Zero the sem_control_bits in each descriptor to indicate the transfer is not complete.
+     * This gets written back by the DMA engine when each transfer completes. */
+    for (uint32_t descriptor_index = 0; descriptor_index < context->num_queued_descriptors; descriptor_index++)
+    {
+        struct mm_dma_desc *const descriptor = &context->descriptors[descriptor_index];
+        const uint32_t next_descriptor_index = descriptor_index + 1;
+
+        if (next_descriptor_index < context->num_queued_descriptors)
+        {
+            descriptor->next_desc_addr =
+                    context->descriptors_iova + (next_descriptor_index * sizeof (struct mm_dma_desc));
+            descriptor->control_bits |= DMASCR_CHAIN_EN;
+        }
+        else
+        {
+            descriptor->next_desc_addr = 0;
+            descriptor->control_bits &= (uint32_t) ~DMASCR_CHAIN_EN;
+        }
+        __atomic_store_n (&descriptor->sem_control_bits, 0, __ATOMIC_RELEASE);
+    }
+    context->num_completed_descriptors = 0;
+    context->error_sem_control_bits = 0;
+
     /* Write the unused CSR DMA addresses as zero, since these are taken from the descriptor */
     write_split_reg64 (csr, DMA_PCI_ADDR, 0);
     write_split_reg64 (csr, DMA_LOCAL_ADDR, 0);
     write_split_reg64 (csr, DMA_TRANSFER_SIZE, 0);
     write_split_reg64 (csr, DMA_SEMAPHORE_ADDR, 0);
 
-    /* Zero the sem_control_bits in the descriptor to indicate the transfer is not complete.
-     * This gets written back by the DMA engine when the transfers completes. */
-    __atomic_store_n (&context->descriptor->sem_control_bits, 0, __ATOMIC_RELEASE);
-
-    /* Write the address of the descriptor */
-    write_split_reg64 (csr, DMA_DESCRIPTOR_ADDR, context->descriptor_iova);
+    /* Write the address of the first descriptor */
+    write_split_reg64 (csr, DMA_DESCRIPTOR_ADDR, context->descriptors_iova);
 
     /* Start the transfer */
     write_reg32 (csr, DMA_STATUS_CTRL, DMASCR_GO | DMASCR_CHAIN_EN | NVRAM_PCI_CMDS);
@@ -198,13 +289,53 @@ void start_nvram_dma_transfer (uint8_t *const csr, nvram_transfer_context_t *con
 
 
 /**
- * @brief Poll for completion of a DMA transfer using the NVRAM device
- * @param[in] context The transfer to poll for completion
- * @return Returns true if the transfer has completed
+ * @brief Reap the completed DMA transfers in a chain for the NVRAM device
+ * @details The transfers in the chain complete in order, so stops at the first descriptor which hasn't completed.
+ * @param[in/out] context The chain of transfers to reap the completions for.
+ *                        num_completed_descriptors is advanced by the number of completions reaped.
+ * @return Returns the number of transfers which have completed since the previous call.
+ */
+uint32_t reap_nvram_dma_completions (nvram_transfer_context_t *const context)
+{
+    uint32_t num_reaped = 0;
+    bool completed = true;
+
+    while (completed && (context->num_completed_descriptors < context->num_queued_descriptors))
+    {
+        const struct mm_dma_desc *const descriptor = &context->descriptors[context->num_completed_descriptors];
+        const uint64_t sem_control_bits = __atomic_load_n (&descriptor->sem_control_bits, __ATOMIC_ACQUIRE);
+
+        completed = (sem_control_bits & DMASCR_DMA_COMPLETE) != 0;
+        if (completed)
+        {
+            if (((sem_control_bits & DMASCR_HARD_ERROR) != 0) && (context->error_sem_control_bits == 0))
+            {
+                context->error_sem_control_bits = sem_control_bits;
+            }
+            context->num_completed_descriptors++;
+            num_reaped++;
+        }
+    }
+
+    return num_reaped;
+}
+
+
+/**
+ * @brief Poll for completion of all DMA transfers in a chain using the NVRAM device
+ * @details Since the transfers in the chain complete in order, only needs to check the last descriptor in the chain.
+ * @param[in] context The chain of transfers to poll for completion
+ * @return Returns true if the transfers have completed
  */
 bool poll_nvram_dma_transfer_completion (const nvram_transfer_context_t *const context)
 {
-    const uint64_t sem_control_bits = __atomic_load_n (&context->descriptor->sem_control_bits, __ATOMIC_ACQUIRE);
+    if (context->num_queued_descriptors == 0)
+    {
+        return true;
+    }
+
+    const struct mm_dma_desc *const last_descriptor = &context->descriptors[context->num_queued_descriptors - 1];
+    const uint64_t sem_control_bits = __atomic_load_n (&last_descriptor->sem_control_bits, __ATOMIC_ACQUIRE);
 
     return (sem_control_bits & DMASCR_DMA_COMPLETE) != 0;
 }
@@ -27,13 +27,23 @@
 #define NVRAM_MEMORY_WINDOW_BAR_INDEX 2
 
 
-/* Contains once DMA transfer for the NVRAM device */
+/* Contains a chain of one or more DMA transfers for the NVRAM device.
+ * The NVRAM device DMA engine processes the descriptors in the chain in order, writing back the completion status of each
+ * descriptor to its sem_control_bits as it completes. This allows completions to be reaped as the chain progresses. */
 typedef struct
 {
-    /* The allocated descriptor in the host virtual address space */
-    struct mm_dma_desc *descriptor;
-    /* The IOVA of the descriptor to pass to the NVRAM device DMA engine */
-    uint64_t descriptor_iova;
+    /* The allocated descriptors in the host virtual address space, as a contiguous array */
+    struct mm_dma_desc *descriptors;
+    /* The IOVA of the first descriptor, to pass to the NVRAM device DMA engine */
+    uint64_t descriptors_iova;
+    /* The number of descriptors allocated, which is the maximum length of the chain */
+    uint32_t max_descriptors;
+    /* The number of descriptors queued in the chain, which are started by start_nvram_dma_transfer() */
+    uint32_t num_queued_descriptors;
+    /* The number of descriptors in the chain which have been reaped as completed since the chain was started */
+    uint32_t num_completed_descriptors;
+    /* Set to the sem_control_bits of the first descriptor reaped which reported a hard error, or zero if no error */
+    uint64_t error_sem_control_bits;
 } nvram_transfer_context_t;
 
 
@@ -44,7 +54,14 @@ bool initialise_nvram_transfer_context (nvram_transfer_context_t *const context,
                                         vfio_dma_mapping_t *const descriptors_mapping,
                                         vfio_dma_mapping_t *const data_mapping,
                                         const int transfer_direction);
+bool initialise_nvram_chained_transfer_context (nvram_transfer_context_t *const context,
+                                                vfio_dma_mapping_t *const descriptors_mapping,
+                                                const uint32_t max_descriptors);
+void clear_nvram_dma_chain (nvram_transfer_context_t *const context);
+bool queue_nvram_dma_transfer (nvram_transfer_context_t *const context, const int transfer_direction,
+                               const uint64_t local_addr, const uint64_t data_iova, const uint32_t transfer_size);
 void start_nvram_dma_transfer (uint8_t *const csr, nvram_transfer_context_t *const context);
+uint32_t reap_nvram_dma_completions (nvram_transfer_context_t *const context);
 bool poll_nvram_dma_transfer_completion (const nvram_transfer_context_t *const context);
 
 #endif /* NVRAM_UTILS_H_ */
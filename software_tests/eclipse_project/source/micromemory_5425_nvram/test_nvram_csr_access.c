@@ -94,7 +94,7 @@ int main (int argc, char *argv[])
     /* Process any Micro Memory devices found */
     for (uint32_t device_index = 0; device_index < vfio_devices.num_devices; device_index++)
     {
-        perform_nvram_csr_tests (&vfio_devices.devices[device_index], prompt);
+        perform_nvram_csr_tests (vfio_devices.devices[device_index], prompt);
     }
 
     close_vfio_devices (&vfio_devices);
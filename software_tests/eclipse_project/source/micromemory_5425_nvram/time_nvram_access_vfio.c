@@ -6,6 +6,10 @@
  * @details
  *   Performs timing of the NVRAM access using both DMA and PIO.
  *   Where PIO is performed by the CPU accessing the NVRAM via the memory mapped window.
+ *
+ *   The default DMA test performs one transfer at a time of the entire NVRAM.
+ *   The -p option instead performs a pipelined DMA test which uses chains of descriptors to overlap host-to-card and
+ *   card-to-host transfers, for a range of transfer sizes.
  */
 
 #include <stdlib.h>
@@ -19,6 +23,71 @@
 #include "nvram_utils.h"
 
 
+/* The range of transfer sizes used by the pipelined DMA test, in increments of powers of two */
+#define MIN_PIPELINED_TRANSFER_SIZE_BYTES (4 * 1024)
+#define MAX_PIPELINED_TRANSFER_SIZE_BYTES (1024 * 1024 * 1024)
+
+/* The number of passes over the entire NVRAM used by the pipelined DMA test for each transfer size */
+#define NUM_PIPELINED_PASSES 4
+
+/* The number of chains of descriptors used by the pipelined DMA test. While the NVRAM DMA engine is processing one chain,
+ * the next chain has already been populated so can be started as soon as the previous chain completes. */
+#define NUM_PIPELINED_CHAINS 2
+
+/* How long the pipelined DMA test waits for the next transfer in a chain to complete. Used in case the NVRAM DMA engine
+ * stops on a hard error without setting DMASCR_DMA_COMPLETE in the remaining descriptors of the chain. */
+#define PIPELINED_TRANSFER_TIMEOUT_NS 10000000000LL
+
+
+/* Command line argument which selects the pipelined DMA test, rather than the default serial DMA and PIO tests */
+static bool arg_pipelined_dma;
+
+
+/* Command line argument which sets the maximum number of descriptors in each chain for the pipelined DMA test */
+static uint32_t arg_chain_length = 64;
+
+
+/**
+ * @brief Parse the command line arguments, storing the results in global variables
+ * @param[in] argc, argv Arguments passed to main
+ */
+static void parse_command_line_arguments (int argc, char *argv[])
+{
+    const char *const optstring = "pc:?";
+    int option;
+    char junk;
+
+    option = getopt (argc, argv, optstring);
+    while (option != -1)
+    {
+        switch (option)
+        {
+        case 'p':
+            arg_pipelined_dma = true;
+            break;
+
+        case 'c':
+            if ((sscanf (optarg, "%" SCNu32 "%c", &arg_chain_length, &junk) != 1) || (arg_chain_length < 1))
+            {
+                printf ("ERROR: Invalid chain length \"%s\"\n", optarg);
+                exit (EXIT_FAILURE);
+            }
+            break;
+
+        case '?':
+        default:
+            printf ("Usage %s [-p] [-c <chain_length>]\n", argv[0]);
+            printf ("  -p performs a pipelined DMA test with overlapped host-to-card and card-to-host transfers,\n");
+            printf ("     rather than the serial DMA and PIO tests\n");
+            printf ("  -c sets the maximum number of descriptors in each chain for the pipelined DMA test\n");
+            exit (EXIT_FAILURE);
+            break;
+        }
+        option = getopt (argc, argv, optstring);
+    }
+}
+
+
 /**
  * @brief Test the NVRAM using DMA
  * @details Writes a test pattern to the entire NVRAM, and then reads back and checks the test pattern to verify the
@@ -100,6 +169,260 @@ static void test_nvram_via_dma (vfio_device_t *const vfio_device,
 }
 
 
+/* Contains the state for the pipelined DMA test for one transfer size */
+typedef struct
+{
+    /* The chains of descriptors, used alternately */
+    nvram_transfer_context_t chains[NUM_PIPELINED_CHAINS];
+    /* The time at which each chain was started, used as the start time of all transfers in the chain */
+    int64_t chain_start_times_ns[NUM_PIPELINED_CHAINS];
+    /* The IOVA of the host buffers for each direction */
+    uint64_t h2c_data_iova;
+    uint64_t c2h_data_iova;
+    /* The size of each transfer */
+    uint32_t transfer_size_bytes;
+    /* The total number of transfers in one pass over the entire NVRAM, and the index of the next transfer to queue.
+     * Transfers alternate between host-to-card and card-to-host for the same block of NVRAM, so that the card-to-host
+     * transfer reads back the data written by the preceding host-to-card transfer. */
+    uint32_t num_transfers_per_pass;
+    uint32_t next_transfer_index;
+    /* The latency of each completed transfer, measured from when the chain containing the transfer was started.
+     * This includes the time the transfer waited for the preceding transfers in the chain to be processed. */
+    int64_t *h2c_latencies_ns;
+    int64_t *c2h_latencies_ns;
+    size_t num_h2c_latencies;
+    size_t num_c2h_latencies;
+} nvram_pipeline_t;
+
+
+/**
+ * @brief Populate a chain with the next transfers for the current pass over the NVRAM
+ * @param[in/out] pipeline The pipeline to get the next transfers from
+ * @param[in/out] chain The chain to populate. Left empty if all transfers for the current pass have been queued.
+ */
+static void populate_pipeline_chain (nvram_pipeline_t *const pipeline, nvram_transfer_context_t *const chain)
+{
+    clear_nvram_dma_chain (chain);
+    while ((pipeline->next_transfer_index < pipeline->num_transfers_per_pass) &&
+           (chain->num_queued_descriptors < chain->max_descriptors))
+    {
+        const uint64_t block_offset = (uint64_t) (pipeline->next_transfer_index / 2) * pipeline->transfer_size_bytes;
+
+        if ((pipeline->next_transfer_index % 2) == 0)
+        {
+            queue_nvram_dma_transfer (chain, DMA_READ_FROM_HOST, block_offset,
+                    pipeline->h2c_data_iova + block_offset, pipeline->transfer_size_bytes);
+        }
+        else
+        {
+            queue_nvram_dma_transfer (chain, DMA_WRITE_TO_HOST, block_offset,
+                    pipeline->c2h_data_iova + block_offset, pipeline->transfer_size_bytes);
+        }
+        pipeline->next_transfer_index++;
+    }
+}
+
+
+/**
+ * @brief Perform one pass over the entire NVRAM using the pipelined chains of transfers
+ * @details Waits for each chain to complete, reaping the completions of each transfer as they occur.
+ *          When one chain completes the next chain, which has already been populated, is started immediately.
+ * @param[in] csr Mapped to the NVRAM CSR
+ * @param[in/out] pipeline The pipeline to perform the pass with.
+ * @return Returns true if the pass completed without the NVRAM DMA engine reporting any errors, or timing out waiting
+ *         for a transfer to complete.
+ */
+static bool perform_pipelined_pass (uint8_t *const csr, nvram_pipeline_t *const pipeline)
+{
+    uint32_t active_chain_index = 0;
+    bool success = true;
+
+    pipeline->next_transfer_index = 0;
+    for (uint32_t chain_index = 0; chain_index < NUM_PIPELINED_CHAINS; chain_index++)
+    {
+        populate_pipeline_chain (pipeline, &pipeline->chains[chain_index]);
+    }
+    pipeline->chain_start_times_ns[active_chain_index] = get_monotonic_time ();
+    start_nvram_dma_transfer (csr, &pipeline->chains[active_chain_index]);
+
+    while (success && (pipeline->chains[active_chain_index].num_queued_descriptors > 0))
+    {
+        nvram_transfer_context_t *const active_chain = &pipeline->chains[active_chain_index];
+        const uint32_t next_chain_index = (active_chain_index + 1) % NUM_PIPELINED_CHAINS;
+        nvram_transfer_context_t *const next_chain = &pipeline->chains[next_chain_index];
+
+        /* Reap the completions from the active chain as they occur, recording the latency of each transfer as the time
+         * from when the chain containing the transfer was started. Where multiple transfers are reaped by one poll, the
+         * completion times can't be resolved any finer than the poll. */
+        const int64_t chain_start_ns = pipeline->chain_start_times_ns[active_chain_index];
+        int64_t last_progress_ns = chain_start_ns;
+        while (success && (active_chain->num_completed_descriptors < active_chain->num_queued_descriptors))
+        {
+            const uint32_t first_reaped_index = active_chain->num_completed_descriptors;
+            const uint32_t num_reaped = reap_nvram_dma_completions (active_chain);
+            const int64_t now_ns = get_monotonic_time ();
+
+            for (uint32_t descriptor_index = first_reaped_index;
+                 descriptor_index < (first_reaped_index + num_reaped);
+                 descriptor_index++)
+            {
+                const int64_t latency_ns = now_ns - chain_start_ns;
+
+                if ((active_chain->descriptors[descriptor_index].control_bits & DMASCR_TRANSFER_READ) != 0)
+                {
+                    pipeline->h2c_latencies_ns[pipeline->num_h2c_latencies++] = latency_ns;
+                }
+                else
+                {
+                    pipeline->c2h_latencies_ns[pipeline->num_c2h_latencies++] = latency_ns;
+                }
+            }
+
+            if (num_reaped > 0)
+            {
+                last_progress_ns = now_ns;
+            }
+            else if ((now_ns - last_progress_ns) > PIPELINED_TRANSFER_TIMEOUT_NS)
+            {
+                printf ("Timeout waiting for NVRAM DMA transfer %" PRIu32 " of %" PRIu32 " in chain to complete\n",
+                        active_chain->num_completed_descriptors + 1, active_chain->num_queued_descriptors);
+                success = false;
+            }
+        }
+
+        if (success && (active_chain->error_sem_control_bits != 0))
+        {
+            printf ("NVRAM DMA error sem_control_bits=0x%" PRIx64 "\n", active_chain->error_sem_control_bits);
+            success = false;
+        }
+
+        /* Once the active chain has completed without error, immediately start the next chain to minimise the time the
+         * NVRAM DMA engine is idle. Then while the next chain is in progress, populate the completed chain with the
+         * subsequent transfers.
+         * On a timeout or error no further transfers are started, and the active chain isn't re-populated since on a
+         * timeout the NVRAM DMA engine may still own its descriptors. */
+        if (success)
+        {
+            if (next_chain->num_queued_descriptors > 0)
+            {
+                pipeline->chain_start_times_ns[next_chain_index] = get_monotonic_time ();
+                start_nvram_dma_transfer (csr, next_chain);
+            }
+
+            populate_pipeline_chain (pipeline, active_chain);
+            active_chain_index = next_chain_index;
+        }
+    }
+
+    return success;
+}
+
+
+/**
+ * @brief Test the NVRAM using pipelined DMA, for a range of transfer sizes
+ * @details For each transfer size performs passes over the entire NVRAM, where for each block of NVRAM a host-to-card
+ *          transfer writes a test pattern and then a card-to-host transfer reads back the test pattern.
+ *          As the NVRAM device has a single DMA engine, the host-to-card and card-to-host transfers are overlapped
+ *          by interleaving them in the chains of descriptors, rather than software having to start each transfer.
+ *
+ *          Reports the sustained throughput over each pass, and the distribution of the latency of individual transfers.
+ *          The error registers on the card are not checked.
+ * @param[in/out] vfio_device Used to obtain the mapped BARs for the NVRAM device
+ * @param[in/out] descriptors_mapping Used to allocate the chains of descriptors
+ * @param[in] h2c_data_mapping The buffer allocated on the host for host-to-card transfers
+ * @param[in] c2h_data_mapping The buffer allocated on the host for for card-to-host transfers
+ */
+static void test_nvram_via_pipelined_dma (vfio_device_t *const vfio_device,
+                                          vfio_dma_mapping_t *const descriptors_mapping,
+                                          const vfio_dma_mapping_t *const h2c_data_mapping,
+                                          const vfio_dma_mapping_t *const c2h_data_mapping)
+{
+    uint8_t *const csr = vfio_device->mapped_bars[NVRAM_CSR_BAR_INDEX];
+    const size_t nvram_size_bytes = get_nvram_size_bytes (csr);
+    const size_t nvram_size_words = nvram_size_bytes / sizeof (uint32_t);
+    uint32_t *host_words = h2c_data_mapping->buffer.vaddr;
+    uint32_t *card_words = c2h_data_mapping->buffer.vaddr;
+    uint32_t host_test_pattern = 0;
+    uint32_t card_test_pattern;
+    nvram_pipeline_t pipeline;
+    transfer_timing_t pass_timing;
+    char description[128];
+    bool success = true;
+
+    memset (&pipeline, 0, sizeof (pipeline));
+    pipeline.h2c_data_iova = h2c_data_mapping->iova;
+    pipeline.c2h_data_iova = c2h_data_mapping->iova;
+    for (uint32_t chain_index = 0; success && (chain_index < NUM_PIPELINED_CHAINS); chain_index++)
+    {
+        success = initialise_nvram_chained_transfer_context (&pipeline.chains[chain_index], descriptors_mapping,
+                arg_chain_length);
+    }
+
+    for (size_t transfer_size_bytes = MIN_PIPELINED_TRANSFER_SIZE_BYTES;
+         success && (transfer_size_bytes <= MAX_PIPELINED_TRANSFER_SIZE_BYTES) && (transfer_size_bytes <= nvram_size_bytes);
+         transfer_size_bytes <<= 1)
+    {
+        const size_t num_blocks = nvram_size_bytes / transfer_size_bytes;
+        const size_t max_latencies = num_blocks * NUM_PIPELINED_PASSES;
+
+        pipeline.transfer_size_bytes = (uint32_t) transfer_size_bytes;
+        pipeline.num_transfers_per_pass = (uint32_t) (num_blocks * 2);
+        pipeline.h2c_latencies_ns = calloc (max_latencies, sizeof (pipeline.h2c_latencies_ns[0]));
+        pipeline.c2h_latencies_ns = calloc (max_latencies, sizeof (pipeline.c2h_latencies_ns[0]));
+        pipeline.num_h2c_latencies = 0;
+        pipeline.num_c2h_latencies = 0;
+        if ((pipeline.h2c_latencies_ns == NULL) || (pipeline.c2h_latencies_ns == NULL))
+        {
+            printf ("Failed to allocate latency samples\n");
+            exit (EXIT_FAILURE);
+        }
+
+        /* The timing is for both directions in each pass over the NVRAM */
+        snprintf (description, sizeof (description), "%zu byte pipelined host-to-card+card-to-host DMA", transfer_size_bytes);
+        initialise_transfer_timing (&pass_timing, description, 2 * nvram_size_bytes);
+
+        for (uint32_t pass = 0; success && (pass < NUM_PIPELINED_PASSES); pass++)
+        {
+            /* Fill the host buffer with a test pattern to write to the NVRAM contents */
+            card_test_pattern = host_test_pattern;
+            for (size_t word_index = 0; word_index < nvram_size_words; word_index++)
+            {
+                host_words[word_index] = host_test_pattern;
+                linear_congruential_generator32 (&host_test_pattern);
+            }
+
+            transfer_time_start (&pass_timing);
+            success = perform_pipelined_pass (csr, &pipeline);
+            transfer_time_stop (&pass_timing);
+
+            /* Verify the test pattern read back */
+            for (size_t word_offset = 0; success && (word_offset < nvram_size_words); word_offset++)
+            {
+                if (card_words[word_offset] != card_test_pattern)
+                {
+                    printf ("NVRAM word[%zu] actual=0x%" PRIx32 " expected=0x%" PRIx32 "\n",
+                            word_offset, card_words[word_offset], card_test_pattern);
+                    success = false;
+                }
+                linear_congruential_generator32 (&card_test_pattern);
+            }
+        }
+
+        if (success)
+        {
+            display_transfer_timing_statistics (&pass_timing);
+            display_latency_distribution ("  host-to-card", pipeline.num_h2c_latencies, pipeline.h2c_latencies_ns);
+            display_latency_distribution ("  card-to-host", pipeline.num_c2h_latencies, pipeline.c2h_latencies_ns);
+        }
+
+        free (pipeline.h2c_latencies_ns);
+        free (pipeline.c2h_latencies_ns);
+    }
+
+    printf ("Pipelined DMA test %s\n", success ? "PASS" : "FAIL");
+}
+
+
 /**
  * @brief Test the NVRAM via the memory mapped window, using the CPU to access the NVRAM by advancing the window through
  *        the entire NVRAM space.
@@ -190,6 +513,7 @@ static void test_nvram_via_memory_window (vfio_device_t *const vfio_device,
 int main (int argc, char *argv[])
 {
     const size_t page_size = (size_t) getpagesize ();
+    size_t descriptors_mapping_size;
     vfio_devices_t vfio_devices;
     vfio_dma_mapping_t descriptors_mapping;
     vfio_dma_mapping_t h2c_data_mapping;
@@ -206,13 +530,24 @@ int main (int argc, char *argv[])
         .dma_capability = VFIO_DEVICE_DMA_CAPABILITY_A64
     };
 
+    parse_command_line_arguments (argc, argv);
+
+    /* Size the mapping for DMA descriptors, which for the pipelined DMA test may be more than a single page */
+    descriptors_mapping_size = page_size;
+    if (arg_pipelined_dma)
+    {
+        const size_t chain_size = vfio_align_cache_line_size (arg_chain_length * sizeof (struct mm_dma_desc));
+
+        descriptors_mapping_size = ((NUM_PIPELINED_CHAINS * chain_size) + page_size - 1) & ~(page_size - 1);
+    }
+
     /* Open the Micro Memory devices which have an IOMMU group assigned */
     open_vfio_devices_matching_filter (&vfio_devices, 1, &filter);
 
     /* Process any Micro Memory devices found */
     for (uint32_t device_index = 0; device_index < vfio_devices.num_devices; device_index++)
     {
-        vfio_device_t *const vfio_device = &vfio_devices.devices[device_index];
+        vfio_device_t *const vfio_device = vfio_devices.devices[device_index];
 
         map_vfio_device_bar_before_use (vfio_device, NVRAM_CSR_BAR_INDEX);
         map_vfio_device_bar_before_use (vfio_device, NVRAM_MEMORY_WINDOW_BAR_INDEX);
@@ -227,8 +562,8 @@ int main (int argc, char *argv[])
             {
                 initialise_nvram_device (csr);
 
-                /* Create read/write mapping of a single page for DMA descriptors */
-                allocate_vfio_dma_mapping (vfio_device, &descriptors_mapping, page_size,
+                /* Create read/write mapping for DMA descriptors */
+                allocate_vfio_dma_mapping (vfio_device, &descriptors_mapping, descriptors_mapping_size,
                         VFIO_DMA_MAP_FLAG_READ | VFIO_DMA_MAP_FLAG_WRITE, VFIO_BUFFER_ALLOCATION_HEAP);
 
                 /* Read mapping used by device to transfer a region of host memory to the entire NVRAM contents */
@@ -239,11 +574,20 @@ int main (int argc, char *argv[])
                 allocate_vfio_dma_mapping (vfio_device, &c2h_data_mapping, nvram_size_bytes,
                         VFIO_DMA_MAP_FLAG_WRITE, VFIO_BUFFER_ALLOCATION_HEAP);
 
-                if ((descriptors_mapping.buffer.vaddr != NULL) &&
-                    (h2c_data_mapping.buffer.vaddr    != NULL) &&
-                    (c2h_data_mapping.buffer.vaddr    != NULL) &&
-                    initialise_nvram_transfer_context (&h2c_context, &descriptors_mapping, &h2c_data_mapping, DMA_READ_FROM_HOST) &&
-                    initialise_nvram_transfer_context (&c2h_context, &descriptors_mapping, &c2h_data_mapping, DMA_WRITE_TO_HOST))
+                if (arg_pipelined_dma)
+                {
+                    if ((descriptors_mapping.buffer.vaddr != NULL) &&
+                        (h2c_data_mapping.buffer.vaddr    != NULL) &&
+                        (c2h_data_mapping.buffer.vaddr    != NULL))
+                    {
+                        test_nvram_via_pipelined_dma (vfio_device, &descriptors_mapping, &h2c_data_mapping, &c2h_data_mapping);
+                    }
+                }
+                else if ((descriptors_mapping.buffer.vaddr != NULL) &&
+                         (h2c_data_mapping.buffer.vaddr    != NULL) &&
+                         (c2h_data_mapping.buffer.vaddr    != NULL) &&
+                         initialise_nvram_transfer_context (&h2c_context, &descriptors_mapping, &h2c_data_mapping, DMA_READ_FROM_HOST) &&
+                         initialise_nvram_transfer_context (&c2h_context, &descriptors_mapping, &c2h_data_mapping, DMA_WRITE_TO_HOST))
                 {
                     test_nvram_via_dma (vfio_device, &h2c_data_mapping, &c2h_data_mapping, &h2c_context, &c2h_context);
 
@@ -355,8 +355,10 @@ const mrmac_statistics_counter_definition_t mrmac_statistics_counter_definitions
 };
 
 
-/* The monotonic time of the last sample tick for the statistics counters in each MRMAC port */
-static int64_t port_last_sample_tick_times_ns[MAX_VFIO_DEVICES][NUM_MRMAC_PORTS];
+/* The monotonic time of the last sample tick for the statistics counters in each MRMAC port.
+ * Indexed by the design index, and grown as statistics are sampled for designs. */
+static int64_t (*port_last_sample_tick_times_ns)[NUM_MRMAC_PORTS];
+static uint32_t port_last_sample_tick_times_allocated_length;
 
 
 /**
@@ -760,6 +762,9 @@ void mrmac_read_port_statistics (mrmac_port_statistics_t *const stats)
     }
 
     /* Record the duration between samples on the same port */
+    port_last_sample_tick_times_ns = vfio_grow_array (port_last_sample_tick_times_ns,
+            &port_last_sample_tick_times_allocated_length, stats->design->design_index + 1,
+            sizeof (port_last_sample_tick_times_ns[0]), "port_last_sample_tick_times_ns");
     if (port_last_sample_tick_times_ns[stats->design->design_index][stats->port_num] != 0)
     {
         stats->sample_duration_ns =
@@ -39,7 +39,13 @@ static void read_and_display_mrmac_statistics (fpga_designs_t *const designs, co
 {
     uint32_t design_index;
     uint32_t port_num;
-    mrmac_port_statistics_t stats[MAX_VFIO_DEVICES][NUM_MRMAC_PORTS];
+    mrmac_port_statistics_t (*const stats)[NUM_MRMAC_PORTS] = calloc (designs->num_identified_designs, sizeof (stats[0]));
+
+    if ((stats == NULL) && (designs->num_identified_designs > 0))
+    {
+        printf ("Failed to allocate memory for statistics\n");
+        exit (EXIT_FAILURE);
+    }
 
     /* Snapshot the counters for all MRMAC ports */
     for (design_index = 0; design_index < designs->num_identified_designs; design_index++)
@@ -79,6 +85,8 @@ static void read_and_display_mrmac_statistics (fpga_designs_t *const designs, co
             }
         }
     }
+
+    free (stats);
 }
 
 
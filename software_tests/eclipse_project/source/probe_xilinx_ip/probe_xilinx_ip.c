@@ -475,7 +475,7 @@ int main (int argc, char *argv[])
     /* Probe the VFIO devices */
     for (uint32_t device_index = 0; device_index < vfio_devices.num_devices; device_index++)
     {
-        probe_vfio_device_for_xilinx_ip (&vfio_devices.devices[device_index]);
+        probe_vfio_device_for_xilinx_ip (vfio_devices.devices[device_index]);
     }
 
     close_vfio_devices (&vfio_devices);
@@ -17,6 +17,7 @@
 #include "fpga_sio_pci_ids.h"
 #include "vfio_access.h"
 #include "xilinx_axi_iic_transfers.h"
+#include "transfer_timing.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -66,6 +67,19 @@ static const char *const qsfp_port_names[NUM_QSFP_PORTS] =
 };
 
 
+/* The SFF-8636 memory map of a QSFP module, which has a lower page and paged upper memory selected by the page select byte */
+#define SFF_8636_I2C_SLAVE_ADDRESS   0x50
+#define SFF_8636_PAGE_SIZE           128
+#define SFF_8636_UPPER_PAGE_START    128
+#define SFF_8636_STATUS_ADDRESS      2
+#define SFF_8636_STATUS_FLAT_MEM     0x04 /* Upper memory flat, i.e. only upper page 00h */
+#define SFF_8636_PAGE_SELECT_ADDRESS 127
+#define SFF_8636_OPTIONS_ADDRESS     195 /* In upper page 00h */
+#define SFF_8636_OPTIONS_PAGE_02     0x80
+#define SFF_8636_OPTIONS_PAGE_01     0x40
+#define SFF_8636_MAX_UPPER_PAGES     4 /* Pages 00h .. 03h */
+
+
 /* Contains the registers mapped for management of one QSFP port */
 typedef struct
 {
@@ -318,6 +332,150 @@ static void display_module_information (qsfp_management_port_registers_t *const
 }
 
 
+/**
+ * @brief Read one SFF-8636 page from a QSFP module using the Standard Mode transfers, as a benchmark reference
+ * @param[in,out] qsfp_port Which QSFP port to read from
+ * @param[in] select_page When true the page_number is written to the page select byte before the read
+ * @param[in] page_number The upper page number to select
+ * @param[in] data_address The start address to read from
+ * @param[out] data The page contents
+ * @return Returns IIC_TRANSFER_STATUS_SUCCESS if the read was successful
+ */
+static iic_transfer_status_t qsfp_standard_mode_page_read (qsfp_management_port_registers_t *const qsfp_port,
+                                                           const bool select_page, const uint8_t page_number,
+                                                           const uint8_t data_address, uint8_t data[const SFF_8636_PAGE_SIZE])
+{
+    iic_transfer_status_t status = IIC_TRANSFER_STATUS_SUCCESS;
+
+    if (select_page)
+    {
+        const uint8_t page_select[] = {SFF_8636_PAGE_SELECT_ADDRESS, page_number};
+
+        status = iic_write (&qsfp_port->iic_controller, SFF_8636_I2C_SLAVE_ADDRESS, sizeof (page_select), page_select,
+                IIC_TRANSFER_OPTION_STOP);
+    }
+
+    if (status == IIC_TRANSFER_STATUS_SUCCESS)
+    {
+        status = qsfp_i2c_single_read (qsfp_port, SFF_8636_I2C_SLAVE_ADDRESS, data_address, SFF_8636_PAGE_SIZE, data);
+    }
+
+    return status;
+}
+
+
+/**
+ * @brief Benchmark dumping all the pages of a QSFP module, comparing the Standard Mode and the chained Dynamic Mode transfers
+ * @details The pages dumped are the lower page and the upper pages advertised by the module. The page select is set back
+ *          to page 00h at the end.
+ * @param[in,out] qsfp_port Which QSFP port to dump
+ */
+static void benchmark_module_page_dump (qsfp_management_port_registers_t *const qsfp_port)
+{
+    uint8_t standard_data[1 + SFF_8636_MAX_UPPER_PAGES][SFF_8636_PAGE_SIZE];
+    uint8_t dynamic_data[1 + SFF_8636_MAX_UPPER_PAGES][SFF_8636_PAGE_SIZE];
+    iic_chained_read_t reads[1 + SFF_8636_MAX_UPPER_PAGES];
+    size_t num_reads = 0;
+    iic_transfer_status_t status;
+    int64_t start_time;
+    int64_t standard_duration;
+    int64_t dynamic_duration;
+    size_t read_index;
+
+    status = qsfp_module_access_setup (qsfp_port);
+    if (status != IIC_TRANSFER_STATUS_SUCCESS)
+    {
+        printf ("No module present\n");
+        return;
+    }
+
+    /* Read the lower page and upper page 00h to determine which other upper pages are present */
+    reads[num_reads++] = (iic_chained_read_t)
+    {
+        .i2c_slave_address = SFF_8636_I2C_SLAVE_ADDRESS, .select_page = false,
+        .start_address = 0, .num_bytes = SFF_8636_PAGE_SIZE, .data = dynamic_data[0]
+    };
+    reads[num_reads++] = (iic_chained_read_t)
+    {
+        .i2c_slave_address = SFF_8636_I2C_SLAVE_ADDRESS, .select_page = true, .page_number = 0,
+        .start_address = SFF_8636_UPPER_PAGE_START, .num_bytes = SFF_8636_PAGE_SIZE, .data = dynamic_data[1]
+    };
+    status = iic_chained_register_read (&qsfp_port->iic_controller, SFF_8636_PAGE_SELECT_ADDRESS, num_reads, reads);
+    if (status != IIC_TRANSFER_STATUS_SUCCESS)
+    {
+        printf ("Failed to read upper page 00h\n");
+        return;
+    }
+
+    if ((dynamic_data[0][SFF_8636_STATUS_ADDRESS] & SFF_8636_STATUS_FLAT_MEM) == 0)
+    {
+        const uint8_t options = dynamic_data[1][SFF_8636_OPTIONS_ADDRESS - SFF_8636_UPPER_PAGE_START];
+
+        for (uint8_t page_number = 1; page_number < SFF_8636_MAX_UPPER_PAGES; page_number++)
+        {
+            const bool page_present = (page_number == 3) ||
+                    ((page_number == 1) && ((options & SFF_8636_OPTIONS_PAGE_01) != 0)) ||
+                    ((page_number == 2) && ((options & SFF_8636_OPTIONS_PAGE_02) != 0));
+
+            if (page_present)
+            {
+                reads[num_reads] = (iic_chained_read_t)
+                {
+                    .i2c_slave_address = SFF_8636_I2C_SLAVE_ADDRESS, .select_page = true, .page_number = page_number,
+                    .start_address = SFF_8636_UPPER_PAGE_START, .num_bytes = SFF_8636_PAGE_SIZE, .data = dynamic_data[num_reads]
+                };
+                num_reads++;
+            }
+        }
+    }
+
+    /* Time the Standard Mode transfers, with one page select write per upper page */
+    start_time = get_monotonic_time ();
+    for (read_index = 0; (status == IIC_TRANSFER_STATUS_SUCCESS) && (read_index < num_reads); read_index++)
+    {
+        status = qsfp_standard_mode_page_read (qsfp_port, reads[read_index].select_page, reads[read_index].page_number,
+                reads[read_index].start_address, standard_data[read_index]);
+    }
+    standard_duration = get_monotonic_time () - start_time;
+    if (status != IIC_TRANSFER_STATUS_SUCCESS)
+    {
+        printf ("Standard Mode page dump failed\n");
+        return;
+    }
+
+    /* Time the chained Dynamic Mode transfers */
+    start_time = get_monotonic_time ();
+    status = iic_chained_register_read (&qsfp_port->iic_controller, SFF_8636_PAGE_SELECT_ADDRESS, num_reads, reads);
+    dynamic_duration = get_monotonic_time () - start_time;
+    if (status != IIC_TRANSFER_STATUS_SUCCESS)
+    {
+        printf ("Dynamic Mode page dump failed\n");
+        return;
+    }
+
+    /* Leave upper page 00h selected */
+    const uint8_t page_zero = 0;
+    (void) iic_register_write (&qsfp_port->iic_controller, SFF_8636_I2C_SLAVE_ADDRESS, SFF_8636_PAGE_SELECT_ADDRESS,
+            sizeof (page_zero), &page_zero);
+
+    /* Report the throughput, and compare the upper pages which are expected to be constant.
+     * The lower page isn't compared as it contains live monitor values. */
+    const size_t num_bytes = num_reads * SFF_8636_PAGE_SIZE;
+    printf ("Dumped %zu pages (lower + %zu upper) = %zu bytes\n", num_reads, num_reads - 1, num_bytes);
+    printf ("  Standard Mode        : %8.3f ms  %8.1f bytes/s\n",
+            (double) standard_duration / 1E6, (double) num_bytes / ((double) standard_duration / 1E9));
+    printf ("  Chained Dynamic Mode : %8.3f ms  %8.1f bytes/s\n",
+            (double) dynamic_duration / 1E6, (double) num_bytes / ((double) dynamic_duration / 1E9));
+    for (read_index = 1; read_index < num_reads; read_index++)
+    {
+        if (memcmp (standard_data[read_index], dynamic_data[read_index], SFF_8636_PAGE_SIZE) != 0)
+        {
+            printf ("  Upper page %02xh contents differ between the methods\n", reads[read_index].page_number);
+        }
+    }
+}
+
+
 /**
  * @brief Perform the top level menu for QSFP management
  * @param[in,out] vfio_device The device to perform QSFP management for
@@ -371,6 +529,7 @@ static void qsfp_management_menu (vfio_device_t *const vfio_device)
             printf ("1: Display GPIO signals\n");
             printf ("2: Toggle GPIO output\n");
             printf ("3: Display module information\n");
+            printf ("4: Benchmark module page dump\n");
             printf ("98: Display menu\n");
             printf ("99: Exit\n");
             display_menu = false;
@@ -415,6 +574,10 @@ static void qsfp_management_menu (vfio_device_t *const vfio_device)
                 display_module_information (&qsfp_ports[port_index]);
                 break;
 
+            case 4:
+                benchmark_module_page_dump (&qsfp_ports[port_index]);
+                break;
+
             case 98:
                 display_menu = true;
                 break;
@@ -463,7 +626,7 @@ int main (int argc, char *argv[])
         {
             printf ("%u devices found, only using the 1st one\n", vfio_devices.num_devices);
         }
-        qsfp_management_menu (&vfio_devices.devices[0]);
+        qsfp_management_menu (vfio_devices.devices[0]);
     }
     else
     {
@@ -64,6 +64,46 @@
 #define TEST_DMA_RING_SIZE (((2 + MAX_QUEUED_BLOCKS) * UART_BLOCK_SIZE_BYTES) + 1)
 
 
+/* The frequency of the oscillator for the 16C950 UARTs on the Sealevel COMM+2.LPCIe board (7205e) */
+#define UART_CLOCK_FREQUENCY_HZ 14745600
+
+
+/* Defines one baud rate setting for a 16C950 UART.
+ * The Clock Prescaler Register isn't used, since it requires MCR[7] to be set which the loopback selection overwrites.
+ * The high rate modes are obtained by setting the Times Clock Register to less than the standard 16 samples per bit. */
+typedef struct
+{
+    /* The resulting baud rate, which is UART_CLOCK_FREQUENCY_HZ / (samples_per_bit * divisor) */
+    uint32_t baud_rate;
+    /* The number of samples per bit, in the range 4 to 16 */
+    uint8_t samples_per_bit;
+    /* The divisor latch value */
+    uint16_t divisor;
+} uart_baud_rate_t;
+
+static const uart_baud_rate_t uart_baud_rates[] =
+{
+    {.baud_rate =  115200, .samples_per_bit = 16, .divisor = 8},
+    {.baud_rate =  230400, .samples_per_bit = 16, .divisor = 4},
+    {.baud_rate =  460800, .samples_per_bit = 16, .divisor = 2},
+    {.baud_rate =  921600, .samples_per_bit = 16, .divisor = 1},
+    {.baud_rate = 1228800, .samples_per_bit = 12, .divisor = 1},
+    {.baud_rate = 1843200, .samples_per_bit =  8, .divisor = 1},
+    {.baud_rate = 2457600, .samples_per_bit =  6, .divisor = 1},
+    {.baud_rate = 2949120, .samples_per_bit =  5, .divisor = 1},
+    {.baud_rate = 3686400, .samples_per_bit =  4, .divisor = 1}
+};
+#define UART_NUM_BAUD_RATES (sizeof (uart_baud_rates) / sizeof (uart_baud_rates[0]))
+
+/* The index into uart_baud_rates[] used for the non-soak tests */
+#define UART_DEFAULT_BAUD_RATE_INDEX 6
+
+
+/* The block sizes randomly selected for transmission during a soak test, to exercise different FIFO levels */
+static const uint32_t uart_soak_block_sizes[] = {1, 3, 16, 31, 64, 100, UART_FIFO_DEPTH};
+#define UART_SOAK_NUM_BLOCK_SIZES (sizeof (uart_soak_block_sizes) / sizeof (uart_soak_block_sizes[0]))
+
+
 /* Structure to access one 16C950 UART, as a 8-bit wide device on the local bus of a PEX8311.
  * Each UART is mapped as one bar in memory space. */
 typedef struct
@@ -197,6 +237,54 @@ static const char *const uart_test_mode_descriptions[UART_TEST_MODE_ARRAY_SIZE]
 };
 
 
+/* The statistics accumulated for one UART port at one baud rate during a soak test */
+typedef struct
+{
+    /* The number of bytes received */
+    uint64_t num_rx_bytes;
+    /* Counts of the receive errors reported by the Line Status Register */
+    uint64_t num_overrun_errors;
+    uint64_t num_parity_errors;
+    uint64_t num_framing_errors;
+    /* The number of received bytes which didn't match the transmitted test pattern */
+    uint64_t num_data_mismatches;
+    /* The number of times the expected receive bytes didn't arrive, which causes the port to be re-synchronised */
+    uint64_t num_timeouts;
+    /* The total time spent testing at the baud rate */
+    int64_t duration_ns;
+} uart_soak_statistics_t;
+
+
+/* Structure which contains the context used for one UART during a soak test.
+ * Unlike uart_test_context_t errors are counted rather than stopping the test, and no DMA buffers are used since the
+ * soak test uses PIO for all UARTs from a single poll loop. */
+typedef struct
+{
+    /* The VFIO device containing the UART */
+    vfio_device_t *vfio_device;
+    /* The UART ports used for the test */
+    uart_port_t *tx_port;
+    uart_port_t *rx_port;
+    /* Used to generate the transmit test pattern, and the expected receive test pattern */
+    uint32_t tx_test_pattern;
+    uint32_t rx_test_pattern;
+    /* Used to randomly select the size of each transmitted block */
+    uint32_t block_size_seed;
+    /* The size of the next block to be transmitted */
+    uint32_t next_tx_block_size;
+    /* The number of bytes transmitted which have yet to be received */
+    uint32_t num_bytes_in_flight;
+    /* The last time at which bytes were received, used to detect a timeout */
+    int64_t last_rx_time_ns;
+    /* When true the context is being re-synchronised, and the receive FIFO is cleared once resync_deadline_ns is
+     * reached. Transmission is suspended while re-synchronising. */
+    bool resynchronising;
+    int64_t resync_deadline_ns;
+    /* The statistics for each baud rate */
+    uart_soak_statistics_t statistics[UART_NUM_BAUD_RATES];
+} uart_soak_context_t;
+
+
 /* The timeout used for the test. Made a global so may be changed if single stepping in the debugger */
 static int test_timeout_secs = 1;
 
@@ -232,13 +320,21 @@ static uint32_t arg_dma_transfer_max_size = UART_FIFO_DEPTH;
 static bool arg_no_dma_channel_overlap;
 
 
+/* Command line argument which when non-zero selects a soak test, and sets the number of seconds spent at each baud rate */
+static uint32_t arg_soak_secs_per_baud_rate;
+
+
+/* Command line argument which sets the number of times the soak test sweeps over all baud rates */
+static uint32_t arg_num_soak_sweeps = 1;
+
+
 /**
  * @brief Parse the command line arguments, storing the results in global variables
  * @param[in] argc, argv Arguments passed to main
  */
 static void parse_command_line_arguments (int argc, char *argv[])
 {
-    const char *const optstring = "edu:m:6t:o?";
+    const char *const optstring = "edu:m:6t:os:n:?";
     int option;
     char junk;
     uart_test_mode_t test_mode;
@@ -302,15 +398,35 @@ static void parse_command_line_arguments (int argc, char *argv[])
             arg_no_dma_channel_overlap = true;
             break;
 
+        case 's':
+            if ((sscanf (optarg, "%" SCNu32 "%c", &arg_soak_secs_per_baud_rate, &junk) != 1)
+                    || (arg_soak_secs_per_baud_rate < 1))
+            {
+                printf ("ERROR: Invalid soak seconds per baud rate \"%s\"\n", optarg);
+                exit (EXIT_FAILURE);
+            }
+            break;
+
+        case 'n':
+            if ((sscanf (optarg, "%" SCNu32 "%c", &arg_num_soak_sweeps, &junk) != 1)
+                    || (arg_num_soak_sweeps < 1))
+            {
+                printf ("ERROR: Invalid number of soak sweeps \"%s\"\n", optarg);
+                exit (EXIT_FAILURE);
+            }
+            break;
+
         case '?':
         default:
-            printf ("Usage %s [-e] [-d] [-o] [-u <num_uarts_tested>] [-m PIO|DMA_BLOCK|DMA_RING] [-6] [-t <MAX_DMA_transfer_size_bytes>]\n", argv[0]);
+            printf ("Usage %s [-e] [-d] [-o] [-u <num_uarts_tested>] [-m PIO|DMA_BLOCK|DMA_RING] [-6] [-t <MAX_DMA_transfer_size_bytes>] [-s <soak_secs_per_baud_rate>] [-n <num_soak_sweeps>]\n", argv[0]);
             printf ("  -e performs test using external loopback, in addition to internal loopback\n");
             printf ("  -d dumps the PEX8311 Local Configuration Space registers for debugging\n");
             printf ("  -o disables overlapping DMA between different channels\n");
             printf ("  -m may be specified more than once to specify multiple test modes\n");
             printf ("     Defaults to all test modes if not specified\n");
             printf ("  -6 specifies 64-bit DMA addressing capability\n");
+            printf ("  -s selects a soak test using PIO on all UARTs on all devices, sweeping the baud rates\n");
+            printf ("  -n sets the number of times the soak test sweeps the baud rates\n");
             exit (EXIT_FAILURE);
             break;
         }
@@ -583,6 +699,24 @@ static void autoconfig (uart_port_t *const port)
 }
 
 
+/**
+ * @brief Set the baud rate for a UART
+ * @details The LCR is restored from the value tracked in port, since may not be readable when ASR is enabled.
+ * @param[in/out] port Which port to set the baud rate for
+ * @param[in] baud_rate The baud rate settings to apply
+ */
+static void set_uart_baud_rate (uart_port_t *const port, const uart_baud_rate_t *const baud_rate)
+{
+    serial_out (port, UART_LCR, port->lcr | UART_LCR_DLAB);
+    serial_out (port, UART_DLL, (uint8_t) (baud_rate->divisor & 0xff));
+    serial_out (port, UART_DLM, (uint8_t) (baud_rate->divisor >> 8));
+    serial_out (port, UART_LCR, port->lcr);
+
+    /* A Times Clock Register value of zero selects the standard 16 samples per bit */
+    serial_icr_write (port, UART_TCR, (baud_rate->samples_per_bit == 16) ? 0 : baud_rate->samples_per_bit);
+}
+
+
 /**
  * @brief Set a UART to operational mode for transmitting data.
  * @param[in] port Which port to initialise
@@ -598,15 +732,9 @@ static void set_uart_operational_mode (uart_port_t *const port)
     /* Set 8 data bits, 1 stop bit, no parity */
     port->lcr = UART_LCR_WLEN8;
 
-    /* Set a divisor of one */
-    serial_out (port, UART_LCR, port->lcr | UART_LCR_DLAB);
-    serial_out (port, UART_DLL, 1);
-    serial_out (port, UART_DLM, 0);
-    serial_out (port, UART_LCR, port->lcr);
-
-    /* Set the clock pre-scaler to 6.
+    /* Set a divisor of one and 6 samples per bit.
      * With the 14.7456MHz oscillator, this results in a baud rate of 2.4576 Mbaud. */
-    serial_icr_write (port, UART_TCR, 6);
+    set_uart_baud_rate (port, &uart_baud_rates[UART_DEFAULT_BAUD_RATE_INDEX]);
 
     /* For the tests enable the Additional Status Read, to allow reading of the Rx FIFO level with a single register read */
     const bool enable_asr = true;
@@ -1271,6 +1399,33 @@ static void perform_uart_loopback_test (uart_test_context_t contexts[const NUM_U
 }
 
 
+/**
+ * @brief Initialise ports to access both UARTS on the board, mapping the BARs of the ports into the address space
+ * @param[in/out] vfio_device The VFIO device containing the UARTs
+ * @param[out] ports The initialised ports
+ */
+static void map_uart_ports (vfio_device_t *const vfio_device, uart_port_t ports[const NUM_UARTS])
+{
+    memset (ports, 0, NUM_UARTS * sizeof (ports[0]));
+    ports[0].bar_index = PEX_LOCAL_SPACE0_BAR_INDEX;
+    map_vfio_device_bar_before_use (vfio_device, ports[0].bar_index);
+    ports[0].bar_mapping = vfio_device->mapped_bars[ports[0].bar_index];
+    ports[1].bar_index = PEX_LOCAL_SPACE1_BAR_INDEX;
+    map_vfio_device_bar_before_use (vfio_device, ports[1].bar_index);
+    ports[1].bar_mapping = vfio_device->mapped_bars[ports[1].bar_index];
+    if (ports[0].bar_mapping == NULL)
+    {
+        printf ("BAR %d not mapped\n", ports[0].bar_index);
+        exit (EXIT_FAILURE);
+    }
+    if (ports[1].bar_mapping == NULL)
+    {
+        printf ("BAR %d not mapped\n", ports[1].bar_index);
+        exit (EXIT_FAILURE);
+    }
+}
+
+
 /**
  * @brief Sequence the UART tests, using VFIO
  * @param[in/out] vfio_devices The opened VFIO devices
@@ -1278,7 +1433,7 @@ static void perform_uart_loopback_test (uart_test_context_t contexts[const NUM_U
  */
 static void perform_uart_tests (vfio_devices_t *const vfio_devices, const uint32_t device_index)
 {
-    vfio_device_t *const vfio_device = &vfio_devices->devices[device_index];
+    vfio_device_t *const vfio_device = vfio_devices->devices[device_index];
     vfio_dma_mapping_t vfio_mapping;
     uart_port_t ports[NUM_UARTS];
     uart_test_context_t contexts[NUM_UARTS];
@@ -1302,24 +1457,7 @@ static void perform_uart_tests (vfio_devices_t *const vfio_devices, const uint32
         pex_dump_lcs_registers (lcs, "initial");
     }
 
-    /* Initialise ports to access both UARTS on the board, mapping the BARs of the ports into the address space */
-    memset (ports, 0, sizeof (ports));
-    ports[0].bar_index = PEX_LOCAL_SPACE0_BAR_INDEX;
-    map_vfio_device_bar_before_use (vfio_device, ports[0].bar_index);
-    ports[0].bar_mapping = vfio_device->mapped_bars[ports[0].bar_index];
-    ports[1].bar_index = PEX_LOCAL_SPACE1_BAR_INDEX;
-    map_vfio_device_bar_before_use (vfio_device, ports[1].bar_index);
-    ports[1].bar_mapping = vfio_device->mapped_bars[ports[1].bar_index];
-    if (ports[0].bar_mapping == NULL)
-    {
-        printf ("BAR %d not mapped\n", ports[0].bar_index);
-        exit (EXIT_FAILURE);
-    }
-    if (ports[1].bar_mapping == NULL)
-    {
-        printf ("BAR %d not mapped\n", ports[1].bar_index);
-        exit (EXIT_FAILURE);
-    }
+    map_uart_ports (vfio_device, ports);
 
     /* Obtain the local bus base addresses for the UARTs */
     ports[0].local_bus_base_address = read_reg32 (lcs, PEX_LCS_LAS0BA) & PEX_LCS_LASxBA_ADDR_MASK;
@@ -1508,6 +1646,355 @@ static void perform_uart_tests (vfio_devices_t *const vfio_devices, const uint32
 }
 
 
+/**
+ * @brief Get the next byte of a soak test pattern
+ * @details Uses the most significant byte of the linear congruential generator, since the least significant bits
+ *          have a short period.
+ * @param[in/out] test_pattern The test pattern to advance
+ * @return The next byte of the test pattern
+ */
+static uint8_t get_soak_test_pattern_byte (uint32_t *const test_pattern)
+{
+    const uint8_t pattern_byte = (uint8_t) (*test_pattern >> 24);
+
+    linear_congruential_generator32 (test_pattern);
+
+    return pattern_byte;
+}
+
+
+/**
+ * @brief Randomly select the size of the next block to be transmitted during a soak test
+ * @param[in/out] context The soak test context to select the block size for
+ */
+static void select_next_soak_tx_block_size (uart_soak_context_t *const context)
+{
+    linear_congruential_generator32 (&context->block_size_seed);
+    context->next_tx_block_size = uart_soak_block_sizes[(context->block_size_seed >> 16) % UART_SOAK_NUM_BLOCK_SIZES];
+}
+
+
+/**
+ * @brief Accumulate the per-byte receive errors reported by one read of the Line Status Register during a soak test
+ * @details Overrun isn't counted, since it isn't associated with a byte in the receive FIFO. The caller counts
+ *          overrun once for each batch of received bytes.
+ * @param[in/out] statistics The statistics to update
+ * @param[in] lsr The Line Status Register value
+ */
+static void count_soak_lsr_errors (uart_soak_statistics_t *const statistics, const uint8_t lsr)
+{
+    if ((lsr & UART_LSR_PE) != 0)
+    {
+        statistics->num_parity_errors++;
+    }
+    if ((lsr & (UART_LSR_FE | UART_LSR_BI)) != 0)
+    {
+        statistics->num_framing_errors++;
+    }
+}
+
+
+/**
+ * @brief Start re-synchronising a soak test context, e.g. after the expected receive bytes haven't arrived
+ * @details Only the transmit FIFO of the transmit port and the receive FIFO of the receive port are cleared, since with
+ *          external loopback the other FIFOs in the ports are in use by a different context.
+ *          The receive FIFO is cleared by complete_soak_context_resynchronisation() after a delay to allow for any
+ *          character being shifted at the slowest baud rate. The delay doesn't block, so that the other contexts
+ *          continue to be polled while this context is re-synchronised.
+ * @param[in/out] context The soak test context to re-synchronise
+ */
+static void resynchronise_soak_context (uart_soak_context_t *const context)
+{
+    serial_out (context->tx_port, UART_FCR, UART_FCR_ENABLE_FIFO | UART_FCR_CLEAR_XMIT);
+    context->resynchronising = true;
+    context->resync_deadline_ns = get_monotonic_time () + 1000000;
+}
+
+
+/**
+ * @brief Complete re-synchronising a soak test context, once the delay after clearing the transmit FIFO has expired
+ * @param[in/out] context The soak test context being re-synchronised
+ * @param[in] now_ns The current monotonic time
+ */
+static void complete_soak_context_resynchronisation (uart_soak_context_t *const context, const int64_t now_ns)
+{
+    if (now_ns >= context->resync_deadline_ns)
+    {
+        serial_out (context->rx_port, UART_FCR, UART_FCR_ENABLE_FIFO | UART_FCR_CLEAR_RCVR);
+        context->rx_port->previous_rx_fifo_level = 0;
+
+        context->rx_test_pattern = context->tx_test_pattern;
+        context->num_bytes_in_flight = 0;
+        context->last_rx_time_ns = now_ns;
+        context->resynchronising = false;
+    }
+}
+
+
+/**
+ * @brief Sequence the soak test for one context, using PIO to transmit/receive
+ * @details Blocks of random sizes are transmitted while the total number of bytes in flight fits in the receive FIFO.
+ *          The Line Status Register is read once for each batch of received bytes, and only read for each byte when
+ *          the FIFO error flag indicates at least one byte in the receive FIFO has an error.
+ *          While the context is being re-synchronised only checks if the re-synchronisation can be completed.
+ * @param[in/out] context The soak test context
+ * @param[in/out] statistics The statistics to update for the current baud rate
+ * @param[in] transmit_enabled When false no further bytes are transmitted, to allow the bytes in flight to be drained
+ */
+static void sequence_uart_soak_pio (uart_soak_context_t *const context, uart_soak_statistics_t *const statistics,
+                                    const bool transmit_enabled)
+{
+    if (context->resynchronising)
+    {
+        complete_soak_context_resynchronisation (context, get_monotonic_time ());
+        return;
+    }
+
+    while (transmit_enabled && ((context->num_bytes_in_flight + context->next_tx_block_size) <= UART_FIFO_DEPTH))
+    {
+        for (uint32_t block_index = 0; block_index < context->next_tx_block_size; block_index++)
+        {
+            serial_out (context->tx_port, UART_TX, get_soak_test_pattern_byte (&context->tx_test_pattern));
+        }
+        context->num_bytes_in_flight += context->next_tx_block_size;
+        select_next_soak_tx_block_size (context);
+    }
+
+    if (context->num_bytes_in_flight > 0)
+    {
+        const uint8_t rx_fifo_level = serial_read_rx_fifo_level (context->rx_port, 0);
+        const int64_t now_ns = get_monotonic_time ();
+
+        if (rx_fifo_level == 255)
+        {
+            printf ("PEX8311 on %s appears to have failed, as register read of receive FIFO level returns all-ones\n",
+                    context->vfio_device->device_name);
+            printf ("Exiting in case further device accesses cause the PC to hang\n");
+            exit (EXIT_FAILURE);
+        }
+
+        if (rx_fifo_level > 0)
+        {
+            const uint32_t num_rx_bytes =
+                    (rx_fifo_level < context->num_bytes_in_flight) ? rx_fifo_level : context->num_bytes_in_flight;
+            const uint8_t batch_lsr = serial_in (context->rx_port, UART_LSR);
+            const bool read_lsr_per_byte = (batch_lsr & UART_LSR_FIFOE) != 0;
+            bool overrun = (batch_lsr & UART_LSR_OE) != 0;
+
+            for (uint32_t byte_index = 0; byte_index < num_rx_bytes; byte_index++)
+            {
+                if (read_lsr_per_byte)
+                {
+                    const uint8_t lsr = serial_in (context->rx_port, UART_LSR);
+
+                    count_soak_lsr_errors (statistics, lsr);
+                    overrun = overrun || ((lsr & UART_LSR_OE) != 0);
+                }
+
+                const uint8_t rx_byte = serial_in (context->rx_port, UART_RX);
+                if (rx_byte != get_soak_test_pattern_byte (&context->rx_test_pattern))
+                {
+                    statistics->num_data_mismatches++;
+                }
+            }
+            if (overrun)
+            {
+                statistics->num_overrun_errors++;
+            }
+            context->rx_port->previous_rx_fifo_level = (uint8_t) (rx_fifo_level - num_rx_bytes);
+            context->num_bytes_in_flight -= num_rx_bytes;
+            statistics->num_rx_bytes += num_rx_bytes;
+            context->last_rx_time_ns = now_ns;
+        }
+        else if ((now_ns - context->last_rx_time_ns) > (test_timeout_secs * 1000000000LL))
+        {
+            statistics->num_timeouts++;
+            resynchronise_soak_context (context);
+        }
+    }
+}
+
+
+/**
+ * @brief Determine if one port passed the soak test at one baud rate
+ * @param[in] statistics The accumulated statistics for the port and baud rate
+ * @return Returns true if data was received without any errors
+ */
+static bool uart_soak_statistics_passed (const uart_soak_statistics_t *const statistics)
+{
+    return (statistics->num_rx_bytes > 0) &&
+            (statistics->num_overrun_errors == 0) && (statistics->num_parity_errors == 0) &&
+            (statistics->num_framing_errors == 0) && (statistics->num_data_mismatches == 0) &&
+            (statistics->num_timeouts == 0);
+}
+
+
+/**
+ * @brief Perform a long-running soak test on all UARTs on all devices, using PIO from a single poll loop
+ * @details Sweeps over all the baud rates, spending arg_soak_secs_per_baud_rate at each baud rate.
+ *          Errors are counted rather than stopping the test, and at the end a pass/fail matrix is reported
+ *          for each port and baud rate.
+ * @param[in/out] vfio_devices The opened VFIO devices containing the UARTs
+ */
+static void perform_uart_soak_test (vfio_devices_t *const vfio_devices)
+{
+    uart_port_t (*const ports)[NUM_UARTS] = calloc (vfio_devices->num_devices, sizeof (ports[0]));
+    uart_soak_context_t *const contexts = calloc (vfio_devices->num_devices * NUM_UARTS, sizeof (contexts[0]));
+    uint32_t num_contexts = 0;
+    uint32_t device_index;
+    uint32_t port_index;
+    uint32_t context_index;
+    uint32_t baud_rate_index;
+    uint32_t seed = 1;
+    bool test_running;
+
+    /* Initialise all UARTs on all devices */
+    if ((ports == NULL) || (contexts == NULL))
+    {
+        printf ("Failed to allocate memory for soak test\n");
+        exit (EXIT_FAILURE);
+    }
+    for (device_index = 0; device_index < vfio_devices->num_devices; device_index++)
+    {
+        vfio_device_t *const vfio_device = vfio_devices->devices[device_index];
+
+        map_uart_ports (vfio_device, ports[device_index]);
+        for (port_index = 0; port_index < arg_num_uarts_tested; port_index++)
+        {
+            uart_port_t *const port = &ports[device_index][port_index];
+            uart_soak_context_t *const context = &contexts[num_contexts];
+
+            autoconfig (port);
+            set_uart_operational_mode (port);
+            serial_set_internal_loopback (port, !arg_test_external_loopback);
+
+            context->vfio_device = vfio_device;
+            context->tx_port = port;
+            context->rx_port = arg_test_external_loopback ? &ports[device_index][(port_index + 1) % arg_num_uarts_tested] : port;
+            context->block_size_seed = seed;
+            linear_congruential_generator32 (&seed);
+            num_contexts++;
+        }
+    }
+
+    printf ("\nSoak testing %u UARTs on %u devices using %s loopback, %u secs per baud rate, %u sweeps\n",
+            num_contexts, vfio_devices->num_devices, arg_test_external_loopback ? "external" : "internal",
+            arg_soak_secs_per_baud_rate, arg_num_soak_sweeps);
+
+    for (uint32_t sweep_index = 0; sweep_index < arg_num_soak_sweeps; sweep_index++)
+    {
+        for (baud_rate_index = 0; baud_rate_index < UART_NUM_BAUD_RATES; baud_rate_index++)
+        {
+            const uart_baud_rate_t *const baud_rate = &uart_baud_rates[baud_rate_index];
+
+            /* Change the baud rate when no bytes are in flight, and restart the test patterns */
+            for (context_index = 0; context_index < num_contexts; context_index++)
+            {
+                uart_soak_context_t *const context = &contexts[context_index];
+
+                set_uart_baud_rate (context->tx_port, baud_rate);
+                context->tx_test_pattern = seed;
+                linear_congruential_generator32 (&seed);
+                select_next_soak_tx_block_size (context);
+                resynchronise_soak_context (context);
+            }
+
+            /* Run the test for the required duration, and then drain the bytes in flight */
+            const int64_t start_time_ns = get_monotonic_time ();
+            const int64_t transmit_end_time_ns = start_time_ns + (arg_soak_secs_per_baud_rate * 1000000000LL);
+            bool transmit_enabled;
+            do
+            {
+                transmit_enabled = get_monotonic_time () < transmit_end_time_ns;
+                test_running = transmit_enabled;
+                for (context_index = 0; context_index < num_contexts; context_index++)
+                {
+                    uart_soak_context_t *const context = &contexts[context_index];
+
+                    sequence_uart_soak_pio (context, &context->statistics[baud_rate_index], transmit_enabled);
+                    if (context->resynchronising || (context->num_bytes_in_flight > 0))
+                    {
+                        test_running = true;
+                    }
+                }
+            } while (test_running);
+            const int64_t duration_ns = get_monotonic_time () - start_time_ns;
+
+            /* Report the accumulated statistics for the baud rate */
+            printf ("\nSweep %u baud rate %u (%u samples per bit, divisor %u):\n",
+                    sweep_index + 1, baud_rate->baud_rate, baud_rate->samples_per_bit, baud_rate->divisor);
+            for (context_index = 0; context_index < num_contexts; context_index++)
+            {
+                uart_soak_context_t *const context = &contexts[context_index];
+                uart_soak_statistics_t *const statistics = &context->statistics[baud_rate_index];
+
+                statistics->duration_ns += duration_ns;
+
+                /* Each character on the line is a start bit, 8 data bits and one stop bit */
+                const double achieved_bytes_per_sec = (double) statistics->num_rx_bytes / ((double) statistics->duration_ns / 1E9);
+                const double line_bytes_per_sec = (double) baud_rate->baud_rate / 10.0;
+                printf ("  %s BAR %u->%u rx_bytes=%" PRIu64 " %.0f bytes/sec (%.1f%% of line rate) overrun=%" PRIu64 " parity=%" PRIu64 " framing=%" PRIu64 " mismatch=%" PRIu64 " timeouts=%" PRIu64 " %s\n",
+                        context->vfio_device->device_name, context->tx_port->bar_index, context->rx_port->bar_index,
+                        statistics->num_rx_bytes, achieved_bytes_per_sec, (achieved_bytes_per_sec * 100.0) / line_bytes_per_sec,
+                        statistics->num_overrun_errors, statistics->num_parity_errors, statistics->num_framing_errors,
+                        statistics->num_data_mismatches, statistics->num_timeouts,
+                        uart_soak_statistics_passed (statistics) ? "PASS" : "FAIL");
+            }
+        }
+    }
+
+    /* Report the pass/fail matrix for each port and baud rate */
+    uint32_t total_tests = 0;
+    uint32_t total_test_failures = 0;
+    printf ("\nSoak test pass/fail matrix:\n");
+    printf ("%-12s %-7s", "Device", "BARs");
+    for (baud_rate_index = 0; baud_rate_index < UART_NUM_BAUD_RATES; baud_rate_index++)
+    {
+        printf (" %8u", uart_baud_rates[baud_rate_index].baud_rate);
+    }
+    printf ("\n");
+    for (context_index = 0; context_index < num_contexts; context_index++)
+    {
+        const uart_soak_context_t *const context = &contexts[context_index];
+
+        printf ("%-12s %u->%-4u", context->vfio_device->device_name, context->tx_port->bar_index, context->rx_port->bar_index);
+        for (baud_rate_index = 0; baud_rate_index < UART_NUM_BAUD_RATES; baud_rate_index++)
+        {
+            const bool passed = uart_soak_statistics_passed (&context->statistics[baud_rate_index]);
+
+            printf (" %8s", passed ? "PASS" : "FAIL");
+            if (!passed)
+            {
+                total_test_failures++;
+            }
+            total_tests++;
+        }
+        printf ("\n");
+    }
+
+    /* Disable ASR upon end of tests */
+    const bool enable_asr = false;
+    for (context_index = 0; context_index < num_contexts; context_index++)
+    {
+        serial_set_additional_status_read (contexts[context_index].tx_port, enable_asr);
+    }
+    free (contexts);
+    free (ports);
+
+    if (total_tests > 0)
+    {
+        if (total_test_failures > 0)
+        {
+            printf ("\n%u out of %u tests FAILED\n", total_test_failures, total_tests);
+        }
+        else
+        {
+            printf ("\nAll %u tests PASSED\n", total_tests);
+        }
+    }
+}
+
+
 int main (int argc, char *argv[])
 {
     vfio_devices_t vfio_devices;
@@ -1530,9 +2017,16 @@ int main (int argc, char *argv[])
     open_vfio_devices_matching_filter (&vfio_devices, 1, &filter);
 
     /* Process any Sealevel devices found */
-    for (uint32_t device_index = 0; device_index < vfio_devices.num_devices; device_index++)
+    if (arg_soak_secs_per_baud_rate > 0)
     {
-        perform_uart_tests (&vfio_devices, device_index);
+        perform_uart_soak_test (&vfio_devices);
+    }
+    else
+    {
+        for (uint32_t device_index = 0; device_index < vfio_devices.num_devices; device_index++)
+        {
+            perform_uart_tests (&vfio_devices, device_index);
+        }
     }
 
     close_vfio_devices (&vfio_devices);
@@ -0,0 +1,655 @@
+/*
+ * @file time_pex8311_dma.c
+ * @date 18 Oct 2026
+ * @author Chester Gillon
+ * @brief Program to time DMA throughput of a PEX8311, using both DMA channels concurrently
+ * @details The intention is to find the practical DMA throughput limit of the PEX8311 on a
+ *          Sealevel COMM+2.LPCIe board (7205e), rather than the UART throughput measured by sealevel_serial_7205e_uart_tests.c
+ *
+ *          The DMA channels can only transfer between the PCI Express address space and the PEX8311 local bus.
+ *          The internal shared memory is in the "PEX 8111 PCI Express-to-PCI Bridge" part of the PEX8311, which isn't on the
+ *          local bus and vfio-pci can't be bound to the bridge. Therefore, the only local bus targets are the 16C950 UARTs and
+ *          the DMA transfers use the UART Scratch Pad Register with constant local addressing, which has no side effects
+ *          on the UART operation:
+ *          - DMA channel 0 transfers to/from the UART on local address space 0
+ *          - DMA channel 1 transfers to/from the UART on local address space 1
+ *
+ *          The test modes are:
+ *          - DMA_RING which has multiple descriptors in flight in host memory, but is constrained to an IOVA below 4GB.
+ *          - DMA_BLOCK which only has one transfer in flight, but can use an IOVA above 4GB via the DMADAC registers.
+ *            When run with the -6 option the IOVA is allocated above 4GB, if pex8311_enable_above_4GB_dma has been used
+ *            to enable the 64-bit capability.
+ *
+ *          Data checking is limited to what is possible with a single register as the local target:
+ *          - Host-to-card checks the Scratch Pad Register contains the last byte transferred.
+ *          - Card-to-host checks all bytes transferred are the value written to the Scratch Pad Register by the CPU.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#include <time.h>
+#include <unistd.h>
+#include <linux/serial_reg.h>
+
+#include "vfio_access.h"
+#include "transfer_timing.h"
+#include "pex8311.h"
+
+
+/* The number of DMA channels in the PEX8311, which are run concurrently */
+#define PEX_NUM_DMA_CHANNELS 2
+
+
+/* Define the mode of a DMA test, in terms of how the DMA is controlled */
+typedef enum
+{
+    /* Ring based DMA, using scatter-gather descriptors stored in host memory */
+    DMA_TEST_MODE_RING,
+    /* DMA block mode, which doesn't use descriptors stored in host memory */
+    DMA_TEST_MODE_BLOCK,
+
+    DMA_TEST_MODE_ARRAY_SIZE
+} dma_test_mode_t;
+
+static const char *const dma_test_mode_descriptions[DMA_TEST_MODE_ARRAY_SIZE] =
+{
+    [DMA_TEST_MODE_RING] = "DMA_RING",
+    [DMA_TEST_MODE_BLOCK] = "DMA_BLOCK"
+};
+
+
+/* The context for one DMA channel during a test */
+typedef struct
+{
+    /* Used to perform DMA for the test when DMA_TEST_MODE_RING */
+    pex_dma_ring_context_t ring;
+    /* Used to perform DMA for the test when DMA_TEST_MODE_BLOCK */
+    pex_dma_block_context_t block;
+    /* Used for CPU access to the UART used as the local bus target of the DMA */
+    uint8_t *uart_registers;
+    /* The local bus address used as the target of the DMA */
+    uint32_t local_address;
+    /* The host buffers for host-to-card and card-to-host transfers */
+    uint8_t *h2c_buffer;
+    uint64_t h2c_buffer_iova;
+    uint8_t *c2h_buffer;
+    uint64_t c2h_buffer_iova;
+    /* The number of transfers which have been started and completed for the current test */
+    uint32_t num_started_transfers;
+    uint32_t num_completed_transfers;
+    /* The number of transfers started by the most recent DMA start, which are in progress */
+    uint32_t num_in_progress_transfers;
+    /* The time at which the final transfer for the current test completed */
+    int64_t end_time_ns;
+} dma_channel_context_t;
+
+
+/* The timeout used for the test. Made a global so may be changed if single stepping in the debugger */
+static int test_timeout_secs = 10;
+
+
+/* Command line argument to enable dumping of PEX8311 registers for debug */
+static bool arg_dump_pex_registers;
+
+
+/* Command line argument to select which test modes are enabled */
+static bool arg_enabled_test_modes[DMA_TEST_MODE_ARRAY_SIZE];
+
+
+/* Command line argument to specify the DMA capability for testing handling of IOVA above the 4-GB Address Boundary */
+static vfio_device_dma_capability_t arg_dma_capability = VFIO_DEVICE_DMA_CAPABILITY_A32;
+
+
+/* Command line argument which sets the number of descriptors in the ring for each DMA channel */
+static uint32_t arg_ring_size = 1024;
+
+
+/* Command line arguments which set the range of DMA transfer sizes swept, in powers of two */
+static uint32_t arg_min_transfer_size = 1;
+static uint32_t arg_max_transfer_size = 65536;
+
+
+/* Command line argument which sets the number of bytes transferred per DMA channel for each test */
+static uint32_t arg_test_bytes_per_channel = 1024 * 1024;
+
+
+/**
+ * @brief Parse the command line arguments, storing the results in global variables
+ * @param[in] argc, argv Arguments passed to main
+ */
+static void parse_command_line_arguments (int argc, char *argv[])
+{
+    const char *const optstring = "dm:6r:s:S:b:?";
+    int option;
+    char junk;
+    dma_test_mode_t test_mode;
+    bool test_modes_specified = false;
+    bool mode_found;
+
+    option = getopt (argc, argv, optstring);
+    while (option != -1)
+    {
+        switch (option)
+        {
+        case 'd':
+            arg_dump_pex_registers = true;
+            break;
+
+        case 'm':
+            mode_found = false;
+            for (test_mode = 0; test_mode < DMA_TEST_MODE_ARRAY_SIZE; test_mode++)
+            {
+                if (strcasecmp (optarg, dma_test_mode_descriptions[test_mode]) == 0)
+                {
+                    arg_enabled_test_modes[test_mode] = true;
+                    mode_found = true;
+                }
+            }
+            if (!mode_found)
+            {
+                printf ("ERROR: Invalid test mode \"%s\"\n", optarg);
+                exit (EXIT_FAILURE);
+            }
+            test_modes_specified = true;
+            break;
+
+        case '6':
+            arg_dma_capability = VFIO_DEVICE_DMA_CAPABILITY_A64;
+            break;
+
+        case 'r':
+            if ((sscanf (optarg, "%" SCNu32 "%c", &arg_ring_size, &junk) != 1) || (arg_ring_size < 2))
+            {
+                printf ("ERROR: Invalid ring size \"%s\"\n", optarg);
+                exit (EXIT_FAILURE);
+            }
+            break;
+
+        case 's':
+            if ((sscanf (optarg, "%" SCNu32 "%c", &arg_min_transfer_size, &junk) != 1)
+                    || (arg_min_transfer_size < 1) || (arg_min_transfer_size > PEX_MAX_DMA_TRANSFER_SIZE_BYTES))
+            {
+                printf ("ERROR: Invalid min DMA transfer size \"%s\"\n", optarg);
+                exit (EXIT_FAILURE);
+            }
+            break;
+
+        case 'S':
+            if ((sscanf (optarg, "%" SCNu32 "%c", &arg_max_transfer_size, &junk) != 1)
+                    || (arg_max_transfer_size < 1) || (arg_max_transfer_size > PEX_MAX_DMA_TRANSFER_SIZE_BYTES))
+            {
+                printf ("ERROR: Invalid max DMA transfer size \"%s\"\n", optarg);
+                exit (EXIT_FAILURE);
+            }
+            break;
+
+        case 'b':
+            if ((sscanf (optarg, "%" SCNu32 "%c", &arg_test_bytes_per_channel, &junk) != 1)
+                    || (arg_test_bytes_per_channel < 1))
+            {
+                printf ("ERROR: Invalid test bytes per channel \"%s\"\n", optarg);
+                exit (EXIT_FAILURE);
+            }
+            break;
+
+        case '?':
+        default:
+            printf ("Usage %s [-d] [-m DMA_BLOCK|DMA_RING] [-6] [-r <ring_size>] [-s <min_transfer_size_bytes>] [-S <max_transfer_size_bytes>] [-b <test_bytes_per_channel>]\n", argv[0]);
+            printf ("  -d dumps the PEX8311 Local Configuration Space registers for debugging\n");
+            printf ("  -m may be specified more than once to specify multiple test modes\n");
+            printf ("     Defaults to all test modes if not specified\n");
+            printf ("  -6 specifies 64-bit DMA addressing capability\n");
+            printf ("  -r sets the number of descriptors in the ring for each DMA channel\n");
+            printf ("  -s and -S set the range of transfer sizes swept in powers of two\n");
+            printf ("  -b sets the number of bytes transferred by each DMA channel for each transfer size\n");
+            exit (EXIT_FAILURE);
+            break;
+        }
+        option = getopt (argc, argv, optstring);
+    }
+
+    if (arg_min_transfer_size > arg_max_transfer_size)
+    {
+        printf ("ERROR: min transfer size %" PRIu32 " greater than max transfer size %" PRIu32 "\n",
+                arg_min_transfer_size, arg_max_transfer_size);
+        exit (EXIT_FAILURE);
+    }
+
+    if (arg_max_transfer_size > arg_test_bytes_per_channel)
+    {
+        printf ("ERROR: max transfer size %" PRIu32 " greater than test bytes per channel %" PRIu32 "\n",
+                arg_max_transfer_size, arg_test_bytes_per_channel);
+        exit (EXIT_FAILURE);
+    }
+
+    if (!test_modes_specified)
+    {
+        for (test_mode = 0; test_mode < DMA_TEST_MODE_ARRAY_SIZE; test_mode++)
+        {
+            arg_enabled_test_modes[test_mode] = true;
+        }
+    }
+}
+
+
+/**
+ * @brief Start the next DMA transfer(s) for one channel during a test
+ * @details For DMA_TEST_MODE_RING queues as many descriptors as are free in the ring, leaving one descriptor with the
+ *          Valid flag clear to stop the ring.
+ * @param[in/out] channel The channel to start the transfer(s) on
+ * @param[in] test_mode Which DMA mode is used
+ * @param[in] direction PEX_LCS_DMADPRx_DIRECTION_PCI_TO_LOCAL or PEX_LCS_DMADPRx_DIRECTION_LOCAL_TO_PCI
+ * @param[in] transfer_size The size of each DMA transfer
+ * @param[in] num_transfers The total number of transfers for the test
+ */
+static void start_dma_transfers (dma_channel_context_t *const channel, const dma_test_mode_t test_mode,
+                                 const uint32_t direction, const uint32_t transfer_size, const uint32_t num_transfers)
+{
+    const uint64_t buffer_iova =
+            (direction == PEX_LCS_DMADPRx_DIRECTION_PCI_TO_LOCAL) ? channel->h2c_buffer_iova : channel->c2h_buffer_iova;
+    const uint32_t remaining_transfers = num_transfers - channel->num_started_transfers;
+    uint32_t transfer_iova;
+
+    switch (test_mode)
+    {
+    case DMA_TEST_MODE_RING:
+        channel->num_in_progress_transfers = remaining_transfers;
+        if (channel->num_in_progress_transfers > (channel->ring.num_descriptors - 1))
+        {
+            channel->num_in_progress_transfers = channel->ring.num_descriptors - 1;
+        }
+        for (uint32_t transfer_index = 0; transfer_index < channel->num_in_progress_transfers; transfer_index++)
+        {
+            transfer_iova = (uint32_t) (buffer_iova + ((channel->num_started_transfers + transfer_index) * transfer_size));
+            pex_update_descriptor_in_ring (&channel->ring, transfer_size, transfer_iova, channel->local_address, direction);
+        }
+        pex_start_dma_ring (&channel->ring);
+        break;
+
+    case DMA_TEST_MODE_BLOCK:
+        channel->num_in_progress_transfers = 1;
+        pex_start_dma_block (&channel->block, transfer_size,
+                buffer_iova + (channel->num_started_transfers * (uint64_t) transfer_size), channel->local_address, direction);
+        break;
+
+    default:
+        break;
+    }
+
+    channel->num_started_transfers += channel->num_in_progress_transfers;
+}
+
+
+/**
+ * @brief Perform one DMA throughput test, with both DMA channels transferring concurrently.
+ * @param[in/out] channels The DMA channels to use for the test
+ * @param[in] test_mode Which DMA mode to use
+ * @param[in] direction PEX_LCS_DMADPRx_DIRECTION_PCI_TO_LOCAL or PEX_LCS_DMADPRx_DIRECTION_LOCAL_TO_PCI
+ * @param[in] transfer_size The size of each DMA transfer
+ * @param[in/out] seed Used to generate the data transferred
+ * @return Returns true if the test passed, or false if failed
+ */
+static bool perform_dma_throughput_test (dma_channel_context_t channels[const PEX_NUM_DMA_CHANNELS],
+                                         const dma_test_mode_t test_mode, const uint32_t direction,
+                                         const uint32_t transfer_size, uint32_t *const seed)
+{
+    const bool h2c = direction == PEX_LCS_DMADPRx_DIRECTION_PCI_TO_LOCAL;
+    const uint32_t num_transfers = arg_test_bytes_per_channel / transfer_size;
+    const uint32_t test_bytes = num_transfers * transfer_size;
+    uint32_t channel_index;
+    uint32_t num_channels_complete;
+    uint8_t expected_scratch[PEX_NUM_DMA_CHANNELS];
+    bool success = true;
+    bool dma_complete;
+
+    /* Prepare the data for the test */
+    for (channel_index = 0; channel_index < PEX_NUM_DMA_CHANNELS; channel_index++)
+    {
+        dma_channel_context_t *const channel = &channels[channel_index];
+
+        if (h2c)
+        {
+            for (uint32_t byte_index = 0; byte_index < test_bytes; byte_index++)
+            {
+                channel->h2c_buffer[byte_index] = (uint8_t) *seed;
+                linear_congruential_generator32 (seed);
+            }
+            expected_scratch[channel_index] = channel->h2c_buffer[test_bytes - 1];
+        }
+        else
+        {
+            expected_scratch[channel_index] = (uint8_t) *seed;
+            linear_congruential_generator32 (seed);
+            write_reg8 (channel->uart_registers, UART_SCR, expected_scratch[channel_index]);
+            memset (channel->c2h_buffer, (uint8_t) ~expected_scratch[channel_index], test_bytes);
+        }
+
+        channel->num_started_transfers = 0;
+        channel->num_completed_transfers = 0;
+        channel->num_in_progress_transfers = 0;
+    }
+
+    /* Run the DMA on both channels until all transfers have completed */
+    const int64_t start_time_ns = get_monotonic_time ();
+    const int64_t timeout_time_ns = start_time_ns + (test_timeout_secs * 1000000000LL);
+    do
+    {
+        num_channels_complete = 0;
+        for (channel_index = 0; channel_index < PEX_NUM_DMA_CHANNELS; channel_index++)
+        {
+            dma_channel_context_t *const channel = &channels[channel_index];
+
+            if (channel->num_in_progress_transfers > 0)
+            {
+                dma_complete = (test_mode == DMA_TEST_MODE_RING) ? pex_poll_dma_ring_completion (&channel->ring) :
+                        pex_poll_dma_block_completion (&channel->block);
+                if (dma_complete)
+                {
+                    channel->num_completed_transfers += channel->num_in_progress_transfers;
+                    channel->num_in_progress_transfers = 0;
+                    if (channel->num_completed_transfers == num_transfers)
+                    {
+                        channel->end_time_ns = get_monotonic_time ();
+                    }
+                }
+            }
+
+            if (channel->num_in_progress_transfers == 0)
+            {
+                if (channel->num_started_transfers < num_transfers)
+                {
+                    start_dma_transfers (channel, test_mode, direction, transfer_size, num_transfers);
+                }
+                else
+                {
+                    num_channels_complete++;
+                }
+            }
+        }
+
+        if ((num_channels_complete < PEX_NUM_DMA_CHANNELS) && (get_monotonic_time () > timeout_time_ns))
+        {
+            printf ("Timeout waiting for %s %s transfer size %" PRIu32 " (ch0 completed %" PRIu32 " ch1 completed %" PRIu32 " of %" PRIu32 ")\n",
+                    dma_test_mode_descriptions[test_mode], h2c ? "H2C" : "C2H", transfer_size,
+                    channels[0].num_completed_transfers, channels[1].num_completed_transfers, num_transfers);
+            exit (EXIT_FAILURE);
+        }
+    } while (num_channels_complete < PEX_NUM_DMA_CHANNELS);
+
+    /* Report the throughput */
+    int64_t aggregate_end_time_ns = start_time_ns;
+    printf ("%-9s  %s  %8" PRIu32, dma_test_mode_descriptions[test_mode], h2c ? "H2C" : "C2H", transfer_size);
+    for (channel_index = 0; channel_index < PEX_NUM_DMA_CHANNELS; channel_index++)
+    {
+        const dma_channel_context_t *const channel = &channels[channel_index];
+        const double channel_duration_secs = (double) (channel->end_time_ns - start_time_ns) / 1E9;
+
+        printf ("  %11.3f", ((double) test_bytes / channel_duration_secs) / 1E6);
+        if (channel->end_time_ns > aggregate_end_time_ns)
+        {
+            aggregate_end_time_ns = channel->end_time_ns;
+        }
+    }
+    const double aggregate_duration_secs = (double) (aggregate_end_time_ns - start_time_ns) / 1E9;
+    printf ("  %11.3f  %12.0f",
+            ((double) (PEX_NUM_DMA_CHANNELS * test_bytes) / aggregate_duration_secs) / 1E6,
+            (double) (PEX_NUM_DMA_CHANNELS * num_transfers) / aggregate_duration_secs);
+
+    /* Perform the data checks possible when using a single register as the local target */
+    for (channel_index = 0; channel_index < PEX_NUM_DMA_CHANNELS; channel_index++)
+    {
+        const dma_channel_context_t *const channel = &channels[channel_index];
+
+        if (h2c)
+        {
+            const uint8_t actual_scratch = read_reg8 (channel->uart_registers, UART_SCR);
+
+            if (actual_scratch != expected_scratch[channel_index])
+            {
+                printf ("\n  ch%" PRIu32 " scratch register expected 0x%02x actual 0x%02x",
+                        channel_index, expected_scratch[channel_index], actual_scratch);
+                success = false;
+            }
+        }
+        else
+        {
+            for (uint32_t byte_index = 0; byte_index < test_bytes; byte_index++)
+            {
+                if (channel->c2h_buffer[byte_index] != expected_scratch[channel_index])
+                {
+                    printf ("\n  ch%" PRIu32 " c2h_buffer[%" PRIu32 "] expected 0x%02x actual 0x%02x",
+                            channel_index, byte_index, expected_scratch[channel_index], channel->c2h_buffer[byte_index]);
+                    success = false;
+                    break;
+                }
+            }
+        }
+    }
+    printf ("  %s\n", success ? "PASS" : "FAIL");
+
+    return success;
+}
+
+
+/**
+ * @brief Perform the DMA throughput tests on one device, using VFIO
+ * @param[in/out] vfio_devices The opened VFIO devices
+ * @param[in] device_index Which VFIO device to test
+ */
+static void perform_dma_tests (vfio_devices_t *const vfio_devices, const uint32_t device_index)
+{
+    vfio_device_t *const vfio_device = vfio_devices->devices[device_index];
+    const uint32_t local_space_bar_indices[PEX_NUM_DMA_CHANNELS] =
+    {
+        PEX_LOCAL_SPACE0_BAR_INDEX,
+        PEX_LOCAL_SPACE1_BAR_INDEX
+    };
+    const uint32_t lasba_offsets[PEX_NUM_DMA_CHANNELS] =
+    {
+        PEX_LCS_LAS0BA,
+        PEX_LCS_LAS1BA
+    };
+    const uint32_t directions[] =
+    {
+        PEX_LCS_DMADPRx_DIRECTION_PCI_TO_LOCAL,
+        PEX_LCS_DMADPRx_DIRECTION_LOCAL_TO_PCI
+    };
+    const uint32_t num_directions = sizeof (directions) / sizeof (directions[0]);
+    vfio_dma_mapping_t vfio_mapping;
+    dma_channel_context_t channels[PEX_NUM_DMA_CHANNELS];
+    uint32_t channel_index;
+    uint32_t seed;
+    uint32_t total_tests = 0;
+    uint32_t total_test_failures = 0;
+
+    map_vfio_device_bar_before_use (vfio_device, PEX_LCS_MMIO_BAR_INDEX);
+    uint8_t *const lcs = vfio_device->mapped_bars[PEX_LCS_MMIO_BAR_INDEX];
+    if (lcs == NULL)
+    {
+        printf ("BAR %d not mapped\n", PEX_LCS_MMIO_BAR_INDEX);
+        exit (EXIT_FAILURE);
+    }
+
+    if (arg_dump_pex_registers)
+    {
+        pex_dump_lcs_registers (lcs, "initial");
+    }
+
+    /* Allocate DMA addressable space for both channels, including DMA descriptors.
+     * The allocated size needs to be page aligned to prevent VFIO_IOMMU_MAP_DMA failing with EPERM */
+    const size_t page_size = (size_t) getpagesize ();
+    const size_t per_channel_iova_size =
+            vfio_align_cache_line_size (arg_test_bytes_per_channel) + /* h2c_buffer */
+            vfio_align_cache_line_size (arg_test_bytes_per_channel) + /* c2h_buffer */
+            vfio_align_cache_line_size ((arg_ring_size * sizeof (pex_ring_dma_descriptor_short_format_t))); /* DMA descriptors */
+    const size_t required_iova_size = PEX_NUM_DMA_CHANNELS * per_channel_iova_size;
+    const size_t aligned_iova_size = ((required_iova_size + page_size - 1) / page_size) * page_size;
+    allocate_vfio_dma_mapping (vfio_device, &vfio_mapping, aligned_iova_size,
+            VFIO_DMA_MAP_FLAG_READ | VFIO_DMA_MAP_FLAG_WRITE, VFIO_BUFFER_ALLOCATION_HEAP);
+    if (vfio_mapping.buffer.vaddr == NULL)
+    {
+        exit (EXIT_FAILURE);
+    }
+    printf ("vfio_mapping iova=0x%" PRIx64 " size=0x%zx (%s 4GB address boundary)\n",
+            vfio_mapping.iova, vfio_mapping.buffer.size,
+            pex_check_ring_dma_iova_constraints (&vfio_mapping) ? "below" : "above");
+
+    /* Initialise each DMA channel to target the Scratch Pad Register of one UART */
+    memset (channels, 0, sizeof (channels));
+    for (channel_index = 0; channel_index < PEX_NUM_DMA_CHANNELS; channel_index++)
+    {
+        dma_channel_context_t *const channel = &channels[channel_index];
+        const uint32_t bar_index = local_space_bar_indices[channel_index];
+
+        map_vfio_device_bar_before_use (vfio_device, bar_index);
+        channel->uart_registers = vfio_device->mapped_bars[bar_index];
+        if (channel->uart_registers == NULL)
+        {
+            printf ("BAR %" PRIu32 " not mapped\n", bar_index);
+            exit (EXIT_FAILURE);
+        }
+        channel->local_address = (read_reg32 (lcs, lasba_offsets[channel_index]) & PEX_LCS_LASxBA_ADDR_MASK) + UART_SCR;
+
+        /* Check the Scratch Pad Register can be accessed by the CPU before using as the target for DMA */
+        const uint8_t scratch_test_patterns[] = {0x55, 0xaa};
+        for (uint32_t pattern_index = 0; pattern_index < sizeof (scratch_test_patterns); pattern_index++)
+        {
+            write_reg8 (channel->uart_registers, UART_SCR, scratch_test_patterns[pattern_index]);
+            const uint8_t scratch = read_reg8 (channel->uart_registers, UART_SCR);
+            if (scratch != scratch_test_patterns[pattern_index])
+            {
+                printf ("BAR %" PRIu32 " UART scratch register wrote 0x%02x read 0x%02x\n",
+                        bar_index, scratch_test_patterns[pattern_index], scratch);
+                exit (EXIT_FAILURE);
+            }
+        }
+
+        channel->h2c_buffer = vfio_dma_mapping_allocate_space (&vfio_mapping, arg_test_bytes_per_channel,
+                &channel->h2c_buffer_iova);
+        vfio_dma_mapping_align_space (&vfio_mapping);
+        channel->c2h_buffer = vfio_dma_mapping_allocate_space (&vfio_mapping, arg_test_bytes_per_channel,
+                &channel->c2h_buffer_iova);
+        if ((channel->h2c_buffer == NULL) || (channel->c2h_buffer == NULL))
+        {
+            exit (EXIT_FAILURE);
+        }
+    }
+
+    /* Iterate over test modes */
+    seed = 1;
+    for (dma_test_mode_t test_mode = 0; test_mode < DMA_TEST_MODE_ARRAY_SIZE; test_mode++)
+    {
+        /* Skip a test mode which isn't enabled */
+        if (!arg_enabled_test_modes[test_mode])
+        {
+            continue;
+        }
+
+        /* Perform test mode specific setup. This doesn't start any DMA. */
+        switch (test_mode)
+        {
+        case DMA_TEST_MODE_RING:
+            if (!pex_check_ring_dma_iova_constraints (&vfio_mapping))
+            {
+                printf ("Skipping DMA ring test, as IOVA above 4GB address boundary\n");
+                continue;
+            }
+            for (channel_index = 0; channel_index < PEX_NUM_DMA_CHANNELS; channel_index++)
+            {
+                pex_initialise_dma_ring (&channels[channel_index].ring, lcs, channel_index, arg_ring_size, &vfio_mapping);
+            }
+            if (arg_dump_pex_registers)
+            {
+                pex_dump_lcs_registers (lcs, "DMA ring setup");
+            }
+            break;
+
+        case DMA_TEST_MODE_BLOCK:
+            for (channel_index = 0; channel_index < PEX_NUM_DMA_CHANNELS; channel_index++)
+            {
+                pex_initialise_dma_block (&channels[channel_index].block, lcs, channel_index);
+            }
+            if (arg_dump_pex_registers)
+            {
+                pex_dump_lcs_registers (lcs, "DMA block setup");
+            }
+            break;
+
+        default:
+            break;
+        }
+
+        printf ("\n%-9s  Dir  Transfer  ch0 Mbytes/s  ch1 Mbytes/s  agg Mbytes/s  agg xfers/s  Result\n", "Mode");
+        for (uint32_t direction_index = 0; direction_index < num_directions; direction_index++)
+        {
+            for (uint64_t transfer_size = arg_min_transfer_size;
+                 transfer_size <= arg_max_transfer_size;
+                 transfer_size *= 2)
+            {
+                if (!perform_dma_throughput_test (channels, test_mode, directions[direction_index],
+                        (uint32_t) transfer_size, &seed))
+                {
+                    total_test_failures++;
+                }
+                total_tests++;
+            }
+        }
+
+        if (arg_dump_pex_registers)
+        {
+            pex_dump_lcs_registers (lcs, "test mode completion");
+        }
+    }
+
+    free_vfio_dma_mapping (&vfio_mapping);
+
+    if (total_tests > 0)
+    {
+        if (total_test_failures > 0)
+        {
+            printf ("\n%u out of %u tests FAILED\n", total_test_failures, total_tests);
+        }
+        else
+        {
+            printf ("\nAll %u tests PASSED\n", total_tests);
+        }
+    }
+}
+
+
+int main (int argc, char *argv[])
+{
+    vfio_devices_t vfio_devices;
+
+    parse_command_line_arguments (argc, argv);
+
+    /* The device ID for a SIO4 board, which is what the identity of the Sealevel COMM+2.LPCIe board (7205e)
+     * has been changed to as described in
+     * https://github.com/Chester-Gillon/plx_poll_mode_driver/blob/master/plx_poll_mode_driver/sealevel_pex8311_addressing.txt */
+    const vfio_pci_device_identity_filter_t filter =
+    {
+        .vendor_id = 0x10b5,
+        .device_id = 0x9056,
+        .subsystem_vendor_id = 0x10b5,
+        .subsystem_device_id = 0x3198,
+        .dma_capability = arg_dma_capability
+    };
+
+    /* Open the Sealevel devices which have an IOMMU group assigned */
+    open_vfio_devices_matching_filter (&vfio_devices, 1, &filter);
+
+    /* Process any Sealevel devices found */
+    for (uint32_t device_index = 0; device_index < vfio_devices.num_devices; device_index++)
+    {
+        perform_dma_tests (&vfio_devices, device_index);
+    }
+
+    close_vfio_devices (&vfio_devices);
+
+    return EXIT_SUCCESS;
+}
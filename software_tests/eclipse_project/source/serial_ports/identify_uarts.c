@@ -692,7 +692,7 @@ int main (int argc, char *argv[])
     /* Process the opened devices */
     for (uint32_t device_index = 0; device_index < vfio_devices.num_devices; device_index++)
     {
-        vfio_device_t *const vfio_device = &vfio_devices.devices[device_index];
+        vfio_device_t *const vfio_device = vfio_devices.devices[device_index];
 
         for (card_index = 0; card_index < SERIAL_CARD_ARRAY_SIZE; card_index++)
         {
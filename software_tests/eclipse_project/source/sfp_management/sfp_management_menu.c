@@ -455,7 +455,7 @@ int main (int argc, char *argv[])
         {
             printf ("%u devices found, only using the 1st one\n", vfio_devices.num_devices);
         }
-        sfp_management_menu (&vfio_devices.devices[0]);
+        sfp_management_menu (vfio_devices.devices[0]);
     }
     else
     {
@@ -0,0 +1,65 @@
+/*
+ * @file pcie_extended_capability.h
+ * @date 18 Oct 2026
+ * @author Chester Gillon
+ * @brief Provides a search of the PCIe extended capabilities which is independent of the PCI access mechanism
+ * @details
+ *   Shared by the vfio_access library and the generic PCI access programs, which read the PCI configuration space
+ *   using different mechanisms. The caller supplies a function to read a dword of the configuration space.
+ */
+
+#ifndef PCIE_EXTENDED_CAPABILITY_H_
+#define PCIE_EXTENDED_CAPABILITY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <linux/pci_regs.h>
+
+
+/* Function used to read one dword of the PCI configuration space of a device.
+ * device is the caller's handle for the device. Returns true if the read was successful. */
+typedef bool (*pcie_config_read_u32_t) (void *const device, const uint32_t offset, uint32_t *const value);
+
+
+/**
+ * @brief Find a PCIe extended capability for a device
+ * @details The extended capabilities start at offset PCI_CFG_SPACE_SIZE in the PCI configuration space, and are only
+ *          present for PCIe devices. A failure to read the configuration space is treated as the capability not being
+ *          present.
+ * @param[in] read_u32 The function used to read the configuration space of the device
+ * @param[in/out] device The caller's handle for the device, passed to read_u32
+ * @param[in] capability_id The PCI_EXT_CAP_ID_* to search for
+ * @param[out] capability_offset The offset in the PCI configuration space of the header of the extended capability
+ * @return Returns true when the extended capability has been found.
+ */
+static inline bool pcie_find_extended_capability (pcie_config_read_u32_t read_u32, void *const device,
+                                                  const uint16_t capability_id, uint32_t *const capability_offset)
+{
+    bool been_hear[PCI_CFG_SPACE_EXP_SIZE / sizeof (uint32_t)] = {false};
+    uint32_t capability_header;
+    bool found = false;
+
+    /* Iterate over all extended capabilities. been_hear[] used as protection against infinite loops due to malformed
+     * capability lists. A header of zero, or all ones, indicates no extended capabilities. */
+    *capability_offset = PCI_CFG_SPACE_SIZE;
+    while ((!found) && (*capability_offset >= PCI_CFG_SPACE_SIZE) && (*capability_offset < PCI_CFG_SPACE_EXP_SIZE) &&
+           (!been_hear[*capability_offset / sizeof (uint32_t)]) &&
+           read_u32 (device, *capability_offset, &capability_header) &&
+           (capability_header != 0) && (capability_header != 0xffffffff))
+    {
+        if (PCI_EXT_CAP_ID (capability_header) == capability_id)
+        {
+            found = true;
+        }
+        else
+        {
+            been_hear[*capability_offset / sizeof (uint32_t)] = true;
+            *capability_offset = PCI_EXT_CAP_NEXT (capability_header);
+        }
+    }
+
+    return found;
+}
+
+#endif /* PCIE_EXTENDED_CAPABILITY_H_ */
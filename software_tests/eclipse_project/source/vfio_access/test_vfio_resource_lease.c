@@ -0,0 +1,291 @@
+/*
+ * @file test_vfio_resource_lease.c
+ * @date 18 Oct 2026
+ * @author Chester Gillon
+ * @brief Client used to test the resource leases provided by the VFIO multi process manager
+ * @details
+ *   Opens one VFIO device, acquires a lease on one resource of the device, holds the lease for a specified time and then
+ *   releases the lease. Each event is reported on a line prefixed by the client name, and standard out is line buffered,
+ *   so that the order in which multiple clients are granted a lease can be checked from their combined output.
+ *
+ *   This program doesn't access any of the registers in the opened device, so can lease any type of resource to test the
+ *   arbitration performed by the manager. When the VFIO multi process manager isn't running the lease is always granted.
+ *
+ *   Exits with success if the lease was granted, or failure if timed out waiting for the lease.
+ */
+
+#include "vfio_access.h"
+#include "transfer_timing.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <time.h>
+
+
+/** The command line options for this program, in the format passed to getopt_long().
+ *  Only long arguments are supported */
+static const struct option command_line_options[] =
+{
+    {"device", required_argument, NULL, 0},
+    {"name", required_argument, NULL, 0},
+    {"resource_type", required_argument, NULL, 0},
+    {"resource_index", required_argument, NULL, 0},
+    {"lease_secs", required_argument, NULL, 0},
+    {"wait_secs", required_argument, NULL, 0},
+    {"hold_secs", required_argument, NULL, 0},
+    {NULL, 0, NULL, 0}
+};
+
+
+/* The names of the resource types which can be specified on the command line */
+static const char *const resource_type_names[VFIO_RESOURCE_TYPE_ARRAY_SIZE] =
+{
+    [VFIO_RESOURCE_DMA_H2C_CHANNEL] = "h2c",
+    [VFIO_RESOURCE_DMA_C2H_CHANNEL] = "c2h",
+    [VFIO_RESOURCE_QUAD_SPI       ] = "quad_spi",
+    [VFIO_RESOURCE_IIC            ] = "iic",
+    [VFIO_RESOURCE_CMAC_PORT      ] = "cmac"
+};
+
+
+/* Command line argument which specifies the PCI device containing the resource to lease */
+static const char *arg_device = NULL;
+
+
+/* Command line argument which specifies the name used to prefix the output, to identify the client */
+static const char *arg_name = "client";
+
+
+/* Command line arguments which specify the resource to lease */
+static vfio_resource_type_t arg_resource_type = VFIO_RESOURCE_IIC;
+static uint32_t arg_resource_index = 0;
+
+
+/* Command line arguments which specify the lease duration and wait timeout. Zero means no time limit */
+static double arg_lease_secs = 0.0;
+static double arg_wait_secs = 0.0;
+
+
+/* Command line argument which specifies how long the lease is held for before being released */
+static double arg_hold_secs = 0.0;
+
+
+/**
+ * @brief Display the usage for this program, and the exit
+ */
+static void display_usage (void)
+{
+    printf ("Usage:\n");
+    printf ("--device <domain>:<bus>:<dev>.<func>\n");
+    printf ("  The PCI device containing the resource to lease. Mandatory\n");
+    printf ("--name <name>\n");
+    printf ("  The name used to prefix the output, to identify the client. Defaults to %s\n", arg_name);
+    printf ("--resource_type h2c|c2h|quad_spi|iic|cmac\n");
+    printf ("  The type of resource to lease. Defaults to %s\n", resource_type_names[arg_resource_type]);
+    printf ("--resource_index <index>\n");
+    printf ("  The instance of the resource type to lease. Defaults to %" PRIu32 "\n", arg_resource_index);
+    printf ("--lease_secs <secs>\n");
+    printf ("  The duration of the lease. Defaults to no time limit\n");
+    printf ("--wait_secs <secs>\n");
+    printf ("  How long to wait for the lease to be granted. Defaults to no time limit\n");
+    printf ("--hold_secs <secs>\n");
+    printf ("  How long to hold the lease for before releasing it. Defaults to %.3f\n", arg_hold_secs);
+
+    exit (EXIT_FAILURE);
+}
+
+
+/**
+ * @brief Parse a command line argument which is a time in seconds
+ * @param[in] optdef The definition of the argument being parsed
+ * @param[out] secs The parsed time
+ */
+static void parse_secs_argument (const struct option *const optdef, double *const secs)
+{
+    char junk;
+
+    if ((sscanf (optarg, "%lf%c", secs, &junk) != 1) || (*secs < 0.0))
+    {
+        printf ("Invalid %s %s\n", optdef->name, optarg);
+        exit (EXIT_FAILURE);
+    }
+}
+
+
+/**
+ * @brief Parse the command line arguments, storing the results in global variables
+ * @param[in] argc, argv Command line arguments passed to the program
+ */
+static void parse_command_line_arguments (int argc, char *argv[])
+{
+    int opt_status;
+    char junk;
+
+    do
+    {
+        int option_index = 0;
+
+        opt_status = getopt_long (argc, argv, "", command_line_options, &option_index);
+        if (opt_status == '?')
+        {
+            display_usage ();
+        }
+        else if (opt_status >= 0)
+        {
+            const struct option *const optdef = &command_line_options[option_index];
+
+            if (optdef->flag != NULL)
+            {
+                /* Argument just sets a flag */
+            }
+            else if (strcmp (optdef->name, "device") == 0)
+            {
+                arg_device = optarg;
+            }
+            else if (strcmp (optdef->name, "name") == 0)
+            {
+                arg_name = optarg;
+            }
+            else if (strcmp (optdef->name, "resource_type") == 0)
+            {
+                bool found = false;
+
+                for (vfio_resource_type_t resource_type = 0;
+                     !found && (resource_type < VFIO_RESOURCE_TYPE_ARRAY_SIZE);
+                     resource_type++)
+                {
+                    if (strcmp (optarg, resource_type_names[resource_type]) == 0)
+                    {
+                        arg_resource_type = resource_type;
+                        found = true;
+                    }
+                }
+                if (!found)
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else if (strcmp (optdef->name, "resource_index") == 0)
+            {
+                if (sscanf (optarg, "%" SCNu32 "%c", &arg_resource_index, &junk) != 1)
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else if (strcmp (optdef->name, "lease_secs") == 0)
+            {
+                parse_secs_argument (optdef, &arg_lease_secs);
+            }
+            else if (strcmp (optdef->name, "wait_secs") == 0)
+            {
+                parse_secs_argument (optdef, &arg_wait_secs);
+            }
+            else if (strcmp (optdef->name, "hold_secs") == 0)
+            {
+                parse_secs_argument (optdef, &arg_hold_secs);
+            }
+            else
+            {
+                /* This is a program error, and shouldn't be triggered by the command line options */
+                fprintf (stderr, "Unexpected argument definition %s\n", optdef->name);
+                exit (EXIT_FAILURE);
+            }
+        }
+    } while (opt_status != -1);
+
+    if (arg_device == NULL)
+    {
+        printf ("The --device argument is mandatory\n");
+        display_usage ();
+    }
+}
+
+
+/**
+ * @brief Convert a time in seconds from the command line into the nanoseconds for a lease
+ * @param[in] secs The time in seconds, where zero means no time limit
+ * @return The time in nanoseconds
+ */
+static uint64_t secs_to_lease_ns (const double secs)
+{
+    return (secs > 0.0) ? (uint64_t) (secs * 1E9) : VFIO_RESOURCE_LEASE_INFINITE_NS;
+}
+
+
+int main (int argc, char *argv[])
+{
+    vfio_devices_t vfio_devices;
+    uint32_t lease_id;
+    bool granted = false;
+
+    parse_command_line_arguments (argc, argv);
+
+    /* Line buffered so that the output of concurrent clients redirected to the same file is in the order of events */
+    setvbuf (stdout, NULL, _IOLBF, 0);
+
+    /* Open only the specified device, which can be any type of device since the registers aren't accessed */
+    const vfio_pci_device_identity_filter_t filter_any_id =
+    {
+        .vendor_id = VFIO_PCI_DEVICE_FILTER_ANY,
+        .device_id = VFIO_PCI_DEVICE_FILTER_ANY,
+        .subsystem_vendor_id = VFIO_PCI_DEVICE_FILTER_ANY,
+        .subsystem_device_id = VFIO_PCI_DEVICE_FILTER_ANY,
+        .dma_capability = VFIO_DEVICE_DMA_CAPABILITY_NONE
+    };
+
+    vfio_add_pci_device_location_filter (arg_device);
+    open_vfio_devices_matching_filter (&vfio_devices, 1, &filter_any_id);
+    if (vfio_devices.num_devices == 0)
+    {
+        printf ("%s unable to open device %s\n", arg_name, arg_device);
+        exit (EXIT_FAILURE);
+    }
+
+    vfio_device_t *const vfio_device = vfio_devices.devices[0];
+    if (vfio_devices.devices_usage != VFIO_DEVICES_USAGE_INDIRECT_ACCESS)
+    {
+        printf ("%s not using the VFIO multi process manager, so the lease is always granted\n", arg_name);
+    }
+
+    /* Acquire the lease */
+    printf ("%s requesting lease on %s %" PRIu32 " in device %s\n",
+            arg_name, vfio_resource_type_name (arg_resource_type), arg_resource_index, vfio_device->device_name);
+    const int64_t request_time = get_monotonic_time ();
+    granted = vfio_acquire_resource_lease (vfio_device, arg_resource_type, arg_resource_index,
+            secs_to_lease_ns (arg_lease_secs), secs_to_lease_ns (arg_wait_secs), &lease_id);
+    const double wait_secs = (double) (get_monotonic_time () - request_time) / 1E9;
+
+    if (granted)
+    {
+        printf ("%s granted lease_id %" PRIu32 " after waiting %.3f secs\n", arg_name, lease_id, wait_secs);
+
+        /* Hold the lease, and then release it */
+        const struct timespec hold_time =
+        {
+            .tv_sec = (time_t) arg_hold_secs,
+            .tv_nsec = (long) ((arg_hold_secs - (double) (time_t) arg_hold_secs) * 1E9)
+        };
+        clock_nanosleep (CLOCK_MONOTONIC, 0, &hold_time, NULL);
+        if (vfio_release_resource_lease (vfio_device, lease_id))
+        {
+            printf ("%s released lease_id %" PRIu32 "\n", arg_name, lease_id);
+        }
+        else
+        {
+            printf ("%s lease_id %" PRIu32 " expired before being released\n", arg_name, lease_id);
+        }
+    }
+    else
+    {
+        printf ("%s timed out waiting for lease after %.3f secs\n", arg_name, wait_secs);
+    }
+
+    close_vfio_devices (&vfio_devices);
+
+    return granted ? EXIT_SUCCESS : EXIT_FAILURE;
+}
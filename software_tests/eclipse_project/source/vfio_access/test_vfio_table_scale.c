@@ -0,0 +1,311 @@
+/*
+ * @file test_vfio_table_scale.c
+ * @date 18 Oct 2026
+ * @author Chester Gillon
+ * @brief Scale test for the dynamically sized device, IOMMU group and container tables in the vfio_access library
+ * @details
+ *   Populates the tables with a large number of synthetic devices, to check:
+ *   a. The tables grow beyond the number of devices in a typical PC.
+ *   b. Pointers to devices, IOMMU groups and containers remain valid as the tables grow, since other structures
+ *      (e.g. vfio_device_t.group and fpga_design_t.vfio_device) hold pointers to the table entries.
+ *   c. Random lookups by indexing the tables, as done by the VFIO multi process manager for the indices handed out to
+ *      clients, return the expected entries.
+ *
+ *   The time to populate the tables is reported for information, but isn't a pass/fail criteria since the times are
+ *   affected by the memory allocator and caching.
+ *
+ *   The synthetic devices don't open any VFIO file descriptors, so this program doesn't need any hardware.
+ */
+
+#include "vfio_access.h"
+#include "vfio_access_private.h"
+#include "transfer_timing.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <getopt.h>
+#include <inttypes.h>
+
+
+/** The command line options for this program, in the format passed to getopt_long().
+ *  Only long arguments are supported */
+static const struct option command_line_options[] =
+{
+    {"num_devices", required_argument, NULL, 0},
+    {"groups_per_container", required_argument, NULL, 0},
+    {"lookups", required_argument, NULL, 0},
+    {NULL, 0, NULL, 0}
+};
+
+
+/* Command line argument which specifies the number of synthetic devices to create, each in their own IOMMU group */
+static uint32_t arg_num_devices = 4096;
+
+
+/* Command line argument which specifies the number of IOMMU groups which share each container */
+static uint32_t arg_groups_per_container = 16;
+
+
+/* Command line argument which specifies the number of random table lookups to verify */
+static uint32_t arg_num_lookups = 1000000;
+
+
+/**
+ * @brief Display the usage for this program, and the exit
+ */
+static void display_usage (void)
+{
+    printf ("Usage:\n");
+    printf ("--num_devices <num>\n");
+    printf ("  The number of synthetic devices to create, each in their own IOMMU group.\n");
+    printf ("  Defaults to %" PRIu32 "\n", arg_num_devices);
+    printf ("--groups_per_container <num>\n");
+    printf ("  The number of IOMMU groups which share each container. Defaults to %" PRIu32 "\n", arg_groups_per_container);
+    printf ("--lookups <num>\n");
+    printf ("  The number of random table lookups to verify. Defaults to %" PRIu32 "\n", arg_num_lookups);
+
+    exit (EXIT_FAILURE);
+}
+
+
+/**
+ * @brief Parse the command line arguments, storing the results in global variables
+ * @param[in] argc, argv Command line arguments passed to the program
+ */
+static void parse_command_line_arguments (int argc, char *argv[])
+{
+    int opt_status;
+    char junk;
+
+    do
+    {
+        int option_index = 0;
+
+        opt_status = getopt_long (argc, argv, "", command_line_options, &option_index);
+        if (opt_status == '?')
+        {
+            display_usage ();
+        }
+        else if (opt_status >= 0)
+        {
+            const struct option *const optdef = &command_line_options[option_index];
+
+            if (optdef->flag != NULL)
+            {
+                /* Argument just sets a flag */
+            }
+            else if (strcmp (optdef->name, "num_devices") == 0)
+            {
+                if ((sscanf (optarg, "%" SCNu32 "%c", &arg_num_devices, &junk) != 1) || (arg_num_devices == 0))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else if (strcmp (optdef->name, "groups_per_container") == 0)
+            {
+                if ((sscanf (optarg, "%" SCNu32 "%c", &arg_groups_per_container, &junk) != 1) ||
+                    (arg_groups_per_container == 0))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else if (strcmp (optdef->name, "lookups") == 0)
+            {
+                if ((sscanf (optarg, "%" SCNu32 "%c", &arg_num_lookups, &junk) != 1) || (arg_num_lookups == 0))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else
+            {
+                /* This is a program error, and shouldn't be triggered by the command line options */
+                fprintf (stderr, "Unexpected argument definition %s\n", optdef->name);
+                exit (EXIT_FAILURE);
+            }
+        }
+    } while (opt_status != -1);
+}
+
+
+/**
+ * @brief Form the synthetic PCI device name for a device index, which spreads the devices over multiple buses
+ * @param[in] device_index The device index to form the name for
+ * @param[out] device_name The formatted device name
+ * @param[in] device_name_size The size of device_name
+ */
+static void format_synthetic_device_name (const uint32_t device_index, char *const device_name, const size_t device_name_size)
+{
+    snprintf (device_name, device_name_size, "%04x:%02x:%02x.%x",
+            device_index >> 16, (device_index >> 8) & 0xff, (device_index >> 3) & 0x1f, device_index & 0x7);
+}
+
+
+/**
+ * @brief Append one synthetic device to the tables, creating a new IOMMU group and when required a new container
+ * @param[in/out] vfio_devices The tables to append the device to
+ * @return The appended device
+ */
+static vfio_device_t *append_synthetic_device (vfio_devices_t *const vfio_devices)
+{
+    const uint32_t device_index = vfio_devices->num_devices;
+    vfio_iommu_container_t *container;
+    char iommu_group_name[32];
+
+    /* Create a new container when the previous container has the requested number of IOMMU groups */
+    if ((vfio_devices->num_containers == 0) ||
+        (vfio_devices->containers[vfio_devices->num_containers - 1]->num_iommu_groups == arg_groups_per_container))
+    {
+        container = vfio_next_free_container (vfio_devices);
+        container->vfio_devices = vfio_devices;
+        container->container_fd = -1;
+        vfio_devices->num_containers++;
+    }
+    else
+    {
+        container = vfio_devices->containers[vfio_devices->num_containers - 1];
+    }
+
+    /* Each synthetic device is in its own IOMMU group */
+    vfio_iommu_group_t *const group = vfio_next_free_iommu_group (container);
+    snprintf (iommu_group_name, sizeof (iommu_group_name), "%" PRIu32, device_index);
+    group->iommu_group_name = strdup (iommu_group_name);
+    group->group_fd = -1;
+    group->container = container;
+    container->num_iommu_groups++;
+
+    vfio_device_t *const device = vfio_next_free_device (vfio_devices);
+    format_synthetic_device_name (device_index, device->device_name, sizeof (device->device_name));
+    device->device_fd = -1;
+    device->group = group;
+    vfio_devices->num_devices++;
+
+    return device;
+}
+
+
+/**
+ * @brief Verify the contents of a synthetic device, and the IOMMU group and container it references
+ * @param[in] vfio_devices The tables containing the device
+ * @param[in] device_index Which device to verify
+ * @return Returns true if the device contents are as expected
+ */
+static bool verify_synthetic_device (const vfio_devices_t *const vfio_devices, const uint32_t device_index)
+{
+    const vfio_device_t *const device = vfio_devices->devices[device_index];
+    char expected_device_name[sizeof (device->device_name)];
+    char expected_iommu_group_name[32];
+
+    format_synthetic_device_name (device_index, expected_device_name, sizeof (expected_device_name));
+    snprintf (expected_iommu_group_name, sizeof (expected_iommu_group_name), "%" PRIu32, device_index);
+
+    const uint32_t container_index = device_index / arg_groups_per_container;
+    const uint32_t group_index = device_index % arg_groups_per_container;
+
+    return (strcmp (device->device_name, expected_device_name) == 0) &&
+            (strcmp (device->group->iommu_group_name, expected_iommu_group_name) == 0) &&
+            (device->group->container == vfio_devices->containers[container_index]) &&
+            (device->group->container->iommu_groups[group_index] == device->group) &&
+            (device->group->container->container_id == container_index);
+}
+
+
+/**
+ * @brief Verify random lookups of devices in the tables
+ * @param[in] vfio_devices The tables to perform the lookups on
+ * @param[out] num_failures Incremented for each lookup which failed verification
+ */
+static void verify_random_lookups (const vfio_devices_t *const vfio_devices, uint32_t *const num_failures)
+{
+    uint32_t seed = 1;
+
+    for (uint32_t lookup_index = 0; lookup_index < arg_num_lookups; lookup_index++)
+    {
+        /* Use a linear congruential generator to spread the lookups over the devices */
+        seed = (seed * 1664525) + 1013904223;
+
+        const uint32_t device_index = seed % vfio_devices->num_devices;
+        const vfio_device_t *const device = vfio_devices->devices[device_index];
+
+        if (device->group->container->iommu_groups[device_index % arg_groups_per_container] != device->group)
+        {
+            (*num_failures)++;
+        }
+    }
+}
+
+
+int main (int argc, char *argv[])
+{
+    vfio_devices_t vfio_devices;
+    uint32_t num_failures = 0;
+    uint32_t device_index;
+    char device_name[32];
+
+    parse_command_line_arguments (argc, argv);
+
+    /* Start with empty tables. initialise_empty_vfio_devices() isn't used, since that scans the PCI bus and
+     * detects the multi process manager, which isn't needed for synthetic devices. */
+    memset (&vfio_devices, 0, sizeof (vfio_devices));
+    vfio_devices.devices_usage = VFIO_DEVICES_USAGE_DIRECT_ACCESS;
+    vfio_devices.cmem_usage = VFIO_CMEM_USAGE_NONE;
+
+    /* The location filters use the same growth as the tables. The filters aren't applied as the PCI bus isn't scanned. */
+    for (device_index = 0; device_index < arg_num_devices; device_index++)
+    {
+        format_synthetic_device_name (device_index, device_name, sizeof (device_name));
+        vfio_add_pci_device_location_filter (device_name);
+    }
+
+    /* Populate the tables, checking the first device, IOMMU group and container don't move as the tables grow */
+    const int64_t populate_start_time = get_monotonic_time ();
+    vfio_device_t *const first_device = append_synthetic_device (&vfio_devices);
+    vfio_iommu_group_t *const first_group = first_device->group;
+    vfio_iommu_container_t *const first_container = first_group->container;
+    for (device_index = 1; device_index < arg_num_devices; device_index++)
+    {
+        (void) append_synthetic_device (&vfio_devices);
+    }
+    const int64_t populate_stop_time = get_monotonic_time ();
+
+    if ((vfio_devices.devices[0] != first_device) || (first_device->group != first_group) ||
+        (first_group->container != first_container) || (vfio_devices.containers[0] != first_container))
+    {
+        printf ("Pointers to the first device, IOMMU group or container changed as the tables grew\n");
+        num_failures++;
+    }
+
+    /* Verify the contents of all devices */
+    for (device_index = 0; device_index < vfio_devices.num_devices; device_index++)
+    {
+        if (!verify_synthetic_device (&vfio_devices, device_index))
+        {
+            printf ("Device index %" PRIu32 " has unexpected contents\n", device_index);
+            num_failures++;
+        }
+    }
+
+    printf ("Populated %" PRIu32 " devices in %" PRIu32 " containers in %.3f ms\n",
+            vfio_devices.num_devices, vfio_devices.num_containers,
+            (double) (populate_stop_time - populate_start_time) / 1E6);
+    printf ("Allocated lengths : devices %" PRIu32 " containers %" PRIu32 "\n",
+            vfio_devices.devices_allocated_length, vfio_devices.containers_allocated_length);
+
+    verify_random_lookups (&vfio_devices, &num_failures);
+
+    /* The synthetic containers don't have a container_fd to close, so only have close_vfio_devices() free the tables */
+    vfio_devices.num_containers = 0;
+    close_vfio_devices (&vfio_devices);
+    if ((vfio_devices.devices != NULL) || (vfio_devices.containers != NULL) || (vfio_devices.num_devices != 0))
+    {
+        printf ("close_vfio_devices() didn't free the tables\n");
+        num_failures++;
+    }
+
+    printf ("\nOverall %s\n", (num_failures == 0) ? "PASS" : "FAIL");
+
+    return (num_failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -121,3 +121,60 @@ void display_transfer_timing_statistics (const transfer_timing_t *const timing)
         }
     }
 }
+
+
+/**
+ * @brief qsort comparison function for latency values
+ */
+static int latency_compare (const void *const compare_a, const void *const compare_b)
+{
+    const int64_t *const latency_a = compare_a;
+    const int64_t *const latency_b = compare_b;
+
+    if (*latency_a < *latency_b)
+    {
+        return -1;
+    }
+    else if (*latency_a == *latency_b)
+    {
+        return 0;
+    }
+    else
+    {
+        return 1;
+    }
+}
+
+
+/**
+ * @brief Display the distribution of a set of latency measurements, as the min, max and selected percentiles.
+ * @details The latency measurements are sorted in place to obtain the percentiles.
+ * @param[in] latency_name Describes the latency measurements
+ * @param[in] num_samples The number of latency measurements
+ * @param[in/out] latencies_ns The latency measurements in nanoseconds, which are sorted on return
+ */
+void display_latency_distribution (const char *const latency_name,
+                                   const size_t num_samples, int64_t latencies_ns[const num_samples])
+{
+    const double reported_percentiles[] = {50.0, 99.0, 99.9};
+    const uint32_t num_percentiles = sizeof (reported_percentiles) / sizeof (reported_percentiles[0]);
+
+    printf ("%s latency for %zu samples (us):", latency_name, num_samples);
+    if (num_samples > 0)
+    {
+        qsort (latencies_ns, num_samples, sizeof (latencies_ns[0]), latency_compare);
+        printf (" min %.3f", (double) latencies_ns[0] / 1E3);
+        for (uint32_t percentile_index = 0; percentile_index < num_percentiles; percentile_index++)
+        {
+            size_t latency_index = (size_t) ((reported_percentiles[percentile_index] / 100.0) * (double) num_samples);
+
+            if (latency_index > 0)
+            {
+                latency_index--;
+            }
+            printf (" p%g %.3f", reported_percentiles[percentile_index], (double) latencies_ns[latency_index] / 1E3);
+        }
+        printf (" max %.3f", (double) latencies_ns[num_samples - 1] / 1E3);
+    }
+    printf ("\n");
+}
@@ -38,6 +38,8 @@ void initialise_transfer_timing (transfer_timing_t *const timing,
 void transfer_time_start (transfer_timing_t *const timing);
 void transfer_time_stop (transfer_timing_t *const timing);
 void display_transfer_timing_statistics (const transfer_timing_t *const timing);
+void display_latency_distribution (const char *const latency_name,
+                                   const size_t num_samples, int64_t latencies_ns[const num_samples]);
 
 
 /**
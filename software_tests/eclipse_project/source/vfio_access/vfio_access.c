@@ -12,6 +12,8 @@
 #include "vfio_access.h"
 #include "vfio_access_private.h"
 #include "pci_sysfs_access.h"
+#include "transfer_timing.h"
+#include "pcie_extended_capability.h"
 
 #include <stdlib.h>
 #include <stddef.h>
@@ -30,12 +32,37 @@
 #include <dirent.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <pthread.h>
 
 
 /* Optional filters which may be set to only open by VFIO specific PCI device(s) by location.
  * This can be used to limit which VFIO devices one process may open. */
-static vfio_pci_device_location_filter_t vfio_pci_device_location_filters[MAX_VFIO_DEVICES];
+static vfio_pci_device_location_filter_t *vfio_pci_device_location_filters;
 static uint32_t num_pci_device_location_filters;
+static uint32_t pci_device_location_filters_allocated_length;
+
+
+/* The number of threads used to zero, and therefore pre-fault, buffers before they are mapped for DMA.
+ * Using multiple threads reduces the time taken to set up large buffers. */
+static uint32_t vfio_buffer_prefault_threads = 1;
+
+
+/* The minimum number of bytes zeroed by each pre-fault thread, so the overhead of creating threads isn't incurred
+ * for small buffers */
+#define VFIO_PREFAULT_MIN_BYTES_PER_THREAD (64 * 1024 * 1024)
+
+
+/* Defines the slice of a buffer zeroed by one pre-fault thread */
+typedef struct
+{
+    /* The thread performing the zeroing */
+    pthread_t thread_id;
+    /* Set true when the thread was created and needs to be joined */
+    bool thread_created;
+    /* The start and length of the slice */
+    uint8_t *start;
+    size_t length;
+} vfio_prefault_slice_t;
 
 
 /* Controls how containers are allocated when multiple IOMMU groups are opened by the same process:
@@ -45,6 +72,46 @@ static uint32_t num_pci_device_location_filters;
 static bool vfio_isolate_iommu_groups;
 
 
+/**
+ * @brief Grow a dynamically sized array, to ensure it has at least a required length
+ * @details The allocated length is doubled as required, to give amortised O(1) cost when appending entries.
+ *          Any new entries are zero initialised, which for arrays of pointers sets the new entries to NULL.
+ *          Exits the program if unable to allocate memory.
+ * @param[in] array The array to grow, which may be NULL if not yet allocated
+ * @param[in/out] allocated_length The current allocated length of the array, updated if the array is grown
+ * @param[in] required_length The minimum length the array must have
+ * @param[in] entry_size The size of each entry in the array, in bytes
+ * @param[in] array_name Used to report an error if unable to allocate memory
+ * @return The array, which may have been moved by the growth
+ */
+void *vfio_grow_array (void *const array, uint32_t *const allocated_length, const uint32_t required_length,
+                       const size_t entry_size, const char *const array_name)
+{
+    const uint32_t initial_length = 8;
+    uint8_t *grown_array = array;
+
+    if (required_length > *allocated_length)
+    {
+        uint32_t new_length = (*allocated_length > 0) ? *allocated_length : initial_length;
+
+        while (new_length < required_length)
+        {
+            new_length *= 2;
+        }
+        grown_array = realloc (array, new_length * entry_size);
+        if (grown_array == NULL)
+        {
+            fprintf (stderr, "Failed to allocate memory for %s\n", array_name);
+            exit (EXIT_FAILURE);
+        }
+        memset (&grown_array[*allocated_length * entry_size], 0, (new_length - *allocated_length) * entry_size);
+        *allocated_length = new_length;
+    }
+
+    return grown_array;
+}
+
+
 /**
  * @brief Add an optional PCI device location filter
  * @detail This may be called before open_vfio_devices_matching_filter() to only open using VFIO specific PCI devices
@@ -55,34 +122,128 @@ void vfio_add_pci_device_location_filter (const char *const device_name)
 {
     char junk;
 
-    if (num_pci_device_location_filters < MAX_VFIO_DEVICES)
+    vfio_pci_device_location_filters = vfio_grow_array (vfio_pci_device_location_filters,
+            &pci_device_location_filters_allocated_length, num_pci_device_location_filters + 1,
+            sizeof (vfio_pci_device_location_filters[0]), "vfio_pci_device_location_filters");
+
+    vfio_pci_device_location_filter_t *const filter = &vfio_pci_device_location_filters[num_pci_device_location_filters];
+    const int num_values = sscanf (device_name, "%" SCNx32 ":%" SCNx8 ":%" SCNx8 ".%" SCNx8 "%c",
+            &filter->domain, &filter->bus, &filter->dev, &filter->func, &junk);
+
+    if (num_values == 4)
     {
-        vfio_pci_device_location_filter_t *const filter = &vfio_pci_device_location_filters[num_pci_device_location_filters];
-        const int num_values = sscanf (device_name, "%" SCNx32 ":%" SCNx8 ":%" SCNx8 ".%" SCNx8 "%c",
-                &filter->domain, &filter->bus, &filter->dev, &filter->func, &junk);
+        /* Add the filter if doesn't already exist */
+        bool filter_exists = false;
+        for (uint32_t filter_index = 0; !filter_exists && (filter_index < num_pci_device_location_filters); filter_index++)
+        {
+            const vfio_pci_device_location_filter_t *const existing = &vfio_pci_device_location_filters[filter_index];
 
-        if (num_values == 4)
+            filter_exists = (filter->domain == existing->domain) && (filter->bus == existing->bus) &&
+                    (filter->dev == existing->dev) && (filter->func == existing->func);
+        }
+        if (!filter_exists)
         {
-            /* Add the filter if doesn't already exist */
-            bool filter_exists = false;
-            for (uint32_t filter_index = 0; !filter_exists && (filter_index < num_pci_device_location_filters); filter_index++)
-            {
-                const vfio_pci_device_location_filter_t *const existing = &vfio_pci_device_location_filters[filter_index];
+            num_pci_device_location_filters++;
+        }
+    }
+    else
+    {
+        printf ("Error: Invalid PCI device location filter %s\n", device_name);
+        exit (EXIT_FAILURE);
+    }
+}
 
-                filter_exists = (filter->domain == existing->domain) && (filter->bus == existing->bus) &&
-                        (filter->dev == existing->dev) && (filter->func == existing->func);
-            }
-            if (!filter_exists)
+
+/**
+ * @brief Get the default huge page size, as reported in /proc/meminfo
+ * @return The default huge page size in bytes, or zero if unknown
+ */
+static size_t vfio_default_huge_page_size (void)
+{
+    static bool read_default_size = false;
+    static size_t default_huge_page_size = 0;
+    char line[128];
+    size_t huge_page_size_kb;
+
+    if (!read_default_size)
+    {
+        FILE *const meminfo_file = fopen ("/proc/meminfo", "r");
+
+        if (meminfo_file != NULL)
+        {
+            while (fgets (line, sizeof (line), meminfo_file) != NULL)
             {
-                num_pci_device_location_filters++;
+                if (sscanf (line, "Hugepagesize: %zu kB", &huge_page_size_kb) == 1)
+                {
+                    default_huge_page_size = huge_page_size_kb * 1024;
+                }
             }
+            fclose (meminfo_file);
         }
-        else
-        {
-            printf ("Error: Invalid PCI device location filter %s\n", device_name);
-            exit (EXIT_FAILURE);
-        }
+        read_default_size = true;
+    }
+
+    return default_huge_page_size;
+}
+
+
+/**
+ * @brief Attempt to create a memory buffer to be used for VFIO, using huge pages of a specific size
+ * @param[in/out] buffer The buffer to create. On exit buffer->vaddr is NULL if the allocation failed.
+ * @param[in] huge_page_size The huge page size to use. If zero the default huge page size is used, but the size
+ *                           isn't known to round up the mapped size.
+ * @param[in] explicit_size When true huge_page_size is encoded in the mmap() flags to select a specific size.
+ *                          When false the default huge page size is used.
+ */
+static void vfio_mmap_huge_pages (vfio_buffer_t *const buffer, const size_t huge_page_size, const bool explicit_size)
+{
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+
+    if (explicit_size)
+    {
+        /* The log2 of the huge page size is encoded in the flags */
+        flags |= __builtin_ctzll (huge_page_size) << MAP_HUGE_SHIFT;
+    }
+    buffer->huge_page_size = huge_page_size;
+    buffer->mapped_size = (huge_page_size > 0) ?
+            ((buffer->size + (huge_page_size - 1)) / huge_page_size) * huge_page_size : buffer->size;
+    buffer->vaddr = mmap (NULL, buffer->mapped_size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (buffer->vaddr == (void *) -1)
+    {
+        buffer->vaddr = NULL;
+        printf ("mmap(%zu) with huge page size %zu failed : %s\n", buffer->mapped_size, huge_page_size, strerror (errno));
+    }
+}
+
+
+/**
+ * @brief Get the name of a buffer allocation type, for use in diagnostic messages
+ * @param[in] buffer_allocation The buffer allocation type to get the name for
+ * @return The name of the buffer allocation type
+ */
+const char *vfio_buffer_allocation_name (const vfio_buffer_allocation_type_t buffer_allocation)
+{
+    switch (buffer_allocation)
+    {
+    case VFIO_BUFFER_ALLOCATION_HEAP:
+        return "heap";
+    case VFIO_BUFFER_ALLOCATION_SHARED_MEMORY:
+        return "shared_memory";
+    case VFIO_BUFFER_ALLOCATION_HUGE_PAGES:
+        return "huge_pages";
+    case VFIO_BUFFER_ALLOCATION_HUGE_PAGES_2M:
+        return "huge_pages_2M";
+    case VFIO_BUFFER_ALLOCATION_HUGE_PAGES_1G:
+        return "huge_pages_1G";
+    case VFIO_BUFFER_ALLOCATION_PHYSICAL_MEMORY_A32:
+        return "physical_memory_a32";
+    case VFIO_BUFFER_ALLOCATION_PHYSICAL_MEMORY_A64:
+        return "physical_memory_a64";
+    case VFIO_BUFFER_ALLOCATION_PEER_BAR:
+        return "peer_bar";
     }
+
+    return "unknown";
 }
 
 
@@ -102,6 +263,8 @@ void create_vfio_buffer (vfio_buffer_t *const buffer,
 
     buffer->allocation_type = buffer_allocation;
     buffer->size = size;
+    buffer->huge_page_size = 0;
+    buffer->mapped_size = size;
 
     switch (buffer->allocation_type)
     {
@@ -167,12 +330,24 @@ void create_vfio_buffer (vfio_buffer_t *const buffer,
         break;
 
     case VFIO_BUFFER_ALLOCATION_HUGE_PAGES:
-        buffer->vaddr = mmap (NULL, buffer->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
-        if (buffer->vaddr == (void *) -1)
+    case VFIO_BUFFER_ALLOCATION_HUGE_PAGES_2M:
+    case VFIO_BUFFER_ALLOCATION_HUGE_PAGES_1G:
+        buffer->vaddr = NULL;
+        if (buffer->allocation_type != VFIO_BUFFER_ALLOCATION_HUGE_PAGES)
         {
-            buffer->vaddr = NULL;
-            printf ("mmap(%zu) failed : %s\n", buffer->size, strerror (errno));
-            return;
+            const size_t explicit_huge_page_size = (buffer->allocation_type == VFIO_BUFFER_ALLOCATION_HUGE_PAGES_1G) ?
+                    (1024 * 1024 * 1024) : (2 * 1024 * 1024);
+
+            vfio_mmap_huge_pages (buffer, explicit_huge_page_size, true);
+            if (buffer->vaddr == NULL)
+            {
+                printf ("Falling back to default huge page size, as unable to allocate %zu bytes using %s\n",
+                        buffer->size, vfio_buffer_allocation_name (buffer->allocation_type));
+            }
+        }
+        if (buffer->vaddr == NULL)
+        {
+            vfio_mmap_huge_pages (buffer, vfio_default_huge_page_size (), false);
         }
         break;
 
@@ -194,6 +369,13 @@ void create_vfio_buffer (vfio_buffer_t *const buffer,
         }
 #endif
         break;
+
+    case VFIO_BUFFER_ALLOCATION_PEER_BAR:
+        /* The peer BAR is already mapped by VFIO, so there is nothing to allocate */
+        buffer->vaddr = NULL;
+        printf ("A %s buffer can't be created, use allocate_vfio_peer_bar_dma_mapping()\n",
+                vfio_buffer_allocation_name (buffer->allocation_type));
+        break;
     }
 }
 
@@ -234,19 +416,15 @@ void free_vfio_buffer (vfio_buffer_t *const buffer)
         break;
 
     case VFIO_BUFFER_ALLOCATION_HUGE_PAGES:
-        /* @todo If buffer->size is only a 4K normal page then munmap() fails with EINVAL, even though the mmap()
-         *       call succeeded with the same size.
-         *       Seen on AlmaLinux 8.7 with a 4.18.0-425.10.1.el8_7.x86_64 Kernel and 2MB huge pages.
-         *
-         *       To avoid this error would probably need to parse the actual huge page size and use that to
-         *       round-up the buffer->size.
-         *
-         *       When the program exits the huge pages are freed.
-         */
-        rc = munmap (buffer->vaddr, buffer->size);
+    case VFIO_BUFFER_ALLOCATION_HUGE_PAGES_2M:
+    case VFIO_BUFFER_ALLOCATION_HUGE_PAGES_1G:
+        /* Use the mapped size, since if buffer->size isn't a multiple of the huge page size then munmap() fails
+         * with EINVAL, even though the mmap() call succeeded with the same size.
+         * Seen on AlmaLinux 8.7 with a 4.18.0-425.10.1.el8_7.x86_64 Kernel and 2MB huge pages. */
+        rc = munmap (buffer->vaddr, buffer->mapped_size);
         if (rc != 0)
         {
-            printf ("munmap(%zu) failed : %s\n", buffer->size, strerror (errno));
+            printf ("munmap(%zu) failed : %s\n", buffer->mapped_size, strerror (errno));
             return;
         }
         break;
@@ -257,6 +435,10 @@ void free_vfio_buffer (vfio_buffer_t *const buffer)
         rc = cmem_drv_free (1, &buffer->cmem_host_buf_desc);
 #endif
         break;
+
+    case VFIO_BUFFER_ALLOCATION_PEER_BAR:
+        /* The BAR mapping is released when the peer device is closed */
+        break;
     }
 
     buffer->size = 0;
@@ -265,6 +447,122 @@ void free_vfio_buffer (vfio_buffer_t *const buffer)
 }
 
 
+/**
+ * @brief Set the number of threads used to zero, and therefore pre-fault, buffers before they are mapped for DMA
+ * @details Pre-faulting the buffer before VFIO_IOMMU_MAP_DMA means the pinning by VFIO_IOMMU_MAP_DMA doesn't take the
+ *          page faults, and the first DMA pass doesn't run against lazily faulted pages.
+ *          For multi GB buffers the zeroing is dominated by the page faults, which can be performed in parallel.
+ * @param[in] num_threads The number of threads to use. Zero is treated as one, meaning zero in the calling thread.
+ */
+void vfio_set_buffer_prefault_threads (const uint32_t num_threads)
+{
+    vfio_buffer_prefault_threads = (num_threads > 0) ? num_threads : 1;
+}
+
+
+/**
+ * @brief The thread entry point to zero one slice of a buffer
+ * @param[in/out] arg The slice to zero
+ * @return Not used
+ */
+static void *vfio_prefault_thread (void *arg)
+{
+    const vfio_prefault_slice_t *const slice = arg;
+
+    memset (slice->start, 0, slice->length);
+
+    return NULL;
+}
+
+
+/**
+ * @brief Zero a buffer, which also pre-faults the pages before the buffer is mapped for DMA
+ * @details The buffer is split into slices which are zeroed in parallel, according to vfio_buffer_prefault_threads.
+ *          The slices are aligned to the huge page size, when known, so each huge page is faulted by one thread.
+ * @param[in/out] buffer The buffer to zero
+ */
+static void vfio_prefault_buffer (vfio_buffer_t *const buffer)
+{
+    const size_t page_size = (buffer->huge_page_size > 0) ? buffer->huge_page_size : (size_t) getpagesize ();
+    const size_t max_threads = (buffer->size / VFIO_PREFAULT_MIN_BYTES_PER_THREAD) + 1;
+    const uint32_t num_slices = (vfio_buffer_prefault_threads < max_threads) ?
+            vfio_buffer_prefault_threads : (uint32_t) max_threads;
+
+    if (num_slices <= 1)
+    {
+        memset (buffer->vaddr, 0, buffer->size);
+    }
+    else
+    {
+        vfio_prefault_slice_t *const slices = calloc (num_slices, sizeof (slices[0]));
+        const size_t pages_per_slice = ((buffer->size + (page_size - 1)) / page_size + (num_slices - 1)) / num_slices;
+        const size_t bytes_per_slice = pages_per_slice * page_size;
+        uint8_t *const buffer_bytes = buffer->vaddr;
+        size_t offset = 0;
+        int rc;
+
+        if (slices == NULL)
+        {
+            printf ("Failed to allocate memory for pre-fault slices\n");
+            exit (EXIT_FAILURE);
+        }
+
+        /* Create threads for all but the first slice, which is zeroed by the calling thread.
+         * If unable to create a thread zero the slice in the calling thread. */
+        for (uint32_t slice_index = 0; slice_index < num_slices; slice_index++)
+        {
+            vfio_prefault_slice_t *const slice = &slices[slice_index];
+
+            slice->start = &buffer_bytes[offset];
+            slice->length = ((buffer->size - offset) < bytes_per_slice) ? (buffer->size - offset) : bytes_per_slice;
+            offset += slice->length;
+            if ((slice_index > 0) && (slice->length > 0))
+            {
+                rc = pthread_create (&slice->thread_id, NULL, vfio_prefault_thread, slice);
+                slice->thread_created = rc == 0;
+                if (!slice->thread_created)
+                {
+                    (void) vfio_prefault_thread (slice);
+                }
+            }
+        }
+        (void) vfio_prefault_thread (&slices[0]);
+
+        for (uint32_t slice_index = 1; slice_index < num_slices; slice_index++)
+        {
+            if (slices[slice_index].thread_created)
+            {
+                rc = pthread_join (slices[slice_index].thread_id, NULL);
+                if (rc != 0)
+                {
+                    printf ("pthread_join() failed : %s\n", strerror (rc));
+                    exit (EXIT_FAILURE);
+                }
+            }
+        }
+        free (slices);
+    }
+}
+
+
+/**
+ * @brief Display the time taken for the different stages of setting up a DMA mapping
+ * @param[in] mapping The mapping to display the setup times for
+ * @param[in] mapping_name Describes the mapping in the displayed output
+ */
+void display_vfio_dma_mapping_setup_times (const vfio_dma_mapping_t *const mapping, const char *const mapping_name)
+{
+    printf ("%s mapping of %zu bytes using %s", mapping_name, mapping->buffer.size,
+            vfio_buffer_allocation_name (mapping->buffer.allocation_type));
+    if (mapping->buffer.huge_page_size > 0)
+    {
+        printf (" (huge page size %zu)", mapping->buffer.huge_page_size);
+    }
+    printf (" : allocation %.3f ms, prefault %.3f ms, VFIO_IOMMU_MAP_DMA %.3f ms\n",
+            (double) mapping->allocation_ns / 1E6, (double) mapping->prefault_ns / 1E6, (double) mapping->map_dma_ns / 1E6);
+}
+
+
 /*
  * @brief Scan a fd directory, reporting if any of the files references an absolute pathname
  * @param[in] fd_dir_to_scan The directory to scan, which may be at either:
@@ -520,6 +818,21 @@ bool vfio_receive_manage_message (const int socket_fd, vfio_manage_messages_t *c
            valid_message = num_rx_data_bytes == sizeof (vfio_free_iova_reply_t);
            break;
 
+       case VFIO_MANAGE_MSG_ID_ACQUIRE_LEASE_REQUEST:
+           valid_message = num_rx_data_bytes == sizeof (vfio_acquire_lease_request_t);
+           break;
+
+       case VFIO_MANAGE_MSG_ID_ACQUIRE_LEASE_REPLY:
+           valid_message = num_rx_data_bytes == sizeof (vfio_acquire_lease_reply_t);
+           break;
+
+       case VFIO_MANAGE_MSG_ID_RELEASE_LEASE_REQUEST:
+           valid_message = num_rx_data_bytes == sizeof (vfio_release_lease_request_t);
+           break;
+
+       case VFIO_MANAGE_MSG_ID_RELEASE_LEASE_REPLY:
+           valid_message = num_rx_data_bytes == sizeof (vfio_release_lease_reply_t);
+           break;
 
        case VFIO_MANAGE_MSG_ID_EXCLUSIVE_ACCESS_REQUEST:
        case VFIO_MANAGE_MSG_ID_EXCLUSIVE_ACCESS_ALLOWED:
@@ -621,6 +934,22 @@ void vfio_send_manage_message (const int socket_fd, vfio_manage_messages_t *cons
         tx_iovec[0].iov_len = sizeof (vfio_free_iova_reply_t);
         break;
 
+    case VFIO_MANAGE_MSG_ID_ACQUIRE_LEASE_REQUEST:
+        tx_iovec[0].iov_len = sizeof (vfio_acquire_lease_request_t);
+        break;
+
+    case VFIO_MANAGE_MSG_ID_ACQUIRE_LEASE_REPLY:
+        tx_iovec[0].iov_len = sizeof (vfio_acquire_lease_reply_t);
+        break;
+
+    case VFIO_MANAGE_MSG_ID_RELEASE_LEASE_REQUEST:
+        tx_iovec[0].iov_len = sizeof (vfio_release_lease_request_t);
+        break;
+
+    case VFIO_MANAGE_MSG_ID_RELEASE_LEASE_REPLY:
+        tx_iovec[0].iov_len = sizeof (vfio_release_lease_reply_t);
+        break;
+
     case VFIO_MANAGE_MSG_ID_EXCLUSIVE_ACCESS_REQUEST:
     case VFIO_MANAGE_MSG_ID_EXCLUSIVE_ACCESS_ALLOWED:
     case VFIO_MANAGE_MSG_ID_EXCLUSIVE_ACCESS_COMPLETED:
@@ -1322,13 +1651,13 @@ static vfio_iommu_group_t *find_open_iommu_group (vfio_devices_t *const vfio_dev
 
     for (uint32_t container_index = 0; (iommu_group == NULL) && (container_index < vfio_devices->num_containers); container_index++)
     {
-        vfio_iommu_container_t *const container = &vfio_devices->containers[container_index];
+        vfio_iommu_container_t *const container = vfio_devices->containers[container_index];
 
         for (uint32_t group_index = 0; (iommu_group == NULL) && (group_index < container->num_iommu_groups); group_index++)
         {
-            if (strcmp (container->iommu_groups[group_index].iommu_group_name, iommu_group_name) == 0)
+            if (strcmp (container->iommu_groups[group_index]->iommu_group_name, iommu_group_name) == 0)
             {
-                iommu_group = &container->iommu_groups[group_index];
+                iommu_group = container->iommu_groups[group_index];
             }
         }
     }
@@ -1337,6 +1666,89 @@ static vfio_iommu_group_t *find_open_iommu_group (vfio_devices_t *const vfio_dev
 }
 
 
+/**
+ * @brief Get the next free container in the dynamically sized array of containers, allocating the container if required
+ * @details The container is only counted as in use once the caller increments num_containers.
+ * @param[in/out] vfio_devices Contains the array of containers to grow
+ * @return The zero initialised next free container, with the container_id set to its index in the array
+ */
+vfio_iommu_container_t *vfio_next_free_container (vfio_devices_t *const vfio_devices)
+{
+    vfio_devices->containers = vfio_grow_array (vfio_devices->containers, &vfio_devices->containers_allocated_length,
+            vfio_devices->num_containers + 1, sizeof (vfio_devices->containers[0]), "containers");
+
+    vfio_iommu_container_t **const container = &vfio_devices->containers[vfio_devices->num_containers];
+    if (*container == NULL)
+    {
+        *container = malloc (sizeof (**container));
+        if (*container == NULL)
+        {
+            fprintf (stderr, "Failed to allocate memory for container\n");
+            exit (EXIT_FAILURE);
+        }
+    }
+    memset (*container, 0, sizeof (**container));
+    (*container)->container_id = vfio_devices->num_containers;
+
+    return *container;
+}
+
+
+/**
+ * @brief Get the next free IOMMU group in the dynamically sized array of groups for a container, allocating if required
+ * @details The group is only counted as in use once the caller increments num_iommu_groups.
+ * @param[in/out] container Contains the array of IOMMU groups to grow
+ * @return The zero initialised next free IOMMU group
+ */
+vfio_iommu_group_t *vfio_next_free_iommu_group (vfio_iommu_container_t *const container)
+{
+    container->iommu_groups = vfio_grow_array (container->iommu_groups, &container->iommu_groups_allocated_length,
+            container->num_iommu_groups + 1, sizeof (container->iommu_groups[0]), "iommu_groups");
+
+    vfio_iommu_group_t **const group = &container->iommu_groups[container->num_iommu_groups];
+    if (*group == NULL)
+    {
+        *group = malloc (sizeof (**group));
+        if (*group == NULL)
+        {
+            fprintf (stderr, "Failed to allocate memory for IOMMU group\n");
+            exit (EXIT_FAILURE);
+        }
+    }
+    memset (*group, 0, sizeof (**group));
+
+    return *group;
+}
+
+
+/**
+ * @brief Get the next free device in the dynamically sized array of devices, allocating the device if required
+ * @details The device is only counted as in use once the caller increments num_devices, so the same device is returned
+ *          again if the caller fails to open the device.
+ * @param[in/out] vfio_devices Contains the array of devices to grow
+ * @return The zero initialised next free device
+ */
+vfio_device_t *vfio_next_free_device (vfio_devices_t *const vfio_devices)
+{
+    vfio_devices->devices = vfio_grow_array (vfio_devices->devices, &vfio_devices->devices_allocated_length,
+            vfio_devices->num_devices + 1, sizeof (vfio_devices->devices[0]), "devices");
+
+    vfio_device_t **const device = &vfio_devices->devices[vfio_devices->num_devices];
+    if (*device == NULL)
+    {
+        *device = malloc (sizeof (**device));
+        if (*device == NULL)
+        {
+            fprintf (stderr, "Failed to allocate memory for device\n");
+            exit (EXIT_FAILURE);
+        }
+    }
+    memset (*device, 0, sizeof (**device));
+
+    return *device;
+}
+
+
 /**
  * @brief Create an IOMMU container, which has no IOMMU groups
  * @param[in/out] vfio_devices The list of vfio devices to append the created container to.
@@ -1348,16 +1760,8 @@ static vfio_iommu_container_t *vfio_iommu_create_container (vfio_devices_t *cons
     int saved_errno;
     int api_version;
 
-    if (vfio_devices->num_containers == MAX_VFIO_DEVICES)
-    {
-        /* This shouldn't happen since the caller should have checked for exceeding the maximum number of devices */
-        fprintf (stderr, "No free containers\n");
-        exit (EXIT_FAILURE);
-    }
-
     /* Initialise to an empty container */
-    vfio_iommu_container_t *const container = &vfio_devices->containers[vfio_devices->num_containers];
-    container->container_id = vfio_devices->num_containers;
+    vfio_iommu_container_t *const container = vfio_next_free_container (vfio_devices);
     container->num_iommu_groups = 0;
     container->num_iova_regions = 0;
     container->iova_regions_allocated_length = 0;
@@ -1513,14 +1917,7 @@ static vfio_iommu_group_t *vfio_open_iommu_group (vfio_iommu_container_t *const
     int rc;
     int saved_errno;
 
-    if (container->num_iommu_groups == MAX_VFIO_DEVICES)
-    {
-        /* This shouldn't happen since the caller should have checked for exceeding the maximum number of devices */
-        printf ("Skipping %s as no free IOMMU groups\n", device_description);
-        return NULL;
-    }
-
-    vfio_iommu_group_t *const group = &container->iommu_groups[container->num_iommu_groups];
+    vfio_iommu_group_t *const group = vfio_next_free_iommu_group (container);
     group->container = container;
     group->iommu_group_name = iommu_group_name;
 
@@ -1729,7 +2126,7 @@ static void open_group_with_direct_access (vfio_devices_t *const vfio_devices, v
         if ((vfio_devices->num_containers > 0) && (!vfio_isolate_iommu_groups))
         {
             /* Use an existing container */
-            container = &vfio_devices->containers[0];
+            container = vfio_devices->containers[0];
         }
         else
         {
@@ -1779,39 +2176,46 @@ static bool open_vfio_device_with_indirect_access (vfio_devices_t *const vfio_de
     {
         if (tx_buffer.open_device_request.container_fd_required)
         {
-            /* When requested a container_fd, store the received file descriptor and the IOMMU groups the container
-             * is used on. This allows calls to find_open_iommu_group() for further opened devices to locate the information. */
-            if (vfio_devices->num_containers == MAX_VFIO_DEVICES)
-            {
-                /* This shouldn't happen since the caller should have checked for exceeding the maximum number of devices */
-                fprintf (stderr, "No free containers\n");
-                exit (EXIT_FAILURE);
-            }
-
-            /* Set the minimum container and IOMMU group information needed in the client for indirect access.
+            /* When requested a container_fd, store the IOMMU group in the container identified by the manager.
+             * This allows calls to find_open_iommu_group() for further opened devices to locate the information.
              *
+             * Set the minimum container and IOMMU group information needed in the client for indirect access.
              * For the IOMMU group only the name needs to be populated. */
-            vfio_iommu_container_t *const container = &vfio_devices->containers[vfio_devices->num_containers];
-            container->vfio_devices = vfio_devices;
-            container->iommu_type = rx_buffer.open_device_reply.iommu_type;
-            container->container_id = rx_buffer.open_device_reply.container_id;
-            container->container_fd = vfio_fds.container_fd;
-            container->num_iommu_groups = rx_buffer.open_device_reply.num_iommu_groups;
-            container->container_enabled = false;
-            for (uint32_t group_index = 0; group_index < container->num_iommu_groups; group_index++)
-            {
-                vfio_iommu_group_t *const group = &container->iommu_groups[group_index];
+            vfio_iommu_container_t *container = NULL;
 
-                group->iommu_group_name = strdup (rx_buffer.open_device_reply.iommu_group_names[group_index]);
-                group->group_fd = -1;
-                group->container = container;
-                if (strcmp (group->iommu_group_name, iommu_group_name) == 0)
+            for (uint32_t container_index = 0; (container == NULL) && (container_index < vfio_devices->num_containers);
+                 container_index++)
+            {
+                if (vfio_devices->containers[container_index]->container_id == rx_buffer.open_device_reply.container_id)
                 {
-                    new_device->group = group;
+                    container = vfio_devices->containers[container_index];
                 }
             }
 
-            vfio_devices->num_containers++;
+            if (container != NULL)
+            {
+                /* Another IOMMU group in the same container has already been opened, so the received container file
+                 * descriptor is a duplicate which isn't required. */
+                close (vfio_fds.container_fd);
+            }
+            else
+            {
+                container = vfio_next_free_container (vfio_devices);
+                container->vfio_devices = vfio_devices;
+                container->iommu_type = rx_buffer.open_device_reply.iommu_type;
+                container->container_id = rx_buffer.open_device_reply.container_id;
+                container->container_fd = vfio_fds.container_fd;
+                container->num_iommu_groups = 0;
+                container->container_enabled = false;
+                vfio_devices->num_containers++;
+            }
+
+            vfio_iommu_group_t *const group = vfio_next_free_iommu_group (container);
+            group->iommu_group_name = strdup (iommu_group_name);
+            group->group_fd = -1;
+            group->container = container;
+            container->num_iommu_groups++;
+            new_device->group = group;
         }
 
         /* Store the device file descriptor to access the device, and get the information */
@@ -1847,7 +2251,7 @@ static uint32_t vfio_extract_pci_field (const uint32_t register_value, const uin
  * @param[out] capability_pointer The capability pointer read from the PCI configuration space of the device
  * @return Returns true when have read the capability pointer.
  */
-static bool vfio_get_pcie_capability_pointer (vfio_device_t *const vfio_device, uint8_t *const capability_pointer)
+bool vfio_get_pcie_capability_pointer (vfio_device_t *const vfio_device, uint8_t *const capability_pointer)
 {
     bool been_hear[256] = {false};
     bool success;
@@ -1885,6 +2289,39 @@ static bool vfio_get_pcie_capability_pointer (vfio_device_t *const vfio_device,
 }
 
 
+/**
+ * @brief The pcie_config_read_u32_t function used to search the extended capabilities of a VFIO device
+ * @param[in/out] device The VFIO device to read the configuration space of
+ * @param[in] offset The offset of the dword to read
+ * @param[out] value The dword read
+ * @return Returns true if the read was successful
+ */
+static bool vfio_find_pcie_extended_capability_read_u32 (void *const device, const uint32_t offset, uint32_t *const value)
+{
+    return vfio_read_pci_config_u32 (device, offset, value);
+}
+
+
+/**
+ * @brief Find a PCIe extended capability for a VFIO device
+ * @details The extended capabilities start at offset PCI_CFG_SPACE_SIZE in the PCI configuration space, and are only
+ *          present for PCIe devices.
+ * @param[in] vfio_device The device to search the extended capabilities of
+ * @param[in] capability_id The PCI_EXT_CAP_ID_* to search for
+ * @param[out] capability_offset The offset in the PCI configuration space of the header of the extended capability
+ * @return Returns true when the extended capability has been found.
+ */
+bool vfio_find_pcie_extended_capability (vfio_device_t *const vfio_device, const uint16_t capability_id,
+                                         uint32_t *const capability_offset)
+{
+    uint8_t pcie_capability_pointer;
+
+    return vfio_get_pcie_capability_pointer (vfio_device, &pcie_capability_pointer) &&
+            pcie_find_extended_capability (vfio_find_pcie_extended_capability_read_u32, vfio_device, capability_id,
+                    capability_offset);
+}
+
+
 /**
  * @brief Display an enumeration
  * @param[in] enums_array_size The size of the enumeration array
@@ -1969,7 +2406,7 @@ static void vfio_warn_if_device_limited_bandwidth (vfio_device_t *const vfio_dev
 vfio_device_t *open_vfio_device (vfio_devices_t *const vfio_devices, struct pci_dev *const pci_dev,
                                  const vfio_device_dma_capability_t dma_capability)
 {
-    vfio_device_t *const new_device = &vfio_devices->devices[vfio_devices->num_devices];
+    vfio_device_t *const new_device = vfio_next_free_device (vfio_devices);
 
     /* Check the PCI device has an IOMMU group. */
     snprintf (new_device->device_name, sizeof (new_device->device_name), "%04x:%02x:%02x.%x",
@@ -2190,7 +2627,7 @@ void open_vfio_devices_matching_filter (vfio_devices_t *const vfio_devices,
 
     /* Open the PCI devices which match the filters and have an IOMMU group assigned */
     const int required_fields = PCI_FILL_IDENT;
-    for (dev = vfio_devices->pacc->devices; (dev != NULL) && (vfio_devices->num_devices < MAX_VFIO_DEVICES); dev = dev->next)
+    for (dev = vfio_devices->pacc->devices; dev != NULL; dev = dev->next)
     {
         known_fields = pci_fill_info (dev, required_fields);
         if ((known_fields & required_fields) == required_fields)
@@ -2264,7 +2701,7 @@ vfio_device_t *append_vfio_device (vfio_devices_t *const vfio_devices, struct pc
     /* Search for the requested device already have been opened */
     for (uint32_t device_index = 0; (opened_device == NULL) && (device_index < vfio_devices->num_devices); device_index++)
     {
-        vfio_device_t *const existing_device = &vfio_devices->devices[device_index];
+        vfio_device_t *const existing_device = vfio_devices->devices[device_index];
 
         if ((pci_dev->domain == existing_device->pci_dev->domain) && (pci_dev->bus == existing_device->pci_dev->bus) &&
             (pci_dev->dev == existing_device->pci_dev->dev) && (pci_dev->func == existing_device->pci_dev->func))
@@ -2273,7 +2710,7 @@ vfio_device_t *append_vfio_device (vfio_devices_t *const vfio_devices, struct pc
         }
     }
 
-    if ((opened_device == NULL) && (vfio_devices->num_devices < MAX_VFIO_DEVICES))
+    if (opened_device == NULL)
     {
         /* Device not already open, so attempt to open it */
         opened_device = open_vfio_device (vfio_devices, pci_dev, dma_capability);
@@ -2305,7 +2742,7 @@ static void close_vfio_container (vfio_iommu_container_t *const container)
     /* Close the IOMMU groups in the container */
     for (uint32_t group_index = 0; group_index < container->num_iommu_groups; group_index++)
     {
-        vfio_iommu_group_t *const group = &container->iommu_groups[group_index];
+        vfio_iommu_group_t *const group = container->iommu_groups[group_index];
 
         if (group->group_fd != -1)
         {
@@ -2345,7 +2782,7 @@ void close_vfio_devices (vfio_devices_t *const vfio_devices)
     /* Close the VFIO devices, including unmapping their bars */
     for (uint32_t device_index = 0; device_index < vfio_devices->num_devices; device_index++)
     {
-        vfio_device_t *const vfio_device = &vfio_devices->devices[device_index];
+        vfio_device_t *const vfio_device = vfio_devices->devices[device_index];
 
         for (int bar_index = 0; bar_index < PCI_STD_NUM_BARS; bar_index++)
         {
@@ -2401,10 +2838,38 @@ void close_vfio_devices (vfio_devices_t *const vfio_devices)
     /* Close the containers */
     for (uint32_t container_index = 0; container_index < vfio_devices->num_containers; container_index++)
     {
-        close_vfio_container (&vfio_devices->containers[container_index]);
+        close_vfio_container (vfio_devices->containers[container_index]);
     }
     vfio_devices->num_containers = 0;
 
+    /* Free the dynamically allocated tables. The entries are freed individually, since the entries are allocated
+     * individually to keep pointers to the entries valid as the tables grow. */
+    for (uint32_t device_index = 0; device_index < vfio_devices->devices_allocated_length; device_index++)
+    {
+        free (vfio_devices->devices[device_index]);
+    }
+    free (vfio_devices->devices);
+    vfio_devices->devices = NULL;
+    vfio_devices->devices_allocated_length = 0;
+    vfio_devices->num_devices = 0;
+    for (uint32_t container_index = 0; container_index < vfio_devices->containers_allocated_length; container_index++)
+    {
+        vfio_iommu_container_t *const container = vfio_devices->containers[container_index];
+
+        if (container != NULL)
+        {
+            for (uint32_t group_index = 0; group_index < container->iommu_groups_allocated_length; group_index++)
+            {
+                free (container->iommu_groups[group_index]);
+            }
+            free (container->iommu_groups);
+            free (container);
+        }
+    }
+    free (vfio_devices->containers);
+    vfio_devices->containers = NULL;
+    vfio_devices->containers_allocated_length = 0;
+
 #ifdef HAVE_CMEM
     /* Close the cmem driver if it has been opened */
     if (vfio_devices->cmem_usage == VFIO_CMEM_USAGE_DRIVER_OPEN)
@@ -2558,6 +3023,9 @@ void allocate_vfio_container_dma_mapping (vfio_iommu_container_t *const containe
 
     mapping->container = container;
     mapping->num_allocated_bytes = 0;
+    mapping->allocation_ns = 0;
+    mapping->prefault_ns = 0;
+    mapping->map_dma_ns = 0;
     if (container->iommu_type == VFIO_NOIOMMU_IOMMU)
     {
         /* In NOIOMMU mode allocate IOVA using the contiguous physical memory cmem driver.
@@ -2593,13 +3061,17 @@ void allocate_vfio_container_dma_mapping (vfio_iommu_container_t *const containe
 
             /* cmem driver is open, so attempt the allocation and use the allocated physical memory address as the IOVA
              * to be used for DMA. */
+            const int64_t allocation_start_time = get_monotonic_time ();
             create_vfio_buffer (&mapping->buffer, aligned_size,
                     (dma_capability == VFIO_DEVICE_DMA_CAPABILITY_A64) ?
                             VFIO_BUFFER_ALLOCATION_PHYSICAL_MEMORY_A64 : VFIO_BUFFER_ALLOCATION_PHYSICAL_MEMORY_A32, NULL);
+            const int64_t allocation_end_time = get_monotonic_time ();
+            mapping->allocation_ns = allocation_end_time - allocation_start_time;
             mapping->iova = mapping->buffer.cmem_host_buf_desc.physAddr;
             if (mapping->buffer.vaddr != NULL)
             {
-                memset (mapping->buffer.vaddr, 0, mapping->buffer.size);
+                vfio_prefault_buffer (&mapping->buffer);
+                mapping->prefault_ns = get_monotonic_time () - allocation_end_time;
             }
         }
 #endif
@@ -2628,11 +3100,17 @@ void allocate_vfio_container_dma_mapping (vfio_iommu_container_t *const containe
             /* Create the buffer in the local process.
              * Since multiple containers may be in use, prepends the PID to make the name unique */
             snprintf (name_suffix, sizeof (name_suffix), "pid-%d_iova-%" PRIu64, getpid(), mapping->iova);
+            const int64_t allocation_start_time = get_monotonic_time ();
             create_vfio_buffer (&mapping->buffer, aligned_size, buffer_allocation, name_suffix);
+            const int64_t allocation_end_time = get_monotonic_time ();
+            mapping->allocation_ns = allocation_end_time - allocation_start_time;
 
             if (mapping->buffer.vaddr != NULL)
             {
-                memset (mapping->buffer.vaddr, 0, mapping->buffer.size);
+                vfio_prefault_buffer (&mapping->buffer);
+                const int64_t prefault_end_time = get_monotonic_time ();
+                mapping->prefault_ns = prefault_end_time - allocation_end_time;
+
                 memset (&dma_map, 0, sizeof (dma_map));
                 dma_map.argsz = sizeof (dma_map);
                 dma_map.flags = permission;
@@ -2640,10 +3118,11 @@ void allocate_vfio_container_dma_mapping (vfio_iommu_container_t *const containe
                 dma_map.iova = mapping->iova;
                 dma_map.size = mapping->buffer.size;
                 rc = ioctl (container->container_fd, VFIO_IOMMU_MAP_DMA, &dma_map);
+                mapping->map_dma_ns = get_monotonic_time () - prefault_end_time;
                 if (rc != 0)
                 {
                     printf ("VFIO_IOMMU_MAP_DMA of size %zu failed : %s\n", mapping->buffer.size, strerror (-rc));
-                    free (mapping->buffer.vaddr);
+                    free_vfio_buffer (&mapping->buffer);
                     mapping->buffer.vaddr = NULL;
                 }
             }
@@ -2803,6 +3282,243 @@ void free_vfio_dma_mapping (vfio_dma_mapping_t *const mapping)
     }
 }
 
+/**
+ * @brief Create a DMA mapping which allows one device to perform peer-to-peer DMA to a memory BAR of another device
+ * @details The BAR of the peer device, as mapped into the process by VFIO, is mapped into the IOMMU container used by
+ *          the initiator device. The resulting mapping can be used as the data_mapping for the DMA transfers of the
+ *          initiator, where the buffer virtual address gives PIO access to the peer BAR.
+ *
+ *          Requires:
+ *          a. An IOMMU, since in NOIOMMU mode the IOVA isn't allocated by this library.
+ *          b. The initiator and peer devices to be in the same IOMMU container.
+ *          c. The PCIe topology to route peer-to-peer transactions between the devices. If ACS redirects the transactions
+ *             via the root complex, the root complex also needs to support peer-to-peer.
+ *
+ *          Doesn't prefault the buffer, since that would zero the contents of the peer BAR.
+ * @param[in/out] initiator_device The device which will perform the DMA
+ * @param[in/out] peer_device The device which contains the BAR which is the target of the DMA
+ * @param[in] peer_bar_index Which BAR of the peer device to map
+ * @param[out] mapping Contains the peer BAR and associated DMA mapping. On failure, mapping->buffer.vaddr is NULL.
+ * @param[in] permission Bitwise OR VFIO_DMA_MAP_FLAG_READ / VFIO_DMA_MAP_FLAG_WRITE flags to define
+ *                       the initiator access to the peer BAR.
+ */
+void allocate_vfio_peer_bar_dma_mapping (vfio_device_t *const initiator_device, vfio_device_t *const peer_device,
+                                         const uint32_t peer_bar_index, vfio_dma_mapping_t *const mapping,
+                                         const uint32_t permission)
+{
+    vfio_iommu_container_t *const container = initiator_device->group->container;
+    struct vfio_iommu_type1_dma_map dma_map;
+    vfio_iova_region_t region;
+    int rc;
+
+    memset (mapping, 0, sizeof (*mapping));
+    mapping->container = container;
+    mapping->buffer.allocation_type = VFIO_BUFFER_ALLOCATION_PEER_BAR;
+    mapping->buffer.vaddr = NULL;
+    mapping->buffer.fd = -1;
+
+    if (container->iommu_type == VFIO_NOIOMMU_IOMMU)
+    {
+        printf ("Peer-to-peer DMA from %s not supported in NOIOMMU mode\n", initiator_device->device_name);
+        return;
+    }
+
+    if (peer_device->group->container != container)
+    {
+        printf ("Peer-to-peer DMA not supported as %s and %s are not in the same IOMMU container\n",
+                initiator_device->device_name, peer_device->device_name);
+        return;
+    }
+
+    if (peer_bar_index >= PCI_STD_NUM_BARS)
+    {
+        printf ("Invalid BAR %" PRIu32 " for peer-to-peer DMA\n", peer_bar_index);
+        return;
+    }
+
+    map_vfio_device_bar_before_use (peer_device, peer_bar_index);
+    if (peer_device->mapped_bars[peer_bar_index] == NULL)
+    {
+        printf ("Peer-to-peer DMA not supported as BAR %" PRIu32 " of %s can't be mapped\n",
+                peer_bar_index, peer_device->device_name);
+        return;
+    }
+    const size_t bar_size = peer_device->regions_info[peer_bar_index].size;
+    if ((bar_size % (size_t) getpagesize ()) != 0)
+    {
+        /* Prevents the IOVA allocation being rounded up to more than the size of the BAR which can be mapped */
+        printf ("Peer-to-peer DMA not supported as BAR %" PRIu32 " of %s size %zu isn't a multiple of the page size\n",
+                peer_bar_index, peer_device->device_name, bar_size);
+        return;
+    }
+
+    if (container->vfio_devices->devices_usage == VFIO_DEVICES_USAGE_INDIRECT_ACCESS)
+    {
+        allocate_iova_region_indirect (container, initiator_device->dma_capability, bar_size, &region);
+    }
+    else
+    {
+        const uint32_t unused_client_id = 0;
+        allocate_iova_region_direct (container, initiator_device->dma_capability, bar_size, unused_client_id, &region);
+    }
+    if (!region.allocated)
+    {
+        printf ("Failed to allocate IOVA for %zu bytes of peer BAR\n", bar_size);
+        return;
+    }
+
+    mapping->iova = region.start;
+    mapping->buffer.size = bar_size;
+    mapping->buffer.mapped_size = bar_size;
+
+    memset (&dma_map, 0, sizeof (dma_map));
+    dma_map.argsz = sizeof (dma_map);
+    dma_map.flags = permission;
+    dma_map.vaddr = (uintptr_t) peer_device->mapped_bars[peer_bar_index];
+    dma_map.iova = mapping->iova;
+    dma_map.size = bar_size;
+    const int64_t map_start_time = get_monotonic_time ();
+    rc = ioctl (container->container_fd, VFIO_IOMMU_MAP_DMA, &dma_map);
+    mapping->map_dma_ns = get_monotonic_time () - map_start_time;
+    if (rc == 0)
+    {
+        mapping->buffer.vaddr = peer_device->mapped_bars[peer_bar_index];
+    }
+    else
+    {
+        printf ("VFIO_IOMMU_MAP_DMA of BAR %" PRIu32 " of %s failed : %s\n",
+                peer_bar_index, peer_device->device_name, strerror (errno));
+
+        /* Release the IOVA allocation, since unlike a buffer allocation the caller doesn't call free_vfio_dma_mapping()
+         * on failure */
+        region.allocated = false;
+        if (container->vfio_devices->devices_usage == VFIO_DEVICES_USAGE_INDIRECT_ACCESS)
+        {
+            free_vfio_region_indirect (container, &region);
+        }
+        else
+        {
+            update_iova_regions (container, &region);
+        }
+    }
+}
+
+
+/**
+ * @brief Get the name of a type of resource which can be leased, for diagnostic messages
+ * @param[in] resource_type The resource type to get the name for
+ * @return The name of the resource type
+ */
+const char *vfio_resource_type_name (const vfio_resource_type_t resource_type)
+{
+    switch (resource_type)
+    {
+    case VFIO_RESOURCE_DMA_H2C_CHANNEL:
+        return "DMA H2C channel";
+    case VFIO_RESOURCE_DMA_C2H_CHANNEL:
+        return "DMA C2H channel";
+    case VFIO_RESOURCE_QUAD_SPI:
+        return "Quad SPI";
+    case VFIO_RESOURCE_IIC:
+        return "IIC";
+    case VFIO_RESOURCE_CMAC_PORT:
+        return "CMAC port";
+    case VFIO_RESOURCE_TYPE_ARRAY_SIZE:
+        break;
+    }
+
+    return "unknown";
+}
+
+
+/**
+ * @brief Acquire a lease on one resource of a VFIO device, to arbitrate access with other processes using the device
+ * @details The arbitration is performed by the VFIO multi process manager, and is cooperative in that it relies upon all
+ *          processes which access the resource acquiring a lease first.
+ *
+ *          When the resource is leased by another client, the requests are queued by the manager and granted in FIFO order.
+ *          This call blocks until either the lease is granted or wait_timeout_ns expires.
+ *
+ *          Acquiring a lease on a resource which the calling process already holds renews the lease, using the existing
+ *          lease_id, which allows a long running process to extend a lease with a finite duration.
+ *
+ *          When the VFIO device wasn't opened via the manager the process already has exclusive use of the device,
+ *          so the lease is always granted.
+ * @param[in/out] vfio_device The device containing the resource
+ * @param[in] resource_type The type of resource to lease
+ * @param[in] resource_index Identifies the instance of the resource type within the device
+ * @param[in] lease_duration_ns How long the lease is granted for, after which the manager may grant the resource
+ *                              to another client. VFIO_RESOURCE_LEASE_INFINITE_NS means hold until released.
+ * @param[in] wait_timeout_ns How long to wait for the resource when leased by another client.
+ *                            VFIO_RESOURCE_LEASE_INFINITE_NS means wait forever.
+ * @param[out] lease_id When the lease is granted identifies the lease, to pass to vfio_release_resource_lease()
+ * @return Returns true if the lease was granted, or false if timed out waiting for the resource
+ */
+bool vfio_acquire_resource_lease (vfio_device_t *const vfio_device,
+                                  const vfio_resource_type_t resource_type, const uint32_t resource_index,
+                                  const uint64_t lease_duration_ns, const uint64_t wait_timeout_ns,
+                                  uint32_t *const lease_id)
+{
+    vfio_devices_t *const vfio_devices = vfio_device->group->container->vfio_devices;
+    vfio_manage_messages_t tx_buffer;
+    vfio_manage_messages_t rx_buffer;
+
+    *lease_id = 0;
+    if (vfio_devices->devices_usage != VFIO_DEVICES_USAGE_INDIRECT_ACCESS)
+    {
+        return true;
+    }
+
+    tx_buffer.acquire_lease_request.msg_id = VFIO_MANAGE_MSG_ID_ACQUIRE_LEASE_REQUEST;
+    tx_buffer.acquire_lease_request.device_id.domain = vfio_device->pci_dev->domain;
+    tx_buffer.acquire_lease_request.device_id.bus    = vfio_device->pci_dev->bus;
+    tx_buffer.acquire_lease_request.device_id.dev    = vfio_device->pci_dev->dev;
+    tx_buffer.acquire_lease_request.device_id.func   = vfio_device->pci_dev->func;
+    tx_buffer.acquire_lease_request.resource_type = resource_type;
+    tx_buffer.acquire_lease_request.resource_index = resource_index;
+    tx_buffer.acquire_lease_request.lease_duration_ns = lease_duration_ns;
+    tx_buffer.acquire_lease_request.wait_timeout_ns = wait_timeout_ns;
+    vfio_send_manage_message (vfio_devices->manager_client_socket_fd, &tx_buffer, NULL);
+
+    /* Wait for the lease to be granted, or the wait to time out */
+    vfio_receive_manage_reply (vfio_devices->manager_client_socket_fd, &rx_buffer, NULL,
+            VFIO_MANAGE_MSG_ID_ACQUIRE_LEASE_REPLY);
+    if (rx_buffer.acquire_lease_reply.success)
+    {
+        *lease_id = rx_buffer.acquire_lease_reply.lease_id;
+    }
+
+    return rx_buffer.acquire_lease_reply.success;
+}
+
+
+/**
+ * @brief Release a lease previously granted by vfio_acquire_resource_lease()
+ * @param[in/out] vfio_device The device containing the resource
+ * @param[in] lease_id Identifies the lease to release
+ * @return Returns true if the lease was still held, or false if the lease had expired before being released.
+ *         Expiry means the manager may have granted the resource to another client while this process was still using it.
+ */
+bool vfio_release_resource_lease (vfio_device_t *const vfio_device, const uint32_t lease_id)
+{
+    vfio_devices_t *const vfio_devices = vfio_device->group->container->vfio_devices;
+    vfio_manage_messages_t tx_buffer;
+    vfio_manage_messages_t rx_buffer;
+
+    if (vfio_devices->devices_usage != VFIO_DEVICES_USAGE_INDIRECT_ACCESS)
+    {
+        return true;
+    }
+
+    tx_buffer.release_lease_request.msg_id = VFIO_MANAGE_MSG_ID_RELEASE_LEASE_REQUEST;
+    tx_buffer.release_lease_request.lease_id = lease_id;
+    vfio_send_manage_message (vfio_devices->manager_client_socket_fd, &tx_buffer, NULL);
+    vfio_receive_manage_reply (vfio_devices->manager_client_socket_fd, &rx_buffer, NULL,
+            VFIO_MANAGE_MSG_ID_RELEASE_LEASE_REPLY);
+
+    return rx_buffer.release_lease_reply.success;
+}
+
 
 /**
  * @brief Read a number of bytes from a PCI region of a VFIO device
@@ -20,10 +20,6 @@
 #endif
 
 
-/* The maximum number of VFIO devices this API can open. Also used to size other arrays which may be per device */
-#define MAX_VFIO_DEVICES 8
-
-
 /* Defines the option used to allocate a buffer used for VFIO DMA */
 typedef enum
 {
@@ -33,12 +29,21 @@ typedef enum
     VFIO_BUFFER_ALLOCATION_SHARED_MEMORY,
     /* Allocate the buffer using huge pages (of the default huge page size), when using an IOMMU */
     VFIO_BUFFER_ALLOCATION_HUGE_PAGES,
+    /* Allocate the buffer using huge pages of an explicit size, when using an IOMMU.
+     * If no huge pages of the explicit size are available, reports a diagnostic and falls back to using
+     * the default huge page size. */
+    VFIO_BUFFER_ALLOCATION_HUGE_PAGES_2M,
+    VFIO_BUFFER_ALLOCATION_HUGE_PAGES_1G,
     /* Allocate the buffer using a physical contiguous memory allocator, when using NOIOMMU:
      * - VFIO_BUFFER_ALLOCATION_PHYSICAL_MEMORY_A32 allocates physical addresses in the first 4 GiB,
      *   for DMA devices which can only address 32-bits.
      * - VFIO_BUFFER_ALLOCATION_PHYSICAL_MEMORY_A64 allocates any possible physical addresses */
     VFIO_BUFFER_ALLOCATION_PHYSICAL_MEMORY_A32,
-    VFIO_BUFFER_ALLOCATION_PHYSICAL_MEMORY_A64
+    VFIO_BUFFER_ALLOCATION_PHYSICAL_MEMORY_A64,
+    /* The buffer is a memory BAR of a peer device which has been mapped by VFIO, used as the target for peer-to-peer DMA.
+     * No memory is allocated, and the BAR mapping remains owned by the peer device. Only created by
+     * allocate_vfio_peer_bar_dma_mapping(). */
+    VFIO_BUFFER_ALLOCATION_PEER_BAR
 } vfio_buffer_allocation_type_t;
 
 
@@ -55,6 +60,11 @@ typedef struct
     char pathname[PATH_MAX];
     /* For VFIO_BUFFER_ALLOCATION_SHARED_MEMORY the file descriptor of the POSIX shared memory file */
     int fd;
+    /* For the huge page allocations the huge page size actually used, and the size of the memory mapping which is
+     * the size rounded up to a multiple of the huge page size. munmap() requires the length to be a multiple of the
+     * huge page size. */
+    size_t huge_page_size;
+    size_t mapped_size;
 #ifdef HAVE_CMEM
     /* For VFIO_BUFFER_ALLOCATION_PHYSICAL_MEMORY_A32 and VFIO_BUFFER_ALLOCATION_PHYSICAL_MEMORY_A64
      * the buffer allocated in physically contiguous memory */
@@ -111,7 +121,7 @@ typedef struct vfio_iommu_container_s
     int container_fd;
     /* The identity of the container. This is to support indirect IOVA allocations:
      * a. For VFIO_DEVICES_USAGE_DIRECT_ACCESS or VFIO_DEVICES_USAGE_MANAGER this is the index into the
-     *    local vfio_devices->container[] array.
+     *    local vfio_devices->containers[] array.
      * b. For VFIO_DEVICES_USAGE_INDIRECT_ACCESS this is index into the containers[] array on the manager.
      *    This client might not be use all possible containers. */
     uint32_t container_id;
@@ -124,8 +134,11 @@ typedef struct vfio_iommu_container_s
     struct vfio_iommu_type1_info *iommu_info;
     /* The number of IOMMU groups the container is used on */
     uint32_t num_iommu_groups;
-    /* The IOMMU groups the container is used on */
-    vfio_iommu_group_t iommu_groups[MAX_VFIO_DEVICES];
+    /* Dynamically sized array of the IOMMU groups the container is used on.
+     * Each group is allocated separately so that pointers to a group remain valid as the array grows. */
+    vfio_iommu_group_t **iommu_groups;
+    /* The current allocated length of the iommu_groups[] array, dynamically grown as required */
+    uint32_t iommu_groups_allocated_length;
     /* Dynamically sized array of IOVA regions used to perform IOVA allocations in order to:
      * a. Only allocate from valid region. I.e. excludes reserved regions.
      * b. Support allocations for both VFIO_DEVICE_DMA_CAPABILITY_A32 and VFIO_DEVICE_DMA_CAPABILITY_A64
@@ -252,16 +265,22 @@ typedef struct vfio_devices_s
     vfio_cmem_usage_t cmem_usage;
     /* The number of IOMMU containers which have been created */
     uint32_t num_containers;
-    /* The IOMMU containers which have been created */
-    vfio_iommu_container_t containers[MAX_VFIO_DEVICES];
+    /* Dynamically sized array of the IOMMU containers which have been created, indexed by container_id.
+     * Each container is allocated separately so that pointers to a container remain valid as the array grows. */
+    vfio_iommu_container_t **containers;
+    /* The current allocated length of the containers[] array, dynamically grown as required */
+    uint32_t containers_allocated_length;
     /* How the devices are used by the local process */
     vfio_devices_usage_t devices_usage;
     /* For VFIO_DEVICES_USAGE_INDIRECT_ACCESS the socket file descriptor used to communicate with the manager */
     int manager_client_socket_fd;
     /* The number of devices which have been opened */
     uint32_t num_devices;
-    /* The devices which have been opened */
-    vfio_device_t devices[MAX_VFIO_DEVICES];
+    /* Dynamically sized array of the devices which have been opened.
+     * Each device is allocated separately so that pointers to a device remain valid as the array grows. */
+    vfio_device_t **devices;
+    /* The current allocated length of the devices[] array, dynamically grown as required */
+    uint32_t devices_allocated_length;
 } vfio_devices_t;
 
 
@@ -302,14 +321,49 @@ typedef struct
     size_t num_allocated_bytes;
     /* The IOMMU container for freeing mappings */
     vfio_iommu_container_t *container;
+    /* The time taken for the different stages of setting up the mapping, to allow the setup time for large buffers
+     * to be measured:
+     * - allocation_ns : creating the buffer in the process virtual address space.
+     * - prefault_ns : zeroing the buffer, which faults in the pages before VFIO_IOMMU_MAP_DMA.
+     * - map_dma_ns : VFIO_IOMMU_MAP_DMA, which pins the pages and creates the IOMMU mapping.
+     *   The kernel performs the pinning and mapping in the same ioctl, so can't be timed separately. */
+    int64_t allocation_ns;
+    int64_t prefault_ns;
+    int64_t map_dma_ns;
 } vfio_dma_mapping_t;
 
 
+/* Identifies the types of resource in a FPGA design which clients of the VFIO multi process manager can lease,
+ * to arbitrate access between processes which share the same device. The resource index within a device is:
+ * - For DMA channels the channel number.
+ * - For the CMAC the port number.
+ * - Otherwise zero, unless a design contains multiple instances of the resource. */
+typedef enum
+{
+    VFIO_RESOURCE_DMA_H2C_CHANNEL,
+    VFIO_RESOURCE_DMA_C2H_CHANNEL,
+    VFIO_RESOURCE_QUAD_SPI,
+    VFIO_RESOURCE_IIC,
+    VFIO_RESOURCE_CMAC_PORT,
+
+    VFIO_RESOURCE_TYPE_ARRAY_SIZE
+} vfio_resource_type_t;
+
+
+/* Used for the lease duration or wait timeout when requesting a resource lease, to mean no time limit */
+#define VFIO_RESOURCE_LEASE_INFINITE_NS UINT64_MAX
+
+
+void *vfio_grow_array (void *const array, uint32_t *const allocated_length, const uint32_t required_length,
+                       const size_t entry_size, const char *const array_name);
 void vfio_add_pci_device_location_filter (const char *const device_name);
 void create_vfio_buffer (vfio_buffer_t *const buffer,
                          const size_t size, const vfio_buffer_allocation_type_t buffer_allocation,
                          const char *const name_suffix);
 void free_vfio_buffer (vfio_buffer_t *const buffer);
+void vfio_set_buffer_prefault_threads (const uint32_t num_threads);
+const char *vfio_buffer_allocation_name (const vfio_buffer_allocation_type_t buffer_allocation);
+void display_vfio_dma_mapping_setup_times (const vfio_dma_mapping_t *const mapping, const char *const mapping_name);
 void get_vfio_device_region (vfio_device_t *const vfio_device, const uint32_t region_index);
 void map_vfio_device_bar_before_use (vfio_device_t *const vfio_device, const uint32_t bar_index);
 uint8_t *map_vfio_registers_block (vfio_device_t *const vfio_device, const uint32_t bar_index,
@@ -330,6 +384,9 @@ void allocate_vfio_container_dma_mapping (vfio_iommu_container_t *const containe
                                           vfio_dma_mapping_t *const mapping,
                                           const size_t requested_size, const uint32_t permission,
                                           const vfio_buffer_allocation_type_t buffer_allocation);
+void allocate_vfio_peer_bar_dma_mapping (vfio_device_t *const initiator_device, vfio_device_t *const peer_device,
+                                         const uint32_t peer_bar_index, vfio_dma_mapping_t *const mapping,
+                                         const uint32_t permission);
 void allocate_vfio_dma_mapping (vfio_device_t *const vfio_device,
                                 vfio_dma_mapping_t *const mapping,
                                 const size_t requested_size, const uint32_t permission,
@@ -338,6 +395,12 @@ void *vfio_dma_mapping_allocate_space (vfio_dma_mapping_t *const mapping,
                                        const size_t allocation_size, uint64_t *const allocated_iova);
 void vfio_dma_mapping_align_space (vfio_dma_mapping_t *const mapping);
 void free_vfio_dma_mapping (vfio_dma_mapping_t *const mapping);
+const char *vfio_resource_type_name (const vfio_resource_type_t resource_type);
+bool vfio_acquire_resource_lease (vfio_device_t *const vfio_device,
+                                  const vfio_resource_type_t resource_type, const uint32_t resource_index,
+                                  const uint64_t lease_duration_ns, const uint64_t wait_timeout_ns,
+                                  uint32_t *const lease_id);
+bool vfio_release_resource_lease (vfio_device_t *const vfio_device, const uint32_t lease_id);
 bool vfio_read_pci_region_bytes (vfio_device_t *const vfio_device, const uint32_t region_index,
                                  const uint32_t offset, const size_t num_bytes, void *const config_bytes);
 bool vfio_write_pci_region_bytes (vfio_device_t *const vfio_device, const uint32_t region_index,
@@ -348,6 +411,9 @@ bool vfio_read_pci_config_u32 (vfio_device_t *const vfio_device, const uint32_t
 bool vfio_write_pci_config_u8 (vfio_device_t *const vfio_device, const uint32_t offset, const uint8_t value);
 bool vfio_write_pci_config_u16 (vfio_device_t *const vfio_device, const uint32_t offset, const uint16_t value);
 bool vfio_write_pci_config_u32 (vfio_device_t *const vfio_device, const uint32_t offset, const uint32_t value);
+bool vfio_get_pcie_capability_pointer (vfio_device_t *const vfio_device, uint8_t *const capability_pointer);
+bool vfio_find_pcie_extended_capability (vfio_device_t *const vfio_device, const uint16_t capability_id,
+                                         uint32_t *const capability_offset);
 
 
 /* Intel processor cache line size */
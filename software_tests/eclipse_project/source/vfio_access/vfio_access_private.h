@@ -53,7 +53,16 @@ typedef enum
     /* Message ID only from manager to client that exclusive access is allowed */
     VFIO_MANAGE_MSG_ID_EXCLUSIVE_ACCESS_ALLOWED,
     /* Message ID only sent from client to indicate the exclusive access has been completed */
-    VFIO_MANAGE_MSG_ID_EXCLUSIVE_ACCESS_COMPLETED
+    VFIO_MANAGE_MSG_ID_EXCLUSIVE_ACCESS_COMPLETED,
+    /* A request from a client to acquire a lease on one resource of a device */
+    VFIO_MANAGE_MSG_ID_ACQUIRE_LEASE_REQUEST,
+    /* The response from the manager for a VFIO_MANAGE_MSG_ID_ACQUIRE_LEASE_REQUEST.
+     * Is deferred until either the lease is granted, or the wait for the lease times out. */
+    VFIO_MANAGE_MSG_ID_ACQUIRE_LEASE_REPLY,
+    /* A request from a client to release a previously granted lease */
+    VFIO_MANAGE_MSG_ID_RELEASE_LEASE_REQUEST,
+    /* The response from the manager for a VFIO_MANAGE_MSG_ID_RELEASE_LEASE_REQUEST */
+    VFIO_MANAGE_MSG_ID_RELEASE_LEASE_REPLY
 } vfio_manager_msg_id_t;
 
 
@@ -90,12 +99,9 @@ typedef struct
     bool success;
     /* The IOMMU type which is used for the VFIO container */
     __s32 iommu_type;
-    /* The number of IOMMU groups the container is used on */
-    uint32_t num_iommu_groups;
-    /* The names of the IOMMU groups in the container. This is used by the client to determine which IOMMU groups are used
-     * by which container. */
-    char iommu_group_names[MAX_VFIO_DEVICES][32];
-    /* The identity of the container, which is used by the client to allocate / free IOVA regions */
+    /* The identity of the container, which is used by the client to allocate / free IOVA regions.
+     * Also used by the client to determine which IOMMU groups share a container, since the number of IOMMU groups
+     * in a container isn't bounded the group names aren't sent in the reply. */
     uint32_t container_id;
 } vfio_open_device_reply_t;
 
@@ -186,6 +192,58 @@ typedef struct
 } vfio_free_iova_reply_t;
 
 
+/* The message body for a VFIO_MANAGE_MSG_ID_ACQUIRE_LEASE_REQUEST */
+typedef struct
+{
+    /* Common placement of message identification */
+    vfio_manager_msg_id_t msg_id;
+    /* Identifies the device containing the resource */
+    vfio_device_identity_t device_id;
+    /* Identifies the resource within the device */
+    vfio_resource_type_t resource_type;
+    uint32_t resource_index;
+    /* How long the lease is granted for, after which the manager may grant the resource to another client.
+     * VFIO_RESOURCE_LEASE_INFINITE_NS means the lease is held until released, or the client disconnects. */
+    uint64_t lease_duration_ns;
+    /* How long to wait for the resource to become free when leased by another client.
+     * Zero means fail immediately if the resource is not free, VFIO_RESOURCE_LEASE_INFINITE_NS means wait forever. */
+    uint64_t wait_timeout_ns;
+} vfio_acquire_lease_request_t;
+
+
+/* The message body for a VFIO_MANAGE_MSG_ID_ACQUIRE_LEASE_REPLY */
+typedef struct
+{
+    /* Common placement of message identification */
+    vfio_manager_msg_id_t msg_id;
+    /* If true the lease was granted, otherwise the request was invalid or timed out waiting */
+    bool success;
+    /* When success is true identifies the lease, to be used when releasing it */
+    uint32_t lease_id;
+} vfio_acquire_lease_reply_t;
+
+
+/* The message body for a VFIO_MANAGE_MSG_ID_RELEASE_LEASE_REQUEST */
+typedef struct
+{
+    /* Common placement of message identification */
+    vfio_manager_msg_id_t msg_id;
+    /* Identifies the lease to release */
+    uint32_t lease_id;
+} vfio_release_lease_request_t;
+
+
+/* The message body for a VFIO_MANAGE_MSG_ID_RELEASE_LEASE_REPLY */
+typedef struct
+{
+    /* Common placement of message identification */
+    vfio_manager_msg_id_t msg_id;
+    /* If true the lease was still held by the client when released.
+     * False if the lease had expired and so may have been granted to another client. */
+    bool success;
+} vfio_release_lease_reply_t;
+
+
 /* Used to allocate a buffer to receive different messages */
 typedef union
 {
@@ -200,10 +258,17 @@ typedef union
     vfio_allocate_iova_reply_t   allocate_iova_reply;
     vfio_free_iova_request_t     free_iova_request;
     vfio_free_iova_reply_t       free_iova_reply;
+    vfio_acquire_lease_request_t acquire_lease_request;
+    vfio_acquire_lease_reply_t   acquire_lease_reply;
+    vfio_release_lease_request_t release_lease_request;
+    vfio_release_lease_reply_t   release_lease_reply;
 } vfio_manage_messages_t;
 
 
 char *vfio_get_iommu_group (struct pci_dev *const pci_dev);
+vfio_iommu_container_t *vfio_next_free_container (vfio_devices_t *const vfio_devices);
+vfio_iommu_group_t *vfio_next_free_iommu_group (vfio_iommu_container_t *const container);
+vfio_device_t *vfio_next_free_device (vfio_devices_t *const vfio_devices);
 void enable_bus_master_for_dma (vfio_device_t *const device);
 bool open_vfio_device_fd (vfio_device_t *const new_device);
 vfio_device_t *open_vfio_device (vfio_devices_t *const vfio_devices, struct pci_dev *const pci_dev,
@@ -0,0 +1,684 @@
+/*
+ * @file vfio_error_monitor.c
+ * @date 18 Oct 2026
+ * @author Chester Gillon
+ * @brief Provides an interface to monitor VFIO devices for PCIe errors reported during a test, in a background thread
+ * @details
+ *   For each monitored device eventfds are attached to the following VFIO IRQs, when the device supports them:
+ *   a. VFIO_PCI_ERR_IRQ_INDEX which vfio-pci signals when the host AER driver reports an error for the device.
+ *      Only supported for PCIe devices, and only signalled for uncorrectable errors which the host AER driver handles.
+ *   b. VFIO_PCI_REQ_IRQ_INDEX which vfio-pci signals when the host requests the device is released,
+ *      e.g. when the device is being unbound from vfio-pci or hot removed. vfio-pci repeats the request until the
+ *      device is released, so the callbacks should arrange for the test to stop and close the device.
+ *
+ *   Correctable errors don't cause the VFIO_PCI_ERR_IRQ_INDEX to be signalled, so the monitor can also periodically poll
+ *   the error status in the PCIe Device Status register and the Advanced Error Reporting capability.
+ *
+ *   Whenever an IRQ is signalled, or polling finds new error status bits, the error status is read from the PCI
+ *   configuration space and delivered as a timestamped event to the registered callbacks. The callbacks are called from
+ *   the background thread, so a callback which requests a test is aborted should only set a flag for the test to poll.
+ *
+ *   Error status bits latched before the monitor is started are sampled as a baseline when the monitor is started, and are
+ *   not reported to the callbacks. This prevents a stale error, e.g. Unsupported Request detected during enumeration at
+ *   boot, from causing a test to fail.
+ *
+ *   Only one eventfd can be attached to each VFIO IRQ of a device. Therefore when devices are shared by multiple
+ *   processes via the VFIO multi process manager only one process should monitor a device for errors.
+ */
+
+#include "vfio_error_monitor.h"
+#include "transfer_timing.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/eventfd.h>
+
+
+/* The names of the bits in the AER Uncorrectable Error Status register, using the same abbreviations as lspci */
+static const char *const aer_uncorrectable_error_names[32] =
+{
+    [ 4] = "DLP",
+    [ 5] = "SDES",
+    [12] = "TLP",
+    [13] = "FCP",
+    [14] = "CmpltTO",
+    [15] = "CmpltAbrt",
+    [16] = "UnxCmplt",
+    [17] = "RxOF",
+    [18] = "MalfTLP",
+    [19] = "ECRC",
+    [20] = "UnsupReq",
+    [21] = "ACSViol",
+    [22] = "UncorrIntErr",
+    [23] = "BlockedTLP",
+    [24] = "AtomicOpBlocked",
+    [25] = "TLPBlockedErr"
+};
+
+
+/* The names of the bits in the AER Correctable Error Status register, using the same abbreviations as lspci */
+static const char *const aer_correctable_error_names[32] =
+{
+    [ 0] = "RxErr",
+    [ 6] = "BadTLP",
+    [ 7] = "BadDLLP",
+    [ 8] = "Rollover",
+    [12] = "Timeout",
+    [13] = "AdvNonFatalErr",
+    [14] = "CorrIntErr",
+    [15] = "HeaderOF"
+};
+
+
+static const char *const error_event_source_names[VFIO_ERROR_EVENT_ARRAY_SIZE] =
+{
+    [VFIO_ERROR_EVENT_ERR_IRQ    ] = "ERR IRQ",
+    [VFIO_ERROR_EVENT_REQ_IRQ    ] = "REQ IRQ",
+    [VFIO_ERROR_EVENT_STATUS_POLL] = "status poll"
+};
+
+
+/**
+ * @brief Attach an eventfd to one VFIO IRQ of a device, if supported by the device
+ * @param[in] vfio_device The device to attach the eventfd to
+ * @param[in] irq_index Which VFIO IRQ to attach the eventfd to
+ * @return The eventfd which has been attached, or -1 if the device doesn't support the IRQ
+ */
+static int vfio_error_monitor_attach_irq (vfio_device_t *const vfio_device, const uint32_t irq_index)
+{
+    struct vfio_irq_info irq_info;
+    struct
+    {
+        struct vfio_irq_set irq_set;
+        int32_t eventfd;
+    } irq_set_eventfd;
+    int rc;
+    int event_fd;
+
+    memset (&irq_info, 0, sizeof (irq_info));
+    irq_info.argsz = sizeof (irq_info);
+    irq_info.index = irq_index;
+    rc = ioctl (vfio_device->device_fd, VFIO_DEVICE_GET_IRQ_INFO, &irq_info);
+    if ((rc != 0) || (irq_info.count == 0) || ((irq_info.flags & VFIO_IRQ_INFO_EVENTFD) == 0))
+    {
+        /* VFIO_PCI_ERR_IRQ_INDEX isn't supported for conventional PCI devices */
+        return -1;
+    }
+
+    event_fd = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (event_fd < 0)
+    {
+        printf ("eventfd() failed : %s\n", strerror (errno));
+        exit (EXIT_FAILURE);
+    }
+
+    memset (&irq_set_eventfd, 0, sizeof (irq_set_eventfd));
+    irq_set_eventfd.irq_set.argsz = sizeof (irq_set_eventfd);
+    irq_set_eventfd.irq_set.flags = VFIO_IRQ_SET_DATA_EVENTFD | VFIO_IRQ_SET_ACTION_TRIGGER;
+    irq_set_eventfd.irq_set.index = irq_index;
+    irq_set_eventfd.irq_set.start = 0;
+    irq_set_eventfd.irq_set.count = 1;
+    irq_set_eventfd.eventfd = event_fd;
+    rc = ioctl (vfio_device->device_fd, VFIO_DEVICE_SET_IRQS, &irq_set_eventfd);
+    if (rc != 0)
+    {
+        printf ("VFIO_DEVICE_SET_IRQS for IRQ index %" PRIu32 " on %s failed : %s\n",
+                irq_index, vfio_device->device_name, strerror (errno));
+        close (event_fd);
+        event_fd = -1;
+    }
+
+    return event_fd;
+}
+
+
+/**
+ * @brief Detach an eventfd from one VFIO IRQ of a device, and close the eventfd
+ * @param[in] vfio_device The device to detach the eventfd from
+ * @param[in] irq_index Which VFIO IRQ to detach the eventfd from
+ * @param[in/out] event_fd The eventfd to close, which is set to -1
+ */
+static void vfio_error_monitor_detach_irq (vfio_device_t *const vfio_device, const uint32_t irq_index, int *const event_fd)
+{
+    struct vfio_irq_set irq_set;
+    int rc;
+
+    if (*event_fd >= 0)
+    {
+        memset (&irq_set, 0, sizeof (irq_set));
+        irq_set.argsz = sizeof (irq_set);
+        irq_set.flags = VFIO_IRQ_SET_DATA_NONE | VFIO_IRQ_SET_ACTION_TRIGGER;
+        irq_set.index = irq_index;
+        irq_set.start = 0;
+        irq_set.count = 0;
+        rc = ioctl (vfio_device->device_fd, VFIO_DEVICE_SET_IRQS, &irq_set);
+        if (rc != 0)
+        {
+            printf ("VFIO_DEVICE_SET_IRQS to disable IRQ index %" PRIu32 " on %s failed : %s\n",
+                    irq_index, vfio_device->device_name, strerror (errno));
+        }
+
+        close (*event_fd);
+        *event_fd = -1;
+    }
+}
+
+
+/**
+ * @brief Read the error status of one device
+ * @param[in] monitor_device The device to read the error status for
+ * @param[in] source What caused the error status to be read
+ * @param[out] event The timestamped error status read
+ */
+static void vfio_error_monitor_read_status (const vfio_error_monitor_device_t *const monitor_device,
+                                            const vfio_error_event_source_t source, vfio_error_event_t *const event)
+{
+    vfio_device_t *const vfio_device = monitor_device->vfio_device;
+    const uint32_t aer = monitor_device->aer_capability_offset;
+
+    memset (event, 0, sizeof (*event));
+    event->timestamp_ns = get_monotonic_time ();
+    clock_gettime (CLOCK_REALTIME, &event->wall_clock_time);
+    event->vfio_device = vfio_device;
+    event->source = source;
+    if (monitor_device->pcie_capability_present)
+    {
+        event->device_status_valid = vfio_read_pci_config_u16 (vfio_device,
+                monitor_device->pcie_capability_pointer + PCI_EXP_DEVSTA, &event->device_status);
+        event->device_status &= VFIO_ERROR_MONITOR_DEVSTA_ERRORS;
+    }
+    if (monitor_device->aer_capability_present)
+    {
+        event->aer_status_valid =
+                vfio_read_pci_config_u32 (vfio_device, aer + PCI_ERR_UNCOR_STATUS, &event->uncorrectable_status) &&
+                vfio_read_pci_config_u32 (vfio_device, aer + PCI_ERR_UNCOR_SEVER, &event->uncorrectable_severity) &&
+                vfio_read_pci_config_u32 (vfio_device, aer + PCI_ERR_COR_STATUS, &event->correctable_status);
+    }
+}
+
+
+/**
+ * @brief Clear the error status bits of one device which are set in an event
+ * @details The error status bits are RW1C, so write back the bits which are set
+ * @param[in] monitor_device The device to clear the error status for
+ * @param[in] event The error status previously read for the device
+ */
+static void vfio_error_monitor_clear_status (const vfio_error_monitor_device_t *const monitor_device,
+                                             const vfio_error_event_t *const event)
+{
+    vfio_device_t *const vfio_device = monitor_device->vfio_device;
+    const uint32_t aer = monitor_device->aer_capability_offset;
+
+    if (event->device_status_valid && (event->device_status != 0))
+    {
+        (void) vfio_write_pci_config_u16 (vfio_device,
+                monitor_device->pcie_capability_pointer + PCI_EXP_DEVSTA, event->device_status);
+    }
+    if (event->aer_status_valid && (event->uncorrectable_status != 0))
+    {
+        (void) vfio_write_pci_config_u32 (vfio_device, aer + PCI_ERR_UNCOR_STATUS, event->uncorrectable_status);
+    }
+    if (event->aer_status_valid && (event->correctable_status != 0))
+    {
+        (void) vfio_write_pci_config_u32 (vfio_device, aer + PCI_ERR_COR_STATUS, event->correctable_status);
+    }
+}
+
+
+/**
+ * @brief Sample the error status of one device, and report an event to the callbacks if required
+ * @details Events are always reported when caused by an IRQ, but only reported from polling when there are error
+ *          status bits which have not previously been reported.
+ * @param[in/out] monitor The monitor to report the event to
+ * @param[in/out] monitor_device The device to sample the error status for
+ * @param[in] source What caused the error status to be sampled
+ */
+static void vfio_error_monitor_sample_device (vfio_error_monitor_t *const monitor,
+                                              vfio_error_monitor_device_t *const monitor_device,
+                                              const vfio_error_event_source_t source)
+{
+    vfio_error_event_t event;
+
+    vfio_error_monitor_read_status (monitor_device, source, &event);
+
+    const bool new_errors =
+            (event.device_status_valid &&
+             ((event.device_status & ~monitor_device->reported_device_status) != 0)) ||
+            (event.aer_status_valid &&
+             (((event.uncorrectable_status & ~monitor_device->reported_uncorrectable_status) != 0) ||
+              ((event.correctable_status & ~monitor_device->reported_correctable_status) != 0)));
+
+    if ((source != VFIO_ERROR_EVENT_STATUS_POLL) || new_errors)
+    {
+        __atomic_add_fetch (&monitor->num_events[source], 1, __ATOMIC_RELAXED);
+        for (uint32_t callback_index = 0; callback_index < monitor->num_callbacks; callback_index++)
+        {
+            const vfio_error_monitor_callback_t *const callback = &monitor->callbacks[callback_index];
+
+            callback->callback (&event, callback->callback_context);
+        }
+
+        if (monitor->clear_error_status)
+        {
+            vfio_error_monitor_clear_status (monitor_device, &event);
+        }
+    }
+
+    /* Track the status bits which are currently set, rather than accumulating them, so that errors are reported again
+     * if the status bits are cleared and then set again (e.g. when the host AER driver clears the status). */
+    if (monitor->clear_error_status)
+    {
+        monitor_device->reported_device_status = 0;
+        monitor_device->reported_uncorrectable_status = 0;
+        monitor_device->reported_correctable_status = 0;
+    }
+    else
+    {
+        monitor_device->reported_device_status = event.device_status;
+        monitor_device->reported_uncorrectable_status = event.uncorrectable_status;
+        monitor_device->reported_correctable_status = event.correctable_status;
+    }
+}
+
+
+/**
+ * @brief The entry point for the background thread which monitors the devices for errors until requested to stop
+ * @details The first poll of the error status is one poll interval after the start, since vfio_error_monitor_start()
+ *          has already sampled the error status latched before the monitor was started.
+ * @param[in/out] arg The monitor context
+ * @return Not used
+ */
+static void *vfio_error_monitor_thread (void *const arg)
+{
+    vfio_error_monitor_t *const monitor = arg;
+    const nfds_t max_fds = 1 + (2 * monitor->num_devices);
+    struct pollfd *const poll_fds = calloc (max_fds, sizeof (poll_fds[0]));
+    vfio_error_event_source_t *const fd_sources = calloc (max_fds, sizeof (fd_sources[0]));
+    vfio_error_monitor_device_t **const fd_devices = calloc (max_fds, sizeof (fd_devices[0]));
+    nfds_t num_fds;
+    int64_t next_poll_time_ns;
+    int timeout_ms;
+    int rc;
+    uint64_t event_count;
+    bool stop_requested = false;
+
+    if ((poll_fds == NULL) || (fd_sources == NULL) || (fd_devices == NULL))
+    {
+        printf ("Failed to allocate poll_fds for the VFIO error monitor\n");
+        exit (EXIT_FAILURE);
+    }
+
+    /* Build the list of file descriptors to wait on, with the stop request first */
+    num_fds = 0;
+    poll_fds[num_fds].fd = monitor->stop_eventfd;
+    poll_fds[num_fds].events = POLLIN;
+    num_fds++;
+    for (uint32_t device_index = 0; device_index < monitor->num_devices; device_index++)
+    {
+        vfio_error_monitor_device_t *const monitor_device = &monitor->devices[device_index];
+
+        if (monitor_device->err_irq_eventfd >= 0)
+        {
+            poll_fds[num_fds].fd = monitor_device->err_irq_eventfd;
+            poll_fds[num_fds].events = POLLIN;
+            fd_sources[num_fds] = VFIO_ERROR_EVENT_ERR_IRQ;
+            fd_devices[num_fds] = monitor_device;
+            num_fds++;
+        }
+        if (monitor_device->req_irq_eventfd >= 0)
+        {
+            poll_fds[num_fds].fd = monitor_device->req_irq_eventfd;
+            poll_fds[num_fds].events = POLLIN;
+            fd_sources[num_fds] = VFIO_ERROR_EVENT_REQ_IRQ;
+            fd_devices[num_fds] = monitor_device;
+            num_fds++;
+        }
+    }
+
+    next_poll_time_ns = (monitor->status_poll_interval_ns > 0) ?
+            get_monotonic_time () + monitor->status_poll_interval_ns : INT64_MAX;
+    while (!stop_requested)
+    {
+        /* Poll the error status of all devices when the poll interval has expired */
+        const int64_t now_ns = get_monotonic_time ();
+        if (now_ns >= next_poll_time_ns)
+        {
+            for (uint32_t device_index = 0; device_index < monitor->num_devices; device_index++)
+            {
+                vfio_error_monitor_sample_device (monitor, &monitor->devices[device_index], VFIO_ERROR_EVENT_STATUS_POLL);
+            }
+            next_poll_time_ns += monitor->status_poll_interval_ns;
+            if (next_poll_time_ns <= now_ns)
+            {
+                /* Don't try and catch up on missed polls */
+                next_poll_time_ns = now_ns + monitor->status_poll_interval_ns;
+            }
+        }
+
+        if (monitor->status_poll_interval_ns > 0)
+        {
+            const int64_t remaining_ns = next_poll_time_ns - get_monotonic_time ();
+
+            timeout_ms = (remaining_ns > 0) ? (int) ((remaining_ns + 999999) / 1000000) : 0;
+        }
+        else
+        {
+            timeout_ms = -1;
+        }
+
+        /* Wait for an IRQ, a stop request, or the next poll time */
+        rc = poll (poll_fds, num_fds, timeout_ms);
+        if ((rc < 0) && (errno != EINTR))
+        {
+            printf ("poll() failed in VFIO error monitor : %s\n", strerror (errno));
+            exit (EXIT_FAILURE);
+        }
+
+        for (nfds_t fd_index = 0; (rc > 0) && (fd_index < num_fds); fd_index++)
+        {
+            if ((poll_fds[fd_index].revents & POLLIN) != 0)
+            {
+                /* Read the eventfd to reset the count */
+                if (read (poll_fds[fd_index].fd, &event_count, sizeof (event_count)) == sizeof (event_count))
+                {
+                    if (fd_index == 0)
+                    {
+                        stop_requested = true;
+                    }
+                    else
+                    {
+                        vfio_error_monitor_sample_device (monitor, fd_devices[fd_index], fd_sources[fd_index]);
+                    }
+                }
+            }
+        }
+    }
+
+    free (fd_devices);
+    free (fd_sources);
+    free (poll_fds);
+
+    return NULL;
+}
+
+
+/**
+ * @brief Initialise a monitor for VFIO device errors, which has no devices or callbacks
+ * @param[out] monitor The monitor to initialise
+ * @param[in] status_poll_interval_ns The interval at which to poll the device error status, to detect correctable errors.
+ *                                    Zero means the error status is only read when an IRQ is signalled.
+ * @param[in] clear_error_status When true the error status bits are cleared once they have been reported
+ */
+void vfio_error_monitor_initialise (vfio_error_monitor_t *const monitor,
+                                    const int64_t status_poll_interval_ns, const bool clear_error_status)
+{
+    memset (monitor, 0, sizeof (*monitor));
+    monitor->status_poll_interval_ns = status_poll_interval_ns;
+    monitor->clear_error_status = clear_error_status;
+    monitor->thread_running = false;
+    monitor->stop_eventfd = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (monitor->stop_eventfd < 0)
+    {
+        printf ("eventfd() failed : %s\n", strerror (errno));
+        exit (EXIT_FAILURE);
+    }
+}
+
+
+/**
+ * @brief Add a device to be monitored for errors
+ * @details This attaches eventfds to the error and request IRQs of the device, and locates the registers used to read
+ *          the error status. Must be called before vfio_error_monitor_start().
+ * @param[in/out] monitor The monitor to add the device to
+ * @param[in/out] vfio_device The device to monitor, which must be open
+ */
+void vfio_error_monitor_add_device (vfio_error_monitor_t *const monitor, vfio_device_t *const vfio_device)
+{
+    if (monitor->thread_running)
+    {
+        printf ("Devices can't be added to the VFIO error monitor once started\n");
+        exit (EXIT_FAILURE);
+    }
+
+    if (vfio_device->device_fd < 0)
+    {
+        printf ("Can't monitor %s for errors as the device isn't open\n", vfio_device->device_name);
+        return;
+    }
+
+    monitor->devices = vfio_grow_array (monitor->devices, &monitor->devices_allocated_length, monitor->num_devices + 1,
+            sizeof (monitor->devices[0]), "VFIO error monitor devices");
+    vfio_error_monitor_device_t *const monitor_device = &monitor->devices[monitor->num_devices];
+
+    memset (monitor_device, 0, sizeof (*monitor_device));
+    monitor_device->vfio_device = vfio_device;
+    monitor_device->pcie_capability_present =
+            vfio_get_pcie_capability_pointer (vfio_device, &monitor_device->pcie_capability_pointer);
+    monitor_device->aer_capability_present =
+            vfio_find_pcie_extended_capability (vfio_device, PCI_EXT_CAP_ID_ERR, &monitor_device->aer_capability_offset);
+    monitor_device->err_irq_eventfd = vfio_error_monitor_attach_irq (vfio_device, VFIO_PCI_ERR_IRQ_INDEX);
+    monitor_device->req_irq_eventfd = vfio_error_monitor_attach_irq (vfio_device, VFIO_PCI_REQ_IRQ_INDEX);
+    monitor->num_devices++;
+
+    printf ("Monitoring %s for errors using:%s%s%s%s\n", vfio_device->device_name,
+            (monitor_device->err_irq_eventfd >= 0) ? " ERR_IRQ" : "",
+            (monitor_device->req_irq_eventfd >= 0) ? " REQ_IRQ" : "",
+            monitor_device->pcie_capability_present ? " DEVSTA" : "",
+            monitor_device->aer_capability_present ? " AER" : "");
+}
+
+
+/**
+ * @brief Register a callback which is called for each error event
+ * @details Must be called before vfio_error_monitor_start(). The callback is called from the background thread.
+ * @param[in/out] monitor The monitor to register the callback with
+ * @param[in] callback The function to call
+ * @param[in] callback_context Passed to the callback
+ */
+void vfio_error_monitor_register_callback (vfio_error_monitor_t *const monitor,
+                                           vfio_error_event_callback_t callback, void *const callback_context)
+{
+    if (monitor->thread_running)
+    {
+        printf ("Callbacks can't be registered with the VFIO error monitor once started\n");
+        exit (EXIT_FAILURE);
+    }
+
+    if (monitor->num_callbacks >= VFIO_ERROR_MONITOR_MAX_CALLBACKS)
+    {
+        printf ("Maximum of %u VFIO error monitor callbacks exceeded\n", VFIO_ERROR_MONITOR_MAX_CALLBACKS);
+        exit (EXIT_FAILURE);
+    }
+
+    monitor->callbacks[monitor->num_callbacks].callback = callback;
+    monitor->callbacks[monitor->num_callbacks].callback_context = callback_context;
+    monitor->num_callbacks++;
+}
+
+
+/**
+ * @brief Start the background thread which monitors the devices for errors
+ * @details Before the thread is started the error status of each device is sampled as a baseline, so that only errors
+ *          which occur after the start are reported to the callbacks. Error status bits latched before the start, e.g. from
+ *          device enumeration at boot, are displayed and then either cleared or ignored according to clear_error_status.
+ *          Since the baseline is sampled before returning, a caller can read vfio_error_monitor_total_events() immediately
+ *          after the start without counting the latched errors.
+ * @param[in/out] monitor The monitor to start
+ */
+void vfio_error_monitor_start (vfio_error_monitor_t *const monitor)
+{
+    vfio_error_event_t baseline;
+    int rc;
+
+    for (uint32_t device_index = 0; device_index < monitor->num_devices; device_index++)
+    {
+        vfio_error_monitor_device_t *const monitor_device = &monitor->devices[device_index];
+
+        vfio_error_monitor_read_status (monitor_device, VFIO_ERROR_EVENT_STATUS_POLL, &baseline);
+        if ((baseline.device_status != 0) || (baseline.uncorrectable_status != 0) || (baseline.correctable_status != 0))
+        {
+            printf ("%s had error status latched before monitoring started, which will be %s:\n"
+                    "  DevSta=0x%04" PRIx16 " UESta=0x%08" PRIx32 " CESta=0x%08" PRIx32 "\n",
+                    monitor_device->vfio_device->device_name, monitor->clear_error_status ? "cleared" : "ignored",
+                    baseline.device_status, baseline.uncorrectable_status, baseline.correctable_status);
+        }
+
+        if (monitor->clear_error_status)
+        {
+            vfio_error_monitor_clear_status (monitor_device, &baseline);
+            monitor_device->reported_device_status = 0;
+            monitor_device->reported_uncorrectable_status = 0;
+            monitor_device->reported_correctable_status = 0;
+        }
+        else
+        {
+            monitor_device->reported_device_status = baseline.device_status;
+            monitor_device->reported_uncorrectable_status = baseline.uncorrectable_status;
+            monitor_device->reported_correctable_status = baseline.correctable_status;
+        }
+    }
+
+    rc = pthread_create (&monitor->thread, NULL, vfio_error_monitor_thread, monitor);
+    if (rc != 0)
+    {
+        printf ("pthread_create() failed\n");
+        exit (EXIT_FAILURE);
+    }
+    monitor->thread_running = true;
+}
+
+
+/**
+ * @brief Get the total number of error events which have been delivered to the callbacks
+ * @param[in] monitor The monitor to get the number of events for
+ * @return The total number of error events, from all sources
+ */
+uint64_t vfio_error_monitor_total_events (vfio_error_monitor_t *const monitor)
+{
+    uint64_t total_events = 0;
+
+    for (vfio_error_event_source_t source = 0; source < VFIO_ERROR_EVENT_ARRAY_SIZE; source++)
+    {
+        total_events += __atomic_load_n (&monitor->num_events[source], __ATOMIC_RELAXED);
+    }
+
+    return total_events;
+}
+
+
+/**
+ * @brief Stop monitoring for errors, detaching the eventfds from the IRQs and freeing the resources
+ * @details Must be called before the monitored devices are closed.
+ * @param[in/out] monitor The monitor to stop
+ */
+void vfio_error_monitor_stop (vfio_error_monitor_t *const monitor)
+{
+    const uint64_t stop_request = 1;
+    int rc;
+
+    if (monitor->thread_running)
+    {
+        if (write (monitor->stop_eventfd, &stop_request, sizeof (stop_request)) != sizeof (stop_request))
+        {
+            printf ("Failed to request VFIO error monitor stop : %s\n", strerror (errno));
+            exit (EXIT_FAILURE);
+        }
+        rc = pthread_join (monitor->thread, NULL);
+        if (rc != 0)
+        {
+            printf ("pthread_join() failed\n");
+            exit (EXIT_FAILURE);
+        }
+        monitor->thread_running = false;
+    }
+
+    for (uint32_t device_index = 0; device_index < monitor->num_devices; device_index++)
+    {
+        vfio_error_monitor_device_t *const monitor_device = &monitor->devices[device_index];
+
+        vfio_error_monitor_detach_irq (monitor_device->vfio_device, VFIO_PCI_ERR_IRQ_INDEX, &monitor_device->err_irq_eventfd);
+        vfio_error_monitor_detach_irq (monitor_device->vfio_device, VFIO_PCI_REQ_IRQ_INDEX, &monitor_device->req_irq_eventfd);
+    }
+    free (monitor->devices);
+    monitor->devices = NULL;
+    monitor->num_devices = 0;
+    monitor->devices_allocated_length = 0;
+    close (monitor->stop_eventfd);
+    monitor->stop_eventfd = -1;
+}
+
+
+/**
+ * @brief Display the names of the bits set in an error status register
+ * @param[in] status The error status register value
+ * @param[in] bit_names The names of the defined bits
+ * @param[in] severity When non-NULL the AER Uncorrectable Error Severity register, used to flag fatal errors
+ */
+static void vfio_error_monitor_display_bits (const uint32_t status, const char *const bit_names[const 32],
+                                             const uint32_t *const severity)
+{
+    for (uint32_t bit = 0; bit < 32; bit++)
+    {
+        const uint32_t mask = 1U << bit;
+
+        if ((status & mask) != 0)
+        {
+            if (bit_names[bit] != NULL)
+            {
+                printf (" %s", bit_names[bit]);
+            }
+            else
+            {
+                printf (" bit%u", bit);
+            }
+            if ((severity != NULL) && ((*severity & mask) != 0))
+            {
+                printf ("(Fatal)");
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief A callback which displays an error event on the console, with a timestamp
+ * @param[in] event The error event to display
+ * @param[in] callback_context Not used
+ */
+void vfio_error_monitor_display_event (const vfio_error_event_t *const event, void *const callback_context)
+{
+    struct tm broken_down_time;
+    char date_time[32];
+
+    localtime_r (&event->wall_clock_time.tv_sec, &broken_down_time);
+    strftime (date_time, sizeof (date_time), "%Y-%m-%d %H:%M:%S", &broken_down_time);
+    printf ("%s.%06ld %s error event from %s:", date_time, event->wall_clock_time.tv_nsec / 1000,
+            event->vfio_device->device_name, error_event_source_names[event->source]);
+    if (event->device_status_valid)
+    {
+        printf (" DevSta:%s%s%s%s",
+                (event->device_status & PCI_EXP_DEVSTA_CED ) != 0 ? " CorrErr" : "",
+                (event->device_status & PCI_EXP_DEVSTA_NFED) != 0 ? " NonFatalErr" : "",
+                (event->device_status & PCI_EXP_DEVSTA_FED ) != 0 ? " FatalErr" : "",
+                (event->device_status & PCI_EXP_DEVSTA_URD ) != 0 ? " UnsupReq" : "");
+    }
+    if (event->aer_status_valid)
+    {
+        printf (" UESta:");
+        vfio_error_monitor_display_bits (event->uncorrectable_status, aer_uncorrectable_error_names,
+                &event->uncorrectable_severity);
+        printf (" CESta:");
+        vfio_error_monitor_display_bits (event->correctable_status, aer_correctable_error_names, NULL);
+    }
+    if (event->source == VFIO_ERROR_EVENT_REQ_IRQ)
+    {
+        printf (" (host requested the device is released)");
+    }
+    printf ("\n");
+}
@@ -0,0 +1,133 @@
+/*
+ * @file vfio_error_monitor.h
+ * @date 18 Oct 2026
+ * @author Chester Gillon
+ * @brief Provides an interface to monitor VFIO devices for PCIe errors reported during a test, in a background thread
+ */
+
+#ifndef VFIO_ERROR_MONITOR_H_
+#define VFIO_ERROR_MONITOR_H_
+
+#include <time.h>
+#include <pthread.h>
+
+#include "vfio_access.h"
+
+
+/* The error detected bits in the PCIe Device Status register, which are RW1C */
+#define VFIO_ERROR_MONITOR_DEVSTA_ERRORS \
+    (PCI_EXP_DEVSTA_CED | PCI_EXP_DEVSTA_NFED | PCI_EXP_DEVSTA_FED | PCI_EXP_DEVSTA_URD)
+
+
+/* The maximum number of callbacks which can be registered with one monitor */
+#define VFIO_ERROR_MONITOR_MAX_CALLBACKS 4
+
+
+/* Identifies what caused an error event to be reported */
+typedef enum
+{
+    /* The VFIO_PCI_ERR_IRQ_INDEX eventfd was signalled, due to the host AER driver reporting an error for the device */
+    VFIO_ERROR_EVENT_ERR_IRQ,
+    /* The VFIO_PCI_REQ_IRQ_INDEX eventfd was signalled, due to the host requesting that the device is released */
+    VFIO_ERROR_EVENT_REQ_IRQ,
+    /* Polling of the device error status found error bits which were not previously reported */
+    VFIO_ERROR_EVENT_STATUS_POLL,
+
+    VFIO_ERROR_EVENT_ARRAY_SIZE
+} vfio_error_event_source_t;
+
+
+/* One error event reported for a device, delivered to the registered callbacks */
+typedef struct
+{
+    /* CLOCK_MONOTONIC time in nanoseconds at which the error status was sampled */
+    int64_t timestamp_ns;
+    /* CLOCK_REALTIME at which the error status was sampled, to allow correlation with the Kernel log */
+    struct timespec wall_clock_time;
+    /* The device the event is for */
+    vfio_device_t *vfio_device;
+    /* What caused the event to be reported */
+    vfio_error_event_source_t source;
+    /* When true the device has the PCIe capability, and device_status is valid */
+    bool device_status_valid;
+    /* The PCIe Device Status register, which contains the PCI_EXP_DEVSTA_* detected error bits */
+    uint16_t device_status;
+    /* When true the device has the Advanced Error Reporting capability, and the following AER registers are valid */
+    bool aer_status_valid;
+    uint32_t uncorrectable_status;
+    uint32_t uncorrectable_severity;
+    uint32_t correctable_status;
+} vfio_error_event_t;
+
+
+/* Function called from the background thread of the monitor to deliver an error event */
+typedef void (*vfio_error_event_callback_t) (const vfio_error_event_t *const event, void *const callback_context);
+
+
+/* A callback registered with the monitor */
+typedef struct
+{
+    vfio_error_event_callback_t callback;
+    void *callback_context;
+} vfio_error_monitor_callback_t;
+
+
+/* The monitoring state for one device */
+typedef struct
+{
+    /* The device being monitored */
+    vfio_device_t *vfio_device;
+    /* The eventfds attached to VFIO_PCI_ERR_IRQ_INDEX and VFIO_PCI_REQ_IRQ_INDEX, or -1 if the device doesn't support
+     * the IRQ */
+    int err_irq_eventfd;
+    int req_irq_eventfd;
+    /* When true pcie_capability_pointer gives the offset of the PCIe capability */
+    bool pcie_capability_present;
+    uint8_t pcie_capability_pointer;
+    /* When true aer_capability_offset gives the offset of the Advanced Error Reporting extended capability */
+    bool aer_capability_present;
+    uint32_t aer_capability_offset;
+    /* The error status bits which have previously been reported, or were latched when the monitor was started, so that
+     * when the status bits are not cleared polling only reports errors which are new. */
+    uint16_t reported_device_status;
+    uint32_t reported_uncorrectable_status;
+    uint32_t reported_correctable_status;
+} vfio_error_monitor_device_t;
+
+
+/* Context for a background thread which monitors VFIO devices for errors */
+typedef struct
+{
+    /* The devices being monitored */
+    uint32_t num_devices;
+    uint32_t devices_allocated_length;
+    vfio_error_monitor_device_t *devices;
+    /* The callbacks which are called, in the order registered, for each error event */
+    uint32_t num_callbacks;
+    vfio_error_monitor_callback_t callbacks[VFIO_ERROR_MONITOR_MAX_CALLBACKS];
+    /* The interval at which the error status of the devices is polled. Zero means the error status is only read
+     * when one of the IRQs is signalled. */
+    int64_t status_poll_interval_ns;
+    /* When true the error status bits are cleared once they have been reported */
+    bool clear_error_status;
+    /* Signalled to request the background thread to stop */
+    int stop_eventfd;
+    /* The background thread */
+    pthread_t thread;
+    bool thread_running;
+    /* The number of error events delivered to the callbacks, for each source */
+    uint64_t num_events[VFIO_ERROR_EVENT_ARRAY_SIZE];
+} vfio_error_monitor_t;
+
+
+void vfio_error_monitor_initialise (vfio_error_monitor_t *const monitor,
+                                    const int64_t status_poll_interval_ns, const bool clear_error_status);
+void vfio_error_monitor_add_device (vfio_error_monitor_t *const monitor, vfio_device_t *const vfio_device);
+void vfio_error_monitor_register_callback (vfio_error_monitor_t *const monitor,
+                                           vfio_error_event_callback_t callback, void *const callback_context);
+void vfio_error_monitor_start (vfio_error_monitor_t *const monitor);
+uint64_t vfio_error_monitor_total_events (vfio_error_monitor_t *const monitor);
+void vfio_error_monitor_stop (vfio_error_monitor_t *const monitor);
+void vfio_error_monitor_display_event (const vfio_error_event_t *const event, void *const callback_context);
+
+#endif /* VFIO_ERROR_MONITOR_H_ */
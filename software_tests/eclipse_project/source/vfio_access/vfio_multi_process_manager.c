@@ -11,6 +11,7 @@
 
 #include "vfio_access.h"
 #include "vfio_access_private.h"
+#include "transfer_timing.h"
 
 #include <stdlib.h>
 #include <stddef.h>
@@ -28,14 +29,7 @@
 #include <poll.h>
 #include <sys/ioctl.h>
 #include <signal.h>
-
-
-/* The maximum number of client, assuming 4 bi-directional channels on each device.
- * This simplifies the code by having a compile time maximum number of clients. */
-#define VFIO_MAX_CLIENTS (MAX_VFIO_DEVICES * 8)
-
-
-#define VFIO_MAX_FDS (1 /* listening_socket_fd */ + VFIO_MAX_CLIENTS)
+#include <time.h>
 
 
 /** The command line options for this program, in the format passed to getopt_long().
@@ -58,8 +52,9 @@ typedef struct
     int client_socket_fd;
     /* Indicates which devices are in used by the client. This is used to:
      * a. Open a device when the first client requests access.
-     * b. Close a device once no clients require access. */
-    bool devices_used[MAX_VFIO_DEVICES];
+     * b. Close a device once no clients require access.
+     * Indexed by the device index, and allocated with the number of devices opened by the manager initialisation. */
+    bool *devices_used;
     /* Contains the PID of the client, for reporting diagnostics */
     bool credentials_valid;
     struct ucred credentials;
@@ -71,16 +66,55 @@ typedef struct
 } vfio_client_data_t;
 
 
+/* Contains one resource lease, which is either granted to a client or a queued request from a client waiting for the
+ * resource to become free */
+typedef struct
+{
+    /* Set true when the entry is in use, and the other fields are defined */
+    bool in_use;
+    /* Set true when the lease has been granted, or false when the client is waiting for the lease */
+    bool granted;
+    /* Identifies the client which requested the lease */
+    uint32_t client_index;
+    /* Identifies the resource being leased, as the index of the device and the resource within the device */
+    uint32_t device_index;
+    vfio_resource_type_t resource_type;
+    uint32_t resource_index;
+    /* Identifies the lease to the client once granted */
+    uint32_t lease_id;
+    /* Incremented for each queued request, to allow waiting requests to be granted in FIFO order */
+    uint64_t request_sequence;
+    /* The requested lease duration, applied when the lease is granted */
+    uint64_t lease_duration_ns;
+    /* When granted is true the CLOCK_MONOTONIC time at which the lease expires.
+     * When granted is false the CLOCK_MONOTONIC time at which the wait for the lease times out.
+     * VFIO_RESOURCE_LEASE_INFINITE_NS means no deadline. */
+    uint64_t deadline_ns;
+} vfio_resource_lease_t;
+
+
 /* Defines the content for the manager process */
 typedef struct
 {
     /* File descriptor used a listening socket to accept client connections */
     int listening_socket_fd;
-    /* Data for each connected client. The index into this array is used identify the client */
-    vfio_client_data_t clients[VFIO_MAX_CLIENTS];
+    /* Data for each connected client. The index into this array is used identify the client.
+     * Grown as clients connect, with the entries for disconnected clients re-used. */
+    vfio_client_data_t *clients;
+    uint32_t clients_allocated_length;
     /* One more than the highest index in clients[] for a connected client. Used to limit how many
      * clients have to be iterated over. */
     uint32_t maximum_used_clients;
+    /* The file descriptors polled by the run loop, as the listening socket followed by one entry per client.
+     * Grown as the maximum_used_clients increases. */
+    struct pollfd *poll_fds;
+    uint32_t poll_fds_allocated_length;
+    /* The resource leases which are granted or waiting. Grown as required, with unused entries re-used. */
+    vfio_resource_lease_t *leases;
+    uint32_t leases_allocated_length;
+    /* Used to allocate unique lease identities, and the sequence of requests to preserve FIFO order */
+    uint32_t next_lease_id;
+    uint64_t next_request_sequence;
     /* Contains the open IOMMU groups, IOMMU containers and VFIO devices */
     vfio_devices_t vfio_devices;
     /* Used to unblock SIGINT only during ppoll() and not other blocking calls */
@@ -190,7 +224,7 @@ static void parse_command_line_arguments (int argc, char *argv[])
 static void update_maximum_used_clients (vfio_manager_context_t *const context)
 {
     context->maximum_used_clients = 0;
-    for (uint32_t client_index = 0; client_index < VFIO_MAX_CLIENTS; client_index++)
+    for (uint32_t client_index = 0; client_index < context->clients_allocated_length; client_index++)
     {
         if (context->clients[client_index].connected)
         {
@@ -229,11 +263,14 @@ static bool initialise_vfio_manager (vfio_manager_context_t *const context)
     context->vfio_devices.num_containers = 0;
     context->vfio_devices.num_devices = 0;
     context->listening_socket_fd = -1;
-    for (uint32_t client_index = 0; client_index < VFIO_MAX_CLIENTS; client_index++)
-    {
-        context->clients[client_index].connected = false;
-        context->clients[client_index].client_socket_fd = -1;
-    }
+    context->clients = NULL;
+    context->clients_allocated_length = 0;
+    context->poll_fds = NULL;
+    context->poll_fds_allocated_length = 0;
+    context->leases = NULL;
+    context->leases_allocated_length = 0;
+    context->next_lease_id = 1;
+    context->next_request_sequence = 0;
     update_maximum_used_clients (context);
 
     /* The VFIO manager doesn't need to use the cmem driver */
@@ -279,12 +316,10 @@ static bool initialise_vfio_manager (vfio_manager_context_t *const context)
                         if ((iommu_group != NULL) && (strcmp (iommu_group_text, iommu_group) == 0))
                         {
                             num_expected_vfio_devices++;
-                            if (context->vfio_devices.num_devices < MAX_VFIO_DEVICES)
-                            {
-                                /* The device is initialised to not being DMA capable, may be changed when a client requests
-                                 * the device is opened. */
-                                (void) open_vfio_device (&context->vfio_devices, dev, VFIO_DEVICE_DMA_CAPABILITY_NONE);
-                            }
+
+                            /* The device is initialised to not being DMA capable, may be changed when a client requests
+                             * the device is opened. */
+                            (void) open_vfio_device (&context->vfio_devices, dev, VFIO_DEVICE_DMA_CAPABILITY_NONE);
                         }
                     }
                 }
@@ -294,12 +329,11 @@ static bool initialise_vfio_manager (vfio_manager_context_t *const context)
     closedir (vfio_dir);
 
     /* Verify that the expected number of IOMMU groups and devices were opened.
-     * open_vfio_device() will have output diagnostic about all failures except for exceeding the compile time maximum
-     * number of VFIO devices. */
+     * open_vfio_device() will have output diagnostic about all failures. */
     uint32_t num_opened_iommu_groups = 0;
     for (uint32_t container_index = 0; container_index < context->vfio_devices.num_containers; container_index++)
     {
-        num_opened_iommu_groups += context->vfio_devices.containers[container_index].num_iommu_groups;
+        num_opened_iommu_groups += context->vfio_devices.containers[container_index]->num_iommu_groups;
     }
     bool success = (num_opened_iommu_groups > 0) &&
             (context->vfio_devices.num_devices == num_expected_vfio_devices) &&
@@ -338,7 +372,7 @@ static bool initialise_vfio_manager (vfio_manager_context_t *const context)
         if (success)
         {
             errno = 0;
-            rc = listen (context->listening_socket_fd, VFIO_MAX_CLIENTS);
+            rc = listen (context->listening_socket_fd, SOMAXCONN);
             saved_errno = errno;
             if (rc != 0)
             {
@@ -356,11 +390,6 @@ static bool initialise_vfio_manager (vfio_manager_context_t *const context)
         }
         else
         {
-            if (num_expected_vfio_devices > MAX_VFIO_DEVICES)
-            {
-                printf ("Number of VFIO devices %u bound to IOMMU groups exceeds the compile time maximum of %u\n",
-                        num_expected_vfio_devices, MAX_VFIO_DEVICES);
-            }
             printf ("Only opened %u out of %u IOMMU groups, and %u out of %u expected VFIO devices\n",
                     num_opened_iommu_groups, num_expected_iommu_groups,
                     context->vfio_devices.num_devices, num_expected_vfio_devices);
@@ -389,6 +418,20 @@ static void finalise_vfio_manager (vfio_manager_context_t *const context)
             printf ("close() failed\n");
         }
     }
+
+    for (uint32_t client_index = 0; client_index < context->clients_allocated_length; client_index++)
+    {
+        free (context->clients[client_index].devices_used);
+    }
+    free (context->clients);
+    context->clients = NULL;
+    context->clients_allocated_length = 0;
+    free (context->poll_fds);
+    context->poll_fds = NULL;
+    context->poll_fds_allocated_length = 0;
+    free (context->leases);
+    context->leases = NULL;
+    context->leases_allocated_length = 0;
 }
 
 
@@ -403,73 +446,70 @@ static void accept_client_connection (vfio_manager_context_t *const context)
 
     if (new_client_fd != -1)
     {
-        if (context->maximum_used_clients < VFIO_MAX_CLIENTS)
+        /* Allocate a free index for the new client, re-using the index of a previously disconnected client when possible.
+         * Otherwise grow the array of clients. */
+        uint32_t client_index = 0;
+
+        while ((client_index < context->clients_allocated_length) && context->clients[client_index].connected)
         {
-            /* Allocate a free index for the new client */
-            bool client_added = false;
+            client_index++;
+        }
+        context->clients = vfio_grow_array (context->clients, &context->clients_allocated_length, client_index + 1,
+                sizeof (context->clients[0]), "clients");
 
-            for (uint32_t client_index = 0; !client_added && (client_index < VFIO_MAX_CLIENTS); client_index++)
-            {
-                if (!context->clients[client_index].connected)
-                {
-                    vfio_client_data_t *const client = &context->clients[client_index];
+        vfio_client_data_t *const client = &context->clients[client_index];
 
-                    client->connected = true;
-                    client->client_socket_fd = new_client_fd;
-                    for (uint32_t device_index = 0; device_index < MAX_VFIO_DEVICES; device_index++)
-                    {
-                        client->devices_used[device_index] = false;
-                    }
+        client->connected = true;
+        client->client_socket_fd = new_client_fd;
+        if (client->devices_used == NULL)
+        {
+            /* The number of devices is fixed once the manager has initialised */
+            client->devices_used = calloc (context->vfio_devices.num_devices, sizeof (client->devices_used[0]));
+            if (client->devices_used == NULL)
+            {
+                printf ("Failed to allocate memory for devices_used\n");
+                exit (EXIT_FAILURE);
+            }
+        }
+        else
+        {
+            memset (client->devices_used, 0, context->vfio_devices.num_devices * sizeof (client->devices_used[0]));
+        }
 
-                    /* Attempt to obtain identity information of the connected client, for reporting diagnostic information.
-                     * Failure to obtain the identity isn't considered an error, in case lack of permissions. */
-                    socklen_t sock_len = sizeof (client->credentials);
+        /* Attempt to obtain identity information of the connected client, for reporting diagnostic information.
+         * Failure to obtain the identity isn't considered an error, in case lack of permissions. */
+        socklen_t sock_len = sizeof (client->credentials);
 
-                    memset (client->description, 0, sizeof (client->description));
-                    rc = getsockopt (new_client_fd, SOL_SOCKET, SO_PEERCRED, &client->credentials, &sock_len);
-                    client->credentials_valid = rc == 0;
-                    client->exe_pathname_valid = false;
-                    if (client->credentials_valid)
-                    {
-                        char pid_exe_symlink[PATH_MAX];
-                        ssize_t exe_pathname_len;
+        memset (client->description, 0, sizeof (client->description));
+        rc = getsockopt (new_client_fd, SOL_SOCKET, SO_PEERCRED, &client->credentials, &sock_len);
+        client->credentials_valid = rc == 0;
+        client->exe_pathname_valid = false;
+        if (client->credentials_valid)
+        {
+            char pid_exe_symlink[PATH_MAX];
+            ssize_t exe_pathname_len;
 
-                        snprintf (client->description, sizeof (client->description), " PID %d", client->credentials.pid);
-                        snprintf (pid_exe_symlink, sizeof (pid_exe_symlink), "/proc/%d/exe", client->credentials.pid);
-                        exe_pathname_len = readlink (pid_exe_symlink, client->exe_pathname, sizeof (client->exe_pathname) - 1);
-                        if (exe_pathname_len > 0)
-                        {
-                            client->exe_pathname[exe_pathname_len] = '\0';
+            snprintf (client->description, sizeof (client->description), " PID %d", client->credentials.pid);
+            snprintf (pid_exe_symlink, sizeof (pid_exe_symlink), "/proc/%d/exe", client->credentials.pid);
+            exe_pathname_len = readlink (pid_exe_symlink, client->exe_pathname, sizeof (client->exe_pathname) - 1);
+            if (exe_pathname_len > 0)
+            {
+                client->exe_pathname[exe_pathname_len] = '\0';
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wrestrict"
-                            /* Suppress warning of the form, which was seen with GCC 10.3.1 when compiling for the release platform:
-                             *   warning: 'snprintf' argument 5 may overlap destination object 'context' [-Wrestrict]
-                             *
-                             * "Bug 102919 - spurious -Wrestrict warning for sprintf into the same member array as argument plus offset"
-                             * https://gcc.gnu.org/bugzilla/show_bug.cgi?id=102919 suggests this is a spurious warning
-                             */
-                            snprintf (client->description, sizeof (client->description),
-                                    " PID %d %s", client->credentials.pid, client->exe_pathname);
+                /* Suppress warning of the form, which was seen with GCC 10.3.1 when compiling for the release platform:
+                 *   warning: 'snprintf' argument 5 may overlap destination object 'context' [-Wrestrict]
+                 *
+                 * "Bug 102919 - spurious -Wrestrict warning for sprintf into the same member array as argument plus offset"
+                 * https://gcc.gnu.org/bugzilla/show_bug.cgi?id=102919 suggests this is a spurious warning
+                 */
+                snprintf (client->description, sizeof (client->description),
+                        " PID %d %s", client->credentials.pid, client->exe_pathname);
 #pragma GCC diagnostic pop
-                            client->exe_pathname_valid = true;
-                        }
-                    }
-                    update_maximum_used_clients (context);
-                    client_added = true;
-                }
-            }
-        }
-        else
-        {
-            /* Compile time maximum number of clients already connected */
-            printf ("Unable to accept new client as client_socket_fds[] array full\n");
-            rc = close (new_client_fd);
-            if (rc != 0)
-            {
-                printf ("close() failed\n");
-                exit (EXIT_FAILURE);
+                client->exe_pathname_valid = true;
             }
         }
+        update_maximum_used_clients (context);
     }
     else
     {
@@ -494,14 +534,14 @@ static uint32_t unset_container_on_inactive_groups (vfio_iommu_container_t *cons
     num_active_groups = 0;
     for (uint32_t group_index = 0; group_index < container->num_iommu_groups; group_index++)
     {
-        vfio_iommu_group_t *const group = &container->iommu_groups[group_index];
+        vfio_iommu_group_t *const group = container->iommu_groups[group_index];
 
         /* Count the number of devices currently open in the group */
         num_devices_open_in_group = 0;
         for (uint32_t device_index = 0; device_index < container->vfio_devices->num_devices; device_index++)
         {
-            if ((container->vfio_devices->devices[device_index].group == group) &&
-                (container->vfio_devices->devices[device_index].device_fd >= 0))
+            if ((container->vfio_devices->devices[device_index]->group == group) &&
+                (container->vfio_devices->devices[device_index]->device_fd >= 0))
             {
                 num_devices_open_in_group++;
             }
@@ -556,7 +596,7 @@ static void disable_unused_containers (vfio_manager_context_t *const context)
     /* Iterate over all containers */
     for (uint32_t container_index = 0; container_index < context->vfio_devices.num_containers; container_index++)
     {
-        vfio_iommu_container_t *const container = &context->vfio_devices.containers[container_index];
+        vfio_iommu_container_t *const container = context->vfio_devices.containers[container_index];
 
         /* Check any containers which are currently enabled */
         if (container->container_enabled)
@@ -618,15 +658,16 @@ static void close_device_for_client (vfio_manager_context_t *const context,
 
     /* Determine if the device is still in use by any other clients */
     bool device_still_used = false;
-    for (uint32_t scan_index = 0; !device_still_used && (scan_index < VFIO_MAX_CLIENTS); scan_index++)
+    for (uint32_t scan_index = 0; !device_still_used && (scan_index < context->maximum_used_clients); scan_index++)
     {
-        device_still_used = context->clients[scan_index].devices_used[device_index];
+        device_still_used = (context->clients[scan_index].devices_used != NULL) &&
+                context->clients[scan_index].devices_used[device_index];
     }
 
     if (!device_still_used)
     {
         /* Once the device is no longer used by any client, then close the device */
-        vfio_device_t *const device = &context->vfio_devices.devices[device_index];
+        vfio_device_t *const device = context->vfio_devices.devices[device_index];
 
         errno = 0;
         rc = close (device->device_fd);
@@ -667,7 +708,7 @@ static void close_client_connection (vfio_manager_context_t *const context, cons
     bool region_outstanding;
     for (uint32_t container_index = 0; container_index < context->vfio_devices.num_containers; container_index++)
     {
-        vfio_iommu_container_t *const container = &context->vfio_devices.containers[container_index];
+        vfio_iommu_container_t *const container = context->vfio_devices.containers[container_index];
 
         do
         {
@@ -701,11 +742,33 @@ static void close_client_connection (vfio_manager_context_t *const context, cons
         if (client->devices_used[device_index])
         {
             printf ("Client%s still had device %s open at client connection close\n",
-                    client->description, context->vfio_devices.devices[device_index].device_name);
+                    client->description, context->vfio_devices.devices[device_index]->device_name);
             close_device_for_client (context, client_index, device_index);
         }
     }
 
+    /* Free any resource leases held, or waited for, by the client. This allows leases held by a crashed client to be
+     * granted to other clients. */
+    uint32_t num_outstanding_leases = 0;
+    for (uint32_t lease_index = 0; lease_index < context->leases_allocated_length; lease_index++)
+    {
+        vfio_resource_lease_t *const lease = &context->leases[lease_index];
+
+        if (lease->in_use && (lease->client_index == client_index))
+        {
+            if (lease->granted)
+            {
+                num_outstanding_leases++;
+            }
+            lease->in_use = false;
+        }
+    }
+    if (num_outstanding_leases > 0)
+    {
+        printf ("Client%s still held %u resource leases at client connection close\n",
+                client->description, num_outstanding_leases);
+    }
+
     disable_unused_containers (context);
 
     /* Close the socket for the client */
@@ -733,7 +796,7 @@ static vfio_device_t *find_client_requested_device (vfio_manager_context_t *cons
 {
     for (*device_index = 0; (*device_index < context->vfio_devices.num_devices); (*device_index)++)
     {
-        vfio_device_t *const candidate_device = &context->vfio_devices.devices[*device_index];
+        vfio_device_t *const candidate_device = context->vfio_devices.devices[*device_index];
 
         if ((candidate_device->pci_dev->domain == device_id->domain) &&
             (candidate_device->pci_dev->bus    == device_id->bus   ) &&
@@ -763,7 +826,7 @@ static vfio_iommu_container_t *find_client_requested_container (vfio_manager_con
 {
     if (container_id < context->vfio_devices.num_containers)
     {
-        return &context->vfio_devices.containers[container_id];
+        return context->vfio_devices.containers[container_id];
     }
     else
     {
@@ -841,13 +904,6 @@ static void process_open_device_request (vfio_manager_context_t *const context,
         {
             /* On success complete the reply and indicate the client is using the device */
             tx_buffer.open_device_reply.iommu_type = device->group->container->iommu_type;
-            tx_buffer.open_device_reply.num_iommu_groups = device->group->container->num_iommu_groups;
-            for (group_index = 0; group_index < device->group->container->num_iommu_groups; group_index++)
-            {
-                snprintf (tx_buffer.open_device_reply.iommu_group_names[group_index],
-                        sizeof (tx_buffer.open_device_reply.iommu_group_names[group_index]),
-                        "%s", device->group->container->iommu_groups[group_index].iommu_group_name);
-            }
             tx_buffer.open_device_reply.container_id = device->group->container->container_id;
             vfio_fds.device_fd = device->device_fd;
             vfio_fds.container_fd = request->container_fd_required ? device->group->container->container_fd : -1;
@@ -1018,6 +1074,265 @@ static void process_exclusive_access_request (vfio_manager_context_t *const cont
 }
 
 
+/**
+ * @brief Calculate the deadline for a resource lease, allowing for no time limit
+ * @param[in] now_ns The current time
+ * @param[in] duration_ns The duration from now to the deadline
+ * @return The deadline, or VFIO_RESOURCE_LEASE_INFINITE_NS if no time limit
+ */
+static uint64_t get_lease_deadline_ns (const uint64_t now_ns, const uint64_t duration_ns)
+{
+    return (duration_ns >= (VFIO_RESOURCE_LEASE_INFINITE_NS - now_ns)) ? VFIO_RESOURCE_LEASE_INFINITE_NS : now_ns + duration_ns;
+}
+
+
+/**
+ * @brief Display a diagnostic message about a resource lease
+ * @param[in] context The manager context containing the lease
+ * @param[in] lease The lease to display the message for
+ * @param[in] event Describes what has happened to the lease
+ */
+static void report_lease_event (const vfio_manager_context_t *const context, const vfio_resource_lease_t *const lease,
+                                const char *const event)
+{
+    printf ("Client%s %s for %s %u in device %s\n",
+            context->clients[lease->client_index].description, event,
+            vfio_resource_type_name (lease->resource_type), lease->resource_index,
+            context->vfio_devices.devices[lease->device_index]->device_name);
+}
+
+
+/**
+ * @brief Find a granted lease on a resource
+ * @param[in] context The manager context to search
+ * @param[in] device_index Identifies the device containing the resource
+ * @param[in] resource_type The type of the resource
+ * @param[in] resource_index Identifies the instance of the resource in the device
+ * @return The granted lease for the resource, or NULL if the resource is free
+ */
+static vfio_resource_lease_t *find_granted_lease (vfio_manager_context_t *const context, const uint32_t device_index,
+                                                  const vfio_resource_type_t resource_type, const uint32_t resource_index)
+{
+    for (uint32_t lease_index = 0; lease_index < context->leases_allocated_length; lease_index++)
+    {
+        vfio_resource_lease_t *const lease = &context->leases[lease_index];
+
+        if (lease->in_use && lease->granted && (lease->device_index == device_index) &&
+            (lease->resource_type == resource_type) && (lease->resource_index == resource_index))
+        {
+            return lease;
+        }
+    }
+
+    return NULL;
+}
+
+
+/**
+ * @brief Send the reply to a client for a request to acquire a resource lease
+ * @param[in] context The manager context containing the lease
+ * @param[in] client_index Identifies the client to send the reply to
+ * @param[in] success Indicates if the lease was granted
+ * @param[in] lease_id When success is true, the granted lease
+ */
+static void send_acquire_lease_reply (vfio_manager_context_t *const context, const uint32_t client_index,
+                                      const bool success, const uint32_t lease_id)
+{
+    vfio_manage_messages_t tx_buffer = {0};
+
+    tx_buffer.acquire_lease_reply.msg_id = VFIO_MANAGE_MSG_ID_ACQUIRE_LEASE_REPLY;
+    tx_buffer.acquire_lease_reply.success = success;
+    tx_buffer.acquire_lease_reply.lease_id = lease_id;
+    vfio_send_manage_message (context->clients[client_index].client_socket_fd, &tx_buffer, NULL);
+}
+
+
+/**
+ * @brief Service the resource leases, which is called every time around the run loop
+ * @details This:
+ *          a. Expires granted leases which have reached their deadline.
+ *          b. Grants waiting requests for free resources, in FIFO order.
+ *          c. Fails waiting requests which have timed out.
+ *          Expired leases are freed before granting, so that an expired lease allows a waiting request to be granted.
+ *          Granting happens before timeouts, so that a request with a zero wait timeout is granted if the resource is free.
+ * @param[in/out] context The manager context containing the leases
+ * @return The earliest deadline of the remaining leases, or VFIO_RESOURCE_LEASE_INFINITE_NS if no deadlines
+ */
+static uint64_t service_resource_leases (vfio_manager_context_t *const context)
+{
+    const uint64_t now_ns = (uint64_t) get_monotonic_time ();
+    uint64_t earliest_deadline_ns = VFIO_RESOURCE_LEASE_INFINITE_NS;
+    vfio_resource_lease_t *oldest_request;
+    uint32_t lease_index;
+
+    /* Expire granted leases */
+    for (lease_index = 0; lease_index < context->leases_allocated_length; lease_index++)
+    {
+        vfio_resource_lease_t *const lease = &context->leases[lease_index];
+
+        if (lease->in_use && lease->granted && (lease->deadline_ns <= now_ns))
+        {
+            report_lease_event (context, lease, "lease expired");
+            lease->in_use = false;
+        }
+    }
+
+    /* Grant waiting requests for free resources. Each iteration grants the oldest waiting request whose resource is free,
+     * which means requests for the same resource are granted in the order they were received. */
+    do
+    {
+        oldest_request = NULL;
+        for (lease_index = 0; lease_index < context->leases_allocated_length; lease_index++)
+        {
+            vfio_resource_lease_t *const lease = &context->leases[lease_index];
+
+            if (lease->in_use && !lease->granted &&
+                ((oldest_request == NULL) || (lease->request_sequence < oldest_request->request_sequence)) &&
+                (find_granted_lease (context, lease->device_index, lease->resource_type, lease->resource_index) == NULL))
+            {
+                oldest_request = lease;
+            }
+        }
+
+        if (oldest_request != NULL)
+        {
+            oldest_request->granted = true;
+            oldest_request->lease_id = context->next_lease_id++;
+            oldest_request->deadline_ns = get_lease_deadline_ns (now_ns, oldest_request->lease_duration_ns);
+            send_acquire_lease_reply (context, oldest_request->client_index, true, oldest_request->lease_id);
+        }
+    } while (oldest_request != NULL);
+
+    /* Fail waiting requests which have timed out, and determine the earliest deadline of the remaining leases */
+    for (lease_index = 0; lease_index < context->leases_allocated_length; lease_index++)
+    {
+        vfio_resource_lease_t *const lease = &context->leases[lease_index];
+
+        if (lease->in_use)
+        {
+            if (!lease->granted && (lease->deadline_ns <= now_ns))
+            {
+                report_lease_event (context, lease, "timed out waiting for lease");
+                send_acquire_lease_reply (context, lease->client_index, false, 0);
+                lease->in_use = false;
+            }
+            else if (lease->deadline_ns < earliest_deadline_ns)
+            {
+                earliest_deadline_ns = lease->deadline_ns;
+            }
+        }
+    }
+
+    return earliest_deadline_ns;
+}
+
+
+/**
+ * @brief Process a request from a connected client to acquire a resource lease
+ * @details The reply is sent immediately if the request is invalid, or renews an existing lease held by the client.
+ *          Otherwise the request is queued, and service_resource_leases() sends the reply once the lease has been granted
+ *          or the wait has timed out. The client is blocked waiting for the reply, while the manager continues to
+ *          service other clients.
+ * @param[in/out] context The manager context to update with the request
+ * @param[in] client_index Identifies which client sent the request
+ * @param[in] request The request received from the client, which identifies the resource
+ */
+static void process_acquire_lease_request (vfio_manager_context_t *const context, const uint32_t client_index,
+                                           const vfio_acquire_lease_request_t *const request)
+{
+    vfio_client_data_t *const client = &context->clients[client_index];
+    const uint64_t now_ns = (uint64_t) get_monotonic_time ();
+    uint32_t device_index;
+    uint32_t lease_index;
+
+    /* Validate the request */
+    vfio_device_t *const device = find_client_requested_device (context, &request->device_id, &device_index);
+    if (device == NULL)
+    {
+        send_acquire_lease_reply (context, client_index, false, 0);
+        return;
+    }
+    if (!client->devices_used[device_index])
+    {
+        printf ("Client%s requested lease on device %s which the client isn't using\n", client->description, device->device_name);
+        send_acquire_lease_reply (context, client_index, false, 0);
+        return;
+    }
+    if (request->resource_type >= VFIO_RESOURCE_TYPE_ARRAY_SIZE)
+    {
+        printf ("Client%s requested lease on invalid resource type %u\n", client->description, request->resource_type);
+        send_acquire_lease_reply (context, client_index, false, 0);
+        return;
+    }
+
+    /* If the client already holds the lease, renew it */
+    vfio_resource_lease_t *const existing_lease =
+            find_granted_lease (context, device_index, request->resource_type, request->resource_index);
+    if ((existing_lease != NULL) && (existing_lease->client_index == client_index))
+    {
+        existing_lease->lease_duration_ns = request->lease_duration_ns;
+        existing_lease->deadline_ns = get_lease_deadline_ns (now_ns, request->lease_duration_ns);
+        send_acquire_lease_reply (context, client_index, true, existing_lease->lease_id);
+        return;
+    }
+
+    /* Queue the request, re-using the first unused entry */
+    for (lease_index = 0; (lease_index < context->leases_allocated_length) && context->leases[lease_index].in_use; lease_index++)
+    {
+    }
+    context->leases = vfio_grow_array (context->leases, &context->leases_allocated_length, lease_index + 1,
+            sizeof (context->leases[0]), "leases");
+
+    vfio_resource_lease_t *const new_lease = &context->leases[lease_index];
+    new_lease->in_use = true;
+    new_lease->granted = false;
+    new_lease->client_index = client_index;
+    new_lease->device_index = device_index;
+    new_lease->resource_type = request->resource_type;
+    new_lease->resource_index = request->resource_index;
+    new_lease->lease_id = 0;
+    new_lease->request_sequence = context->next_request_sequence++;
+    new_lease->lease_duration_ns = request->lease_duration_ns;
+    new_lease->deadline_ns = get_lease_deadline_ns (now_ns, request->wait_timeout_ns);
+}
+
+
+/**
+ * @brief Process a request from a connected client to release a resource lease, sending a reply
+ * @param[in/out] context The manager context to update with the request
+ * @param[in] client_index Identifies which client sent the request, to validate the request
+ * @param[in] request The request received from the client, which identifies the lease to release
+ */
+static void process_release_lease_request (vfio_manager_context_t *const context, const uint32_t client_index,
+                                           const vfio_release_lease_request_t *const request)
+{
+    vfio_client_data_t *const client = &context->clients[client_index];
+    vfio_manage_messages_t tx_buffer = {0};
+
+    tx_buffer.release_lease_reply.msg_id = VFIO_MANAGE_MSG_ID_RELEASE_LEASE_REPLY;
+    tx_buffer.release_lease_reply.success = false;
+    for (uint32_t lease_index = 0;
+         !tx_buffer.release_lease_reply.success && (lease_index < context->leases_allocated_length);
+         lease_index++)
+    {
+        vfio_resource_lease_t *const lease = &context->leases[lease_index];
+
+        if (lease->in_use && lease->granted && (lease->client_index == client_index) && (lease->lease_id == request->lease_id))
+        {
+            lease->in_use = false;
+            tx_buffer.release_lease_reply.success = true;
+        }
+    }
+
+    if (!tx_buffer.release_lease_reply.success)
+    {
+        printf ("Client%s released lease_id %u which it doesn't hold\n", client->description, request->lease_id);
+    }
+
+    vfio_send_manage_message (client->client_socket_fd, &tx_buffer, NULL);
+}
+
+
 /**
  * @brief The run loop for the VFIO manager
  * @param[in/out] context The initialised context to manage.
@@ -1025,7 +1340,7 @@ static void process_exclusive_access_request (vfio_manager_context_t *const cont
  */
 static void run_vfio_manager (vfio_manager_context_t *const context)
 {
-    struct pollfd poll_fds[VFIO_MAX_FDS] = {0};
+    struct pollfd *poll_fds;
     uint32_t num_fds;
     uint32_t client_index;
     int num_ready_fds;
@@ -1033,6 +1348,9 @@ static void run_vfio_manager (vfio_manager_context_t *const context)
     vfio_manage_messages_t rx_buffer;
     bool valid_message;
     bool close_connection;
+    uint64_t earliest_deadline_ns;
+    uint64_t now_ns;
+    struct timespec poll_timeout;
 
     /* Run servicing requests from clients, until requested to shutdown */
     context->shutdown_pending = false;
@@ -1042,6 +1360,9 @@ static void run_vfio_manager (vfio_manager_context_t *const context)
         /* Create the list of fds to poll as the listening socket and all currently connected clients.
          * clients[] might be sparse, but entries for unconnected clients have a value of -1 and poll()
          * ignores any fds with a negative value. */
+        context->poll_fds = vfio_grow_array (context->poll_fds, &context->poll_fds_allocated_length,
+                1 + context->maximum_used_clients, sizeof (context->poll_fds[0]), "poll_fds");
+        poll_fds = context->poll_fds;
         num_fds = 0;
         poll_fds[num_fds].fd = context->listening_socket_fd;
         poll_fds[num_fds].events = POLLIN;
@@ -1055,11 +1376,25 @@ static void run_vfio_manager (vfio_manager_context_t *const context)
             num_fds++;
         }
 
-        /* Wait for a socket to be readable with no timeout */
+        /* Service resource leases, and when any have a deadline limit the time waiting for a socket to be readable
+         * so that the deadline is processed. */
+        earliest_deadline_ns = service_resource_leases (context);
+        if (earliest_deadline_ns != VFIO_RESOURCE_LEASE_INFINITE_NS)
+        {
+            now_ns = (uint64_t) get_monotonic_time ();
+            const uint64_t timeout_ns = (earliest_deadline_ns > now_ns) ? (earliest_deadline_ns - now_ns) : 0;
+
+            poll_timeout.tv_sec = (time_t) (timeout_ns / 1000000000UL);
+            poll_timeout.tv_nsec = (long) (timeout_ns % 1000000000UL);
+        }
+
+        /* Wait for a socket to be readable */
         errno = 0;
-        num_ready_fds = ppoll (poll_fds, num_fds, NULL, &context->signal_mask_during_ppoll);
+        num_ready_fds = ppoll (poll_fds, num_fds,
+                (earliest_deadline_ns != VFIO_RESOURCE_LEASE_INFINITE_NS) ? &poll_timeout : NULL,
+                &context->signal_mask_during_ppoll);
         saved_errno = errno;
-        if ((num_ready_fds <= 0) && (saved_errno != EINTR) && (saved_errno != EAGAIN))
+        if ((num_ready_fds < 0) && (saved_errno != EINTR) && (saved_errno != EAGAIN))
         {
             fprintf (stderr, "poll() failed : %s\n", strerror (saved_errno));
             exit (EXIT_FAILURE);
@@ -1108,6 +1443,14 @@ static void run_vfio_manager (vfio_manager_context_t *const context)
                                 process_exclusive_access_request (context, client_index);
                                 break;
 
+                            case VFIO_MANAGE_MSG_ID_ACQUIRE_LEASE_REQUEST:
+                                process_acquire_lease_request (context, client_index, &rx_buffer.acquire_lease_request);
+                                break;
+
+                            case VFIO_MANAGE_MSG_ID_RELEASE_LEASE_REQUEST:
+                                process_release_lease_request (context, client_index, &rx_buffer.release_lease_request);
+                                break;
+
                             default:
                                 printf ("Received unexpected message ID %u for manager\n", rx_buffer.msg_id);
                                 valid_message = false;
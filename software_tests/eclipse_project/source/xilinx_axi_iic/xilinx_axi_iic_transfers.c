@@ -4,7 +4,14 @@
  * @author Chester Gillon
  * @brief Provides I2C transfers using the Xilinx "AXI IIC Bus Interface" which is accessed via VFIO from the host.
  * @details
- *  Uses "Standard Mode", so the transfer lengths are not limited by the 8-bit Dynamic Mode transfer length.
+ *  iic_read() and iic_write() use "Standard Mode", so the transfer lengths are not limited by the 8-bit Dynamic Mode transfer
+ *  length. They handshake each byte with the IIC.
+ *
+ *  iic_register_read(), iic_register_write() and iic_chained_register_read() use "Dynamic Mode" sequences for devices with a
+ *  byte register address, such as SFF module memory maps and EEPROMs. The complete sequence of START, address, STOP and
+ *  receive byte count is queued in the TX FIFO, and the received data is drained from the RX FIFO in batches of up to the
+ *  FIFO depth using the RX_FIFO_PIRQ threshold. This reduces the register accesses per byte, and the time the IIC throttles
+ *  the bus waiting for software.
  *
  *  Restrictions are:
  *  a. Polls for transfer completion, so can't overlap with other work.
@@ -498,3 +505,385 @@ iic_transfer_status_t iic_write (iic_controller_context_t *const controller, con
 
     return status;
 }
+
+
+/**
+ * @brief Abort a dynamic mode sequence which has failed, leaving the IIC disabled and the bus free
+ * @details Flushes the TX FIFO so no further sequence items are actioned, then waits for the IIC to release the bus.
+ *          Any data left in the RX FIFO is discarded.
+ * @param[in] controller The IIC controller context to use
+ */
+static void iic_dynamic_abort (iic_controller_context_t *const controller)
+{
+    uint32_t iic_sr;
+
+    write_reg32 (controller->iic_regs, IIC_CONTROL_REGISTER_OFFSET, IIC_CR_EN_MASK | IIC_CR_TX_FIFO_RESET_MASK);
+    write_reg32 (controller->iic_regs, IIC_CONTROL_REGISTER_OFFSET, IIC_CR_EN_MASK);
+    do
+    {
+        iic_sr = read_reg32 (controller->iic_regs, IIC_STATUS_REGISTER_OFFSET);
+        if ((iic_sr & IIC_SR_RX_FIFO_EMPTY_MASK) == 0)
+        {
+            (void) read_reg32 (controller->iic_regs, IIC_RX_FIFO_OFFSET);
+        }
+    } while ((iic_sr & (IIC_SR_BB_MASK | IIC_SR_RX_FIFO_EMPTY_MASK)) != IIC_SR_RX_FIFO_EMPTY_MASK);
+
+    write_reg32 (controller->iic_regs, IIC_CONTROL_REGISTER_OFFSET, 0);
+}
+
+
+/**
+ * @brief Prepare the IIC to start a dynamic mode sequence
+ * @param[in] controller The IIC controller context to use
+ * @return Returns IIC_TRANSFER_STATUS_SUCCESS if the bus is free to start the sequence
+ */
+static iic_transfer_status_t iic_dynamic_prepare (iic_controller_context_t *const controller)
+{
+    iic_transfer_status_t status;
+
+    /* Dynamic mode sequences always start with a START and end with a STOP, so the bus can't already be claimed */
+    if (controller->bus_claimed)
+    {
+        return IIC_TRANSFER_STATUS_BUS_BUSY;
+    }
+
+    status = iic_check_bus_state_before_transfer (controller);
+    if (status == IIC_TRANSFER_STATUS_SUCCESS)
+    {
+        /* Flush any stale TX FIFO contents, then enable the IIC with MSMS clear so that the dynamic START bit generates
+         * a START rather than a repeated START */
+        write_reg32 (controller->iic_regs, IIC_CONTROL_REGISTER_OFFSET, IIC_CR_EN_MASK | IIC_CR_TX_FIFO_RESET_MASK);
+        write_reg32 (controller->iic_regs, IIC_CONTROL_REGISTER_OFFSET, IIC_CR_EN_MASK);
+        iic_clear_isr (controller, IIC_ISR_ARBITRATION_LOST_MASK | IIC_ISR_TRANSMIT_ERROR_SLAVE_TRANSMIT_COMPLETE_MASK |
+                IIC_ISR_RECEIVE_FIFO_FULL_MASK);
+    }
+
+    return status;
+}
+
+
+/**
+ * @brief Queue one item for a dynamic mode sequence in the TX FIFO, waiting for space in the TX FIFO if required
+ * @param[in] controller The IIC controller context to use
+ * @param[in] tx_fifo_item The value to write to the TX FIFO, which can include the dynamic START and STOP bits
+ * @return Returns IIC_TRANSFER_STATUS_SUCCESS if the item was queued, or the error if the sequence has failed
+ */
+static iic_transfer_status_t iic_dynamic_queue (iic_controller_context_t *const controller, const uint32_t tx_fifo_item)
+{
+    uint32_t iic_sr;
+    uint32_t iic_isr;
+
+    for (;;)
+    {
+        iic_sr = read_reg32 (controller->iic_regs, IIC_STATUS_REGISTER_OFFSET);
+        if ((iic_sr & IIC_SR_TX_FIFO_FULL_MASK) == 0)
+        {
+            write_reg32 (controller->iic_regs, IIC_TX_FIFO_OFFSET, tx_fifo_item);
+            return IIC_TRANSFER_STATUS_SUCCESS;
+        }
+
+        /* Only check for errors when need to wait for space */
+        iic_isr = read_reg32 (controller->iic_regs, IIC_INTERRUPT_STATUS_REGISTER_OFFSET);
+        if ((iic_isr & IIC_ISR_ARBITRATION_LOST_MASK) != 0)
+        {
+            return IIC_TRANSFER_STATUS_ARBITRATION_LOST;
+        }
+        else if ((iic_isr & IIC_ISR_TRANSMIT_ERROR_SLAVE_TRANSMIT_COMPLETE_MASK) != 0)
+        {
+            return IIC_TRANSFER_STATUS_NO_ACK;
+        }
+    }
+}
+
+
+/**
+ * @brief Wait for a dynamic mode sequence which only transmits to complete, by the STOP having freed the bus
+ * @details The sequence has at least the address, register address and one data byte queued in the TX FIFO.
+ *          The TX FIFO can only drain by transmitting on the bus, so the TX FIFO empty with the bus not busy
+ *          means the STOP has completed. This avoids the race in iic_read() of having to sample the bus as busy.
+ * @param[in] controller The IIC controller context to use
+ * @return Returns IIC_TRANSFER_STATUS_SUCCESS if the sequence completed without error
+ */
+static iic_transfer_status_t iic_dynamic_wait_transmit_complete (iic_controller_context_t *const controller)
+{
+    const uint32_t complete_mask = IIC_SR_TX_FIFO_EMPTY_MASK | IIC_SR_BB_MASK;
+    uint32_t iic_sr;
+    uint32_t iic_isr;
+
+    for (;;)
+    {
+        iic_isr = read_reg32 (controller->iic_regs, IIC_INTERRUPT_STATUS_REGISTER_OFFSET);
+        if ((iic_isr & IIC_ISR_ARBITRATION_LOST_MASK) != 0)
+        {
+            return IIC_TRANSFER_STATUS_ARBITRATION_LOST;
+        }
+        else if ((iic_isr & IIC_ISR_TRANSMIT_ERROR_SLAVE_TRANSMIT_COMPLETE_MASK) != 0)
+        {
+            return IIC_TRANSFER_STATUS_NO_ACK;
+        }
+
+        iic_sr = read_reg32 (controller->iic_regs, IIC_STATUS_REGISTER_OFFSET);
+        if ((iic_sr & complete_mask) == IIC_SR_TX_FIFO_EMPTY_MASK)
+        {
+            return IIC_TRANSFER_STATUS_SUCCESS;
+        }
+    }
+}
+
+
+/**
+ * @brief Receive the data for a dynamic mode read sequence, draining the RX FIFO in batches
+ * @details RX_FIFO_PIRQ is set so the receive FIFO full interrupt status is set once a batch of up to the FIFO depth has been
+ *          received. The IIC throttles the bus if the RX FIFO fills before software reads it, so data can't be lost.
+ *          The number of bytes read from the RX FIFO is taken from the occupancy, rather than assuming the batch size.
+ * @param[in] controller The IIC controller context to use
+ * @param[in] num_bytes The number of bytes to receive
+ * @param[out] data The received bytes
+ * @return Returns IIC_TRANSFER_STATUS_SUCCESS if all bytes were received
+ */
+static iic_transfer_status_t iic_dynamic_receive (iic_controller_context_t *const controller,
+                                                  const size_t num_bytes, uint8_t data[const num_bytes])
+{
+    size_t num_received = 0;
+    uint32_t iic_isr;
+    uint32_t iic_sr;
+
+    while (num_received < num_bytes)
+    {
+        const size_t remaining_bytes = num_bytes - num_received;
+        const size_t batch_size = (remaining_bytes < IIC_FIFO_DEPTH) ? remaining_bytes : IIC_FIFO_DEPTH;
+
+        /* Set the occupancy which sets the receive FIFO full interrupt status (zero based) */
+        write_reg32 (controller->iic_regs, IIC_RX_FIFO_PIRQ_OFFSET, (uint32_t) (batch_size - 1));
+
+        /* Wait for the batch. Check the receive status before the errors, since a NACK of the last byte is expected */
+        for (;;)
+        {
+            iic_isr = read_reg32 (controller->iic_regs, IIC_INTERRUPT_STATUS_REGISTER_OFFSET);
+            if ((iic_isr & IIC_ISR_RECEIVE_FIFO_FULL_MASK) != 0)
+            {
+                break;
+            }
+            else if ((iic_isr & IIC_ISR_ARBITRATION_LOST_MASK) != 0)
+            {
+                return IIC_TRANSFER_STATUS_ARBITRATION_LOST;
+            }
+            else if ((iic_isr & IIC_ISR_TRANSMIT_ERROR_SLAVE_TRANSMIT_COMPLETE_MASK) != 0)
+            {
+                return IIC_TRANSFER_STATUS_NO_ACK;
+            }
+        }
+
+        /* Drain the available bytes. The occupancy register is zero based. */
+        iic_sr = read_reg32 (controller->iic_regs, IIC_STATUS_REGISTER_OFFSET);
+        if ((iic_sr & IIC_SR_RX_FIFO_EMPTY_MASK) == 0)
+        {
+            size_t num_available = read_reg32 (controller->iic_regs, IIC_RX_FIFO_OCY_OFFSET) + 1u;
+
+            if (num_available > remaining_bytes)
+            {
+                num_available = remaining_bytes;
+            }
+            for (size_t byte_index = 0; byte_index < num_available; byte_index++)
+            {
+                data[num_received] = (uint8_t) read_reg32 (controller->iic_regs, IIC_RX_FIFO_OFFSET);
+                num_received++;
+            }
+        }
+
+        /* Clear the latched interrupt status after reading the RX FIFO */
+        iic_clear_isr (controller, IIC_ISR_RECEIVE_FIFO_FULL_MASK);
+    }
+
+    /* Wait for the STOP to complete, which the dynamic STOP bit generates after the last byte was received */
+    do
+    {
+        iic_sr = read_reg32 (controller->iic_regs, IIC_STATUS_REGISTER_OFFSET);
+    } while ((iic_sr & IIC_SR_BB_MASK) != 0);
+
+    return IIC_TRANSFER_STATUS_SUCCESS;
+}
+
+
+/**
+ * @brief Perform a dynamic mode sequence to read from a device with a byte register address, of up to the maximum
+ *        receive byte count of a dynamic mode sequence
+ * @param[in] controller The IIC controller context to use
+ * @param[in] i2c_slave_address The 7-bit slave address to read from
+ * @param[in] reg_address The register address to start the read from
+ * @param[in] num_bytes The number of bytes to read, in the range 1 .. IIC_DYNAMIC_MAX_READ_BYTES
+ * @param[out] data The bytes read
+ * @return Returns IIC_TRANSFER_STATUS_SUCCESS if the read was successful.
+ */
+static iic_transfer_status_t iic_dynamic_register_read (iic_controller_context_t *const controller,
+                                                        const uint8_t i2c_slave_address, const uint8_t reg_address,
+                                                        const size_t num_bytes, uint8_t data[const num_bytes])
+{
+    const uint32_t write_address = (uint32_t) ((i2c_slave_address << 1) & 0xFE) | IIC_RX_FIFO_WRITE_OPERATION;
+    const uint32_t read_address = (uint32_t) ((i2c_slave_address << 1) & 0xFE) | IIC_TX_FIFO_READ_OPERATION;
+    iic_transfer_status_t status;
+
+    status = iic_dynamic_prepare (controller);
+
+    /* Write the register address, then a repeated START to receive the data followed by a STOP */
+    if (status == IIC_TRANSFER_STATUS_SUCCESS)
+    {
+        status = iic_dynamic_queue (controller, IIC_TX_FIFO_START_MASK | write_address);
+    }
+    if (status == IIC_TRANSFER_STATUS_SUCCESS)
+    {
+        status = iic_dynamic_queue (controller, reg_address);
+    }
+    if (status == IIC_TRANSFER_STATUS_SUCCESS)
+    {
+        status = iic_dynamic_queue (controller, IIC_TX_FIFO_START_MASK | read_address);
+    }
+    if (status == IIC_TRANSFER_STATUS_SUCCESS)
+    {
+        status = iic_dynamic_queue (controller, IIC_TX_FIFO_STOP_MASK | (uint32_t) num_bytes);
+    }
+
+    if (status == IIC_TRANSFER_STATUS_SUCCESS)
+    {
+        status = iic_dynamic_receive (controller, num_bytes, data);
+    }
+
+    if (status == IIC_TRANSFER_STATUS_SUCCESS)
+    {
+        write_reg32 (controller->iic_regs, IIC_CONTROL_REGISTER_OFFSET, 0);
+    }
+    else
+    {
+        iic_dynamic_abort (controller);
+    }
+
+    return status;
+}
+
+
+/**
+ * @brief Read from a device with a byte register address, using dynamic mode sequences
+ * @details Reads longer than the maximum receive byte count of one dynamic mode sequence are split into multiple sequences,
+ *          which assumes the device auto-increments the register address as the bytes are read.
+ * @param[in,out] controller The IIC controller context to use
+ * @param[in] i2c_slave_address The 7-bit slave address to read from
+ * @param[in] reg_address The register address to start the read from
+ * @param[in] num_bytes The number of bytes to read
+ * @param[out] data The bytes read
+ * @return Returns IIC_TRANSFER_STATUS_SUCCESS if the read was successful.
+ */
+iic_transfer_status_t iic_register_read (iic_controller_context_t *const controller, const uint8_t i2c_slave_address,
+                                         const uint8_t reg_address, const size_t num_bytes, uint8_t data[const num_bytes])
+{
+    iic_transfer_status_t status = IIC_TRANSFER_STATUS_SUCCESS;
+    size_t num_read = 0;
+
+    while ((status == IIC_TRANSFER_STATUS_SUCCESS) && (num_read < num_bytes))
+    {
+        const size_t remaining_bytes = num_bytes - num_read;
+        const size_t sequence_bytes =
+                (remaining_bytes < IIC_DYNAMIC_MAX_READ_BYTES) ? remaining_bytes : IIC_DYNAMIC_MAX_READ_BYTES;
+
+        status = iic_dynamic_register_read (controller, i2c_slave_address, (uint8_t) (reg_address + num_read),
+                sequence_bytes, &data[num_read]);
+        num_read += sequence_bytes;
+    }
+
+    return status;
+}
+
+
+/**
+ * @brief Write to a device with a byte register address, using a dynamic mode sequence
+ * @details The caller is responsible for not exceeding any page write size of the device.
+ * @param[in,out] controller The IIC controller context to use
+ * @param[in] i2c_slave_address The 7-bit slave address to write to
+ * @param[in] reg_address The register address to start the write at
+ * @param[in] num_bytes The number of bytes to write, which must be at least one
+ * @param[in] data The bytes to write
+ * @return Returns IIC_TRANSFER_STATUS_SUCCESS if the write was successful.
+ */
+iic_transfer_status_t iic_register_write (iic_controller_context_t *const controller, const uint8_t i2c_slave_address,
+                                          const uint8_t reg_address, const size_t num_bytes, const uint8_t data[const num_bytes])
+{
+    const uint32_t write_address = (uint32_t) ((i2c_slave_address << 1) & 0xFE) | IIC_RX_FIFO_WRITE_OPERATION;
+    iic_transfer_status_t status;
+    size_t byte_index;
+
+    status = iic_dynamic_prepare (controller);
+
+    if (status == IIC_TRANSFER_STATUS_SUCCESS)
+    {
+        status = iic_dynamic_queue (controller, IIC_TX_FIFO_START_MASK | write_address);
+    }
+    if (status == IIC_TRANSFER_STATUS_SUCCESS)
+    {
+        status = iic_dynamic_queue (controller, reg_address);
+    }
+
+    /* Queue the data, with a STOP after the last byte */
+    for (byte_index = 0; (status == IIC_TRANSFER_STATUS_SUCCESS) && (byte_index < num_bytes); byte_index++)
+    {
+        const uint32_t stop = ((byte_index + 1) == num_bytes) ? IIC_TX_FIFO_STOP_MASK : 0;
+
+        status = iic_dynamic_queue (controller, stop | data[byte_index]);
+    }
+
+    if (status == IIC_TRANSFER_STATUS_SUCCESS)
+    {
+        status = iic_dynamic_wait_transmit_complete (controller);
+    }
+
+    if (status == IIC_TRANSFER_STATUS_SUCCESS)
+    {
+        write_reg32 (controller->iic_regs, IIC_CONTROL_REGISTER_OFFSET, 0);
+    }
+    else
+    {
+        iic_dynamic_abort (controller);
+    }
+
+    return status;
+}
+
+
+/**
+ * @brief Perform a chain of reads from devices with a byte register address, which may be paged, as one call.
+ * @details Intended to dump multiple pages from SFF module memory maps, where the upper memory is paged by a page select
+ *          register in the lower memory. Each read uses dynamic mode sequences. The page select write is skipped when
+ *          the previous read in the chain selected the same page on the same device.
+ * @param[in,out] controller The IIC controller context to use
+ * @param[in] page_select_address The register address of the page select byte, e.g. 127 for SFF-8636
+ * @param[in] num_reads The number of reads in the chain
+ * @param[in] reads Defines the reads to perform, in order
+ * @return Returns IIC_TRANSFER_STATUS_SUCCESS if all reads in the chain were successful.
+ *         On failure the chain is abandoned at the failing read.
+ */
+iic_transfer_status_t iic_chained_register_read (iic_controller_context_t *const controller, const uint8_t page_select_address,
+                                                 const size_t num_reads, const iic_chained_read_t reads[const num_reads])
+{
+    iic_transfer_status_t status = IIC_TRANSFER_STATUS_SUCCESS;
+    const iic_chained_read_t *selected_page_read = NULL;
+
+    for (size_t read_index = 0; (status == IIC_TRANSFER_STATUS_SUCCESS) && (read_index < num_reads); read_index++)
+    {
+        const iic_chained_read_t *const read = &reads[read_index];
+
+        if (read->select_page &&
+            ((selected_page_read == NULL) ||
+             (selected_page_read->i2c_slave_address != read->i2c_slave_address) ||
+             (selected_page_read->page_number != read->page_number)))
+        {
+            status = iic_register_write (controller, read->i2c_slave_address, page_select_address,
+                    sizeof (read->page_number), &read->page_number);
+            selected_page_read = read;
+        }
+
+        if (status == IIC_TRANSFER_STATUS_SUCCESS)
+        {
+            status = iic_register_read (controller, read->i2c_slave_address, read->start_address, read->num_bytes, read->data);
+        }
+    }
+
+    return status;
+}
@@ -10,6 +10,14 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+
+
+/* The depth of the TX and RX FIFOs in the IIC */
+#define IIC_FIFO_DEPTH 16
+
+/* The maximum number of bytes which can be received by one dynamic mode sequence, set by the 8-bit count */
+#define IIC_DYNAMIC_MAX_READ_BYTES 255
 
 /* The status for an I2C transfer */
 typedef enum
@@ -45,6 +53,22 @@ typedef struct
     bool bus_claimed;
 } iic_controller_context_t;
 
+/* Defines one read in a chain performed by iic_chained_register_read() */
+typedef struct
+{
+    /* The 7-bit slave address to read from */
+    uint8_t i2c_slave_address;
+    /* When true the page_number is written to the page select register before the read */
+    bool select_page;
+    uint8_t page_number;
+    /* The register address to start the read from */
+    uint8_t start_address;
+    /* The number of bytes to read */
+    size_t num_bytes;
+    /* Where to store the bytes read */
+    uint8_t *data;
+} iic_chained_read_t;
+
 
 iic_transfer_status_t iic_initialise_controller (iic_controller_context_t *const controller, uint8_t *const iic_regs);
 iic_transfer_status_t iic_read (iic_controller_context_t *const controller, const uint8_t i2c_slave_address,
@@ -53,5 +77,11 @@ iic_transfer_status_t iic_read (iic_controller_context_t *const controller, cons
 iic_transfer_status_t iic_write (iic_controller_context_t *const controller, const uint8_t i2c_slave_address,
                                  const size_t num_bytes, const uint8_t data[const num_bytes],
                                  const iic_transfer_option_t option);
+iic_transfer_status_t iic_register_read (iic_controller_context_t *const controller, const uint8_t i2c_slave_address,
+                                         const uint8_t reg_address, const size_t num_bytes, uint8_t data[const num_bytes]);
+iic_transfer_status_t iic_register_write (iic_controller_context_t *const controller, const uint8_t i2c_slave_address,
+                                          const uint8_t reg_address, const size_t num_bytes, const uint8_t data[const num_bytes]);
+iic_transfer_status_t iic_chained_register_read (iic_controller_context_t *const controller, const uint8_t page_select_address,
+                                                 const size_t num_reads, const iic_chained_read_t reads[const num_reads]);
 
 #endif /* XILINX_AXI_IIC_TRANSFERS_H_ */
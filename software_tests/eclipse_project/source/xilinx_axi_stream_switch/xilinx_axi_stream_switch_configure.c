@@ -19,8 +19,9 @@
 
 
 /** Specifies which devices to set routes for */
-static device_routing_t device_routing[MAX_VFIO_DEVICES];
+static device_routing_t *device_routing;
 static uint32_t num_devices_routed;
+static uint32_t device_routing_allocated_length;
 
 
 /* The default stream loopback routing for the designs which support it.
@@ -195,11 +196,8 @@ void process_device_routing_argument (const char *const argument, const bool add
     char *device_name;
     char *route_string;
 
-    if (num_devices_routed == MAX_VFIO_DEVICES)
-    {
-        fprintf (stderr, "Maximum number of devices reached\n");
-        exit (EXIT_FAILURE);
-    }
+    device_routing = vfio_grow_array (device_routing, &device_routing_allocated_length, num_devices_routed + 1,
+            sizeof (device_routing[0]), "device_routing");
 
     /* Extract the device the routing is for */
     device_routing_t *const routes = &device_routing[num_devices_routed];
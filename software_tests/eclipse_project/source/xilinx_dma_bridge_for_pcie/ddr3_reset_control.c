@@ -243,7 +243,7 @@ int main (int argc, char *argv[])
     for (uint32_t design_index = 0; design_index < designs.num_identified_designs; design_index++)
     {
         fpga_design_t *const design = &designs.designs[design_index];
-        vfio_device_t *const vfio_device = &designs.vfio_devices.devices[design_index];
+        vfio_device_t *const vfio_device = designs.vfio_devices.devices[design_index];
 
         switch (design->design_id)
         {
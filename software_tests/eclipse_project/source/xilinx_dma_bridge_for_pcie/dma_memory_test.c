@@ -0,0 +1,799 @@
+/*
+ * @file dma_memory_test.c
+ * @date 18 Oct 2026
+ * @author Chester Gillon
+ * @brief Provides classic memory test patterns for card memory accessed by the Xilinx "DMA/Bridge Subsystem for PCI Express"
+ * @details
+ *   Each test is a sequence of passes over the card memory, where each pass performs one or both of:
+ *   a. C2H transfer of a chunk of card memory and verify the contents against a pattern.
+ *   b. Populate a chunk with a pattern and H2C transfer to card memory.
+ *
+ *   A pair of host buffers is used in each direction, so the CPU can verify or populate one chunk while the DMA transfers
+ *   the adjacent chunks. This allows the tests to run at DMA throughput, rather than the throughput of PIO accesses to
+ *   card memory.
+ *
+ *   Since DMA transfers operate on complete chunks, the "moving inversions" test moves through the memory in units of
+ *   chunks, with each chunk read, inverted and written back before moving onto the next chunk.
+ *
+ *   The memory is tested as 64-bit words, which matches the data width of the DDR3 and DDR4 memory on the cards.
+ *
+ *   Leases on the DMA channels are held while the context is initialised, to arbitrate the use of the channels with
+ *   other processes using the VFIO multi process manager.
+ */
+
+#include "dma_memory_test.h"
+#include "transfer_timing.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+
+/* Use a single fixed transfer timeout, to stop the tests from hanging */
+#define TRANSFER_TIMEOUT_SECS 60
+
+
+/* How long to wait for the leases on the DMA channels, when in use by another process */
+#define CHANNEL_LEASE_WAIT_TIMEOUT_NS 60000000000UL
+
+
+/* The number of host buffers used in each direction */
+#define DMA_MEMORY_TEST_HOST_BUFFERS 2
+
+
+/* Bit patterns used by the tests */
+#define ALTERNATING_BITS_PATTERN 0x5555555555555555UL
+#define ALL_ONES_PATTERN         0xFFFFFFFFFFFFFFFFUL
+
+
+/* The names of the different tests */
+const char *const dma_memory_test_names[DMA_MEMORY_TEST_ARRAY_SIZE] =
+{
+    [DMA_MEMORY_TEST_WALKING_ONES] = "walking_ones",
+    [DMA_MEMORY_TEST_WALKING_ZEROS] = "walking_zeros",
+    [DMA_MEMORY_TEST_ADDRESS_IN_ADDRESS] = "address_in_address",
+    [DMA_MEMORY_TEST_MOVING_INVERSIONS] = "moving_inversions",
+    [DMA_MEMORY_TEST_CHECKERBOARD] = "checkerboard",
+    [DMA_MEMORY_TEST_ROW_HAMMER] = "row_hammer"
+};
+
+
+/* Defines how the contents of each word are generated from the address of the word */
+typedef enum
+{
+    /* Every word is set to the value */
+    DMA_MEMORY_FILL_CONSTANT,
+    /* Even words are set to the value, and odd words to the inverse of the value */
+    DMA_MEMORY_FILL_ALTERNATING,
+    /* Each word is set to the value rotated left by the word index modulo the number of bits in a word */
+    DMA_MEMORY_FILL_WALKING,
+    /* Each word is set to its address exclusive-ORed with the value */
+    DMA_MEMORY_FILL_ADDRESS
+} dma_memory_fill_type_t;
+
+
+/* Defines a pattern used to fill the memory */
+typedef struct
+{
+    dma_memory_fill_type_t type;
+    uint64_t value;
+} dma_memory_fill_t;
+
+
+/* Defines one pass over the card memory */
+typedef struct
+{
+    /* When true the card memory is read and verified against verify_fill */
+    bool verify;
+    dma_memory_fill_t verify_fill;
+    /* When true the card memory is written with write_fill, after any verification of the same chunk */
+    bool write;
+    dma_memory_fill_t write_fill;
+    /* When true the chunks are processed from the highest address to the lowest */
+    bool descending;
+    /* When true, rather than transferring chunks, the row-hammer aggressor addresses are repeatedly read */
+    bool hammer;
+} dma_memory_test_pass_t;
+
+
+/* Defines the sequence of passes for one test */
+typedef struct
+{
+    uint32_t num_passes;
+    const dma_memory_test_pass_t *passes;
+} dma_memory_test_sequence_t;
+
+
+static const dma_memory_test_pass_t walking_ones_passes[] =
+{
+    {.write = true, .write_fill = {DMA_MEMORY_FILL_WALKING, 1}},
+    {.verify = true, .verify_fill = {DMA_MEMORY_FILL_WALKING, 1}}
+};
+
+static const dma_memory_test_pass_t walking_zeros_passes[] =
+{
+    {.write = true, .write_fill = {DMA_MEMORY_FILL_WALKING, ~1UL}},
+    {.verify = true, .verify_fill = {DMA_MEMORY_FILL_WALKING, ~1UL}}
+};
+
+static const dma_memory_test_pass_t address_in_address_passes[] =
+{
+    {.write = true, .write_fill = {DMA_MEMORY_FILL_ADDRESS, 0}},
+    {.verify = true, .verify_fill = {DMA_MEMORY_FILL_ADDRESS, 0},
+     .write = true, .write_fill = {DMA_MEMORY_FILL_ADDRESS, ALL_ONES_PATTERN}},
+    {.verify = true, .verify_fill = {DMA_MEMORY_FILL_ADDRESS, ALL_ONES_PATTERN}}
+};
+
+static const dma_memory_test_pass_t moving_inversions_passes[] =
+{
+    {.write = true, .write_fill = {DMA_MEMORY_FILL_CONSTANT, 0}},
+    {.verify = true, .verify_fill = {DMA_MEMORY_FILL_CONSTANT, 0},
+     .write = true, .write_fill = {DMA_MEMORY_FILL_CONSTANT, ALL_ONES_PATTERN}},
+    {.verify = true, .verify_fill = {DMA_MEMORY_FILL_CONSTANT, ALL_ONES_PATTERN},
+     .write = true, .write_fill = {DMA_MEMORY_FILL_CONSTANT, 0}, .descending = true},
+    {.verify = true, .verify_fill = {DMA_MEMORY_FILL_CONSTANT, 0}, .descending = true}
+};
+
+static const dma_memory_test_pass_t checkerboard_passes[] =
+{
+    {.write = true, .write_fill = {DMA_MEMORY_FILL_ALTERNATING, ALTERNATING_BITS_PATTERN}},
+    {.verify = true, .verify_fill = {DMA_MEMORY_FILL_ALTERNATING, ALTERNATING_BITS_PATTERN},
+     .write = true, .write_fill = {DMA_MEMORY_FILL_ALTERNATING, ~ALTERNATING_BITS_PATTERN}},
+    {.verify = true, .verify_fill = {DMA_MEMORY_FILL_ALTERNATING, ~ALTERNATING_BITS_PATTERN}}
+};
+
+static const dma_memory_test_pass_t row_hammer_passes[] =
+{
+    {.write = true, .write_fill = {DMA_MEMORY_FILL_ALTERNATING, ALTERNATING_BITS_PATTERN}},
+    {.hammer = true},
+    {.verify = true, .verify_fill = {DMA_MEMORY_FILL_ALTERNATING, ALTERNATING_BITS_PATTERN}}
+};
+
+#define TEST_SEQUENCE(passes) {sizeof (passes) / sizeof (passes[0]), passes}
+
+static const dma_memory_test_sequence_t dma_memory_test_sequences[DMA_MEMORY_TEST_ARRAY_SIZE] =
+{
+    [DMA_MEMORY_TEST_WALKING_ONES] = TEST_SEQUENCE (walking_ones_passes),
+    [DMA_MEMORY_TEST_WALKING_ZEROS] = TEST_SEQUENCE (walking_zeros_passes),
+    [DMA_MEMORY_TEST_ADDRESS_IN_ADDRESS] = TEST_SEQUENCE (address_in_address_passes),
+    [DMA_MEMORY_TEST_MOVING_INVERSIONS] = TEST_SEQUENCE (moving_inversions_passes),
+    [DMA_MEMORY_TEST_CHECKERBOARD] = TEST_SEQUENCE (checkerboard_passes),
+    [DMA_MEMORY_TEST_ROW_HAMMER] = TEST_SEQUENCE (row_hammer_passes)
+};
+
+
+/**
+ * @brief Get the expected contents of one word in card memory
+ * @param[in] fill The pattern used to fill the memory
+ * @param[in] address The address of the word in card memory
+ * @return The expected contents of the word
+ */
+static inline uint64_t dma_memory_fill_word (const dma_memory_fill_t *const fill, const uint64_t address)
+{
+    const uint64_t word_index = address / sizeof (uint64_t);
+    const uint32_t rotate = (uint32_t) (word_index % 64);
+
+    switch (fill->type)
+    {
+    case DMA_MEMORY_FILL_ALTERNATING:
+        return ((word_index & 1) != 0) ? ~fill->value : fill->value;
+
+    case DMA_MEMORY_FILL_WALKING:
+        return (rotate == 0) ? fill->value : ((fill->value << rotate) | (fill->value >> (64 - rotate)));
+
+    case DMA_MEMORY_FILL_ADDRESS:
+        return address ^ fill->value;
+
+    case DMA_MEMORY_FILL_CONSTANT:
+    default:
+        return fill->value;
+    }
+}
+
+
+/**
+ * @brief Get the location of a chunk of card memory for a pass
+ * @param[in] context The memory test context
+ * @param[in] pass The pass which defines the order the chunks are processed in
+ * @param[in] chunk_sequence The sequence number of the chunk in the pass
+ * @param[out] card_offset The offset in card memory of the chunk
+ * @param[out] num_words The number of words in the chunk
+ */
+static void dma_memory_test_get_chunk (const dma_memory_test_context_t *const context, const dma_memory_test_pass_t *const pass,
+                                       const size_t chunk_sequence, uint64_t *const card_offset, size_t *const num_words)
+{
+    const size_t chunk_size_words = context->configuration.chunk_size_bytes / sizeof (uint64_t);
+    const size_t chunk_index = pass->descending ? (context->num_chunks - 1 - chunk_sequence) : chunk_sequence;
+    const size_t start_word = chunk_index * chunk_size_words;
+    const size_t remaining_words = context->memory_size_words - start_word;
+
+    *card_offset = start_word * sizeof (uint64_t);
+    *num_words = (remaining_words < chunk_size_words) ? remaining_words : chunk_size_words;
+}
+
+
+/**
+ * @brief Start a DMA transfer for one chunk of card memory
+ * @param[in/out] context The memory test context
+ * @param[in/out] transfer Which channel to start the transfer on
+ * @param[in] pass The pass the chunk is for
+ * @param[in] chunk_sequence The sequence number of the chunk in the pass, which also selects the host buffer
+ * @param[in/out] num_bytes_transferred Updated with the number of bytes in the transfer
+ */
+static void dma_memory_test_start_chunk_transfer (dma_memory_test_context_t *const context,
+                                                  x2x_transfer_context_t *const transfer,
+                                                  const dma_memory_test_pass_t *const pass, const size_t chunk_sequence,
+                                                  uint64_t *const num_bytes_transferred)
+{
+    const uint64_t host_buffer_offset = (chunk_sequence % DMA_MEMORY_TEST_HOST_BUFFERS) * context->configuration.chunk_size_bytes;
+    uint64_t card_offset;
+    size_t num_words;
+    void *host_buffer;
+
+    dma_memory_test_get_chunk (context, pass, chunk_sequence, &card_offset, &num_words);
+    host_buffer = x2x_populate_memory_transfer (transfer, num_words * sizeof (uint64_t), host_buffer_offset, card_offset);
+    X2X_ASSERT (transfer, host_buffer != NULL);
+    x2x_start_populated_descriptors (transfer);
+    (*num_bytes_transferred) += num_words * sizeof (uint64_t);
+}
+
+
+/**
+ * @brief Record one word in card memory which doesn't have the expected contents
+ * @param[in/out] context The memory test context, to update the results
+ * @param[in] fill The pattern the memory was verified against
+ * @param[in] address The address of the failing word
+ * @param[in] expected The expected contents of the word
+ * @param[in] actual The actual contents of the word
+ */
+static void dma_memory_test_record_failing_word (dma_memory_test_context_t *const context, const dma_memory_fill_t *const fill,
+                                                 const uint64_t address, const uint64_t expected, const uint64_t actual)
+{
+    dma_memory_test_results_t *const results = &context->results;
+
+    results->num_failing_words++;
+    results->failing_data_bits |= expected ^ actual;
+    if (fill->type == DMA_MEMORY_FILL_ADDRESS)
+    {
+        /* If the word contains the address of a different word in the memory being tested, the word was overwritten by a
+         * write to the other address. The differences between the addresses identify the failing address bits. */
+        const uint64_t contained_address = actual ^ fill->value;
+        const uint64_t memory_start = context->configuration.memory_base_address;
+        const uint64_t memory_end = memory_start + (context->memory_size_words * sizeof (uint64_t));
+
+        if ((contained_address != address) && (contained_address >= memory_start) && (contained_address < memory_end) &&
+            ((contained_address % sizeof (uint64_t)) == 0))
+        {
+            results->failing_address_bits |= contained_address ^ address;
+        }
+    }
+
+    if (results->num_failing_words <= DMA_MEMORY_TEST_MAX_REPORTED_FAILURES)
+    {
+        printf ("  Word at address 0x%" PRIx64 " expected 0x%016" PRIx64 " actual 0x%016" PRIx64 "\n",
+                address, expected, actual);
+    }
+}
+
+
+/**
+ * @brief Verify the contents of one chunk which has been transferred from card memory
+ * @param[in/out] context The memory test context
+ * @param[in] pass Defines the expected contents of the card memory
+ * @param[in] chunk_sequence The sequence number of the chunk in the pass
+ */
+static void dma_memory_test_verify_chunk (dma_memory_test_context_t *const context, const dma_memory_test_pass_t *const pass,
+                                          const size_t chunk_sequence)
+{
+    const uint64_t *const host_words = context->c2h_data_mapping.buffer.vaddr;
+    const size_t host_word_offset =
+            (chunk_sequence % DMA_MEMORY_TEST_HOST_BUFFERS) * (context->configuration.chunk_size_bytes / sizeof (uint64_t));
+    uint64_t card_offset;
+    size_t num_words;
+
+    dma_memory_test_get_chunk (context, pass, chunk_sequence, &card_offset, &num_words);
+    const uint64_t chunk_address = context->configuration.memory_base_address + card_offset;
+    for (size_t word_index = 0; word_index < num_words; word_index++)
+    {
+        const uint64_t address = chunk_address + (word_index * sizeof (uint64_t));
+        const uint64_t expected = dma_memory_fill_word (&pass->verify_fill, address);
+        const uint64_t actual = host_words[host_word_offset + word_index];
+
+        if (actual != expected)
+        {
+            dma_memory_test_record_failing_word (context, &pass->verify_fill, address, expected, actual);
+        }
+    }
+}
+
+
+/**
+ * @brief Populate the contents of one chunk which is to be transferred to card memory
+ * @param[in/out] context The memory test context
+ * @param[in] pass Defines the contents to write to the card memory
+ * @param[in] chunk_sequence The sequence number of the chunk in the pass
+ */
+static void dma_memory_test_populate_chunk (dma_memory_test_context_t *const context, const dma_memory_test_pass_t *const pass,
+                                            const size_t chunk_sequence)
+{
+    uint64_t *const host_words = context->h2c_data_mapping.buffer.vaddr;
+    const size_t host_word_offset =
+            (chunk_sequence % DMA_MEMORY_TEST_HOST_BUFFERS) * (context->configuration.chunk_size_bytes / sizeof (uint64_t));
+    uint64_t card_offset;
+    size_t num_words;
+
+    dma_memory_test_get_chunk (context, pass, chunk_sequence, &card_offset, &num_words);
+    const uint64_t chunk_address = context->configuration.memory_base_address + card_offset;
+    for (size_t word_index = 0; word_index < num_words; word_index++)
+    {
+        host_words[host_word_offset + word_index] =
+                dma_memory_fill_word (&pass->write_fill, chunk_address + (word_index * sizeof (uint64_t)));
+    }
+}
+
+
+/**
+ * @brief Perform one pass over the card memory which transfers chunks
+ * @details The chunks are processed in order, with the C2H transfer of the next chunk and H2C transfer of the previous
+ *          chunk overlapped with the CPU verifying and populating the current chunk.
+ * @param[in/out] context The memory test context
+ * @param[in] pass The pass to perform
+ */
+static void dma_memory_test_transfer_pass (dma_memory_test_context_t *const context, const dma_memory_test_pass_t *const pass)
+{
+    size_t num_reads_started = 0;
+    size_t num_reads_completed = 0;
+    size_t num_chunks_processed = 0;
+    size_t num_writes_started = 0;
+    size_t num_writes_completed = 0;
+    bool read_in_flight = false;
+    bool write_in_flight = false;
+
+    while (context->transfer_success &&
+           ((pass->write ? num_writes_completed : num_chunks_processed) < context->num_chunks))
+    {
+        /* Check for completed transfers */
+        if (read_in_flight && (x2x_poll_completed_transfer (&context->c2h_transfer, NULL, NULL) != NULL))
+        {
+            num_reads_completed++;
+            read_in_flight = false;
+        }
+        if (write_in_flight && (x2x_poll_completed_transfer (&context->h2c_transfer, NULL, NULL) != NULL))
+        {
+            num_writes_completed++;
+            write_in_flight = false;
+        }
+
+        /* Read the next chunk, once the host buffer is no longer in use for verification of an earlier chunk */
+        if (context->transfer_success && pass->verify && !read_in_flight && (num_reads_started < context->num_chunks) &&
+            ((num_reads_started - num_chunks_processed) < DMA_MEMORY_TEST_HOST_BUFFERS))
+        {
+            dma_memory_test_start_chunk_transfer (context, &context->c2h_transfer, pass, num_reads_started,
+                    &context->results.c2h_bytes);
+            num_reads_started++;
+            read_in_flight = true;
+        }
+
+        /* Process the next chunk once it has been read, and the host buffer is no longer in use for writing an earlier chunk */
+        if (context->transfer_success && (num_chunks_processed < context->num_chunks) &&
+            (!pass->verify || (num_chunks_processed < num_reads_completed)) &&
+            (!pass->write || ((num_chunks_processed - num_writes_completed) < DMA_MEMORY_TEST_HOST_BUFFERS)))
+        {
+            if (pass->verify)
+            {
+                dma_memory_test_verify_chunk (context, pass, num_chunks_processed);
+            }
+            if (pass->write)
+            {
+                dma_memory_test_populate_chunk (context, pass, num_chunks_processed);
+            }
+            num_chunks_processed++;
+        }
+
+        /* Write the next chunk once it has been populated */
+        if (context->transfer_success && pass->write && !write_in_flight && (num_writes_started < num_chunks_processed))
+        {
+            dma_memory_test_start_chunk_transfer (context, &context->h2c_transfer, pass, num_writes_started,
+                    &context->results.h2c_bytes);
+            num_writes_started++;
+            write_in_flight = true;
+        }
+    }
+}
+
+
+/**
+ * @brief Perform a pass which repeatedly reads the row-hammer aggressor addresses
+ * @details Keeps multiple C2H transfers queued so the aggressor rows are activated at the maximum rate the DMA engine allows.
+ *          The data read is discarded.
+ * @param[in/out] context The memory test context
+ */
+static void dma_memory_test_hammer_pass (dma_memory_test_context_t *const context)
+{
+    const dma_memory_test_configuration_t *const configuration = &context->configuration;
+    const uint64_t num_accesses = configuration->row_hammer_num_activations * configuration->num_row_hammer_aggressors;
+    const uint64_t host_buffer_offset = 0;
+    uint64_t num_accesses_started = 0;
+    uint64_t num_accesses_completed = 0;
+
+    while (context->transfer_success && (num_accesses_completed < num_accesses))
+    {
+        /* Queue accesses to the aggressors in turn, until all descriptors are in use */
+        bool accesses_populated = false;
+        while (context->transfer_success && (num_accesses_started < num_accesses) &&
+               (x2x_populate_memory_transfer (&context->c2h_transfer, DMA_MEMORY_TEST_HAMMER_ACCESS_BYTES, host_buffer_offset,
+                       configuration->row_hammer_aggressor_offsets[num_accesses_started % configuration->num_row_hammer_aggressors])
+                != NULL))
+        {
+            num_accesses_started++;
+            accesses_populated = true;
+        }
+        if (accesses_populated)
+        {
+            x2x_start_populated_descriptors (&context->c2h_transfer);
+        }
+
+        while (context->transfer_success && (x2x_poll_completed_transfer (&context->c2h_transfer, NULL, NULL) != NULL))
+        {
+            num_accesses_completed++;
+        }
+    }
+
+    context->results.c2h_bytes += num_accesses_completed * DMA_MEMORY_TEST_HAMMER_ACCESS_BYTES;
+}
+
+
+/**
+ * @brief If a transfer failed, report an error to the console
+ * @param[in] transfer The transfer context to check for errors.
+ */
+static void report_if_transfer_failed (const x2x_transfer_context_t *const transfer)
+{
+    if (transfer->failed)
+    {
+        printf ("  %s failure : %s%s\n",
+                (transfer->configuration.channels_submodule == DMA_SUBMODULE_H2C_CHANNELS) ? "H2C" : "C2H",
+                transfer->error_message,
+                transfer->timeout_awaiting_idle_at_finalisation ? " (+timeout waiting for idle at finalisation)" : "");
+    }
+}
+
+
+/**
+ * @brief Acquire leases on the DMA channels used for testing card memory, with no time limit
+ * @details The H2C channel is always leased before the C2H channel, so that multiple processes using this library can't
+ *          deadlock waiting for each others channel.
+ * @param[in/out] context The memory test context to store the lease identities in
+ * @return Returns true if the leases on both channels were acquired, or false if timed out waiting for a lease.
+ *         On failure no leases are held.
+ */
+static bool dma_memory_test_acquire_channel_leases (dma_memory_test_context_t *const context)
+{
+    const dma_memory_test_configuration_t *const configuration = &context->configuration;
+
+    if (!vfio_acquire_resource_lease (configuration->vfio_device,
+            VFIO_RESOURCE_DMA_H2C_CHANNEL, configuration->h2c_channel_id,
+            VFIO_RESOURCE_LEASE_INFINITE_NS, CHANNEL_LEASE_WAIT_TIMEOUT_NS, &context->h2c_lease_id))
+    {
+        printf ("Timed out waiting for lease on DMA H2C channel %" PRIu32 "\n", configuration->h2c_channel_id);
+        return false;
+    }
+
+    if (!vfio_acquire_resource_lease (configuration->vfio_device,
+            VFIO_RESOURCE_DMA_C2H_CHANNEL, configuration->c2h_channel_id,
+            VFIO_RESOURCE_LEASE_INFINITE_NS, CHANNEL_LEASE_WAIT_TIMEOUT_NS, &context->c2h_lease_id))
+    {
+        printf ("Timed out waiting for lease on DMA C2H channel %" PRIu32 "\n", configuration->c2h_channel_id);
+        (void) vfio_release_resource_lease (configuration->vfio_device, context->h2c_lease_id);
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Release the leases on the DMA channels used for testing card memory
+ * @details The leases have no time limit, so can't have expired which means the result of the release is ignored.
+ * @param[in/out] context The memory test context containing the lease identities
+ */
+static void dma_memory_test_release_channel_leases (dma_memory_test_context_t *const context)
+{
+    (void) vfio_release_resource_lease (context->configuration.vfio_device, context->c2h_lease_id);
+    (void) vfio_release_resource_lease (context->configuration.vfio_device, context->h2c_lease_id);
+}
+
+
+/**
+ * @brief Initialise the context for testing card memory, allocating the host buffers and initialising the DMA channels
+ * @param[out] context The memory test context to initialise
+ * @param[in] configuration The configuration for the tests
+ * @return Returns true if the context was initialised, or false if the configuration is invalid,
+ *         timed out waiting for the leases on the DMA channels or failed to allocate the host buffers.
+ */
+bool dma_memory_test_initialise (dma_memory_test_context_t *const context,
+                                 const dma_memory_test_configuration_t *const configuration)
+{
+    memset (context, 0, sizeof (*context));
+    context->configuration = *configuration;
+    context->memory_size_words = configuration->memory_size_bytes / sizeof (uint64_t);
+
+    if ((configuration->chunk_size_bytes < DMA_MEMORY_TEST_MIN_CHUNK_SIZE_BYTES) ||
+        ((configuration->chunk_size_bytes % sizeof (uint64_t)) != 0) || (context->memory_size_words == 0))
+    {
+        printf ("Invalid chunk_size_bytes 0x%zx for memory_size_bytes 0x%zx\n",
+                configuration->chunk_size_bytes, configuration->memory_size_bytes);
+        return false;
+    }
+    for (uint32_t aggressor_index = 0; aggressor_index < configuration->num_row_hammer_aggressors; aggressor_index++)
+    {
+        if ((configuration->row_hammer_aggressor_offsets[aggressor_index] + DMA_MEMORY_TEST_HAMMER_ACCESS_BYTES) >
+            configuration->memory_size_bytes)
+        {
+            printf ("Row hammer aggressor offset 0x%" PRIx64 " outside of memory_size_bytes 0x%zx\n",
+                    configuration->row_hammer_aggressor_offsets[aggressor_index], configuration->memory_size_bytes);
+            return false;
+        }
+    }
+
+    if (!dma_memory_test_acquire_channel_leases (context))
+    {
+        return false;
+    }
+
+    const size_t chunk_size_words = configuration->chunk_size_bytes / sizeof (uint64_t);
+    context->num_chunks = (context->memory_size_words + chunk_size_words - 1) / chunk_size_words;
+
+    const uint32_t num_descriptors_for_chunk = x2x_num_descriptors_for_transfer_len (configuration->chunk_size_bytes);
+    const size_t host_buffers_size_bytes = DMA_MEMORY_TEST_HOST_BUFFERS * configuration->chunk_size_bytes;
+
+    const x2x_transfer_configuration_t h2c_transfer_configuration =
+    {
+        .dma_bridge_memory_base_address = configuration->memory_base_address,
+        .dma_bridge_memory_size_bytes = configuration->memory_size_bytes,
+        .min_size_alignment = 1, /* The card memory is byte addressable */
+        .num_descriptors = num_descriptors_for_chunk,
+        .channels_submodule = DMA_SUBMODULE_H2C_CHANNELS,
+        .channel_id = configuration->h2c_channel_id,
+        .bytes_per_buffer = 0, /* Length and offsets set before each each transfer */
+        .host_buffer_start_offset = 0,
+        .card_buffer_start_offset = 0,
+        .timeout_seconds = TRANSFER_TIMEOUT_SECS,
+        .vfio_device = configuration->vfio_device,
+        .bar_index = configuration->bar_index,
+        .descriptors_mapping = &context->descriptors_mapping,
+        .data_mapping = &context->h2c_data_mapping,
+        .overall_success = &context->transfer_success
+    };
+
+    /* The C2H channel has sufficient descriptors for either a complete chunk, or to queue multiple row-hammer accesses */
+    const x2x_transfer_configuration_t c2h_transfer_configuration =
+    {
+        .dma_bridge_memory_base_address = configuration->memory_base_address,
+        .dma_bridge_memory_size_bytes = configuration->memory_size_bytes,
+        .min_size_alignment = 1, /* The card memory is byte addressable */
+        .num_descriptors = (num_descriptors_for_chunk > DMA_MEMORY_TEST_HAMMER_DESCRIPTORS) ?
+                num_descriptors_for_chunk : DMA_MEMORY_TEST_HAMMER_DESCRIPTORS,
+        .channels_submodule = DMA_SUBMODULE_C2H_CHANNELS,
+        .channel_id = configuration->c2h_channel_id,
+        .bytes_per_buffer = 0, /* Length and offsets set before each each transfer */
+        .host_buffer_start_offset = 0,
+        .card_buffer_start_offset = 0,
+        .timeout_seconds = TRANSFER_TIMEOUT_SECS,
+        .vfio_device = configuration->vfio_device,
+        .bar_index = configuration->bar_index,
+        .descriptors_mapping = &context->descriptors_mapping,
+        .data_mapping = &context->c2h_data_mapping,
+        .overall_success = &context->transfer_success
+    };
+
+    /* Create read/write mapping for DMA descriptors */
+    const size_t descriptors_allocation_size = x2x_get_descriptor_allocation_size (&h2c_transfer_configuration) +
+            x2x_get_descriptor_allocation_size (&c2h_transfer_configuration);
+    allocate_vfio_dma_mapping (configuration->vfio_device, &context->descriptors_mapping, descriptors_allocation_size,
+            VFIO_DMA_MAP_FLAG_READ | VFIO_DMA_MAP_FLAG_WRITE, configuration->buffer_allocation);
+
+    /* Read only mapping used by device for the H2C host buffers */
+    allocate_vfio_dma_mapping (configuration->vfio_device, &context->h2c_data_mapping, host_buffers_size_bytes,
+            VFIO_DMA_MAP_FLAG_READ, configuration->buffer_allocation);
+
+    /* Write only mapping used by device for the C2H host buffers */
+    allocate_vfio_dma_mapping (configuration->vfio_device, &context->c2h_data_mapping, host_buffers_size_bytes,
+            VFIO_DMA_MAP_FLAG_WRITE, configuration->buffer_allocation);
+
+    context->transfer_success = (context->descriptors_mapping.buffer.vaddr != NULL) &&
+                                (context->h2c_data_mapping.buffer.vaddr    != NULL) &&
+                                (context->c2h_data_mapping.buffer.vaddr    != NULL);
+    if (context->transfer_success)
+    {
+        display_vfio_dma_mapping_setup_times (&context->h2c_data_mapping, "H2C host buffers");
+        display_vfio_dma_mapping_setup_times (&context->c2h_data_mapping, "C2H host buffers");
+        x2x_initialise_transfer_context (&context->h2c_transfer, &h2c_transfer_configuration);
+        x2x_initialise_transfer_context (&context->c2h_transfer, &c2h_transfer_configuration);
+    }
+    else
+    {
+        printf ("allocate_vfio_dma_mapping() failed\n");
+        free_vfio_dma_mapping (&context->c2h_data_mapping);
+        free_vfio_dma_mapping (&context->h2c_data_mapping);
+        free_vfio_dma_mapping (&context->descriptors_mapping);
+        dma_memory_test_release_channel_leases (context);
+    }
+
+    return context->transfer_success;
+}
+
+
+/**
+ * @brief Finalise the context for testing card memory, releasing the resources
+ * @details Only to be called when dma_memory_test_initialise() returned true.
+ *          This is the one place the reason for a DMA transfer failure is reported, so that a failure is only reported
+ *          once regardless of which tests were run on the context.
+ * @param[in/out] context The memory test context to finalise
+ */
+void dma_memory_test_finalise (dma_memory_test_context_t *const context)
+{
+    x2x_finalise_transfer_context (&context->h2c_transfer);
+    x2x_finalise_transfer_context (&context->c2h_transfer);
+    if (!context->transfer_success ||
+        context->h2c_transfer.timeout_awaiting_idle_at_finalisation || context->c2h_transfer.timeout_awaiting_idle_at_finalisation)
+    {
+        report_if_transfer_failed (&context->h2c_transfer);
+        report_if_transfer_failed (&context->c2h_transfer);
+    }
+
+    free_vfio_dma_mapping (&context->c2h_data_mapping);
+    free_vfio_dma_mapping (&context->h2c_data_mapping);
+    free_vfio_dma_mapping (&context->descriptors_mapping);
+    dma_memory_test_release_channel_leases (context);
+}
+
+
+/**
+ * @brief Run one memory test over the card memory
+ * @details Any failing words are reported as they are detected, up to a limit. Once a DMA transfer has failed no more
+ *          tests can be run.
+ * @param[in/out] context The memory test context. On exit the results have been updated for the test.
+ * @param[in] test Which test to run
+ * @return Returns true if the test passed, or false if a DMA transfer failed or the memory didn't have the expected contents
+ */
+bool dma_memory_test_run (dma_memory_test_context_t *const context, const dma_memory_test_t test)
+{
+    const dma_memory_test_sequence_t *const sequence = &dma_memory_test_sequences[test];
+
+    memset (&context->results, 0, sizeof (context->results));
+    if ((test == DMA_MEMORY_TEST_ROW_HAMMER) &&
+        ((context->configuration.num_row_hammer_aggressors == 0) || (context->configuration.row_hammer_num_activations == 0)))
+    {
+        printf ("No row hammer aggressors specified\n");
+        return false;
+    }
+
+    const int64_t start_time = get_monotonic_time ();
+    for (uint32_t pass_index = 0; context->transfer_success && (pass_index < sequence->num_passes); pass_index++)
+    {
+        const dma_memory_test_pass_t *const pass = &sequence->passes[pass_index];
+
+        if (pass->hammer)
+        {
+            dma_memory_test_hammer_pass (context);
+        }
+        else
+        {
+            dma_memory_test_transfer_pass (context, pass);
+        }
+    }
+    context->results.elapsed_ns = get_monotonic_time () - start_time;
+
+    return context->transfer_success && (context->results.num_failing_words == 0);
+}
+
+
+/**
+ * @brief Start a DMA transfer of the next chunk of card memory, for a throughput measurement
+ * @param[in/out] context The memory test context
+ * @param[in/out] transfer Which channel to start the transfer on
+ * @param[in/out] chunk_index The index of the chunk to transfer, advanced to the next chunk wrapping around the card memory
+ * @param[in/out] num_bytes_transferred Updated with the number of bytes in the transfer
+ */
+static void dma_memory_test_start_throughput_transfer (dma_memory_test_context_t *const context,
+                                                       x2x_transfer_context_t *const transfer,
+                                                       size_t *const chunk_index, uint64_t *const num_bytes_transferred)
+{
+    const size_t chunk_size_words = context->configuration.chunk_size_bytes / sizeof (uint64_t);
+    const size_t start_word = *chunk_index * chunk_size_words;
+    const size_t remaining_words = context->memory_size_words - start_word;
+    const size_t num_words = (remaining_words < chunk_size_words) ? remaining_words : chunk_size_words;
+    void *host_buffer;
+
+    host_buffer = x2x_populate_memory_transfer (transfer, num_words * sizeof (uint64_t), 0, start_word * sizeof (uint64_t));
+    X2X_ASSERT (transfer, host_buffer != NULL);
+    x2x_start_populated_descriptors (transfer);
+    (*num_bytes_transferred) += num_words * sizeof (uint64_t);
+    *chunk_index = (*chunk_index + 1) % context->num_chunks;
+}
+
+
+/**
+ * @brief Measure the DMA throughput between host memory and card memory
+ * @details Transfers chunks of card memory for a fixed duration, without populating or verifying the contents so the
+ *          throughput is only limited by the DMA. When both directions are measured the H2C and C2H transfers run
+ *          concurrently, starting at opposite halves of the card memory.
+ * @param[in/out] context The memory test context. On exit the results contain the bytes transferred in each direction
+ *                        and the elapsed time.
+ * @param[in] duration_ns How long to start new transfers for
+ * @param[in] measure_h2c When true H2C transfers are performed
+ * @param[in] measure_c2h When true C2H transfers are performed
+ * @return Returns true if the transfers were successful, or false if a DMA transfer failed
+ */
+bool dma_memory_test_measure_throughput (dma_memory_test_context_t *const context, const int64_t duration_ns,
+                                         const bool measure_h2c, const bool measure_c2h)
+{
+    size_t h2c_chunk_index = 0;
+    size_t c2h_chunk_index = context->num_chunks / 2;
+    bool h2c_in_flight = false;
+    bool c2h_in_flight = false;
+    bool measurement_running = true;
+
+    memset (&context->results, 0, sizeof (context->results));
+    const int64_t start_time = get_monotonic_time ();
+    const int64_t stop_time = start_time + duration_ns;
+    while (context->transfer_success && (measurement_running || h2c_in_flight || c2h_in_flight))
+    {
+        if (h2c_in_flight && (x2x_poll_completed_transfer (&context->h2c_transfer, NULL, NULL) != NULL))
+        {
+            h2c_in_flight = false;
+        }
+        if (c2h_in_flight && (x2x_poll_completed_transfer (&context->c2h_transfer, NULL, NULL) != NULL))
+        {
+            c2h_in_flight = false;
+        }
+
+        measurement_running = get_monotonic_time () < stop_time;
+        if (context->transfer_success && measurement_running && measure_h2c && !h2c_in_flight)
+        {
+            dma_memory_test_start_throughput_transfer (context, &context->h2c_transfer, &h2c_chunk_index,
+                    &context->results.h2c_bytes);
+            h2c_in_flight = true;
+        }
+        if (context->transfer_success && measurement_running && measure_c2h && !c2h_in_flight)
+        {
+            dma_memory_test_start_throughput_transfer (context, &context->c2h_transfer, &c2h_chunk_index,
+                    &context->results.c2h_bytes);
+            c2h_in_flight = true;
+        }
+    }
+    context->results.elapsed_ns = get_monotonic_time () - start_time;
+
+    return context->transfer_success;
+}
+
+
+/**
+ * @brief Display the results of the most recent memory test
+ * @param[in] context The memory test context containing the results
+ * @param[in] test Which test the results are for
+ */
+void dma_memory_test_display_results (const dma_memory_test_context_t *const context, const dma_memory_test_t test)
+{
+    const dma_memory_test_results_t *const results = &context->results;
+    const double elapsed_secs = (double) results->elapsed_ns / 1E9;
+    const bool passed = context->transfer_success && (results->num_failing_words == 0);
+
+    printf ("%s : %s\n", dma_memory_test_names[test], passed ? "PASS" : "FAIL");
+    if (elapsed_secs > 0.0)
+    {
+        printf ("  H2C %" PRIu64 " bytes, C2H %" PRIu64 " bytes in %.3f secs = %.6f (Mbytes/sec)\n",
+                results->h2c_bytes, results->c2h_bytes, elapsed_secs,
+                ((double) (results->h2c_bytes + results->c2h_bytes) / elapsed_secs) / 1E6);
+    }
+    if (results->num_failing_words > 0)
+    {
+        printf ("  %" PRIu64 " failing words with failing data bits 0x%016" PRIx64 "\n",
+                results->num_failing_words, results->failing_data_bits);
+        if (results->failing_address_bits != 0)
+        {
+            printf ("  Failing address bits 0x%" PRIx64 "\n", results->failing_address_bits);
+        }
+    }}
@@ -0,0 +1,139 @@
+/*
+ * @file dma_memory_test.h
+ * @date 18 Oct 2026
+ * @author Chester Gillon
+ * @brief Provides classic memory test patterns for card memory accessed by the Xilinx "DMA/Bridge Subsystem for PCI Express"
+ */
+
+#ifndef DMA_MEMORY_TEST_H_
+#define DMA_MEMORY_TEST_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "xilinx_dma_bridge_transfers.h"
+
+
+/* The maximum number of aggressor addresses which can be used for a row-hammer test */
+#define DMA_MEMORY_TEST_MAX_AGGRESSORS 16
+
+/* The number of descriptors used to queue the row-hammer C2H accesses, so the DMA engine doesn't go idle
+ * while the software is queueing the next access. */
+#define DMA_MEMORY_TEST_HAMMER_DESCRIPTORS 64
+
+/* The number of bytes read by each row-hammer access, which is sufficient to cause one row activation */
+#define DMA_MEMORY_TEST_HAMMER_ACCESS_BYTES 64
+
+/* The minimum chunk_size_bytes which can be configured. Each row-hammer access is read into the host buffer
+ * for one chunk, so a chunk has to be large enough to hold one access. */
+#define DMA_MEMORY_TEST_MIN_CHUNK_SIZE_BYTES DMA_MEMORY_TEST_HAMMER_ACCESS_BYTES
+
+/* The maximum number of failing words which are individually reported for each test */
+#define DMA_MEMORY_TEST_MAX_REPORTED_FAILURES 16
+
+
+/* The different memory tests which can be performed */
+typedef enum
+{
+    /* Word n is set to a single one bit, which walks through the data bits as n increments */
+    DMA_MEMORY_TEST_WALKING_ONES,
+    /* Word n is set to a single zero bit, which walks through the data bits as n increments */
+    DMA_MEMORY_TEST_WALKING_ZEROS,
+    /* Each word is set to its own address and then to the inverse of its own address.
+     * Allows failing address bits to be identified from the address of the word which overwrote the expected contents. */
+    DMA_MEMORY_TEST_ADDRESS_IN_ADDRESS,
+    /* Moving inversions, in which the memory is filled with a pattern and each word is read and inverted on an ascending
+     * pass and then a descending pass */
+    DMA_MEMORY_TEST_MOVING_INVERSIONS,
+    /* Adjacent words are set to alternating bit patterns, and then to the inverse */
+    DMA_MEMORY_TEST_CHECKERBOARD,
+    /* The memory is filled with a pattern, the user specified aggressor addresses are repeatedly read,
+     * and then the memory checked for disturbance. */
+    DMA_MEMORY_TEST_ROW_HAMMER,
+
+    DMA_MEMORY_TEST_ARRAY_SIZE
+} dma_memory_test_t;
+
+extern const char *const dma_memory_test_names[DMA_MEMORY_TEST_ARRAY_SIZE];
+
+
+/* Defines the configuration for testing card memory. Provided by the caller and read-only during the tests. */
+typedef struct
+{
+    /* The device and BAR containing the DMA bridge used to access the card memory */
+    vfio_device_t *vfio_device;
+    uint32_t bar_index;
+    /* The base address and size of the card memory to test. The memory is tested as 64-bit words, so any
+     * trailing bytes which don't form a complete word aren't tested. */
+    size_t memory_base_address;
+    size_t memory_size_bytes;
+    /* The DMA channels used to access the card memory */
+    uint32_t h2c_channel_id;
+    uint32_t c2h_channel_id;
+    /* The size of each chunk of card memory transferred by a DMA transfer.
+     * Two host buffers of this size are used for each direction, to overlap the DMA and CPU processing. */
+    size_t chunk_size_bytes;
+    /* How the host buffers are allocated */
+    vfio_buffer_allocation_type_t buffer_allocation;
+    /* For DMA_MEMORY_TEST_ROW_HAMMER the offsets in card memory of the aggressor addresses, which are read in turn */
+    uint32_t num_row_hammer_aggressors;
+    uint64_t row_hammer_aggressor_offsets[DMA_MEMORY_TEST_MAX_AGGRESSORS];
+    /* For DMA_MEMORY_TEST_ROW_HAMMER the number of reads of each aggressor address */
+    uint64_t row_hammer_num_activations;
+} dma_memory_test_configuration_t;
+
+
+/* The results from one memory test */
+typedef struct
+{
+    /* The number of words which didn't have the expected contents */
+    uint64_t num_failing_words;
+    /* Bitwise OR of the difference between the actual and expected contents of the failing words */
+    uint64_t failing_data_bits;
+    /* For DMA_MEMORY_TEST_ADDRESS_IN_ADDRESS bitwise OR of the difference between the address of failing words and the
+     * address contained in the failing word, when the failing word contains the address of another word in the memory. */
+    uint64_t failing_address_bits;
+    /* The number of bytes transferred by DMA in each direction */
+    uint64_t h2c_bytes;
+    uint64_t c2h_bytes;
+    /* The elapsed time for the test */
+    int64_t elapsed_ns;
+} dma_memory_test_results_t;
+
+
+/* The context for testing card memory */
+typedef struct
+{
+    /* The configuration for the tests */
+    dma_memory_test_configuration_t configuration;
+    /* The number of 64-bit words in card memory which are tested */
+    size_t memory_size_words;
+    /* The number of chunks the card memory is tested in */
+    size_t num_chunks;
+    /* Overall success for DMA transfers. Once a DMA transfer fails the test is aborted, since can't then check the
+     * memory contents. */
+    bool transfer_success;
+    /* The DMA mappings for the descriptors, and the pair of host buffers for each direction */
+    vfio_dma_mapping_t descriptors_mapping;
+    vfio_dma_mapping_t h2c_data_mapping;
+    vfio_dma_mapping_t c2h_data_mapping;
+    /* The channels used to access the card memory */
+    x2x_transfer_context_t h2c_transfer;
+    x2x_transfer_context_t c2h_transfer;
+    /* The leases on the DMA channels, held from initialisation until finalisation */
+    uint32_t h2c_lease_id;
+    uint32_t c2h_lease_id;
+    /* The results from the most recent test */
+    dma_memory_test_results_t results;
+} dma_memory_test_context_t;
+
+
+bool dma_memory_test_initialise (dma_memory_test_context_t *const context,
+                                 const dma_memory_test_configuration_t *const configuration);
+void dma_memory_test_finalise (dma_memory_test_context_t *const context);
+bool dma_memory_test_run (dma_memory_test_context_t *const context, const dma_memory_test_t test);
+bool dma_memory_test_measure_throughput (dma_memory_test_context_t *const context, const int64_t duration_ns,
+                                         const bool measure_h2c, const bool measure_c2h);
+void dma_memory_test_display_results (const dma_memory_test_context_t *const context, const dma_memory_test_t test);
+
+#endif /* DMA_MEMORY_TEST_H_ */
@@ -49,6 +49,43 @@ typedef struct
 } c2h_stream_buffer_t;
 
 
+/* The number of words of CPU work performed in the populate or verify stages of DMA_TEST_MEMORY_PIPELINED_CHUNKS
+ * between polling the DMA channels for completion, so the next DMA transfer is started promptly. */
+#define PIPELINE_CPU_SLICE_WORDS 0x10000
+
+
+/* Tracks the progress of a stage of DMA_TEST_MEMORY_PIPELINED_CHUNKS performed by the CPU, which processes
+ * each chunk in order in slices */
+typedef struct
+{
+    /* The number of chunks which have been completely processed by the stage */
+    size_t num_chunks_completed;
+    /* The number of words which have been processed in the current chunk */
+    size_t chunk_word_index;
+    /* The test pattern for the next word to be processed */
+    uint32_t test_pattern;
+    /* The total time spent processing slices */
+    int64_t total_active_ns;
+} pipeline_cpu_stage_t;
+
+
+/* Tracks the progress of a stage of DMA_TEST_MEMORY_PIPELINED_CHUNKS performed by one DMA channel,
+ * which has a maximum of one chunk in flight */
+typedef struct
+{
+    /* The number of chunks for which the DMA transfer has been started */
+    size_t num_chunks_started;
+    /* The number of chunks for which the DMA transfer has completed */
+    size_t num_chunks_completed;
+    /* Set true when a DMA transfer has been started which has yet to complete */
+    bool transfer_in_flight;
+    /* The time at which the DMA transfer in flight was started */
+    int64_t transfer_start_ns;
+    /* The total time DMA transfers have been in flight */
+    int64_t total_active_ns;
+} pipeline_dma_stage_t;
+
+
 /* The list of different tests which can be performed */
 typedef enum
 {
@@ -83,6 +120,17 @@ typedef enum
      *
      * The entire card memory is written before being read back. */
     DMA_TEST_MEMORY_HOST_CHUNKS,
+    /* Perform a write/read test of DMA accessible memory using a pair of channels, with the card memory split into
+     * chunks which are passed through a pipeline of stages:
+     * 1. The CPU fills a H2C host buffer with the test pattern for the chunk.
+     * 2. The H2C channel transfers the chunk to card memory.
+     * 3. The C2H channel transfers the chunk from card memory to a C2H host buffer.
+     * 4. The CPU verifies the test pattern in the C2H host buffer.
+     *
+     * Multiple host buffers are used for each direction, so the H2C and C2H channels can run at the same time while the
+     * CPU fills and verifies other chunks. Host memory required is a fraction of the card memory.
+     * As each chunk is read back shortly after being written, may not detect high order broken address bits. */
+    DMA_TEST_MEMORY_PIPELINED_CHUNKS,
 
     DMA_TEST_ARRAY_SIZE
 } dma_test_t;
@@ -95,7 +143,8 @@ static const char *const dma_test_names[DMA_TEST_ARRAY_SIZE] =
     [DMA_TEST_STREAM_FIXED_BUFFERS_C2H_CONTINUOUS] = "stream_fixed_buffers_c2h_continuous",
     [DMA_TEST_MEMORY_VARIABLE_TRANSFERS] = "memory_variable_transfers",
     [DMA_TEST_STREAM_VARIABLE_TRANSFERS] = "stream_variable_transfers",
-    [DMA_TEST_MEMORY_HOST_CHUNKS] = "memory_host_chunks"
+    [DMA_TEST_MEMORY_HOST_CHUNKS] = "memory_host_chunks",
+    [DMA_TEST_MEMORY_PIPELINED_CHUNKS] = "memory_pipelined_chunks"
 };
 
 /* Identifies which tests use AXI streams, as opposed to DMA accessible memory */
@@ -115,7 +164,8 @@ static bool arg_enabled_tests[DMA_TEST_ARRAY_SIZE] =
     [DMA_TEST_STREAM_FIXED_BUFFERS_C2H_CONTINUOUS] = true,
     [DMA_TEST_MEMORY_VARIABLE_TRANSFERS] = true,
     [DMA_TEST_STREAM_VARIABLE_TRANSFERS] = true,
-    [DMA_TEST_MEMORY_HOST_CHUNKS] = true
+    [DMA_TEST_MEMORY_HOST_CHUNKS] = true,
+    [DMA_TEST_MEMORY_PIPELINED_CHUNKS] = true
 };
 
 
@@ -160,6 +210,15 @@ static size_t arg_stream_axi_width_bytes = 16;
 static size_t arg_host_buffer_divisor = 4;
 
 
+/* Command line argument which specifies the size of each chunk used for DMA_TEST_MEMORY_PIPELINED_CHUNKS */
+static size_t arg_pipeline_chunk_size = 0x4000000;
+
+
+/* Command line argument which specifies the number of host buffers used for each direction by
+ * DMA_TEST_MEMORY_PIPELINED_CHUNKS, which is the number of chunks which can be in each pipeline stage */
+static uint32_t arg_pipeline_depth = 3;
+
+
 /* Command line arguments for overriding the definition of DMA accessible memory for the design */
 static size_t arg_dma_bridge_memory_base_address;
 static bool arg_dma_bridge_memory_base_address_specified;
@@ -177,12 +236,15 @@ static const struct option command_line_options[] =
     {"max_buffer_size", required_argument, NULL, 0},
     {"max_channel_combinations", required_argument, NULL, 0},
     {"buffer_allocation", required_argument, NULL, 0},
+    {"prefault_threads", required_argument, NULL, 0},
     {"stream_mapping_size", required_argument, NULL, 0},
     {"stream_num_descriptors", required_argument, NULL, 0},
     {"enabled_tests", required_argument, NULL, 0},
     {"transfer_length", required_argument, NULL, 0},
     {"stream_axi_width_bytes", required_argument, NULL, 0},
     {"host_buffer_divisor", required_argument, NULL, 0},
+    {"pipeline_chunk_size", required_argument, NULL, 0},
+    {"pipeline_depth", required_argument, NULL, 0},
     {"dma_bridge_memory_base_address", required_argument, NULL, 0},
     {"dma_bridge_memory_size_bytes", required_argument, NULL, 0},
     {NULL, 0, NULL, 0}
@@ -227,8 +289,10 @@ static void display_usage (void)
     printf ("--max_channel_combinations <num>\n");
     printf ("  When a DMA bridge has more than 1 channel, limits the maximum number of\n");
     printf ("  different H2C and C2H channels used during testing\n");
-    printf ("--buffer_allocation heap|shared_memory|huge_pages\n");
+    printf ("--buffer_allocation heap|shared_memory|huge_pages|huge_pages_2M|huge_pages_1G\n");
     printf ("  Selects the VFIO buffer allocation type\n");
+    printf ("--prefault_threads <num>\n");
+    printf ("  The number of threads used to zero, and therefore pre-fault, the VFIO buffers before they are mapped\n");
     printf ("--stream_mapping_size <h2c>,<c2h>\n");
     printf ("  Specifies the size of the mapping for the host buffer when performing AXI\n");
     printf ("  stream transfers. May use different values for each direction.\n");
@@ -245,6 +309,12 @@ static void display_usage (void)
     printf ("--host_buffer_divisor <divisor>\n");
     printf ("  Specifies the divisor on the card memory size to get the host buffer size\n");
     printf ("  used for DMA_TEST_MEMORY_HOST_CHUNKS.\n");
+    printf ("--pipeline_chunk_size <size_bytes>\n");
+    printf ("  Specifies the size of each chunk of card memory used for\n");
+    printf ("  DMA_TEST_MEMORY_PIPELINED_CHUNKS. Must be a multiple of 4 bytes.\n");
+    printf ("--pipeline_depth <num>\n");
+    printf ("  Specifies the number of host buffers for each of H2C and C2H used for\n");
+    printf ("  DMA_TEST_MEMORY_PIPELINED_CHUNKS.\n");
     printf ("--dma_bridge_memory_base_address <address>\n");
     printf ("  Overrides the dma_bridge_memory_base_address specified for the design.\n");
     printf ("  To either reduce the memory tested, or investigate accessing non-existent memory\n");
@@ -314,6 +384,17 @@ static void parse_command_line_arguments (int argc, char *argv[])
                     exit (EXIT_FAILURE);
                 }
             }
+            else if (strcmp (optdef->name, "prefault_threads") == 0)
+            {
+                uint32_t prefault_threads;
+
+                if ((sscanf (optarg, "%" SCNu32 "%c", &prefault_threads, &junk) != 1) || (prefault_threads == 0))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+                vfio_set_buffer_prefault_threads (prefault_threads);
+            }
             else if (strcmp (optdef->name, "buffer_allocation") == 0)
             {
                 if (strcmp (optarg, "heap") == 0)
@@ -328,6 +409,14 @@ static void parse_command_line_arguments (int argc, char *argv[])
                 {
                     arg_buffer_allocation = VFIO_BUFFER_ALLOCATION_HUGE_PAGES;
                 }
+                else if (strcmp (optarg, "huge_pages_2M") == 0)
+                {
+                    arg_buffer_allocation = VFIO_BUFFER_ALLOCATION_HUGE_PAGES_2M;
+                }
+                else if (strcmp (optarg, "huge_pages_1G") == 0)
+                {
+                    arg_buffer_allocation = VFIO_BUFFER_ALLOCATION_HUGE_PAGES_1G;
+                }
                 else
                 {
                     printf ("Invalid %s %s\n", optdef->name, optarg);
@@ -417,6 +506,23 @@ static void parse_command_line_arguments (int argc, char *argv[])
                     exit (EXIT_FAILURE);
                 }
             }
+            else if (strcmp (optdef->name, "pipeline_chunk_size") == 0)
+            {
+                if ((sscanf (optarg, "%zi%c", &arg_pipeline_chunk_size, &junk) != 1) || (arg_pipeline_chunk_size == 0) ||
+                    ((arg_pipeline_chunk_size % sizeof (uint32_t)) != 0))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else if (strcmp (optdef->name, "pipeline_depth") == 0)
+            {
+                if ((sscanf (optarg, "%u%c", &arg_pipeline_depth, &junk) != 1) || (arg_pipeline_depth < 2))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
             else if (strcmp (optdef->name, "dma_bridge_memory_base_address") == 0)
             {
                 if (sscanf (optarg, "%zi%c", &arg_dma_bridge_memory_base_address, &junk) != 1)
@@ -1225,6 +1331,12 @@ static bool test_dma_accessible_memory_with_fixed_buffers (const fpga_design_t *
     success = (descriptors_mapping.buffer.vaddr != NULL) &&
               (h2c_data_mapping.buffer.vaddr    != NULL) &&
               (c2h_data_mapping.buffer.vaddr    != NULL);
+    if (success)
+    {
+        /* Report the setup time for the mappings for the entire card memory, which may be multiple GB */
+        display_vfio_dma_mapping_setup_times (&h2c_data_mapping, "H2C data");
+        display_vfio_dma_mapping_setup_times (&c2h_data_mapping, "C2H data");
+    }
 
     if (success)
     {
@@ -1469,6 +1581,12 @@ static bool test_dma_accessible_memory_with_variable_transfers (const fpga_desig
     success = (descriptors_mapping.buffer.vaddr != NULL) &&
               (h2c_data_mapping.buffer.vaddr    != NULL) &&
               (c2h_data_mapping.buffer.vaddr    != NULL);
+    if (success)
+    {
+        /* Report the setup time for the mappings for the entire card memory, which may be multiple GB */
+        display_vfio_dma_mapping_setup_times (&h2c_data_mapping, "H2C data");
+        display_vfio_dma_mapping_setup_times (&c2h_data_mapping, "C2H data");
+    }
 
     if (success)
     {
@@ -1871,6 +1989,351 @@ static bool test_dma_accessible_memory_in_chunks (const fpga_design_t *const des
 }
 
 
+/**
+ * @brief Get the number of words in one chunk of card memory tested by test_dma_accessible_memory_pipelined()
+ * @details All chunks are the same size, apart from the final chunk which may be shorter
+ * @param[in] chunk_index Which chunk to get the number of words for
+ * @param[in] chunk_size_words The number of words in a full size chunk
+ * @param[in] card_memory_size_words The total number of words in card memory
+ * @return The number of words in the chunk
+ */
+static size_t pipeline_chunk_num_words (const size_t chunk_index, const size_t chunk_size_words,
+                                        const size_t card_memory_size_words)
+{
+    return min_size_t (chunk_size_words, card_memory_size_words - (chunk_index * chunk_size_words));
+}
+
+
+/**
+ * @brief Perform one slice of populating the test pattern for the chunk at the populate stage of the pipeline
+ * @param[in/out] stage The populate stage, which is advanced by the number of words populated
+ * @param[out] chunk_words The H2C host buffer for the chunk being populated
+ * @param[in] num_chunk_words The number of words in the chunk being populated
+ */
+static void pipeline_populate_slice (pipeline_cpu_stage_t *const stage,
+                                     uint32_t *const chunk_words, const size_t num_chunk_words)
+{
+    const int64_t slice_start_ns = get_monotonic_time ();
+    const size_t slice_end = min_size_t (stage->chunk_word_index + PIPELINE_CPU_SLICE_WORDS, num_chunk_words);
+
+    for (size_t word_index = stage->chunk_word_index; word_index < slice_end; word_index++)
+    {
+        chunk_words[word_index] = stage->test_pattern;
+        linear_congruential_generator32 (&stage->test_pattern);
+    }
+
+    stage->chunk_word_index = slice_end;
+    if (stage->chunk_word_index == num_chunk_words)
+    {
+        stage->num_chunks_completed++;
+        stage->chunk_word_index = 0;
+    }
+    stage->total_active_ns += get_monotonic_time () - slice_start_ns;
+}
+
+
+/**
+ * @brief Perform one slice of verifying the test pattern for the chunk at the verify stage of the pipeline
+ * @param[in/out] stage The verify stage, which is advanced by the number of words verified
+ * @param[in/out] c2h_transfer The C2H transfer used to record a verification failure
+ * @param[in] chunk_words The C2H host buffer for the chunk being verified
+ * @param[in] num_chunk_words The number of words in the chunk being verified
+ * @param[in] chunk_start_word The index of the first word of the chunk in card memory, used to report failures
+ * @return Returns true if the slice had the expected test pattern, or false otherwise
+ */
+static bool pipeline_verify_slice (pipeline_cpu_stage_t *const stage, x2x_transfer_context_t *const c2h_transfer,
+                                   const uint32_t *const chunk_words, const size_t num_chunk_words,
+                                   const size_t chunk_start_word)
+{
+    const int64_t slice_start_ns = get_monotonic_time ();
+    const size_t slice_end = min_size_t (stage->chunk_word_index + PIPELINE_CPU_SLICE_WORDS, num_chunk_words);
+    bool success = true;
+
+    for (size_t word_index = stage->chunk_word_index; success && (word_index < slice_end); word_index++)
+    {
+        if (chunk_words[word_index] != stage->test_pattern)
+        {
+            x2x_record_failure (c2h_transfer, "DDR word[%zu] actual=0x%" PRIx32 " expected=0x%" PRIx32,
+                    chunk_start_word + word_index, chunk_words[word_index], stage->test_pattern);
+            success = false;
+        }
+        linear_congruential_generator32 (&stage->test_pattern);
+    }
+
+    stage->chunk_word_index = slice_end;
+    if (stage->chunk_word_index == num_chunk_words)
+    {
+        stage->num_chunks_completed++;
+        stage->chunk_word_index = 0;
+    }
+    stage->total_active_ns += get_monotonic_time () - slice_start_ns;
+
+    return success;
+}
+
+
+/**
+ * @brief Start the DMA transfer for the next chunk at a DMA stage of the pipeline
+ * @param[in/out] stage The DMA stage to start the transfer for
+ * @param[in/out] transfer The channel used for the DMA stage
+ * @param[in] num_chunk_words The number of words in the chunk to transfer
+ * @param[in] host_buffer_offset The offset in the data mapping of the host buffer for the chunk
+ * @param[in] card_buffer_offset The offset in card memory of the chunk
+ */
+static void pipeline_start_dma (pipeline_dma_stage_t *const stage, x2x_transfer_context_t *const transfer,
+                                const size_t num_chunk_words,
+                                const uint64_t host_buffer_offset, const uint64_t card_buffer_offset)
+{
+    void *const host_buffer = x2x_populate_memory_transfer (transfer, num_chunk_words * sizeof (uint32_t),
+            host_buffer_offset, card_buffer_offset);
+
+    X2X_ASSERT (transfer, host_buffer != NULL);
+    stage->transfer_start_ns = get_monotonic_time ();
+    x2x_start_populated_descriptors (transfer);
+    stage->num_chunks_started++;
+    stage->transfer_in_flight = true;
+}
+
+
+/**
+ * @brief Check for completion of the DMA transfer in flight at a DMA stage of the pipeline
+ * @param[in/out] stage The DMA stage to check
+ * @param[in/out] transfer The channel used for the DMA stage
+ */
+static void pipeline_poll_dma (pipeline_dma_stage_t *const stage, x2x_transfer_context_t *const transfer)
+{
+    if (stage->transfer_in_flight && (x2x_poll_completed_transfer (transfer, NULL, NULL) != NULL))
+    {
+        stage->total_active_ns += get_monotonic_time () - stage->transfer_start_ns;
+        stage->num_chunks_completed++;
+        stage->transfer_in_flight = false;
+    }
+}
+
+
+/**
+ * @brief Display how long one stage of the pipeline was active for, relative to the elapsed time for the test
+ * @param[in] stage_name Describes the stage
+ * @param[in] active_ns The total time the stage was active for
+ * @param[in] elapsed_ns The elapsed time for the test
+ */
+static void display_pipeline_stage_utilisation (const char *const stage_name,
+                                                const int64_t active_ns, const int64_t elapsed_ns)
+{
+    printf ("  %-21s active %.3f secs (%.1f%% of elapsed)\n",
+            stage_name, (double) active_ns / 1E9, (100.0 * (double) active_ns) / (double) elapsed_ns);
+}
+
+
+/**
+ * @brief Perform a write/read test of DMA accessible memory using a pair of channels, with a pipeline over chunks
+ * @details
+ *   Splits the card memory into chunks, where each chunk is populated, transferred to card memory by H2C,
+ *   transferred back from card memory by C2H and then verified. The stages are overlapped, such that while
+ *   the CPU is populating or verifying one chunk the H2C and C2H channels are transferring other chunks.
+ *
+ *   Each direction has a ring of pipeline_depth host buffers, which limits how far the stages can run ahead
+ *   of each other. The H2C and C2H host buffers are separate, so that a C2H transfer which fails to write to the
+ *   host buffer can't leave the expected test pattern in place.
+ *
+ *   The CPU work is performed in slices, with the DMA channels polled for completion between each slice,
+ *   so the CPU doesn't leave a channel idle for a complete chunk. Verification takes priority over populating,
+ *   unless the H2C channel has no populated chunk queued, so that C2H host buffers are released promptly.
+ * @param[in] design The design containing the DMA bridge to test
+ * @param[in/out] vfio_device The device containing the DMA bridge to test
+ * @param[in] h2c_channel_id Which channel to use for H2C transfers
+ * @param[in] c2h_channel_id Which channel to use for C2H transfers
+ * @return Returns true if the test passed, or false otherwise
+ */
+static bool test_dma_accessible_memory_pipelined (const fpga_design_t *const design, vfio_device_t *const vfio_device,
+                                                  const uint32_t h2c_channel_id, const uint32_t c2h_channel_id)
+{
+    vfio_dma_mapping_t descriptors_mapping;
+    vfio_dma_mapping_t h2c_data_mapping;
+    vfio_dma_mapping_t c2h_data_mapping;
+    x2x_transfer_context_t h2c_transfer;
+    x2x_transfer_context_t c2h_transfer;
+    pipeline_cpu_stage_t populate_stage = {0};
+    pipeline_dma_stage_t h2c_stage = {0};
+    pipeline_dma_stage_t c2h_stage = {0};
+    pipeline_cpu_stage_t verify_stage = {0};
+    bool success;
+
+    /* The chunk size is always a complete number of 32-bit words, and is limited to the card memory size */
+    const size_t card_memory_size_words = design->dma_bridge_memory_size_bytes / sizeof (uint32_t);
+    const size_t chunk_size_words = min_size_t (arg_pipeline_chunk_size / sizeof (uint32_t), card_memory_size_words);
+    const size_t chunk_size_bytes = chunk_size_words * sizeof (uint32_t);
+    const size_t num_chunks = (card_memory_size_words + chunk_size_words - 1) / chunk_size_words;
+    const size_t pipeline_depth = arg_pipeline_depth;
+    const size_t host_buffers_size_bytes = pipeline_depth * chunk_size_bytes;
+
+    const uint32_t num_descriptors_for_chunk = x2x_num_descriptors_for_transfer_len (chunk_size_bytes);
+
+    /* Populate the transfer configurations to be used */
+    const x2x_transfer_configuration_t h2c_transfer_configuration =
+    {
+        .dma_bridge_memory_base_address = design->dma_bridge_memory_base_address,
+        .dma_bridge_memory_size_bytes = design->dma_bridge_memory_size_bytes,
+        .min_size_alignment = 1, /* The card memory is byte addressable */
+        .num_descriptors = num_descriptors_for_chunk,
+        .channels_submodule = DMA_SUBMODULE_H2C_CHANNELS,
+        .channel_id = h2c_channel_id,
+        .bytes_per_buffer = 0, /* Length and offsets set before each each transfer */
+        .host_buffer_start_offset = 0,
+        .card_buffer_start_offset = 0,
+        .timeout_seconds = TRANSFER_TIMEOUT_SECS,
+        .vfio_device = vfio_device,
+        .bar_index = design->dma_bridge_bar,
+        .descriptors_mapping = &descriptors_mapping,
+        .data_mapping = &h2c_data_mapping,
+        .overall_success = &success
+    };
+
+    const x2x_transfer_configuration_t c2h_transfer_configuration =
+    {
+        .dma_bridge_memory_base_address = design->dma_bridge_memory_base_address,
+        .dma_bridge_memory_size_bytes = design->dma_bridge_memory_size_bytes,
+        .min_size_alignment = 1, /* The card memory is byte addressable */
+        .num_descriptors = num_descriptors_for_chunk,
+        .channels_submodule = DMA_SUBMODULE_C2H_CHANNELS,
+        .channel_id = c2h_channel_id,
+        .bytes_per_buffer = 0, /* Length and offsets set before each each transfer */
+        .host_buffer_start_offset = 0,
+        .card_buffer_start_offset = 0,
+        .timeout_seconds = TRANSFER_TIMEOUT_SECS,
+        .vfio_device = vfio_device,
+        .bar_index = design->dma_bridge_bar,
+        .descriptors_mapping = &descriptors_mapping,
+        .data_mapping = &c2h_data_mapping,
+        .overall_success = &success
+    };
+
+    printf ("\nTesting using %zu chunks of 0x%zx bytes with a pipeline depth of %zu:\n",
+            num_chunks, chunk_size_bytes, pipeline_depth);
+    printf ("  H2C channel %u\n", h2c_channel_id);
+    printf ("  C2H channel %u\n", c2h_channel_id);
+
+    /* Create read/write mapping for DMA descriptors */
+    const size_t descriptors_allocation_size = x2x_get_descriptor_allocation_size (&h2c_transfer_configuration) +
+            x2x_get_descriptor_allocation_size (&c2h_transfer_configuration);
+    allocate_vfio_dma_mapping (vfio_device, &descriptors_mapping, descriptors_allocation_size,
+            VFIO_DMA_MAP_FLAG_READ | VFIO_DMA_MAP_FLAG_WRITE, arg_buffer_allocation);
+
+    /* Read only mapping used by device for the H2C host buffers */
+    allocate_vfio_dma_mapping (vfio_device, &h2c_data_mapping, host_buffers_size_bytes,
+            VFIO_DMA_MAP_FLAG_READ, arg_buffer_allocation);
+
+    /* Write only mapping used by device for the C2H host buffers */
+    allocate_vfio_dma_mapping (vfio_device, &c2h_data_mapping, host_buffers_size_bytes,
+            VFIO_DMA_MAP_FLAG_WRITE, arg_buffer_allocation);
+
+    success = (descriptors_mapping.buffer.vaddr != NULL) &&
+              (h2c_data_mapping.buffer.vaddr    != NULL) &&
+              (c2h_data_mapping.buffer.vaddr    != NULL);
+
+    if (success)
+    {
+        uint32_t *const h2c_host_words = h2c_data_mapping.buffer.vaddr;
+        const uint32_t *const c2h_host_words = c2h_data_mapping.buffer.vaddr;
+
+        /* Initialise the transfers */
+        x2x_initialise_transfer_context (&h2c_transfer, &h2c_transfer_configuration);
+        x2x_initialise_transfer_context (&c2h_transfer, &c2h_transfer_configuration);
+
+        const int64_t start_time_ns = get_monotonic_time ();
+        while (success && (verify_stage.num_chunks_completed < num_chunks))
+        {
+            /* Retire any completed DMA transfers */
+            pipeline_poll_dma (&h2c_stage, &h2c_transfer);
+            pipeline_poll_dma (&c2h_stage, &c2h_transfer);
+
+            /* Start the H2C transfer for the next chunk once it has been populated */
+            if (success && !h2c_stage.transfer_in_flight && (h2c_stage.num_chunks_started < populate_stage.num_chunks_completed))
+            {
+                const size_t chunk_index = h2c_stage.num_chunks_started;
+
+                pipeline_start_dma (&h2c_stage, &h2c_transfer,
+                        pipeline_chunk_num_words (chunk_index, chunk_size_words, card_memory_size_words),
+                        (chunk_index % pipeline_depth) * chunk_size_bytes, chunk_index * chunk_size_bytes);
+            }
+
+            /* Start the C2H transfer for the next chunk once it has been written to card memory,
+             * and the C2H host buffer is no longer in use for verifying an earlier chunk */
+            if (success && !c2h_stage.transfer_in_flight && (c2h_stage.num_chunks_started < h2c_stage.num_chunks_completed) &&
+                ((c2h_stage.num_chunks_started - verify_stage.num_chunks_completed) < pipeline_depth))
+            {
+                const size_t chunk_index = c2h_stage.num_chunks_started;
+
+                pipeline_start_dma (&c2h_stage, &c2h_transfer,
+                        pipeline_chunk_num_words (chunk_index, chunk_size_words, card_memory_size_words),
+                        (chunk_index % pipeline_depth) * chunk_size_bytes, chunk_index * chunk_size_bytes);
+            }
+
+            /* Perform one slice of CPU work. A H2C host buffer can be populated once the H2C transfer which previously
+             * used the host buffer has completed. */
+            const bool can_verify = verify_stage.num_chunks_completed < c2h_stage.num_chunks_completed;
+            const bool can_populate = (populate_stage.num_chunks_completed < num_chunks) &&
+                    ((populate_stage.num_chunks_completed - h2c_stage.num_chunks_completed) < pipeline_depth);
+            const bool h2c_awaiting_populate = populate_stage.num_chunks_completed == h2c_stage.num_chunks_started;
+
+            if (success && can_populate && (h2c_awaiting_populate || !can_verify))
+            {
+                const size_t chunk_index = populate_stage.num_chunks_completed;
+
+                pipeline_populate_slice (&populate_stage, &h2c_host_words[(chunk_index % pipeline_depth) * chunk_size_words],
+                        pipeline_chunk_num_words (chunk_index, chunk_size_words, card_memory_size_words));
+            }
+            else if (success && can_verify)
+            {
+                const size_t chunk_index = verify_stage.num_chunks_completed;
+
+                success = pipeline_verify_slice (&verify_stage, &c2h_transfer,
+                        &c2h_host_words[(chunk_index % pipeline_depth) * chunk_size_words],
+                        pipeline_chunk_num_words (chunk_index, chunk_size_words, card_memory_size_words),
+                        chunk_index * chunk_size_words);
+            }
+        }
+        const int64_t elapsed_ns = get_monotonic_time () - start_time_ns;
+
+        x2x_finalise_transfer_context (&h2c_transfer);
+        x2x_finalise_transfer_context (&c2h_transfer);
+
+        if (success)
+        {
+            /* The serial time is that which would be taken if the stages weren't overlapped */
+            const int64_t serial_ns = populate_stage.total_active_ns + h2c_stage.total_active_ns +
+                    c2h_stage.total_active_ns + verify_stage.total_active_ns;
+            const double elapsed_secs = (double) elapsed_ns / 1E9;
+
+            display_pipeline_stage_utilisation ("populate test pattern", populate_stage.total_active_ns, elapsed_ns);
+            display_pipeline_stage_utilisation ("host-to-card DMA", h2c_stage.total_active_ns, elapsed_ns);
+            display_pipeline_stage_utilisation ("card-to-host DMA", c2h_stage.total_active_ns, elapsed_ns);
+            display_pipeline_stage_utilisation ("verify test pattern", verify_stage.total_active_ns, elapsed_ns);
+            printf ("  Elapsed %.3f secs = %0.6lf (Mbytes/sec) : %.2f times faster than serial stages\n",
+                    elapsed_secs, ((double) design->dma_bridge_memory_size_bytes / elapsed_secs) / 1E6,
+                    (double) serial_ns / (double) elapsed_ns);
+            printf ("TEST PASS\n");
+        }
+        else
+        {
+            printf ("TEST FAIL:\n");
+            report_if_transfer_failed (&h2c_transfer);
+            report_if_transfer_failed (&c2h_transfer);
+        }
+    }
+    else
+    {
+        printf ("TEST FAIL : allocate_vfio_dma_mapping()\n");
+    }
+
+    free_vfio_dma_mapping (&c2h_data_mapping);
+    free_vfio_dma_mapping (&h2c_data_mapping);
+    free_vfio_dma_mapping (&descriptors_mapping);
+
+    return success;
+}
+
+
 /**
  * @brief Perform one DMA bridge test which is enabled and supported by a design
  * @param[in] dma_test Which test to perform
@@ -1917,6 +2380,10 @@ static bool perform_enabled_test (const dma_test_t dma_test,
         success = test_dma_accessible_memory_in_chunks (design, vfio_device, h2c_channel_id, c2h_channel_id);
         break;
 
+    case DMA_TEST_MEMORY_PIPELINED_CHUNKS:
+        success = test_dma_accessible_memory_pipelined (design, vfio_device, h2c_channel_id, c2h_channel_id);
+        break;
+
     default:
         /* Shouldn't get here */
         success = false;
@@ -1991,7 +2458,7 @@ int main (int argc, char *argv[])
         {
             if (designs.designs[design_index].dma_bridge_present)
             {
-                designs.vfio_devices.devices[design_index].dma_capability = VFIO_DEVICE_DMA_CAPABILITY_A32;
+                designs.vfio_devices.devices[design_index]->dma_capability = VFIO_DEVICE_DMA_CAPABILITY_A32;
             }
         }
     }
@@ -2000,7 +2467,7 @@ int main (int argc, char *argv[])
     for (design_index = 0; design_index < designs.num_identified_designs; design_index++)
     {
         fpga_design_t *const design = &designs.designs[design_index];
-        vfio_device_t *const vfio_device = &designs.vfio_devices.devices[design_index];
+        vfio_device_t *const vfio_device = designs.vfio_devices.devices[design_index];
 
         if (design->dma_bridge_present)
         {
@@ -22,9 +22,11 @@
 #include "xilinx_dma_bridge_transfers.h"
 #include "xilinx_axi_stream_switch_configure.h"
 #include "transfer_timing.h"
+#include "vfio_error_monitor.h"
 
 #include <stdlib.h>
 #include <string.h>
+#include <inttypes.h>
 #include <stdio.h>
 
 #include <getopt.h>
@@ -37,8 +39,8 @@
 #define TRANSFER_TIMEOUT_SECS 10
 
 
-/* Used to size arrays of streams in one direction which may be tested in parallel */
-#define MAX_STREAMS_PER_DIRECTION (MAX_VFIO_DEVICES * X2X_MAX_CHANNELS)
+/* The interval at which the PCIe error status of the devices is polled, when monitoring for PCIe errors */
+#define PCIE_ERROR_POLL_INTERVAL_NS 1000000000L
 
 
 /* Command line argument which sets the VFIO buffer allocation type */
@@ -57,6 +59,17 @@ static uint32_t arg_stream_num_descriptors = 64;
 static bool arg_use_one_container_for_mappings;
 
 
+/* Command line argument which specifies the maximum number of times during the test that a stream can be recovered after a
+ * transfer failure. Zero means the test stops on the first failure. */
+static uint32_t arg_max_recoveries;
+
+
+/* Command line arguments which enable monitoring the devices for PCIe errors during the test, and optionally stop the
+ * test when a PCIe error is reported. */
+static bool arg_monitor_pcie_errors;
+static bool arg_stop_on_pcie_error;
+
+
 /* Identifies the direction for one stream tested */
 typedef enum
 {
@@ -83,8 +96,9 @@ typedef struct
     /* The channels IDs of the streams on the device to be tested */
     uint32_t channel_ids[X2X_DIRECTION_ARRAY_SIZE][X2X_MAX_CHANNELS];
 } tested_device_filter_t;
-static tested_device_filter_t arg_tested_device_filters[MAX_VFIO_DEVICES];
+static tested_device_filter_t *arg_tested_device_filters;
 static uint32_t arg_num_tested_device_filters;
+static uint32_t arg_tested_device_filters_allocated_length;
 
 
 /** The command line options for this program, in the format passed to getopt_long().
@@ -95,10 +109,14 @@ static const struct option command_line_options[] =
     {"c2h_stream_device", required_argument, NULL, 0},
     {"device_routing", required_argument, NULL, 0},
     {"buffer_allocation", required_argument, NULL, 0},
+    {"prefault_threads", required_argument, NULL, 0},
     {"stream_mapping_size", required_argument, NULL, 0},
     {"stream_num_descriptors", required_argument, NULL, 0},
     {"isolate_iommu_groups", no_argument, NULL, 0},
     {"use_one_container_for_mappings", no_argument, NULL, 0},
+    {"max_recoveries", required_argument, NULL, 0},
+    {"monitor_pcie_errors", no_argument, NULL, 0},
+    {"stop_on_pcie_error", no_argument, NULL, 0},
     {NULL, 0, NULL, 0}
 };
 
@@ -107,6 +125,10 @@ static const struct option command_line_options[] =
 static volatile bool test_stop_requested;
 
 
+/* Set true by the PCIe error monitor callback when the test is stopped due to a PCIe error */
+static volatile bool test_stopped_on_pcie_error;
+
+
 /* Used to maintain statistics for the throughout on one AXI stream */
 typedef struct
 {
@@ -159,9 +181,9 @@ typedef struct
     uint32_t num_streams[X2X_DIRECTION_ARRAY_SIZE];
     /* Total number of streams tested, sum of num_streams[] */
     uint32_t total_streams_tested;
-    /* The array of streams to test in parallel.
+    /* The array of streams to test in parallel, allocated for the maximum number of channels in the identified designs.
      * Valid indices are in the range [][0 .. stream_pairs-1] */
-    stream_test_context_t streams[X2X_DIRECTION_ARRAY_SIZE][MAX_STREAMS_PER_DIRECTION];
+    stream_test_context_t *streams[X2X_DIRECTION_ARRAY_SIZE];
     /* Points at the fist used entry in streams[], for code which uses any DMA transfer or device */
     stream_test_context_t *first_stream;
     /* The test operates with the stream transfers set to use fixed size buffers, so doesn't need to modify the
@@ -170,16 +192,20 @@ typedef struct
     size_t bytes_per_buffer;
     /* The number of words in each data mapping, which defines the length of the test pattern */
     size_t data_mapping_size_words;
-    /* Overall success for the test. Set to false any an error on any test stream pair, which stops the test. */
+    /* Overall success for the test. Set to false any an error on any test stream pair, which stops the test
+     * unless the stream is recovered. */
     bool overall_success;
+    /* The number of times during the test streams have been successfully recovered after a transfer failure */
+    uint32_t num_recoveries;
 } stream_test_contexts_t;
 
 
 /* Contains the statistics for all tested streams for one reporting interval of the test */
 typedef struct
 {
-    /* The throughput statistics for the current reporting interval for each stream */
-    stream_throughput_statistics_t streams[X2X_DIRECTION_ARRAY_SIZE][MAX_STREAMS_PER_DIRECTION];
+    /* The throughput statistics for the current reporting interval for each stream, allocated with the same length as
+     * stream_test_contexts_t.streams[] */
+    stream_throughput_statistics_t *streams[X2X_DIRECTION_ARRAY_SIZE];
     /* Set true in the final statistics before the independent_streams_test_thread() exits */
     bool final_statistics;
 } stream_test_statistics_t;
@@ -237,8 +263,10 @@ static void display_usage (void)
     printf ("  The routing in specified as zero or more pairs of the master port and the\n");
     printf ("  slave port used for the route. Unspecified master ports are left disabled\n");
     printf ("  May be used more than once.\n");
-    printf ("--buffer_allocation heap|shared_memory|huge_pages\n");
+    printf ("--buffer_allocation heap|shared_memory|huge_pages|huge_pages_2M|huge_pages_1G\n");
     printf ("  Selects the VFIO buffer allocation type\n");
+    printf ("--prefault_threads <num>\n");
+    printf ("  The number of threads used to zero, and therefore pre-fault, the VFIO buffers before they are mapped\n");
     printf ("--stream_mapping_size <size_bytes>\n");
     printf ("  Specifies the size of the mapping for the host buffer when performing AXI\n");
     printf ("  stream transfers.\n");
@@ -249,6 +277,16 @@ static void display_usage (void)
     printf ("--use_one_container_for_mappings\n");
     printf ("  Causes the first container to be used for all DMA mappings\n");
     printf ("  mappings.\n");
+    printf ("--max_recoveries <num>\n");
+    printf ("  The maximum number of times during the test that a stream is recovered after a\n");
+    printf ("  transfer failure, to allow the test to continue after transient errors.\n");
+    printf ("  Default is zero which stops the test on the first failure.\n");
+    printf ("--monitor_pcie_errors\n");
+    printf ("  Monitor the tested devices for PCIe errors during the test, reporting the\n");
+    printf ("  errors with timestamps.\n");
+    printf ("--stop_on_pcie_error\n");
+    printf ("  Monitor the tested devices for PCIe errors, and stop the test with a failure\n");
+    printf ("  when an error is reported.\n");
     printf ("\n");
 
     exit (EXIT_FAILURE);
@@ -317,9 +355,12 @@ static void parse_command_line_arguments (int argc, char *argv[])
                         }
                     }
 
-                    if (!found_existing_device && (arg_num_tested_device_filters < MAX_VFIO_DEVICES))
+                    if (!found_existing_device)
                     {
                         /* Add a new device to be tested */
+                        arg_tested_device_filters = vfio_grow_array (arg_tested_device_filters,
+                                &arg_tested_device_filters_allocated_length, arg_num_tested_device_filters + 1,
+                                sizeof (arg_tested_device_filters[0]), "arg_tested_device_filters");
                         tested_device_filter_t *const new_filter = &arg_tested_device_filters[arg_num_tested_device_filters];
 
                         new_filter->device_filter = filter;
@@ -344,6 +385,17 @@ static void parse_command_line_arguments (int argc, char *argv[])
 
                 process_device_routing_argument (optarg, add_pci_device_location_filter);
             }
+            else if (strcmp (optdef->name, "prefault_threads") == 0)
+            {
+                uint32_t prefault_threads;
+
+                if ((sscanf (optarg, "%" SCNu32 "%c", &prefault_threads, &junk) != 1) || (prefault_threads == 0))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+                vfio_set_buffer_prefault_threads (prefault_threads);
+            }
             else if (strcmp (optdef->name, "buffer_allocation") == 0)
             {
                 if (strcmp (optarg, "heap") == 0)
@@ -358,6 +410,14 @@ static void parse_command_line_arguments (int argc, char *argv[])
                 {
                     arg_buffer_allocation = VFIO_BUFFER_ALLOCATION_HUGE_PAGES;
                 }
+                else if (strcmp (optarg, "huge_pages_2M") == 0)
+                {
+                    arg_buffer_allocation = VFIO_BUFFER_ALLOCATION_HUGE_PAGES_2M;
+                }
+                else if (strcmp (optarg, "huge_pages_1G") == 0)
+                {
+                    arg_buffer_allocation = VFIO_BUFFER_ALLOCATION_HUGE_PAGES_1G;
+                }
                 else
                 {
                     printf ("Invalid %s %s\n", optdef->name, optarg);
@@ -395,6 +455,23 @@ static void parse_command_line_arguments (int argc, char *argv[])
             {
                 arg_use_one_container_for_mappings = true;
             }
+            else if (strcmp (optdef->name, "max_recoveries") == 0)
+            {
+                if (sscanf (optarg, "%" SCNu32 "%c", &arg_max_recoveries, &junk) != 1)
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else if (strcmp (optdef->name, "monitor_pcie_errors") == 0)
+            {
+                arg_monitor_pcie_errors = true;
+            }
+            else if (strcmp (optdef->name, "stop_on_pcie_error") == 0)
+            {
+                arg_monitor_pcie_errors = true;
+                arg_stop_on_pcie_error = true;
+            }
             else
             {
                 /* This is a program error, and shouldn't be triggered by the command line options */
@@ -573,6 +650,88 @@ static void publish_statistics (stream_test_contexts_t *const context, const boo
 }
 
 
+/**
+ * @brief Queue transfers on all free descriptors for a stream
+ * @param[in/out] stream The stream to queue the transfers for
+ * @param[in] direction The direction of the stream
+ * @param[in] num_descriptors The number of descriptors to queue transfers on
+ */
+static void queue_stream_transfers (stream_test_context_t *const stream, const x2x_direction_t direction,
+                                    const uint32_t num_descriptors)
+{
+    void *buffer;
+
+    for (uint32_t descriptor_index = 0; !stream->transfer.failed && (descriptor_index < num_descriptors); descriptor_index++)
+    {
+        if (direction == X2X_DIRECTION_C2H)
+        {
+            x2x_start_next_c2h_buffer (&stream->transfer);
+        }
+        else
+        {
+            buffer = x2x_get_next_h2c_buffer (&stream->transfer);
+            X2X_ASSERT (&stream->transfer, buffer != NULL);
+            x2x_start_populated_descriptors (&stream->transfer);
+        }
+    }
+}
+
+
+/**
+ * @brief Determine if no tested stream is currently recorded as having failed
+ * @param[in] context The context for the test
+ * @return Returns true if all tested streams are free from failure
+ */
+static bool no_stream_failed (const stream_test_contexts_t *const context)
+{
+    bool success = true;
+
+    for (x2x_direction_t direction = 0; success && (direction < X2X_DIRECTION_ARRAY_SIZE); direction++)
+    {
+        for (uint32_t stream_index = 0; success && (stream_index < context->num_streams[direction]); stream_index++)
+        {
+            success = !context->streams[direction][stream_index].transfer.failed;
+        }
+    }
+
+    return success;
+}
+
+
+/**
+ * @brief Attempt to recover a stream after a transfer failure, so that the test can continue
+ * @details If recovery is successful the overall success of the test is re-evaluated from the failure state of all
+ *          streams, so that a failure on a different stream which hasn't been recovered still stops the test.
+ *          Unless the test is stopping the transfers for the recovered stream are re-queued.
+ *          If recovery fails, the overall success remains false which stops the test.
+ *          Only successful recoveries count towards the --max_recoveries limit.
+ * @param[in/out] context The context for the test
+ * @param[in/out] stream The stream which has failed
+ * @param[in] direction The direction of the failed stream
+ * @param[in] test_stopping When true the test is stopping, so no further transfers are queued on the stream
+ */
+static void recover_failed_stream (stream_test_contexts_t *const context, stream_test_context_t *const stream,
+                                   const x2x_direction_t direction, const bool test_stopping)
+{
+    uint32_t num_lost_transfers;
+
+    printf ("  %s %s channel %u recovering from failure : %s\n",
+            stream->vfio_device->device_name, x2x_direction_names[direction], stream->channel_id,
+            stream->transfer.error_message);
+    if (x2x_recover_transfer_context (&stream->transfer, &num_lost_transfers))
+    {
+        printf ("  %s %s channel %u recovered with %u lost transfers\n",
+                stream->vfio_device->device_name, x2x_direction_names[direction], stream->channel_id, num_lost_transfers);
+        context->num_recoveries++;
+        context->overall_success = no_stream_failed (context);
+        if (!test_stopping)
+        {
+            queue_stream_transfers (stream, direction, context->num_descriptors);
+        }
+    }
+}
+
+
 /**
  * @brief The entry point for thread which tests streams in parallel
  * @details
@@ -700,6 +859,12 @@ static void *independent_streams_test_thread (void *const arg)
                     stream->completed_times[stream->last_completed_descriptor_index] = now;
                 }
 
+                /* Attempt to recover from a transfer failure, if the number of recoveries hasn't been exhausted */
+                if (stream->transfer.failed && (context->num_recoveries < arg_max_recoveries))
+                {
+                    recover_failed_stream (context, stream, direction, test_stopping);
+                }
+
                 /* Once the test has been requested to stop, monitor when the transfers have become idle meaning
                  * all outstanding transfers have completed */
                 if (test_stopping && (stream->transfer.num_in_use_descriptors == 0))
@@ -800,6 +965,56 @@ static void display_stream_statistics (const stream_test_contexts_t *const conte
 }
 
 
+/**
+ * @brief Callback from the PCIe error monitor, which requests the test stops when enabled by the command line arguments
+ * @details Called after vfio_error_monitor_display_event() has displayed the error event
+ * @param[in] event The PCIe error event
+ * @param[in] callback_context Not used
+ */
+static void stop_test_on_pcie_error (const vfio_error_event_t *const event, void *const callback_context)
+{
+    if (arg_stop_on_pcie_error)
+    {
+        test_stopped_on_pcie_error = true;
+        test_stop_requested = true;
+    }
+}
+
+
+/**
+ * @brief Start monitoring for PCIe errors on the devices which contain the streams being tested
+ * @param[out] monitor The monitor to start
+ * @param[in] context The test context, which identifies the streams being tested
+ */
+static void start_pcie_error_monitor (vfio_error_monitor_t *const monitor, const stream_test_contexts_t *const context)
+{
+    vfio_error_monitor_initialise (monitor, PCIE_ERROR_POLL_INTERVAL_NS, false);
+    vfio_error_monitor_register_callback (monitor, vfio_error_monitor_display_event, NULL);
+    vfio_error_monitor_register_callback (monitor, stop_test_on_pcie_error, NULL);
+
+    /* Add each device once, since multiple streams may be tested on the same device */
+    for (x2x_direction_t direction = 0; direction < X2X_DIRECTION_ARRAY_SIZE; direction++)
+    {
+        for (uint32_t stream_index = 0; stream_index < context->num_streams[direction]; stream_index++)
+        {
+            vfio_device_t *const vfio_device = context->streams[direction][stream_index].vfio_device;
+            bool device_monitored = false;
+
+            for (uint32_t device_index = 0; !device_monitored && (device_index < monitor->num_devices); device_index++)
+            {
+                device_monitored = monitor->devices[device_index].vfio_device == vfio_device;
+            }
+            if (!device_monitored)
+            {
+                vfio_error_monitor_add_device (monitor, vfio_device);
+            }
+        }
+    }
+
+    vfio_error_monitor_start (monitor);
+}
+
+
 /**
  * @brief Sequence the testing of streams tested in parallel
  * @details
@@ -819,6 +1034,8 @@ static void sequence_independent_streams_test (stream_test_contexts_t *const con
     x2x_direction_t direction;
     uint32_t stream_index;
     pthread_t id;
+    vfio_error_monitor_t pcie_error_monitor;
+    bool pcie_error_monitor_started = false;
 
     /* Perform initialisation.
      * X2X_ASSERT doesn't suspend the calling process on failure, which is reason for conditional tests on overall_success. */
@@ -840,6 +1057,12 @@ static void sequence_independent_streams_test (stream_test_contexts_t *const con
         X2X_ASSERT (&context->first_stream->transfer, rc == 0);
     }
 
+    if (context->overall_success && arg_monitor_pcie_errors)
+    {
+        start_pcie_error_monitor (&pcie_error_monitor, context);
+        pcie_error_monitor_started = true;
+    }
+
     if (context->overall_success)
     {
         rc = pthread_create (&id, NULL, independent_streams_test_thread, context);
@@ -880,14 +1103,34 @@ static void sequence_independent_streams_test (stream_test_contexts_t *const con
         X2X_ASSERT (&context->first_stream->transfer, rc == 0);
     }
 
+    if (pcie_error_monitor_started)
+    {
+        const uint64_t num_pcie_error_events = vfio_error_monitor_total_events (&pcie_error_monitor);
+
+        vfio_error_monitor_stop (&pcie_error_monitor);
+        printf ("%" PRIu64 " PCIe error events reported during the test\n", num_pcie_error_events);
+        if (test_stopped_on_pcie_error)
+        {
+            printf ("Test stopped due to a PCIe error\n");
+            context->overall_success = false;
+        }
+    }
+
     /* Display overall test statistics */
     printf ("Overall test statistics:\n");
     for (direction = 0; direction < X2X_DIRECTION_ARRAY_SIZE; direction++)
     {
         for (stream_index = 0; stream_index < context->num_streams[direction]; stream_index++)
         {
-            display_stream_statistics (context, direction, stream_index,
-                    &context->streams[direction][stream_index].overall_statistics);
+            const stream_test_context_t *const stream = &context->streams[direction][stream_index];
+
+            display_stream_statistics (context, direction, stream_index, &stream->overall_statistics);
+            if (stream->transfer.num_recoveries > 0)
+            {
+                printf ("  %s %s channel %u recovered %u times with %" PRIu64 " lost transfers\n",
+                        stream->vfio_device->device_name, x2x_direction_names[direction], stream->channel_id,
+                        stream->transfer.num_recoveries, stream->transfer.num_lost_transfers);
+            }
         }
     }
     printf ("\n");
@@ -919,10 +1162,22 @@ int main (int argc, char *argv[])
             context.num_descriptors, context.bytes_per_buffer, context.data_mapping_size_words);
 
     /* Create the array of AXI streams which can be tested */
+    const uint32_t max_streams_per_direction = (designs.num_identified_designs > 0) ?
+            (designs.num_identified_designs * X2X_MAX_CHANNELS) : 1;
+    for (x2x_direction_t direction = 0; direction < X2X_DIRECTION_ARRAY_SIZE; direction++)
+    {
+        context.streams[direction] = calloc (max_streams_per_direction, sizeof (context.streams[direction][0]));
+        test_statistics.streams[direction] = calloc (max_streams_per_direction, sizeof (test_statistics.streams[direction][0]));
+        if ((context.streams[direction] == NULL) || (test_statistics.streams[direction] == NULL))
+        {
+            printf ("Failed to allocate memory for streams\n");
+            exit (EXIT_FAILURE);
+        }
+    }
     for (uint32_t design_index = 0; design_index < designs.num_identified_designs; design_index++)
     {
         fpga_design_t *const design = &designs.designs[design_index];
-        vfio_device_t *const vfio_device = &designs.vfio_devices.devices[design_index];
+        vfio_device_t *const vfio_device = designs.vfio_devices.devices[design_index];
 
         if (design->dma_bridge_present)
         {
@@ -989,6 +1244,11 @@ int main (int argc, char *argv[])
     }
 
     close_pcie_fpga_designs (&designs);
+    for (x2x_direction_t direction = 0; direction < X2X_DIRECTION_ARRAY_SIZE; direction++)
+    {
+        free (context.streams[direction]);
+        free (test_statistics.streams[direction]);
+    }
 
     if (context.total_streams_tested > 0)
     {
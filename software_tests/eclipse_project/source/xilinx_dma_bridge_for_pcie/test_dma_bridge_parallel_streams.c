@@ -36,10 +36,6 @@
 #define TRANSFER_TIMEOUT_SECS 10
 
 
-/* Used to size arrays of stream pairs which may be tested in parallel */
-#define MAX_STREAM_PAIRS (MAX_VFIO_DEVICES * X2X_MAX_CHANNELS)
-
-
 /* Command line argument which sets the VFIO buffer allocation type */
 static vfio_buffer_allocation_type_t arg_buffer_allocation = VFIO_BUFFER_ALLOCATION_HEAP;
 
@@ -67,8 +63,9 @@ typedef struct
     /* The C2H channels IDs of the stream pairs on the device to be tested */
     uint32_t h2c_channel_ids[X2X_MAX_CHANNELS];
 } tested_device_filter_t;
-static tested_device_filter_t arg_tested_device_filters[MAX_VFIO_DEVICES];
+static tested_device_filter_t *arg_tested_device_filters;
 static uint32_t arg_num_tested_device_filters;
+static uint32_t arg_tested_device_filters_allocated_length;
 
 
 /** The command line options for this program, in the format passed to getopt_long().
@@ -78,6 +75,7 @@ static const struct option command_line_options[] =
     {"stream_device", required_argument, NULL, 0},
     {"device_routing", required_argument, NULL, 0},
     {"buffer_allocation", required_argument, NULL, 0},
+    {"prefault_threads", required_argument, NULL, 0},
     {"stream_mapping_size", required_argument, NULL, 0},
     {"stream_num_descriptors", required_argument, NULL, 0},
     {"isolate_iommu_groups", no_argument, NULL, 0},
@@ -148,9 +146,9 @@ typedef struct
 {
     /* The number of pairs of streams tested */
     uint32_t num_stream_pairs;
-    /* The array of stream pairs to test in parallel.
+    /* The array of stream pairs to test in parallel, allocated for the maximum number of channels in the identified designs.
      * Valid indices are in the range [0 .. num_stream_pairs-1] */
-    stream_test_context_t stream_pairs[MAX_STREAM_PAIRS];
+    stream_test_context_t *stream_pairs;
     /* The test operates with the stream transfers set to use fixed size buffers, so doesn't need to modify the
      * descriptors when the descriptors are started. */
     uint32_t num_descriptors;
@@ -165,8 +163,9 @@ typedef struct
 /* Contains the statistics for all tested streams for one reporting interval of the test */
 typedef struct
 {
-    /* The throughput statistics for the current reporting interval for each stream */
-    stream_pair_throughput_statistics_t stream_pairs[MAX_STREAM_PAIRS];
+    /* The throughput statistics for the current reporting interval for each stream, allocated with the same length as
+     * stream_test_contexts_t.stream_pairs[] */
+    stream_pair_throughput_statistics_t *stream_pairs;
     /* Set true in the final statistics before the parallel_streams_test_thread() exits */
     bool final_statistics;
 } stream_test_statistics_t;
@@ -221,8 +220,10 @@ static void display_usage (void)
     printf ("  The routing in specified as zero or more pairs of the master port and the\n");
     printf ("  slave port used for the route. Unspecified master ports are left disabled\n");
     printf ("  May be used more than once.\n");
-    printf ("--buffer_allocation heap|shared_memory|huge_pages\n");
+    printf ("--buffer_allocation heap|shared_memory|huge_pages|huge_pages_2M|huge_pages_1G\n");
     printf ("  Selects the VFIO buffer allocation type\n");
+    printf ("--prefault_threads <num>\n");
+    printf ("  The number of threads used to zero, and therefore pre-fault, the VFIO buffers before they are mapped\n");
     printf ("--stream_mapping_size <size_bytes>\n");
     printf ("  Specifies the size of the mapping for the host buffer when performing AXI\n");
     printf ("  stream transfers.\n");
@@ -298,9 +299,12 @@ static void parse_command_line_arguments (int argc, char *argv[])
                         }
                     }
 
-                    if (!found_existing_device && (arg_num_tested_device_filters < MAX_VFIO_DEVICES))
+                    if (!found_existing_device)
                     {
                         /* Add a new device to be tested */
+                        arg_tested_device_filters = vfio_grow_array (arg_tested_device_filters,
+                                &arg_tested_device_filters_allocated_length, arg_num_tested_device_filters + 1,
+                                sizeof (arg_tested_device_filters[0]), "arg_tested_device_filters");
                         tested_device_filter_t *const new_filter = &arg_tested_device_filters[arg_num_tested_device_filters];
 
                         new_filter->device_filter = filter;
@@ -325,6 +329,17 @@ static void parse_command_line_arguments (int argc, char *argv[])
 
                 process_device_routing_argument (optarg, add_pci_device_location_filter);
             }
+            else if (strcmp (optdef->name, "prefault_threads") == 0)
+            {
+                uint32_t prefault_threads;
+
+                if ((sscanf (optarg, "%" SCNu32 "%c", &prefault_threads, &junk) != 1) || (prefault_threads == 0))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+                vfio_set_buffer_prefault_threads (prefault_threads);
+            }
             else if (strcmp (optdef->name, "buffer_allocation") == 0)
             {
                 if (strcmp (optarg, "heap") == 0)
@@ -339,6 +354,14 @@ static void parse_command_line_arguments (int argc, char *argv[])
                 {
                     arg_buffer_allocation = VFIO_BUFFER_ALLOCATION_HUGE_PAGES;
                 }
+                else if (strcmp (optarg, "huge_pages_2M") == 0)
+                {
+                    arg_buffer_allocation = VFIO_BUFFER_ALLOCATION_HUGE_PAGES_2M;
+                }
+                else if (strcmp (optarg, "huge_pages_1G") == 0)
+                {
+                    arg_buffer_allocation = VFIO_BUFFER_ALLOCATION_HUGE_PAGES_1G;
+                }
                 else
                 {
                     printf ("Invalid %s %s\n", optdef->name, optarg);
@@ -935,11 +958,20 @@ int main (int argc, char *argv[])
             context.num_descriptors, context.bytes_per_buffer, context.data_mapping_size_words);
 
     /* Create the array of AXI streams which can be tested */
+    const uint32_t max_stream_pairs = (designs.num_identified_designs > 0) ?
+            (designs.num_identified_designs * X2X_MAX_CHANNELS) : 1;
+    context.stream_pairs = calloc (max_stream_pairs, sizeof (context.stream_pairs[0]));
+    test_statistics.stream_pairs = calloc (max_stream_pairs, sizeof (test_statistics.stream_pairs[0]));
+    if ((context.stream_pairs == NULL) || (test_statistics.stream_pairs == NULL))
+    {
+        printf ("Failed to allocate memory for stream pairs\n");
+        exit (EXIT_FAILURE);
+    }
     context.num_stream_pairs = 0;
     for (uint32_t design_index = 0; design_index < designs.num_identified_designs; design_index++)
     {
         fpga_design_t *const design = &designs.designs[design_index];
-        vfio_device_t *const vfio_device = &designs.vfio_devices.devices[design_index];
+        vfio_device_t *const vfio_device = designs.vfio_devices.devices[design_index];
 
         if (design->dma_bridge_present)
         {
@@ -983,6 +1015,8 @@ int main (int argc, char *argv[])
     }
 
     close_pcie_fpga_designs (&designs);
+    free (context.stream_pairs);
+    free (test_statistics.stream_pairs);
 
     if (context.num_stream_pairs > 0)
     {
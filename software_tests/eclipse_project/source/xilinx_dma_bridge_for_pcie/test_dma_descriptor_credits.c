@@ -1022,7 +1022,7 @@ static bool test_memory_mapped_descriptor_rings (fpga_designs_t *const designs,
     };
 
     fpga_design_t *const design = &designs->designs[design_index];
-    vfio_device_t *const vfio_device = &designs->vfio_devices.devices[design_index];
+    vfio_device_t *const vfio_device = designs->vfio_devices.devices[design_index];
 
     spawn_child_when_required (&test_dma_mappings);
 
@@ -1258,7 +1258,7 @@ static bool test_stream_descriptor_rings_loopback (fpga_designs_t *const designs
     };
 
     fpga_design_t *const design = &designs->designs[design_index];
-    vfio_device_t *const vfio_device = &designs->vfio_devices.devices[design_index];
+    vfio_device_t *const vfio_device = designs->vfio_devices.devices[design_index];
 
     spawn_child_when_required (&test_dma_mappings);
 
@@ -1590,7 +1590,7 @@ static bool test_stream_descriptor_rings_crc64 (fpga_designs_t *const designs, c
     };
 
     fpga_design_t *const design = &designs->designs[design_index];
-    vfio_device_t *const vfio_device = &designs->vfio_devices.devices[design_index];
+    vfio_device_t *const vfio_device = designs->vfio_devices.devices[design_index];
 
     uint64_t running_crc64;
 
@@ -1878,7 +1878,7 @@ static void test_vfio_reset (fpga_designs_t *const designs, const uint32_t desig
 {
     const uint32_t channel_id = 0;
     fpga_design_t *const design = &designs->designs[design_index];
-    vfio_device_t *const vfio_device = &designs->vfio_devices.devices[design_index];
+    vfio_device_t *const vfio_device = designs->vfio_devices.devices[design_index];
     const char *const iteration_names[] =
     {
         "After VFIO open",
@@ -1969,7 +1969,7 @@ int main (int argc, char *argv[])
         {
             if (arg_test_a32_dma_capability)
             {
-                designs.vfio_devices.devices[design_index].dma_capability = VFIO_DEVICE_DMA_CAPABILITY_A32;
+                designs.vfio_devices.devices[design_index]->dma_capability = VFIO_DEVICE_DMA_CAPABILITY_A32;
             }
 
             if (design->dma_bridge_memory_size_bytes > 0)
@@ -0,0 +1,620 @@
+/*
+ * @file test_dma_fault_injection.c
+ * @date 18 Oct 2026
+ * @author Chester Gillon
+ * @brief Test the error detection and recovery paths of the xilinx_dma_bridge_transfers library using fault injection
+ * @details
+ *  For designs with DMA accessible memory, repeatedly:
+ *  1. Performs a loopback transfer of writing a test pattern to card memory and reading it back, to check the DMA works.
+ *  2. Injects one fault into either the H2C or C2H channel using x2x_inject_fault().
+ *  3. Performs loopback transfers until a failure is recorded by the library, reporting the failure message and the latency
+ *     from the fault being applied to the failure being recorded.
+ *  4. Recovers the channels using x2x_recover_transfer_context(), and performs a loopback transfer to check the DMA
+ *     works again, reporting the time taken to recover.
+ *
+ *  Unlike test_dma_descriptor_credits, which was used to investigate the behaviour of the DMA bridge by hand using raw descriptor
+ *  rings, this uses the same library as the other tests so that the error paths can be tested regularly.
+ */
+
+#include "identify_pcie_fpga_design.h"
+#include "xilinx_dma_bridge_transfers.h"
+#include "transfer_timing.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <getopt.h>
+
+
+/* A short transfer timeout, since some of the injected faults are only detected by a timeout */
+#define TRANSFER_TIMEOUT_SECS 1
+
+/* The number of descriptors in each ring, which allows a fault in the next descriptor address to be followed */
+#define NUM_DESCRIPTORS 4
+
+/* The maximum number of loopback transfers performed after injecting a fault, waiting for the failure to be detected.
+ * X2X_FAULT_CORRUPT_NEXT_DESCRIPTOR_ADDRESS is only detected on the transfer after the one the fault was applied to. */
+#define MAX_TRANSFERS_AFTER_FAULT 3
+
+/** Delimiter for comma-separated command line arguments */
+#define DELIMITER ","
+
+
+/* Which channels faults are injected into */
+typedef enum
+{
+    FAULT_DIRECTION_H2C,
+    FAULT_DIRECTION_C2H,
+
+    FAULT_DIRECTION_ARRAY_SIZE
+} fault_direction_t;
+
+static const char *const fault_direction_names[FAULT_DIRECTION_ARRAY_SIZE] =
+{
+    [FAULT_DIRECTION_H2C] = "H2C",
+    [FAULT_DIRECTION_C2H] = "C2H"
+};
+
+
+/* Command line argument which selects which faults are injected */
+static bool arg_enabled_faults[X2X_FAULT_ARRAY_SIZE] =
+{
+    [X2X_FAULT_CORRUPT_DESCRIPTOR_MAGIC] = true,
+    [X2X_FAULT_CORRUPT_NEXT_DESCRIPTOR_ADDRESS] = true,
+    [X2X_FAULT_UNMAPPED_HOST_BUFFER] = true,
+    [X2X_FAULT_DROP_CREDITS] = true,
+    [X2X_FAULT_RESET_DEVICE] = true,
+    [X2X_FAULT_STALL_CONSUMER] = true
+};
+
+
+/* Command line argument which selects which channels faults are injected into */
+static bool arg_enabled_directions[FAULT_DIRECTION_ARRAY_SIZE] = {true, true};
+
+
+/* Command line argument which specifies how many times all enabled scenarios are run */
+static uint32_t arg_num_iterations = 1;
+
+
+/* Command line argument which specifies the size of each loopback transfer */
+static size_t arg_transfer_size_bytes = 0x10000;
+
+
+/* Command line argument which specifies the duration for X2X_FAULT_STALL_CONSUMER */
+static int64_t arg_stall_duration_ns = 100000000;
+
+
+/** The command line options for this program, in the format passed to getopt_long().
+ *  Only long arguments are supported */
+static const struct option command_line_options[] =
+{
+    {"device", required_argument, NULL, 0},
+    {"enabled_faults", required_argument, NULL, 0},
+    {"fault_direction", required_argument, NULL, 0},
+    {"iterations", required_argument, NULL, 0},
+    {"transfer_size", required_argument, NULL, 0},
+    {"stall_duration_ms", required_argument, NULL, 0},
+    {NULL, 0, NULL, 0}
+};
+
+
+/* The context for testing fault injection on one design */
+typedef struct
+{
+    /* Overall success of the DMA transfers, which is cleared when a failure is recorded on either channel */
+    bool transfer_success;
+    vfio_dma_mapping_t descriptors_mapping;
+    vfio_dma_mapping_t h2c_data_mapping;
+    vfio_dma_mapping_t c2h_data_mapping;
+    x2x_transfer_configuration_t h2c_configuration;
+    x2x_transfer_configuration_t c2h_configuration;
+    x2x_transfer_context_t h2c_transfer;
+    x2x_transfer_context_t c2h_transfer;
+    /* The test pattern for the next loopback transfer, which changes for each transfer to detect stale data */
+    uint32_t test_pattern;
+} fault_test_context_t;
+
+
+/* The statistics for one fault scenario over all iterations */
+typedef struct
+{
+    /* The number of times the scenario was run */
+    uint32_t num_runs;
+    /* The number of times the fault couldn't be injected */
+    uint32_t num_skipped;
+    /* The number of times a failure was recorded after the fault was injected */
+    uint32_t num_detected;
+    /* The number of times the DMA was recovered following the fault */
+    uint32_t num_recovered;
+    /* The latency from the fault being applied to the failure being recorded */
+    int64_t min_detection_ns;
+    int64_t max_detection_ns;
+    /* The time taken to recover following the fault */
+    int64_t min_recovery_ns;
+    int64_t max_recovery_ns;
+} fault_scenario_statistics_t;
+
+
+/**
+ * @brief Display the usage for this program, and the exit
+ */
+static void display_usage (void)
+{
+    printf ("Usage:\n");
+    printf ("  test_dma_fault_injection <options>   Test DMA error detection and recovery using fault injection\n");
+    printf ("\n");
+    printf ("--device <domain>:<bus>:<dev>.<func>\n");
+    printf ("  only open using VFIO specific PCI devices in the event that there is one than\n");
+    printf ("  one PCI device which matches the identity filters.\n");
+    printf ("  May be used more than once.\n");
+    printf ("--fault_direction h2c|c2h|both\n");
+    printf ("  Selects which channels faults are injected into\n");
+    printf ("--iterations <num>\n");
+    printf ("  The number of times all enabled fault scenarios are run\n");
+    printf ("--transfer_size <size_bytes>\n");
+    printf ("  The size of each loopback transfer. Must be a multiple of 4 bytes.\n");
+    printf ("--stall_duration_ms <ms>\n");
+    printf ("  The duration the consumer is stalled for the stall_consumer fault\n");
+    printf ("--enabled_faults <comma separated fault names>\n");
+    printf ("  Selects which faults are injected. Possible faults are:\n");
+    for (x2x_fault_t fault = X2X_FAULT_NONE + 1; fault < X2X_FAULT_ARRAY_SIZE; fault++)
+    {
+        printf ("  - %s\n", x2x_fault_names[fault]);
+    }
+
+    exit (EXIT_FAILURE);
+}
+
+
+/**
+ * @brief Parse the command line arguments, storing the results in global variables
+ * @param[in] argc, argv Arguments passed to main
+ */
+static void parse_command_line_arguments (int argc, char *argv[])
+{
+    int opt_status;
+    char junk;
+    int64_t stall_duration_ms;
+
+    do
+    {
+        int option_index = 0;
+
+        opt_status = getopt_long (argc, argv, "", command_line_options, &option_index);
+        if (opt_status == '?')
+        {
+            display_usage ();
+        }
+        else if (opt_status >= 0)
+        {
+            const struct option *const optdef = &command_line_options[option_index];
+
+            if (optdef->flag != NULL)
+            {
+                /* Argument just sets a flag */
+            }
+            else if (strcmp (optdef->name, "device") == 0)
+            {
+                vfio_add_pci_device_location_filter (optarg);
+            }
+            else if (strcmp (optdef->name, "enabled_faults") == 0)
+            {
+                /* Parse the comma delimited fault names, which define which faults to inject */
+                char *const fault_names = strdup (optarg);
+                char *saveptr = NULL;
+                char *token;
+                x2x_fault_t fault;
+                bool fault_name_found;
+
+                for (fault = 0; fault < X2X_FAULT_ARRAY_SIZE; fault++)
+                {
+                    arg_enabled_faults[fault] = false;
+                }
+                token = strtok_r (fault_names, DELIMITER, &saveptr);
+                while (token != NULL)
+                {
+                    fault_name_found = false;
+                    for (fault = X2X_FAULT_NONE + 1; !fault_name_found && (fault < X2X_FAULT_ARRAY_SIZE); fault++)
+                    {
+                        if (strcmp (x2x_fault_names[fault], token) == 0)
+                        {
+                            arg_enabled_faults[fault] = true;
+                            fault_name_found = true;
+                        }
+                    }
+                    if (!fault_name_found)
+                    {
+                        printf ("%s contains unknown fault name %s\n", optdef->name, token);
+                        exit (EXIT_FAILURE);
+                    }
+                    token = strtok_r (NULL, DELIMITER, &saveptr);
+                }
+                free (fault_names);
+            }
+            else if (strcmp (optdef->name, "fault_direction") == 0)
+            {
+                if (strcmp (optarg, "h2c") == 0)
+                {
+                    arg_enabled_directions[FAULT_DIRECTION_H2C] = true;
+                    arg_enabled_directions[FAULT_DIRECTION_C2H] = false;
+                }
+                else if (strcmp (optarg, "c2h") == 0)
+                {
+                    arg_enabled_directions[FAULT_DIRECTION_H2C] = false;
+                    arg_enabled_directions[FAULT_DIRECTION_C2H] = true;
+                }
+                else if (strcmp (optarg, "both") == 0)
+                {
+                    arg_enabled_directions[FAULT_DIRECTION_H2C] = true;
+                    arg_enabled_directions[FAULT_DIRECTION_C2H] = true;
+                }
+                else
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else if (strcmp (optdef->name, "iterations") == 0)
+            {
+                if ((sscanf (optarg, "%" SCNu32 "%c", &arg_num_iterations, &junk) != 1) || (arg_num_iterations == 0))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else if (strcmp (optdef->name, "transfer_size") == 0)
+            {
+                if ((sscanf (optarg, "%zi%c", &arg_transfer_size_bytes, &junk) != 1) || (arg_transfer_size_bytes == 0) ||
+                    ((arg_transfer_size_bytes % sizeof (uint32_t)) != 0) || (arg_transfer_size_bytes > DMA_DESCRIPTOR_MAX_LEN))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else if (strcmp (optdef->name, "stall_duration_ms") == 0)
+            {
+                if ((sscanf (optarg, "%" SCNi64 "%c", &stall_duration_ms, &junk) != 1) || (stall_duration_ms <= 0))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+                arg_stall_duration_ns = stall_duration_ms * 1000000;
+            }
+            else
+            {
+                /* This is a program error, and shouldn't be triggered by the command line options */
+                fprintf (stderr, "Unexpected argument definition %s\n", optdef->name);
+                exit (EXIT_FAILURE);
+            }
+        }
+    } while (opt_status != -1);
+}
+
+
+/**
+ * @brief Wait for a transfer to complete, or a failure to be recorded
+ * @param[in/out] test The test context
+ * @param[in/out] transfer The transfer to wait for
+ */
+static void await_transfer_completion (fault_test_context_t *const test, x2x_transfer_context_t *const transfer)
+{
+    void *completed_buffer;
+
+    do
+    {
+        completed_buffer = x2x_poll_completed_transfer (transfer, NULL, NULL);
+    } while (test->transfer_success && (completed_buffer == NULL));
+}
+
+
+/**
+ * @brief Perform one loopback transfer, of writing a test pattern to card memory and reading back to verify
+ * @param[in/out] test The test context
+ * @return Returns true if the loopback transfer was successful, or false if a failure was recorded
+ */
+static bool perform_loopback_transfer (fault_test_context_t *const test)
+{
+    const size_t num_words = arg_transfer_size_bytes / sizeof (uint32_t);
+    const uint64_t host_buffer_offset = 0;
+    const uint64_t card_buffer_offset = 0;
+    uint32_t *h2c_words;
+    const uint32_t *c2h_words;
+    uint32_t test_pattern;
+
+    /* Write the test pattern to card memory */
+    h2c_words = x2x_populate_memory_transfer (&test->h2c_transfer, arg_transfer_size_bytes, host_buffer_offset, card_buffer_offset);
+    X2X_ASSERT (&test->h2c_transfer, h2c_words != NULL);
+    if (test->transfer_success)
+    {
+        test_pattern = test->test_pattern;
+        for (size_t word_index = 0; word_index < num_words; word_index++)
+        {
+            h2c_words[word_index] = test_pattern;
+            linear_congruential_generator32 (&test_pattern);
+        }
+        x2x_start_populated_descriptors (&test->h2c_transfer);
+        await_transfer_completion (test, &test->h2c_transfer);
+    }
+
+    /* Read back the card memory and verify the test pattern */
+    if (test->transfer_success)
+    {
+        c2h_words = x2x_populate_memory_transfer (&test->c2h_transfer, arg_transfer_size_bytes, host_buffer_offset,
+                card_buffer_offset);
+        X2X_ASSERT (&test->c2h_transfer, c2h_words != NULL);
+        if (test->transfer_success)
+        {
+            x2x_start_populated_descriptors (&test->c2h_transfer);
+            await_transfer_completion (test, &test->c2h_transfer);
+        }
+        test_pattern = test->test_pattern;
+        for (size_t word_index = 0; test->transfer_success && (word_index < num_words); word_index++)
+        {
+            if (c2h_words[word_index] != test_pattern)
+            {
+                x2x_record_failure (&test->c2h_transfer, "word[%zu] actual=0x%" PRIx32 " expected=0x%" PRIx32,
+                        word_index, c2h_words[word_index], test_pattern);
+            }
+            linear_congruential_generator32 (&test_pattern);
+        }
+    }
+
+    /* Use a different pattern for the next transfer */
+    linear_congruential_generator32 (&test->test_pattern);
+
+    return test->transfer_success;
+}
+
+
+/**
+ * @brief Update the minimum and maximum of a time statistic
+ * @param[in] first_sample true when this is the first sample for the statistic
+ * @param[in] sample_ns The sample time
+ * @param[in/out] min_ns, max_ns The statistic to update
+ */
+static void update_time_statistic (const bool first_sample, const int64_t sample_ns, int64_t *const min_ns, int64_t *const max_ns)
+{
+    if (first_sample || (sample_ns < *min_ns))
+    {
+        *min_ns = sample_ns;
+    }
+    if (first_sample || (sample_ns > *max_ns))
+    {
+        *max_ns = sample_ns;
+    }
+}
+
+
+/**
+ * @brief Run one fault scenario, of injecting a fault and then recovering
+ * @param[in/out] test The test context, which must have working transfers on entry
+ * @param[in] fault The fault to inject
+ * @param[in] direction Which channel to inject the fault into
+ * @param[in/out] statistics Updated with the outcome of the scenario
+ * @return Returns true if the scenario passed, meaning the fault was detected when expected and the DMA recovered
+ */
+static bool run_fault_scenario (fault_test_context_t *const test, const x2x_fault_t fault, const fault_direction_t direction,
+                                fault_scenario_statistics_t *const statistics)
+{
+    x2x_transfer_context_t *const faulted_transfer =
+            (direction == FAULT_DIRECTION_H2C) ? &test->h2c_transfer : &test->c2h_transfer;
+    const bool detection_expected = fault != X2X_FAULT_STALL_CONSUMER;
+    const x2x_fault_injection_t *const injection = &faulted_transfer->fault_injection;
+    bool detected;
+    bool recovered;
+    uint32_t num_h2c_lost_transfers = 0;
+    uint32_t num_c2h_lost_transfers = 0;
+
+    printf ("  %s on %s: ", x2x_fault_names[fault], fault_direction_names[direction]);
+    statistics->num_runs++;
+    if (!x2x_inject_fault (faulted_transfer, fault, arg_stall_duration_ns))
+    {
+        printf ("SKIPPED as fault can't be injected\n");
+        statistics->num_skipped++;
+        return true;
+    }
+
+    /* Perform transfers until a failure is recorded */
+    for (uint32_t transfer_index = 0; test->transfer_success && (transfer_index < MAX_TRANSFERS_AFTER_FAULT); transfer_index++)
+    {
+        perform_loopback_transfer (test);
+    }
+    detected = !test->transfer_success;
+    if (detected)
+    {
+        const x2x_transfer_context_t *const failed_transfer =
+                test->h2c_transfer.failed ? &test->h2c_transfer : &test->c2h_transfer;
+        const int64_t detection_ns = (failed_transfer->fault_injection.detected_time_ns > 0) ?
+                (failed_transfer->fault_injection.detected_time_ns - injection->applied_time_ns) :
+                (get_monotonic_time () - injection->applied_time_ns);
+
+        printf ("detected after %.3f ms on %s : %s\n", (double) detection_ns / 1E6,
+                (failed_transfer == &test->h2c_transfer) ? "H2C" : "C2H", failed_transfer->error_message);
+        update_time_statistic (statistics->num_detected == 0, detection_ns,
+                &statistics->min_detection_ns, &statistics->max_detection_ns);
+        statistics->num_detected++;
+    }
+    else
+    {
+        printf ("no failure detected\n");
+    }
+
+    /* Recover the channels, and check a loopback transfer works */
+    const int64_t recovery_start_ns = get_monotonic_time ();
+    recovered = x2x_recover_transfer_context (&test->h2c_transfer, &num_h2c_lost_transfers) &&
+            x2x_recover_transfer_context (&test->c2h_transfer, &num_c2h_lost_transfers);
+    test->transfer_success = recovered;
+    recovered = recovered && perform_loopback_transfer (test);
+    const int64_t recovery_ns = get_monotonic_time () - recovery_start_ns;
+    if (recovered)
+    {
+        printf ("    recovered in %.3f ms, with H2C %" PRIu32 " and C2H %" PRIu32 " lost transfers\n",
+                (double) recovery_ns / 1E6, num_h2c_lost_transfers, num_c2h_lost_transfers);
+        update_time_statistic (statistics->num_recovered == 0, recovery_ns,
+                &statistics->min_recovery_ns, &statistics->max_recovery_ns);
+        statistics->num_recovered++;
+    }
+    else
+    {
+        printf ("    FAILED to recover : H2C %s C2H %s\n", test->h2c_transfer.error_message, test->c2h_transfer.error_message);
+    }
+
+    return recovered && (detected == detection_expected);
+}
+
+
+/**
+ * @brief Run the enabled fault scenarios on one design
+ * @param[in] design The design containing the DMA bridge with DMA accessible memory to test
+ * @return Returns true if all scenarios passed, or false otherwise
+ */
+static bool test_design_fault_injection (const fpga_design_t *const design)
+{
+    fault_test_context_t *const test = calloc (1, sizeof (*test));
+    fault_scenario_statistics_t statistics[X2X_FAULT_ARRAY_SIZE][FAULT_DIRECTION_ARRAY_SIZE] = {0};
+    bool success = true;
+
+    if (test == NULL)
+    {
+        printf ("Failed to allocate fault_test_context_t\n");
+        exit (EXIT_FAILURE);
+    }
+
+    const x2x_transfer_configuration_t h2c_transfer_configuration =
+    {
+        .dma_bridge_memory_base_address = design->dma_bridge_memory_base_address,
+        .dma_bridge_memory_size_bytes = design->dma_bridge_memory_size_bytes,
+        .min_size_alignment = 1, /* The card memory is byte addressable */
+        .num_descriptors = NUM_DESCRIPTORS,
+        .channels_submodule = DMA_SUBMODULE_H2C_CHANNELS,
+        .channel_id = 0,
+        .bytes_per_buffer = 0, /* Length and offsets set before each each transfer */
+        .host_buffer_start_offset = 0,
+        .card_buffer_start_offset = 0,
+        .timeout_seconds = TRANSFER_TIMEOUT_SECS,
+        .vfio_device = design->vfio_device,
+        .bar_index = design->dma_bridge_bar,
+        .descriptors_mapping = &test->descriptors_mapping,
+        .data_mapping = &test->h2c_data_mapping,
+        .overall_success = &test->transfer_success
+    };
+    x2x_transfer_configuration_t c2h_transfer_configuration = h2c_transfer_configuration;
+
+    c2h_transfer_configuration.channels_submodule = DMA_SUBMODULE_C2H_CHANNELS;
+    c2h_transfer_configuration.data_mapping = &test->c2h_data_mapping;
+    test->h2c_configuration = h2c_transfer_configuration;
+    test->c2h_configuration = c2h_transfer_configuration;
+
+    /* Create read/write mapping for DMA descriptors */
+    const size_t descriptors_allocation_size = x2x_get_descriptor_allocation_size (&test->h2c_configuration) +
+            x2x_get_descriptor_allocation_size (&test->c2h_configuration);
+    allocate_vfio_dma_mapping (design->vfio_device, &test->descriptors_mapping, descriptors_allocation_size,
+            VFIO_DMA_MAP_FLAG_READ | VFIO_DMA_MAP_FLAG_WRITE, VFIO_BUFFER_ALLOCATION_HEAP);
+
+    /* Read only mapping used by device for the H2C host buffer */
+    allocate_vfio_dma_mapping (design->vfio_device, &test->h2c_data_mapping, arg_transfer_size_bytes,
+            VFIO_DMA_MAP_FLAG_READ, VFIO_BUFFER_ALLOCATION_HEAP);
+
+    /* Write only mapping used by device for the C2H host buffer */
+    allocate_vfio_dma_mapping (design->vfio_device, &test->c2h_data_mapping, arg_transfer_size_bytes,
+            VFIO_DMA_MAP_FLAG_WRITE, VFIO_BUFFER_ALLOCATION_HEAP);
+
+    if ((test->descriptors_mapping.buffer.vaddr != NULL) &&
+        (test->h2c_data_mapping.buffer.vaddr    != NULL) &&
+        (test->c2h_data_mapping.buffer.vaddr    != NULL))
+    {
+        /* Check the DMA works before injecting any faults */
+        test->transfer_success = true;
+        x2x_initialise_transfer_context (&test->h2c_transfer, &test->h2c_configuration);
+        x2x_initialise_transfer_context (&test->c2h_transfer, &test->c2h_configuration);
+        success = test->transfer_success && perform_loopback_transfer (test);
+        if (!success)
+        {
+            printf ("Loopback transfer failed before injecting faults : H2C %s C2H %s\n",
+                    test->h2c_transfer.error_message, test->c2h_transfer.error_message);
+        }
+
+        for (uint32_t iteration = 0; success && (iteration < arg_num_iterations); iteration++)
+        {
+            printf ("Iteration %" PRIu32 ":\n", iteration + 1);
+            for (x2x_fault_t fault = X2X_FAULT_NONE + 1; success && (fault < X2X_FAULT_ARRAY_SIZE); fault++)
+            {
+                for (fault_direction_t direction = 0; success && (direction < FAULT_DIRECTION_ARRAY_SIZE); direction++)
+                {
+                    if (arg_enabled_faults[fault] && arg_enabled_directions[direction])
+                    {
+                        success = run_fault_scenario (test, fault, direction, &statistics[fault][direction]);
+                    }
+                }
+            }
+        }
+
+        x2x_finalise_transfer_context (&test->h2c_transfer);
+        x2x_finalise_transfer_context (&test->c2h_transfer);
+
+        /* Summarise the scenarios */
+        printf ("\n%-32s  Dir  Runs  Skip  Detect  Recover  Detection min/max (ms)  Recovery min/max (ms)\n", "Fault");
+        for (x2x_fault_t fault = X2X_FAULT_NONE + 1; fault < X2X_FAULT_ARRAY_SIZE; fault++)
+        {
+            for (fault_direction_t direction = 0; direction < FAULT_DIRECTION_ARRAY_SIZE; direction++)
+            {
+                const fault_scenario_statistics_t *const stats = &statistics[fault][direction];
+
+                if (stats->num_runs > 0)
+                {
+                    printf ("%-32s  %s  %4" PRIu32 "  %4" PRIu32 "  %6" PRIu32 "  %7" PRIu32 "  %10.3f/%-10.3f  %10.3f/%-10.3f\n",
+                            x2x_fault_names[fault], fault_direction_names[direction],
+                            stats->num_runs, stats->num_skipped, stats->num_detected, stats->num_recovered,
+                            (double) stats->min_detection_ns / 1E6, (double) stats->max_detection_ns / 1E6,
+                            (double) stats->min_recovery_ns / 1E6, (double) stats->max_recovery_ns / 1E6);
+                }
+            }
+        }
+    }
+    else
+    {
+        printf ("allocate_vfio_dma_mapping() failed\n");
+        success = false;
+    }
+
+    free_vfio_dma_mapping (&test->c2h_data_mapping);
+    free_vfio_dma_mapping (&test->h2c_data_mapping);
+    free_vfio_dma_mapping (&test->descriptors_mapping);
+    free (test);
+
+    return success;
+}
+
+
+int main (int argc, char *argv[])
+{
+    fpga_designs_t designs;
+    bool overall_success = true;
+
+    parse_command_line_arguments (argc, argv);
+
+    /* Open the FPGA designs which have an IOMMU group assigned */
+    identify_pcie_fpga_designs (&designs);
+
+    /* Process any FPGA designs which have a DMA bridge with DMA accessible memory */
+    for (uint32_t design_index = 0; design_index < designs.num_identified_designs; design_index++)
+    {
+        const fpga_design_t *const design = &designs.designs[design_index];
+
+        if (design->dma_bridge_present && (design->dma_bridge_memory_size_bytes >= arg_transfer_size_bytes))
+        {
+            printf ("\nTesting fault injection on %s design PCI device %s IOMMU group %s\n",
+                    fpga_design_names[design->design_id], design->vfio_device->device_name,
+                    design->vfio_device->group->iommu_group_name);
+            overall_success = test_design_fault_injection (design) && overall_success;
+        }
+    }
+
+    close_pcie_fpga_designs (&designs);
+
+    printf ("\nOverall %s\n", overall_success ? "PASS" : "FAIL");
+
+    return overall_success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
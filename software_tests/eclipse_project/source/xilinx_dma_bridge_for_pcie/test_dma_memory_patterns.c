@@ -0,0 +1,431 @@
+/*
+ * @file test_dma_memory_patterns.c
+ * @date 18 Oct 2026
+ * @author Chester Gillon
+ * @brief Test DMA accessible memory using classic memory test patterns
+ * @details
+ *  Complements:
+ *  a. test_dma_bridge which tests the memory with a pseudo-random pattern.
+ *  b. test_dma_bridge_memory_addressing which looks for aliasing of power-of-two addresses.
+ *
+ *  Uses the dma_memory_test library to run walking ones/zeros, address-in-address, moving inversions and checkerboard tests
+ *  over all of the DMA accessible memory, reporting any failing data and address bits. A row-hammer test is run when the
+ *  aggressor addresses are specified on the command line.
+ */
+
+#include "identify_pcie_fpga_design.h"
+#include "dma_memory_test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <getopt.h>
+
+
+/** Delimiter for comma-separated command line arguments */
+#define DELIMITER ","
+
+
+/* Command line argument used to enable which tests to perform.
+ * The row-hammer test is enabled when aggressor addresses are specified. */
+static bool arg_enabled_tests[DMA_MEMORY_TEST_ARRAY_SIZE] =
+{
+    [DMA_MEMORY_TEST_WALKING_ONES] = true,
+    [DMA_MEMORY_TEST_WALKING_ZEROS] = true,
+    [DMA_MEMORY_TEST_ADDRESS_IN_ADDRESS] = true,
+    [DMA_MEMORY_TEST_MOVING_INVERSIONS] = true,
+    [DMA_MEMORY_TEST_CHECKERBOARD] = true
+};
+static bool arg_enabled_tests_specified;
+
+
+/* Command line argument which sets the size of each chunk of card memory transferred */
+static size_t arg_chunk_size_bytes = 0x1000000;
+
+
+/* Command line argument which sets the VFIO buffer allocation type */
+static vfio_buffer_allocation_type_t arg_buffer_allocation = VFIO_BUFFER_ALLOCATION_HEAP;
+
+
+/* Command line arguments for the row-hammer test */
+static uint32_t arg_num_row_hammer_aggressors;
+static uint64_t arg_row_hammer_aggressor_offsets[DMA_MEMORY_TEST_MAX_AGGRESSORS];
+static uint64_t arg_row_hammer_num_activations = 1000000;
+
+
+/* Command line arguments for overriding the definition of DMA accessible memory for the design */
+static size_t arg_dma_bridge_memory_base_address;
+static bool arg_dma_bridge_memory_base_address_specified;
+static size_t arg_dma_bridge_memory_size_bytes;
+static bool arg_dma_bridge_memory_size_bytes_specified;
+
+
+/** The command line options for this program, in the format passed to getopt_long().
+ *  Only long arguments are supported */
+static const struct option command_line_options[] =
+{
+    {"device", required_argument, NULL, 0},
+    {"enabled_tests", required_argument, NULL, 0},
+    {"chunk_size", required_argument, NULL, 0},
+    {"buffer_allocation", required_argument, NULL, 0},
+    {"prefault_threads", required_argument, NULL, 0},
+    {"row_hammer_aggressors", required_argument, NULL, 0},
+    {"row_hammer_activations", required_argument, NULL, 0},
+    {"dma_bridge_memory_base_address", required_argument, NULL, 0},
+    {"dma_bridge_memory_size_bytes", required_argument, NULL, 0},
+    {NULL, 0, NULL, 0}
+};
+
+
+/**
+ * @brief Display the usage for this program, and the exit
+ */
+static void display_usage (void)
+{
+    printf ("Usage:\n");
+    printf ("  test_dma_memory_patterns <options>   Test Xilinx DMA accessible memory with classic patterns\n");
+    printf ("\n");
+    printf ("--device <domain>:<bus>:<dev>.<func>\n");
+    printf ("  only open using VFIO specific PCI devices in the event that there is one than\n");
+    printf ("  one PCI device which matches the identity filters.\n");
+    printf ("  May be used more than once.\n");
+    printf ("--chunk_size <size_bytes>\n");
+    printf ("  Specifies the size of each DMA transfer. Must be a multiple of 8 bytes.\n");
+    printf ("--buffer_allocation heap|shared_memory|huge_pages|huge_pages_2M|huge_pages_1G\n");
+    printf ("  Selects the VFIO buffer allocation type\n");
+    printf ("--prefault_threads <num>\n");
+    printf ("  The number of threads used to zero, and therefore pre-fault, the VFIO buffers before they are mapped\n");
+    printf ("--row_hammer_aggressors <offset>[,<offset>...]\n");
+    printf ("  Specifies the offsets in card memory of the aggressor addresses for the\n");
+    printf ("  row_hammer test, which are read in turn. Enables the row_hammer test.\n");
+    printf ("--row_hammer_activations <num>\n");
+    printf ("  Specifies the number of reads of each aggressor address for the row_hammer test\n");
+    printf ("--dma_bridge_memory_base_address <address>\n");
+    printf ("  Overrides the dma_bridge_memory_base_address specified for the design.\n");
+    printf ("  To either reduce the memory tested, or investigate accessing non-existent memory\n");
+    printf ("--dma_bridge_memory_size_bytes <size>\n");
+    printf ("  Overrides the dma_bridge_memory_size_bytes specified for the design.\n");
+    printf ("--enabled_tests <comma separated test names>\n");
+    printf ("  Selects which tests are enabled. Possible tests are:\n");
+    for (dma_memory_test_t test = 0; test < DMA_MEMORY_TEST_ARRAY_SIZE; test++)
+    {
+        printf ("  - %s\n", dma_memory_test_names[test]);
+    }
+
+    exit (EXIT_FAILURE);
+}
+
+
+/**
+ * @brief Parse the command line arguments, storing the results in global variables
+ * @param[in] argc, argv Arguments passed to main
+ */
+static void parse_command_line_arguments (int argc, char *argv[])
+{
+    int opt_status;
+    char junk;
+
+    do
+    {
+        int option_index = 0;
+
+        opt_status = getopt_long (argc, argv, "", command_line_options, &option_index);
+        if (opt_status == '?')
+        {
+            display_usage ();
+        }
+        else if (opt_status >= 0)
+        {
+            const struct option *const optdef = &command_line_options[option_index];
+
+            if (optdef->flag != NULL)
+            {
+                /* Argument just sets a flag */
+            }
+            else if (strcmp (optdef->name, "device") == 0)
+            {
+                vfio_add_pci_device_location_filter (optarg);
+            }
+            else if (strcmp (optdef->name, "enabled_tests") == 0)
+            {
+                /* Parse the comma delimited test names, which define which tests to enable */
+                char *const test_names = strdup (optarg);
+                char *saveptr = NULL;
+                char *token;
+                dma_memory_test_t test;
+                bool test_name_found;
+
+                for (test = 0; test < DMA_MEMORY_TEST_ARRAY_SIZE; test++)
+                {
+                    arg_enabled_tests[test] = false;
+                }
+                token = strtok_r (test_names, DELIMITER, &saveptr);
+                while (token != NULL)
+                {
+                    test_name_found = false;
+                    for (test = 0; !test_name_found && (test < DMA_MEMORY_TEST_ARRAY_SIZE); test++)
+                    {
+                        if (strcmp (dma_memory_test_names[test], token) == 0)
+                        {
+                            arg_enabled_tests[test] = true;
+                            test_name_found = true;
+                        }
+                    }
+                    if (!test_name_found)
+                    {
+                        printf ("%s contains unknown test name %s\n", optdef->name, token);
+                        exit (EXIT_FAILURE);
+                    }
+                    token = strtok_r (NULL, DELIMITER, &saveptr);
+                }
+                free (test_names);
+                arg_enabled_tests_specified = true;
+            }
+            else if (strcmp (optdef->name, "chunk_size") == 0)
+            {
+                if ((sscanf (optarg, "%zi%c", &arg_chunk_size_bytes, &junk) != 1) ||
+                    (arg_chunk_size_bytes < DMA_MEMORY_TEST_MIN_CHUNK_SIZE_BYTES) || ((arg_chunk_size_bytes % sizeof (uint64_t)) != 0))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else if (strcmp (optdef->name, "prefault_threads") == 0)
+            {
+                uint32_t prefault_threads;
+
+                if ((sscanf (optarg, "%" SCNu32 "%c", &prefault_threads, &junk) != 1) || (prefault_threads == 0))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+                vfio_set_buffer_prefault_threads (prefault_threads);
+            }
+            else if (strcmp (optdef->name, "buffer_allocation") == 0)
+            {
+                if (strcmp (optarg, "heap") == 0)
+                {
+                    arg_buffer_allocation = VFIO_BUFFER_ALLOCATION_HEAP;
+                }
+                else if (strcmp (optarg, "shared_memory") == 0)
+                {
+                    arg_buffer_allocation = VFIO_BUFFER_ALLOCATION_SHARED_MEMORY;
+                }
+                else if (strcmp (optarg, "huge_pages") == 0)
+                {
+                    arg_buffer_allocation = VFIO_BUFFER_ALLOCATION_HUGE_PAGES;
+                }
+                else if (strcmp (optarg, "huge_pages_2M") == 0)
+                {
+                    arg_buffer_allocation = VFIO_BUFFER_ALLOCATION_HUGE_PAGES_2M;
+                }
+                else if (strcmp (optarg, "huge_pages_1G") == 0)
+                {
+                    arg_buffer_allocation = VFIO_BUFFER_ALLOCATION_HUGE_PAGES_1G;
+                }
+                else
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else if (strcmp (optdef->name, "row_hammer_aggressors") == 0)
+            {
+                /* Parse the comma delimited aggressor offsets */
+                char *const offsets = strdup (optarg);
+                char *saveptr = NULL;
+                char *token;
+
+                arg_num_row_hammer_aggressors = 0;
+                token = strtok_r (offsets, DELIMITER, &saveptr);
+                while (token != NULL)
+                {
+                    if ((arg_num_row_hammer_aggressors == DMA_MEMORY_TEST_MAX_AGGRESSORS) ||
+                        (sscanf (token, "%" SCNi64 "%c", &arg_row_hammer_aggressor_offsets[arg_num_row_hammer_aggressors], &junk) != 1))
+                    {
+                        printf ("Invalid %s %s\n", optdef->name, optarg);
+                        exit (EXIT_FAILURE);
+                    }
+                    arg_num_row_hammer_aggressors++;
+                    token = strtok_r (NULL, DELIMITER, &saveptr);
+                }
+                free (offsets);
+            }
+            else if (strcmp (optdef->name, "row_hammer_activations") == 0)
+            {
+                if ((sscanf (optarg, "%" SCNi64 "%c", &arg_row_hammer_num_activations, &junk) != 1) ||
+                    (arg_row_hammer_num_activations == 0))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else if (strcmp (optdef->name, "dma_bridge_memory_base_address") == 0)
+            {
+                if (sscanf (optarg, "%zi%c", &arg_dma_bridge_memory_base_address, &junk) != 1)
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+                arg_dma_bridge_memory_base_address_specified = true;
+            }
+            else if (strcmp (optdef->name, "dma_bridge_memory_size_bytes") == 0)
+            {
+                if ((sscanf (optarg, "%zi%c", &arg_dma_bridge_memory_size_bytes, &junk) != 1) ||
+                    (arg_dma_bridge_memory_size_bytes == 0))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+                arg_dma_bridge_memory_size_bytes_specified = true;
+            }
+            else
+            {
+                /* This is a program error, and shouldn't be triggered by the command line options */
+                fprintf (stderr, "Unexpected argument definition %s\n", optdef->name);
+                exit (EXIT_FAILURE);
+            }
+        }
+    } while (opt_status != -1);
+
+    if (!arg_enabled_tests_specified && (arg_num_row_hammer_aggressors > 0))
+    {
+        arg_enabled_tests[DMA_MEMORY_TEST_ROW_HAMMER] = true;
+    }
+}
+
+
+/**
+ * @brief Process optional command line options which allow overriding the rage of DMA accessible memory tested.
+ * @details
+ *   Called before any tests on the design. The only modification prevented, via the command line option validation,
+ *   is zeroing the dma_bridge_memory_size_bytes. Since zeroing that would indicate the design uses streams.
+ * @param[in/out] design The design, which might have its DMA accessible memory definition tested
+ */
+static void allow_override_of_dma_accessible_memory_tested (fpga_design_t *const design)
+{
+    const size_t original_dma_bridge_memory_base_address = design->dma_bridge_memory_base_address;
+    const size_t original_dma_bridge_memory_size_bytes = design->dma_bridge_memory_size_bytes;
+    const size_t original_end_address = original_dma_bridge_memory_base_address + original_dma_bridge_memory_size_bytes - 1;
+
+    if (arg_dma_bridge_memory_base_address_specified &&
+            (arg_dma_bridge_memory_base_address != original_dma_bridge_memory_base_address))
+    {
+        design->dma_bridge_memory_base_address = arg_dma_bridge_memory_base_address;
+        printf ("Overriding dma_bridge_memory_base_address 0x%zx -> 0x%zx\n",
+                original_dma_bridge_memory_base_address, design->dma_bridge_memory_base_address);
+    }
+
+    if (arg_dma_bridge_memory_size_bytes_specified &&
+            (arg_dma_bridge_memory_size_bytes != original_dma_bridge_memory_size_bytes))
+    {
+        design->dma_bridge_memory_size_bytes = arg_dma_bridge_memory_size_bytes;
+        printf ("Overriding dma_bridge_memory_size_bytes 0x%zx -> 0x%zx\n",
+                original_dma_bridge_memory_size_bytes, design->dma_bridge_memory_size_bytes);
+    }
+
+    const size_t new_end_address = design->dma_bridge_memory_base_address + design->dma_bridge_memory_size_bytes - 1;
+    if ((design->dma_bridge_memory_base_address < original_dma_bridge_memory_base_address) ||
+        (new_end_address > original_end_address))
+    {
+        printf ("Warning: Overridden DMA accessible memory is outside of that specified for the design.\n");
+        printf ("         Tests are expected to fail.\n");
+    }
+}
+
+
+/**
+ * @brief Run the enabled memory tests on one design
+ * @param[in] design The design containing the DMA bridge with DMA accessible memory to test
+ * @return Returns true if all enabled tests passed, or false otherwise
+ */
+static bool test_design_memory (const fpga_design_t *const design)
+{
+    dma_memory_test_configuration_t configuration =
+    {
+        .vfio_device = design->vfio_device,
+        .bar_index = design->dma_bridge_bar,
+        .memory_base_address = design->dma_bridge_memory_base_address,
+        .memory_size_bytes = design->dma_bridge_memory_size_bytes,
+        /* Since as focused of testing the memory, just use fixed channels */
+        .h2c_channel_id = 0,
+        .c2h_channel_id = 0,
+        .chunk_size_bytes = (arg_chunk_size_bytes < design->dma_bridge_memory_size_bytes) ?
+                arg_chunk_size_bytes : (design->dma_bridge_memory_size_bytes & ~(sizeof (uint64_t) - 1)),
+        .buffer_allocation = arg_buffer_allocation,
+        .num_row_hammer_aggressors = arg_num_row_hammer_aggressors,
+        .row_hammer_num_activations = arg_row_hammer_num_activations
+    };
+    dma_memory_test_context_t *const context = calloc (1, sizeof (*context));
+    bool success;
+
+    memcpy (configuration.row_hammer_aggressor_offsets, arg_row_hammer_aggressor_offsets,
+            sizeof (configuration.row_hammer_aggressor_offsets));
+    if (context == NULL)
+    {
+        printf ("Failed to allocate dma_memory_test_context_t\n");
+        exit (EXIT_FAILURE);
+    }
+
+    success = dma_memory_test_initialise (context, &configuration);
+    if (success)
+    {
+        printf ("Testing %zu chunks of 0x%zx bytes\n", context->num_chunks, configuration.chunk_size_bytes);
+        for (dma_memory_test_t test = 0; test < DMA_MEMORY_TEST_ARRAY_SIZE; test++)
+        {
+            if (arg_enabled_tests[test])
+            {
+                const bool test_success = dma_memory_test_run (context, test);
+
+                dma_memory_test_display_results (context, test);
+                success = success && test_success;
+            }
+        }
+        dma_memory_test_finalise (context);
+    }
+
+    free (context);
+
+    return success;
+}
+
+
+int main (int argc, char *argv[])
+{
+    fpga_designs_t designs;
+    bool overall_success = true;
+
+    parse_command_line_arguments (argc, argv);
+
+    /* Open the FPGA designs which have an IOMMU group assigned */
+    identify_pcie_fpga_designs (&designs);
+
+    /* Process any FPGA designs which have a DMA bridge with DMA accessible memory */
+    for (uint32_t design_index = 0; design_index < designs.num_identified_designs; design_index++)
+    {
+        fpga_design_t *const design = &designs.designs[design_index];
+
+        if (design->dma_bridge_present && (design->dma_bridge_memory_size_bytes > 0))
+        {
+            allow_override_of_dma_accessible_memory_tested (design);
+            printf ("\nTesting %s design", fpga_design_names[design->design_id]);
+            if ((design->design_id == FPGA_DESIGN_LITEFURY_PROJECT0) || (design->design_id == FPGA_DESIGN_NITEFURY_PROJECT0))
+            {
+                printf (" version 0x%x", design->board_version);
+            }
+            printf (" with memory base address 0x%zx size 0x%zx\n",
+                    design->dma_bridge_memory_base_address, design->dma_bridge_memory_size_bytes);
+            printf ("PCI device %s IOMMU group %s\n", design->vfio_device->device_name,
+                    design->vfio_device->group->iommu_group_name);
+            overall_success = test_design_memory (design) && overall_success;
+        }
+    }
+
+    close_pcie_fpga_designs (&designs);
+
+    printf ("\nOverall %s\n", overall_success ? "PASS" : "FAIL");
+
+    return overall_success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,610 @@
+/*
+ * @file test_dma_peer_to_peer.c
+ * @date 18 Oct 2026
+ * @author Chester Gillon
+ * @brief Measure the throughput of card-to-card DMA transfers, compared to bouncing the data through host memory
+ * @details
+ *   The initiator is a design with a DMA/Bridge Subsystem with DMA accessible memory. The peer is a memory BAR of another
+ *   device, which is mapped into the IOMMU container by allocate_vfio_peer_bar_dma_mapping() so that the DMA engine in the
+ *   initiator can address the peer BAR directly. The peer device must be one of the devices opened by
+ *   identify_pcie_fpga_designs(), so that it is in the same IOMMU container as the initiator.
+ *
+ *   For each direction the throughput is measured for:
+ *   a. Direct, where the initiator DMA transfers between its card memory and the peer BAR.
+ *   b. Host bounce, where the initiator DMA transfers between its card memory and a host buffer, and the CPU copies
+ *      between the host buffer and the peer BAR.
+ *   The contents transferred are checked after each measurement.
+ *
+ *   If no peer is specified a simulated pair is used where the peer BAR is replaced by a host buffer. This allows the test
+ *   to be run with a single card, but the results don't then characterise peer-to-peer routing in the PCIe topology.
+ *   If a peer is specified but peer-to-peer DMA isn't possible (e.g. NOIOMMU mode or the peer BAR can't be mapped for DMA)
+ *   the test fails, rather than falling back to a simulated pair which wouldn't test what was requested.
+ */
+
+#include "identify_pcie_fpga_design.h"
+#include "xilinx_dma_bridge_transfers.h"
+#include "transfer_timing.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <getopt.h>
+
+
+/* Use a single fixed transfer timeout, to stop the test from hanging */
+#define TRANSFER_TIMEOUT_SECS 5
+
+
+/* The different paths which data can take between the initiator card memory and the peer */
+typedef enum
+{
+    /* The initiator DMA directly accesses the peer */
+    TRANSFER_PATH_DIRECT,
+    /* The initiator DMA accesses a host buffer, and the CPU copies between the host buffer and the peer */
+    TRANSFER_PATH_HOST_BOUNCE,
+
+    TRANSFER_PATH_ARRAY_SIZE
+} transfer_path_t;
+
+static const char *const transfer_path_names[TRANSFER_PATH_ARRAY_SIZE] =
+{
+    [TRANSFER_PATH_DIRECT     ] = "direct",
+    [TRANSFER_PATH_HOST_BOUNCE] = "host bounce"
+};
+
+
+/* The context for the peer-to-peer test */
+typedef struct
+{
+    /* The design which performs the DMA transfers */
+    fpga_design_t *initiator;
+    /* The size of each transfer */
+    size_t transfer_size_bytes;
+    /* The offset in the initiator card memory which is the source for card-to-peer transfers */
+    uint64_t card_source_offset;
+    /* The offset in the initiator card memory which is the destination for peer-to-card transfers */
+    uint64_t card_destination_offset;
+    /* Host buffer used to bounce data, and to fill and read back the initiator card memory */
+    vfio_dma_mapping_t host_mapping;
+    /* Either the peer BAR, or a host buffer for a simulated pair */
+    vfio_dma_mapping_t peer_mapping;
+    /* When true peer_mapping is a host buffer for a simulated pair */
+    bool simulated_peer;
+    /* The offset in peer_mapping used for the transfers */
+    uint64_t peer_offset;
+    /* The expected contents of the transfers */
+    uint8_t *pattern;
+    /* Overall success for DMA transfers. Once a DMA transfer fails the test is aborted. */
+    bool transfer_success;
+    /* Overall success for the contents of the transfers */
+    bool content_success;
+} peer_to_peer_test_context_t;
+
+
+/* Command line argument which specifies the peer device */
+static const char *arg_peer_device;
+
+
+/* Command line argument which specifies the BAR of the peer device which is the target of the DMA */
+static uint32_t arg_peer_bar;
+
+
+/* Command line argument which specifies the offset in the peer BAR used for the transfers */
+static uint64_t arg_peer_offset;
+
+
+/* Command line argument which specifies the size of each transfer */
+static size_t arg_transfer_size_bytes = 0x100000;
+
+
+/* Command line argument which specifies the duration of each throughput measurement */
+static double arg_duration_secs = 2.0;
+
+
+/** The command line options for this program, in the format passed to getopt_long().
+ *  Only long arguments are supported */
+static const struct option command_line_options[] =
+{
+    {"device", required_argument, NULL, 0},
+    {"peer_device", required_argument, NULL, 0},
+    {"peer_bar", required_argument, NULL, 0},
+    {"peer_offset", required_argument, NULL, 0},
+    {"transfer_size", required_argument, NULL, 0},
+    {"duration_secs", required_argument, NULL, 0},
+    {NULL, 0, NULL, 0}
+};
+
+
+/**
+ * @brief Display the usage for this program, and the exit
+ */
+static void display_usage (void)
+{
+    printf ("Usage:\n");
+    printf ("  test_dma_peer_to_peer <options>   Measure card-to-card DMA throughput\n");
+    printf ("\n");
+    printf ("--device <domain>:<bus>:<dev>.<func>\n");
+    printf ("  only open using VFIO specific PCI devices in the event that there is one than\n");
+    printf ("  one PCI device which matches the identity filters.\n");
+    printf ("  May be used more than once, and if used must also specify the peer device.\n");
+    printf ("--peer_device <domain>:<bus>:<dev>.<func>\n");
+    printf ("  The device which contains the BAR which is the target of the DMA.\n");
+    printf ("  If not specified uses a simulated peer in host memory. If specified the test\n");
+    printf ("  fails if peer-to-peer DMA to the device isn't possible.\n");
+    printf ("--peer_bar <bar_index>\n");
+    printf ("  The memory BAR of the peer device. Default %" PRIu32 "\n", arg_peer_bar);
+    printf ("--peer_offset <offset>\n");
+    printf ("  The offset in the peer BAR used for the transfers. Default 0x%" PRIx64 "\n", arg_peer_offset);
+    printf ("--transfer_size <size_bytes>\n");
+    printf ("  The size of each transfer. Default 0x%zx\n", arg_transfer_size_bytes);
+    printf ("--duration_secs <secs>\n");
+    printf ("  The duration of each throughput measurement. Default %.1f\n", arg_duration_secs);
+
+    exit (EXIT_FAILURE);
+}
+
+
+/**
+ * @brief Parse the command line arguments, storing the results in global variables
+ * @param[in] argc, argv Arguments passed to main
+ */
+static void parse_command_line_arguments (int argc, char *argv[])
+{
+    int opt_status;
+    char junk;
+
+    do
+    {
+        int option_index = 0;
+
+        opt_status = getopt_long (argc, argv, "", command_line_options, &option_index);
+        if (opt_status == '?')
+        {
+            display_usage ();
+        }
+        else if (opt_status >= 0)
+        {
+            const struct option *const optdef = &command_line_options[option_index];
+
+            if (optdef->flag != NULL)
+            {
+                /* Argument just sets a flag */
+            }
+            else if (strcmp (optdef->name, "device") == 0)
+            {
+                vfio_add_pci_device_location_filter (optarg);
+            }
+            else if (strcmp (optdef->name, "peer_device") == 0)
+            {
+                arg_peer_device = optarg;
+            }
+            else if (strcmp (optdef->name, "peer_bar") == 0)
+            {
+                if ((sscanf (optarg, "%" SCNu32 "%c", &arg_peer_bar, &junk) != 1) || (arg_peer_bar >= PCI_STD_NUM_BARS))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else if (strcmp (optdef->name, "peer_offset") == 0)
+            {
+                if (sscanf (optarg, "%" SCNi64 "%c", &arg_peer_offset, &junk) != 1)
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else if (strcmp (optdef->name, "transfer_size") == 0)
+            {
+                if ((sscanf (optarg, "%zi%c", &arg_transfer_size_bytes, &junk) != 1) || (arg_transfer_size_bytes == 0))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else if (strcmp (optdef->name, "duration_secs") == 0)
+            {
+                if ((sscanf (optarg, "%lf%c", &arg_duration_secs, &junk) != 1) || (arg_duration_secs < 0.0))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else
+            {
+                /* This is a program error, and shouldn't be triggered by the command line options */
+                fprintf (stderr, "Unexpected argument definition %s\n", optdef->name);
+                exit (EXIT_FAILURE);
+            }
+        }
+    } while (opt_status != -1);
+}
+
+
+/**
+ * @brief Perform repeated DMA transfers of the same data for a duration
+ * @param[in/out] test The test context
+ * @param[in] channels_submodule Identifies the direction of the DMA transfers
+ * @param[in] data_mapping The "host" side of the DMA transfers, which may be the peer
+ * @param[in] host_offset The offset in data_mapping for the transfers
+ * @param[in] card_offset The offset in the initiator card memory for the transfers
+ * @param[in] bounce_via_peer When true the CPU copies between the host buffer and the peer for each transfer
+ * @param[in] duration_ns The duration to perform transfers for. Zero performs a single transfer.
+ * @param[out] num_transfers The number of transfers performed
+ * @param[out] elapsed_ns The elapsed time for the transfers, including any CPU copies
+ * @return Returns true if the transfers were successful
+ */
+static bool perform_transfers (peer_to_peer_test_context_t *const test, const uint32_t channels_submodule,
+                               const vfio_dma_mapping_t *const data_mapping, const uint64_t host_offset,
+                               const uint64_t card_offset, const bool bounce_via_peer, const int64_t duration_ns,
+                               uint64_t *const num_transfers, int64_t *const elapsed_ns)
+{
+    fpga_design_t *const design = test->initiator;
+    uint8_t *const peer_bytes = test->peer_mapping.buffer.vaddr;
+    uint8_t *const host_bytes = test->host_mapping.buffer.vaddr;
+    vfio_dma_mapping_t descriptors_mapping;
+    x2x_transfer_context_t transfer;
+    const x2x_transfer_configuration_t configuration =
+    {
+        .dma_bridge_memory_base_address = design->dma_bridge_memory_base_address,
+        .dma_bridge_memory_size_bytes = design->dma_bridge_memory_size_bytes,
+        .min_size_alignment = 1, /* The card memory is byte addressable */
+        .num_descriptors = x2x_num_descriptors_for_transfer_len (test->transfer_size_bytes),
+        .channels_submodule = channels_submodule,
+        .channel_id = 0,
+        .bytes_per_buffer = 0, /* Length and offsets set before each each transfer */
+        .host_buffer_start_offset = 0,
+        .card_buffer_start_offset = 0,
+        .timeout_seconds = TRANSFER_TIMEOUT_SECS,
+        .vfio_device = design->vfio_device,
+        .bar_index = design->dma_bridge_bar,
+        .descriptors_mapping = &descriptors_mapping,
+        .data_mapping = data_mapping,
+        .overall_success = &test->transfer_success
+    };
+
+    *num_transfers = 0;
+    *elapsed_ns = 0;
+    allocate_vfio_dma_mapping (design->vfio_device, &descriptors_mapping, x2x_get_descriptor_allocation_size (&configuration),
+            VFIO_DMA_MAP_FLAG_READ | VFIO_DMA_MAP_FLAG_WRITE, VFIO_BUFFER_ALLOCATION_HEAP);
+    if (descriptors_mapping.buffer.vaddr == NULL)
+    {
+        test->transfer_success = false;
+        return false;
+    }
+
+    x2x_initialise_transfer_context (&transfer, &configuration);
+    const int64_t start_time = get_monotonic_time ();
+    int64_t now;
+    do
+    {
+        if (bounce_via_peer && (channels_submodule == DMA_SUBMODULE_H2C_CHANNELS))
+        {
+            memcpy (&host_bytes[host_offset], &peer_bytes[test->peer_offset], test->transfer_size_bytes);
+        }
+
+        const void *const host_buffer =
+                x2x_populate_memory_transfer (&transfer, test->transfer_size_bytes, host_offset, card_offset);
+        X2X_ASSERT (&transfer, host_buffer != NULL);
+        if (host_buffer != NULL)
+        {
+            x2x_start_populated_descriptors (&transfer);
+            while (test->transfer_success && (x2x_poll_completed_transfer (&transfer, NULL, NULL) == NULL))
+            {
+            }
+        }
+
+        if (test->transfer_success)
+        {
+            if (bounce_via_peer && (channels_submodule == DMA_SUBMODULE_C2H_CHANNELS))
+            {
+                memcpy (&peer_bytes[test->peer_offset], &host_bytes[host_offset], test->transfer_size_bytes);
+            }
+            (*num_transfers)++;
+        }
+        now = get_monotonic_time ();
+    } while (test->transfer_success && ((now - start_time) < duration_ns));
+    *elapsed_ns = now - start_time;
+
+    if (!test->transfer_success)
+    {
+        printf ("DMA transfer failed : %s\n", transfer.error_message);
+    }
+    x2x_finalise_transfer_context (&transfer);
+    free_vfio_dma_mapping (&descriptors_mapping);
+
+    return test->transfer_success;
+}
+
+
+/**
+ * @brief Check that a transferred region has the expected pattern
+ * @param[in/out] test The test context, where content_success is cleared on a mismatch
+ * @param[in] actual The transferred region
+ * @param[in] description Describes the region for reporting a mismatch
+ * @return Returns true if the region has the expected pattern
+ */
+static bool check_pattern (peer_to_peer_test_context_t *const test, const uint8_t *const actual,
+                           const char *const description)
+{
+    for (size_t byte_index = 0; byte_index < test->transfer_size_bytes; byte_index++)
+    {
+        if (actual[byte_index] != test->pattern[byte_index])
+        {
+            printf ("%s mismatch at offset 0x%zx : expected 0x%02x actual 0x%02x\n",
+                    description, byte_index, test->pattern[byte_index], actual[byte_index]);
+            test->content_success = false;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Measure the throughput of one direction and path, checking the transferred contents afterwards
+ * @details The destination is cleared before the measurement, so that the check detects if no data was transferred.
+ * @param[in/out] test The test context
+ * @param[in] card_to_peer Selects the direction of the data
+ * @param[in] path Selects the path of the data
+ */
+static void measure_path (peer_to_peer_test_context_t *const test, const bool card_to_peer, const transfer_path_t path)
+{
+    const int64_t duration_ns = (int64_t) (arg_duration_secs * 1E9);
+    const uint32_t channels_submodule = card_to_peer ? DMA_SUBMODULE_C2H_CHANNELS : DMA_SUBMODULE_H2C_CHANNELS;
+    const uint64_t card_offset = card_to_peer ? test->card_source_offset : test->card_destination_offset;
+    uint8_t *const peer_bytes = test->peer_mapping.buffer.vaddr;
+    uint8_t *const host_bytes = test->host_mapping.buffer.vaddr;
+    uint64_t num_transfers = 0;
+    int64_t elapsed_ns = 0;
+    uint64_t unused_num_transfers;
+    int64_t unused_elapsed_ns;
+    bool contents_ok = false;
+
+    if (!test->transfer_success)
+    {
+        return;
+    }
+
+    /* Clear the destination */
+    if (card_to_peer)
+    {
+        memset (&peer_bytes[test->peer_offset], 0, test->transfer_size_bytes);
+    }
+    else
+    {
+        memset (host_bytes, 0, test->transfer_size_bytes);
+        (void) perform_transfers (test, DMA_SUBMODULE_H2C_CHANNELS, &test->host_mapping, 0, card_offset, false, 0,
+                &unused_num_transfers, &unused_elapsed_ns);
+    }
+
+    /* Perform the measurement */
+    if (path == TRANSFER_PATH_DIRECT)
+    {
+        (void) perform_transfers (test, channels_submodule, &test->peer_mapping, test->peer_offset, card_offset, false,
+                duration_ns, &num_transfers, &elapsed_ns);
+    }
+    else
+    {
+        (void) perform_transfers (test, channels_submodule, &test->host_mapping, 0, card_offset, true,
+                duration_ns, &num_transfers, &elapsed_ns);
+    }
+
+    /* Check the destination contents */
+    if (test->transfer_success)
+    {
+        if (card_to_peer)
+        {
+            contents_ok = check_pattern (test, &peer_bytes[test->peer_offset], "Peer");
+        }
+        else if (perform_transfers (test, DMA_SUBMODULE_C2H_CHANNELS, &test->host_mapping, 0, card_offset, false, 0,
+                &unused_num_transfers, &unused_elapsed_ns))
+        {
+            contents_ok = check_pattern (test, host_bytes, "Card");
+        }
+    }
+
+    const double total_bytes = (double) num_transfers * (double) test->transfer_size_bytes;
+    printf ("%-14s  %-12s  %10" PRIu64 "  %12.1f  %s\n",
+            card_to_peer ? "card->peer" : "peer->card", transfer_path_names[path], num_transfers,
+            (elapsed_ns > 0) ? ((total_bytes * 1E3) / (double) elapsed_ns) : 0.0,
+            !test->transfer_success ? "DMA failed" : (contents_ok ? "OK" : "Mismatch"));
+}
+
+
+/**
+ * @brief Select the peer for the test, which is a simulated pair if no peer device was specified
+ * @param[in/out] test The test context. transfer_success is set false if a peer device was specified but peer-to-peer
+ *                     DMA to the device isn't possible.
+ * @param[in/out] designs Used to find the peer device
+ */
+static void select_peer (peer_to_peer_test_context_t *const test, fpga_designs_t *const designs)
+{
+    vfio_device_t *const initiator_device = test->initiator->vfio_device;
+    vfio_device_t *peer_device = NULL;
+    bool peer_usable = false;
+
+    test->simulated_peer = arg_peer_device == NULL;
+    if (!test->simulated_peer)
+    {
+        for (uint32_t device_index = 0; (peer_device == NULL) && (device_index < designs->vfio_devices.num_devices); device_index++)
+        {
+            if (strcmp (designs->vfio_devices.devices[device_index]->device_name, arg_peer_device) == 0)
+            {
+                peer_device = designs->vfio_devices.devices[device_index];
+            }
+        }
+
+        if (peer_device == NULL)
+        {
+            printf ("Peer device %s not open\n", arg_peer_device);
+        }
+        else
+        {
+            allocate_vfio_peer_bar_dma_mapping (initiator_device, peer_device, arg_peer_bar, &test->peer_mapping,
+                    VFIO_DMA_MAP_FLAG_READ | VFIO_DMA_MAP_FLAG_WRITE);
+            if (test->peer_mapping.buffer.vaddr != NULL)
+            {
+                if ((test->peer_offset + test->transfer_size_bytes) <= test->peer_mapping.buffer.size)
+                {
+                    peer_usable = true;
+                    printf ("Peer device %s BAR %" PRIu32 " size 0x%zx mapped at IOVA 0x%" PRIx64 "\n",
+                            peer_device->device_name, arg_peer_bar, test->peer_mapping.buffer.size,
+                            test->peer_mapping.iova);
+                }
+                else
+                {
+                    printf ("Transfer size 0x%zx at offset 0x%" PRIx64 " exceeds peer BAR size 0x%zx\n",
+                            test->transfer_size_bytes, test->peer_offset, test->peer_mapping.buffer.size);
+                    free_vfio_dma_mapping (&test->peer_mapping);
+
+                    /* Prevent the mapping being freed again at the end of the test */
+                    memset (&test->peer_mapping, 0, sizeof (test->peer_mapping));
+                }
+            }
+        }
+
+        if (!peer_usable)
+        {
+            printf ("Unable to use peer device %s for peer-to-peer DMA\n", arg_peer_device);
+            test->transfer_success = false;
+        }
+    }
+
+    if (test->simulated_peer)
+    {
+        /* Use a host buffer to simulate the peer BAR */
+        allocate_vfio_dma_mapping (initiator_device, &test->peer_mapping, test->peer_offset + test->transfer_size_bytes,
+                VFIO_DMA_MAP_FLAG_READ | VFIO_DMA_MAP_FLAG_WRITE, VFIO_BUFFER_ALLOCATION_HEAP);
+        if (test->peer_mapping.buffer.vaddr != NULL)
+        {
+            printf ("Using a simulated peer in host memory, so not testing peer-to-peer routing\n");
+        }
+        else
+        {
+            test->transfer_success = false;
+        }
+    }
+}
+
+
+/**
+ * @brief Perform the peer-to-peer test using one initiator design
+ * @param[in/out] design The initiator design
+ * @param[in/out] designs Used to find the peer device
+ * @return Returns true if the test was successful
+ */
+static bool test_peer_to_peer (fpga_design_t *const design, fpga_designs_t *const designs)
+{
+    peer_to_peer_test_context_t test =
+    {
+        .initiator = design,
+        .transfer_size_bytes = arg_transfer_size_bytes,
+        .card_source_offset = 0,
+        .peer_offset = arg_peer_offset,
+        .transfer_success = true,
+        .content_success = true
+    };
+    uint64_t unused_num_transfers;
+    int64_t unused_elapsed_ns;
+
+    printf ("Initiator %s design PCI device %s IOMMU group %s\n", fpga_design_names[design->design_id],
+            design->vfio_device->device_name, design->vfio_device->group->iommu_group_name);
+    if (test.transfer_size_bytes > design->dma_bridge_memory_size_bytes)
+    {
+        printf ("Transfer size 0x%zx exceeds the card memory size 0x%zx\n",
+                test.transfer_size_bytes, design->dma_bridge_memory_size_bytes);
+        return false;
+    }
+
+    /* Use different card memory for the source and destination when there is sufficient memory */
+    test.card_destination_offset =
+            ((2 * test.transfer_size_bytes) <= design->dma_bridge_memory_size_bytes) ? test.transfer_size_bytes : 0;
+
+    test.pattern = malloc (test.transfer_size_bytes);
+    if (test.pattern == NULL)
+    {
+        printf ("Failed to allocate pattern\n");
+        exit (EXIT_FAILURE);
+    }
+    uint64_t seed = (uint64_t) get_monotonic_time ();
+    for (size_t byte_index = 0; byte_index < test.transfer_size_bytes; byte_index++)
+    {
+        linear_congruential_generator64 (&seed);
+        test.pattern[byte_index] = (uint8_t) (seed >> 32);
+    }
+
+    allocate_vfio_dma_mapping (design->vfio_device, &test.host_mapping, test.transfer_size_bytes,
+            VFIO_DMA_MAP_FLAG_READ | VFIO_DMA_MAP_FLAG_WRITE, VFIO_BUFFER_ALLOCATION_HEAP);
+    test.transfer_success = test.host_mapping.buffer.vaddr != NULL;
+    if (test.transfer_success)
+    {
+        select_peer (&test, designs);
+    }
+
+    if (test.transfer_success)
+    {
+        /* Fill the source in card memory with the pattern */
+        memcpy (test.host_mapping.buffer.vaddr, test.pattern, test.transfer_size_bytes);
+        (void) perform_transfers (&test, DMA_SUBMODULE_H2C_CHANNELS, &test.host_mapping, 0, test.card_source_offset, false, 0,
+                &unused_num_transfers, &unused_elapsed_ns);
+
+        printf ("\nTransfer size 0x%zx, %s peer\n", test.transfer_size_bytes, test.simulated_peer ? "simulated" : "real");
+        printf ("%-14s  %-12s  %10s  %12s  %s\n", "Direction", "Path", "Transfers", "Mbytes/sec", "Contents");
+        for (transfer_path_t path = 0; path < TRANSFER_PATH_ARRAY_SIZE; path++)
+        {
+            measure_path (&test, true, path);
+        }
+        /* The peer now contains the pattern, as the source for the peer-to-card transfers */
+        for (transfer_path_t path = 0; path < TRANSFER_PATH_ARRAY_SIZE; path++)
+        {
+            measure_path (&test, false, path);
+        }
+    }
+
+    free_vfio_dma_mapping (&test.peer_mapping);
+    free_vfio_dma_mapping (&test.host_mapping);
+    free (test.pattern);
+
+    return test.transfer_success && test.content_success;
+}
+
+
+int main (int argc, char *argv[])
+{
+    fpga_designs_t designs;
+    bool overall_success = false;
+    bool initiator_found = false;
+
+    parse_command_line_arguments (argc, argv);
+
+    /* Open the FPGA designs which have an IOMMU group assigned */
+    identify_pcie_fpga_designs (&designs);
+
+    /* Use the first design with a DMA bridge with DMA accessible memory, which isn't the peer, as the initiator */
+    for (uint32_t design_index = 0; (!initiator_found) && (design_index < designs.num_identified_designs); design_index++)
+    {
+        fpga_design_t *const design = &designs.designs[design_index];
+
+        if (design->dma_bridge_present && (design->dma_bridge_memory_size_bytes > 0) &&
+            ((arg_peer_device == NULL) || (strcmp (design->vfio_device->device_name, arg_peer_device) != 0)))
+        {
+            initiator_found = true;
+            overall_success = test_peer_to_peer (design, &designs);
+        }
+    }
+
+    if (!initiator_found)
+    {
+        printf ("No design with a DMA bridge with DMA accessible memory found to use as the initiator\n");
+    }
+
+    close_pcie_fpga_designs (&designs);
+
+    printf ("\nOverall %s\n", overall_success ? "PASS" : "FAIL");
+
+    return overall_success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,624 @@
+/*
+ * @file test_dma_scheduler.c
+ * @date 18 Oct 2026
+ * @author Chester Gillon
+ * @brief Measure the throughput of all DMA channels in use at once, using the multi-channel scheduler
+ * @details
+ *   For designs with a DMA/Bridge Subsystem with DMA accessible memory, all H2C and C2H channels are given to a scheduler.
+ *   Each channel has a number of host buffers, each of which is transferred to / from a different part of a region of the
+ *   card memory. As each transfer completes the completion callback re-submits the transfer, until the test duration has
+ *   elapsed. The purpose is to characterise the throughput and fairness of the channels when they compete for the
+ *   DMA engine, with different scheduler policies and numbers of polling threads.
+ *
+ *   Each H2C channel has its own region of card memory. The C2H channels read the same regions as the H2C channels, so the
+ *   reads overlap the writes. Each word written by the H2C channels contains its own card memory offset, and is written
+ *   to the card memory before the test starts. Since the H2C channels then keep writing the same contents, the
+ *   completion callback for the C2H channels verifies every word read contains its own card memory offset. A mismatch
+ *   means the scheduler has corrupted, or mixed up, the transfers.
+ *
+ *   When the design has no H2C channels the C2H channels read their own regions, the contents of which are unknown
+ *   so aren't verified.
+ */
+
+#include "identify_pcie_fpga_design.h"
+#include "xilinx_dma_bridge_transfers.h"
+#include "transfer_timing.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <getopt.h>
+#include <unistd.h>
+
+
+/* Use a single fixed transfer timeout, to stop the test from hanging */
+#define TRANSFER_TIMEOUT_SECS 5
+
+
+/* The maximum number of host buffers for each channel */
+#define MAX_BUFFERS_PER_CHANNEL 64
+
+
+/* The maximum number of channels which can be tested */
+#define MAX_TEST_CHANNELS (2 * X2X_MAX_CHANNELS)
+
+
+/* One channel being tested */
+typedef struct
+{
+    /* The transfer context for the channel, which is owned by the scheduler during the test */
+    x2x_transfer_context_t context;
+    /* The host buffers for the channel */
+    vfio_dma_mapping_t data_mapping;
+    /* The transfer for each host buffer. The transfer_arg of each transfer points at itself, so the completion callback
+     * can re-submit the transfer. */
+    x2x_scheduled_transfer_t transfers[MAX_BUFFERS_PER_CHANNEL];
+    /* When true the completion callback verifies the data read by a C2H channel */
+    bool verify;
+    /* The number of words read by a C2H channel which didn't contain the expected card memory offset.
+     * Only updated by the polling thread which owns the channel. */
+    uint64_t num_failing_words;
+} test_channel_t;
+
+
+/* The context for testing one design */
+typedef struct
+{
+    /* Overall success for DMA transfers, also set false when a C2H channel read unexpected data */
+    bool transfer_success;
+    /* Shared by the DMA descriptors for all channels */
+    vfio_dma_mapping_t descriptors_mapping;
+    /* The channels being tested, with the H2C channels followed by the C2H channels */
+    uint32_t num_h2c_channels;
+    uint32_t num_c2h_channels;
+    uint32_t num_channels;
+    test_channel_t channels[MAX_TEST_CHANNELS];
+    /* The scheduler which owns the channels during the test */
+    x2x_scheduler_t scheduler;
+} scheduler_test_context_t;
+
+
+/* Set at the end of the test duration to stop the completion callbacks re-submitting transfers */
+static bool stop_submitting;
+
+
+/* Command line argument which specifies the scheduler policy */
+static x2x_scheduler_policy_t arg_policy = X2X_SCHEDULER_ROUND_ROBIN;
+
+
+/* Command line argument which specifies the number of scheduler polling threads */
+static uint32_t arg_num_threads;
+
+
+/* Command line arguments which specify the weights for the channels in each direction */
+static uint32_t arg_h2c_weight = 1;
+static uint32_t arg_c2h_weight = 1;
+
+
+/* Command line arguments which specify the size and number of the host buffers for each channel */
+static size_t arg_buffer_size_bytes = 0x10000;
+static uint32_t arg_num_buffers = 4;
+
+
+/* Command line argument which specifies the test duration */
+static double arg_duration_secs = 2.0;
+
+
+/** The command line options for this program, in the format passed to getopt_long().
+ *  Only long arguments are supported */
+static const struct option command_line_options[] =
+{
+    {"device", required_argument, NULL, 0},
+    {"policy", required_argument, NULL, 0},
+    {"threads", required_argument, NULL, 0},
+    {"h2c_weight", required_argument, NULL, 0},
+    {"c2h_weight", required_argument, NULL, 0},
+    {"buffer_size", required_argument, NULL, 0},
+    {"num_buffers", required_argument, NULL, 0},
+    {"duration_secs", required_argument, NULL, 0},
+    {NULL, 0, NULL, 0}
+};
+
+
+/**
+ * @brief Display the usage for this program, and the exit
+ */
+static void display_usage (void)
+{
+    printf ("Usage:\n");
+    printf ("  test_dma_scheduler <options>   Measure the throughput of all DMA channels at once\n");
+    printf ("\n");
+    printf ("--device <domain>:<bus>:<dev>.<func>\n");
+    printf ("  only open using VFIO specific PCI devices in the event that there is one than\n");
+    printf ("  one PCI device which matches the identity filters.\n");
+    printf ("  May be used more than once.\n");
+    printf ("--policy round_robin|weighted_fair\n");
+    printf ("  The scheduler policy. Default round_robin\n");
+    printf ("--threads <num_threads>\n");
+    printf ("  The number of scheduler polling threads, limited to the number of channels.\n");
+    printf ("  Zero means the main thread polls. Default %" PRIu32 "\n", arg_num_threads);
+    printf ("--h2c_weight <weight>\n");
+    printf ("--c2h_weight <weight>\n");
+    printf ("  The weights for the channels in each direction, used by the weighted_fair policy. Default 1\n");
+    printf ("--buffer_size <size_bytes>\n");
+    printf ("  The size of each transfer, which must be a multiple of 8 bytes. Default 0x%zx\n", arg_buffer_size_bytes);
+    printf ("--num_buffers <num_buffers>\n");
+    printf ("  The number of host buffers for each channel, up to %u. Default %" PRIu32 "\n",
+            MAX_BUFFERS_PER_CHANNEL, arg_num_buffers);
+    printf ("--duration_secs <secs>\n");
+    printf ("  The test duration. Default %.1f\n", arg_duration_secs);
+
+    exit (EXIT_FAILURE);
+}
+
+
+/**
+ * @brief Parse an unsigned integer command line argument, exiting on an invalid value
+ * @param[in] optdef The definition of the option being parsed
+ * @param[in] min_value The minimum valid value
+ * @param[in] max_value The maximum valid value
+ * @return The parsed value
+ */
+static uint32_t parse_uint32_argument (const struct option *const optdef, const uint32_t min_value, const uint32_t max_value)
+{
+    uint32_t value;
+    char junk;
+
+    if ((sscanf (optarg, "%" SCNu32 "%c", &value, &junk) != 1) || (value < min_value) || (value > max_value))
+    {
+        printf ("Invalid %s %s\n", optdef->name, optarg);
+        exit (EXIT_FAILURE);
+    }
+
+    return value;
+}
+
+
+/**
+ * @brief Parse the command line arguments, storing the results in global variables
+ * @param[in] argc, argv Arguments passed to main
+ */
+static void parse_command_line_arguments (int argc, char *argv[])
+{
+    int opt_status;
+    char junk;
+
+    do
+    {
+        int option_index = 0;
+
+        opt_status = getopt_long (argc, argv, "", command_line_options, &option_index);
+        if (opt_status == '?')
+        {
+            display_usage ();
+        }
+        else if (opt_status >= 0)
+        {
+            const struct option *const optdef = &command_line_options[option_index];
+
+            if (optdef->flag != NULL)
+            {
+                /* Argument just sets a flag */
+            }
+            else if (strcmp (optdef->name, "device") == 0)
+            {
+                vfio_add_pci_device_location_filter (optarg);
+            }
+            else if (strcmp (optdef->name, "policy") == 0)
+            {
+                if (strcmp (optarg, "round_robin") == 0)
+                {
+                    arg_policy = X2X_SCHEDULER_ROUND_ROBIN;
+                }
+                else if (strcmp (optarg, "weighted_fair") == 0)
+                {
+                    arg_policy = X2X_SCHEDULER_WEIGHTED_FAIR;
+                }
+                else
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else if (strcmp (optdef->name, "threads") == 0)
+            {
+                arg_num_threads = parse_uint32_argument (optdef, 0, MAX_TEST_CHANNELS);
+            }
+            else if (strcmp (optdef->name, "h2c_weight") == 0)
+            {
+                arg_h2c_weight = parse_uint32_argument (optdef, 1, UINT32_MAX);
+            }
+            else if (strcmp (optdef->name, "c2h_weight") == 0)
+            {
+                arg_c2h_weight = parse_uint32_argument (optdef, 1, UINT32_MAX);
+            }
+            else if (strcmp (optdef->name, "buffer_size") == 0)
+            {
+                if ((sscanf (optarg, "%zi%c", &arg_buffer_size_bytes, &junk) != 1) || (arg_buffer_size_bytes == 0) ||
+                    ((arg_buffer_size_bytes % sizeof (uint64_t)) != 0))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else if (strcmp (optdef->name, "num_buffers") == 0)
+            {
+                arg_num_buffers = parse_uint32_argument (optdef, 1, MAX_BUFFERS_PER_CHANNEL);
+            }
+            else if (strcmp (optdef->name, "duration_secs") == 0)
+            {
+                if ((sscanf (optarg, "%lf%c", &arg_duration_secs, &junk) != 1) || (arg_duration_secs < 0.0))
+                {
+                    printf ("Invalid %s %s\n", optdef->name, optarg);
+                    exit (EXIT_FAILURE);
+                }
+            }
+            else
+            {
+                /* This is a program error, and shouldn't be triggered by the command line options */
+                fprintf (stderr, "Unexpected argument definition %s\n", optdef->name);
+                exit (EXIT_FAILURE);
+            }
+        }
+    } while (opt_status != -1);
+}
+
+
+/**
+ * @brief The scheduler completion callback, which verifies the data read by a C2H channel and re-submits the completed
+ *        transfer until the test is stopped
+ * @param[in/out] channel The channel the transfer completed on
+ * @param[in] host_buffer The host buffer containing the data for the transfer
+ * @param[in] transfer_len The number of bytes in the transfer
+ * @param[in] end_of_packet Not used
+ * @param[in] transfer_arg The completed transfer
+ */
+static void transfer_completed (x2x_scheduler_channel_t *const channel,
+                                void *const host_buffer, const size_t transfer_len,
+                                const bool end_of_packet, void *const transfer_arg)
+{
+    const x2x_scheduled_transfer_t *const transfer = transfer_arg;
+    test_channel_t *const test_channel = channel->configuration.channel_arg;
+
+    (void) end_of_packet;
+    if (test_channel->verify)
+    {
+        const uint64_t *const words = host_buffer;
+        const size_t num_words = transfer_len / sizeof (uint64_t);
+
+        for (size_t word_index = 0; word_index < num_words; word_index++)
+        {
+            if (words[word_index] != (transfer->card_buffer_offset + (word_index * sizeof (uint64_t))))
+            {
+                test_channel->num_failing_words++;
+            }
+        }
+    }
+
+    if (!__atomic_load_n (&stop_submitting, __ATOMIC_ACQUIRE))
+    {
+        /* Can't be rejected for a full queue, since each channel only has one transfer per host buffer */
+        (void) x2x_scheduler_submit (channel, transfer);
+    }
+}
+
+
+/**
+ * @brief Initialise the transfer contexts for all channels of a design
+ * @param[in/out] design The design to initialise the channels for
+ * @param[out] test The test context with the initialised channels
+ * @return Returns true if the channels were initialised
+ */
+static bool initialise_channels (fpga_design_t *const design, scheduler_test_context_t *const test)
+{
+    x2x_transfer_configuration_t configurations[MAX_TEST_CHANNELS];
+    const uint32_t num_descriptors_per_buffer = x2x_num_descriptors_for_transfer_len (arg_buffer_size_bytes);
+    const size_t channel_buffers_size_bytes = arg_num_buffers * arg_buffer_size_bytes;
+    size_t descriptors_allocation_size = 0;
+
+    x2x_get_num_channels (design->vfio_device, design->dma_bridge_bar, design->dma_bridge_memory_size_bytes,
+            &test->num_h2c_channels, &test->num_c2h_channels, NULL, NULL);
+    test->num_channels = test->num_h2c_channels + test->num_c2h_channels;
+    test->transfer_success = true;
+    printf ("Testing %s design PCI device %s with %" PRIu32 " H2C and %" PRIu32 " C2H channels\n",
+            fpga_design_names[design->design_id], design->vfio_device->device_name,
+            test->num_h2c_channels, test->num_c2h_channels);
+
+    /* Each H2C channel transfers to a separate region of the card memory, which is shared with the C2H channels */
+    const uint32_t num_regions = (test->num_h2c_channels > 0) ? test->num_h2c_channels : test->num_c2h_channels;
+    if ((num_regions * channel_buffers_size_bytes) > design->dma_bridge_memory_size_bytes)
+    {
+        printf ("Card memory size 0x%zx insufficient for %" PRIu32 " regions of %" PRIu32 " buffers of 0x%zx bytes\n",
+                design->dma_bridge_memory_size_bytes, num_regions, arg_num_buffers, arg_buffer_size_bytes);
+        return false;
+    }
+
+    for (uint32_t channel_index = 0; channel_index < test->num_channels; channel_index++)
+    {
+        const bool is_h2c = channel_index < test->num_h2c_channels;
+
+        configurations[channel_index] = (x2x_transfer_configuration_t)
+        {
+            .dma_bridge_memory_base_address = design->dma_bridge_memory_base_address,
+            .dma_bridge_memory_size_bytes = design->dma_bridge_memory_size_bytes,
+            .min_size_alignment = 1, /* The card memory is byte addressable */
+            .num_descriptors = arg_num_buffers * num_descriptors_per_buffer,
+            .channels_submodule = is_h2c ? DMA_SUBMODULE_H2C_CHANNELS : DMA_SUBMODULE_C2H_CHANNELS,
+            .channel_id = is_h2c ? channel_index : (channel_index - test->num_h2c_channels),
+            .bytes_per_buffer = 0, /* Length and offsets set by the scheduled transfers */
+            .host_buffer_start_offset = 0,
+            .card_buffer_start_offset = 0,
+            .timeout_seconds = TRANSFER_TIMEOUT_SECS,
+            .vfio_device = design->vfio_device,
+            .bar_index = design->dma_bridge_bar,
+            .descriptors_mapping = &test->descriptors_mapping,
+            .data_mapping = &test->channels[channel_index].data_mapping,
+            .overall_success = &test->transfer_success
+        };
+        descriptors_allocation_size += x2x_get_descriptor_allocation_size (&configurations[channel_index]);
+    }
+
+    allocate_vfio_dma_mapping (design->vfio_device, &test->descriptors_mapping, descriptors_allocation_size,
+            VFIO_DMA_MAP_FLAG_READ | VFIO_DMA_MAP_FLAG_WRITE, VFIO_BUFFER_ALLOCATION_HEAP);
+    test->transfer_success = test->descriptors_mapping.buffer.vaddr != NULL;
+    for (uint32_t channel_index = 0; test->transfer_success && (channel_index < test->num_channels); channel_index++)
+    {
+        test_channel_t *const channel = &test->channels[channel_index];
+
+        allocate_vfio_dma_mapping (design->vfio_device, &channel->data_mapping, channel_buffers_size_bytes,
+                (channel_index < test->num_h2c_channels) ? VFIO_DMA_MAP_FLAG_READ : VFIO_DMA_MAP_FLAG_WRITE,
+                VFIO_BUFFER_ALLOCATION_HEAP);
+        test->transfer_success = channel->data_mapping.buffer.vaddr != NULL;
+        if (test->transfer_success)
+        {
+            const bool is_h2c = channel_index < test->num_h2c_channels;
+            const uint32_t region_index = is_h2c ? channel_index :
+                    ((channel_index - test->num_h2c_channels) % num_regions);
+            uint64_t *const host_words = channel->data_mapping.buffer.vaddr;
+
+            x2x_initialise_transfer_context (&channel->context, &configurations[channel_index]);
+            channel->verify = !is_h2c && (test->num_h2c_channels > 0);
+            channel->num_failing_words = 0;
+            for (uint32_t buffer_index = 0; buffer_index < arg_num_buffers; buffer_index++)
+            {
+                x2x_scheduled_transfer_t *const transfer = &channel->transfers[buffer_index];
+
+                transfer->len = arg_buffer_size_bytes;
+                transfer->host_buffer_offset = buffer_index * arg_buffer_size_bytes;
+                transfer->card_buffer_offset = (region_index * channel_buffers_size_bytes) + transfer->host_buffer_offset;
+                transfer->transfer_arg = transfer;
+            }
+
+            if (is_h2c)
+            {
+                /* Each word contains its own card memory offset. As the host buffers are contiguous the card memory
+                 * offset of each word is a fixed offset from its host buffer offset. */
+                const uint64_t region_offset = region_index * channel_buffers_size_bytes;
+
+                for (size_t word_index = 0; word_index < (channel_buffers_size_bytes / sizeof (uint64_t)); word_index++)
+                {
+                    host_words[word_index] = region_offset + (word_index * sizeof (uint64_t));
+                }
+            }
+        }
+    }
+
+    return test->transfer_success;
+}
+
+
+/**
+ * @brief Finalise the transfer contexts for all channels of a design, releasing the resources
+ * @param[in/out] test The test context with the channels to finalise
+ */
+static void finalise_channels (scheduler_test_context_t *const test)
+{
+    for (uint32_t channel_index = 0; channel_index < test->num_channels; channel_index++)
+    {
+        test_channel_t *const channel = &test->channels[channel_index];
+
+        if (channel->data_mapping.buffer.vaddr != NULL)
+        {
+            x2x_finalise_transfer_context (&channel->context);
+            free_vfio_dma_mapping (&channel->data_mapping);
+        }
+    }
+    free_vfio_dma_mapping (&test->descriptors_mapping);
+}
+
+
+/**
+ * @brief Write the contents of the H2C host buffers to the card memory, before the scheduler is started
+ * @details This means the C2H channels can verify their reads from the start of the test, since the card memory already
+ *          has the contents which the H2C channels keep writing. The transfer contexts are used directly, since each
+ *          channel has sufficient descriptors to start the transfers for all its host buffers at once.
+ * @param[in/out] test The test context with the initialised channels
+ */
+static void write_initial_card_memory (scheduler_test_context_t *const test)
+{
+    for (uint32_t channel_index = 0; test->transfer_success && (channel_index < test->num_h2c_channels); channel_index++)
+    {
+        test_channel_t *const channel = &test->channels[channel_index];
+        uint32_t num_completed = 0;
+
+        for (uint32_t buffer_index = 0; test->transfer_success && (buffer_index < arg_num_buffers); buffer_index++)
+        {
+            const x2x_scheduled_transfer_t *const transfer = &channel->transfers[buffer_index];
+            void *const host_buffer = x2x_populate_memory_transfer (&channel->context, transfer->len,
+                    transfer->host_buffer_offset, transfer->card_buffer_offset);
+
+            X2X_ASSERT (&channel->context, host_buffer != NULL);
+            if (host_buffer != NULL)
+            {
+                x2x_start_populated_descriptors (&channel->context);
+            }
+        }
+        while (test->transfer_success && (num_completed < arg_num_buffers))
+        {
+            if (x2x_poll_completed_transfer (&channel->context, NULL, NULL) != NULL)
+            {
+                num_completed++;
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief Run the test on all channels of a design using the scheduler, and report the results
+ * @param[in/out] test The test context with the initialised channels
+ */
+static void run_scheduler_test (scheduler_test_context_t *const test)
+{
+    x2x_scheduler_channel_configuration_t channel_configurations[MAX_TEST_CHANNELS];
+    const int64_t duration_ns = (int64_t) (arg_duration_secs * 1E9);
+    bool all_idle;
+
+    for (uint32_t channel_index = 0; channel_index < test->num_channels; channel_index++)
+    {
+        channel_configurations[channel_index] = (x2x_scheduler_channel_configuration_t)
+        {
+            .context = &test->channels[channel_index].context,
+            .weight = (channel_index < test->num_h2c_channels) ? arg_h2c_weight : arg_c2h_weight,
+            .queue_depth = arg_num_buffers,
+            .completion_callback = transfer_completed,
+            .channel_arg = &test->channels[channel_index]
+        };
+    }
+    x2x_scheduler_initialise (&test->scheduler, arg_policy, test->num_channels, channel_configurations, arg_num_threads);
+    write_initial_card_memory (test);
+    if (!test->transfer_success)
+    {
+        printf ("Failed to write the initial card memory contents\n");
+        x2x_scheduler_finalise (&test->scheduler);
+        return;
+    }
+
+    /* Submit one transfer for each host buffer, which are then re-submitted by the completion callback */
+    __atomic_store_n (&stop_submitting, false, __ATOMIC_RELEASE);
+    for (uint32_t channel_index = 0; channel_index < test->num_channels; channel_index++)
+    {
+        for (uint32_t buffer_index = 0; buffer_index < arg_num_buffers; buffer_index++)
+        {
+            (void) x2x_scheduler_submit (&test->scheduler.channels[channel_index],
+                    &test->channels[channel_index].transfers[buffer_index]);
+        }
+    }
+
+    const int64_t start_time = get_monotonic_time ();
+    if (x2x_scheduler_start (&test->scheduler))
+    {
+        /* Run for the test duration, then wait for the transfers in progress to complete */
+        while ((get_monotonic_time () - start_time) < duration_ns)
+        {
+            if (test->scheduler.num_threads == 0)
+            {
+                (void) x2x_scheduler_poll (&test->scheduler, 0);
+            }
+            else
+            {
+                usleep (10000);
+            }
+        }
+        /* A callback which sampled stop_submitting before it was set may still re-submit its transfer. Since the
+         * scheduler only counts a completion once the callback has returned, such a channel isn't idle until the
+         * re-submitted transfer has also completed. */
+        __atomic_store_n (&stop_submitting, true, __ATOMIC_RELEASE);
+        do
+        {
+            if (test->scheduler.num_threads == 0)
+            {
+                (void) x2x_scheduler_poll (&test->scheduler, 0);
+            }
+            all_idle = true;
+            for (uint32_t channel_index = 0; channel_index < test->num_channels; channel_index++)
+            {
+                all_idle = all_idle && x2x_scheduler_channel_idle (&test->scheduler.channels[channel_index]);
+            }
+        } while (!all_idle);
+        x2x_scheduler_stop (&test->scheduler);
+    }
+    else
+    {
+        test->transfer_success = false;
+    }
+    const int64_t elapsed_ns = get_monotonic_time () - start_time;
+
+    /* Report the results */
+    printf ("Policy %s with %" PRIu32 " polling threads, test duration %.3f secs\n",
+            (arg_policy == X2X_SCHEDULER_WEIGHTED_FAIR) ? "weighted_fair" : "round_robin", test->scheduler.num_threads,
+            (double) elapsed_ns / 1E9);
+    printf ("Channel  Weight  Thread  Completed  Rejected  Mbytes/sec  Status\n");
+    for (uint32_t channel_index = 0; channel_index < test->num_channels; channel_index++)
+    {
+        x2x_scheduler_channel_t *const channel = &test->scheduler.channels[channel_index];
+        const x2x_transfer_context_t *const context = channel->configuration.context;
+        const test_channel_t *const test_channel = &test->channels[channel_index];
+        x2x_scheduler_channel_statistics_t statistics;
+        char status[64];
+
+        x2x_scheduler_get_statistics (channel, &statistics);
+        if (test_channel->num_failing_words > 0)
+        {
+            snprintf (status, sizeof (status), "%" PRIu64 " failing words", test_channel->num_failing_words);
+            test->transfer_success = false;
+        }
+        else
+        {
+            snprintf (status, sizeof (status), "%s", test_channel->verify ? "OK (verified)" : "OK");
+        }
+        printf ("%s %-3" PRIu32 "  %6" PRIu32 "  %6" PRIu32 "  %9" PRIu64 "  %8" PRIu64 "  %10.1f  %s\n",
+                (context->configuration.channels_submodule == DMA_SUBMODULE_H2C_CHANNELS) ? "H2C" : "C2H",
+                context->configuration.channel_id, channel->configuration.weight, channel->thread_index,
+                statistics.num_completed, statistics.num_rejected,
+                ((double) statistics.completed_bytes * 1E3) / (double) elapsed_ns,
+                context->failed ? context->error_message : status);
+    }
+
+    x2x_scheduler_finalise (&test->scheduler);
+}
+
+
+int main (int argc, char *argv[])
+{
+    fpga_designs_t designs;
+    bool overall_success = true;
+    scheduler_test_context_t *const test = calloc (1, sizeof (*test));
+
+    parse_command_line_arguments (argc, argv);
+    if (test == NULL)
+    {
+        printf ("Failed to allocate test context\n");
+        exit (EXIT_FAILURE);
+    }
+
+    /* Open the FPGA designs which have an IOMMU group assigned */
+    identify_pcie_fpga_designs (&designs);
+
+    /* Process any FPGA designs which have a DMA bridge with DMA accessible memory */
+    for (uint32_t design_index = 0; design_index < designs.num_identified_designs; design_index++)
+    {
+        fpga_design_t *const design = &designs.designs[design_index];
+
+        if (design->dma_bridge_present && (design->dma_bridge_memory_size_bytes > 0))
+        {
+            memset (test, 0, sizeof (*test));
+            if (initialise_channels (design, test))
+            {
+                run_scheduler_test (test);
+            }
+            overall_success = overall_success && test->transfer_success;
+            finalise_channels (test);
+            printf ("\n");
+        }
+    }
+
+    close_pcie_fpga_designs (&designs);
+    free (test);
+
+    printf ("Overall %s\n", overall_success ? "PASS" : "FAIL");
+
+    return overall_success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
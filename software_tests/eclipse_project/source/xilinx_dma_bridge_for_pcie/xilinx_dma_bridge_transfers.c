@@ -15,18 +15,36 @@
  *      size buffers without software interaction. In this case the software has to keep up with the completed
  *      transfers so the data in the host buffers isn't overwritten before it has been processed.
  *
+ *   A scheduler is provided for programs which use multiple channels. The scheduler owns the transfer contexts for the
+ *   channels, queues submitted transfers until there are free descriptors, and dispatches completed transfers to callbacks.
+ *   The channels can be sharded across multiple polling threads.
+ *
  *   The version in the identifier register is not checked. This file has been written based upon PG195 (v4.1)
  */
 
 #include "xilinx_dma_bridge_transfers.h"
 #include "transfer_timing.h"
 
+#include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
 #include <stdio.h>
 #include <stdarg.h>
 
 
+/* The names of the faults which can be injected */
+const char *const x2x_fault_names[X2X_FAULT_ARRAY_SIZE] =
+{
+    [X2X_FAULT_NONE] = "none",
+    [X2X_FAULT_CORRUPT_DESCRIPTOR_MAGIC] = "corrupt_descriptor_magic",
+    [X2X_FAULT_CORRUPT_NEXT_DESCRIPTOR_ADDRESS] = "corrupt_next_descriptor_address",
+    [X2X_FAULT_UNMAPPED_HOST_BUFFER] = "unmapped_host_buffer",
+    [X2X_FAULT_DROP_CREDITS] = "drop_credits",
+    [X2X_FAULT_RESET_DEVICE] = "reset_device",
+    [X2X_FAULT_STALL_CONSUMER] = "stall_consumer"
+};
+
+
 /**
  * @brief Record a DMA transfer failure, setting the error message on the first failure
  * @param[in/out] context The transfer content to record the failure on
@@ -44,6 +62,10 @@ void x2x_record_failure (x2x_transfer_context_t *const context, const char *form
         va_end (args);
         context->failed = true;
         *context->configuration.overall_success = false;
+        if (context->fault_injection.applied)
+        {
+            context->fault_injection.detected_time_ns = get_monotonic_time ();
+        }
     }
 }
 
@@ -388,25 +410,13 @@ static void x2x_validate_transfer_configuration (x2x_transfer_context_t *const c
 
 
 /**
- * @brief Initialise the context for performing DMA transfers using one H2C or 2CH channel
- * @param[out] context The initialised context. failed is set to indicate the initialisation failed.
- * @param[in] configuration The configuration to be used for the DMA transfers.
+ * @brief Arm a DMA channel, by initialising the ring of descriptors and then setting the channel running
+ * @details Used both for the initial start of a channel, and when re-starting a channel after recovering from a failure.
+ *          The channel must be idle on entry, with the descriptor ring and write backs already allocated.
+ * @param[in/out] context The context to arm the channel for
  */
-void x2x_initialise_transfer_context (x2x_transfer_context_t *const context,
-                                      const x2x_transfer_configuration_t *const configuration)
+static void x2x_arm_channel (x2x_transfer_context_t *const context)
 {
-    uint64_t first_descriptor_iova;
-    uint64_t first_stream_writeback_iova;
-    uint64_t completed_descriptor_count_iova;
-
-    /* Perform initialisation for channel control register mapping which doesn't use any descriptor ring information.
-     * This validates the control registers for the channel are found with the expected identification values. */
-    x2x_initialise_transfer_register_mapping (context, configuration);
-    if (context->failed)
-    {
-        return;
-    }
-
     /* Initialise to no descriptors used */
     context->num_descriptors_started = 0;
     context->num_in_use_descriptors = 0;
@@ -414,75 +424,18 @@ void x2x_initialise_transfer_context (x2x_transfer_context_t *const context,
     context->previous_num_completed_descriptors = 0;
     context->next_started_descriptor_index = 0;
     context->next_completed_descriptor_index = 0;
-    context->num_descriptors_per_transfer =
-            calloc (context->configuration.num_descriptors, sizeof (*context->num_descriptors_per_transfer));
 
     /* Timeout can be changed for each transfer started */
     context->timeout_enabled = false;
     context->abs_timeout = 0;
 
-    /* Use the minimum size alignment specified in the arguments */
-    if (context->configuration.min_size_alignment > context->addr_alignment)
-    {
-        context->addr_alignment = context->configuration.min_size_alignment;
-    }
-
-    /* Validate the configuration, after the alignment has been determined */
-    x2x_validate_transfer_configuration (context);
-    if (context->failed)
-    {
-        return;
-    }
-
-    /* Check the channel is idle. Should be idle since:
-     * a. Opening a VFIO device asserts a reset.
-     * b. The DMA engine is stopped by x2x_finalise_transfer_context() before this function is called to re-initialise a DMA channel */
-    const uint32_t channel_status = read_reg32 (context->x2x_channel_regs, X2X_CHANNEL_STATUS_RW1C_OFFSET);
-    if ((channel_status & X2X_CHANNEL_STATUS_BUSY) != 0)
-    {
-        x2x_record_failure (context, "Error: Attempting to initialise when DMA channel busy");
-    }
-
-    /* When the channel is idle, there should be zero available credits */
-    const uint32_t available_credits = read_reg32 (context->x2x_sgdma_regs, X2X_SGDMA_DESCRIPTOR_CREDITS_OFFSET);
-    if (available_credits != 0)
-    {
-        x2x_record_failure (context, "Error: Attempting to initialise DMA channel when %" PRIu32 " available credits", available_credits);
-    }
-
-    /* Allocate the descriptor writeback array to record the length for each received transfer */
-    if (context->is_axi_stream && (context->configuration.channels_submodule == DMA_SUBMODULE_C2H_CHANNELS))
-    {
-        vfio_dma_mapping_align_space (context->configuration.descriptors_mapping);
-        context->stream_writeback =
-                vfio_dma_mapping_allocate_space (context->configuration.descriptors_mapping,
-                        context->configuration.num_descriptors * sizeof (*context->stream_writeback),
-                        &first_stream_writeback_iova);
-        X2X_ASSERT (context, context->stream_writeback != NULL);
-    }
-    else
-    {
-        context->stream_writeback = NULL;
-    }
-
     /* Initialise the ring of descriptors, excluding the length and memory addresses for each descriptor, which are set before use.
      * DMA_DESCRIPTOR_CONTROL_COMPLETED is used to allow pollmode writeback to detect completion of the descriptor. */
-    vfio_dma_mapping_align_space (context->configuration.descriptors_mapping);
-    context->descriptors =
-            vfio_dma_mapping_allocate_space (context->configuration.descriptors_mapping,
-                    context->configuration.num_descriptors * sizeof (context->descriptors[0]),
-                    &first_descriptor_iova);
-    X2X_ASSERT (context, context->descriptors != NULL);
-    if (context->failed)
-    {
-        return;
-    }
-
     for (uint32_t descriptor_index = 0; descriptor_index < context->configuration.num_descriptors; descriptor_index++)
     {
         dma_descriptor_t *const descriptor = &context->descriptors[descriptor_index];
         const uint32_t next_descriptor_index = (descriptor_index + 1) % context->configuration.num_descriptors;
-        const uint64_t next_descriptor_iova = first_descriptor_iova + (next_descriptor_index * sizeof (*descriptor));
+        const uint64_t next_descriptor_iova = context->first_descriptor_iova + (next_descriptor_index * sizeof (*descriptor));
 
         /* Calculate the fixed buffer addresses, or zero if not used */
         const uint64_t buffer_offset = (descriptor_index * context->configuration.bytes_per_buffer);
@@ -519,7 +472,7 @@ void x2x_initialise_transfer_context (x2x_transfer_context_t *const context,
             /* For a C2H stream set the address for where the writeback for this stream is stored */
             context->stream_writeback[descriptor_index].wb_magic_status = 0;
             context->stream_writeback[descriptor_index].length = 0;
-            descriptor->src_adr = first_stream_writeback_iova + (descriptor_index * sizeof (context->stream_writeback[0]));
+            descriptor->src_adr = context->first_stream_writeback_iova + (descriptor_index * sizeof (context->stream_writeback[0]));
             descriptor->dst_adr = host_buffer_address;
         }
         else if (context->configuration.channels_submodule == DMA_SUBMODULE_H2C_CHANNELS)
@@ -544,15 +497,8 @@ void x2x_initialise_transfer_context (x2x_transfer_context_t *const context,
     }
 
     /* Initialise the write back to monitor completed descriptors */
-    vfio_dma_mapping_align_space (context->configuration.descriptors_mapping);
-    context->completed_descriptor_count = vfio_dma_mapping_allocate_space (context->configuration.descriptors_mapping,
-            sizeof (*context->completed_descriptor_count), &completed_descriptor_count_iova);
-    X2X_ASSERT (context, context->completed_descriptor_count != NULL);
-    if (context->failed)
-    {
-        return;
-    }
-    write_split_reg64 (context->x2x_channel_regs, X2X_CHANNEL_POLL_MODE_WRITE_BACK_ADDRESS_OFFSET, completed_descriptor_count_iova);
+    write_split_reg64 (context->x2x_channel_regs, X2X_CHANNEL_POLL_MODE_WRITE_BACK_ADDRESS_OFFSET,
+            context->completed_descriptor_count_iova);
     context->completed_descriptor_count->sts_err_compl_descriptor_count = 0;
 
     /* Set channel control to enable pollmode write back and logging of all errors */
@@ -571,7 +517,7 @@ void x2x_initialise_transfer_context (x2x_transfer_context_t *const context,
 
     /* For the first descriptor in the ring set it's address in the DMA control registers.
      * Number of extra descriptors is set to zero as are no trying to optimise the descriptor fetching. */
-    write_split_reg64 (context->x2x_sgdma_regs, X2X_SGDMA_DESCRIPTOR_ADDRESS_OFFSET, first_descriptor_iova);
+    write_split_reg64 (context->x2x_sgdma_regs, X2X_SGDMA_DESCRIPTOR_ADDRESS_OFFSET, context->first_descriptor_iova);
     write_reg32 (context->x2x_sgdma_regs, X2X_SGDMA_DESCRIPTOR_ADJACENT_OFFSET, 0);
 
     /* Clear descriptor halt flag for the channel */
@@ -596,11 +542,101 @@ void x2x_initialise_transfer_context (x2x_transfer_context_t *const context,
 
 
 /**
- * @brief Finalise a context for performing DMA, which stops the DMA engine, and frees some resources.
- * @details Doesn't free resources allocated with VFIO, since the VFIO mappings may be shared by more than one context.
- * @param[out] context The context to finalise.
+ * @brief Initialise the context for performing DMA transfers using one H2C or 2CH channel
+ * @param[out] context The initialised context. failed is set to indicate the initialisation failed.
+ * @param[in] configuration The configuration to be used for the DMA transfers.
  */
-void x2x_finalise_transfer_context (x2x_transfer_context_t *const context)
+void x2x_initialise_transfer_context (x2x_transfer_context_t *const context,
+                                      const x2x_transfer_configuration_t *const configuration)
+{
+    /* Perform initialisation for channel control register mapping which doesn't use any descriptor ring information.
+     * This validates the control registers for the channel are found with the expected identification values. */
+    x2x_initialise_transfer_register_mapping (context, configuration);
+    if (context->failed)
+    {
+        return;
+    }
+
+    /* Allocate the array to record how many descriptors are used for each transfer, populated when the channel is armed */
+    context->num_descriptors_per_transfer =
+            calloc (context->configuration.num_descriptors, sizeof (*context->num_descriptors_per_transfer));
+
+    /* Use the minimum size alignment specified in the arguments */
+    if (context->configuration.min_size_alignment > context->addr_alignment)
+    {
+        context->addr_alignment = context->configuration.min_size_alignment;
+    }
+
+    /* Validate the configuration, after the alignment has been determined */
+    x2x_validate_transfer_configuration (context);
+    if (context->failed)
+    {
+        return;
+    }
+
+    /* Check the channel is idle. Should be idle since:
+     * a. Opening a VFIO device asserts a reset.
+     * b. The DMA engine is stopped by x2x_finalise_transfer_context() before this function is called to re-initialise a DMA channel */
+    const uint32_t channel_status = read_reg32 (context->x2x_channel_regs, X2X_CHANNEL_STATUS_RW1C_OFFSET);
+    if ((channel_status & X2X_CHANNEL_STATUS_BUSY) != 0)
+    {
+        x2x_record_failure (context, "Error: Attempting to initialise when DMA channel busy");
+    }
+
+    /* When the channel is idle, there should be zero available credits */
+    const uint32_t available_credits = read_reg32 (context->x2x_sgdma_regs, X2X_SGDMA_DESCRIPTOR_CREDITS_OFFSET);
+    if (available_credits != 0)
+    {
+        x2x_record_failure (context, "Error: Attempting to initialise DMA channel when %" PRIu32 " available credits", available_credits);
+    }
+
+    /* Allocate the descriptor writeback array to record the length for each received transfer */
+    if (context->is_axi_stream && (context->configuration.channels_submodule == DMA_SUBMODULE_C2H_CHANNELS))
+    {
+        vfio_dma_mapping_align_space (context->configuration.descriptors_mapping);
+        context->stream_writeback =
+                vfio_dma_mapping_allocate_space (context->configuration.descriptors_mapping,
+                        context->configuration.num_descriptors * sizeof (*context->stream_writeback),
+                        &context->first_stream_writeback_iova);
+        X2X_ASSERT (context, context->stream_writeback != NULL);
+    }
+    else
+    {
+        context->stream_writeback = NULL;
+    }
+
+    /* Allocate the ring of descriptors */
+    vfio_dma_mapping_align_space (context->configuration.descriptors_mapping);
+    context->descriptors =
+            vfio_dma_mapping_allocate_space (context->configuration.descriptors_mapping,
+                    context->configuration.num_descriptors * sizeof (context->descriptors[0]),
+                    &context->first_descriptor_iova);
+    X2X_ASSERT (context, context->descriptors != NULL);
+    if (context->failed)
+    {
+        return;
+    }
+
+    /* Allocate the write back to monitor completed descriptors */
+    vfio_dma_mapping_align_space (context->configuration.descriptors_mapping);
+    context->completed_descriptor_count = vfio_dma_mapping_allocate_space (context->configuration.descriptors_mapping,
+            sizeof (*context->completed_descriptor_count), &context->completed_descriptor_count_iova);
+    X2X_ASSERT (context, context->completed_descriptor_count != NULL);
+    if (context->failed)
+    {
+        return;
+    }
+
+    x2x_arm_channel (context);
+}
+
+
+/**
+ * @brief Stop a DMA channel, by clearing the Run bit and then waiting for the channel to become idle
+ * @param[in/out] context The context to stop the channel for
+ * @return Returns true if the channel became idle, or false if timed out waiting for the channel to become idle
+ */
+static bool x2x_stop_channel (x2x_transfer_context_t *const context)
 {
     /* Clear the Run bit to stop the DMA engine */
     write_reg32 (context->x2x_channel_regs, X2X_CHANNEL_CONTROL_W1C_OFFSET, X2X_CHANNEL_CONTROL_RUN);
@@ -621,17 +657,29 @@ void x2x_finalise_transfer_context (x2x_transfer_context_t *const context)
         }
         else
         {
-            if (get_monotonic_time () > abs_timeout)
-            {
-                /* Only need to flag this timeout specifically if a previous failure has already been recorded */
-                context->timeout_awaiting_idle_at_finalisation = context->failed;
-
-                timed_out = true;
-                x2x_record_failure (context, "Timeout waiting to become idle after clearing Run bit");
-            }
+            timed_out = get_monotonic_time () > abs_timeout;
         }
     } while (!timed_out && !is_idle);
 
+    return is_idle;
+}
+
+
+/**
+ * @brief Finalise a context for performing DMA, which stops the DMA engine, and frees some resources.
+ * @details Doesn't free resources allocated with VFIO, since the VFIO mappings may be shared by more than one context.
+ * @param[out] context The context to finalise.
+ */
+void x2x_finalise_transfer_context (x2x_transfer_context_t *const context)
+{
+    if (!x2x_stop_channel (context))
+    {
+        /* Only need to flag this timeout specifically if a previous failure has already been recorded */
+        context->timeout_awaiting_idle_at_finalisation = context->failed;
+
+        x2x_record_failure (context, "Timeout waiting to become idle after clearing Run bit");
+    }
+
     /* Release allocations in the context which are host memory only. I.e. not mapped with VFIO */
     free (context->num_descriptors_per_transfer);
     context->num_descriptors_per_transfer = NULL;
@@ -711,6 +759,57 @@ uint32_t x2x_get_num_free_descriptors (x2x_transfer_context_t *const context)
 }
 
 
+/**
+ * @brief Apply an injected fault to a transfer which is being started
+ * @param[in/out] context The context the transfer is being started on
+ * @param[in] descriptor The first descriptor in the transfer, which may be corrupted
+ * @return Returns true if the credits for the transfer should be written, or false if the credits are dropped
+ */
+static bool x2x_apply_injected_fault (x2x_transfer_context_t *const context, dma_descriptor_t *const descriptor)
+{
+    x2x_fault_injection_t *const injection = &context->fault_injection;
+    bool write_credits = true;
+
+    if ((injection->fault != X2X_FAULT_NONE) && !injection->applied)
+    {
+        switch (injection->fault)
+        {
+        case X2X_FAULT_CORRUPT_DESCRIPTOR_MAGIC:
+            descriptor->magic_nxt_adj_control ^= DMA_DESCRIPTOR_MAGIC;
+            break;
+
+        case X2X_FAULT_CORRUPT_NEXT_DESCRIPTOR_ADDRESS:
+            descriptor->nxt_adr = injection->unmapped_iova;
+            break;
+
+        case X2X_FAULT_UNMAPPED_HOST_BUFFER:
+            if (context->configuration.channels_submodule == DMA_SUBMODULE_H2C_CHANNELS)
+            {
+                descriptor->src_adr = injection->unmapped_iova;
+            }
+            else
+            {
+                descriptor->dst_adr = injection->unmapped_iova;
+            }
+            break;
+
+        case X2X_FAULT_DROP_CREDITS:
+            write_credits = false;
+            break;
+
+        default:
+            /* Applied after the credits have been written, or when polling for completion */
+            break;
+        }
+
+        injection->applied = true;
+        injection->applied_time_ns = get_monotonic_time ();
+    }
+
+    return write_credits;
+}
+
+
 /**
  * @brief Start the DMA transfers for descriptors which have been populated.
  * @param[in/out] context The context to start the descriptors for
@@ -720,11 +819,22 @@ void x2x_start_populated_descriptors (x2x_transfer_context_t *const context)
     const uint32_t num_descriptors_in_transfer = context->num_descriptors_per_transfer[context->next_started_descriptor_index];
     X2X_ASSERT (context, num_descriptors_in_transfer > 0);
 
+    const bool reset_device = (context->fault_injection.fault == X2X_FAULT_RESET_DEVICE) && !context->fault_injection.applied;
+    const bool write_credits = x2x_apply_injected_fault (context, &context->descriptors[context->next_started_descriptor_index]);
+
     context->next_started_descriptor_index = (context->next_started_descriptor_index + num_descriptors_in_transfer) %
             context->configuration.num_descriptors;
     context->num_descriptors_started += num_descriptors_in_transfer;
     context->num_descriptors_started &= COMPLETED_DESCRIPTOR_COUNT_WRITEBACK_MASK;
-    write_reg32 (context->x2x_sgdma_regs, X2X_SGDMA_DESCRIPTOR_CREDITS_OFFSET, num_descriptors_in_transfer);
+    if (write_credits)
+    {
+        write_reg32 (context->x2x_sgdma_regs, X2X_SGDMA_DESCRIPTOR_CREDITS_OFFSET, num_descriptors_in_transfer);
+    }
+    if (reset_device)
+    {
+        reset_vfio_device (context->configuration.vfio_device);
+        context->fault_injection.applied_time_ns = get_monotonic_time ();
+    }
 
     /* Start a timeout if configured */
     context->timeout_enabled = context->configuration.timeout_seconds >= 0;
@@ -1013,8 +1123,14 @@ void *x2x_poll_completed_transfer (x2x_transfer_context_t *const context, size_t
 {
     void *completed_data = NULL;
     uint32_t *const num_descriptors_in_transfer = &context->num_descriptors_per_transfer[context->next_completed_descriptor_index];
+    const x2x_fault_injection_t *const injection = &context->fault_injection;
 
-    if (*num_descriptors_in_transfer > 0)
+    if ((injection->fault == X2X_FAULT_STALL_CONSUMER) && injection->applied &&
+        ((get_monotonic_time () - injection->applied_time_ns) < injection->stall_duration_ns))
+    {
+        /* Injected fault of the consumer being stalled */
+    }
+    else if (*num_descriptors_in_transfer > 0)
     {
         x2x_poll_for_descriptor_completion (context);
 
@@ -1078,3 +1194,539 @@ void *x2x_poll_completed_transfer (x2x_transfer_context_t *const context, size_t
 
     return completed_data;
 }
+
+
+/**
+ * @brief Recover a DMA channel after a failure, so that transfers can be resumed
+ * @details The sequence is:
+ *          1. Stop the channel, waiting for it to become idle. Any descriptor being processed by the DMA engine is completed,
+ *             and the credits for any descriptors not yet started are discarded by the DMA engine.
+ *          2. Discard any transfers which were populated or started, but not reported as completed by
+ *             x2x_poll_completed_transfer(). These are counted as lost transfers.
+ *          3. Clear the latched error status for the channel, any injected fault, and the failure for the context.
+ *          4. Re-initialise the ring of descriptors in the existing allocation, and set the channel running. For a
+ *             c2h_stream_continuous channel this re-arms the stream so received data is written to the host buffers again.
+ *
+ *          On successful recovery no transfers are in use, so the caller needs to re-start transfers to resume.
+ *          The overall_success for the configuration is not modified, since it may be shared with other channels and it is
+ *          up to the caller to decide if the failure is considered transient.
+ *
+ *          Recovery fails if the channel doesn't become idle, which can happen if a transfer has hung. In which case the
+ *          device needs to be reset, and the context re-initialised.
+ * @param[in/out] context The context to recover
+ * @param[out] num_lost_transfers If non-NULL set to the number of transfers discarded by the recovery
+ * @return Returns true if the channel has been recovered, or false if recovery failed and the failure reason has been recorded.
+ */
+bool x2x_recover_transfer_context (x2x_transfer_context_t *const context, uint32_t *const num_lost_transfers)
+{
+    const char *const direction = (context->configuration.channels_submodule == DMA_SUBMODULE_H2C_CHANNELS) ? "H2C" : "C2H";
+    uint32_t lost_transfers = 0;
+
+    if (!x2x_stop_channel (context))
+    {
+        x2x_record_failure (context, "Recovery failed: Timeout waiting to become idle after clearing Run bit on %s channel %" PRIu32,
+                direction, context->configuration.channel_id);
+        return false;
+    }
+
+    /* Count the transfers which are being discarded */
+    if (context->configuration.c2h_stream_continuous)
+    {
+        /* All descriptors are permanently in use, so the only transfers lost are those completed and not yet reported */
+        lost_transfers = context->num_pending_completed_descriptors;
+    }
+    else
+    {
+        uint32_t descriptor_index = context->next_completed_descriptor_index;
+        uint32_t num_remaining_descriptors = context->num_in_use_descriptors;
+
+        while ((num_remaining_descriptors > 0) && (context->num_descriptors_per_transfer[descriptor_index] > 0) &&
+               (context->num_descriptors_per_transfer[descriptor_index] <= num_remaining_descriptors))
+        {
+            const uint32_t num_descriptors_in_transfer = context->num_descriptors_per_transfer[descriptor_index];
+
+            lost_transfers++;
+            num_remaining_descriptors -= num_descriptors_in_transfer;
+            descriptor_index = (descriptor_index + num_descriptors_in_transfer) % context->configuration.num_descriptors;
+        }
+    }
+    if (num_lost_transfers != NULL)
+    {
+        *num_lost_transfers = lost_transfers;
+    }
+    context->num_lost_transfers += lost_transfers;
+
+    /* Check the channel is still accessible, rather than the device having been removed or failed to come out of reset */
+    context->failed = false;
+    context->error_message[0] = '\0';
+    context->timeout_awaiting_idle_at_finalisation = false;
+    x2x_check_dma_submodule_identity (context, context->configuration.channels_submodule);
+    if (context->failed)
+    {
+        return false;
+    }
+
+    /* Clear the latched error status. The error status bits are also reset when the Run bit is set. */
+    (void) read_reg32 (context->x2x_channel_regs, X2X_CHANNEL_STATUS_RC_OFFSET);
+
+    /* Credits are cleared by the DMA engine on the falling edge of the Run bit. If any remain, clear them by disabling credit
+     * mode, which is re-enabled as required when the channel is armed. */
+    const uint32_t available_credits = read_reg32 (context->x2x_sgdma_regs, X2X_SGDMA_DESCRIPTOR_CREDITS_OFFSET);
+    if (available_credits != 0)
+    {
+        const uint32_t credit_enable_low_bit = (context->configuration.channels_submodule == DMA_SUBMODULE_H2C_CHANNELS) ?
+                SGDMA_DESCRIPTOR_H2C_DSC_CREDIT_ENABLE_LOW_BIT : SGDMA_DESCRIPTOR_C2H_DSC_CREDIT_ENABLE_LOW_BIT;
+
+        write_reg32 (context->sgdma_common_regs, SGDMA_DESCRIPTOR_CREDIT_MODE_ENABLE_W1C_OFFSET,
+                1U << (credit_enable_low_bit + context->configuration.channel_id));
+    }
+
+    /* Remove any injected fault, since the descriptors which may have been corrupted are about to be re-initialised */
+    memset (&context->fault_injection, 0, sizeof (context->fault_injection));
+
+    x2x_arm_channel (context);
+    context->num_recoveries++;
+
+    return !context->failed;
+}
+
+
+/**
+ * @brief Find an IOVA which has no mapping in the IOMMU container used by a transfer context
+ * @param[in] context The context to find the unmapped IOVA for
+ * @param[out] unmapped_iova The start of a free IOVA region addressable by the DMA engine
+ * @return Returns true if an unmapped IOVA was found, or false otherwise
+ */
+static bool x2x_find_unmapped_iova (const x2x_transfer_context_t *const context, uint64_t *const unmapped_iova)
+{
+    const vfio_iommu_container_t *const container = context->configuration.data_mapping->container;
+    const uint64_t min_region_size = 0x1000;
+
+    /* With NOIOMMU there is no IOMMU to block the access, so a DMA to an "unmapped" address could corrupt host memory */
+    if ((container == NULL) || (container->iommu_type == VFIO_NOIOMMU_IOMMU))
+    {
+        return false;
+    }
+
+    for (uint32_t region_index = 0; region_index < container->num_iova_regions; region_index++)
+    {
+        const vfio_iova_region_t *const region = &container->iova_regions[region_index];
+
+        if (!region->allocated && ((region->end - region->start) >= (min_region_size - 1)) &&
+            ((context->num_address_bits >= 64) || (region->end < (1ULL << context->num_address_bits))))
+        {
+            *unmapped_iova = region->start;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/**
+ * @brief Inject a fault into the next transfer started on a context, to test the error detection and recovery paths.
+ * @details The time the fault was applied, and the time of the first failure recorded after the fault was applied, are
+ *          recorded in the context to allow the detection latency to be measured. A fault which corrupts the descriptors
+ *          or the state of the DMA engine persists until the context has been recovered or re-initialised.
+ * @param[in/out] context The context to inject the fault into
+ * @param[in] fault The fault to inject
+ * @param[in] stall_duration_ns For X2X_FAULT_STALL_CONSUMER the duration of the stall
+ * @return Returns true if the fault has been armed, or false if the fault can't be injected for the context.
+ */
+bool x2x_inject_fault (x2x_transfer_context_t *const context, const x2x_fault_t fault, const int64_t stall_duration_ns)
+{
+    x2x_fault_injection_t *const injection = &context->fault_injection;
+
+    memset (injection, 0, sizeof (*injection));
+    injection->stall_duration_ns = stall_duration_ns;
+    switch (fault)
+    {
+    case X2X_FAULT_CORRUPT_NEXT_DESCRIPTOR_ADDRESS:
+    case X2X_FAULT_UNMAPPED_HOST_BUFFER:
+        if (!x2x_find_unmapped_iova (context, &injection->unmapped_iova))
+        {
+            return false;
+        }
+        break;
+
+    case X2X_FAULT_RESET_DEVICE:
+        if ((context->configuration.vfio_device->device_info.flags & VFIO_DEVICE_FLAGS_RESET) == 0)
+        {
+            return false;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    injection->fault = fault;
+
+    return true;
+}
+
+
+/**
+ * @brief Initialise a scheduler which owns multiple DMA channels
+ * @details The transfer contexts for the channels must have been initialised by the caller, and must not use fixed size
+ *          buffers since the scheduler populates the descriptors for each submitted transfer.
+ *          Channels are sharded across the polling threads by channel index, so that each channel is only polled by one
+ *          thread. Exits the program if unable to allocate memory.
+ * @param[out] scheduler The scheduler to initialise
+ * @param[in] policy How the polling is shared between channels
+ * @param[in] num_channels The number of channels to be owned by the scheduler
+ * @param[in] channel_configurations The configuration for each channel
+ * @param[in] num_threads The number of polling threads which x2x_scheduler_start() creates.
+ *                        Zero means the caller polls the channels by calling x2x_scheduler_poll().
+ *                        Clamped to num_channels, since a polling thread with no channels would just spin.
+ *                        The number of threads used is in scheduler->num_threads.
+ */
+void x2x_scheduler_initialise (x2x_scheduler_t *const scheduler, const x2x_scheduler_policy_t policy,
+                               const uint32_t num_channels,
+                               const x2x_scheduler_channel_configuration_t channel_configurations[const num_channels],
+                               const uint32_t num_threads)
+{
+    const uint32_t num_used_threads = (num_threads > num_channels) ? num_channels : num_threads;
+    const uint32_t num_shards = (num_used_threads > 0) ? num_used_threads : 1;
+
+    memset (scheduler, 0, sizeof (*scheduler));
+    scheduler->policy = policy;
+    scheduler->num_channels = num_channels;
+    scheduler->num_threads = num_used_threads;
+    scheduler->channels = calloc (num_channels, sizeof (scheduler->channels[0]));
+    scheduler->threads = calloc (num_shards, sizeof (scheduler->threads[0]));
+    if ((scheduler->channels == NULL) || (scheduler->threads == NULL))
+    {
+        printf ("Failed to allocate scheduler\n");
+        exit (EXIT_FAILURE);
+    }
+
+    for (uint32_t thread_index = 0; thread_index < num_shards; thread_index++)
+    {
+        scheduler->threads[thread_index].scheduler = scheduler;
+        scheduler->threads[thread_index].thread_index = thread_index;
+    }
+
+    for (uint32_t channel_index = 0; channel_index < num_channels; channel_index++)
+    {
+        x2x_scheduler_channel_t *const channel = &scheduler->channels[channel_index];
+        x2x_transfer_context_t *const context = channel_configurations[channel_index].context;
+
+        channel->configuration = channel_configurations[channel_index];
+        if (channel->configuration.weight == 0)
+        {
+            channel->configuration.weight = 1;
+        }
+        if (channel->configuration.queue_depth == 0)
+        {
+            channel->configuration.queue_depth = 1;
+        }
+        channel->scheduler = scheduler;
+        channel->channel_index = channel_index;
+        channel->thread_index = channel_index % num_shards;
+        (void) pthread_mutex_init (&channel->lock, NULL);
+        channel->queue = calloc (channel->configuration.queue_depth, sizeof (channel->queue[0]));
+        channel->started_transfer_args =
+                calloc (context->configuration.num_descriptors, sizeof (channel->started_transfer_args[0]));
+        if ((channel->queue == NULL) || (channel->started_transfer_args == NULL))
+        {
+            printf ("Failed to allocate scheduler channel\n");
+            exit (EXIT_FAILURE);
+        }
+        X2X_ASSERT (context, context->configuration.bytes_per_buffer == 0);
+        channel->failed = context->failed;
+    }
+}
+
+
+/**
+ * @brief Submit a transfer to a scheduler channel, to be started when there are free descriptors
+ * @details May be called from any thread, including from a completion callback.
+ * @param[in/out] channel The channel to submit the transfer to
+ * @param[in] transfer The transfer to submit
+ * @return Returns true if the transfer was queued, or false if the queue is full or the channel has failed.
+ *         On false the caller should retry later, which provides backpressure.
+ */
+bool x2x_scheduler_submit (x2x_scheduler_channel_t *const channel, const x2x_scheduled_transfer_t *const transfer)
+{
+    bool queued = false;
+
+    (void) pthread_mutex_lock (&channel->lock);
+    if (!channel->failed && (channel->num_queued < channel->configuration.queue_depth))
+    {
+        const uint32_t queue_index = (channel->queue_head + channel->num_queued) % channel->configuration.queue_depth;
+
+        channel->queue[queue_index] = *transfer;
+        channel->num_queued++;
+        channel->statistics.num_submitted++;
+        queued = true;
+    }
+    else
+    {
+        channel->statistics.num_rejected++;
+    }
+    (void) pthread_mutex_unlock (&channel->lock);
+
+    return queued;
+}
+
+
+/**
+ * @brief Poll one scheduler channel, dispatching completed transfers and then starting queued transfers
+ * @param[in/out] channel The channel to poll
+ * @return The number of completed transfers dispatched
+ */
+static uint32_t x2x_scheduler_poll_channel (x2x_scheduler_channel_t *const channel)
+{
+    x2x_transfer_context_t *const context = channel->configuration.context;
+    const uint32_t num_descriptors = context->configuration.num_descriptors;
+    const uint32_t limit = (channel->scheduler->policy == X2X_SCHEDULER_WEIGHTED_FAIR) ? channel->configuration.weight : 1;
+    uint32_t num_dispatched = 0;
+    uint32_t num_started = 0;
+    bool queue_empty = false;
+
+    if (channel->failed)
+    {
+        return 0;
+    }
+
+    /* Dispatch completed transfers, in the order they were started */
+    while ((num_dispatched < limit) && (channel->num_started > 0))
+    {
+        size_t transfer_len = 0;
+        bool end_of_packet = false;
+        void *const host_buffer = x2x_poll_completed_transfer (context, &transfer_len, &end_of_packet);
+
+        if (host_buffer == NULL)
+        {
+            break;
+        }
+
+        void *const transfer_arg = channel->started_transfer_args[channel->started_head];
+        channel->started_head = (channel->started_head + 1) % num_descriptors;
+        channel->num_started--;
+
+        /* Called without the lock held, so the callback can submit further transfers */
+        channel->configuration.completion_callback (channel, host_buffer, transfer_len, end_of_packet, transfer_arg);
+
+        /* Only count the completion once the callback has returned, so that x2x_scheduler_channel_idle() can't report
+         * idle while a callback is in progress and may still submit a further transfer on the channel */
+        (void) pthread_mutex_lock (&channel->lock);
+        channel->statistics.num_completed++;
+        channel->statistics.completed_bytes += transfer_len;
+        (void) pthread_mutex_unlock (&channel->lock);
+        num_dispatched++;
+    }
+
+    /* Start queued transfers, while there are free descriptors. A transfer is only removed from the queue once started. */
+    while (!queue_empty && !context->failed && (num_started < limit) && (channel->num_started < num_descriptors))
+    {
+        x2x_scheduled_transfer_t transfer;
+        void *host_buffer = NULL;
+
+        (void) pthread_mutex_lock (&channel->lock);
+        queue_empty = channel->num_queued == 0;
+        if (!queue_empty)
+        {
+            transfer = channel->queue[channel->queue_head];
+        }
+        (void) pthread_mutex_unlock (&channel->lock);
+
+        if (!queue_empty)
+        {
+            host_buffer = context->is_axi_stream ?
+                    x2x_populate_stream_transfer (context, transfer.len, transfer.host_buffer_offset) :
+                    x2x_populate_memory_transfer (context, transfer.len, transfer.host_buffer_offset,
+                            transfer.card_buffer_offset);
+            if (host_buffer == NULL)
+            {
+                /* Insufficient free descriptors, so leave the transfer queued */
+                break;
+            }
+
+            x2x_start_populated_descriptors (context);
+            channel->started_transfer_args[(channel->started_head + channel->num_started) % num_descriptors] =
+                    transfer.transfer_arg;
+            channel->num_started++;
+            num_started++;
+
+            (void) pthread_mutex_lock (&channel->lock);
+            channel->queue_head = (channel->queue_head + 1) % channel->configuration.queue_depth;
+            channel->num_queued--;
+            channel->statistics.num_started++;
+            (void) pthread_mutex_unlock (&channel->lock);
+        }
+    }
+
+    if (context->failed)
+    {
+        /* Stop accepting transfers. The caller can use x2x_recover_transfer_context() after stopping the scheduler. */
+        (void) pthread_mutex_lock (&channel->lock);
+        channel->failed = true;
+        (void) pthread_mutex_unlock (&channel->lock);
+    }
+
+    return num_dispatched;
+}
+
+
+/**
+ * @brief Poll all the scheduler channels owned by one polling thread
+ * @details Called by the polling threads, or by the caller when the scheduler has no polling threads
+ * @param[in/out] scheduler The scheduler to poll
+ * @param[in] thread_index Which polling thread's channels to poll
+ * @return The number of completed transfers dispatched
+ */
+uint32_t x2x_scheduler_poll (x2x_scheduler_t *const scheduler, const uint32_t thread_index)
+{
+    x2x_scheduler_thread_t *const thread = &scheduler->threads[thread_index];
+    uint32_t num_dispatched = 0;
+
+    for (uint32_t channel_offset = 0; channel_offset < scheduler->num_channels; channel_offset++)
+    {
+        x2x_scheduler_channel_t *const channel =
+                &scheduler->channels[(thread->next_poll_offset + channel_offset) % scheduler->num_channels];
+
+        if (channel->thread_index == thread_index)
+        {
+            num_dispatched += x2x_scheduler_poll_channel (channel);
+        }
+    }
+    if (scheduler->num_channels > 0)
+    {
+        thread->next_poll_offset = (thread->next_poll_offset + 1) % scheduler->num_channels;
+    }
+
+    return num_dispatched;
+}
+
+
+/**
+ * @brief Determine if a scheduler channel has completed all submitted transfers
+ * @details A transfer is only counted as completed once its completion callback has returned, so when a callback
+ *          re-submits transfers on its own channel an idle channel has no transfer queued, in flight or in a callback.
+ *          Where a callback submits transfers on a different channel, the caller has to allow for the submission
+ *          being made before the completion on the calling channel is counted.
+ * @param[in/out] channel The channel to check
+ * @return Returns true if all submitted transfers have completed, or the channel has failed
+ */
+bool x2x_scheduler_channel_idle (x2x_scheduler_channel_t *const channel)
+{
+    bool idle;
+
+    (void) pthread_mutex_lock (&channel->lock);
+    idle = channel->failed || (channel->statistics.num_completed == channel->statistics.num_submitted);
+    (void) pthread_mutex_unlock (&channel->lock);
+
+    return idle;
+}
+
+
+/**
+ * @brief Get a consistent copy of the statistics for a scheduler channel, while the scheduler may be running
+ * @param[in/out] channel The channel to get the statistics for
+ * @param[out] statistics The statistics for the channel
+ */
+void x2x_scheduler_get_statistics (x2x_scheduler_channel_t *const channel, x2x_scheduler_channel_statistics_t *const statistics)
+{
+    (void) pthread_mutex_lock (&channel->lock);
+    *statistics = channel->statistics;
+    (void) pthread_mutex_unlock (&channel->lock);
+}
+
+
+/**
+ * @brief The entry point for a scheduler polling thread, which polls its channels until requested to stop
+ * @param[in/out] arg The polling thread
+ * @return Not used
+ */
+static void *x2x_scheduler_thread (void *arg)
+{
+    x2x_scheduler_thread_t *const thread = arg;
+    x2x_scheduler_t *const scheduler = thread->scheduler;
+
+    while (!__atomic_load_n (&scheduler->stop_requested, __ATOMIC_ACQUIRE))
+    {
+        (void) x2x_scheduler_poll (scheduler, thread->thread_index);
+    }
+
+    return NULL;
+}
+
+
+/**
+ * @brief Start the polling threads for a scheduler
+ * @param[in/out] scheduler The scheduler to start
+ * @return Returns true if the polling threads were created, or there are no polling threads
+ */
+bool x2x_scheduler_start (x2x_scheduler_t *const scheduler)
+{
+    bool success = true;
+    int rc;
+
+    __atomic_store_n (&scheduler->stop_requested, false, __ATOMIC_RELEASE);
+    for (uint32_t thread_index = 0; success && (thread_index < scheduler->num_threads); thread_index++)
+    {
+        x2x_scheduler_thread_t *const thread = &scheduler->threads[thread_index];
+
+        rc = pthread_create (&thread->thread_id, NULL, x2x_scheduler_thread, thread);
+        thread->created = rc == 0;
+        if (!thread->created)
+        {
+            printf ("pthread_create() for scheduler thread %" PRIu32 " failed : %s\n", thread_index, strerror (rc));
+            success = false;
+        }
+    }
+
+    if (!success)
+    {
+        x2x_scheduler_stop (scheduler);
+    }
+
+    return success;
+}
+
+
+/**
+ * @brief Stop the polling threads for a scheduler, waiting for them to exit
+ * @details Transfers which have been started may still be in progress. The caller should wait for the channels to be idle
+ *          before stopping the scheduler if all transfers are to be completed.
+ * @param[in/out] scheduler The scheduler to stop
+ */
+void x2x_scheduler_stop (x2x_scheduler_t *const scheduler)
+{
+    __atomic_store_n (&scheduler->stop_requested, true, __ATOMIC_RELEASE);
+    for (uint32_t thread_index = 0; thread_index < scheduler->num_threads; thread_index++)
+    {
+        x2x_scheduler_thread_t *const thread = &scheduler->threads[thread_index];
+
+        if (thread->created)
+        {
+            (void) pthread_join (thread->thread_id, NULL);
+            thread->created = false;
+        }
+    }
+}
+
+
+/**
+ * @brief Release the resources for a scheduler
+ * @details The scheduler must have been stopped. The transfer contexts for the channels are not finalised, as they are
+ *          owned by the caller.
+ * @param[in/out] scheduler The scheduler to finalise
+ */
+void x2x_scheduler_finalise (x2x_scheduler_t *const scheduler)
+{
+    for (uint32_t channel_index = 0; channel_index < scheduler->num_channels; channel_index++)
+    {
+        x2x_scheduler_channel_t *const channel = &scheduler->channels[channel_index];
+
+        (void) pthread_mutex_destroy (&channel->lock);
+        free (channel->queue);
+        free (channel->started_transfer_args);
+    }
+    free (scheduler->channels);
+    free (scheduler->threads);
+    memset (scheduler, 0, sizeof (*scheduler));
+}
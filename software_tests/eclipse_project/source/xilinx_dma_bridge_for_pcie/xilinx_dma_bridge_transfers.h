@@ -10,6 +10,8 @@
 
 #include <stdbool.h>
 
+#include <pthread.h>
+
 #include "vfio_access.h"
 #include "xilinx_dma_bridge_host_interface.h"
 
@@ -61,7 +63,10 @@ typedef struct
     /* Used to allocate space for DMA descriptors. May be used by multiple channels. */
     vfio_dma_mapping_t *descriptors_mapping;
     /* The data mapping for the host memory used by the transfer. Used to obtain the host virtual address and
-     * DMA IOVA at different offsets within the mapping. */
+     * DMA IOVA at different offsets within the mapping.
+     * May be a BAR of a peer device mapped by allocate_vfio_peer_bar_dma_mapping(), in which case the "host" side of the
+     * transfers is the peer device. I.e. C2H transfers write card memory to the peer, and H2C transfers read from the peer
+     * into card memory. */
     const vfio_dma_mapping_t *data_mapping;
     /* Points an an overall test success status which is set false when failed is set true.
      * This allows a test to monitor a single boolean to track the overall success over multiple transfers. */
@@ -69,6 +74,54 @@ typedef struct
 } x2x_transfer_configuration_t;
 
 
+/* The faults which can be injected into the transfers for one DMA channel, to test the error detection and recovery paths.
+ * An injected fault is applied when the next transfer is started. */
+typedef enum
+{
+    /* No fault injected */
+    X2X_FAULT_NONE,
+    /* Corrupt the magic value in the first descriptor of the transfer */
+    X2X_FAULT_CORRUPT_DESCRIPTOR_MAGIC,
+    /* Set the next descriptor address in the first descriptor of the transfer to an unmapped IOVA.
+     * The DMA engine only follows the next descriptor address when the following descriptor is started, so the failure
+     * is detected on the next transfer (or the 2nd descriptor in the same transfer). */
+    X2X_FAULT_CORRUPT_NEXT_DESCRIPTOR_ADDRESS,
+    /* Set the host buffer address in the first descriptor of the transfer to an unmapped IOVA */
+    X2X_FAULT_UNMAPPED_HOST_BUFFER,
+    /* Don't write the credits for the transfer, so the DMA engine never starts the descriptors */
+    X2X_FAULT_DROP_CREDITS,
+    /* Reset the VFIO device after writing the credits for the transfer */
+    X2X_FAULT_RESET_DEVICE,
+    /* Stall the consumer, by x2x_poll_completed_transfer() not reporting any completed transfers for a duration after
+     * the transfer was started. With c2h_stream_continuous this allows C2H buffers to be overwritten, which the
+     * application has to detect. */
+    X2X_FAULT_STALL_CONSUMER,
+
+    X2X_FAULT_ARRAY_SIZE
+} x2x_fault_t;
+
+extern const char *const x2x_fault_names[X2X_FAULT_ARRAY_SIZE];
+
+
+/* Records the state of a fault injected into the transfers for one DMA channel */
+typedef struct
+{
+    /* The fault which has been injected */
+    x2x_fault_t fault;
+    /* Set true once the fault has been applied to a started transfer */
+    bool applied;
+    /* For X2X_FAULT_STALL_CONSUMER the duration of the stall */
+    int64_t stall_duration_ns;
+    /* For X2X_FAULT_CORRUPT_NEXT_DESCRIPTOR_ADDRESS and X2X_FAULT_UNMAPPED_HOST_BUFFER the IOVA used, which is a
+     * free region in the IOMMU container so has no mapping. */
+    uint64_t unmapped_iova;
+    /* The CLOCK_MONOTONIC time at which the fault was applied */
+    int64_t applied_time_ns;
+    /* The CLOCK_MONOTONIC time at which a failure was first recorded after the fault was applied, or zero if not detected */
+    int64_t detected_time_ns;
+} x2x_fault_injection_t;
+
+
 /* Defines the context used to control DMA transfers for either one H2C or C2C DMA channel.
  *
  * The vfio_dma_mapping_t is placed in the context since:
@@ -108,6 +161,10 @@ typedef struct
     uint32_t num_address_bits;
     /* The ring of descriptors */
     dma_descriptor_t *descriptors;
+    /* The IOVAs of the descriptor ring and write backs, retained to allow the channel to be re-armed after a failure */
+    uint64_t first_descriptor_iova;
+    uint64_t first_stream_writeback_iova;
+    uint64_t completed_descriptor_count_iova;
     /* For the C2H of a Stream Interface for each descriptor used to write back the length information */
     c2h_stream_writeback_t *stream_writeback;
     /* Host memory where the completed descriptor count is written to, to poll for completion */
@@ -133,9 +190,150 @@ typedef struct
     bool timeout_enabled;
     /* The absolute CLOCK_MONOTONIC time at which the transfer is timed out */
     int64_t abs_timeout;
+    /* Any fault injected to test error handling. Cleared when the context is initialised or recovered. */
+    x2x_fault_injection_t fault_injection;
+    /* The number of times x2x_recover_transfer_context() has recovered the channel since the context was initialised */
+    uint32_t num_recoveries;
+    /* The total number of transfers discarded when recovering the channel since the context was initialised */
+    uint64_t num_lost_transfers;
 } x2x_transfer_context_t;
 
 
+/* The policies which a scheduler can use to share polling between its channels */
+typedef enum
+{
+    /* Each time a channel is polled at most one completed transfer is dispatched and one queued transfer is started */
+    X2X_SCHEDULER_ROUND_ROBIN,
+    /* Each time a channel is polled up to the weight of the channel completed transfers are dispatched,
+     * and queued transfers are started. */
+    X2X_SCHEDULER_WEIGHTED_FAIR
+} x2x_scheduler_policy_t;
+
+
+struct x2x_scheduler_channel_s;
+
+
+/* Called by a scheduler polling thread when a transfer on a channel has completed.
+ * host_buffer, transfer_len and end_of_packet are as returned by x2x_poll_completed_transfer().
+ * transfer_arg is that passed when the transfer was submitted.
+ * The callback may submit further transfers to any channel. */
+typedef void (*x2x_scheduler_completion_callback_t) (struct x2x_scheduler_channel_s *const channel,
+                                                     void *const host_buffer, const size_t transfer_len,
+                                                     const bool end_of_packet, void *const transfer_arg);
+
+
+/* One transfer submitted to a scheduler channel */
+typedef struct
+{
+    /* The transfer length in bytes */
+    size_t len;
+    /* The start offset of the transfer in the host buffer. For a H2C channel the data must have been written to the
+     * host buffer before the transfer is submitted. */
+    uint64_t host_buffer_offset;
+    /* For a memory mapped channel the start offset of the transfer in the card memory. Ignored for an AXI stream. */
+    uint64_t card_buffer_offset;
+    /* Passed to the completion callback */
+    void *transfer_arg;
+} x2x_scheduled_transfer_t;
+
+
+/* Defines one channel to be owned by a scheduler */
+typedef struct
+{
+    /* The transfer context for the channel, which has been initialised by the caller with bytes_per_buffer zero.
+     * Once the scheduler is started, the context must only be accessed by the scheduler. */
+    x2x_transfer_context_t *context;
+    /* For X2X_SCHEDULER_WEIGHTED_FAIR the number of transfers processed each time the channel is polled */
+    uint32_t weight;
+    /* The maximum number of transfers which can be queued waiting to be started. When the queue is full
+     * x2x_scheduler_submit() rejects transfers, to apply backpressure to the producer. */
+    uint32_t queue_depth;
+    /* Called for each completed transfer */
+    x2x_scheduler_completion_callback_t completion_callback;
+    /* Available to the completion callback, to identify the caller's state for the channel */
+    void *channel_arg;
+} x2x_scheduler_channel_configuration_t;
+
+
+/* The statistics for one scheduler channel */
+typedef struct
+{
+    /* The number of transfers accepted by x2x_scheduler_submit() */
+    uint64_t num_submitted;
+    /* The number of transfers rejected by x2x_scheduler_submit() since the queue was full, or the channel has failed */
+    uint64_t num_rejected;
+    /* The number of transfers started by the DMA engine */
+    uint64_t num_started;
+    /* The number of completed transfers whose completion callback has returned, and the total bytes in the
+     * completed transfers */
+    uint64_t num_completed;
+    uint64_t completed_bytes;
+} x2x_scheduler_channel_statistics_t;
+
+
+/* One channel owned by a scheduler */
+typedef struct x2x_scheduler_channel_s
+{
+    /* The configuration of the channel */
+    x2x_scheduler_channel_configuration_t configuration;
+    /* The scheduler the channel is part of */
+    struct x2x_scheduler_s *scheduler;
+    /* The index of the channel in the scheduler, and the polling thread which owns the channel */
+    uint32_t channel_index;
+    uint32_t thread_index;
+    /* Protects the queue and statistics, as transfers can be submitted from any thread */
+    pthread_mutex_t lock;
+    /* Ring of transfers submitted but not yet started, with queue_depth entries */
+    x2x_scheduled_transfer_t *queue;
+    uint32_t queue_head;
+    uint32_t num_queued;
+    /* Ring of the transfer_arg of transfers which have been started, in the order they were started.
+     * The DMA engine completes transfers in order, so is used to match completions to the submitted transfers.
+     * Sized for one transfer per descriptor. Only accessed by the polling thread. */
+    void **started_transfer_args;
+    uint32_t started_head;
+    uint32_t num_started;
+    /* Set by the polling thread when the context has failed */
+    bool failed;
+    /* The statistics for the channel */
+    x2x_scheduler_channel_statistics_t statistics;
+} x2x_scheduler_channel_t;
+
+
+/* One thread used to poll a shard of the scheduler channels */
+typedef struct
+{
+    /* The scheduler the thread is part of */
+    struct x2x_scheduler_s *scheduler;
+    /* The index of this thread, which selects the channels it polls */
+    uint32_t thread_index;
+    /* The offset of the first channel polled, rotated on each poll so that no channel is always polled first */
+    uint32_t next_poll_offset;
+    /* Set true when the thread has been created */
+    bool created;
+    pthread_t thread_id;
+} x2x_scheduler_thread_t;
+
+
+/* A scheduler which owns multiple H2C and/or C2H channels, and polls them for completed transfers and to start queued
+ * transfers. The channels may be sharded across multiple polling threads, where each channel is only polled by one thread. */
+typedef struct x2x_scheduler_s
+{
+    /* How the polling is shared between channels */
+    x2x_scheduler_policy_t policy;
+    /* The channels owned by the scheduler */
+    uint32_t num_channels;
+    x2x_scheduler_channel_t *channels;
+    /* The number of polling threads created by x2x_scheduler_start().
+     * When zero the caller polls the channels by calling x2x_scheduler_poll() with a thread_index of zero. */
+    uint32_t num_threads;
+    /* The state for each polling thread. Always has at least one entry, for when the caller polls the channels. */
+    x2x_scheduler_thread_t *threads;
+    /* Set to request the polling threads to exit */
+    bool stop_requested;
+} x2x_scheduler_t;
+
+
 void x2x_record_failure (x2x_transfer_context_t *const context, const char *format, ...) __attribute__ ((format (printf, 2, 3)));
 void x2x_assert (x2x_transfer_context_t *const context, const bool assertion, const char *const assertion_message);
 #define X2X_ASSERT(context,assertion) x2x_assert (context, assertion, #assertion)
@@ -157,5 +355,18 @@ void *x2x_populate_memory_transfer (x2x_transfer_context_t *const context, const
 void *x2x_populate_stream_transfer (x2x_transfer_context_t *const context, const size_t len,
                                     const uint64_t host_buffer_offset);
 void *x2x_poll_completed_transfer (x2x_transfer_context_t *const context, size_t *const transfer_len, bool *const end_of_packet);
+bool x2x_recover_transfer_context (x2x_transfer_context_t *const context, uint32_t *const num_lost_transfers);
+bool x2x_inject_fault (x2x_transfer_context_t *const context, const x2x_fault_t fault, const int64_t stall_duration_ns);
+void x2x_scheduler_initialise (x2x_scheduler_t *const scheduler, const x2x_scheduler_policy_t policy,
+                               const uint32_t num_channels,
+                               const x2x_scheduler_channel_configuration_t channel_configurations[const num_channels],
+                               const uint32_t num_threads);
+bool x2x_scheduler_submit (x2x_scheduler_channel_t *const channel, const x2x_scheduled_transfer_t *const transfer);
+uint32_t x2x_scheduler_poll (x2x_scheduler_t *const scheduler, const uint32_t thread_index);
+bool x2x_scheduler_channel_idle (x2x_scheduler_channel_t *const channel);
+void x2x_scheduler_get_statistics (x2x_scheduler_channel_t *const channel, x2x_scheduler_channel_statistics_t *const statistics);
+bool x2x_scheduler_start (x2x_scheduler_t *const scheduler);
+void x2x_scheduler_stop (x2x_scheduler_t *const scheduler);
+void x2x_scheduler_finalise (x2x_scheduler_t *const scheduler);
 
 #endif /* XILINX_DMA_BRIDGE_TRANSFERS_H_ */
@@ -341,7 +341,25 @@ int main (int argc, char *argv[])
 
         if (design->quad_spi_regs != NULL)
         {
-            display_spi_flash_information (design);
+            /* Lease the Quad SPI controller, so that the flash access isn't interleaved with another process using the
+             * VFIO multi process manager. The wait is limited so this program doesn't hang if another process holds
+             * the lease for a long time. */
+            const uint64_t lease_wait_timeout_ns = 60000000000UL;
+            uint32_t lease_id;
+
+            if (vfio_acquire_resource_lease (design->vfio_device, VFIO_RESOURCE_QUAD_SPI, 0,
+                    VFIO_RESOURCE_LEASE_INFINITE_NS, lease_wait_timeout_ns, &lease_id))
+            {
+                display_spi_flash_information (design);
+
+                /* The lease has no time limit, so can't have expired */
+                (void) vfio_release_resource_lease (design->vfio_device, lease_id);
+            }
+            else
+            {
+                printf ("Timed out waiting for lease on Quad SPI controller in PCI device %s\n",
+                        design->vfio_device->device_name);
+            }
         }
     }
 
@@ -3,6 +3,8 @@
 # This was written when investigating mmap() sometimes failing with EBUSY when multiple processes were started.
 #
 # There is no check if mmap() fails, rely on manually checking the console output.
+#
+# Also tests the resource leases provided by the manager, which are checked by this script.
 
 # Get the absolute path of the workspace root directory, which is the parent directory of this script.
 SCRIPT=$(readlink -f $0)
@@ -42,5 +44,83 @@ echo $job
     wait $job
 done
 
+# Test the resource leases provided by the manager, using test_vfio_resource_lease clients which contend for a lease on
+# the same resource of the first device bound to vfio-pci. Unlike the above tests, these are checked by this script.
+# Each test writes the combined output of its clients to a log file, where the order of the lines is the order in which
+# the clients were granted and released the lease.
+lease_client=${executable_root_dir}/vfio_access/test_vfio_resource_lease
+lease_device=`ls /sys/bus/pci/drivers/vfio-pci | grep ":" | head -n 1`
+lease_log=`mktemp`
+num_lease_failures=0
+
+# Report if a test passed or failed
+# $1 Test name
+# $2 Test result, where 0 is pass
+report_lease_test ()
+{
+    if [ ${2} -eq 0 ]
+    then
+        echo "Lease test ${1} : PASS"
+    else
+        echo "Lease test ${1} : FAIL"
+        cat ${lease_log}
+        num_lease_failures=$((num_lease_failures+1))
+    fi
+}
+
+if [ -z "${lease_device}" ]
+then
+    echo "No device bound to vfio-pci to test leases"
+    num_lease_failures=1
+else
+    # Three clients contend for a lease. They are started in order, with a delay to ensure the manager receives the
+    # requests in order, and must be granted the lease in FIFO order.
+    : > ${lease_log}
+    ${lease_client} --device ${lease_device} --name first --hold_secs 2 >> ${lease_log} &
+    sleep 0.5
+    ${lease_client} --device ${lease_device} --name second --hold_secs 1 >> ${lease_log} &
+    sleep 0.5
+    ${lease_client} --device ${lease_device} --name third >> ${lease_log} &
+    wait
+    grant_order=`grep "granted lease_id" ${lease_log} | cut -d' ' -f1 | xargs`
+    [ "${grant_order}" = "first second third" ]
+    report_lease_test "FIFO grant" $?
+
+    # A client holds a lease with a 1 second duration for longer than the duration. A waiting client must be granted the
+    # lease when it expires, before the holder releases it. A client with a shorter wait timeout must time out.
+    : > ${lease_log}
+    ${lease_client} --device ${lease_device} --name holder --lease_secs 1 --hold_secs 3 >> ${lease_log} &
+    sleep 0.5
+    ${lease_client} --device ${lease_device} --name impatient --wait_secs 0.2 >> ${lease_log} &
+    ${lease_client} --device ${lease_device} --name waiter >> ${lease_log} &
+    wait
+    events=`grep -E "^waiter granted|^holder lease_id .* expired" ${lease_log} | cut -d' ' -f1 | xargs`
+    [ "${events}" = "waiter holder" ] && grep -q "^impatient timed out" ${lease_log}
+    report_lease_test "expiry and wait timeout" $?
+
+    # A client is killed while holding a lease with no time limit. The manager must free the lease when the client
+    # disconnects, so a waiting client is granted the lease before its wait timeout.
+    : > ${lease_log}
+    ${lease_client} --device ${lease_device} --name killed --hold_secs 60 >> ${lease_log} &
+    killed_pid=$!
+    sleep 0.5
+    ${lease_client} --device ${lease_device} --name survivor --wait_secs 10 >> ${lease_log} &
+    survivor_pid=$!
+    sleep 0.5
+    kill -SIGKILL ${killed_pid}
+    wait ${survivor_pid}
+    report_lease_test "crash cleanup" $?
+    wait
+fi
+rm -f ${lease_log}
+
 # Tell the manager to shutdown
 kill -SIGINT `pgrep vfio_multi_proc`
+
+if [ ${num_lease_failures} -eq 0 ]
+then
+    echo "All lease tests PASSED"
+else
+    echo "${num_lease_failures} lease tests FAILED"
+    exit 1
+fi